@@ -0,0 +1,421 @@
+/** @file
+  Measure small reads through EFI_DISK_IO_PROTOCOL, as issued by file system
+  drivers, against the same reads issued to EFI_BLOCK_IO_PROTOCOL directly.
+
+  Meant to be run from the UEFI shell of the emulator, against the disks of
+  EmuBlockIoDxe, with the Disk I/O cache enabled (PcdDiskIoCacheLineCount):
+
+    DiskIoBenchmark [-n RandomReads] [-w WorkingSetKiB] [-r ReadBytes] [-s SequentialKiB]
+
+  Two access patterns are measured on every disk and partition:
+  - random reads of ReadBytes bytes within the first WorkingSetKiB KiB of the
+    device, like the metadata reads of a file system,
+  - sequential reads of ReadBytes bytes over the first SequentialKiB KiB, like
+    a file read cluster by cluster.
+
+  The hit rate of the cache is printed by DiskIoDxe when it is disconnected,
+  at DEBUG_INFO level.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>                  // StrDecimalToUintn()
+#include <Library/BaseMemoryLib.h>            // CopyMem()
+#include <Library/MemoryAllocationLib.h>      // AllocatePages()
+#include <Library/ShellCEntryLib.h>           // ShellAppMain()
+#include <Library/TimerLib.h>                 // GetPerformanceCounter()
+#include <Library/UefiBootServicesTableLib.h> // gBS
+#include <Library/UefiLib.h>                  // Print()
+#include <Protocol/BlockIo.h>                 // EFI_BLOCK_IO_PROTOCOL
+#include <Protocol/DiskIo.h>                  // EFI_DISK_IO_PROTOCOL
+
+#define DEFAULT_RANDOM_READS     20000
+#define DEFAULT_WORKING_SET_KIB  1024
+#define DEFAULT_READ_BYTES       512
+#define DEFAULT_SEQUENTIAL_KIB   16384
+#define MAX_READ_BYTES           SIZE_64KB
+
+typedef struct {
+  UINTN    RandomReads;
+  UINTN    WorkingSet;
+  UINTN    ReadBytes;
+  UINTN    SequentialSize;
+} BENCHMARK_PARAMS;
+
+typedef struct {
+  EFI_DISK_IO_PROTOCOL     *DiskIo;
+  EFI_BLOCK_IO_PROTOCOL    *BlockIo;
+  UINT8                    *Buffer;
+  UINT8                    *BlockBuffer;
+  UINTN                    BlockBufferSize;
+} BENCHMARK_DEVICE;
+
+//
+// Read a byte range of the device, through Disk I/O or Block I/O.
+//
+typedef
+EFI_STATUS
+(*BENCHMARK_READ)(
+  IN BENCHMARK_DEVICE  *Device,
+  IN UINT64            Offset,
+  IN UINTN             Size
+  );
+
+/**
+  Return the time elapsed since a performance counter value, in nanoseconds.
+
+  @param[in] Start  The performance counter value at the start of the
+                    measurement.
+
+  @return  The elapsed time in nanoseconds.
+**/
+STATIC
+UINT64
+ElapsedNs (
+  IN UINT64  Start
+  )
+{
+  UINT64  End;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  End = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    //
+    // The counter counts down.
+    //
+    return GetTimeInNanoSecond (Start - End);
+  }
+
+  return GetTimeInNanoSecond (End - Start);
+}
+
+/**
+  Read a byte range through EFI_DISK_IO_PROTOCOL.
+
+  @param[in] Device  The device to read.
+  @param[in] Offset  The byte offset to read from.
+  @param[in] Size    The number of bytes to read.
+
+  @return  The status of ReadDisk().
+**/
+STATIC
+EFI_STATUS
+ReadWithDiskIo (
+  IN BENCHMARK_DEVICE  *Device,
+  IN UINT64            Offset,
+  IN UINTN             Size
+  )
+{
+  return Device->DiskIo->ReadDisk (
+                           Device->DiskIo,
+                           Device->BlockIo->Media->MediaId,
+                           Offset,
+                           Size,
+                           Device->Buffer
+                           );
+}
+
+/**
+  Read a byte range through EFI_BLOCK_IO_PROTOCOL, reading the blocks it spans
+  into a bounce buffer, which is what an uncached Disk I/O does.
+
+  @param[in] Device  The device to read.
+  @param[in] Offset  The byte offset to read from.
+  @param[in] Size    The number of bytes to read.
+
+  @return  The status of ReadBlocks().
+**/
+STATIC
+EFI_STATUS
+ReadWithBlockIo (
+  IN BENCHMARK_DEVICE  *Device,
+  IN UINT64            Offset,
+  IN UINTN             Size
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      BlockSize;
+  UINT32      UnderRun;
+  EFI_LBA     Lba;
+  UINTN       Blocks;
+
+  BlockSize = Device->BlockIo->Media->BlockSize;
+  Lba       = DivU64x32Remainder (Offset, BlockSize, &UnderRun);
+  Blocks    = (UnderRun + Size + BlockSize - 1) / BlockSize;
+
+  Status = Device->BlockIo->ReadBlocks (
+                              Device->BlockIo,
+                              Device->BlockIo->Media->MediaId,
+                              Lba,
+                              Blocks * BlockSize,
+                              Device->BlockBuffer
+                              );
+  if (!EFI_ERROR (Status)) {
+    CopyMem (Device->Buffer, Device->BlockBuffer + UnderRun, Size);
+  }
+
+  return Status;
+}
+
+/**
+  Print the result of a measurement.
+
+  @param[in] Label      The name of the access method measured.
+  @param[in] Reads      The number of reads.
+  @param[in] Bytes      The number of bytes read.
+  @param[in] ElapsedNs  The time the reads took, in nanoseconds.
+**/
+STATIC
+VOID
+PrintResult (
+  IN CONST CHAR16  *Label,
+  IN UINT64        Reads,
+  IN UINT64        Bytes,
+  IN UINT64        ElapsedNs
+  )
+{
+  if (ElapsedNs == 0) {
+    ElapsedNs = 1;
+  }
+
+  Print (
+    L"  %-18s %8Lu reads/s %6Lu KiB/s (%Lu reads in %Lu us)\n",
+    Label,
+    DivU64x64Remainder (MultU64x32 (Reads, 1000000000), ElapsedNs, NULL),
+    DivU64x64Remainder (MultU64x32 (Bytes, 1000000000 / SIZE_1KB), ElapsedNs, NULL),
+    Reads,
+    DivU64x32 (ElapsedNs, 1000)
+    );
+}
+
+/**
+  Issue the random reads of the benchmark. The offsets come from a fixed
+  linear congruential sequence so that both access methods see the same
+  pattern.
+
+  @param[in] Device  The device to read.
+  @param[in] Params  The benchmark parameters.
+  @param[in] Read    The access method.
+  @param[in] Label   The name of the access method.
+**/
+STATIC
+VOID
+BenchmarkRandom (
+  IN BENCHMARK_DEVICE        *Device,
+  IN CONST BENCHMARK_PARAMS  *Params,
+  IN BENCHMARK_READ          Read,
+  IN CONST CHAR16            *Label
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Seed;
+  UINT64      Offset;
+  UINTN       Index;
+  UINT64      Start;
+
+  Seed   = 1;
+  Status = EFI_SUCCESS;
+  Start  = GetPerformanceCounter ();
+  for (Index = 0; Index < Params->RandomReads; Index++) {
+    Seed   = Seed * 1103515245 + 12345;
+    Offset = (Seed >> 8) % (Params->WorkingSet - Params->ReadBytes + 1);
+    Status = Read (Device, Offset, Params->ReadBytes);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"  %-18s failed: %r\n", Label, Status);
+    return;
+  }
+
+  PrintResult (Label, Index, MultU64x32 (Index, (UINT32)Params->ReadBytes), ElapsedNs (Start));
+}
+
+/**
+  Issue the sequential reads of the benchmark.
+
+  @param[in] Device  The device to read.
+  @param[in] Params  The benchmark parameters.
+  @param[in] Read    The access method.
+  @param[in] Label   The name of the access method.
+**/
+STATIC
+VOID
+BenchmarkSequential (
+  IN BENCHMARK_DEVICE        *Device,
+  IN CONST BENCHMARK_PARAMS  *Params,
+  IN BENCHMARK_READ          Read,
+  IN CONST CHAR16            *Label
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      Offset;
+  UINT64      Start;
+
+  Status = EFI_SUCCESS;
+  Start  = GetPerformanceCounter ();
+  for (Offset = 0; Offset + Params->ReadBytes <= Params->SequentialSize; Offset += Params->ReadBytes) {
+    Status = Read (Device, Offset, Params->ReadBytes);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"  %-18s failed: %r\n", Label, Status);
+    return;
+  }
+
+  PrintResult (Label, DivU64x32 (Offset, (UINT32)Params->ReadBytes), Offset, ElapsedNs (Start));
+}
+
+/**
+  Run the benchmark on one device.
+
+  @param[in] Handle   The handle carrying both EFI_DISK_IO_PROTOCOL and
+                      EFI_BLOCK_IO_PROTOCOL.
+  @param[in] Params   The benchmark parameters.
+**/
+STATIC
+VOID
+BenchmarkDevice (
+  IN EFI_HANDLE              Handle,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS        Status;
+  BENCHMARK_DEVICE  Device;
+  BENCHMARK_PARAMS  DeviceParams;
+  UINT64            DeviceSize;
+
+  ZeroMem (&Device, sizeof Device);
+  Status = gBS->HandleProtocol (Handle, &gEfiDiskIoProtocolGuid, (VOID **)&Device.DiskIo);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIoProtocolGuid, (VOID **)&Device.BlockIo);
+  if (EFI_ERROR (Status) || !Device.BlockIo->Media->MediaPresent) {
+    return;
+  }
+
+  CopyMem (&DeviceParams, Params, sizeof DeviceParams);
+  DeviceSize = MultU64x32 (Device.BlockIo->Media->LastBlock + 1, Device.BlockIo->Media->BlockSize);
+  if (DeviceParams.WorkingSet > DeviceSize) {
+    DeviceParams.WorkingSet = (UINTN)DeviceSize;
+  }
+
+  if (DeviceParams.SequentialSize > DeviceSize) {
+    DeviceParams.SequentialSize = (UINTN)DeviceSize;
+  }
+
+  if (DeviceParams.ReadBytes > DeviceParams.WorkingSet) {
+    return;
+  }
+
+  Print (
+    L"Handle %p: BlockSize %u, %a, %Lu byte reads\n",
+    Handle,
+    Device.BlockIo->Media->BlockSize,
+    Device.BlockIo->Media->LogicalPartition ? "partition" : "disk",
+    (UINT64)DeviceParams.ReadBytes
+    );
+
+  Device.BlockBufferSize = DeviceParams.ReadBytes + 2 * Device.BlockIo->Media->BlockSize;
+  Device.Buffer          = AllocatePool (DeviceParams.ReadBytes);
+  Device.BlockBuffer     = AllocatePages (EFI_SIZE_TO_PAGES (Device.BlockBufferSize));
+  if ((Device.Buffer == NULL) || (Device.BlockBuffer == NULL)) {
+    Print (L"  out of memory\n");
+    goto FreeBuffers;
+  }
+
+  BenchmarkRandom (&Device, &DeviceParams, ReadWithBlockIo, L"random BlockIo");
+  BenchmarkRandom (&Device, &DeviceParams, ReadWithDiskIo, L"random DiskIo");
+  BenchmarkSequential (&Device, &DeviceParams, ReadWithBlockIo, L"sequential BlockIo");
+  BenchmarkSequential (&Device, &DeviceParams, ReadWithDiskIo, L"sequential DiskIo");
+
+FreeBuffers:
+  if (Device.Buffer != NULL) {
+    FreePool (Device.Buffer);
+  }
+
+  if (Device.BlockBuffer != NULL) {
+    FreePages (Device.BlockBuffer, EFI_SIZE_TO_PAGES (Device.BlockBufferSize));
+  }
+}
+
+/**
+  Entry point of the application.
+
+  @param[in] Argc  The number of command line arguments.
+  @param[in] Argv  The command line arguments.
+
+  @retval 0  The benchmark ran.
+  @retval 1  Invalid command line, or no device to run the benchmark on.
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN   Argc,
+  IN CHAR16  **Argv
+  )
+{
+  EFI_STATUS        Status;
+  BENCHMARK_PARAMS  Params;
+  EFI_HANDLE        *Handles;
+  UINTN             NumHandles;
+  UINTN             Index;
+  UINTN             Value;
+
+  Params.RandomReads    = DEFAULT_RANDOM_READS;
+  Params.WorkingSet     = DEFAULT_WORKING_SET_KIB * SIZE_1KB;
+  Params.ReadBytes      = DEFAULT_READ_BYTES;
+  Params.SequentialSize = DEFAULT_SEQUENTIAL_KIB * SIZE_1KB;
+
+  for (Index = 1; Index + 1 < Argc; Index += 2) {
+    Value = StrDecimalToUintn (Argv[Index + 1]);
+    if (Value == 0) {
+      break;
+    }
+
+    if (StrCmp (Argv[Index], L"-n") == 0) {
+      Params.RandomReads = Value;
+    } else if (StrCmp (Argv[Index], L"-w") == 0) {
+      Params.WorkingSet = Value * SIZE_1KB;
+    } else if (StrCmp (Argv[Index], L"-r") == 0) {
+      Params.ReadBytes = MIN (Value, MAX_READ_BYTES);
+    } else if (StrCmp (Argv[Index], L"-s") == 0) {
+      Params.SequentialSize = Value * SIZE_1KB;
+    } else {
+      break;
+    }
+  }
+
+  if (Index != Argc) {
+    Print (L"Usage: %s [-n RandomReads] [-w WorkingSetKiB] [-r ReadBytes] [-s SequentialKiB]\n", Argv[0]);
+    return 1;
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiDiskIoProtocolGuid,
+                  NULL,
+                  &NumHandles,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    Print (L"No EFI_DISK_IO_PROTOCOL instance found: %r\n", Status);
+    return 1;
+  }
+
+  for (Index = 0; Index < NumHandles; Index++) {
+    BenchmarkDevice (Handles[Index], &Params);
+  }
+
+  FreePool (Handles);
+  return 0;
+}
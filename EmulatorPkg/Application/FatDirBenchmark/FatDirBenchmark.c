@@ -0,0 +1,429 @@
+/** @file
+  Measure the creation and the lookup of files in a single directory holding
+  tens of thousands of files, as log dumps or capsule staging directories do.
+
+  Meant to be run from the UEFI shell of the emulator, against the FAT file
+  systems of the EmuBlockIoDxe disks:
+
+    FatDirBenchmark [-n Files] [-l Lookups]
+
+  On every FAT file system, a FATDIRBM directory is created in the root
+  directory, then:
+  - Files empty files with 8.3 names are created in it,
+  - the directory is closed and opened again, and Lookups files picked from
+    a fixed pseudo random sequence are opened by name,
+  - Lookups names that do not exist are looked up,
+  - the files and the directory are deleted.
+
+  The file systems are told from the host file systems of the emulator by the
+  EFI_BLOCK_IO_PROTOCOL below them.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>                  // StrDecimalToUintn()
+#include <Library/MemoryAllocationLib.h>      // FreePool()
+#include <Library/PrintLib.h>                 // UnicodeSPrint()
+#include <Library/ShellCEntryLib.h>           // ShellAppMain()
+#include <Library/TimerLib.h>                 // GetPerformanceCounter()
+#include <Library/UefiBootServicesTableLib.h> // gBS
+#include <Library/UefiLib.h>                  // Print()
+#include <Protocol/BlockIo.h>                 // EFI_BLOCK_IO_PROTOCOL
+#include <Protocol/SimpleFileSystem.h>        // EFI_SIMPLE_FILE_SYSTEM_PROTOCOL
+
+#define DEFAULT_FILES    50000
+#define DEFAULT_LOOKUPS  50000
+#define MAX_FILES        60000
+
+#define BENCHMARK_DIR_NAME  L"FATDIRBM"
+
+typedef struct {
+  UINTN    Files;
+  UINTN    Lookups;
+} BENCHMARK_PARAMS;
+
+/**
+  Return the time elapsed since a performance counter value, in nanoseconds.
+
+  @param[in] Start  The performance counter value at the start of the
+                    measurement.
+
+  @return  The elapsed time in nanoseconds.
+**/
+STATIC
+UINT64
+ElapsedNs (
+  IN UINT64  Start
+  )
+{
+  UINT64  End;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  End = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    //
+    // The counter counts down.
+    //
+    return GetTimeInNanoSecond (Start - End);
+  }
+
+  return GetTimeInNanoSecond (End - Start);
+}
+
+/**
+  Print the result of a measurement.
+
+  @param[in] Label      The name of the operation measured.
+  @param[in] Count      The number of operations.
+  @param[in] ElapsedNs  The time the operations took, in nanoseconds.
+**/
+STATIC
+VOID
+PrintResult (
+  IN CONST CHAR16  *Label,
+  IN UINT64        Count,
+  IN UINT64        ElapsedNs
+  )
+{
+  if (ElapsedNs == 0) {
+    ElapsedNs = 1;
+  }
+
+  Print (
+    L"  %-8s %8Lu ops/s (%Lu ops in %Lu us)\n",
+    Label,
+    DivU64x64Remainder (MultU64x32 (Count, 1000000000), ElapsedNs, NULL),
+    Count,
+    DivU64x32 (ElapsedNs, 1000)
+    );
+}
+
+/**
+  Build the 8.3 name of a file of the benchmark.
+
+  @param[out] Name   The name, at least 13 characters long.
+  @param[in]  Index  The number of the file.
+**/
+STATIC
+VOID
+FileName (
+  OUT CHAR16  *Name,
+  IN  UINTN   Index
+  )
+{
+  UnicodeSPrint (Name, 13 * sizeof (CHAR16), L"F%07u.LOG", (UINT32)Index);
+}
+
+/**
+  Return the next number of a fixed pseudo random sequence.
+
+  @param[in, out] Seed  The state of the sequence.
+  @param[in]      Range The number returned is below Range.
+
+  @return  The next number of the sequence.
+**/
+STATIC
+UINTN
+NextRandom (
+  IN OUT UINT32  *Seed,
+  IN     UINTN   Range
+  )
+{
+  *Seed = *Seed * 1103515245 + 12345;
+  return (*Seed >> 8) % Range;
+}
+
+/**
+  Create the files of the benchmark.
+
+  @param[in] Dir     The benchmark directory.
+  @param[in] Params  The benchmark parameters.
+
+  @return  The number of files created.
+**/
+STATIC
+UINTN
+BenchmarkCreate (
+  IN EFI_FILE_PROTOCOL       *Dir,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  CHAR16             Name[13];
+  UINTN              Index;
+  UINT64             Start;
+
+  Status = EFI_SUCCESS;
+  Start  = GetPerformanceCounter ();
+  for (Index = 0; Index < Params->Files; Index++) {
+    FileName (Name, Index);
+    Status = Dir->Open (Dir, &File, Name, EFI_FILE_MODE_CREATE | EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    File->Close (File);
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"  create   failed after %u files: %r\n", (UINT32)Index, Status);
+    return Index;
+  }
+
+  PrintResult (L"create", Index, ElapsedNs (Start));
+  return Index;
+}
+
+/**
+  Open files of the benchmark picked at random, then look up names that do
+  not exist.
+
+  @param[in] Dir     The benchmark directory.
+  @param[in] Files   The number of files in the directory.
+  @param[in] Params  The benchmark parameters.
+**/
+STATIC
+VOID
+BenchmarkLookup (
+  IN EFI_FILE_PROTOCOL       *Dir,
+  IN UINTN                   Files,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  CHAR16             Name[13];
+  UINT32             Seed;
+  UINTN              Index;
+  UINT64             Start;
+
+  Seed   = 1;
+  Status = EFI_SUCCESS;
+  Start  = GetPerformanceCounter ();
+  for (Index = 0; Index < Params->Lookups; Index++) {
+    FileName (Name, NextRandom (&Seed, Files));
+    Status = Dir->Open (Dir, &File, Name, EFI_FILE_MODE_READ, 0);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    File->Close (File);
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"  open     failed: %s: %r\n", Name, Status);
+    return;
+  }
+
+  PrintResult (L"open", Index, ElapsedNs (Start));
+
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < Params->Lookups; Index++) {
+    FileName (Name, Files + NextRandom (&Seed, Files));
+    Status = Dir->Open (Dir, &File, Name, EFI_FILE_MODE_READ, 0);
+    if (Status != EFI_NOT_FOUND) {
+      if (!EFI_ERROR (Status)) {
+        File->Close (File);
+      }
+
+      Print (L"  miss     unexpected result: %s: %r\n", Name, Status);
+      return;
+    }
+  }
+
+  PrintResult (L"miss", Index, ElapsedNs (Start));
+}
+
+/**
+  Delete the files of the benchmark.
+
+  @param[in] Dir    The benchmark directory.
+  @param[in] Files  The number of files in the directory.
+**/
+STATIC
+VOID
+BenchmarkDelete (
+  IN EFI_FILE_PROTOCOL  *Dir,
+  IN UINTN              Files
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  CHAR16             Name[13];
+  UINTN              Index;
+  UINT64             Start;
+
+  Status = EFI_SUCCESS;
+  Start  = GetPerformanceCounter ();
+  for (Index = 0; Index < Files; Index++) {
+    FileName (Name, Index);
+    Status = Dir->Open (Dir, &File, Name, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+    if (!EFI_ERROR (Status)) {
+      Status = File->Delete (File);
+    }
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"  delete   failed: %s: %r\n", Name, Status);
+    return;
+  }
+
+  PrintResult (L"delete", Index, ElapsedNs (Start));
+}
+
+/**
+  Run the benchmark on one file system.
+
+  @param[in] Handle  The handle carrying both EFI_SIMPLE_FILE_SYSTEM_PROTOCOL
+                     and EFI_BLOCK_IO_PROTOCOL.
+  @param[in] Params  The benchmark parameters.
+**/
+STATIC
+VOID
+BenchmarkFileSystem (
+  IN EFI_HANDLE              Handle,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+  EFI_BLOCK_IO_PROTOCOL            *BlockIo;
+  EFI_FILE_PROTOCOL                *Root;
+  EFI_FILE_PROTOCOL                *Dir;
+  UINTN                            Files;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIoProtocolGuid, (VOID **)&BlockIo);
+  if (EFI_ERROR (Status) || BlockIo->Media->ReadOnly) {
+    return;
+  }
+
+  Status = gBS->HandleProtocol (Handle, &gEfiSimpleFileSystemProtocolGuid, (VOID **)&FileSystem);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = FileSystem->OpenVolume (FileSystem, &Root);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Print (L"Handle %p: %u files, %u lookups\n", Handle, (UINT32)Params->Files, (UINT32)Params->Lookups);
+
+  Status = Root->Open (Root, &Dir, BENCHMARK_DIR_NAME, EFI_FILE_MODE_READ, 0);
+  if (!EFI_ERROR (Status)) {
+    Print (L"  %s already exists, skipped\n", BENCHMARK_DIR_NAME);
+    Dir->Close (Dir);
+    goto CloseRoot;
+  }
+
+  Status = Root->Open (
+                   Root,
+                   &Dir,
+                   BENCHMARK_DIR_NAME,
+                   EFI_FILE_MODE_CREATE | EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+                   EFI_FILE_DIRECTORY
+                   );
+  if (EFI_ERROR (Status)) {
+    Print (L"  cannot create %s: %r\n", BENCHMARK_DIR_NAME, Status);
+    goto CloseRoot;
+  }
+
+  Files = BenchmarkCreate (Dir, Params);
+  Dir->Close (Dir);
+
+  //
+  // Open the directory again, for the lookups to start from the state the
+  // directory is left in once closed.
+  //
+  Status = Root->Open (Root, &Dir, BENCHMARK_DIR_NAME, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+  if (EFI_ERROR (Status)) {
+    Print (L"  cannot open %s: %r\n", BENCHMARK_DIR_NAME, Status);
+    goto CloseRoot;
+  }
+
+  if (Files == Params->Files) {
+    BenchmarkLookup (Dir, Files, Params);
+  }
+
+  BenchmarkDelete (Dir, Files);
+  Status = Dir->Delete (Dir);
+  if (EFI_ERROR (Status)) {
+    Print (L"  cannot delete %s: %r\n", BENCHMARK_DIR_NAME, Status);
+  }
+
+CloseRoot:
+  Root->Close (Root);
+}
+
+/**
+  Entry point of the application.
+
+  @param[in] Argc  The number of command line arguments.
+  @param[in] Argv  The command line arguments.
+
+  @retval 0  The benchmark ran.
+  @retval 1  Invalid command line, or no file system to run the benchmark on.
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN   Argc,
+  IN CHAR16  **Argv
+  )
+{
+  EFI_STATUS        Status;
+  BENCHMARK_PARAMS  Params;
+  EFI_HANDLE        *Handles;
+  UINTN             NumHandles;
+  UINTN             Index;
+  UINTN             Value;
+
+  Params.Files   = DEFAULT_FILES;
+  Params.Lookups = DEFAULT_LOOKUPS;
+
+  for (Index = 1; Index + 1 < Argc; Index += 2) {
+    Value = StrDecimalToUintn (Argv[Index + 1]);
+    if (Value == 0) {
+      break;
+    }
+
+    if (StrCmp (Argv[Index], L"-n") == 0) {
+      Params.Files = MIN (Value, MAX_FILES);
+    } else if (StrCmp (Argv[Index], L"-l") == 0) {
+      Params.Lookups = Value;
+    } else {
+      break;
+    }
+  }
+
+  if (Index != Argc) {
+    Print (L"Usage: %s [-n Files] [-l Lookups]\n", Argv[0]);
+    return 1;
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  NULL,
+                  &NumHandles,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    Print (L"No EFI_SIMPLE_FILE_SYSTEM_PROTOCOL instance found: %r\n", Status);
+    return 1;
+  }
+
+  for (Index = 0; Index < NumHandles; Index++) {
+    BenchmarkFileSystem (Handles[Index], &Params);
+  }
+
+  FreePool (Handles);
+  return 0;
+}
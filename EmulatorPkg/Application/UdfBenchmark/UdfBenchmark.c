@@ -0,0 +1,485 @@
+/** @file
+  Measure how fast the files of UDF file systems, such as installer DVD
+  images, are looked up, opened and read.
+
+  Meant to be run from the UEFI shell of the emulator, with a large UDF image
+  attached as an EmuBlockIoDxe disk with 2048 byte blocks, for example with
+  PcdEmuVirtualDisk set to L"install.iso:RO:2048":
+
+    UdfBenchmark [-c ChunkKiB] [-r Rounds]
+
+  On every UDF file system, the directory tree is listed first. Then, for
+  Rounds rounds:
+  - every file is opened by its absolute path from the root directory, and
+    closed,
+  - every file is opened, read to its end ChunkKiB at a time, and closed.
+
+  The first round shows the cost with cold caches, the next ones the cost once
+  the directories and the file extents have been seen.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Guid/FileInfo.h>                    // EFI_FILE_INFO
+#include <Library/BaseLib.h>                  // StrDecimalToUintn()
+#include <Library/BaseMemoryLib.h>            // CompareGuid()
+#include <Library/DevicePathLib.h>            // DevicePathFromHandle()
+#include <Library/MemoryAllocationLib.h>      // AllocatePool()
+#include <Library/ShellCEntryLib.h>           // ShellAppMain()
+#include <Library/TimerLib.h>                 // GetPerformanceCounter()
+#include <Library/UefiBootServicesTableLib.h> // gBS
+#include <Library/UefiLib.h>                  // Print()
+#include <Protocol/SimpleFileSystem.h>        // EFI_SIMPLE_FILE_SYSTEM_PROTOCOL
+
+#define DEFAULT_CHUNK_KIB  64
+#define MAX_CHUNK_KIB      SIZE_16KB
+#define DEFAULT_ROUNDS     2
+#define MAX_FILES          SIZE_64KB
+#define MAX_PATH_LENGTH    512
+#define FILE_INFO_SIZE     (SIZE_OF_EFI_FILE_INFO + MAX_PATH_LENGTH * sizeof (CHAR16))
+
+//
+// The Vendor-Defined Media Device Path node that PartitionDxe appends to the
+// device path of an UDF file system.
+//
+STATIC EFI_GUID  mUdfDevicePathGuid = {
+  0xC5BD4D42, 0x1A76, 0x4996, { 0x89, 0x56, 0x73, 0xCD, 0xA3, 0x26, 0xCD, 0x0A }
+};
+
+typedef struct {
+  UINTN    ChunkSize;
+  UINTN    Rounds;
+} BENCHMARK_PARAMS;
+
+typedef struct {
+  CHAR16    **Paths;
+  UINTN     Count;
+  UINTN     Directories;
+} FILE_LIST;
+
+/**
+  Return the time elapsed since a performance counter value, in nanoseconds.
+
+  @param[in] Start  The performance counter value at the start of the
+                    measurement.
+
+  @return  The elapsed time in nanoseconds.
+**/
+STATIC
+UINT64
+ElapsedNs (
+  IN UINT64  Start
+  )
+{
+  UINT64  End;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  End = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    //
+    // The counter counts down.
+    //
+    return GetTimeInNanoSecond (Start - End);
+  }
+
+  return GetTimeInNanoSecond (End - Start);
+}
+
+/**
+  Print the result of a measurement.
+
+  @param[in] Label      The name of the operation measured.
+  @param[in] Files      The number of files handled.
+  @param[in] Bytes      The number of bytes read.
+  @param[in] ElapsedNs  The time the operations took, in nanoseconds.
+**/
+STATIC
+VOID
+PrintResult (
+  IN CONST CHAR16  *Label,
+  IN UINT64        Files,
+  IN UINT64        Bytes,
+  IN UINT64        ElapsedNs
+  )
+{
+  UINT64  KibPerSec;
+
+  if (ElapsedNs == 0) {
+    ElapsedNs = 1;
+  }
+
+  KibPerSec = DivU64x64Remainder (MultU64x32 (Bytes, 1000000000 / SIZE_1KB), ElapsedNs, NULL);
+  Print (
+    L"  %-6s %8Lu files/s %6Lu.%02Lu MiB/s (%Lu files, %Lu bytes in %Lu us)\n",
+    Label,
+    DivU64x64Remainder (MultU64x32 (Files, 1000000000), ElapsedNs, NULL),
+    DivU64x32 (KibPerSec, SIZE_1KB),
+    DivU64x32 (MultU64x32 (KibPerSec % SIZE_1KB, 100), SIZE_1KB),
+    Files,
+    Bytes,
+    DivU64x32 (ElapsedNs, 1000)
+    );
+}
+
+/**
+  Tell whether a file system is an UDF file system, from the last node of its
+  device path.
+
+  @param[in] Handle  The handle carrying EFI_SIMPLE_FILE_SYSTEM_PROTOCOL.
+
+  @retval TRUE   The file system is an UDF file system.
+  @retval FALSE  The file system is not an UDF file system.
+**/
+STATIC
+BOOLEAN
+IsUdfFileSystem (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
+  EFI_DEVICE_PATH_PROTOCOL  *LastNode;
+
+  DevicePath = DevicePathFromHandle (Handle);
+  if (DevicePath == NULL) {
+    return FALSE;
+  }
+
+  LastNode = NULL;
+  while (!IsDevicePathEnd (DevicePath)) {
+    LastNode   = DevicePath;
+    DevicePath = NextDevicePathNode (DevicePath);
+  }
+
+  return (LastNode != NULL &&
+          DevicePathType (LastNode) == MEDIA_DEVICE_PATH &&
+          DevicePathSubType (LastNode) == MEDIA_VENDOR_DP &&
+          CompareGuid (&((VENDOR_DEVICE_PATH *)LastNode)->Guid, &mUdfDevicePathGuid));
+}
+
+/**
+  Add the absolute paths of the files below a directory to a list, recursing
+  into subdirectories.
+
+  @param[in]      Dir     The directory.
+  @param[in, out] Path    The absolute path of the directory, in a buffer of
+                          MAX_PATH_LENGTH characters. It is restored on
+                          return.
+  @param[in]      Info    A buffer of FILE_INFO_SIZE bytes.
+  @param[in, out] List    The list of files.
+
+  @retval EFI_SUCCESS           The directory was listed.
+  @retval EFI_OUT_OF_RESOURCES  The list is full or could not be grown.
+  @return                       Error codes from EFI_FILE_PROTOCOL.
+**/
+STATIC
+EFI_STATUS
+CollectFiles (
+  IN     EFI_FILE_PROTOCOL  *Dir,
+  IN OUT CHAR16             *Path,
+  IN     EFI_FILE_INFO      *Info,
+  IN OUT FILE_LIST          *List
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *SubDir;
+  UINTN              PathLength;
+  UINTN              Size;
+
+  List->Directories++;
+  PathLength = StrLen (Path);
+
+  for ( ; ;) {
+    Size   = FILE_INFO_SIZE;
+    Status = Dir->Read (Dir, &Size, Info);
+    if (EFI_ERROR (Status) || (Size == 0)) {
+      return Status;
+    }
+
+    if ((StrCmp (Info->FileName, L".") == 0) ||
+        (StrCmp (Info->FileName, L"..") == 0))
+    {
+      continue;
+    }
+
+    Path[PathLength] = L'\0';
+    if ((PathLength > 1) &&
+        EFI_ERROR (StrCatS (Path, MAX_PATH_LENGTH, L"\\")))
+    {
+      continue;
+    }
+
+    if (EFI_ERROR (StrCatS (Path, MAX_PATH_LENGTH, Info->FileName))) {
+      Path[PathLength] = L'\0';
+      continue;
+    }
+
+    if ((Info->Attribute & EFI_FILE_DIRECTORY) != 0) {
+      Status = Dir->Open (Dir, &SubDir, Info->FileName, EFI_FILE_MODE_READ, 0);
+      if (!EFI_ERROR (Status)) {
+        Status = CollectFiles (SubDir, Path, Info, List);
+        SubDir->Close (SubDir);
+      }
+    } else if (List->Count < MAX_FILES) {
+      List->Paths[List->Count] = AllocateCopyPool (StrSize (Path), Path);
+      Status                   = (List->Paths[List->Count] == NULL) ?
+                                 EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
+      if (!EFI_ERROR (Status)) {
+        List->Count++;
+      }
+    } else {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+
+    Path[PathLength] = L'\0';
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+}
+
+/**
+  Open every file of the list by its absolute path, and close it.
+
+  @param[in] Root  The root directory of the file system.
+  @param[in] List  The list of files.
+**/
+STATIC
+VOID
+BenchmarkOpen (
+  IN EFI_FILE_PROTOCOL  *Root,
+  IN CONST FILE_LIST    *List
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  UINTN              Index;
+  UINT64             Start;
+
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < List->Count; Index++) {
+    Status = Root->Open (Root, &File, List->Paths[Index], EFI_FILE_MODE_READ, 0);
+    if (EFI_ERROR (Status)) {
+      Print (L"  open   failed: %s: %r\n", List->Paths[Index], Status);
+      return;
+    }
+
+    File->Close (File);
+  }
+
+  PrintResult (L"open", List->Count, 0, ElapsedNs (Start));
+}
+
+/**
+  Open every file of the list by its absolute path, read it to its end, and
+  close it.
+
+  @param[in] Root    The root directory of the file system.
+  @param[in] List    The list of files.
+  @param[in] Buffer  A buffer of Params->ChunkSize bytes.
+  @param[in] Params  The benchmark parameters.
+**/
+STATIC
+VOID
+BenchmarkRead (
+  IN EFI_FILE_PROTOCOL       *Root,
+  IN CONST FILE_LIST         *List,
+  IN VOID                    *Buffer,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+  UINTN              Index;
+  UINTN              Size;
+  UINT64             Bytes;
+  UINT64             Start;
+
+  Bytes = 0;
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < List->Count; Index++) {
+    Status = Root->Open (Root, &File, List->Paths[Index], EFI_FILE_MODE_READ, 0);
+    if (EFI_ERROR (Status)) {
+      Print (L"  read   failed to open: %s: %r\n", List->Paths[Index], Status);
+      return;
+    }
+
+    do {
+      Size   = Params->ChunkSize;
+      Status = File->Read (File, &Size, Buffer);
+      Bytes += Size;
+    } while (!EFI_ERROR (Status) && Size == Params->ChunkSize);
+
+    File->Close (File);
+    if (EFI_ERROR (Status)) {
+      Print (L"  read   failed: %s: %r\n", List->Paths[Index], Status);
+      return;
+    }
+  }
+
+  PrintResult (L"read", List->Count, Bytes, ElapsedNs (Start));
+}
+
+/**
+  Run the benchmark on one file system.
+
+  @param[in] Handle  The handle carrying EFI_SIMPLE_FILE_SYSTEM_PROTOCOL.
+  @param[in] Buffer  A buffer of Params->ChunkSize bytes.
+  @param[in] Params  The benchmark parameters.
+**/
+STATIC
+VOID
+BenchmarkFileSystem (
+  IN EFI_HANDLE              Handle,
+  IN VOID                    *Buffer,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+  EFI_FILE_PROTOCOL                *Root;
+  EFI_FILE_INFO                    *Info;
+  CHAR16                           *Path;
+  FILE_LIST                        List;
+  UINTN                            Round;
+  UINTN                            Index;
+  UINT64                           Start;
+
+  if (!IsUdfFileSystem (Handle)) {
+    return;
+  }
+
+  Status = gBS->HandleProtocol (Handle, &gEfiSimpleFileSystemProtocolGuid, (VOID **)&FileSystem);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = FileSystem->OpenVolume (FileSystem, &Root);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Print (L"Handle %p:\n", Handle);
+
+  List.Paths       = AllocatePool (MAX_FILES * sizeof (CHAR16 *));
+  List.Count       = 0;
+  List.Directories = 0;
+  Info             = AllocatePool (FILE_INFO_SIZE);
+  Path             = AllocateZeroPool (MAX_PATH_LENGTH * sizeof (CHAR16));
+  if ((List.Paths == NULL) || (Info == NULL) || (Path == NULL)) {
+    Print (L"  out of resources\n");
+    goto FreeBuffers;
+  }
+
+  Path[0] = L'\\';
+  Start   = GetPerformanceCounter ();
+  Status  = CollectFiles (Root, Path, Info, &List);
+  if (EFI_ERROR (Status)) {
+    Print (L"  list   stopped after %u files: %r\n", (UINT32)List.Count, Status);
+  } else {
+    PrintResult (L"list", List.Count, 0, ElapsedNs (Start));
+  }
+
+  Print (L"  %u directories, %u files\n", (UINT32)List.Directories, (UINT32)List.Count);
+
+  for (Round = 1; Round <= Params->Rounds; Round++) {
+    Print (L"  round %u\n", (UINT32)Round);
+    BenchmarkOpen (Root, &List);
+    BenchmarkRead (Root, &List, Buffer, Params);
+  }
+
+FreeBuffers:
+  if (List.Paths != NULL) {
+    for (Index = 0; Index < List.Count; Index++) {
+      FreePool (List.Paths[Index]);
+    }
+
+    FreePool (List.Paths);
+  }
+
+  if (Info != NULL) {
+    FreePool (Info);
+  }
+
+  if (Path != NULL) {
+    FreePool (Path);
+  }
+
+  Root->Close (Root);
+}
+
+/**
+  Entry point of the application.
+
+  @param[in] Argc  The number of command line arguments.
+  @param[in] Argv  The command line arguments.
+
+  @retval 0  The benchmark ran.
+  @retval 1  Invalid command line, or no file system to run the benchmark on.
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN   Argc,
+  IN CHAR16  **Argv
+  )
+{
+  EFI_STATUS        Status;
+  BENCHMARK_PARAMS  Params;
+  EFI_HANDLE        *Handles;
+  UINTN             NumHandles;
+  UINTN             Index;
+  UINTN             Value;
+  VOID              *Buffer;
+
+  Params.ChunkSize = DEFAULT_CHUNK_KIB * SIZE_1KB;
+  Params.Rounds    = DEFAULT_ROUNDS;
+
+  for (Index = 1; Index + 1 < Argc; Index += 2) {
+    Value = StrDecimalToUintn (Argv[Index + 1]);
+    if (Value == 0) {
+      break;
+    }
+
+    if (StrCmp (Argv[Index], L"-c") == 0) {
+      Params.ChunkSize = MIN (Value, MAX_CHUNK_KIB) * SIZE_1KB;
+    } else if (StrCmp (Argv[Index], L"-r") == 0) {
+      Params.Rounds = Value;
+    } else {
+      break;
+    }
+  }
+
+  if (Index != Argc) {
+    Print (L"Usage: %s [-c ChunkKiB] [-r Rounds]\n", Argv[0]);
+    return 1;
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  NULL,
+                  &NumHandles,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    Print (L"No EFI_SIMPLE_FILE_SYSTEM_PROTOCOL instance found: %r\n", Status);
+    return 1;
+  }
+
+  Buffer = AllocatePool (Params.ChunkSize);
+  if (Buffer == NULL) {
+    FreePool (Handles);
+    Print (L"Out of resources\n");
+    return 1;
+  }
+
+  for (Index = 0; Index < NumHandles; Index++) {
+    BenchmarkFileSystem (Handles[Index], Buffer, &Params);
+  }
+
+  FreePool (Buffer);
+  FreePool (Handles);
+  return 0;
+}
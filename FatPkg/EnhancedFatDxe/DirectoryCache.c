@@ -37,6 +37,7 @@ FatFreeODir (
     FatFreeDirEnt (DirEnt);
   }
 
+  FatFreeHashTable (ODir);
   FreePool (ODir);
 }
 
@@ -63,11 +64,43 @@ FatAllocateODir (
     ODir->Signature = FAT_ODIR_SIGNATURE;
     InitializeListHead (&ODir->ChildList);
     ODir->CurrentCursor = &ODir->ChildList;
+    ODir->MemorySize    = sizeof (FAT_ODIR);
+    if (EFI_ERROR (FatInitializeHashTable (ODir))) {
+      FreePool (ODir);
+      ODir = NULL;
+    }
   }
 
   return ODir;
 }
 
+/**
+
+  Discard the least recently used directories from the directory cache
+  until it fits both its entry count and its memory budget.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+STATIC
+VOID
+FatTrimODirCache (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  FAT_ODIR  *ODir;
+
+  while ((Volume->DirCacheCount > FAT_MAX_DIR_CACHE_COUNT) ||
+         ((Volume->DirCacheCount > 0) && (Volume->DirCacheSize > PcdGet32 (PcdFatDirCacheSize))))
+  {
+    ODir = ODIR_FROM_DIRCACHELINK (Volume->DirCacheList.BackLink);
+    RemoveEntryList (&ODir->DirCacheLink);
+    Volume->DirCacheCount--;
+    Volume->DirCacheSize -= ODir->MemorySize;
+    FatFreeODir (ODir);
+  }
+}
+
 /**
 
   Discard the directory structure when an OFile will be freed.
@@ -86,34 +119,27 @@ FatDiscardODir (
 
   Volume = OFile->Volume;
   ODir   = OFile->ODir;
-  if (!OFile->DirEnt->Invalid) {
+  if (OFile->DirEnt->Invalid) {
     //
-    // If OFile does not represent a deleted file, then we will cache the directory
-    // We use OFile's first cluster as the directory's tag
+    // Release ODir Structure
     //
-    ODir->DirCacheTag = OFile->FileCluster;
-    InsertHeadList (&Volume->DirCacheList, &ODir->DirCacheLink);
-    if (Volume->DirCacheCount == FAT_MAX_DIR_CACHE_COUNT) {
-      //
-      // Replace the least recent used directory
-      //
-      ODir = ODIR_FROM_DIRCACHELINK (Volume->DirCacheList.BackLink);
-      RemoveEntryList (&ODir->DirCacheLink);
-    } else {
-      //
-      // No need to find a replace
-      //
-      Volume->DirCacheCount++;
-      ODir = NULL;
-    }
+    FatFreeODir (ODir);
+    return;
   }
 
   //
-  // Release ODir Structure
+  // If OFile does not represent a deleted file, then we will cache the directory
+  // We use OFile's first cluster as the directory's tag
+  // The cache is kept in most recently used order, and the least recently used
+  // directories are replaced when there are too many of them or they use more
+  // memory than PcdFatDirCacheSize, so that a few very large directories do
+  // not hold on to all the memory
   //
-  if (ODir != NULL) {
-    FatFreeODir (ODir);
-  }
+  ODir->DirCacheTag = OFile->FileCluster;
+  InsertHeadList (&Volume->DirCacheList, &ODir->DirCacheLink);
+  Volume->DirCacheCount++;
+  Volume->DirCacheSize += ODir->MemorySize;
+  FatTrimODirCache (Volume);
 }
 
 /**
@@ -149,6 +175,7 @@ FatRequestODir (
     if (CurrentODir->DirCacheTag == DirCacheTag) {
       RemoveEntryList (&CurrentODir->DirCacheLink);
       Volume->DirCacheCount--;
+      Volume->DirCacheSize -= CurrentODir->MemorySize;
       ODir = CurrentODir;
       break;
     }
@@ -184,4 +211,6 @@ FatCleanupODirCache (
     FatFreeODir (ODir);
     Volume->DirCacheCount--;
   }
+
+  Volume->DirCacheSize = 0;
 }
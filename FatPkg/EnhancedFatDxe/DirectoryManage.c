@@ -1228,6 +1228,10 @@ FatCloseDirEnt (
     FatDiscardODir (OFile);
   }
 
+  if (OFile->Extents != NULL) {
+    FreePool (OFile->Extents);
+  }
+
   if (OFile->Parent == NULL) {
     Volume->Root = NULL;
   } else {
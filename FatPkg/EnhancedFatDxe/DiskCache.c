@@ -118,6 +118,33 @@ SetCacheTagDirty (
   CacheTag->Dirty = TRUE;
 }
 
+/**
+  Wait for the read ahead of a cache page to complete. If the read ahead
+  failed, the cache page is invalidated.
+
+  @param[in]    CacheTag   - CacheTag of the cache page
+
+**/
+STATIC
+VOID
+FatWaitReadAhead (
+  IN CACHE_TAG  *CacheTag
+  )
+{
+  if (!CacheTag->ReadAhead) {
+    return;
+  }
+
+  while (gBS->CheckEvent (CacheTag->ReadAheadToken.Event) == EFI_NOT_READY) {
+  }
+
+  gBS->CloseEvent (CacheTag->ReadAheadToken.Event);
+  CacheTag->ReadAhead = FALSE;
+  if (EFI_ERROR (CacheTag->ReadAheadToken.TransactionStatus)) {
+    CacheTag->RealSize = 0;
+  }
+}
+
 /**
   Cache version of FatDiskIo for writing only those LBA's with dirty data.
 
@@ -255,6 +282,7 @@ FatFlushDataCacheRange (
   for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
     GroupNo  = PageNo & GroupMask;
     CacheTag = &DiskCache->CacheTag[GroupNo];
+    FatWaitReadAhead (CacheTag);
     if ((CacheTag->RealSize > 0) && (CacheTag->PageNo == PageNo)) {
       //
       // When reading data from disk directly, if some dirty data
@@ -377,6 +405,7 @@ FatGetCachePage (
   EFI_STATUS  Status;
   UINTN       OldPageNo;
 
+  FatWaitReadAhead (CacheTag);
   OldPageNo = CacheTag->PageNo;
   if ((CacheTag->RealSize > 0) && (OldPageNo == PageNo)) {
     //
@@ -460,6 +489,103 @@ FatAccessUnalignedCachePage (
   return Status;
 }
 
+/**
+
+  Detect sequential reads of the data cache, and read the pages following a
+  sequential read ahead asynchronously through DiskIo2.
+
+  The number of pages read ahead doubles with each sequential read, up to
+  ReadAheadMaxCount, and drops to zero on a non-sequential read. A page is
+  only read ahead into a cache page that is clean and not being read ahead,
+  so that no dirty data is lost and no read ahead is waited for.
+
+  @param  Volume                - FAT file system volume.
+  @param  StartPageNo           - The first page of the read.
+  @param  EndPageNo             - The page containing the byte following the read.
+
+**/
+STATIC
+VOID
+FatReadAhead (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       StartPageNo,
+  IN UINTN       EndPageNo
+  )
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       PageNo;
+  UINTN       LastPageNo;
+  UINTN       GroupNo;
+  UINTN       RealSize;
+  UINT64      EntryPos;
+  UINT8       PageAlignment;
+
+  DiskCache     = &Volume->DiskCache[CacheData];
+  PageAlignment = DiskCache->PageAlignment;
+  if (StartPageNo != DiskCache->SequentialPageNo) {
+    DiskCache->SequentialPageNo = EndPageNo;
+    DiskCache->ReadAheadPageNo  = 0;
+    DiskCache->ReadAheadCount   = 0;
+    return;
+  }
+
+  DiskCache->SequentialPageNo = EndPageNo;
+  if ((Volume->DiskIo2 == NULL) || (DiskCache->ReadAheadMaxCount == 0)) {
+    return;
+  }
+
+  DiskCache->ReadAheadCount = MIN (MAX (DiskCache->ReadAheadCount * 2, 1), DiskCache->ReadAheadMaxCount);
+  LastPageNo                = EndPageNo + DiskCache->ReadAheadCount;
+
+  for (PageNo = MAX (EndPageNo, DiskCache->ReadAheadPageNo); PageNo < LastPageNo; PageNo++) {
+    EntryPos = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
+    if (EntryPos >= DiskCache->LimitAddress) {
+      break;
+    }
+
+    GroupNo  = PageNo & DiskCache->GroupMask;
+    CacheTag = &DiskCache->CacheTag[GroupNo];
+    if ((CacheTag->RealSize > 0) && (CacheTag->PageNo == PageNo)) {
+      continue;
+    }
+
+    if (CacheTag->ReadAhead || ((CacheTag->RealSize > 0) && CacheTag->Dirty)) {
+      break;
+    }
+
+    Status = gBS->CreateEvent (0, 0, NULL, NULL, &CacheTag->ReadAheadToken.Event);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    RealSize = (UINTN)MIN (DiskCache->LimitAddress - EntryPos, (UINTN)1 << PageAlignment);
+    ClearCacheTagDirtyState (CacheTag);
+    CacheTag->PageNo                           = PageNo;
+    CacheTag->RealSize                         = RealSize;
+    CacheTag->ReadAhead                        = TRUE;
+    CacheTag->ReadAheadToken.TransactionStatus = EFI_SUCCESS;
+
+    Status = Volume->DiskIo2->ReadDiskEx (
+                                Volume->DiskIo2,
+                                Volume->MediaId,
+                                EntryPos,
+                                &CacheTag->ReadAheadToken,
+                                RealSize,
+                                DiskCache->CacheBase + (GroupNo << PageAlignment)
+                                );
+    if (EFI_ERROR (Status)) {
+      gBS->CloseEvent (CacheTag->ReadAheadToken.Event);
+      CacheTag->ReadAhead = FALSE;
+      CacheTag->RealSize  = 0;
+      break;
+    }
+  }
+
+  DiskCache->ReadAheadPageNo = PageNo;
+}
+
 /**
 
   Read BufferSize bytes from the position of Offset into Buffer,
@@ -507,9 +633,12 @@ FatAccessCache (
   UINTN       AlignedSize;
   UINTN       Length;
   UINTN       PageNo;
+  UINTN       StartPageNo;
+  UINTN       EndPageNo;
   UINTN       AlignedPageCount;
   UINTN       OverRunPageNo;
   DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
   UINT64      EntryPos;
   UINT8       PageAlignment;
 
@@ -522,6 +651,8 @@ FatAccessCache (
   PageSize      = (UINTN)1 << PageAlignment;
   PageNo        = (UINTN)RShiftU64 (EntryPos, PageAlignment);
   UnderRun      = ((UINTN)EntryPos) & (PageSize - 1);
+  StartPageNo   = PageNo;
+  EndPageNo     = (UINTN)RShiftU64 (EntryPos + BufferSize, PageAlignment);
 
   if (UnderRun > 0) {
     Length = PageSize - UnderRun;
@@ -541,6 +672,25 @@ FatAccessCache (
 
   AlignedPageCount = BufferSize >> PageAlignment;
   OverRunPageNo    = PageNo + AlignedPageCount;
+
+  //
+  // Copy the leading aligned pages which are already in the data cache, such as
+  // the pages read ahead, instead of reading them from the disk again
+  //
+  while ((IoMode == ReadDisk) && (CacheDataType == CacheData) && (AlignedPageCount > 0)) {
+    CacheTag = &DiskCache->CacheTag[PageNo & DiskCache->GroupMask];
+    FatWaitReadAhead (CacheTag);
+    if ((CacheTag->RealSize != PageSize) || (CacheTag->PageNo != PageNo)) {
+      break;
+    }
+
+    CopyMem (Buffer, DiskCache->CacheBase + ((PageNo & DiskCache->GroupMask) << PageAlignment), PageSize);
+    Buffer     += PageSize;
+    BufferSize -= PageSize;
+    PageNo++;
+    AlignedPageCount--;
+  }
+
   //
   // The access of the Aligned data
   //
@@ -577,9 +727,121 @@ FatAccessCache (
     Status = FatAccessUnalignedCachePage (Volume, CacheDataType, IoMode, OverRunPageNo, 0, OverRun, Buffer);
   }
 
+  if ((IoMode == ReadDisk) && (CacheDataType == CacheData) && !EFI_ERROR (Status)) {
+    FatReadAhead (Volume, StartPageNo, EndPageNo);
+  }
+
   return Status;
 }
 
+/**
+
+  Write back the dirty FAT cache pages to every copy of the FAT.
+
+  The dirty pages are written in ascending order, one copy of the FAT after the
+  other, so that each copy is written in a single pass over the disk. Dirty
+  blocks that are adjacent both on the disk and in the cache buffer are
+  coalesced into a single write, even across cache pages.
+
+  @param  Volume                - FAT file system volume.
+  @param  Task                    point to task instance.
+
+  @retval EFI_SUCCESS           - The FAT cache is written back successfully.
+  @return other                 - An error occurred when writing the FAT to the disk.
+
+**/
+STATIC
+EFI_STATUS
+FatFlushFatCache (
+  IN FAT_VOLUME  *Volume,
+  IN FAT_TASK    *Task
+  )
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *DirtyTags[FAT_FATCACHE_GROUP_MAX_COUNT];
+  CACHE_TAG   *CacheTag;
+  UINTN       DirtyCount;
+  UINTN       GroupIndex;
+  UINTN       Index;
+  UINTN       FatIndex;
+  UINTN       Block;
+  UINTN       LastBlock;
+  UINT64      BlockPos;
+  UINT8       *BlockAddress;
+  UINT64      RunPos;
+  UINT8       *RunAddress;
+  UINTN       RunSize;
+
+  DiskCache = &Volume->DiskCache[CacheFat];
+  ASSERT (DiskCache->GroupMask < FAT_FATCACHE_GROUP_MAX_COUNT);
+
+  //
+  // Sort the dirty pages by page number
+  //
+  DirtyCount = 0;
+  for (GroupIndex = 0; GroupIndex <= DiskCache->GroupMask; GroupIndex++) {
+    CacheTag = &DiskCache->CacheTag[GroupIndex];
+    if ((CacheTag->RealSize == 0) || !CacheTag->Dirty) {
+      continue;
+    }
+
+    for (Index = DirtyCount; (Index > 0) && (DirtyTags[Index - 1]->PageNo > CacheTag->PageNo); Index--) {
+      DirtyTags[Index] = DirtyTags[Index - 1];
+    }
+
+    DirtyTags[Index] = CacheTag;
+    DirtyCount++;
+  }
+
+  for (FatIndex = 0; FatIndex < Volume->NumFats; FatIndex++) {
+    RunPos     = 0;
+    RunAddress = NULL;
+    RunSize    = 0;
+    for (Index = 0; Index < DirtyCount; Index++) {
+      CacheTag     = DirtyTags[Index];
+      LastBlock    = (CacheTag->RealSize - 1) / DiskCache->BlockSize;
+      BlockPos     = DiskCache->BaseAddress + LShiftU64 (CacheTag->PageNo, DiskCache->PageAlignment) +
+                     MultU64x32 (Volume->FatSize, (UINT32)FatIndex);
+      BlockAddress = DiskCache->CacheBase + ((CacheTag->PageNo & DiskCache->GroupMask) << DiskCache->PageAlignment);
+      for (Block = 0; Block <= LastBlock; Block++) {
+        if (IsBitInBlockDirty (Block, CacheTag->DirtyBlocks)) {
+          if ((RunSize != 0) && (RunPos + RunSize == BlockPos) && (RunAddress + RunSize == BlockAddress)) {
+            RunSize += DiskCache->BlockSize;
+          } else {
+            if (RunSize != 0) {
+              Status = FatDiskIo (Volume, WriteDisk, RunPos, RunSize, RunAddress, Task);
+              if (EFI_ERROR (Status)) {
+                return Status;
+              }
+            }
+
+            RunPos     = BlockPos;
+            RunAddress = BlockAddress;
+            RunSize    = DiskCache->BlockSize;
+          }
+        }
+
+        BlockPos     += DiskCache->BlockSize;
+        BlockAddress += DiskCache->BlockSize;
+      }
+    }
+
+    if (RunSize != 0) {
+      Status = FatDiskIo (Volume, WriteDisk, RunPos, RunSize, RunAddress, Task);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+  }
+
+  for (Index = 0; Index < DirtyCount; Index++) {
+    ClearCacheTagDirtyState (DirtyTags[Index]);
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
 
   Flush all the dirty cache back, include the FAT cache and the Data cache.
@@ -606,9 +868,19 @@ FatVolumeFlushCache (
 
   for (CacheDataType = (CACHE_DATA_TYPE)0; CacheDataType < CacheMaxType; CacheDataType++) {
     DiskCache = &Volume->DiskCache[CacheDataType];
-    if (DiskCache->Dirty) {
+    if (DiskCache->Dirty && (CacheDataType == CacheFat)) {
+      //
+      // Fat cache is dirty, write all the copies of the fat back
+      //
+      Status = FatFlushFatCache (Volume, Task);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      DiskCache->Dirty = FALSE;
+    } else if (DiskCache->Dirty) {
       //
-      // Data cache or fat cache is dirty, write the dirty data back
+      // Data cache is dirty, write the dirty data back
       //
       GroupMask = DiskCache->GroupMask;
       for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex++) {
@@ -652,9 +924,11 @@ FatInitializeDiskCache (
 {
   DISK_CACHE  *DiskCache;
   UINTN       FatCacheGroupCount;
+  UINTN       DataCacheGroupCount;
   UINTN       DataCacheSize;
   UINTN       FatCacheSize;
   UINT8       *CacheBuffer;
+  CACHE_TAG   *CacheTag;
 
   DiskCache = Volume->DiskCache;
   //
@@ -670,14 +944,31 @@ FatInitializeDiskCache (
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MAX_ALIGNMENT;
   }
 
-  DiskCache[CacheData].GroupMask    = FAT_DATACACHE_GROUP_COUNT - 1;
+  //
+  // Size the data cache from the memory budget, as a power of two number of
+  // pages, but not much larger than the volume
+  //
+  DataCacheGroupCount = GetPowerOfTwo32 (PcdGet32 (PcdFatDataCacheSize) >> DiskCache[CacheData].PageAlignment);
+  DataCacheGroupCount = MAX (DataCacheGroupCount, FAT_DATACACHE_GROUP_MIN_COUNT);
+  while ((DataCacheGroupCount > FAT_DATACACHE_GROUP_MIN_COUNT) &&
+         (LShiftU64 (DataCacheGroupCount / 2, DiskCache[CacheData].PageAlignment) >= Volume->VolumeSize))
+  {
+    DataCacheGroupCount /= 2;
+  }
+
+  DiskCache[CacheData].ReadAheadMaxCount = MIN (
+                                             PcdGet32 (PcdFatReadAheadSize) >> DiskCache[CacheData].PageAlignment,
+                                             DataCacheGroupCount / 2
+                                             );
+
+  DiskCache[CacheData].GroupMask    = DataCacheGroupCount - 1;
   DiskCache[CacheData].BaseAddress  = Volume->RootPos;
   DiskCache[CacheData].LimitAddress = Volume->VolumeSize;
   DiskCache[CacheFat].GroupMask     = FatCacheGroupCount - 1;
   DiskCache[CacheFat].BaseAddress   = Volume->FatPos;
   DiskCache[CacheFat].LimitAddress  = Volume->FatPos + Volume->FatSize;
   FatCacheSize                      = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
-  DataCacheSize                     = FAT_DATACACHE_GROUP_COUNT << DiskCache[CacheData].PageAlignment;
+  DataCacheSize                     = DataCacheGroupCount << DiskCache[CacheData].PageAlignment;
   //
   // Allocate the Fat Cache buffer
   //
@@ -686,12 +977,57 @@ FatInitializeDiskCache (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  CacheTag = AllocateZeroPool ((FatCacheGroupCount + DataCacheGroupCount) * sizeof (CACHE_TAG));
+  if (CacheTag == NULL) {
+    FreePool (CacheBuffer);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
   Volume->CacheBuffer            = CacheBuffer;
   DiskCache[CacheFat].CacheBase  = CacheBuffer;
   DiskCache[CacheData].CacheBase = CacheBuffer + FatCacheSize;
+  DiskCache[CacheFat].CacheTag   = CacheTag;
+  DiskCache[CacheData].CacheTag  = CacheTag + FatCacheGroupCount;
 
   DiskCache[CacheFat].BlockSize  = Volume->BlockIo->Media->BlockSize;
   DiskCache[CacheData].BlockSize = Volume->BlockIo->Media->BlockSize;
 
+  DEBUG ((
+    DEBUG_INFO,
+    "FatInitializeDiskCache: %d data cache pages of 0x%x bytes, read ahead up to %d pages\n",
+    DataCacheGroupCount,
+    (UINTN)1 << DiskCache[CacheData].PageAlignment,
+    DiskCache[CacheData].ReadAheadMaxCount
+    ));
+
   return EFI_SUCCESS;
 }
+
+/**
+
+  Wait for the outstanding read ahead of the data cache, then free the disk cache.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatFreeDiskCache (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  DISK_CACHE  *DiskCache;
+  UINTN       GroupIndex;
+
+  DiskCache = &Volume->DiskCache[CacheData];
+  if (DiskCache->CacheTag != NULL) {
+    for (GroupIndex = 0; GroupIndex <= DiskCache->GroupMask; GroupIndex++) {
+      FatWaitReadAhead (&DiskCache->CacheTag[GroupIndex]);
+    }
+
+    FreePool (Volume->DiskCache[CacheFat].CacheTag);
+  }
+
+  if (Volume->CacheBuffer != NULL) {
+    FreePool (Volume->CacheBuffer);
+  }
+}
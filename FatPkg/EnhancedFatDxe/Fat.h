@@ -10,6 +10,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Uefi.h>
 
+#include <Guid/EventGroup.h>
 #include <Guid/FileInfo.h>
 #include <Guid/FileSystemInfo.h>
 #include <Guid/FileSystemVolumeLabelInfo.h>
@@ -79,10 +80,21 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FAT_FATCACHE_PAGE_MAX_ALIGNMENT   15
 #define FAT_DATACACHE_PAGE_MIN_ALIGNMENT  13
 #define FAT_DATACACHE_PAGE_MAX_ALIGNMENT  16
-#define FAT_DATACACHE_GROUP_COUNT         64
+#define FAT_DATACACHE_GROUP_MIN_COUNT     8
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// The free cluster bitmap is built from 4KB of FAT entries at a time
+//
+#define FAT_FREE_BITMAP_CHUNK_SIZE  0x1000
+#define FAT_FREE_CHUNK_NOT_LOADED   MAX_UINT32
+
+//
+// The number of clusters looked at by each search for a run of free clusters
+//
+#define FAT_FREE_RUN_SEARCH_LIMIT  0x10000
+
 // For cache block bits, use a UINT64
 typedef UINT64 DIRTY_BLOCKS;
 #define BITS_PER_BYTE         8
@@ -115,8 +127,9 @@ STATIC_ASSERT ((((1 << FAT_DATACACHE_PAGE_MAX_ALIGNMENT) / (1 << MIN_BLOCK_ALIGN
 #define LC_ISO_639_2_ENTRY_SIZE  3
 #define MAX_LANG_CODE_SIZE       100
 
-#define FAT_MAX_DIR_CACHE_COUNT  8
+#define FAT_MAX_DIR_CACHE_COUNT  64
 #define FAT_MAX_DIRENTRY_COUNT   0xFFFF
+#define FAT_MIN_EXTENT_COUNT     8
 typedef CHAR8 LC_ISO_639_2;
 
 //
@@ -155,10 +168,15 @@ typedef enum {
 // Disk cache tag
 //
 typedef struct {
-  UINTN           PageNo;
-  UINTN           RealSize;
-  BOOLEAN         Dirty;
-  DIRTY_BLOCKS    DirtyBlocks[DIRTY_BLOCKS_SIZE];
+  UINTN                 PageNo;
+  UINTN                 RealSize;
+  BOOLEAN               Dirty;
+  DIRTY_BLOCKS          DirtyBlocks[DIRTY_BLOCKS_SIZE];
+  //
+  // An asynchronous read ahead is loading this page
+  //
+  BOOLEAN               ReadAhead;
+  EFI_DISK_IO2_TOKEN    ReadAheadToken;
 } CACHE_TAG;
 
 typedef struct {
@@ -169,14 +187,22 @@ typedef struct {
   BOOLEAN      Dirty;
   UINT8        PageAlignment;
   UINTN        GroupMask;
-  CACHE_TAG    CacheTag[FAT_DATACACHE_GROUP_COUNT];
+  CACHE_TAG    *CacheTag;
+  //
+  // Sequential access detection and read ahead, only for the data cache
+  //
+  UINTN        SequentialPageNo;  // The page the next sequential read starts in
+  UINTN        ReadAheadPageNo;   // The page following the last page read ahead
+  UINTN        ReadAheadCount;    // The number of pages currently read ahead
+  UINTN        ReadAheadMaxCount; // 0 if read ahead is disabled
 } DISK_CACHE;
 
 //
-// Hash table size
+// Hash table size, the hash tables of a directory double in size
+// when it has twice as many entries as buckets
 //
-#define HASH_TABLE_SIZE  0x400
-#define HASH_TABLE_MASK  (HASH_TABLE_SIZE - 1)
+#define HASH_TABLE_MIN_SIZE  0x40
+#define HASH_TABLE_MAX_SIZE  0x10000
 
 //
 // The directory entry for opened directory
@@ -209,10 +235,22 @@ struct _FAT_ODIR {
   BOOLEAN       EndOfDir;                     // Indicate whether we have reached the end of the directory
   LIST_ENTRY    DirCacheLink;                 // Linked in Volume->DirCacheList when discarded
   UINTN         DirCacheTag;                  // The identification of the directory when in directory cache
-  FAT_DIRENT    *LongNameHashTable[HASH_TABLE_SIZE];
-  FAT_DIRENT    *ShortNameHashTable[HASH_TABLE_SIZE];
+  UINTN         MemorySize;                   // The memory used by the directory structure, charged to the directory cache
+  UINTN         HashTableSize;                // The number of buckets of each hash table, a power of 2
+  UINTN         HashEntryCount;               // The number of directory entries in the hash tables
+  FAT_DIRENT    **LongNameHashTable;
+  FAT_DIRENT    **ShortNameHashTable;
 };
 
+//
+// A run of contiguous clusters of an open file
+//
+typedef struct {
+  UINTN    FileCluster;                       // The index of the first cluster of the run within the file
+  UINTN    Cluster;                           // The first cluster of the run on the disk
+  UINTN    Count;                             // The number of clusters in the run
+} FAT_EXTENT;
+
 typedef struct {
   UINTN                Signature;
   EFI_FILE_PROTOCOL    Handle;
@@ -285,6 +323,16 @@ struct _FAT_OFILE {
   UINT64        PosDisk;        // on the disk
   UINTN         PosRem;         // remaining in this disk run
   //
+  // The extent map of the file, built lazily while the cluster chain
+  // is traversed. The extents cover the first ExtentClusters clusters
+  // of the file, and ExtentNext is the FAT entry of the last of them.
+  //
+  FAT_EXTENT    *Extents;
+  UINTN         ExtentCount;
+  UINTN         ExtentMax;
+  UINTN         ExtentClusters;
+  UINTN         ExtentNext;
+  //
   // The opened parent, full path length and currently opened child files
   //
   FAT_OFILE     *Parent;
@@ -349,6 +397,15 @@ struct _FAT_VOLUME {
   UINTN                              FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                            FreeInfoValid;  // If free cluster info is valid
   //
+  // Free cluster bitmap, one bit set for each free cluster. It is built lazily,
+  // one chunk of FreeChunkClusters clusters at a time, and FreeChunkCount holds
+  // the number of free clusters of each chunk, or FAT_FREE_CHUNK_NOT_LOADED.
+  //
+  UINT8                              *FreeBitmap;
+  UINT32                             *FreeChunkCount;
+  UINTN                              FreeChunkClusters;
+  UINTN                              FreeRunHint;   // Where the last free run search stopped
+  //
   // Unpacked Fat BPB info
   //
   UINTN                              NumFats;
@@ -361,6 +418,17 @@ struct _FAT_VOLUME {
   UINT32                             DirtyValue;
   UINT32                             NotDirtyValue;
 
+  //
+  // Write back of the FAT, the free cluster info and the disk cache, deferred
+  // by up to WriteBackDelay milliseconds after the operation that dirtied them.
+  // While it is pending, the dirty value is kept on the disk.
+  //
+  UINT32                             WriteBackDelay; // 0 if every operation writes back
+  BOOLEAN                            WriteBackPending;
+  BOOLEAN                            DirtyOnDisk;
+  EFI_EVENT                          WriteBackEvent;
+  EFI_EVENT                          ExitBootServicesEvent;
+
   //
   // The root directory entry and opened root file
   //
@@ -382,6 +450,7 @@ struct _FAT_VOLUME {
   //
   LIST_ENTRY                         DirCacheList;
   UINTN                              DirCacheCount;
+  UINTN                              DirCacheSize;
 
   //
   // Disk Cache for this volume
@@ -725,6 +794,18 @@ FatInitializeDiskCache (
   IN FAT_VOLUME  *Volume
   );
 
+/**
+
+  Wait for the outstanding read ahead of the data cache, then free the disk cache.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatFreeDiskCache (
+  IN FAT_VOLUME  *Volume
+  );
+
 /**
 
   Read BufferSize bytes from the position of Offset into Buffer,
@@ -871,6 +952,40 @@ FatCleanupVolume (
   IN FAT_TASK    *Task
   );
 
+/**
+
+  Write back the free cluster info, clear the dirty value of the volume and
+  flush the disk cache, including the write back deferred by previous operations.
+
+  @param  Volume                - FAT file system volume.
+  @param  Task                    point to task instance.
+
+  @retval EFI_SUCCESS           - The volume is written back successfully.
+  @return Others                - An error occurred when writing to the disk.
+
+**/
+EFI_STATUS
+FatFlushVolume (
+  IN FAT_VOLUME  *Volume,
+  IN FAT_TASK    *Task
+  );
+
+/**
+
+  Write back the volume when its deferred write back is due, or before
+  ExitBootServices().
+
+  @param  Event                 - The timer event or the before ExitBootServices() event.
+  @param  Context               - The volume.
+
+**/
+VOID
+EFIAPI
+FatWriteBackNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
 //
 // FileSpace.c
 //
@@ -942,6 +1057,18 @@ FatPhysicalFileSize (
   IN UINTN       RealSize
   );
 
+/**
+
+  Discard the extent map of the open file, after its cluster chain is changed.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatResetExtents (
+  IN FAT_OFILE  *OFile
+  );
+
 /**
 
   Seek OFile to requested position, and calculate the number of
@@ -1782,6 +1909,33 @@ FatSetVolumeEntry (
 // Hash.c
 //
 
+/**
+
+  Allocate the initial hash tables of a newly allocated directory.
+
+  @param  ODir                  - The directory.
+
+  @retval EFI_SUCCESS           - The hash tables are allocated.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to allocate the hash tables.
+
+**/
+EFI_STATUS
+FatInitializeHashTable (
+  IN FAT_ODIR  *ODir
+  );
+
+/**
+
+  Free the hash tables of a directory.
+
+  @param  ODir                  - The directory.
+
+**/
+VOID
+FatFreeHashTable (
+  IN FAT_ODIR  *ODir
+  );
+
 /**
 
   Search the long name hash table for the directory entry.
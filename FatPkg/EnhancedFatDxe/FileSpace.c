@@ -122,6 +122,268 @@ FatGetFatEntry (
   return Accum;
 }
 
+/**
+
+  Allocate the free cluster bitmap of the volume, if it is not allocated yet.
+  None of its chunks is loaded.
+
+  @param  Volume                - FAT file system volume.
+
+  @retval TRUE                  - The free cluster bitmap is allocated.
+  @retval FALSE                 - Not enough memory, the FAT must be scanned instead.
+
+**/
+STATIC
+BOOLEAN
+FatInitFreeBitmap (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  UINTN  ClusterCount;
+  UINTN  ChunkCount;
+
+  if (Volume->FreeBitmap != NULL) {
+    return TRUE;
+  }
+
+  //
+  // FAT12 entries are not a whole number of bytes, the whole FAT12 table is
+  // small enough to be a single chunk
+  //
+  ClusterCount = ALIGN_VALUE (Volume->MaxCluster + 2, 8);
+  if (Volume->FatType == Fat12) {
+    Volume->FreeChunkClusters = ClusterCount;
+  } else {
+    Volume->FreeChunkClusters = FAT_FREE_BITMAP_CHUNK_SIZE / Volume->FatEntrySize;
+  }
+
+  ChunkCount             = (ClusterCount + Volume->FreeChunkClusters - 1) / Volume->FreeChunkClusters;
+  Volume->FreeBitmap     = AllocateZeroPool (ClusterCount / 8);
+  Volume->FreeChunkCount = AllocatePool (ChunkCount * sizeof (UINT32));
+  if ((Volume->FreeBitmap == NULL) || (Volume->FreeChunkCount == NULL)) {
+    if (Volume->FreeBitmap != NULL) {
+      FreePool (Volume->FreeBitmap);
+      Volume->FreeBitmap = NULL;
+    }
+
+    if (Volume->FreeChunkCount != NULL) {
+      FreePool (Volume->FreeChunkCount);
+      Volume->FreeChunkCount = NULL;
+    }
+
+    return FALSE;
+  }
+
+  SetMem32 (Volume->FreeChunkCount, ChunkCount * sizeof (UINT32), FAT_FREE_CHUNK_NOT_LOADED);
+  return TRUE;
+}
+
+/**
+
+  Load a chunk of the free cluster bitmap from the FAT entries of its clusters,
+  if it is not loaded yet.
+
+  @param  Volume                - FAT file system volume.
+  @param  Chunk                 - The index of the chunk.
+
+  @retval EFI_SUCCESS           - The chunk is loaded.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to read the FAT entries.
+  @return other                 - An error occurred when reading the FAT entries.
+
+**/
+STATIC
+EFI_STATUS
+FatLoadFreeChunk (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Chunk
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       FirstCluster;
+  UINTN       EndCluster;
+  UINTN       Index;
+  VOID        *Entries;
+  UINT32      FreeCount;
+  BOOLEAN     Free;
+
+  if (Volume->FreeChunkCount[Chunk] != FAT_FREE_CHUNK_NOT_LOADED) {
+    return EFI_SUCCESS;
+  }
+
+  FirstCluster = Chunk * Volume->FreeChunkClusters;
+  EndCluster   = MIN (FirstCluster + Volume->FreeChunkClusters, Volume->MaxCluster + 2);
+  Entries      = NULL;
+  if (Volume->FatType != Fat12) {
+    Entries = AllocatePool (FAT_FREE_BITMAP_CHUNK_SIZE);
+    if (Entries == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Status = FatDiskIo (
+               Volume,
+               ReadFat,
+               Volume->FatPos + FirstCluster * Volume->FatEntrySize,
+               (EndCluster - FirstCluster) * Volume->FatEntrySize,
+               Entries,
+               NULL
+               );
+    if (EFI_ERROR (Status)) {
+      FreePool (Entries);
+      return Status;
+    }
+  }
+
+  FreeCount = 0;
+  for (Index = MAX (FirstCluster, FAT_MIN_CLUSTER); Index < EndCluster; Index++) {
+    switch (Volume->FatType) {
+      case Fat12:
+        Free = (BOOLEAN)(FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE);
+        break;
+
+      case Fat16:
+        Free = (BOOLEAN)(((UINT16 *)Entries)[Index - FirstCluster] == FAT_CLUSTER_FREE);
+        break;
+
+      default:
+        Free = (BOOLEAN)((((UINT32 *)Entries)[Index - FirstCluster] & FAT_CLUSTER_MASK_FAT32) == FAT_CLUSTER_FREE);
+    }
+
+    if (Free) {
+      Volume->FreeBitmap[Index / 8] |= (UINT8)(1 << (Index % 8));
+      FreeCount++;
+    }
+  }
+
+  if (Entries != NULL) {
+    FreePool (Entries);
+  }
+
+  if (Volume->DiskError) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Volume->FreeChunkCount[Chunk] = FreeCount;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Update the free cluster bitmap after the FAT entry of a cluster is changed.
+  Nothing is done if the chunk of the cluster is not loaded.
+
+  @param  Volume                - FAT file system volume.
+  @param  Index                 - The index of the cluster.
+  @param  Free                  - Whether the cluster is now free.
+
+**/
+STATIC
+VOID
+FatMarkFreeCluster (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Index,
+  IN BOOLEAN     Free
+  )
+{
+  UINTN  Chunk;
+  UINT8  Mask;
+
+  if (Volume->FreeBitmap == NULL) {
+    return;
+  }
+
+  Chunk = Index / Volume->FreeChunkClusters;
+  if (Volume->FreeChunkCount[Chunk] == FAT_FREE_CHUNK_NOT_LOADED) {
+    return;
+  }
+
+  Mask = (UINT8)(1 << (Index % 8));
+  if (Free && ((Volume->FreeBitmap[Index / 8] & Mask) == 0)) {
+    Volume->FreeBitmap[Index / 8] |= Mask;
+    Volume->FreeChunkCount[Chunk]++;
+  } else if (!Free && ((Volume->FreeBitmap[Index / 8] & Mask) != 0)) {
+    Volume->FreeBitmap[Index / 8] &= (UINT8) ~Mask;
+    Volume->FreeChunkCount[Chunk]--;
+  }
+}
+
+/**
+
+  Find the first run of free clusters of the requested length in the free
+  cluster bitmap, loading the chunks of the bitmap as they are reached.
+  A run that has started within Limit clusters from Start is followed to its end.
+
+  @param  Volume                - FAT file system volume.
+  @param  Start                 - The cluster to start looking from.
+  @param  Count                 - The number of free clusters of the run.
+  @param  Limit                 - The number of clusters to look at.
+  @param  RunStart              - The first cluster of the run found, or the
+                                  cluster where the search stopped if there is none.
+
+  @retval EFI_SUCCESS           - A run of free clusters is found.
+  @retval EFI_NOT_FOUND         - There is no such run within Limit clusters from Start.
+  @return other                 - An error occurred when loading the free cluster bitmap.
+
+**/
+STATIC
+EFI_STATUS
+FatFindFreeRun (
+  IN  FAT_VOLUME  *Volume,
+  IN  UINTN       Start,
+  IN  UINTN       Count,
+  IN  UINTN       Limit,
+  OUT UINTN       *RunStart
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Cluster;
+  UINTN       Chunk;
+  UINTN       RunLength;
+
+  RunLength = 0;
+  Cluster   = Start;
+  while (Cluster <= Volume->MaxCluster + 1) {
+    if ((Cluster - Start >= Limit) && (RunLength == 0)) {
+      break;
+    }
+
+    Chunk  = Cluster / Volume->FreeChunkClusters;
+    Status = FatLoadFreeChunk (Volume, Chunk);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    //
+    // Skip the chunks and the bytes of the bitmap without free clusters
+    //
+    if (Volume->FreeChunkCount[Chunk] == 0) {
+      RunLength = 0;
+      Cluster   = (Chunk + 1) * Volume->FreeChunkClusters;
+      continue;
+    }
+
+    if (((Cluster % 8) == 0) && (Volume->FreeBitmap[Cluster / 8] == 0)) {
+      RunLength = 0;
+      Cluster  += 8;
+      continue;
+    }
+
+    if ((Volume->FreeBitmap[Cluster / 8] & (1 << (Cluster % 8))) != 0) {
+      RunLength++;
+      if (RunLength == Count) {
+        *RunStart = Cluster + 1 - Count;
+        return EFI_SUCCESS;
+      }
+    } else {
+      RunLength = 0;
+    }
+
+    Cluster++;
+  }
+
+  *RunStart = Cluster;
+  return EFI_NOT_FOUND;
+}
+
 /**
 
   Set the FAT entry value of the volume, which is identified with the Index.
@@ -161,10 +423,14 @@ FatSetFatEntry (
     if (Index < Volume->FatInfoSector.FreeInfo.NextCluster) {
       Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)Index;
     }
+
+    FatMarkFreeCluster (Volume, Index, TRUE);
   } else if ((Value != FAT_CLUSTER_FREE) && (OriginalVal == FAT_CLUSTER_FREE)) {
     if (Volume->FatInfoSector.FreeInfo.ClusterCount != 0) {
       Volume->FatInfoSector.FreeInfo.ClusterCount -= 1;
     }
+
+    FatMarkFreeCluster (Volume, Index, FALSE);
   }
 
   //
@@ -274,7 +540,8 @@ FatAllocateCluster (
   IN FAT_VOLUME  *Volume
   )
 {
-  UINTN  Cluster;
+  EFI_STATUS  Status;
+  UINTN       Cluster;
 
   //
   // Start looking at FatFreePos for the next unallocated cluster
@@ -283,6 +550,26 @@ FatAllocateCluster (
     return (UINTN)FAT_CLUSTER_LAST;
   }
 
+  //
+  // Look the free cluster up in the free cluster bitmap, from FatFreePos and
+  // then from the beginning of the volume. Scan the FAT entries if the bitmap
+  // can't be used.
+  //
+  if (FatInitFreeBitmap (Volume)) {
+    Status = FatFindFreeRun (Volume, Volume->FatInfoSector.FreeInfo.NextCluster, 1, MAX_UINTN, &Cluster);
+    if (Status == EFI_NOT_FOUND) {
+      Status = FatFindFreeRun (Volume, FAT_MIN_CLUSTER, 1, MAX_UINTN, &Cluster);
+      if (Status == EFI_NOT_FOUND) {
+        return (UINTN)FAT_CLUSTER_LAST;
+      }
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)(Cluster + 1);
+      return Cluster;
+    }
+  }
+
   for ( ; ;) {
     //
     // If the end of the list, return no available cluster
@@ -314,6 +601,70 @@ FatAllocateCluster (
   return Cluster;
 }
 
+/**
+
+  Point FatFreePos at a run of free clusters large enough to hold the requested
+  number of clusters, so that FatAllocateCluster allocates them contiguously.
+  The run is looked up from the cluster following LastCluster first, so that a
+  file keeps growing in place, then from where the previous search stopped.
+  Each search looks at no more than FAT_FREE_RUN_SEARCH_LIMIT clusters. If no
+  run is found, FatFreePos is left unchanged and the clusters are allocated
+  first fit.
+
+  @param  Volume                - FAT file system volume.
+  @param  LastCluster           - The last cluster of the file, or FAT_CLUSTER_FREE.
+  @param  Count                 - The number of clusters to allocate.
+
+**/
+STATIC
+VOID
+FatSeekFreeRun (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       LastCluster,
+  IN UINTN       Count
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Start;
+  UINTN       Cluster;
+
+  if (Volume->DiskError || !FatInitFreeBitmap (Volume)) {
+    return;
+  }
+
+  if (Volume->FreeInfoValid && (Volume->FatInfoSector.FreeInfo.ClusterCount < Count)) {
+    return;
+  }
+
+  Start = Volume->FatInfoSector.FreeInfo.NextCluster;
+  if (LastCluster != FAT_CLUSTER_FREE) {
+    Start = LastCluster + 1;
+  }
+
+  Status = FatFindFreeRun (Volume, Start, Count, FAT_FREE_RUN_SEARCH_LIMIT, &Cluster);
+  if (Status == EFI_NOT_FOUND) {
+    //
+    // Go on from where the previous search stopped, so that the successive
+    // searches on a fragmented volume look at different parts of the bitmap
+    //
+    Start = Volume->FreeRunHint;
+    if ((Start < FAT_MIN_CLUSTER) || (Start > Volume->MaxCluster + 1)) {
+      Start = FAT_MIN_CLUSTER;
+    }
+
+    Status = FatFindFreeRun (Volume, Start, Count, FAT_FREE_RUN_SEARCH_LIMIT, &Cluster);
+    if (Status == EFI_NOT_FOUND) {
+      Volume->FreeRunHint = Cluster;
+    } else if (!EFI_ERROR (Status)) {
+      Volume->FreeRunHint = Cluster + Count;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)Cluster;
+  }
+}
+
 /**
 
   Count the number of clusters given a size.
@@ -406,6 +757,7 @@ FatShrinkEof (
   OFile->FileCurrentCluster = OFile->FileCluster;
   OFile->FileLastCluster    = LastCluster;
   OFile->Dirty              = TRUE;
+  FatResetExtents (OFile);
   //
   // Free the remaining cluster chain
   //
@@ -416,6 +768,12 @@ FatShrinkEof (
 
   Grow the end of the open file base on the NewSizeInBytes.
 
+  The clusters are assigned when the file grows, not when the volume is
+  written back, because Write() places the data at its position on the disk
+  or in the data cache, which is addressed by disk position. The new clusters
+  are taken as one contiguous run where possible, and the FAT updates stay in
+  the FAT cache until the volume is written back.
+
   @param  OFile                 - The open file.
   @param  NewSizeInBytes        - The new size in bytes of the open file.
 
@@ -439,6 +797,7 @@ FatGrowEof (
   UINTN       LastCluster;
   UINTN       NewCluster;
   UINTN       ClusterCount;
+  FAT_EXTENT  *Extent;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -492,6 +851,7 @@ FatGrowEof (
     // Loop until we've allocated enough space
     //
     LastCluster = OFile->FileLastCluster;
+    FatSeekFreeRun (Volume, LastCluster, NewSize - CurSize);
 
     while (CurSize < NewSize) {
       NewCluster = FatAllocateCluster (Volume);
@@ -512,6 +872,16 @@ FatGrowEof (
 
       if (LastCluster != 0) {
         FatSetFatEntry (Volume, LastCluster, NewCluster);
+        //
+        // If the extent map reaches the end of the file, it now continues
+        // with the new cluster
+        //
+        if (OFile->ExtentCount != 0) {
+          Extent = &OFile->Extents[OFile->ExtentCount - 1];
+          if (LastCluster == Extent->Cluster + Extent->Count - 1) {
+            OFile->ExtentNext = NewCluster;
+          }
+        }
       } else {
         OFile->FileCluster        = NewCluster;
         OFile->FileCurrentCluster = NewCluster;
@@ -545,6 +915,136 @@ Done:
   return Status;
 }
 
+/**
+
+  Discard the extent map of the open file, after its cluster chain is changed.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatResetExtents (
+  IN FAT_OFILE  *OFile
+  )
+{
+  OFile->ExtentCount    = 0;
+  OFile->ExtentClusters = 0;
+  OFile->ExtentNext     = FAT_CLUSTER_FREE;
+}
+
+/**
+
+  Run the cluster chain of the open file from the end of its extent map,
+  until the extent map covers the requested number of clusters.
+
+  @param  OFile                 - The open file.
+  @param  ClusterCount          - The number of clusters from the beginning of the
+                                  file that the extent map must cover.
+
+  @retval EFI_SUCCESS           - The extent map covers ClusterCount clusters.
+  @retval EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  @retval EFI_OUT_OF_RESOURCES  - Can not allocate memory for the extent map.
+
+**/
+STATIC
+EFI_STATUS
+FatMapClusters (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      ClusterCount
+  )
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *NewExtents;
+  UINTN       Cluster;
+  UINTN       NewMax;
+
+  Volume = OFile->Volume;
+
+  while (OFile->ExtentClusters < ClusterCount) {
+    if (OFile->ExtentCount == 0) {
+      Cluster = OFile->FileCluster;
+      Extent  = NULL;
+    } else {
+      Cluster = OFile->ExtentNext;
+      Extent  = &OFile->Extents[OFile->ExtentCount - 1];
+    }
+
+    if ((Cluster < FAT_MIN_CLUSTER) || (Cluster > Volume->MaxCluster + 1)) {
+      DEBUG ((DEBUG_INIT | DEBUG_ERROR, "FatMapClusters: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    if ((Extent != NULL) && (Cluster == Extent->Cluster + Extent->Count)) {
+      Extent->Count++;
+    } else {
+      if (OFile->ExtentCount == OFile->ExtentMax) {
+        NewMax     = MAX (OFile->ExtentMax * 2, FAT_MIN_EXTENT_COUNT);
+        NewExtents = ReallocatePool (
+                       OFile->ExtentMax * sizeof (FAT_EXTENT),
+                       NewMax * sizeof (FAT_EXTENT),
+                       OFile->Extents
+                       );
+        if (NewExtents == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+
+        OFile->Extents   = NewExtents;
+        OFile->ExtentMax = NewMax;
+      }
+
+      Extent              = &OFile->Extents[OFile->ExtentCount];
+      Extent->FileCluster = OFile->ExtentClusters;
+      Extent->Cluster     = Cluster;
+      Extent->Count       = 1;
+      OFile->ExtentCount++;
+    }
+
+    OFile->ExtentClusters++;
+    OFile->ExtentNext = FatGetFatEntry (Volume, Cluster);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Find the extent of the open file which contains a cluster.
+
+  @param  OFile                 - The open file.
+  @param  ClusterIndex          - The index of the cluster within the file, which
+                                  must be covered by the extent map.
+
+  @return The index of the extent in the extent map.
+
+**/
+STATIC
+UINTN
+FatFindExtent (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      ClusterIndex
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  ASSERT (ClusterIndex < OFile->ExtentClusters);
+
+  Low  = 0;
+  High = OFile->ExtentCount - 1;
+  while (Low < High) {
+    Middle = (Low + High + 1) / 2;
+    if (OFile->Extents[Middle].FileCluster <= ClusterIndex) {
+      Low = Middle;
+    } else {
+      High = Middle - 1;
+    }
+  }
+
+  return Low;
+}
+
 /**
 
   Seek OFile to requested position, and calculate the number of
@@ -566,10 +1066,14 @@ FatOFilePosition (
   )
 {
   FAT_VOLUME  *Volume;
+  EFI_STATUS  Status;
   UINTN       ClusterSize;
+  UINTN       ClusterIndex;
   UINTN       Cluster;
   UINTN       StartPos;
   UINTN       Run;
+  UINTN       Index;
+  FAT_EXTENT  *Extent;
 
   Volume      = OFile->Volume;
   ClusterSize = Volume->ClusterSize;
@@ -585,37 +1089,26 @@ FatOFilePosition (
     Run            = OFile->FileSize - Position;
   } else {
     //
-    // Run the file's cluster chain to find the current position
-    // If possible, run from the current cluster rather than
-    // start from beginning
-    // Assumption: OFile->Position is always consistent with
-    // OFile->FileCurrentCluster.
-    // OFile->Position is not modified outside this function;
-    // OFile->FileCurrentCluster is modified outside this function
-    // to be the same as OFile->FileCluster
-    // when OFile->FileCluster is updated, so make a check of this
-    // and invalidate the original OFile->Position in this case
+    // The extent map is only valid for the cluster chain it was built from
     //
-    Cluster  = OFile->FileCurrentCluster;
-    StartPos = OFile->Position;
-    if ((Position < StartPos) || (OFile->FileCluster == Cluster)) {
-      StartPos = 0;
-      Cluster  = OFile->FileCluster;
+    if ((OFile->ExtentCount != 0) && (OFile->Extents[0].Cluster != OFile->FileCluster)) {
+      FatResetExtents (OFile);
     }
 
-    while (StartPos + ClusterSize <= Position) {
-      StartPos += ClusterSize;
-      if ((Cluster == FAT_CLUSTER_FREE) || (Cluster >= FAT_CLUSTER_SPECIAL)) {
-        DEBUG ((DEBUG_INIT | DEBUG_ERROR, "FatOFilePosition:" " cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      Cluster = FatGetFatEntry (Volume, Cluster);
+    //
+    // Look up the cluster of the position in the extent map, running the
+    // file's cluster chain only as far as it has not been mapped yet
+    //
+    ClusterIndex = Position >> Volume->ClusterAlignment;
+    Status       = FatMapClusters (OFile, ClusterIndex + 1);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
 
-    if ((Cluster < FAT_MIN_CLUSTER) || (Cluster > Volume->MaxCluster + 1)) {
-      return EFI_VOLUME_CORRUPTED;
-    }
+    Index    = FatFindExtent (OFile, ClusterIndex);
+    Extent   = &OFile->Extents[Index];
+    Cluster  = Extent->Cluster + ClusterIndex - Extent->FileCluster;
+    StartPos = ClusterIndex << Volume->ClusterAlignment;
 
     OFile->PosDisk = Volume->FirstClusterPos +
                      LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
@@ -624,14 +1117,20 @@ FatOFilePosition (
     OFile->Position           = StartPos;
 
     //
-    // Compute the number of consecutive clusters in the file
+    // Compute the number of consecutive clusters in the file. The last
+    // extent is extended while the chain stays contiguous and the run is
+    // shorter than PosLimit.
     //
-    Run = StartPos + ClusterSize - Position;
-    if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-      while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && Run < PosLimit) {
-        Run     += ClusterSize;
-        Cluster += 1;
+    Run = ((Extent->FileCluster + Extent->Count - ClusterIndex) << Volume->ClusterAlignment) - (Position - StartPos);
+    while ((Index == OFile->ExtentCount - 1) && (Run < PosLimit) &&
+           (OFile->ExtentNext == Extent->Cluster + Extent->Count))
+    {
+      Status = FatMapClusters (OFile, OFile->ExtentClusters + 1);
+      if (EFI_ERROR (Status)) {
+        return Status;
       }
+
+      Run += ClusterSize;
     }
   }
 
@@ -722,6 +1221,8 @@ FatComputeFreeInfo (
   )
 {
   UINTN  Index;
+  UINTN  ChunkCount;
+  UINTN  Cluster;
 
   //
   // If we don't have valid info, compute it now
@@ -729,6 +1230,37 @@ FatComputeFreeInfo (
   if (!Volume->FreeInfoValid) {
     Volume->FreeInfoValid                       = TRUE;
     Volume->FatInfoSector.FreeInfo.ClusterCount = 0;
+    Volume->FatInfoSector.Signature             = FAT_INFO_SIGNATURE;
+    Volume->FatInfoSector.InfoBeginSignature    = FAT_INFO_BEGIN_SIGNATURE;
+    Volume->FatInfoSector.InfoEndSignature      = FAT_INFO_END_SIGNATURE;
+
+    //
+    // Sum up the free clusters of the free cluster bitmap, loading all its chunks
+    //
+    if (FatInitFreeBitmap (Volume)) {
+      ChunkCount = (Volume->MaxCluster + 1) / Volume->FreeChunkClusters + 1;
+      for (Index = 0; Index < ChunkCount; Index++) {
+        if (EFI_ERROR (FatLoadFreeChunk (Volume, Index))) {
+          break;
+        }
+
+        Volume->FatInfoSector.FreeInfo.ClusterCount += Volume->FreeChunkCount[Index];
+      }
+
+      if (Index == ChunkCount) {
+        if (!EFI_ERROR (FatFindFreeRun (Volume, FAT_MIN_CLUSTER, 1, MAX_UINTN, &Cluster))) {
+          Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)Cluster;
+        }
+
+        return;
+      }
+
+      Volume->FatInfoSector.FreeInfo.ClusterCount = 0;
+    }
+
+    //
+    // The free cluster bitmap can't be used, scan the FAT entries
+    //
     for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
       if (Volume->DiskError) {
         break;
@@ -739,9 +1271,5 @@ FatComputeFreeInfo (
         Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32)Index;
       }
     }
-
-    Volume->FatInfoSector.Signature          = FAT_INFO_SIGNATURE;
-    Volume->FatInfoSector.InfoBeginSignature = FAT_INFO_BEGIN_SIGNATURE;
-    Volume->FatInfoSector.InfoEndSignature   = FAT_INFO_END_SIGNATURE;
   }
 }
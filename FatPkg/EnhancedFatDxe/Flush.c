@@ -81,6 +81,13 @@ FatFlushEx (
   FatAcquireLock ();
   Status = FatOFileFlush (OFile);
   Status = FatCleanupVolume (OFile->Volume, OFile, Status, Task);
+  if (!EFI_ERROR (Status) && Volume->WriteBackPending) {
+    //
+    // Flush() writes back what the previous operations deferred
+    //
+    Status = FatFlushVolume (Volume, Task);
+  }
+
   FatReleaseLock ();
 
   if (Token != NULL) {
@@ -362,6 +369,167 @@ FatCheckVolumeRef (
   }
 }
 
+/**
+
+  Write back the free cluster info, clear the dirty value of the volume and
+  flush the disk cache, including the write back deferred by previous operations.
+
+  @param  Volume                - FAT file system volume.
+  @param  Task                    point to task instance.
+
+  @retval EFI_SUCCESS           - The volume is written back successfully.
+  @return Others                - An error occurred when writing to the disk.
+
+**/
+EFI_STATUS
+FatFlushVolume (
+  IN FAT_VOLUME  *Volume,
+  IN FAT_TASK    *Task
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Update the free hint info. Volume->FreeInfoPos != 0
+  // indicates this a FAT32 volume
+  //
+  if (Volume->FreeInfoValid && Volume->FatDirty && Volume->FreeInfoPos) {
+    Status = FatDiskIo (Volume, WriteDisk, Volume->FreeInfoPos, sizeof (FAT_INFO_SECTOR), &Volume->FatInfoSector, Task);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Update that the volume is not dirty
+  //
+  if (Volume->FatDirty && (Volume->FatType != Fat12)) {
+    Volume->FatDirty = FALSE;
+    Status           = FatAccessVolumeDirty (Volume, WriteFat, &Volume->NotDirtyValue);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Flush all dirty cache entries to disk
+  //
+  Status = FatVolumeFlushCache (Volume, Task);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Volume->WriteBackPending) {
+    gBS->SetTimer (Volume->WriteBackEvent, TimerCancel, 0);
+    Volume->WriteBackPending = FALSE;
+  }
+
+  Volume->DirtyOnDisk = FALSE;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Defer the write back of the volume after an operation, so that the FAT and
+  directory updates of the following operations are written back together.
+  The dirty value of the volume is written to the disk first, so that the
+  volume is seen as dirty if it is not written back.
+
+  @param  Volume                - FAT file system volume.
+
+  @retval EFI_SUCCESS           - The write back is deferred.
+  @return Others                - An error occurred when writing the dirty value.
+
+**/
+STATIC
+EFI_STATUS
+FatDeferWriteBack (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  EFI_STATUS  Status;
+
+  if (!Volume->FatDirty &&
+      !Volume->DiskCache[CacheFat].Dirty &&
+      !Volume->DiskCache[CacheData].Dirty)
+  {
+    return EFI_SUCCESS;
+  }
+
+  if (Volume->FatDirty && !Volume->DirtyOnDisk && (Volume->FatType != Fat12)) {
+    Status = FatAccessVolumeDirty (Volume, WriteDisk, &Volume->DirtyValue);
+    if (!EFI_ERROR (Status)) {
+      Status = Volume->BlockIo->FlushBlocks (Volume->BlockIo);
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Volume->DirtyOnDisk = TRUE;
+  }
+
+  if (!Volume->WriteBackPending) {
+    Status = gBS->SetTimer (
+                    Volume->WriteBackEvent,
+                    TimerRelative,
+                    MultU64x32 (Volume->WriteBackDelay, 10000)
+                    );
+    if (EFI_ERROR (Status)) {
+      return FatFlushVolume (Volume, NULL);
+    }
+
+    Volume->WriteBackPending = TRUE;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Write back the volume when its deferred write back is due, or before
+  ExitBootServices().
+
+  @param  Event                 - The timer event or the before ExitBootServices() event.
+  @param  Context               - The volume.
+
+**/
+VOID
+EFIAPI
+FatWriteBackNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  FAT_VOLUME  *Volume;
+  EFI_STATUS  Status;
+
+  Volume = Context;
+  if (EFI_ERROR (FatAcquireLockOrFail ())) {
+    //
+    // A file system operation is in progress, try again later
+    //
+    if (Volume->WriteBackPending) {
+      gBS->SetTimer (Volume->WriteBackEvent, TimerRelative, MultU64x32 (Volume->WriteBackDelay, 10000));
+    }
+
+    return;
+  }
+
+  if (Volume->Valid && Volume->WriteBackPending) {
+    //
+    // The next operation defers the write back again if this one fails
+    //
+    Volume->WriteBackPending = FALSE;
+    Status                   = FatFlushVolume (Volume, NULL);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "FatWriteBackNotify: write back failed %r\n", Status));
+    }
+  }
+
+  FatReleaseLock ();
+}
+
 /**
 
   Set error status for a specific OFile, reference checking the volume.
@@ -402,32 +570,12 @@ FatCleanupVolume (
   //
   FatCheckVolumeRef (Volume);
   if (Volume->Valid) {
-    //
-    // Update the free hint info. Volume->FreeInfoPos != 0
-    // indicates this a FAT32 volume
-    //
-    if (Volume->FreeInfoValid && Volume->FatDirty && Volume->FreeInfoPos) {
-      Status = FatDiskIo (Volume, WriteDisk, Volume->FreeInfoPos, sizeof (FAT_INFO_SECTOR), &Volume->FatInfoSector, Task);
-      if (EFI_ERROR (Status)) {
-        return Status;
-      }
-    }
-
-    //
-    // Update that the volume is not dirty
-    //
-    if (Volume->FatDirty && (Volume->FatType != Fat12)) {
-      Volume->FatDirty = FALSE;
-      Status           = FatAccessVolumeDirty (Volume, WriteFat, &Volume->NotDirtyValue);
-      if (EFI_ERROR (Status)) {
-        return Status;
-      }
+    if (Volume->WriteBackDelay != 0) {
+      Status = FatDeferWriteBack (Volume);
+    } else {
+      Status = FatFlushVolume (Volume, Task);
     }
 
-    //
-    // Flush all dirty cache entries to disk
-    //
-    Status = FatVolumeFlushCache (Volume, Task);
     if (EFI_ERROR (Status)) {
       return Status;
     }
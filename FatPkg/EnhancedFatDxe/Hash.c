@@ -34,7 +34,7 @@ FatHashLongName (
     );
   FatStrUpr (UpCasedLongFileName);
   gBS->CalculateCrc32 (UpCasedLongFileName, StrSize (UpCasedLongFileName), &HashValue);
-  return (HashValue & HASH_TABLE_MASK);
+  return HashValue;
 }
 
 /**
@@ -55,7 +55,141 @@ FatHashShortName (
   UINT32  HashValue;
 
   gBS->CalculateCrc32 (ShortNameString, FAT_NAME_LEN, &HashValue);
-  return (HashValue & HASH_TABLE_MASK);
+  return HashValue;
+}
+
+/**
+
+  Allocate the hash tables of a directory with TableSize buckets each.
+
+  @param  TableSize             - The number of buckets of each hash table.
+  @param  LongNameHashTable     - The allocated long name hash table.
+  @param  ShortNameHashTable    - The allocated short name hash table.
+
+  @retval EFI_SUCCESS           - The hash tables are allocated.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to allocate the hash tables.
+
+**/
+STATIC
+EFI_STATUS
+FatAllocateHashTables (
+  IN  UINTN       TableSize,
+  OUT FAT_DIRENT  ***LongNameHashTable,
+  OUT FAT_DIRENT  ***ShortNameHashTable
+  )
+{
+  *LongNameHashTable  = AllocateZeroPool (TableSize * sizeof (FAT_DIRENT *));
+  *ShortNameHashTable = AllocateZeroPool (TableSize * sizeof (FAT_DIRENT *));
+  if ((*LongNameHashTable == NULL) || (*ShortNameHashTable == NULL)) {
+    if (*LongNameHashTable != NULL) {
+      FreePool (*LongNameHashTable);
+    }
+
+    if (*ShortNameHashTable != NULL) {
+      FreePool (*ShortNameHashTable);
+    }
+
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Double the hash tables of the directory and move the directory entries
+  to the new hash tables. The directory keeps its hash tables if the new
+  ones can not be allocated.
+
+  @param  ODir                  - The directory whose hash tables grow.
+
+**/
+STATIC
+VOID
+FatGrowHashTable (
+  IN FAT_ODIR  *ODir
+  )
+{
+  FAT_DIRENT  **LongNameHashTable;
+  FAT_DIRENT  **ShortNameHashTable;
+  FAT_DIRENT  *DirEnt;
+  UINTN       TableSize;
+  UINTN       Index;
+  UINT32      HashTableIndex;
+
+  TableSize = ODir->HashTableSize * 2;
+  if (EFI_ERROR (FatAllocateHashTables (TableSize, &LongNameHashTable, &ShortNameHashTable))) {
+    return;
+  }
+
+  for (Index = 0; Index < ODir->HashTableSize; Index++) {
+    while (ODir->ShortNameHashTable[Index] != NULL) {
+      DirEnt                             = ODir->ShortNameHashTable[Index];
+      ODir->ShortNameHashTable[Index]    = DirEnt->ShortNameForwardLink;
+      HashTableIndex                     = FatHashShortName (DirEnt->Entry.FileName) & (UINT32)(TableSize - 1);
+      DirEnt->ShortNameForwardLink       = ShortNameHashTable[HashTableIndex];
+      ShortNameHashTable[HashTableIndex] = DirEnt;
+    }
+
+    while (ODir->LongNameHashTable[Index] != NULL) {
+      DirEnt                            = ODir->LongNameHashTable[Index];
+      ODir->LongNameHashTable[Index]    = DirEnt->LongNameForwardLink;
+      HashTableIndex                    = FatHashLongName (DirEnt->FileString) & (UINT32)(TableSize - 1);
+      DirEnt->LongNameForwardLink       = LongNameHashTable[HashTableIndex];
+      LongNameHashTable[HashTableIndex] = DirEnt;
+    }
+  }
+
+  FreePool (ODir->LongNameHashTable);
+  FreePool (ODir->ShortNameHashTable);
+  ODir->MemorySize        += ODir->HashTableSize * 2 * sizeof (FAT_DIRENT *);
+  ODir->HashTableSize      = TableSize;
+  ODir->LongNameHashTable  = LongNameHashTable;
+  ODir->ShortNameHashTable = ShortNameHashTable;
+}
+
+/**
+
+  Allocate the initial hash tables of a newly allocated directory.
+
+  @param  ODir                  - The directory.
+
+  @retval EFI_SUCCESS           - The hash tables are allocated.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to allocate the hash tables.
+
+**/
+EFI_STATUS
+FatInitializeHashTable (
+  IN FAT_ODIR  *ODir
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = FatAllocateHashTables (HASH_TABLE_MIN_SIZE, &ODir->LongNameHashTable, &ODir->ShortNameHashTable);
+  if (!EFI_ERROR (Status)) {
+    ODir->HashTableSize = HASH_TABLE_MIN_SIZE;
+    ODir->MemorySize   += HASH_TABLE_MIN_SIZE * 2 * sizeof (FAT_DIRENT *);
+  }
+
+  return Status;
+}
+
+/**
+
+  Free the hash tables of a directory.
+
+  @param  ODir                  - The directory.
+
+**/
+VOID
+FatFreeHashTable (
+  IN FAT_ODIR  *ODir
+  )
+{
+  if (ODir->LongNameHashTable != NULL) {
+    FreePool (ODir->LongNameHashTable);
+    FreePool (ODir->ShortNameHashTable);
+  }
 }
 
 /**
@@ -76,7 +210,7 @@ FatLongNameHashSearch (
 {
   FAT_DIRENT  **PreviousHashNode;
 
-  for (PreviousHashNode   = &ODir->LongNameHashTable[FatHashLongName (LongNameString)];
+  for (PreviousHashNode   = &ODir->LongNameHashTable[FatHashLongName (LongNameString) & (ODir->HashTableSize - 1)];
        *PreviousHashNode != NULL;
        PreviousHashNode   = &(*PreviousHashNode)->LongNameForwardLink
        )
@@ -107,7 +241,7 @@ FatShortNameHashSearch (
 {
   FAT_DIRENT  **PreviousHashNode;
 
-  for (PreviousHashNode   = &ODir->ShortNameHashTable[FatHashShortName (ShortNameString)];
+  for (PreviousHashNode   = &ODir->ShortNameHashTable[FatHashShortName (ShortNameString) & (ODir->HashTableSize - 1)];
        *PreviousHashNode != NULL;
        PreviousHashNode   = &(*PreviousHashNode)->ShortNameForwardLink
        )
@@ -137,17 +271,26 @@ FatInsertToHashTable (
   FAT_DIRENT  **HashTable;
   UINT32      HashTableIndex;
 
+  //
+  // Keep the chains short in large directories
+  //
+  if ((ODir->HashEntryCount >= ODir->HashTableSize * 2) && (ODir->HashTableSize < HASH_TABLE_MAX_SIZE)) {
+    FatGrowHashTable (ODir);
+  }
+
+  ODir->HashEntryCount++;
+  ODir->MemorySize += sizeof (FAT_DIRENT) + StrSize (DirEnt->FileString);
   //
   // Insert hash table index for short name
   //
-  HashTableIndex               = FatHashShortName (DirEnt->Entry.FileName);
+  HashTableIndex               = FatHashShortName (DirEnt->Entry.FileName) & (UINT32)(ODir->HashTableSize - 1);
   HashTable                    = ODir->ShortNameHashTable;
   DirEnt->ShortNameForwardLink = HashTable[HashTableIndex];
   HashTable[HashTableIndex]    = DirEnt;
   //
   // Insert hash table index for long name
   //
-  HashTableIndex              = FatHashLongName (DirEnt->FileString);
+  HashTableIndex              = FatHashLongName (DirEnt->FileString) & (UINT32)(ODir->HashTableSize - 1);
   HashTable                   = ODir->LongNameHashTable;
   DirEnt->LongNameForwardLink = HashTable[HashTableIndex];
   HashTable[HashTableIndex]   = DirEnt;
@@ -169,4 +312,6 @@ FatDeleteFromHashTable (
 {
   *FatShortNameHashSearch (ODir, DirEnt->Entry.FileName) = DirEnt->ShortNameForwardLink;
   *FatLongNameHashSearch (ODir, DirEnt->FileString)      = DirEnt->LongNameForwardLink;
+  ODir->HashEntryCount--;
+  ODir->MemorySize -= sizeof (FAT_DIRENT) + StrSize (DirEnt->FileString);
 }
@@ -103,6 +103,36 @@ FatAllocateVolume (
     goto Done;
   }
 
+  //
+  // Defer the write back of the volume if the platform allows it, and write
+  // it back before the OS takes over the disk
+  //
+  if ((PcdGet32 (PcdFatWriteBackDelay) != 0) && !Volume->ReadOnly) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    FatWriteBackNotify,
+                    Volume,
+                    &Volume->WriteBackEvent
+                    );
+    if (!EFI_ERROR (Status)) {
+      Status = gBS->CreateEventEx (
+                      EVT_NOTIFY_SIGNAL,
+                      TPL_CALLBACK,
+                      FatWriteBackNotify,
+                      Volume,
+                      &gEfiEventBeforeExitBootServicesGuid,
+                      &Volume->ExitBootServicesEvent
+                      );
+    }
+
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+
+    Volume->WriteBackDelay = PcdGet32 (PcdFatWriteBackDelay);
+  }
+
   //
   // Install our protocol interfaces on the device's handle
   //
@@ -188,6 +218,13 @@ FatAbandonVolume (
       );
   }
 
+  //
+  // Write back what the previous operations deferred, unless the media changed
+  //
+  if (LockedByMe && Volume->WriteBackPending) {
+    FatFlushVolume (Volume, NULL);
+  }
+
   Volume->Valid = FALSE;
 
   //
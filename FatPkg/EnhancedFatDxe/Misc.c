@@ -464,8 +464,25 @@ FatFreeVolume (
   //
   // Free disk cache
   //
-  if (Volume->CacheBuffer != NULL) {
-    FreePool (Volume->CacheBuffer);
+  FatFreeDiskCache (Volume);
+
+  //
+  // Free the free cluster bitmap
+  //
+  if (Volume->FreeBitmap != NULL) {
+    FreePool (Volume->FreeBitmap);
+    FreePool (Volume->FreeChunkCount);
+  }
+
+  //
+  // Close the deferred write back events
+  //
+  if (Volume->WriteBackEvent != NULL) {
+    gBS->CloseEvent (Volume->WriteBackEvent);
+  }
+
+  if (Volume->ExitBootServicesEvent != NULL) {
+    gBS->CloseEvent (Volume->ExitBootServicesEvent);
   }
 
   //
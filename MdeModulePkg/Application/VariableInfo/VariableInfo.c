@@ -66,6 +66,61 @@ GetVariableStatisticsData (
   return Status;
 }
 
+/**
+  This function gets and prints the runtime variable cache statistics from the SMM variable driver.
+
+  @param[in] CommBuffer     The SMM communication buffer.
+  @param[in] CommBufferSize The size of CommBuffer.
+
+**/
+VOID
+PrintRuntimeCacheStatisticsFromSmm (
+  IN EFI_MM_COMMUNICATE_HEADER  *CommBuffer,
+  IN UINTN                      CommBufferSize
+  )
+{
+  EFI_STATUS                                             Status;
+  UINTN                                                  CommSize;
+  SMM_VARIABLE_COMMUNICATE_HEADER                        *FunctionHeader;
+  SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS  *Statistics;
+
+  CommSize = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + sizeof (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS);
+  if (CommSize > CommBufferSize) {
+    return;
+  }
+
+  ZeroMem (CommBuffer, CommSize);
+  CopyGuid (&CommBuffer->HeaderGuid, &gEfiSmmVariableProtocolGuid);
+  CommBuffer->MessageLength = CommSize - OFFSET_OF (EFI_MM_COMMUNICATE_HEADER, Data);
+
+  FunctionHeader           = (SMM_VARIABLE_COMMUNICATE_HEADER *)&CommBuffer->Data[0];
+  FunctionHeader->Function = SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_STATISTICS;
+
+  Status = mMmCommunication2->Communicate (
+                                mMmCommunication2,
+                                CommBuffer,
+                                CommBuffer,
+                                &CommSize
+                                );
+  if (EFI_ERROR (Status) || EFI_ERROR (FunctionHeader->ReturnStatus)) {
+    return;
+  }
+
+  Statistics = (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS *)FunctionHeader->Data;
+  Print (L"SMM Driver Runtime Variable Cache:\n");
+  Print (
+    L"  Updates: %ld by delta, %ld by full store\n",
+    Statistics->DeltaUpdateCount,
+    Statistics->FullUpdateCount
+    );
+  Print (
+    L"  Flushes: %ld, 0x%lx bytes copied in total, 0x%lx bytes by the last one\n",
+    Statistics->FlushCount,
+    Statistics->TotalBytesSynchronized,
+    Statistics->LastBytesSynchronized
+    );
+}
+
 /**
 
   This function get and print the variable statistics data from SMM variable driver.
@@ -193,6 +248,8 @@ PrintInfoFromSmm (
     }
   } while (TRUE);
 
+  PrintRuntimeCacheStatisticsFromSmm (CommBuffer, RealCommSize);
+
   return Status;
 }
 
@@ -2513,6 +2513,780 @@ AhciReadLogExt (
            );
 }
 
+/**
+  Allocate the native command queuing resources of specific port if both the
+  AHCI controller and the attached device support native command queuing.
+
+  @param  PciIo               The PCI IO protocol instance.
+  @param  AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port                The number of port.
+  @param  IdentifyData        A pointer to data buffer which is used to contain IDENTIFY data.
+
+  @retval EFI_SUCCESS           Native command queuing is enabled on the port.
+  @retval EFI_UNSUPPORTED       The controller or the device doesn't support native command queuing.
+  @retval EFI_OUT_OF_RESOURCES  The command list or command tables can not be allocated.
+  @retval EFI_DEVICE_ERROR      The buffers are not reachable by the controller.
+**/
+EFI_STATUS
+AhciNcqCreatePort (
+  IN EFI_PCI_IO_PROTOCOL  *PciIo,
+  IN EFI_AHCI_REGISTERS   *AhciRegisters,
+  IN UINT8                Port,
+  IN EFI_IDENTIFY_DATA    *IdentifyData
+  )
+{
+  EFI_STATUS             Status;
+  UINT32                 Capability;
+  UINT16                 SataCapabilities;
+  UINT32                 Depth;
+  UINTN                  Bytes;
+  UINTN                  MapLength;
+  VOID                   *Buffer;
+  EFI_AHCI_NCQ_PORT      *Ncq;
+  EFI_PHYSICAL_ADDRESS   PciAddr;
+  EFI_PHYSICAL_ADDRESS   TablePciAddr;
+  DATA_64                Data64;
+  UINT32                 Tag;
+
+  if (AhciRegisters->NcqPort[Port] != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Capability = AhciReadReg (PciIo, EFI_AHCI_CAPABILITY_OFFSET);
+  if ((Capability & EFI_AHCI_CAP_SNCQ) == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Word 76 is only valid for SATA devices, in which case it is neither 0000h
+  // nor FFFFh. Bit 8 indicates native command queuing support, and word 75
+  // reports the maximum queue depth minus one.
+  //
+  SataCapabilities = IdentifyData->AtaData.serial_ata_capabilities;
+  if ((SataCapabilities == 0) || (SataCapabilities == 0xFFFF) || ((SataCapabilities & BIT8) == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Depth = MIN (
+            (UINT32)(IdentifyData->AtaData.queue_depth & 0x1F) + 1,
+            ((Capability & 0x1F00) >> 8) + 1
+            );
+
+  Ncq = AllocateZeroPool (sizeof (EFI_AHCI_NCQ_PORT));
+  if (Ncq == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The command list always has room for all 32 slots, followed by one command
+  // table per usable tag. Both need 128 byte alignment at most, which the page
+  // aligned buffer and the table size already provide.
+  //
+  Bytes          = AHCI_NCQ_MAX_TAGS * sizeof (EFI_AHCI_COMMAND_LIST) + Depth * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+  Ncq->PageCount = EFI_SIZE_TO_PAGES (Bytes);
+  Ncq->Depth     = Depth;
+
+  Buffer = NULL;
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    Ncq->PageCount,
+                    &Buffer,
+                    0
+                    );
+  if (EFI_ERROR (Status)) {
+    FreePool (Ncq);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Buffer, Bytes);
+
+  MapLength = Bytes;
+  Status    = PciIo->Map (
+                       PciIo,
+                       EfiPciIoOperationBusMasterCommonBuffer,
+                       Buffer,
+                       &MapLength,
+                       &PciAddr,
+                       &Ncq->Map
+                       );
+  if (EFI_ERROR (Status) || (MapLength != Bytes)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ErrorFree;
+  }
+
+  if (((Capability & EFI_AHCI_CAP_S64A) == 0) && ((PciAddr + Bytes) > 0x100000000ULL)) {
+    //
+    // The AHCI HBA doesn't support 64bit addressing, so should not get a >4G pci bus master address.
+    //
+    Status = EFI_DEVICE_ERROR;
+    goto ErrorUnmap;
+  }
+
+  Ncq->CmdList             = Buffer;
+  Ncq->CommandTable        = (EFI_AHCI_NCQ_COMMAND_TABLE *)((UINTN)Buffer + AHCI_NCQ_MAX_TAGS * sizeof (EFI_AHCI_COMMAND_LIST));
+  Ncq->CmdListPciAddr      = PciAddr;
+  Ncq->CommandTablePciAddr = PciAddr + AHCI_NCQ_MAX_TAGS * sizeof (EFI_AHCI_COMMAND_LIST);
+
+  for (Tag = 0; Tag < Depth; Tag++) {
+    TablePciAddr                   = Ncq->CommandTablePciAddr + Tag * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+    Data64.Uint64                  = TablePciAddr;
+    Ncq->CmdList[Tag].AhciCmdCtba  = Data64.Uint32.Lower32;
+    Ncq->CmdList[Tag].AhciCmdCtbau = Data64.Uint32.Upper32;
+  }
+
+  AhciRegisters->NcqPort[Port] = Ncq;
+
+  DEBUG ((DEBUG_INFO, "AHCI: port [%d] native command queuing enabled, queue depth %d\n", Port, Depth));
+  return EFI_SUCCESS;
+
+ErrorUnmap:
+  PciIo->Unmap (PciIo, Ncq->Map);
+ErrorFree:
+  PciIo->FreeBuffer (PciIo, Ncq->PageCount, Buffer);
+  FreePool (Ncq);
+  return Status;
+}
+
+/**
+  Release the native command queuing resources of specific port.
+
+  @param[in]  PciIo          The PCI IO protocol instance.
+  @param[in]  AhciRegisters  The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  Port           The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqFreePort (
+  IN EFI_PCI_IO_PROTOCOL  *PciIo,
+  IN EFI_AHCI_REGISTERS   *AhciRegisters,
+  IN UINT8                Port
+  )
+{
+  EFI_AHCI_NCQ_PORT  *Ncq;
+
+  Ncq = AhciRegisters->NcqPort[Port];
+  if (Ncq == NULL) {
+    return;
+  }
+
+  ASSERT (Ncq->ActiveTags == 0);
+
+  PciIo->Unmap (PciIo, Ncq->Map);
+  PciIo->FreeBuffer (PciIo, Ncq->PageCount, Ncq->CmdList);
+  FreePool (Ncq);
+  AhciRegisters->NcqPort[Port] = NULL;
+}
+
+/**
+  Check whether native command queuing commands are outstanding on specific port.
+
+  @param[in]  AhciRegisters  The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  Port           The number of port.
+
+  @retval TRUE   At least one queue tag of the port is in use.
+  @retval FALSE  The port is not using its native command queuing resources.
+
+**/
+BOOLEAN
+EFIAPI
+AhciNcqPortBusy (
+  IN EFI_AHCI_REGISTERS  *AhciRegisters,
+  IN UINT16              Port
+  )
+{
+  if ((Port >= EFI_AHCI_MAX_PORTS) || (AhciRegisters->NcqPort[Port] == NULL)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(AhciRegisters->NcqPort[Port]->ActiveTags != 0);
+}
+
+/**
+  Point the port at its native command queuing command list and start it.
+
+  The command list base address can only be changed while the port is stopped,
+  so this is done when the first tag of a burst of queued commands is issued.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  Ncq                The native command queuing context of the port.
+  @param  Port               The number of port.
+
+  @retval EFI_SUCCESS        The port is running on the queuing command list.
+  @retval Others             The port could not be stopped or started.
+**/
+STATIC
+EFI_STATUS
+AhciNcqStartPort (
+  IN EFI_PCI_IO_PROTOCOL  *PciIo,
+  IN EFI_AHCI_NCQ_PORT    *Ncq,
+  IN UINT8                Port
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Offset;
+  DATA_64     Data64;
+
+  Status = AhciStopCommand (PciIo, Port, ATA_ATAPI_TIMEOUT);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Data64.Uint64 = Ncq->CmdListPciAddr;
+  Offset        = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLB;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Lower32);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLBU;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Upper32);
+
+  AhciClearPortStatus (PciIo, Port);
+
+  Status = AhciEnableFisReceive (PciIo, Port, ATA_ATAPI_TIMEOUT);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+  AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_CMD_ST);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Stop the port and point it back at the shared command list, leaving it in the
+  same state as after a non-queued command.
+
+  Clearing PxCMD.ST also clears PxSACT and PxCI, so any command still outstanding
+  is dropped by the controller.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+**/
+STATIC
+VOID
+AhciNcqStopPort (
+  IN EFI_PCI_IO_PROTOCOL  *PciIo,
+  IN EFI_AHCI_REGISTERS   *AhciRegisters,
+  IN UINT8                Port
+  )
+{
+  UINT32   Offset;
+  DATA_64  Data64;
+
+  AhciStopCommand (PciIo, Port, ATA_ATAPI_TIMEOUT);
+  AhciDisableFisReceive (PciIo, Port, ATA_ATAPI_TIMEOUT);
+
+  Data64.Uint64 = (UINTN)(AhciRegisters->AhciCmdListPciAddr);
+  Offset        = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLB;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Lower32);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLBU;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Upper32);
+}
+
+/**
+  Build the command header and command table of one queue tag.
+
+  @param  Ncq               The native command queuing context of the port.
+  @param  Tag               The queue tag.
+  @param  PortMultiplier    The number of port multiplier.
+  @param  Read              The transfer direction.
+  @param  AtaCommandBlock   The EFI_ATA_COMMAND_BLOCK data.
+  @param  DataPhysicalAddr  The pci bus master address of the data buffer.
+  @param  DataLength        The data count to be transferred.
+  @param  PrdtNumber        The number of PRD entries describing the data buffer.
+**/
+STATIC
+VOID
+AhciNcqBuildCommand (
+  IN EFI_AHCI_NCQ_PORT      *Ncq,
+  IN UINT8                  Tag,
+  IN UINT8                  PortMultiplier,
+  IN BOOLEAN                Read,
+  IN EFI_ATA_COMMAND_BLOCK  *AtaCommandBlock,
+  IN EFI_PHYSICAL_ADDRESS   DataPhysicalAddr,
+  IN UINT32                 DataLength,
+  IN UINT32                 PrdtNumber
+  )
+{
+  EFI_AHCI_NCQ_COMMAND_TABLE  *CommandTable;
+  EFI_AHCI_COMMAND_LIST       *CmdList;
+  UINT32                      PrdtIndex;
+  UINT32                      RemainedData;
+  DATA_64                     Data64;
+
+  CommandTable = &Ncq->CommandTable[Tag];
+  ZeroMem (CommandTable, sizeof (EFI_AHCI_NCQ_COMMAND_TABLE));
+
+  AhciBuildCommandFis (&CommandTable->CommandFis, AtaCommandBlock);
+  CommandTable->CommandFis.AhciCFisPmNum = PortMultiplier;
+  //
+  // The tag is carried in bits 7:3 of the sector count register, and the
+  // device register only holds the FUA bit besides the LBA mode bit.
+  //
+  CommandTable->CommandFis.AhciCFisSecCount = (UINT8)(Tag << 3);
+  CommandTable->CommandFis.AhciCFisDevHead  = (UINT8)((AtaCommandBlock->AtaDeviceHead & BIT7) | BIT6);
+
+  RemainedData = DataLength;
+  for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+    if (RemainedData < EFI_AHCI_MAX_DATA_PER_PRDT) {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = RemainedData - 1;
+    } else {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = EFI_AHCI_MAX_DATA_PER_PRDT - 1;
+    }
+
+    Data64.Uint64                                   = DataPhysicalAddr + (UINT64)PrdtIndex * EFI_AHCI_MAX_DATA_PER_PRDT;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+    RemainedData                                   -= MIN (RemainedData, EFI_AHCI_MAX_DATA_PER_PRDT);
+  }
+
+  CommandTable->PrdtTable[PrdtNumber - 1].AhciPrdtIoc = 1;
+
+  CmdList               = &Ncq->CmdList[Tag];
+  CmdList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+  CmdList->AhciCmdA     = 0;
+  CmdList->AhciCmdW     = Read ? 0 : 1;
+  CmdList->AhciCmdP     = 0;
+  CmdList->AhciCmdPmp   = PortMultiplier;
+  CmdList->AhciCmdPrdtl = PrdtNumber;
+  CmdList->AhciCmdPrdbc = 0;
+}
+
+/**
+  Issue or poll one native command queuing command. Must be called at TPL_NOTIFY
+  so that the queue bookkeeping is not changed behind its back.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Ncq                 The native command queuing context of the port.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Task                Pointer to the ATA_NONBLOCK_TASK of the command.
+
+  @retval EFI_NOT_READY         The command is waiting for a tag or still in flight.
+  @retval EFI_SUCCESS           The command completed successfully.
+  @retval Others                The command failed.
+**/
+STATIC
+EFI_STATUS
+AhciNcqExecute (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN     EFI_AHCI_REGISTERS            *AhciRegisters,
+  IN     EFI_AHCI_NCQ_PORT             *Ncq,
+  IN     UINT8                         Port,
+  IN     UINT8                         PortMultiplier,
+  IN     BOOLEAN                       Read,
+  IN     EFI_ATA_COMMAND_BLOCK         *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK          *AtaStatusBlock,
+  IN OUT VOID                          *MemoryAddr,
+  IN     UINT32                        DataCount,
+  IN     ATA_NONBLOCK_TASK             *Task
+  )
+{
+  EFI_STATUS                     Status;
+  EFI_PCI_IO_PROTOCOL            *PciIo;
+  EFI_PCI_IO_PROTOCOL_OPERATION  Flag;
+  EFI_PHYSICAL_ADDRESS           PhyAddr;
+  UINTN                          MapLength;
+  UINT32                         PrdtNumber;
+  UINT32                         FreeTags;
+  UINT32                         TagBit;
+  UINT8                          Tag;
+  UINT32                         Offset;
+  UINT32                         PortInterrupt;
+  UINT32                         Outstanding;
+
+  PciIo = Instance->PciIo;
+
+  if (!Task->IsStart) {
+    FreeTags = ~Ncq->ActiveTags & (UINT32)(LShiftU64 (1, Ncq->Depth) - 1);
+    if (FreeTags == 0) {
+      return EFI_NOT_READY;
+    }
+
+    PrdtNumber = (DataCount + EFI_AHCI_MAX_DATA_PER_PRDT - 1) / EFI_AHCI_MAX_DATA_PER_PRDT;
+    if ((PrdtNumber == 0) || (PrdtNumber > AHCI_NCQ_MAX_PRDT)) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    if (Read) {
+      Flag = EfiPciIoOperationBusMasterWrite;
+    } else {
+      Flag = EfiPciIoOperationBusMasterRead;
+    }
+
+    MapLength = DataCount;
+    Status    = PciIo->Map (
+                         PciIo,
+                         Flag,
+                         MemoryAddr,
+                         &MapLength,
+                         &PhyAddr,
+                         &Task->Map
+                         );
+    if (EFI_ERROR (Status) || (MapLength != DataCount)) {
+      if (!EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, Task->Map);
+      }
+
+      Task->Map = NULL;
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    Tag    = (UINT8)LowBitSet32 (FreeTags);
+    TagBit = (UINT32)BIT0 << Tag;
+    AhciNcqBuildCommand (Ncq, Tag, PortMultiplier, Read, AtaCommandBlock, PhyAddr, DataCount, PrdtNumber);
+
+    if (Ncq->ActiveTags == 0) {
+      Status = AhciNcqStartPort (PciIo, Ncq, Port);
+      if (EFI_ERROR (Status)) {
+        AhciNcqStopPort (PciIo, AhciRegisters, Port);
+        PciIo->Unmap (PciIo, Task->Map);
+        Task->Map = NULL;
+        return Status;
+      }
+    }
+
+    Ncq->ActiveTags |= TagBit;
+    Ncq->Tasks[Tag]  = Task;
+    Task->NcqTag     = Tag;
+    Task->IsStart    = TRUE;
+
+    DEBUG ((DEBUG_VERBOSE, "Starting queued command on port [%d] tag [%d]:\n", Port, Tag));
+    AhciPrintCommandBlock (AtaCommandBlock, DEBUG_VERBOSE);
+
+    //
+    // PxSACT has to be set before the command is issued through PxCI. Writing
+    // zero to the other bits of either register has no effect.
+    //
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    AhciWriteReg (PciIo, Offset, TagBit);
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+    AhciWriteReg (PciIo, Offset, TagBit);
+
+    return EFI_NOT_READY;
+  }
+
+  TagBit = (UINT32)BIT0 << Task->NcqTag;
+
+  Offset        = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_IS;
+  PortInterrupt = AhciReadReg (PciIo, Offset);
+  if ((PortInterrupt & EFI_AHCI_PORT_IS_ERROR_MASK) != 0) {
+    DEBUG ((DEBUG_ERROR, "AHCI: Error interrupt reported PxIS: %X on queued command tag [%d]\n", PortInterrupt, Task->NcqTag));
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // The device clears the PxSACT bit of a tag through a Set Device Bits FIS once
+  // the command has completed.
+  //
+  Offset      = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+  Outstanding = AhciReadReg (PciIo, Offset);
+  Offset      = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+  Outstanding = Outstanding | AhciReadReg (PciIo, Offset);
+  if ((Outstanding & TagBit) != 0) {
+    if (!Task->InfiniteWait && (Task->RetryTimes == 0)) {
+      DEBUG ((DEBUG_ERROR, "AHCI: Queued command tag [%d] on port [%d] timed out\n", Task->NcqTag, Port));
+      return EFI_TIMEOUT;
+    }
+
+    Task->RetryTimes--;
+    return EFI_NOT_READY;
+  }
+
+  PciIo->Unmap (PciIo, Task->Map);
+  Task->Map                = NULL;
+  Ncq->Tasks[Task->NcqTag] = NULL;
+  Ncq->ActiveTags         &= ~TagBit;
+  if (Ncq->ActiveTags == 0) {
+    AhciNcqStopPort (PciIo, AhciRegisters, Port);
+  }
+
+  if (AtaStatusBlock != NULL) {
+    ZeroMem (AtaStatusBlock, sizeof (EFI_ATA_STATUS_BLOCK));
+    Offset                    = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+    AtaStatusBlock->AtaStatus = (UINT8)(AhciReadReg (PciIo, Offset) & ~EFI_AHCI_PORT_TFD_ERR);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Abort all native command queuing commands outstanding on specific port.
+
+  The port is stopped and switched back to the shared command list. If the
+  device reported an error, the NCQ Command Error log is read to take the device
+  out of its error state. Every aborted non-blocking task is removed from the
+  task list and freed.
+
+  @param[in]  Instance    A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port        The number of port.
+  @param[in]  IsSigEvent  Indicate whether signal the task event when remove the
+                          task.
+
+**/
+VOID
+EFIAPI
+AhciNcqAbortPort (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN UINT8                         Port,
+  IN BOOLEAN                       IsSigEvent
+  )
+{
+  EFI_PCI_IO_PROTOCOL  *PciIo;
+  EFI_AHCI_REGISTERS   *AhciRegisters;
+  EFI_AHCI_NCQ_PORT    *Ncq;
+  ATA_NONBLOCK_TASK    *Task;
+  UINT32               Offset;
+  UINT32               PortTfd;
+  UINT32               Tag;
+  UINT8                Log[512];
+  EFI_STATUS           Status;
+
+  PciIo         = Instance->PciIo;
+  AhciRegisters = &Instance->AhciRegisters;
+  if (Port >= EFI_AHCI_MAX_PORTS) {
+    return;
+  }
+
+  Ncq = AhciRegisters->NcqPort[Port];
+  if ((Ncq == NULL) || (Ncq->ActiveTags == 0)) {
+    return;
+  }
+
+  AhciNcqStopPort (PciIo, AhciRegisters, Port);
+
+  Offset  = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+  PortTfd = AhciReadReg (PciIo, Offset);
+  if ((PortTfd & (EFI_AHCI_PORT_TFD_BSY | EFI_AHCI_PORT_TFD_DRQ)) != 0) {
+    Status = AhciResetPort (PciIo, Port);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "Failed to reset the port %d\n", Port));
+    }
+  } else if ((PortTfd & EFI_AHCI_PORT_TFD_ERR) != 0) {
+    //
+    // After a queued command fails the device aborts every new queued command
+    // until the NCQ Command Error log has been read.
+    //
+    AhciClearPortStatus (PciIo, Port);
+    Status = AhciReadLogExt (PciIo, AhciRegisters, Port, 0, Log, AHCI_NCQ_ERROR_LOG, 0);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "Failed to read the NCQ error log of port %d - %r\n", Port, Status));
+    } else if ((Log[0] & AHCI_NCQ_ERROR_LOG_NQ) == 0) {
+      DEBUG ((
+        DEBUG_ERROR,
+        "AHCI: Queued command tag [%d] on port [%d] failed, status %x error %x\n",
+        Log[0] & AHCI_NCQ_ERROR_LOG_TAG_MASK,
+        Port,
+        Log[2],
+        Log[3]
+        ));
+    }
+  }
+
+  AhciClearPortStatus (PciIo, Port);
+
+  for (Tag = 0; Tag < AHCI_NCQ_MAX_TAGS; Tag++) {
+    Task = Ncq->Tasks[Tag];
+    if (Task == NULL) {
+      continue;
+    }
+
+    Ncq->Tasks[Tag] = NULL;
+    PciIo->Unmap (PciIo, Task->Map);
+    Task->Map     = NULL;
+    Task->IsStart = FALSE;
+
+    //
+    // Blocking commands are not on the task list; their caller reports the error.
+    //
+    if (Task->Event != NULL) {
+      Task->Packet->Asb->AtaStatus = 0x01;
+      RemoveEntryList (&Task->Link);
+      if (IsSigEvent) {
+        gBS->SignalEvent (Task->Event);
+      }
+
+      FreePool (Task);
+    }
+  }
+
+  Ncq->ActiveTags = 0;
+}
+
+/**
+  Wait until no native command queuing command is outstanding on specific port,
+  so that a command can be issued through the shared command list.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port      The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqWaitPortIdle (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN UINT8                         Port
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (AhciNcqPortBusy (&Instance->AhciRegisters, Port)) {
+    AsyncNonBlockingTransferRoutine (NULL, Instance);
+    //
+    // Stall for 100us.
+    //
+    MicroSecondDelay (100);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Start a native command queuing (READ/WRITE FPDMA QUEUED) transfer on specific
+  port, or check whether a started one has completed.
+
+  In non-blocking mode the first call takes a free queue tag and issues the
+  command without waiting for the other commands outstanding on the port. Later
+  calls only check whether that tag has completed. EFI_NOT_READY is returned
+  while every tag is in use or the command is still in flight.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of the transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_UNSUPPORTED       Native command queuing is not enabled on the port.
+  @retval EFI_BAD_BUFFER_SIZE   The data buffer can not be described by one queue tag.
+  @retval EFI_NOT_READY         The command has not completed yet.
+  @retval EFI_DEVICE_ERROR      The transfer abort with error occurs.
+  @retval EFI_TIMEOUT           The operation is time out.
+  @retval EFI_SUCCESS           The transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN     EFI_AHCI_REGISTERS            *AhciRegisters,
+  IN     UINT8                         Port,
+  IN     UINT8                         PortMultiplier,
+  IN     BOOLEAN                       Read,
+  IN     EFI_ATA_COMMAND_BLOCK         *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK          *AtaStatusBlock,
+  IN OUT VOID                          *MemoryAddr,
+  IN     UINT32                        DataCount,
+  IN     UINT64                        Timeout,
+  IN     ATA_NONBLOCK_TASK             *Task
+  )
+{
+  EFI_STATUS         Status;
+  EFI_AHCI_NCQ_PORT  *Ncq;
+  ATA_NONBLOCK_TASK  SyncTask;
+  EFI_TPL            OldTpl;
+
+  if ((Port >= EFI_AHCI_MAX_PORTS) || (AhciRegisters->NcqPort[Port] == NULL)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Ncq = AhciRegisters->NcqPort[Port];
+
+  if (Task != NULL) {
+    return AhciNcqExecute (
+             Instance,
+             AhciRegisters,
+             Ncq,
+             Port,
+             PortMultiplier,
+             Read,
+             AtaCommandBlock,
+             AtaStatusBlock,
+             MemoryAddr,
+             DataCount,
+             Task
+             );
+  }
+
+  //
+  // A blocking queued command runs through the same path as a non-blocking one,
+  // with a task that lives on the stack instead of the task list. As for other
+  // blocking transfers, all non-blocking tasks are finished first.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (!IsListEmpty (&Instance->NonBlockingTaskList)) {
+    AsyncNonBlockingTransferRoutine (NULL, Instance);
+    //
+    // Stall for 100us.
+    //
+    MicroSecondDelay (100);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  ZeroMem (&SyncTask, sizeof (ATA_NONBLOCK_TASK));
+  SyncTask.Signature      = ATA_NONBLOCKING_TASK_SIGNATURE;
+  SyncTask.Port           = Port;
+  SyncTask.PortMultiplier = PortMultiplier;
+  SyncTask.RetryTimes     = DivU64x32 (Timeout, 1000) + 1;
+  SyncTask.InfiniteWait   = (BOOLEAN)(Timeout == 0);
+
+  do {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Status = AhciNcqExecute (
+               Instance,
+               AhciRegisters,
+               Ncq,
+               Port,
+               PortMultiplier,
+               Read,
+               AtaCommandBlock,
+               AtaStatusBlock,
+               MemoryAddr,
+               DataCount,
+               &SyncTask
+               );
+    if (EFI_ERROR (Status) && (Status != EFI_NOT_READY) && SyncTask.IsStart) {
+      //
+      // Non-blocking commands queued on the port meanwhile are aborted as well,
+      // so signal their events.
+      //
+      AhciNcqAbortPort (Instance, Port, TRUE);
+      if (AtaStatusBlock != NULL) {
+        AtaStatusBlock->AtaStatus = 0x01;
+      }
+    }
+
+    gBS->RestoreTPL (OldTpl);
+
+    if (Status != EFI_NOT_READY) {
+      break;
+    }
+
+    //
+    // Stall for 100us.
+    //
+    MicroSecondDelay (100);
+  } while (TRUE);
+
+  return Status;
+}
+
 /**
   Enable DEVSLP of the disk if supported.
 
@@ -3189,6 +3963,12 @@ AhciModeInitialization (
           0,
           &Buffer
           );
+        AhciNcqCreatePort (
+          PciIo,
+          AhciRegisters,
+          Port,
+          &Buffer
+          );
       }
 
       //
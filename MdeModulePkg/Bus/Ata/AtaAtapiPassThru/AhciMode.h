@@ -13,6 +13,7 @@
 #define EFI_AHCI_CAPABILITY_OFFSET  0x0000
 #define   EFI_AHCI_CAP_SAM          BIT18
 #define   EFI_AHCI_CAP_SSS          BIT27
+#define   EFI_AHCI_CAP_SNCQ         BIT30
 #define   EFI_AHCI_CAP_S64A         BIT31
 #define EFI_AHCI_GHC_OFFSET         0x0004
 #define   EFI_AHCI_GHC_RESET        BIT0
@@ -195,6 +196,21 @@ typedef union {
 
 #define AHCI_COMMAND_RETRIES  (PcdGet32 (PcdAhciCommandRetryCount))
 
+//
+// Native command queuing supports up to 32 outstanding commands per port.
+// Each queue tag owns a command table whose PRD table covers the largest
+// FPDMA transfer: 65536 blocks of up to 4KB each, 4MB per PRD entry.
+//
+#define AHCI_NCQ_MAX_TAGS  32
+#define AHCI_NCQ_MAX_PRDT  64
+
+//
+// NCQ Command Error log (ATA8-ACS, log address 10h)
+//
+#define AHCI_NCQ_ERROR_LOG             0x10
+#define   AHCI_NCQ_ERROR_LOG_TAG_MASK  0x1F
+#define   AHCI_NCQ_ERROR_LOG_NQ        BIT7
+
 #pragma pack(1)
 //
 // Command List structure includes total 32 entries.
@@ -285,6 +301,16 @@ typedef struct {
   EFI_AHCI_COMMAND_PRDT     PrdtTable[65535];     // The scatter/gather list for data transfer
 } EFI_AHCI_COMMAND_TABLE;
 
+//
+// Command table used by one native command queuing tag
+//
+typedef struct {
+  EFI_AHCI_COMMAND_FIS      CommandFis;       // A software constructed FIS.
+  EFI_AHCI_ATAPI_COMMAND    AtapiCmd;         // Unused by FPDMA commands.
+  UINT8                     Reserved[0x30];
+  EFI_AHCI_COMMAND_PRDT     PrdtTable[AHCI_NCQ_MAX_PRDT];
+} EFI_AHCI_NCQ_COMMAND_TABLE;
+
 //
 // Received FIS structure
 //
@@ -311,6 +337,23 @@ typedef struct {
 
 #pragma pack()
 
+//
+// Per port native command queuing context. While any tag is outstanding the
+// port's command list base points at CmdList instead of the shared command
+// list, and it is switched back once the queue drains.
+//
+typedef struct {
+  EFI_AHCI_COMMAND_LIST         *CmdList;
+  EFI_AHCI_NCQ_COMMAND_TABLE    *CommandTable;
+  EFI_PHYSICAL_ADDRESS          CmdListPciAddr;
+  EFI_PHYSICAL_ADDRESS          CommandTablePciAddr;
+  VOID                          *Map;
+  UINTN                         PageCount;
+  UINT32                        Depth;      // Number of usable tags.
+  UINT32                        ActiveTags; // Bitmap of outstanding tags.
+  struct _ATA_NONBLOCK_TASK     *Tasks[AHCI_NCQ_MAX_TAGS];
+} EFI_AHCI_NCQ_PORT;
+
 typedef struct {
   EFI_AHCI_RECEIVED_FIS     *AhciRFis;
   EFI_AHCI_COMMAND_LIST     *AhciCmdList;
@@ -324,6 +367,7 @@ typedef struct {
   VOID                      *MapRFis;
   VOID                      *MapCmdList;
   VOID                      *MapCommandTable;
+  EFI_AHCI_NCQ_PORT         *NcqPort[EFI_AHCI_MAX_PORTS];
 } EFI_AHCI_REGISTERS;
 
 /**
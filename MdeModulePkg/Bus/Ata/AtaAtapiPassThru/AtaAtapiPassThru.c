@@ -193,6 +193,7 @@ AtaPassThruPassThruExecute (
   EFI_ATA_PASS_THRU_CMD_PROTOCOL  Protocol;
   EFI_ATA_HC_WORK_MODE            Mode;
   EFI_STATUS                      Status;
+  BOOLEAN                         Read;
 
   Protocol = Packet->Protocol;
 
@@ -286,6 +287,14 @@ AtaPassThruPassThruExecute (
         PortMultiplierPort = 0;
       }
 
+      //
+      // A port only goes back to the shared command list once all of its
+      // queued commands have completed.
+      //
+      if ((Task == NULL) && (Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+        AhciNcqWaitPortIdle (Instance, (UINT8)Port);
+      }
+
       switch (Protocol) {
         case EFI_ATA_PASS_THRU_PROTOCOL_ATA_NON_DATA:
           Status = AhciNonDataTransfer (
@@ -369,6 +378,22 @@ AtaPassThruPassThruExecute (
                      Task
                      );
           break;
+        case EFI_ATA_PASS_THRU_PROTOCOL_FPDMA:
+          Read   = (BOOLEAN)(Packet->InTransferLength != 0);
+          Status = AhciNcqTransfer (
+                     Instance,
+                     &Instance->AhciRegisters,
+                     (UINT8)Port,
+                     (UINT8)PortMultiplierPort,
+                     Read,
+                     Packet->Acb,
+                     Packet->Asb,
+                     Read ? Packet->InDataBuffer : Packet->OutDataBuffer,
+                     Read ? Packet->InTransferLength : Packet->OutTransferLength,
+                     Packet->Timeout,
+                     Task
+                     );
+          break;
         default:
           return EFI_UNSUPPORTED;
       }
@@ -403,19 +428,39 @@ AsyncNonBlockingTransferRoutine (
   ATA_NONBLOCK_TASK             *Task;
   EFI_STATUS                    Status;
   ATA_ATAPI_PASS_THRU_INSTANCE  *Instance;
-
-  Instance    = (ATA_ATAPI_PASS_THRU_INSTANCE *)Context;
-  EntryHeader = &Instance->NonBlockingTaskList;
-  //
-  // Get the Tasks from the Tasks List and execute it, until there is
-  // no task in the list or the device is busy with task (EFI_NOT_READY).
-  //
-  while (TRUE) {
-    if (!IsListEmpty (EntryHeader)) {
-      Entry = GetFirstNode (EntryHeader);
-      Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
-    } else {
-      return;
+  BOOLEAN                       IsQueued;
+  BOOLEAN                       NonQueuedBusy;
+  UINT32                        PortBit;
+  UINT32                        BlockedPorts;
+
+  Instance      = (ATA_ATAPI_PASS_THRU_INSTANCE *)Context;
+  EntryHeader   = &Instance->NonBlockingTaskList;
+  NonQueuedBusy = FALSE;
+  BlockedPorts  = 0;
+  //
+  // Walk the Tasks List in order. Tasks which are not native command queuing
+  // ones are executed one at a time, until the device is busy with one of them
+  // (EFI_NOT_READY). Queued (FPDMA) tasks are issued whenever their port has a
+  // free tag and no earlier task for the port is still pending, and they may
+  // complete in any order.
+  //
+  Entry = GetFirstNode (EntryHeader);
+  while (!IsNull (EntryHeader, Entry)) {
+    Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    Entry = GetNextNode (EntryHeader, Entry);
+
+    IsQueued = (BOOLEAN)(Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA);
+    PortBit  = (UINT32)BIT0 << Task->Port;
+    if (!IsQueued) {
+      if (NonQueuedBusy ||
+          ((Instance->Mode == EfiAtaAhciMode) && AhciNcqPortBusy (&Instance->AhciRegisters, Task->Port)))
+      {
+        NonQueuedBusy = TRUE;
+        BlockedPorts |= PortBit;
+        continue;
+      }
+    } else if (!Task->IsStart && ((BlockedPorts & PortBit) != 0)) {
+      continue;
     }
 
     Status = AtaPassThruPassThruExecute (
@@ -426,21 +471,37 @@ AsyncNonBlockingTransferRoutine (
                Task
                );
 
-    //
-    // If the data transfer meet a error, remove all tasks in the list since these tasks are
-    // associated with one task from Ata Bus and signal the event with error status.
-    //
     if ((Status != EFI_NOT_READY) && (Status != EFI_SUCCESS)) {
-      DestroyAsynTaskList (Instance, TRUE);
-      break;
+      if (!IsQueued) {
+        //
+        // If the data transfer meet a error, remove all tasks in the list since these tasks are
+        // associated with one task from Ata Bus and signal the event with error status.
+        //
+        DestroyAsynTaskList (Instance, TRUE);
+        break;
+      }
+
+      if (Task->IsStart) {
+        //
+        // An error on a queued command aborts every command outstanding on the
+        // port, including this one. The list may have changed, so stop here.
+        //
+        AhciNcqAbortPort (Instance, (UINT8)Task->Port, TRUE);
+        break;
+      }
+
+      Task->Packet->Asb->AtaStatus = 0x01;
     }
 
     //
     // For Non blocking mode, the Status of EFI_NOT_READY means the operation
-    // is not finished yet. Otherwise the operation is successful.
+    // is not finished yet. Otherwise the operation is done.
     //
     if (Status == EFI_NOT_READY) {
-      break;
+      if (!IsQueued) {
+        NonQueuedBusy = TRUE;
+        BlockedPorts |= PortBit;
+      }
     } else {
       RemoveEntryList (&Task->Link);
       gBS->SignalEvent (Task->Event);
@@ -879,6 +940,7 @@ AtaAtapiPassThruStop (
   EFI_ATA_PASS_THRU_PROTOCOL    *AtaPassThru;
   EFI_PCI_IO_PROTOCOL           *PciIo;
   EFI_AHCI_REGISTERS            *AhciRegisters;
+  UINT8                         Port;
 
   DEBUG ((DEBUG_INFO, "==AtaAtapiPassThru Stop== Controller = %x\n", Controller));
 
@@ -952,6 +1014,10 @@ AtaAtapiPassThruStop (
   //
   if (Instance->Mode == EfiAtaAhciMode) {
     AhciRegisters = &Instance->AhciRegisters;
+    for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port++) {
+      AhciNcqFreePort (PciIo, AhciRegisters, Port);
+    }
+
     PciIo->Unmap (
              PciIo,
              AhciRegisters->MapCommandTable
@@ -1151,8 +1217,18 @@ DestroyAsynTaskList (
   LIST_ENTRY         *DelEntry;
   ATA_NONBLOCK_TASK  *Task;
   EFI_TPL            OldTpl;
+  UINT8              Port;
 
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  //
+  // Stop the queued commands which are in flight before their tasks are freed.
+  //
+  if (Instance->Mode == EfiAtaAhciMode) {
+    for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port++) {
+      AhciNcqAbortPort (Instance, Port, IsSigEvent);
+    }
+  }
+
   if (!IsListEmpty (&Instance->NonBlockingTaskList)) {
     //
     // Free the Subtask list.
@@ -1378,6 +1454,17 @@ AtaPassThruPassThru (
     return EFI_BAD_BUFFER_SIZE;
   }
 
+  //
+  // Native command queuing is only available on the AHCI ports where both the
+  // controller and the device support it.
+  //
+  if ((Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) &&
+      ((Instance->Mode != EfiAtaAhciMode) || (Port >= EFI_AHCI_MAX_PORTS) ||
+       (Instance->AhciRegisters.NcqPort[Port] == NULL)))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
   //
   // For non-blocking mode, queue the Task into the list.
   //
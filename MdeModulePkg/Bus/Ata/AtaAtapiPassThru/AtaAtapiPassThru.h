@@ -138,6 +138,7 @@ struct _ATA_NONBLOCK_TASK {
   VOID                                *TableMap;       // Pointer to PRD table map.
   EFI_ATA_DMA_PRD                     *MapBaseAddress; //  Pointer to range Base address for Map.
   UINTN                               PageCount;       //  The page numbers used by PCIO freebuffer.
+  UINT8                               NcqTag;          //  Queue tag of a native command queuing command.
 };
 
 //
@@ -1190,6 +1191,122 @@ AhciPioTransfer (
   IN     ATA_NONBLOCK_TASK       *Task
   );
 
+/**
+  Start a native command queuing (READ/WRITE FPDMA QUEUED) transfer on specific
+  port, or check whether a started one has completed.
+
+  In non-blocking mode the first call takes a free queue tag and issues the
+  command without waiting for the other commands outstanding on the port. Later
+  calls only check whether that tag has completed. EFI_NOT_READY is returned
+  while every tag is in use or the command is still in flight.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of the transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_UNSUPPORTED       Native command queuing is not enabled on the port.
+  @retval EFI_BAD_BUFFER_SIZE   The data buffer can not be described by one queue tag.
+  @retval EFI_NOT_READY         The command has not completed yet.
+  @retval EFI_DEVICE_ERROR      The transfer abort with error occurs.
+  @retval EFI_TIMEOUT           The operation is time out.
+  @retval EFI_SUCCESS           The transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN     EFI_AHCI_REGISTERS            *AhciRegisters,
+  IN     UINT8                         Port,
+  IN     UINT8                         PortMultiplier,
+  IN     BOOLEAN                       Read,
+  IN     EFI_ATA_COMMAND_BLOCK         *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK          *AtaStatusBlock,
+  IN OUT VOID                          *MemoryAddr,
+  IN     UINT32                        DataCount,
+  IN     UINT64                        Timeout,
+  IN     ATA_NONBLOCK_TASK             *Task
+  );
+
+/**
+  Abort all native command queuing commands outstanding on specific port.
+
+  The port is stopped and switched back to the shared command list. If the
+  device reported an error, the NCQ Command Error log is read to take the device
+  out of its error state. Every aborted non-blocking task is removed from the
+  task list and freed.
+
+  @param[in]  Instance    A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port        The number of port.
+  @param[in]  IsSigEvent  Indicate whether signal the task event when remove the
+                          task.
+
+**/
+VOID
+EFIAPI
+AhciNcqAbortPort (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN UINT8                         Port,
+  IN BOOLEAN                       IsSigEvent
+  );
+
+/**
+  Check whether native command queuing commands are outstanding on specific port.
+
+  @param[in]  AhciRegisters  The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  Port           The number of port.
+
+  @retval TRUE   At least one queue tag of the port is in use.
+  @retval FALSE  The port is not using its native command queuing resources.
+
+**/
+BOOLEAN
+EFIAPI
+AhciNcqPortBusy (
+  IN EFI_AHCI_REGISTERS  *AhciRegisters,
+  IN UINT16              Port
+  );
+
+/**
+  Wait until no native command queuing command is outstanding on specific port,
+  so that a command can be issued through the shared command list.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port      The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqWaitPortIdle (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN UINT8                         Port
+  );
+
+/**
+  Release the native command queuing resources of specific port.
+
+  @param[in]  PciIo          The PCI IO protocol instance.
+  @param[in]  AhciRegisters  The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  Port           The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqFreePort (
+  IN EFI_PCI_IO_PROTOCOL  *PciIo,
+  IN EFI_AHCI_REGISTERS   *AhciRegisters,
+  IN UINT8                Port
+  );
+
 /**
   Send ATA command into device with NON_DATA protocol
 
@@ -113,6 +113,7 @@ typedef struct {
 
   BOOLEAN                                  UdmaValid;
   BOOLEAN                                  Lba48Bit;
+  BOOLEAN                                  NcqSupported;
 
   //
   // Cached data for ATA identify data
@@ -333,6 +333,19 @@ IdentifyAtaDevice (
     AtaDevice->Lba48Bit = FALSE;
   }
 
+  //
+  // Check whether the WORD 76 (Serial ATA capabilities) reports native command
+  // queuing. FPDMA QUEUED commands always use 48-bit addressing and DMA.
+  //
+  if (AtaDevice->UdmaValid &&
+      (IdentifyData->serial_ata_capabilities != 0x0000) &&
+      (IdentifyData->serial_ata_capabilities != 0xFFFF) &&
+      ((IdentifyData->serial_ata_capabilities & BIT8) != 0))
+  {
+    AtaDevice->NcqSupported = TRUE;
+    DEBUG ((DEBUG_INFO, "AtaBus - NCQ supported, queue depth %d\n", (IdentifyData->queue_depth & 0x1F) + 1));
+  }
+
   //
   // Block Media Information:
   //
@@ -469,8 +482,10 @@ TransferAtaDevice (
   IN EFI_EVENT                             Event OPTIONAL
   )
 {
+  EFI_STATUS                        Status;
   EFI_ATA_COMMAND_BLOCK             *Acb;
   EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+  BOOLEAN                           UseNcq;
 
   //
   // Ensure AtaDevice->UdmaValid, AtaDevice->Lba48Bit and IsWrite are valid boolean values
@@ -479,22 +494,46 @@ TransferAtaDevice (
   ASSERT ((UINTN)AtaDevice->Lba48Bit < 2);
   ASSERT ((UINTN)IsWrite < 2);
   //
+  // Non-blocking requests to a device that supports native command queuing are
+  // issued as FPDMA QUEUED commands, so that several of them can be outstanding
+  // on the device at once.
+  //
+  UseNcq = (BOOLEAN)((Event != NULL) && AtaDevice->NcqSupported);
+  //
   // Prepare for ATA command block.
   //
-  Acb                  = ZeroMem (&AtaDevice->Acb, sizeof (EFI_ATA_COMMAND_BLOCK));
-  Acb->AtaCommand      = mAtaCommands[AtaDevice->UdmaValid][AtaDevice->Lba48Bit][IsWrite];
-  Acb->AtaSectorNumber = (UINT8)StartLba;
-  Acb->AtaCylinderLow  = (UINT8)RShiftU64 (StartLba, 8);
-  Acb->AtaCylinderHigh = (UINT8)RShiftU64 (StartLba, 16);
-  Acb->AtaDeviceHead   = (UINT8)(BIT7 | BIT6 | BIT5 | (AtaDevice->PortMultiplierPort == 0xFFFF ? 0 : (AtaDevice->PortMultiplierPort << 4)));
-  Acb->AtaSectorCount  = (UINT8)TransferLength;
-  if (AtaDevice->Lba48Bit) {
+  Acb = ZeroMem (&AtaDevice->Acb, sizeof (EFI_ATA_COMMAND_BLOCK));
+  if (UseNcq) {
+    //
+    // For FPDMA QUEUED the block count goes in the FEATURE registers, and the
+    // SECTOR COUNT register carries the tag, which is assigned by the host
+    // controller driver.
+    //
+    Acb->AtaCommand         = (UINT8)(IsWrite ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED);
+    Acb->AtaFeatures        = (UINT8)TransferLength;
+    Acb->AtaFeaturesExp     = (UINT8)(TransferLength >> 8);
+    Acb->AtaSectorNumber    = (UINT8)StartLba;
+    Acb->AtaCylinderLow     = (UINT8)RShiftU64 (StartLba, 8);
+    Acb->AtaCylinderHigh    = (UINT8)RShiftU64 (StartLba, 16);
     Acb->AtaSectorNumberExp = (UINT8)RShiftU64 (StartLba, 24);
     Acb->AtaCylinderLowExp  = (UINT8)RShiftU64 (StartLba, 32);
     Acb->AtaCylinderHighExp = (UINT8)RShiftU64 (StartLba, 40);
-    Acb->AtaSectorCountExp  = (UINT8)(TransferLength >> 8);
+    Acb->AtaDeviceHead      = BIT6;
   } else {
-    Acb->AtaDeviceHead = (UINT8)(Acb->AtaDeviceHead | RShiftU64 (StartLba, 24));
+    Acb->AtaCommand      = mAtaCommands[AtaDevice->UdmaValid][AtaDevice->Lba48Bit][IsWrite];
+    Acb->AtaSectorNumber = (UINT8)StartLba;
+    Acb->AtaCylinderLow  = (UINT8)RShiftU64 (StartLba, 8);
+    Acb->AtaCylinderHigh = (UINT8)RShiftU64 (StartLba, 16);
+    Acb->AtaDeviceHead   = (UINT8)(BIT7 | BIT6 | BIT5 | (AtaDevice->PortMultiplierPort == 0xFFFF ? 0 : (AtaDevice->PortMultiplierPort << 4)));
+    Acb->AtaSectorCount  = (UINT8)TransferLength;
+    if (AtaDevice->Lba48Bit) {
+      Acb->AtaSectorNumberExp = (UINT8)RShiftU64 (StartLba, 24);
+      Acb->AtaCylinderLowExp  = (UINT8)RShiftU64 (StartLba, 32);
+      Acb->AtaCylinderHighExp = (UINT8)RShiftU64 (StartLba, 40);
+      Acb->AtaSectorCountExp  = (UINT8)(TransferLength >> 8);
+    } else {
+      Acb->AtaDeviceHead = (UINT8)(Acb->AtaDeviceHead | RShiftU64 (StartLba, 24));
+    }
   }
 
   //
@@ -514,8 +553,13 @@ TransferAtaDevice (
     Packet->InTransferLength = TransferLength;
   }
 
-  Packet->Protocol = mAtaPassThruCmdProtocols[AtaDevice->UdmaValid][IsWrite];
-  Packet->Length   = EFI_ATA_PASS_THRU_LENGTH_SECTOR_COUNT;
+  if (UseNcq) {
+    Packet->Protocol = EFI_ATA_PASS_THRU_PROTOCOL_FPDMA;
+  } else {
+    Packet->Protocol = mAtaPassThruCmdProtocols[AtaDevice->UdmaValid][IsWrite];
+  }
+
+  Packet->Length = EFI_ATA_PASS_THRU_LENGTH_SECTOR_COUNT;
   //
   // |------------------------|-----------------|------------------------|-----------------|
   // | ATA PIO Transfer Mode  |  Transfer Rate  | ATA DMA Transfer Mode  |  Transfer Rate  |
@@ -549,7 +593,23 @@ TransferAtaDevice (
     Packet->Timeout = EFI_TIMER_PERIOD_SECONDS (DivU64x32 (MultU64x32 (TransferLength, AtaDevice->BlockMedia.BlockSize), 3300000) + 31);
   }
 
-  return AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+  Status = AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+  if (UseNcq && (Status == EFI_UNSUPPORTED)) {
+    //
+    // The ATA pass through driver cannot queue commands on this port. Fall back
+    // to the non-queued DMA commands for this and all later requests.
+    //
+    DEBUG ((DEBUG_INFO, "AtaBus - NCQ not available on Port %x, using DMA\n", AtaDevice->Port));
+    AtaDevice->NcqSupported = FALSE;
+    FreeAlignedBuffer (Packet->Asb, sizeof (EFI_ATA_STATUS_BLOCK));
+    if (Packet->Acb != NULL) {
+      FreePool (Packet->Acb);
+    }
+
+    return TransferAtaDevice (AtaDevice, TaskPacket, Buffer, StartLba, TransferLength, IsWrite, Event);
+  }
+
+  return Status;
 }
 
 /**
@@ -806,7 +866,11 @@ AccessAtaDevice (
   if ((Token != NULL) && (Token->Event != NULL)) {
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-    if (!IsListEmpty (&AtaDevice->AtaSubTaskList)) {
+    //
+    // With native command queuing the device accepts several requests at once,
+    // so there is no need to hold this one back until the previous completes.
+    //
+    if (!AtaDevice->NcqSupported && !IsListEmpty (&AtaDevice->AtaSubTaskList)) {
       AtaTask = AllocateZeroPool (sizeof (ATA_BUS_ASYN_TASK));
       if (AtaTask == NULL) {
         gBS->RestoreTPL (OldTpl);
@@ -41,6 +41,8 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
 
 #include <Guid/NVMeEventGroup.h>
 
@@ -67,17 +69,24 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 #define NVME_CCQ_SIZE  1                                // Number of I/O completion queue entries, which is 0-based
 
 //
-// Number of asynchronous I/O submission queue entries, which is 0-based.
-// The asynchronous I/O submission queue size is 4kB in total.
+// The asynchronous I/O queue pairs start after the admin queue pair and the
+// synchronous I/O queue pair. Their number and depth are taken from
+// PcdNvmeIoQueuePairs and PcdNvmeIoQueueDepth, and then limited by what the
+// controller supports.
 //
-#define NVME_ASYNC_CSQ_SIZE  63
+#define NVME_ASYNC_QUEUE_BASE  2
+#define NVME_MAX_ASYNC_QUEUES  4
+#define NVME_MIN_QUEUE_DEPTH   2
+
+#define NVME_MAX_QUEUES  (NVME_ASYNC_QUEUE_BASE + NVME_MAX_ASYNC_QUEUES) // Number of queues supported by the driver
+
 //
-// Number of asynchronous I/O completion queue entries, which is 0-based.
-// The asynchronous I/O completion queue size is 4kB in total.
+// Number of PRP list pages preallocated for each asynchronous I/O queue. A
+// command whose PRP entries fit into a single page takes its PRP list from
+// the pool of its queue, others allocate PRP lists on demand.
 //
-#define NVME_ASYNC_CCQ_SIZE  255
-
-#define NVME_MAX_QUEUES  3                              // Number of queues supported by the driver
+#define NVME_PRP_POOL_SIZE  32
+#define NVME_PRP_POOL_NONE  0xFFFF
 
 //
 // FormatNVM Admin Command LBA Format (LBAF) Mask
@@ -115,6 +124,38 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 //
 #define NVME_HC_ASYNC_TIMER  EFI_TIMER_PERIOD_MILLISECONDS (1)
 
+//
+// Pool of single-page PRP lists owned by one I/O queue.
+//
+typedef struct {
+  UINT8                   *Host;
+  EFI_PHYSICAL_ADDRESS    PciAddr;
+  UINT16                  Pages;
+  UINT16                  FreeCount;
+  UINT16                  Free[NVME_PRP_POOL_SIZE];
+} NVME_PRP_POOL;
+
+//
+// How the data buffer of an I/O command is described to the controller.
+//
+typedef enum {
+  NvmeDptrPrp,          // No data, or the PRP entries in the command
+  NvmeDptrPrpPool,      // A PRP list taken from the pool of the queue
+  NvmeDptrPrpAlloc,     // A PRP list allocated for the command
+  NvmeDptrSgl,          // A single SGL Data Block descriptor
+  NvmeDptrMax
+} NVME_DPTR_TYPE;
+
+//
+// Latency of the completed I/O commands of one data pointer type.
+//
+typedef struct {
+  UINT64    Commands;
+  UINT64    TotalNs;
+  UINT64    MinNs;
+  UINT64    MaxNs;
+} NVME_LATENCY_STATS;
+
 //
 // Unique signature for private data structure.
 //
@@ -144,16 +185,26 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_ADMIN_CONTROLLER_DATA            *ControllerData;
 
   //
-  // 6 x 4kB aligned buffers will be carved out of this buffer.
+  // The submission & completion queues and the PRP list pools are carved out
+  // of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
   // 2nd 4kB boundary is the start of the admin completion queue.
   // 3rd 4kB boundary is the start of I/O submission queue #1.
   // 4th 4kB boundary is the start of I/O completion queue #1.
-  // 5th 4kB boundary is the start of I/O submission queue #2.
-  // 6th 4kB boundary is the start of I/O completion queue #2.
+  // Each asynchronous I/O queue pair follows, submission queue first.
+  // The PRP list pools fill the last BufferPages - QueuePages pages.
   //
   UINT8          *Buffer;
   UINT8          *BufferPciAddr;
+  UINTN          BufferPages;
+  UINTN          QueuePages;
+
+  //
+  // Number of asynchronous I/O queue pairs in use, and their size in entries
+  // (0-based).
+  //
+  UINT16         AsyncQueueNum;
+  UINT16         AsyncQueueSize;
 
   //
   // Pointers to 4kB aligned submission & completion queues.
@@ -168,7 +219,24 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   //
   NVME_SQTDBL    SqTdbl[NVME_MAX_QUEUES];
   NVME_CQHDBL    CqHdbl[NVME_MAX_QUEUES];
-  UINT16         AsyncSqHead;
+  UINT16         AsyncSqHead[NVME_MAX_QUEUES];
+  UINT16         AsyncOutstanding[NVME_MAX_QUEUES];
+
+  //
+  // Number of asynchronous completions reaped so far, used to detect that
+  // the asynchronous I/O queues are making progress.
+  //
+  UINTN          AsyncCompletions;
+
+  //
+  // Preallocated PRP list pages of the I/O queues.
+  //
+  NVME_PRP_POOL  PrpPool[NVME_MAX_QUEUES];
+
+  //
+  // Submission to completion latency of the I/O commands.
+  //
+  NVME_LATENCY_STATS  Latency[NvmeDptrMax];
 
   //
   // Flag to indicate internal IO queue creation.
@@ -328,7 +396,11 @@ typedef struct {
   LIST_ENTRY                                  Link;
 
   EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet;
+  UINT16                                      QueueId;
   UINT16                                      CommandId;
+  UINT16                                      PrpPoolIndex;
+  NVME_DPTR_TYPE                              DptrType;
+  UINT64                                      SubmitTick;
   VOID                                        *MapPrpList;
   UINTN                                       PrpListNo;
   VOID                                        *PrpListHost;
@@ -777,3 +849,108 @@ VOID
 NvmeUnregisterShutdownNotification (
   VOID
   );
+
+/**
+  Call back function when the timer event is signaled.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
+/**
+  Aborts the asynchronous PassThru requests.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_SUCCESS       The asynchronous PassThru requests have been aborted.
+  @return EFI_DEVICE_ERROR  Fail to abort all the asynchronous PassThru requests.
+
+**/
+EFI_STATUS
+AbortAsyncPassThruTasks (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
+/**
+  Reset the NVMe controller after a command timed out, and abort the
+  outstanding asynchronous requests.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_TIMEOUT       The controller has been reset.
+  @retval Others            The controller could not be reset.
+
+**/
+EFI_STATUS
+NvmeRecoverFromTimeout (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
+/**
+  Carve the PRP list pools of the I/O queues out of the last pages of
+  Private->Buffer.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+**/
+VOID
+NvmeInitPrpPools (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
+/**
+  Return a pooled PRP list to the pool of its I/O queue.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] QueueId        The I/O queue the PRP list belongs to.
+  @param[in] PoolIndex      The index of the PRP list in the pool, or
+                            NVME_PRP_POOL_NONE.
+
+**/
+VOID
+NvmeReleasePrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT16                        QueueId,
+  IN UINT16                        PoolIndex
+  );
+
+/**
+  Account the latency of a completed I/O command.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] DptrType       How the data buffer of the command was described.
+  @param[in] SubmitTick     The performance counter when the command was
+                            submitted.
+
+**/
+VOID
+NvmeRecordLatency (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN NVME_DPTR_TYPE                DptrType,
+  IN UINT64                        SubmitTick
+  );
+
+/**
+  Dump the I/O command latency statistics of the controller.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+**/
+VOID
+NvmeDumpLatencyStats (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
@@ -141,6 +141,139 @@ WriteSectors (
   return Status;
 }
 
+/**
+  Wait for a blocking read or write request that has been split into
+  asynchronous subtasks.
+
+  The asynchronous I/O queues are polled directly instead of waiting for the
+  periodic timer, so that the next subtasks are submitted as soon as queue
+  entries become free.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Token                  The token of the request. Its event must not
+                                 have a notification function.
+
+  @retval EFI_SUCCESS            All the subtasks completed successfully.
+  @retval EFI_TIMEOUT            No command completed within NVME_GENERIC_TIMEOUT
+                                 and the controller has been reset.
+  @retval Others                 A subtask failed.
+
+**/
+STATIC
+EFI_STATUS
+NvmeWaitForSplitRequest (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN EFI_BLOCK_IO2_TOKEN       *Token
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA  *Private;
+  EFI_EVENT                     TimerEvent;
+  EFI_STATUS                    Status;
+  EFI_TPL                       OldTpl;
+  UINTN                         Completions;
+  UINTN                         LastCompletions;
+
+  Private = Device->Controller;
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  LastCompletions = Private->AsyncCompletions;
+  gBS->SetTimer (TimerEvent, TimerRelative, NVME_GENERIC_TIMEOUT);
+
+  Status = EFI_SUCCESS;
+  while (EFI_ERROR (gBS->CheckEvent (Token->Event))) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    ProcessAsyncTaskList (NULL, Private);
+    Completions = Private->AsyncCompletions;
+    gBS->RestoreTPL (OldTpl);
+
+    //
+    // The timeout only expires when the controller stops making progress.
+    //
+    if (Completions != LastCompletions) {
+      LastCompletions = Completions;
+      gBS->SetTimer (TimerEvent, TimerRelative, NVME_GENERIC_TIMEOUT);
+      continue;
+    }
+
+    if (!EFI_ERROR (gBS->CheckEvent (TimerEvent))) {
+      DEBUG ((DEBUG_ERROR, "%a: Timeout occurs for an NVMe command.\n", __func__));
+      Status = NvmeRecoverFromTimeout (Private);
+      if (Status != EFI_TIMEOUT) {
+        //
+        // Even if the reset failed, no subtask may refer to the caller's
+        // token any more.
+        //
+        AbortAsyncPassThruTasks (Private);
+        Status = EFI_DEVICE_ERROR;
+      }
+    }
+  }
+
+  gBS->CloseEvent (TimerEvent);
+
+  if (!EFI_ERROR (Status)) {
+    Status = Token->TransactionStatus;
+  }
+
+  return Status;
+}
+
+/**
+  Read or write a range of blocks with several commands in flight.
+
+  The range is split into commands of the maximum data transfer size, which
+  are spread over the asynchronous I/O queues, and the call returns after all
+  of them completed.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer to transfer the data from or to.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  IsWrite                TRUE to write to the device, FALSE to read.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+STATIC
+EFI_STATUS
+NvmeSplitTransfer (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks,
+  IN BOOLEAN                   IsWrite
+  )
+{
+  EFI_BLOCK_IO2_TOKEN  Token;
+  EFI_STATUS           Status;
+
+  Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Token.Event);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Token.TransactionStatus = EFI_SUCCESS;
+
+  if (IsWrite) {
+    Status = NvmeAsyncWrite (Device, Buffer, Lba, Blocks, &Token);
+  } else {
+    Status = NvmeAsyncRead (Device, Buffer, Lba, Blocks, &Token);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = NvmeWaitForSplitRequest (Device, &Token);
+  }
+
+  gBS->CloseEvent (Token.Event);
+
+  return Status;
+}
+
 /**
   Read some blocks from the device.
 
@@ -195,21 +328,17 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
-    if (Blocks > MaxTransferBlocks) {
-      Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
-
-      Blocks -= MaxTransferBlocks;
-      Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + MaxTransferBlocks * BlockSize);
-      Lba    += MaxTransferBlocks;
-    } else {
-      Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
-      Blocks = 0;
-    }
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Keep several commands of the maximum transfer size in flight.
+    //
+    Status = NvmeSplitTransfer (Device, Buffer, Lba, Blocks, FALSE);
+  } else {
+    Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
+  }
 
-    if (EFI_ERROR (Status)) {
-      break;
-    }
+  if (!EFI_ERROR (Status)) {
+    Blocks = 0;
   }
 
   DEBUG ((
@@ -281,21 +410,17 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
-    if (Blocks > MaxTransferBlocks) {
-      Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
-
-      Blocks -= MaxTransferBlocks;
-      Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + MaxTransferBlocks * BlockSize);
-      Lba    += MaxTransferBlocks;
-    } else {
-      Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
-      Blocks = 0;
-    }
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Keep several commands of the maximum transfer size in flight.
+    //
+    Status = NvmeSplitTransfer (Device, Buffer, Lba, Blocks, TRUE);
+  } else {
+    Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
+  }
 
-    if (EFI_ERROR (Status)) {
-      break;
-    }
+  if (!EFI_ERROR (Status)) {
+    Blocks = 0;
   }
 
   DEBUG ((
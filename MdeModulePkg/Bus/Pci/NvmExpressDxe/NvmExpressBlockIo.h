@@ -8,6 +8,53 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #pragma once
 
+/**
+  Read some blocks from the device in an asynchronous manner.
+
+  @param  Device        The pointer to the NVME_DEVICE_PRIVATE_DATA data
+                        structure.
+  @param  Buffer        The buffer used to store the data read from the device.
+  @param  Lba           The start block number.
+  @param  Blocks        Total block number to be read.
+  @param  Token         A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS   Data are read from the device.
+  @retval Others        Fail to read all the data.
+
+**/
+EFI_STATUS
+NvmeAsyncRead (
+  IN     NVME_DEVICE_PRIVATE_DATA  *Device,
+  OUT VOID                         *Buffer,
+  IN     UINT64                    Lba,
+  IN     UINTN                     Blocks,
+  IN     EFI_BLOCK_IO2_TOKEN       *Token
+  );
+
+/**
+  Write some blocks from the device in an asynchronous manner.
+
+  @param  Device        The pointer to the NVME_DEVICE_PRIVATE_DATA data
+                        structure.
+  @param  Buffer        The buffer used to store the data written to the
+                        device.
+  @param  Lba           The start block number.
+  @param  Blocks        Total block number to be written.
+  @param  Token         A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS   Data are written to the device.
+  @retval Others        Fail to write all the data.
+
+**/
+EFI_STATUS
+NvmeAsyncWrite (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks,
+  IN EFI_BLOCK_IO2_TOKEN       *Token
+  );
+
 /**
   Reset the Block Device.
 
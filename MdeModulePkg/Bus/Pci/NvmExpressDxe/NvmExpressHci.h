@@ -17,6 +17,19 @@
 //
 #define NVME_ASQ_BUF_OFFSET  EFI_PAGE_SIZE
 
+/**
+  Get the number of pages taken by the submission and completion queues.
+
+  @param  Private          The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @return The number of pages, starting at Private->Buffer.
+
+**/
+UINTN
+NvmeGetQueuePages (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
 /**
   Initialize the Nvm Express controller.
 
@@ -314,6 +314,324 @@ EXIT:
   return NULL;
 }
 
+/**
+  Carve the PRP list pools of the I/O queues out of the last pages of
+  Private->Buffer.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+**/
+VOID
+NvmeInitPrpPools (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  NVME_PRP_POOL  *Pool;
+  UINTN          Offset;
+  UINT16         QueueId;
+  UINT16         Index;
+
+  Offset = EFI_PAGES_TO_SIZE (Private->QueuePages);
+  ZeroMem (Private->PrpPool, sizeof (Private->PrpPool));
+
+  for (QueueId = 1; QueueId < NVME_ASYNC_QUEUE_BASE + Private->AsyncQueueNum; QueueId++) {
+    Pool          = &Private->PrpPool[QueueId];
+    Pool->Host    = Private->Buffer + Offset;
+    Pool->PciAddr = (EFI_PHYSICAL_ADDRESS)(UINTN)(Private->BufferPciAddr + Offset);
+    //
+    // The synchronous I/O queue has a single command in flight.
+    //
+    Pool->Pages = (QueueId < NVME_ASYNC_QUEUE_BASE) ? 1 : NVME_PRP_POOL_SIZE;
+    for (Index = 0; Index < Pool->Pages; Index++) {
+      Pool->Free[Index] = (UINT16)(Pool->Pages - 1 - Index);
+    }
+
+    Pool->FreeCount = Pool->Pages;
+    Offset         += EFI_PAGES_TO_SIZE (Pool->Pages);
+  }
+
+  ASSERT (Offset <= EFI_PAGES_TO_SIZE (Private->BufferPages));
+}
+
+/**
+  Build the PRP list of a command in a page taken from the pool of its I/O
+  queue.
+
+  @param[in]  Private       The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in]  QueueId       The I/O queue the command is submitted to.
+  @param[in]  PhysicalAddr  The physical base address of data buffer.
+  @param[in]  Pages         The number of pages to be transfered.
+  @param[out] PoolIndex     The index of the PRP list in the pool.
+
+  @return The device address of the PRP list, or NULL if the PRP entries do
+          not fit into one page or the pool is exhausted.
+
+**/
+STATIC
+VOID *
+NvmeAcquirePrpList (
+  IN  NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN  UINT16                        QueueId,
+  IN  EFI_PHYSICAL_ADDRESS          PhysicalAddr,
+  IN  UINTN                         Pages,
+  OUT UINT16                        *PoolIndex
+  )
+{
+  NVME_PRP_POOL  *Pool;
+  UINT64         *PrpList;
+  UINTN          Index;
+  EFI_TPL        OldTpl;
+
+  Pool       = &Private->PrpPool[QueueId];
+  *PoolIndex = NVME_PRP_POOL_NONE;
+
+  if (Pages > EFI_PAGE_SIZE / sizeof (UINT64)) {
+    return NULL;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Pool->FreeCount != 0) {
+    *PoolIndex = Pool->Free[--Pool->FreeCount];
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (*PoolIndex == NVME_PRP_POOL_NONE) {
+    return NULL;
+  }
+
+  PrpList = (UINT64 *)(Pool->Host + EFI_PAGES_TO_SIZE (*PoolIndex));
+  for (Index = 0; Index < Pages; Index++) {
+    PrpList[Index] = PhysicalAddr;
+    PhysicalAddr  += EFI_PAGE_SIZE;
+  }
+
+  return (VOID *)(UINTN)(Pool->PciAddr + EFI_PAGES_TO_SIZE (*PoolIndex));
+}
+
+/**
+  Return a pooled PRP list to the pool of its I/O queue.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] QueueId        The I/O queue the PRP list belongs to.
+  @param[in] PoolIndex      The index of the PRP list in the pool, or
+                            NVME_PRP_POOL_NONE.
+
+**/
+VOID
+NvmeReleasePrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT16                        QueueId,
+  IN UINT16                        PoolIndex
+  )
+{
+  NVME_PRP_POOL  *Pool;
+  EFI_TPL        OldTpl;
+
+  if (PoolIndex == NVME_PRP_POOL_NONE) {
+    return;
+  }
+
+  Pool = &Private->PrpPool[QueueId];
+  ASSERT (PoolIndex < Pool->Pages);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  ASSERT (Pool->FreeCount < Pool->Pages);
+  Pool->Free[Pool->FreeCount++] = PoolIndex;
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Check whether the data buffer of a command can be described by a single SGL
+  Data Block descriptor instead of a PRP list.
+
+  Only the NVM read and write commands on the I/O queues are considered, as SGL
+  support for admin commands is optional and other I/O commands may not
+  support it even if the controller advertises SGLs.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] QueueId        The queue the command is submitted to.
+  @param[in] Sq             The submission queue entry of the command.
+  @param[in] PhysicalAddr   The mapped address of the data buffer.
+  @param[in] Bytes          The length of the data buffer.
+
+  @retval TRUE              An SGL Data Block descriptor can be used.
+  @retval FALSE             A PRP list has to be used.
+
+**/
+STATIC
+BOOLEAN
+NvmeCanUseSgl (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN UINT16                        QueueId,
+  IN NVME_SQ                       *Sq,
+  IN EFI_PHYSICAL_ADDRESS          PhysicalAddr,
+  IN UINT32                        Bytes
+  )
+{
+  UINT32  Sgls;
+
+  if ((QueueId == 0) ||
+      ((Sq->Opc != NVME_IO_READ_OPC) && (Sq->Opc != NVME_IO_WRITE_OPC)))
+  {
+    return FALSE;
+  }
+
+  Sgls = Private->ControllerData->Sgls & NVME_SGLS_SUPPORT_MASK;
+  if (Sgls == NVME_SGLS_SUPPORTED) {
+    return TRUE;
+  }
+
+  if (Sgls == NVME_SGLS_SUPPORTED_DWORD) {
+    return (BOOLEAN)((((UINTN)PhysicalAddr | Bytes) & (sizeof (UINT32) - 1)) == 0);
+  }
+
+  return FALSE;
+}
+
+/**
+  Account the latency of a completed I/O command.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] DptrType       How the data buffer of the command was described.
+  @param[in] SubmitTick     The performance counter when the command was
+                            submitted.
+
+**/
+VOID
+NvmeRecordLatency (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN NVME_DPTR_TYPE                DptrType,
+  IN UINT64                        SubmitTick
+  )
+{
+  NVME_LATENCY_STATS  *Stats;
+  UINT64              Now;
+  UINT64              StartValue;
+  UINT64              EndValue;
+  UINT64              Ns;
+  EFI_TPL             OldTpl;
+
+  Now = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  if (StartValue > EndValue) {
+    Ns = GetTimeInNanoSecond (SubmitTick - Now);
+  } else {
+    Ns = GetTimeInNanoSecond (Now - SubmitTick);
+  }
+
+  ASSERT (DptrType < NvmeDptrMax);
+  Stats = &Private->Latency[DptrType];
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if ((Stats->Commands == 0) || (Ns < Stats->MinNs)) {
+    Stats->MinNs = Ns;
+  }
+
+  if (Ns > Stats->MaxNs) {
+    Stats->MaxNs = Ns;
+  }
+
+  Stats->Commands++;
+  Stats->TotalNs += Ns;
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Dump the I/O command latency statistics of the controller.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+**/
+VOID
+NvmeDumpLatencyStats (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  STATIC CONST CHAR8  *DptrName[NvmeDptrMax] = {
+    "PRP",
+    "PRP list (pooled)",
+    "PRP list (allocated)",
+    "SGL"
+  };
+  NVME_LATENCY_STATS  *Stats;
+  UINTN               Index;
+
+  for (Index = 0; Index < NvmeDptrMax; Index++) {
+    Stats = &Private->Latency[Index];
+    if (Stats->Commands == 0) {
+      continue;
+    }
+
+    DEBUG ((
+      DEBUG_INFO,
+      "NVMe I/O latency %a: %ld commands, avg %ld ns, min %ld ns, max %ld ns\n",
+      DptrName[Index],
+      Stats->Commands,
+      DivU64x64Remainder (Stats->TotalNs, Stats->Commands, NULL),
+      Stats->MinNs,
+      Stats->MaxNs
+      ));
+  }
+}
+
+/**
+  Select the asynchronous I/O queue pair with the fewest outstanding commands.
+
+  At most AsyncQueueSize commands are kept outstanding on a queue pair, so that
+  neither its submission queue nor its completion queue can overflow.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @return The identifier of the selected queue pair, or 0 if all of them are
+          full.
+
+**/
+STATIC
+UINT16
+NvmeSelectAsyncQueue (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  UINT16  QueueId;
+  UINT16  QueueSize;
+  UINT16  Selected;
+
+  QueueSize = Private->AsyncQueueSize + 1;
+  Selected  = 0;
+
+  for (QueueId = NVME_ASYNC_QUEUE_BASE;
+       QueueId < NVME_ASYNC_QUEUE_BASE + Private->AsyncQueueNum;
+       QueueId++)
+  {
+    if (Private->AsyncOutstanding[QueueId] >= Private->AsyncQueueSize) {
+      continue;
+    }
+
+    //
+    // Submission queue full check.
+    //
+    if ((Private->SqTdbl[QueueId].Sqt + 1) % QueueSize == Private->AsyncSqHead[QueueId]) {
+      continue;
+    }
+
+    if ((Selected == 0) ||
+        (Private->AsyncOutstanding[QueueId] < Private->AsyncOutstanding[Selected]))
+    {
+      Selected = QueueId;
+    }
+  }
+
+  return Selected;
+}
+
 /**
   Aborts the asynchronous PassThru requests.
 
@@ -396,6 +714,8 @@ AbortAsyncPassThruTasks (
                );
     }
 
+    NvmeReleasePrpList (Private, AsyncRequest->QueueId, AsyncRequest->PrpPoolIndex);
+
     RemoveEntryList (Link);
     gBS->SignalEvent (AsyncRequest->CallerEvent);
     FreePool (AsyncRequest);
@@ -414,6 +734,61 @@ AbortAsyncPassThruTasks (
   return Status;
 }
 
+/**
+  Reset the NVMe controller after a command timed out, and abort the
+  outstanding asynchronous requests.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_TIMEOUT       The controller has been reset.
+  @retval Others            The controller could not be reset.
+
+**/
+EFI_STATUS
+NvmeRecoverFromTimeout (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  EFI_STATUS  Status;
+
+  ReportStatusCode ((EFI_ERROR_MAJOR | EFI_ERROR_CODE), (EFI_IO_BUS_SCSI | EFI_IOB_EC_INTERFACE_ERROR));
+
+  //
+  // Disable the timer to trigger the process of async transfers temporarily.
+  //
+  Status = gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Reset the NVMe controller.
+  //
+  Status = NvmeControllerInit (Private);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = AbortAsyncPassThruTasks (Private);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Re-enable the timer to trigger the process of async transfers.
+  //
+  Status = gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Return EFI_TIMEOUT to indicate a timeout occurs for NVMe PassThru command.
+  //
+  return EFI_TIMEOUT;
+}
+
 /**
   Sends an NVM Express Command Packet to an NVM Express controller or namespace. This function supports
   both blocking I/O and non-blocking I/O. The blocking I/O functionality is required, and the non-blocking
@@ -475,6 +850,10 @@ NvmExpressPassThru (
   UINT64                         *Prp;
   VOID                           *PrpListHost;
   UINTN                          PrpListNo;
+  UINT16                         PrpPoolIndex;
+  NVME_SGL_DESCRIPTOR            Sgl;
+  NVME_DPTR_TYPE                 DptrType;
+  UINT64                         SubmitTick;
   UINT32                         Attributes;
   UINT32                         IoAlign;
   UINT32                         MaxTransLen;
@@ -544,16 +923,22 @@ NvmExpressPassThru (
     }
   }
 
-  PciIo       = Private->PciIo;
-  MapData     = NULL;
-  MapMeta     = NULL;
-  MapPrpList  = NULL;
-  PrpListHost = NULL;
-  PrpListNo   = 0;
-  Prp         = NULL;
-  TimerEvent  = NULL;
-  Status      = EFI_SUCCESS;
-  QueueSize   = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
+  PciIo        = Private->PciIo;
+  MapData      = NULL;
+  MapMeta      = NULL;
+  MapPrpList   = NULL;
+  PrpListHost  = NULL;
+  PrpListNo    = 0;
+  PrpPoolIndex = NVME_PRP_POOL_NONE;
+  DptrType     = NvmeDptrPrp;
+  Prp          = NULL;
+  TimerEvent   = NULL;
+  Status       = EFI_SUCCESS;
+  QueueSize    = Private->AsyncQueueSize + 1;
+
+  if (Packet->NvmeCmd->Nsid != NamespaceId) {
+    return EFI_INVALID_PARAMETER;
+  }
 
   if (Packet->QueueType == NVME_ADMIN_QUEUE) {
     QueueId = 0;
@@ -561,14 +946,14 @@ NvmExpressPassThru (
     if (Event == NULL) {
       QueueId = 1;
     } else {
-      QueueId = 2;
-
       //
-      // Submission queue full check.
+      // The asynchronous I/O queues are shared with the completion handler
+      // that runs at TPL_NOTIFY, so the command is submitted at that level.
       //
-      if ((Private->SqTdbl[QueueId].Sqt + 1) % QueueSize ==
-          Private->AsyncSqHead)
-      {
+      OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+      QueueId = NvmeSelectAsyncQueue (Private);
+      if (QueueId == 0) {
+        gBS->RestoreTPL (OldTpl);
         return EFI_NOT_READY;
       }
     }
@@ -577,24 +962,13 @@ NvmExpressPassThru (
   Sq = Private->SqBuffer[QueueId] + Private->SqTdbl[QueueId].Sqt;
   Cq = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
 
-  if (Packet->NvmeCmd->Nsid != NamespaceId) {
-    return EFI_INVALID_PARAMETER;
-  }
-
   ZeroMem (Sq, sizeof (NVME_SQ));
   Sq->Opc  = (UINT8)Packet->NvmeCmd->Cdw0.Opcode;
   Sq->Fuse = (UINT8)Packet->NvmeCmd->Cdw0.FusedOperation;
   Sq->Cid  = Private->Cid[QueueId]++;
   Sq->Nsid = Packet->NvmeCmd->Nsid;
 
-  //
-  // Currently we only support PRP for data transfer, SGL is NOT supported.
-  //
-  ASSERT (Sq->Psdt == 0);
-  if (Sq->Psdt != 0) {
-    DEBUG ((DEBUG_ERROR, "NvmExpressPassThru: doesn't support SGL mechanism\n"));
-    return EFI_UNSUPPORTED;
-  }
+  Sq->Psdt = NVME_PSDT_PRP;
 
   Sq->Prp[0] = (UINT64)(UINTN)Packet->TransferBuffer;
   if ((Packet->QueueType == NVME_ADMIN_QUEUE) &&
@@ -618,7 +992,8 @@ NvmExpressPassThru (
     if (((Packet->TransferLength != 0) && (Packet->TransferBuffer == NULL)) ||
         ((Packet->TransferLength == 0) && (Packet->TransferBuffer != NULL)))
     {
-      return EFI_INVALID_PARAMETER;
+      Status = EFI_INVALID_PARAMETER;
+      goto EXIT;
     }
 
     if ((Sq->Opc & BIT0) != 0) {
@@ -638,7 +1013,8 @@ NvmExpressPassThru (
                            &MapData
                            );
       if (EFI_ERROR (Status) || (Packet->TransferLength != MapLength)) {
-        return EFI_OUT_OF_RESOURCES;
+        Status = EFI_OUT_OF_RESOURCES;
+        goto EXIT;
       }
 
       Sq->Prp[0] = PhyAddr;
@@ -656,12 +1032,8 @@ NvmExpressPassThru (
                            &MapMeta
                            );
       if (EFI_ERROR (Status) || (Packet->MetadataLength != MapLength)) {
-        PciIo->Unmap (
-                 PciIo,
-                 MapData
-                 );
-
-        return EFI_OUT_OF_RESOURCES;
+        Status = EFI_OUT_OF_RESOURCES;
+        goto EXIT;
       }
 
       Sq->Mptr = PhyAddr;
@@ -670,20 +1042,47 @@ NvmExpressPassThru (
 
   //
   // If the buffer size spans more than two memory pages (page size as defined in CC.Mps),
-  // then build a PRP list in the second PRP submission queue entry.
+  // then describe it with one SGL Data Block descriptor if the controller supports it,
+  // or build a PRP list in the second PRP submission queue entry.
   //
   Offset = ((UINT16)Sq->Prp[0]) & (EFI_PAGE_SIZE - 1);
   Bytes  = Packet->TransferLength;
 
-  if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
+  if (((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) &&
+      NvmeCanUseSgl (Private, QueueId, Sq, Sq->Prp[0], Bytes))
+  {
+    //
+    // The mapped data buffer is contiguous, so the descriptor replaces the
+    // whole PRP list. The metadata pointer keeps addressing a contiguous
+    // buffer.
+    //
+    ZeroMem (&Sgl, sizeof (Sgl));
+    Sgl.Address = Sq->Prp[0];
+    Sgl.Length  = Bytes;
+    Sgl.Type    = NVME_SGL_TYPE_DATA_BLOCK;
+    CopyMem (Sq->Prp, &Sgl, sizeof (Sgl));
+    Sq->Psdt = NVME_PSDT_SGL_MPTR_BUFFER;
+    DptrType = NvmeDptrSgl;
+  } else if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
     //
-    // Create PrpList for remaining data buffer.
+    // Create PrpList for remaining data buffer. I/O commands take it from the
+    // pool of their queue if possible.
     //
     PhyAddr = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
-    Prp     = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES (Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+    DptrType = NvmeDptrPrpPool;
+    if (QueueId != 0) {
+      Prp = NvmeAcquirePrpList (Private, QueueId, PhyAddr, EFI_SIZE_TO_PAGES (Offset + Bytes) - 1, &PrpPoolIndex);
+    }
+
     if (Prp == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto EXIT;
+      DptrType = NvmeDptrPrpAlloc;
+      Prp      = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES (Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+      if (Prp == NULL) {
+        PrpListHost = NULL;
+        MapPrpList  = NULL;
+        Status      = EFI_OUT_OF_RESOURCES;
+        goto EXIT;
+      }
     }
 
     Sq->Prp[1] = (UINT64)(UINTN)Prp;
@@ -733,15 +1132,16 @@ NvmExpressPassThru (
     Private->SqTdbl[QueueId].Sqt ^= 1;
   }
 
-  Data   = ReadUnaligned32 ((UINT32 *)&Private->SqTdbl[QueueId]);
-  Status = PciIo->Mem.Write (
-                        PciIo,
-                        EfiPciIoWidthUint32,
-                        NVME_BAR,
-                        NVME_SQTDBL_OFFSET (QueueId, Private->Cap.Dstrd),
-                        1,
-                        &Data
-                        );
+  Data       = ReadUnaligned32 ((UINT32 *)&Private->SqTdbl[QueueId]);
+  SubmitTick = GetPerformanceCounter ();
+  Status     = PciIo->Mem.Write (
+                            PciIo,
+                            EfiPciIoWidthUint32,
+                            NVME_BAR,
+                            NVME_SQTDBL_OFFSET (QueueId, Private->Cap.Dstrd),
+                            1,
+                            &Data
+                            );
 
   if (EFI_ERROR (Status)) {
     goto EXIT;
@@ -758,18 +1158,22 @@ NvmExpressPassThru (
       goto EXIT;
     }
 
-    AsyncRequest->Signature   = NVME_PASS_THRU_ASYNC_REQ_SIG;
-    AsyncRequest->Packet      = Packet;
-    AsyncRequest->CommandId   = Sq->Cid;
-    AsyncRequest->CallerEvent = Event;
-    AsyncRequest->MapData     = MapData;
-    AsyncRequest->MapMeta     = MapMeta;
-    AsyncRequest->MapPrpList  = MapPrpList;
-    AsyncRequest->PrpListNo   = PrpListNo;
-    AsyncRequest->PrpListHost = PrpListHost;
-
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    AsyncRequest->Signature    = NVME_PASS_THRU_ASYNC_REQ_SIG;
+    AsyncRequest->Packet       = Packet;
+    AsyncRequest->QueueId      = QueueId;
+    AsyncRequest->CommandId    = Sq->Cid;
+    AsyncRequest->PrpPoolIndex = PrpPoolIndex;
+    AsyncRequest->DptrType     = DptrType;
+    AsyncRequest->SubmitTick   = SubmitTick;
+    AsyncRequest->CallerEvent  = Event;
+    AsyncRequest->MapData      = MapData;
+    AsyncRequest->MapMeta      = MapMeta;
+    AsyncRequest->MapPrpList   = MapPrpList;
+    AsyncRequest->PrpListNo    = PrpListNo;
+    AsyncRequest->PrpListHost  = PrpListHost;
+
     InsertTailList (&Private->AsyncPassThruQueue, &AsyncRequest->Link);
+    Private->AsyncOutstanding[QueueId]++;
     gBS->RestoreTPL (OldTpl);
 
     return EFI_SUCCESS;
@@ -807,6 +1211,10 @@ NvmExpressPassThru (
   // Check the NVMe cmd execution result
   //
   if (Status != EFI_TIMEOUT) {
+    if (QueueId != 0) {
+      NvmeRecordLatency (Private, DptrType, SubmitTick);
+    }
+
     if ((Cq->Sct == 0) && (Cq->Sc == 0)) {
       Status = EFI_SUCCESS;
     } else {
@@ -824,44 +1232,13 @@ NvmExpressPassThru (
     //
     CopyMem (Packet->NvmeCompletion, (VOID *)Cq, sizeof (EFI_NVM_EXPRESS_COMPLETION));
   } else {
-    ReportStatusCode ((EFI_ERROR_MAJOR | EFI_ERROR_CODE), (EFI_IO_BUS_SCSI | EFI_IOB_EC_INTERFACE_ERROR));
-
     //
     // Timeout occurs for an NVMe command. Reset the controller to abort the
     // outstanding commands.
     //
     DEBUG ((DEBUG_ERROR, "NvmExpressPassThru: Timeout occurs for an NVMe command.\n"));
 
-    //
-    // Disable the timer to trigger the process of async transfers temporarily.
-    //
-    Status = gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
-    if (EFI_ERROR (Status)) {
-      goto EXIT;
-    }
-
-    //
-    // Reset the NVMe controller.
-    //
-    Status = NvmeControllerInit (Private);
-    if (!EFI_ERROR (Status)) {
-      Status = AbortAsyncPassThruTasks (Private);
-      if (!EFI_ERROR (Status)) {
-        //
-        // Re-enable the timer to trigger the process of async transfers.
-        //
-        Status = gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
-        if (!EFI_ERROR (Status)) {
-          //
-          // Return EFI_TIMEOUT to indicate a timeout occurs for NVMe PassThru command.
-          //
-          Status = EFI_TIMEOUT;
-        }
-      }
-    } else {
-      Status = EFI_DEVICE_ERROR;
-    }
-
+    Status = NvmeRecoverFromTimeout (Private);
     goto EXIT;
   }
 
@@ -914,14 +1291,20 @@ EXIT:
              );
   }
 
-  if (Prp != NULL) {
+  if (PrpListHost != NULL) {
     PciIo->FreeBuffer (PciIo, PrpListNo, PrpListHost);
   }
 
+  NvmeReleasePrpList (Private, QueueId, PrpPoolIndex);
+
   if (TimerEvent != NULL) {
     gBS->CloseEvent (TimerEvent);
   }
 
+  if ((Event != NULL) && (QueueId != 0)) {
+    gBS->RestoreTPL (OldTpl);
+  }
+
   return Status;
 }
 
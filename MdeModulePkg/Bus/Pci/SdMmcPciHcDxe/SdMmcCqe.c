@@ -0,0 +1,1133 @@
+/** @file
+  This file drives the eMMC Command Queuing Engine (CQE) of SD/MMC host
+  controllers and produces EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL on top of it.
+
+  Refer to EMMC Electrical Standard Spec 5.1 Section 6.6.39 and Appendix B
+  for details.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "SdMmcPciHcDxe.h"
+
+//
+// Argument of CMDQ_TASK_MGMT to discard the entire queue of the device.
+//
+#define EMMC_CMDQ_TM_DISCARD_QUEUE  0x1
+
+/**
+  Read or write a register of the command queuing engine of a slot.
+
+  @param[in]      Private       A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in]      Slot          The slot number.
+  @param[in]      Register      The offset of the register in the CQE register set.
+  @param[in]      Read          A boolean to indicate it's read or write operation.
+  @param[in, out] Data          The value read or to write.
+
+  @retval EFI_SUCCESS           The register is accessed.
+  @retval Others                The register access fails.
+
+**/
+STATIC
+EFI_STATUS
+SdMmcCqeRw (
+  IN     SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN     UINT8                   Slot,
+  IN     UINT32                  Register,
+  IN     BOOLEAN                 Read,
+  IN OUT UINT32                  *Data
+  )
+{
+  return SdMmcHcRwMmio (
+           Private->PciIo,
+           Slot,
+           PcdGet32 (PcdSdMmcCqeRegisterOffset) + Register,
+           Read,
+           sizeof (UINT32),
+           Data
+           );
+}
+
+/**
+  Get the time elapsed since a performance counter value.
+
+  @param[in] StartTick          The performance counter value to start from.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+STATIC
+UINT64
+SdMmcCqeElapsedTime (
+  IN UINT64  StartTick
+  )
+{
+  UINT64  Now;
+  UINT64  StartValue;
+  UINT64  EndValue;
+
+  Now = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  if (StartValue > EndValue) {
+    return GetTimeInNanoSecond (StartTick - Now);
+  }
+
+  return GetTimeInNanoSecond (Now - StartTick);
+}
+
+/**
+  Halt the command queuing engine of a slot.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+  @retval EFI_SUCCESS           The engine is halted.
+  @retval Others                The engine can't be halted.
+
+**/
+STATIC
+EFI_STATUS
+SdMmcCqeHalt (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Control;
+
+  Control = SD_MMC_CQE_CTL_HALT;
+  Status  = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CTL, FALSE, &Control);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return SdMmcHcWaitMmioSet (
+           Private->PciIo,
+           Slot,
+           PcdGet32 (PcdSdMmcCqeRegisterOffset) + SD_MMC_CQE_CTL,
+           sizeof (UINT32),
+           SD_MMC_CQE_CTL_HALT,
+           SD_MMC_CQE_CTL_HALT,
+           SD_MMC_HC_GENERIC_TIMEOUT
+           );
+}
+
+/**
+  Complete a task of the command queuing engine of a slot.
+
+  It should be called at TPL_NOTIFY.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+  @param[in] Tag                The task to complete.
+  @param[in] Status             The result of the task.
+
+**/
+STATIC
+VOID
+SdMmcCqeCompleteTask (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot,
+  IN UINT8                   Tag,
+  IN EFI_STATUS              Status
+  )
+{
+  SD_MMC_CQE                          *Cqe;
+  SD_MMC_CQE_TASK                     *Task;
+  EDKII_SD_MMC_COMMAND_QUEUE_REQUEST  *Request;
+  EFI_EVENT                           Event;
+
+  Cqe  = &Private->Cqe[Slot];
+  Task = &Cqe->Task[Tag];
+
+  ASSERT ((Cqe->Outstanding & (1U << Tag)) != 0);
+
+  Private->PciIo->Unmap (Private->PciIo, Task->DataMap);
+
+  Request = Task->Request;
+  Event   = Task->Event;
+  ZeroMem (Task, sizeof (SD_MMC_CQE_TASK));
+
+  if (EFI_ERROR (Status)) {
+    Cqe->Statistics.FailedRequests++;
+  } else {
+    Cqe->Statistics.CompletedRequests++;
+    Cqe->Statistics.TransferredBytes += MultU64x32 (Request->BlockCount, SD_MMC_CQE_BLOCK_SIZE);
+  }
+
+  Cqe->Outstanding &= ~(1U << Tag);
+  if (Cqe->Outstanding == 0) {
+    Cqe->Statistics.BusyTime += SdMmcCqeElapsedTime (Cqe->BusyStartTick);
+  }
+
+  Request->TransactionStatus = Status;
+  if (Event != NULL) {
+    gBS->SignalEvent (Event);
+  }
+}
+
+/**
+  Stop the command queuing engine of a slot and fail all the tasks in flight.
+
+  The device is left in command queue mode, it is taken out of it with the
+  failed tasks discarded by SdMmcCqeLeave(). It should be called at TPL_NOTIFY.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+  @param[in] Status             The result to report for the tasks in flight.
+
+**/
+VOID
+SdMmcCqeAbortTasks (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot,
+  IN EFI_STATUS              Status
+  )
+{
+  SD_MMC_CQE  *Cqe;
+  UINT32      Value;
+  UINT16      IntStatus;
+  UINT8       Tag;
+
+  Cqe = &Private->Cqe[Slot];
+  if (!Cqe->Enabled) {
+    return;
+  }
+
+  SdMmcCqeHalt (Private, Slot);
+
+  Value = SD_MMC_CQE_CTL_HALT | SD_MMC_CQE_CTL_CLEAR_ALL;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CTL, FALSE, &Value);
+  SdMmcHcWaitMmioSet (
+    Private->PciIo,
+    Slot,
+    PcdGet32 (PcdSdMmcCqeRegisterOffset) + SD_MMC_CQE_TDBR,
+    sizeof (UINT32),
+    MAX_UINT32,
+    0,
+    SD_MMC_HC_GENERIC_TIMEOUT
+    );
+
+  Value = 0;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CFG, FALSE, &Value);
+
+  //
+  // Reset both the CMD and the DAT lines as a transfer may have been cut
+  // short, then clear the status the engine left behind.
+  //
+  SdMmcSoftwareReset (Private, Slot, 0x7F);
+  IntStatus = 0xFFFF;
+  SdMmcHcRwMmio (Private->PciIo, Slot, SD_MMC_HC_ERR_INT_STS, FALSE, sizeof (IntStatus), &IntStatus);
+  IntStatus = 0xFF3F;
+  SdMmcHcRwMmio (Private->PciIo, Slot, SD_MMC_HC_NOR_INT_STS, FALSE, sizeof (IntStatus), &IntStatus);
+  Value = MAX_UINT32;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_IS, FALSE, &Value);
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_TCN, FALSE, &Value);
+
+  Cqe->Enabled = FALSE;
+  Cqe->Failed  = TRUE;
+
+  for (Tag = 0; Tag < SD_MMC_CQE_MAX_TASKS; Tag++) {
+    if ((Cqe->Outstanding & (1U << Tag)) != 0) {
+      SdMmcCqeCompleteTask (Private, Slot, Tag, Status);
+    }
+  }
+}
+
+/**
+  Complete the tasks the command queuing engine of a slot has finished, and
+  check for errors and timeouts.
+
+  It should be called at TPL_NOTIFY.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+**/
+VOID
+SdMmcCqeCheckTasks (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  SD_MMC_CQE       *Cqe;
+  SD_MMC_CQE_TASK  *Task;
+  EFI_STATUS       Status;
+  UINT32           IntStatus;
+  UINT32           TaskError;
+  UINT32           Completed;
+  UINT16           ErrIntStatus;
+  UINT8            Tag;
+
+  Cqe = &Private->Cqe[Slot];
+  if (!Cqe->Enabled || (Cqe->Outstanding == 0)) {
+    return;
+  }
+
+  IntStatus    = 0;
+  TaskError    = 0;
+  ErrIntStatus = 0;
+  Status       = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_IS, TRUE, &IntStatus);
+  if (!EFI_ERROR (Status)) {
+    Status = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_TERRI, TRUE, &TaskError);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = SdMmcHcRwMmio (Private->PciIo, Slot, SD_MMC_HC_ERR_INT_STS, TRUE, sizeof (ErrIntStatus), &ErrIntStatus);
+  }
+
+  if (EFI_ERROR (Status) ||
+      ((IntStatus & SD_MMC_CQE_IS_RESPONSE_ERROR) != 0) ||
+      ((TaskError & (SD_MMC_CQE_TERRI_RESP_VALID | SD_MMC_CQE_TERRI_DATA_VALID)) != 0) ||
+      (ErrIntStatus != 0))
+  {
+    DEBUG ((
+      DEBUG_ERROR,
+      "SdMmcCqeCheckTasks: Slot[%d] CQIS %08x CQTERRI %08x ErrIntStatus %04x, abort the queue\n",
+      Slot,
+      IntStatus,
+      TaskError,
+      ErrIntStatus
+      ));
+    SdMmcCqeAbortTasks (Private, Slot, EFI_DEVICE_ERROR);
+    return;
+  }
+
+  if (IntStatus != 0) {
+    SdMmcCqeRw (Private, Slot, SD_MMC_CQE_IS, FALSE, &IntStatus);
+  }
+
+  Completed = 0;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_TCN, TRUE, &Completed);
+  Completed &= Cqe->Outstanding;
+  if (Completed != 0) {
+    SdMmcCqeRw (Private, Slot, SD_MMC_CQE_TCN, FALSE, &Completed);
+    for (Tag = 0; Tag < SD_MMC_CQE_MAX_TASKS; Tag++) {
+      if ((Completed & (1U << Tag)) != 0) {
+        SdMmcCqeCompleteTask (Private, Slot, Tag, EFI_SUCCESS);
+      }
+    }
+  }
+
+  for (Tag = 0; Tag < SD_MMC_CQE_MAX_TASKS; Tag++) {
+    if ((Cqe->Outstanding & (1U << Tag)) == 0) {
+      continue;
+    }
+
+    Task = &Cqe->Task[Tag];
+    if ((Task->Request->Timeout != 0) &&
+        (SdMmcCqeElapsedTime (Task->SubmitTick) > MultU64x32 (Task->Request->Timeout, 1000)))
+    {
+      DEBUG ((DEBUG_ERROR, "SdMmcCqeCheckTasks: Slot[%d] task %d times out, abort the queue\n", Slot, Tag));
+      SdMmcCqeAbortTasks (Private, Slot, EFI_TIMEOUT);
+      return;
+    }
+  }
+}
+
+/**
+  Send command CMDQ_TASK_MGMT to the device to discard its entire queue.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+  @retval EFI_SUCCESS           The queue is discarded.
+  @retval Others                The operation fails.
+
+**/
+STATIC
+EFI_STATUS
+SdMmcCqeDiscardQueue (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  EFI_SD_MMC_COMMAND_BLOCK             SdMmcCmdBlk;
+  EFI_SD_MMC_STATUS_BLOCK              SdMmcStatusBlk;
+  EFI_SD_MMC_PASS_THRU_COMMAND_PACKET  Packet;
+
+  ZeroMem (&SdMmcCmdBlk, sizeof (SdMmcCmdBlk));
+  ZeroMem (&SdMmcStatusBlk, sizeof (SdMmcStatusBlk));
+  ZeroMem (&Packet, sizeof (Packet));
+
+  Packet.SdMmcCmdBlk    = &SdMmcCmdBlk;
+  Packet.SdMmcStatusBlk = &SdMmcStatusBlk;
+  Packet.Timeout        = SD_MMC_HC_GENERIC_TIMEOUT;
+
+  SdMmcCmdBlk.CommandIndex    = EMMC_CMDQ_TASK_MGMT;
+  SdMmcCmdBlk.CommandType     = SdMmcCommandTypeAc;
+  SdMmcCmdBlk.ResponseType    = SdMmcResponseTypeR1b;
+  SdMmcCmdBlk.CommandArgument = EMMC_CMDQ_TM_DISCARD_QUEUE;
+
+  return SdMmcPassThruPassThru (&Private->PassThru, Slot, &Packet, NULL);
+}
+
+/**
+  Take the device of a slot out of command queue mode, so that it accepts
+  the commands sent through EFI_SD_MMC_PASS_THRU_PROTOCOL.
+
+  The tasks in flight are completed first. Nothing is done if the device is
+  not in command queue mode.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+  @retval EFI_SUCCESS           The device is out of command queue mode.
+  @retval Others                The device couldn't be switched.
+
+**/
+EFI_STATUS
+SdMmcCqeLeave (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  SD_MMC_CQE  *Cqe;
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  UINT32      Value;
+  BOOLEAN     Discard;
+
+  Cqe = &Private->Cqe[Slot];
+  if (!Cqe->Enabled && !Cqe->Failed) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Let the tasks in flight complete.
+  //
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    SdMmcCqeCheckTasks (Private, Slot);
+    if (!Cqe->Enabled || (Cqe->Outstanding == 0)) {
+      break;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+    gBS->Stall (1);
+  }
+
+  if (Cqe->Enabled) {
+    SdMmcCqeHalt (Private, Slot);
+    Value = 0;
+    SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CFG, FALSE, &Value);
+  }
+
+  Discard      = Cqe->Failed;
+  Cqe->Enabled = FALSE;
+  Cqe->Failed  = FALSE;
+  gBS->RestoreTPL (OldTpl);
+
+  if (Discard) {
+    Status = SdMmcCqeDiscardQueue (Private, Slot);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "SdMmcCqeLeave: Slot[%d] discarding the queue fails with %r\n", Slot, Status));
+    }
+  }
+
+  Status = EmmcSwitch (&Private->PassThru, Slot, 0x3, OFFSET_OF (EMMC_EXT_CSD, CmdqModeEn), 0, 0);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "SdMmcCqeLeave: Slot[%d] leaving command queue mode fails with %r\n", Slot, Status));
+  }
+
+  return Status;
+}
+
+/**
+  Switch the device of a slot into command queue mode and start the command
+  queuing engine.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+  @retval EFI_SUCCESS           The engine is running.
+  @retval Others                The device or the engine couldn't be set up.
+
+**/
+STATIC
+EFI_STATUS
+SdMmcCqeEnter (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  SD_MMC_CQE           *Cqe;
+  EFI_PCI_IO_PROTOCOL  *PciIo;
+  EFI_STATUS           Status;
+  EFI_TPL              OldTpl;
+  UINT64               DescListPhy;
+  UINT32               Config;
+  UINT32               Value;
+  UINT16               BlkSize;
+  UINT16               IntStatus;
+  UINT8                HostCtrl1;
+
+  Cqe   = &Private->Cqe[Slot];
+  PciIo = Private->PciIo;
+
+  //
+  // A failed engine may have left tasks on the device, discard them first.
+  //
+  if (Cqe->Failed) {
+    Status = SdMmcCqeLeave (Private, Slot);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Wait async I/O list is empty, the device doesn't accept those commands
+  // in command queue mode.
+  //
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    if (IsListEmpty (&Private->Queue)) {
+      gBS->RestoreTPL (OldTpl);
+      break;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  Status = EmmcSwitch (&Private->PassThru, Slot, 0x3, OFFSET_OF (EMMC_EXT_CSD, CmdqModeEn), 1, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Cqe->Failed = TRUE;
+
+  //
+  // The engine transfers 512-byte blocks with ADMA2 descriptors.
+  //
+  HostCtrl1 = (UINT8) ~(BIT4 | BIT3);
+  Status    = SdMmcHcAndMmio (PciIo, Slot, SD_MMC_HC_HOST_CTRL1, sizeof (HostCtrl1), &HostCtrl1);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  HostCtrl1 = BIT4;
+  Status    = SdMmcHcOrMmio (PciIo, Slot, SD_MMC_HC_HOST_CTRL1, sizeof (HostCtrl1), &HostCtrl1);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  BlkSize = SD_MMC_CQE_BLOCK_SIZE;
+  Status  = SdMmcHcRwMmio (PciIo, Slot, SD_MMC_HC_BLK_SIZE, FALSE, sizeof (BlkSize), &BlkSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  IntStatus = 0xFFFF;
+  SdMmcHcRwMmio (PciIo, Slot, SD_MMC_HC_ERR_INT_STS, FALSE, sizeof (IntStatus), &IntStatus);
+  IntStatus = 0xFF3F;
+  SdMmcHcRwMmio (PciIo, Slot, SD_MMC_HC_NOR_INT_STS, FALSE, sizeof (IntStatus), &IntStatus);
+
+  Config = 0;
+  if (Cqe->TaskDescSize == sizeof (SD_MMC_HC_ADMA_64_V4_DESC_LINE)) {
+    Config |= SD_MMC_CQE_CFG_TASK_DESC_128;
+  }
+
+  Status = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CFG, FALSE, &Config);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  DescListPhy = Cqe->DescListPhy;
+  Status      = SdMmcHcRwMmio (
+                  PciIo,
+                  Slot,
+                  PcdGet32 (PcdSdMmcCqeRegisterOffset) + SD_MMC_CQE_TDLBA,
+                  FALSE,
+                  sizeof (DescListPhy),
+                  &DescListPhy
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Value  = (UINT32)Cqe->Rca;
+  Status = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_SSC2, FALSE, &Value);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Report the interrupt status for polling, without signaling it.
+  //
+  Value = SD_MMC_CQE_IS_HALT_COMPLETE | SD_MMC_CQE_IS_TASK_COMPLETE |
+          SD_MMC_CQE_IS_RESPONSE_ERROR | SD_MMC_CQE_IS_TASK_CLEARED;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_ISTE, FALSE, &Value);
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_IS, FALSE, &Value);
+  Value = 0;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_ISGE, FALSE, &Value);
+  Value = MAX_UINT32;
+  SdMmcCqeRw (Private, Slot, SD_MMC_CQE_TCN, FALSE, &Value);
+
+  Config |= SD_MMC_CQE_CFG_ENABLE;
+  Status  = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CFG, FALSE, &Config);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Value  = 0;
+  Status = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_CTL, FALSE, &Value);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Cqe->Enabled = TRUE;
+  Cqe->Failed  = FALSE;
+  Cqe->Statistics.ModeSwitches++;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Build the task descriptor, link descriptor and transfer descriptors of a
+  task of the command queuing engine of a slot.
+
+  @param[in] Cqe                The command queuing engine state of the slot.
+  @param[in] Tag                The task.
+  @param[in] Request            The transfer the task does.
+  @param[in] DataPhy            The mapped address of the data buffer.
+
+**/
+STATIC
+VOID
+SdMmcCqeBuildTask (
+  IN SD_MMC_CQE                          *Cqe,
+  IN UINT8                               Tag,
+  IN EDKII_SD_MMC_COMMAND_QUEUE_REQUEST  *Request,
+  IN EFI_PHYSICAL_ADDRESS                DataPhy
+  )
+{
+  UINT8                           *TaskSlot;
+  UINTN                           TableOffset;
+  EFI_PHYSICAL_ADDRESS            TablePhy;
+  SD_MMC_HC_ADMA_32_DESC_LINE     *Adma32Desc;
+  SD_MMC_HC_ADMA_64_V4_DESC_LINE  *Adma64Desc;
+  UINT64                          TaskDesc;
+  UINT64                          Remaining;
+  UINT32                          Length;
+  UINT32                          Index;
+
+  //
+  // Each task slot holds a task descriptor followed by a link descriptor to
+  // the transfer descriptor table of the task.
+  //
+  TaskSlot    = (UINT8 *)Cqe->DescList + Tag * 2 * Cqe->TaskDescSize;
+  TableOffset = SD_MMC_CQE_MAX_TASKS * 2 * Cqe->TaskDescSize +
+                Tag * SD_MMC_CQE_DESC_PER_TASK * Cqe->TaskDescSize;
+  TablePhy    = Cqe->DescListPhy + TableOffset;
+  ZeroMem (TaskSlot, 2 * Cqe->TaskDescSize);
+  ZeroMem ((UINT8 *)Cqe->DescList + TableOffset, SD_MMC_CQE_DESC_PER_TASK * Cqe->TaskDescSize);
+
+  TaskDesc = SD_MMC_CQE_TASK_VALID | SD_MMC_CQE_TASK_END | SD_MMC_CQE_TASK_INT | SD_MMC_CQE_TASK_ACT_TASK |
+             SD_MMC_CQE_TASK_BLOCK_COUNT (Request->BlockCount) |
+             SD_MMC_CQE_TASK_ADDRESS (Request->Address);
+  if (Request->IsRead) {
+    TaskDesc |= SD_MMC_CQE_TASK_DATA_DIR;
+  }
+
+  WriteUnaligned64 ((UINT64 *)TaskSlot, TaskDesc);
+
+  Remaining = MultU64x32 (Request->BlockCount, SD_MMC_CQE_BLOCK_SIZE);
+  if (Cqe->Addressing64) {
+    Adma64Desc               = (SD_MMC_HC_ADMA_64_V4_DESC_LINE *)(TaskSlot + Cqe->TaskDescSize);
+    Adma64Desc->Valid        = 1;
+    Adma64Desc->Act          = SD_MMC_ADMA_ACT_LINK;
+    Adma64Desc->LowerAddress = (UINT32)TablePhy;
+    Adma64Desc->UpperAddress = (UINT32)RShiftU64 (TablePhy, 32);
+
+    Adma64Desc = (SD_MMC_HC_ADMA_64_V4_DESC_LINE *)((UINT8 *)Cqe->DescList + TableOffset);
+    for (Index = 0; Remaining > 0; Index++) {
+      Length                         = (UINT32)MIN (Remaining, SD_MMC_CQE_MAX_DATA_PER_LINE);
+      Adma64Desc[Index].Valid        = 1;
+      Adma64Desc[Index].Act          = SD_MMC_ADMA_ACT_TRAN;
+      Adma64Desc[Index].LowerLength  = (UINT16)Length;
+      Adma64Desc[Index].LowerAddress = (UINT32)DataPhy;
+      Adma64Desc[Index].UpperAddress = (UINT32)RShiftU64 (DataPhy, 32);
+
+      Remaining -= Length;
+      DataPhy   += Length;
+    }
+
+    Adma64Desc[Index - 1].End = 1;
+  } else {
+    Adma32Desc          = (SD_MMC_HC_ADMA_32_DESC_LINE *)(TaskSlot + Cqe->TaskDescSize);
+    Adma32Desc->Valid   = 1;
+    Adma32Desc->Act     = SD_MMC_ADMA_ACT_LINK;
+    Adma32Desc->Address = (UINT32)TablePhy;
+
+    Adma32Desc = (SD_MMC_HC_ADMA_32_DESC_LINE *)((UINT8 *)Cqe->DescList + TableOffset);
+    for (Index = 0; Remaining > 0; Index++) {
+      Length                        = (UINT32)MIN (Remaining, SD_MMC_CQE_MAX_DATA_PER_LINE);
+      Adma32Desc[Index].Valid       = 1;
+      Adma32Desc[Index].Act         = SD_MMC_ADMA_ACT_TRAN;
+      Adma32Desc[Index].LowerLength = (UINT16)Length;
+      Adma32Desc[Index].Address     = (UINT32)DataPhy;
+
+      Remaining -= Length;
+      DataPhy   += Length;
+    }
+
+    Adma32Desc[Index - 1].End = 1;
+  }
+}
+
+/**
+  Prepare the command queuing engine of a slot after its device has been
+  identified.
+
+  Command queuing is used when PcdSdMmcCqeRegisterOffset locates the engine,
+  the host controller is version 4.00 or later and the device is an eMMC
+  device reporting command queuing support in its EXT_CSD register.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+  @retval EFI_SUCCESS           Command queuing can be used in the slot.
+  @retval EFI_UNSUPPORTED       Command queuing is not supported in the slot.
+  @retval Others                The operation fails.
+
+**/
+EFI_STATUS
+SdMmcCqeInit (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  SD_MMC_CQE           *Cqe;
+  EFI_PCI_IO_PROTOCOL  *PciIo;
+  EMMC_EXT_CSD         ExtCsd;
+  EFI_STATUS           Status;
+  UINT32               Version;
+  UINT16               HostCtrl2;
+  UINTN                Size;
+  UINTN                Bytes;
+
+  Cqe   = &Private->Cqe[Slot];
+  PciIo = Private->PciIo;
+
+  SdMmcCqeFree (Private, Slot);
+
+  if ((PcdGet32 (PcdSdMmcCqeRegisterOffset) == 0) ||
+      (Private->Slot[Slot].CardType != EmmcCardType) ||
+      (Private->ControllerVersion[Slot] < SD_MMC_HC_CTRL_VER_400) ||
+      (Private->Capability[Slot].Adma2 == 0))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  Version = 0;
+  Status  = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_VER, TRUE, &Version);
+  if (EFI_ERROR (Status) || (Version == 0) || (Version == MAX_UINT32)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = EmmcGetExtCsd (&Private->PassThru, Slot, &ExtCsd);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((ExtCsd.CmdqSupport & BIT0) == 0) {
+    DEBUG ((DEBUG_INFO, "SdMmcCqeInit: Slot[%d] device doesn't support command queuing\n", Slot));
+    return EFI_UNSUPPORTED;
+  }
+
+  Cqe->Depth = (UINT8)MIN ((ExtCsd.CmdqDepth & 0x1F) + 1, SD_MMC_CQE_MAX_TASKS);
+  //
+  // The RCA assigned by EmmcIdentification().
+  //
+  Cqe->Rca = Slot + 1;
+
+  //
+  // 64-bit addressing needs 128-bit task descriptors, the link and transfer
+  // descriptors then take the ADMA2 64-bit form.
+  //
+  HostCtrl2 = 0;
+  Status    = SdMmcHcRwMmio (PciIo, Slot, SD_MMC_HC_HOST_CTRL2, TRUE, sizeof (HostCtrl2), &HostCtrl2);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Cqe->Addressing64 = (BOOLEAN)((HostCtrl2 & SD_MMC_HC_64_ADDR_EN) != 0);
+  if (Cqe->Addressing64) {
+    Cqe->TaskDescSize = sizeof (SD_MMC_HC_ADMA_64_V4_DESC_LINE);
+  } else {
+    Cqe->TaskDescSize = sizeof (SD_MMC_HC_ADMA_32_DESC_LINE);
+  }
+
+  Size               = SD_MMC_CQE_MAX_TASKS * (2 + SD_MMC_CQE_DESC_PER_TASK) * Cqe->TaskDescSize;
+  Cqe->DescListPages = EFI_SIZE_TO_PAGES (Size);
+  Status             = PciIo->AllocateBuffer (
+                                PciIo,
+                                AllocateAnyPages,
+                                EfiBootServicesData,
+                                Cqe->DescListPages,
+                                &Cqe->DescList,
+                                0
+                                );
+  if (EFI_ERROR (Status)) {
+    Cqe->DescList = NULL;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Cqe->DescList, EFI_PAGES_TO_SIZE (Cqe->DescListPages));
+  Bytes  = EFI_PAGES_TO_SIZE (Cqe->DescListPages);
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Cqe->DescList,
+                    &Bytes,
+                    &Cqe->DescListPhy,
+                    &Cqe->DescListMap
+                    );
+  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (Cqe->DescListPages)) ||
+      (!Cqe->Addressing64 && ((Cqe->DescListPhy + Bytes) > 0x100000000ul)))
+  {
+    SdMmcCqeFree (Private, Slot);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Cqe->Supported = TRUE;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "SdMmcCqeInit: Slot[%d] CQE version %x, queue depth %d, %d-bit addressing\n",
+    Slot,
+    Version,
+    Cqe->Depth,
+    Cqe->Addressing64 ? 64 : 32
+    ));
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Release the resources of the command queuing engine of a slot.
+
+  The engine must not be running.
+
+  @param[in] Private            A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot               The slot number.
+
+**/
+VOID
+SdMmcCqeFree (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  )
+{
+  SD_MMC_CQE           *Cqe;
+  EFI_PCI_IO_PROTOCOL  *PciIo;
+
+  Cqe   = &Private->Cqe[Slot];
+  PciIo = Private->PciIo;
+
+  ASSERT (Cqe->Outstanding == 0);
+
+  if (Cqe->DescListMap != NULL) {
+    PciIo->Unmap (PciIo, Cqe->DescListMap);
+  }
+
+  if (Cqe->DescList != NULL) {
+    PciIo->FreeBuffer (PciIo, Cqe->DescListPages, Cqe->DescList);
+  }
+
+  ZeroMem (Cqe, sizeof (SD_MMC_CQE));
+}
+
+/**
+  Get the command queue parameters of the device in a slot.
+
+  @param[in]  This              A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]  Slot              The slot number of the device.
+  @param[out] QueueDepth        The number of transfers that can be in flight at once.
+  @param[out] MaxBlockCount     The largest BlockCount of a single request.
+
+  @retval EFI_SUCCESS           The parameters are returned.
+  @retval EFI_INVALID_PARAMETER Slot, QueueDepth or MaxBlockCount is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing.
+
+**/
+EFI_STATUS
+EFIAPI
+SdMmcCommandQueueGetInfo (
+  IN  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *This,
+  IN  UINT8                                Slot,
+  OUT UINT32                               *QueueDepth,
+  OUT UINT32                               *MaxBlockCount
+  )
+{
+  SD_MMC_HC_PRIVATE_DATA  *Private;
+
+  if ((This == NULL) || (Slot >= SD_MMC_HC_MAX_SLOT) ||
+      (QueueDepth == NULL) || (MaxBlockCount == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Private = SD_MMC_HC_PRIVATE_FROM_COMMAND_QUEUE (This);
+  if (!Private->Cqe[Slot].Supported) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *QueueDepth    = Private->Cqe[Slot].Depth;
+  *MaxBlockCount = SD_MMC_CQE_MAX_BLOCK_COUNT;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Queue a data transfer with the device in a slot.
+
+  @param[in]      This          A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]      Slot          The slot number of the device.
+  @param[in, out] Request       The transfer to queue. It must stay valid until
+                                the transfer completes.
+  @param[in]      Event         If Event is NULL, the function waits for the
+                                transfer to complete. Otherwise it returns once
+                                the transfer is queued and Event is signaled
+                                when it completes.
+
+  @retval EFI_SUCCESS           The transfer is queued, or done if Event is
+                                NULL. Check Request->TransactionStatus for the
+                                result of a non-blocking transfer.
+  @retval EFI_INVALID_PARAMETER Slot or Request is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing, or it has been
+                                given up because switching modes failed. The
+                                transfer should be done without queuing.
+  @retval EFI_NO_MEDIA          There is no device in the slot.
+  @retval EFI_DEVICE_ERROR      The transfer failed.
+  @retval EFI_TIMEOUT           The transfer didn't complete in time.
+
+**/
+EFI_STATUS
+EFIAPI
+SdMmcCommandQueueSubmit (
+  IN     EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *This,
+  IN     UINT8                                Slot,
+  IN OUT EDKII_SD_MMC_COMMAND_QUEUE_REQUEST   *Request,
+  IN     EFI_EVENT                            Event OPTIONAL
+  )
+{
+  SD_MMC_HC_PRIVATE_DATA         *Private;
+  SD_MMC_CQE                     *Cqe;
+  SD_MMC_CQE_TASK                *Task;
+  EFI_PCI_IO_PROTOCOL            *PciIo;
+  EFI_PCI_IO_PROTOCOL_OPERATION  Flag;
+  EFI_PHYSICAL_ADDRESS           DataPhy;
+  VOID                           *DataMap;
+  UINTN                          DataLen;
+  UINTN                          MapLength;
+  EFI_STATUS                     Status;
+  EFI_TPL                        OldTpl;
+  UINT32                         Free;
+  UINT32                         Doorbell;
+  UINT8                          Tag;
+
+  if ((This == NULL) || (Slot >= SD_MMC_HC_MAX_SLOT) || (Request == NULL) ||
+      (Request->Buffer == NULL) || (Request->BlockCount == 0) ||
+      (Request->BlockCount > SD_MMC_CQE_MAX_BLOCK_COUNT))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Private = SD_MMC_HC_PRIVATE_FROM_COMMAND_QUEUE (This);
+  Cqe     = &Private->Cqe[Slot];
+  PciIo   = Private->PciIo;
+
+  if (!Private->Slot[Slot].Enable) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!Private->Slot[Slot].MediaPresent) {
+    return EFI_NO_MEDIA;
+  }
+
+  if (!Private->Slot[Slot].Initialized) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (!Cqe->Supported) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Request->IsRead) {
+    Flag = EfiPciIoOperationBusMasterWrite;
+  } else {
+    Flag = EfiPciIoOperationBusMasterRead;
+  }
+
+  DataLen   = Request->BlockCount * SD_MMC_CQE_BLOCK_SIZE;
+  MapLength = DataLen;
+  DataMap   = NULL;
+  Status    = PciIo->Map (PciIo, Flag, Request->Buffer, &MapLength, &DataPhy, &DataMap);
+  if (EFI_ERROR (Status) || (MapLength != DataLen)) {
+    if (!EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, DataMap);
+    }
+
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if (!Cqe->Addressing64 && ((DataPhy + DataLen) > 0x100000000ul)) {
+    PciIo->Unmap (PciIo, DataMap);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Request->TransactionStatus = EFI_NOT_READY;
+
+  //
+  // Switch the device into command queue mode if needed and wait for a free
+  // task slot.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (TRUE) {
+    if (!Cqe->Enabled) {
+      gBS->RestoreTPL (OldTpl);
+      Status = SdMmcCqeEnter (Private, Slot);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "SdMmcCommandQueueSubmit: Slot[%d] entering command queue mode fails with %r, give up queuing\n", Slot, Status));
+        Cqe->Supported = FALSE;
+        SdMmcCqeLeave (Private, Slot);
+        PciIo->Unmap (PciIo, DataMap);
+        return EFI_UNSUPPORTED;
+      }
+
+      OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+      continue;
+    }
+
+    Free = ~Cqe->Outstanding;
+    if (Cqe->Depth < SD_MMC_CQE_MAX_TASKS) {
+      Free &= (1U << Cqe->Depth) - 1;
+    }
+
+    if (Free != 0) {
+      break;
+    }
+
+    SdMmcCqeCheckTasks (Private, Slot);
+    gBS->RestoreTPL (OldTpl);
+    gBS->Stall (1);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  }
+
+  Tag = (UINT8)LowBitSet32 (Free);
+  SdMmcCqeBuildTask (Cqe, Tag, Request, DataPhy);
+
+  Task             = &Cqe->Task[Tag];
+  Task->Request    = Request;
+  Task->Event      = Event;
+  Task->DataMap    = DataMap;
+  Task->SubmitTick = GetPerformanceCounter ();
+
+  MemoryFence ();
+  Doorbell = 1U << Tag;
+  Status   = SdMmcCqeRw (Private, Slot, SD_MMC_CQE_TDBR, FALSE, &Doorbell);
+  if (EFI_ERROR (Status)) {
+    ZeroMem (Task, sizeof (SD_MMC_CQE_TASK));
+    gBS->RestoreTPL (OldTpl);
+    PciIo->Unmap (PciIo, DataMap);
+    return Status;
+  }
+
+  if (Cqe->Outstanding == 0) {
+    Cqe->BusyStartTick = Task->SubmitTick;
+  }
+
+  Cqe->Outstanding              |= Doorbell;
+  Cqe->Statistics.MaxOutstanding = MAX (Cqe->Statistics.MaxOutstanding, (UINT32)BitFieldCountOnes32 (Cqe->Outstanding, 0, 31));
+
+  gBS->RestoreTPL (OldTpl);
+
+  //
+  // Immediately return for async I/O.
+  //
+  if (Event != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    SdMmcCqeCheckTasks (Private, Slot);
+    Status = Request->TransactionStatus;
+    gBS->RestoreTPL (OldTpl);
+    if (Status != EFI_NOT_READY) {
+      break;
+    }
+
+    gBS->Stall (1);
+  }
+
+  return Status;
+}
+
+/**
+  Get the statistics of the queued transfers of a slot.
+
+  @param[in]  This              A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]  Slot              The slot number of the device.
+  @param[in]  Reset             Clear the statistics after returning them.
+  @param[out] Statistics        The statistics of the slot.
+
+  @retval EFI_SUCCESS           The statistics are returned.
+  @retval EFI_INVALID_PARAMETER Slot or Statistics is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing.
+
+**/
+EFI_STATUS
+EFIAPI
+SdMmcCommandQueueGetStatistics (
+  IN  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL    *This,
+  IN  UINT8                                  Slot,
+  IN  BOOLEAN                                Reset,
+  OUT EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS  *Statistics
+  )
+{
+  SD_MMC_HC_PRIVATE_DATA  *Private;
+  SD_MMC_CQE              *Cqe;
+  EFI_TPL                 OldTpl;
+  UINT64                  BusyTime;
+
+  if ((This == NULL) || (Slot >= SD_MMC_HC_MAX_SLOT) || (Statistics == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Private = SD_MMC_HC_PRIVATE_FROM_COMMAND_QUEUE (This);
+  Cqe     = &Private->Cqe[Slot];
+
+  //
+  // The statistics stay available after queuing has been given up.
+  //
+  if (Cqe->DescList == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  CopyMem (Statistics, &Cqe->Statistics, sizeof (EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS));
+  if (Cqe->Outstanding != 0) {
+    Statistics->BusyTime += SdMmcCqeElapsedTime (Cqe->BusyStartTick);
+  }
+
+  if (Reset) {
+    ZeroMem (&Cqe->Statistics, sizeof (EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS));
+    Cqe->BusyStartTick = GetPerformanceCounter ();
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  BusyTime = DivU64x32 (Statistics->BusyTime, 1000);
+  if (BusyTime != 0) {
+    Statistics->IoPerSecond    = DivU64x64Remainder (MultU64x32 (Statistics->CompletedRequests, 1000000), BusyTime, NULL);
+    Statistics->BytesPerSecond = DivU64x64Remainder (MultU64x32 (Statistics->TransferredBytes, 1000000), BusyTime, NULL);
+  }
+
+  return EFI_SUCCESS;
+}
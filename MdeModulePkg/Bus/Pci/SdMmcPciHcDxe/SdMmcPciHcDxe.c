@@ -48,6 +48,12 @@ SD_MMC_HC_PRIVATE_DATA  gSdMmcPciHcTemplate = {
     SdMmcPassThruGetSlotNumber,
     SdMmcPassThruResetDevice
   },
+  {                                 // CommandQueue
+    EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL_REVISION,
+    SdMmcCommandQueueGetInfo,
+    SdMmcCommandQueueSubmit,
+    SdMmcCommandQueueGetStatistics
+  },
   0,                                // PciAttributes
   0,                                // PreviousSlot
   NULL,                             // TimerEvent
@@ -161,9 +167,17 @@ ProcessAsyncTaskList (
   EFI_SD_MMC_PASS_THRU_COMMAND_PACKET  *Packet;
   BOOLEAN                              InfiniteWait;
   EFI_EVENT                            TrbEvent;
+  UINT8                                Slot;
 
   Private = (SD_MMC_HC_PRIVATE_DATA *)Context;
 
+  //
+  // Complete the transfers the command queuing engines have finished.
+  //
+  for (Slot = 0; Slot < SD_MMC_HC_MAX_SLOT; Slot++) {
+    SdMmcCqeCheckTasks (Private, Slot);
+  }
+
   //
   // Check if the first entry in the async I/O queue is done or not.
   //
@@ -269,6 +283,8 @@ SdMmcPciHcEnumerateDevice (
         // Signal all async task events at the slot with EFI_NO_MEDIA status.
         //
         OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+        SdMmcCqeAbortTasks (Private, Slot, EFI_NO_MEDIA);
+        SdMmcCqeFree (Private, Slot);
         for (Link = GetFirstNode (&Private->Queue);
              !IsNull (&Private->Queue, Link);
              Link = NextLink)
@@ -331,6 +347,8 @@ SdMmcPciHcEnumerateDevice (
         //
         if (Index == RoutineNum) {
           Private->Slot[Slot].Initialized = FALSE;
+        } else {
+          SdMmcCqeInit (Private, Slot);
         }
 
         //
@@ -777,6 +795,8 @@ SdMmcPciHcDriverBindingStart (
     //
     if (Index == RoutineNum) {
       Private->Slot[Slot].Initialized = FALSE;
+    } else {
+      SdMmcCqeInit (Private, Slot);
     }
   }
 
@@ -838,6 +858,8 @@ SdMmcPciHcDriverBindingStart (
                   &Controller,
                   &gEfiSdMmcPassThruProtocolGuid,
                   &(Private->PassThru),
+                  &gEdkiiSdMmcCommandQueueProtocolGuid,
+                  &(Private->CommandQueue),
                   NULL
                   );
 
@@ -873,6 +895,10 @@ Done:
     }
 
     if (Private != NULL) {
+      for (Slot = 0; Slot < SD_MMC_HC_MAX_SLOT; Slot++) {
+        SdMmcCqeFree (Private, Slot);
+      }
+
       FreePool (Private);
     }
   }
@@ -922,6 +948,7 @@ SdMmcPciHcDriverBindingStop (
   LIST_ENTRY                     *Link;
   LIST_ENTRY                     *NextLink;
   SD_MMC_HC_TRB                  *Trb;
+  UINT8                          Slot;
 
   DEBUG ((DEBUG_INFO, "SdMmcPciHcDriverBindingStop: Start\n"));
 
@@ -967,13 +994,25 @@ SdMmcPciHcDriverBindingStop (
     SdMmcFreeTrb (Trb);
   }
 
+  //
+  // Let the queued transfers complete and take the devices out of command
+  // queue mode.
+  //
+  for (Slot = 0; Slot < SD_MMC_HC_MAX_SLOT; Slot++) {
+    SdMmcCqeLeave (Private, Slot);
+    SdMmcCqeFree (Private, Slot);
+  }
+
   //
   // Uninstall Block I/O protocol from the device handle
   //
-  Status = gBS->UninstallProtocolInterface (
+  Status = gBS->UninstallMultipleProtocolInterfaces (
                   Controller,
                   &gEfiSdMmcPassThruProtocolGuid,
-                  &(Private->PassThru)
+                  &(Private->PassThru),
+                  &gEdkiiSdMmcCommandQueueProtocolGuid,
+                  &(Private->CommandQueue),
+                  NULL
                   );
 
   if (EFI_ERROR (Status)) {
@@ -1138,6 +1177,12 @@ SdMmcPassThruPassThru (
     return EFI_DEVICE_ERROR;
   }
 
+  //
+  // The device doesn't accept these commands in command queue mode. A failure
+  // to switch shows up as the failure of the command itself.
+  //
+  SdMmcCqeLeave (Private, Slot);
+
   Trb = SdMmcCreateTrb (Private, Slot, Packet, Event);
   if (Trb == NULL) {
     return EFI_OUT_OF_RESOURCES;
@@ -1442,6 +1487,8 @@ SdMmcPassThruResetDevice (
   //
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
+  SdMmcCqeAbortTasks (Private, Slot, EFI_ABORTED);
+
   for (Link = GetFirstNode (&Private->Queue);
        !IsNull (&Private->Queue, Link);
        Link = NextLink)
@@ -24,6 +24,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
 
 #include <Protocol/DevicePath.h>
 #include <Protocol/PciIo.h>
@@ -32,6 +33,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/ComponentName2.h>
 #include <Protocol/SdMmcOverride.h>
 #include <Protocol/SdMmcPassThru.h>
+#include <Protocol/SdMmcCommandQueue.h>
 
 #include "SdMmcPciHci.h"
 
@@ -46,6 +48,9 @@ extern EDKII_SD_MMC_OVERRIDE  *mOverride;
 #define SD_MMC_HC_PRIVATE_FROM_THIS(a) \
     CR(a, SD_MMC_HC_PRIVATE_DATA, PassThru, SD_MMC_HC_PRIVATE_SIGNATURE)
 
+#define SD_MMC_HC_PRIVATE_FROM_COMMAND_QUEUE(a) \
+    CR(a, SD_MMC_HC_PRIVATE_DATA, CommandQueue, SD_MMC_HC_PRIVATE_SIGNATURE)
+
 //
 // Generic time out value, 1 microsecond as unit.
 //
@@ -87,39 +92,95 @@ typedef struct {
   EDKII_SD_MMC_OPERATING_PARAMETERS    OperatingParameters;
 } SD_MMC_HC_SLOT;
 
+//
+// The Command Queuing Engine has 32 task slots. Each task gets a table of
+// SD_MMC_CQE_DESC_PER_TASK transfer descriptors of up to 32KB each, which
+// is representable in both the 16-bit and the 26-bit ADMA2 length modes.
+//
+#define SD_MMC_CQE_MAX_TASKS          32
+#define SD_MMC_CQE_DESC_PER_TASK      32
+#define SD_MMC_CQE_MAX_DATA_PER_LINE  SIZE_32KB
+#define SD_MMC_CQE_BLOCK_SIZE         0x200
+#define SD_MMC_CQE_MAX_BLOCK_COUNT    (SD_MMC_CQE_DESC_PER_TASK * SD_MMC_CQE_MAX_DATA_PER_LINE / SD_MMC_CQE_BLOCK_SIZE)
+
+//
+// A task in flight on the Command Queuing Engine.
+//
 typedef struct {
-  UINTN                            Signature;
+  EDKII_SD_MMC_COMMAND_QUEUE_REQUEST    *Request;
+  EFI_EVENT                             Event;
+  VOID                                  *DataMap;
+  UINT64                                SubmitTick;
+} SD_MMC_CQE_TASK;
 
-  EFI_HANDLE                       ControllerHandle;
-  EFI_PCI_IO_PROTOCOL              *PciIo;
+//
+// Command Queuing Engine state of a slot.
+//
+typedef struct {
+  //
+  // The engine and the device support command queuing and the descriptor
+  // list is allocated.
+  //
+  BOOLEAN                                  Supported;
+  //
+  // The device is in command queue mode and the engine is running.
+  //
+  BOOLEAN                                  Enabled;
+  //
+  // The engine was stopped after an error, the device is still in command
+  // queue mode and may hold the failed tasks.
+  //
+  BOOLEAN                                  Failed;
+  BOOLEAN                                  Addressing64;
+  UINT8                                    Depth;
+  UINT16                                   Rca;
+  UINT32                                   TaskDescSize;
+  VOID                                     *DescList;
+  EFI_PHYSICAL_ADDRESS                     DescListPhy;
+  VOID                                     *DescListMap;
+  UINTN                                    DescListPages;
+  UINT32                                   Outstanding;
+  SD_MMC_CQE_TASK                          Task[SD_MMC_CQE_MAX_TASKS];
+  UINT64                                   BusyStartTick;
+  EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS    Statistics;
+} SD_MMC_CQE;
+
+typedef struct {
+  UINTN                                  Signature;
 
-  EFI_SD_MMC_PASS_THRU_PROTOCOL    PassThru;
+  EFI_HANDLE                             ControllerHandle;
+  EFI_PCI_IO_PROTOCOL                    *PciIo;
 
-  UINT64                           PciAttributes;
+  EFI_SD_MMC_PASS_THRU_PROTOCOL          PassThru;
+  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL    CommandQueue;
+
+  UINT64                                 PciAttributes;
   //
   // The field is used to record the previous slot in GetNextSlot().
   //
-  UINT8                            PreviousSlot;
+  UINT8                                  PreviousSlot;
   //
   // For Non-blocking operation.
   //
-  EFI_EVENT                        TimerEvent;
+  EFI_EVENT                              TimerEvent;
   //
   // For Sd removable device enumeration.
   //
-  EFI_EVENT                        ConnectEvent;
-  LIST_ENTRY                       Queue;
+  EFI_EVENT                              ConnectEvent;
+  LIST_ENTRY                             Queue;
 
-  SD_MMC_HC_SLOT                   Slot[SD_MMC_HC_MAX_SLOT];
-  SD_MMC_HC_SLOT_CAP               Capability[SD_MMC_HC_MAX_SLOT];
-  UINT64                           MaxCurrent[SD_MMC_HC_MAX_SLOT];
-  UINT16                           ControllerVersion[SD_MMC_HC_MAX_SLOT];
+  SD_MMC_HC_SLOT                         Slot[SD_MMC_HC_MAX_SLOT];
+  SD_MMC_HC_SLOT_CAP                     Capability[SD_MMC_HC_MAX_SLOT];
+  UINT64                                 MaxCurrent[SD_MMC_HC_MAX_SLOT];
+  UINT16                                 ControllerVersion[SD_MMC_HC_MAX_SLOT];
 
   //
   // Some controllers may require to override base clock frequency
   // value stored in Capabilities Register 1.
   //
-  UINT32                           BaseClkFreq[SD_MMC_HC_MAX_SLOT];
+  UINT32                                 BaseClkFreq[SD_MMC_HC_MAX_SLOT];
+
+  SD_MMC_CQE                             Cqe[SD_MMC_HC_MAX_SLOT];
 } SD_MMC_HC_PRIVATE_DATA;
 
 typedef struct {
@@ -863,3 +924,229 @@ SdMmcHcInitHost (
   IN SD_MMC_HC_PRIVATE_DATA  *Private,
   IN UINT8                   Slot
   );
+
+/**
+  Performs SW reset based on passed error status mask.
+
+  @param[in]  Private       Pointer to driver private data.
+  @param[in]  Slot          Index of the slot to reset.
+  @param[in]  ErrIntStatus  Error interrupt status mask.
+
+  @retval EFI_SUCCESS  Software reset performed successfully.
+  @retval Other        Software reset failed.
+**/
+EFI_STATUS
+SdMmcSoftwareReset (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot,
+  IN UINT16                  ErrIntStatus
+  );
+
+/**
+  Send command SEND_EXT_CSD to the EMMC device to get the data of the EXT_CSD register.
+
+  Refer to EMMC Electrical Standard Spec 5.1 Section 6.10.4 for details.
+
+  @param[in]  PassThru      A pointer to the EFI_SD_MMC_PASS_THRU_PROTOCOL instance.
+  @param[in]  Slot          The slot number of the SD card to send the command to.
+  @param[out] ExtCsd        The buffer to store the content of the EXT_CSD register.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EmmcGetExtCsd (
+  IN     EFI_SD_MMC_PASS_THRU_PROTOCOL  *PassThru,
+  IN     UINT8                          Slot,
+  OUT EMMC_EXT_CSD                      *ExtCsd
+  );
+
+/**
+  Send command SWITCH to the EMMC device to switch the mode of operation of the
+  selected Device or modifies the EXT_CSD registers.
+
+  Refer to EMMC Electrical Standard Spec 5.1 Section 6.10.4 for details.
+
+  @param[in]  PassThru      A pointer to the EFI_SD_MMC_PASS_THRU_PROTOCOL instance.
+  @param[in]  Slot          The slot number of the SD card to send the command to.
+  @param[in]  Access        The access mode of SWTICH command.
+  @param[in]  Index         The offset of the field to be access.
+  @param[in]  Value         The value to be set to the specified field of EXT_CSD register.
+  @param[in]  CmdSet        The value of CmdSet field of EXT_CSD register.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EmmcSwitch (
+  IN EFI_SD_MMC_PASS_THRU_PROTOCOL  *PassThru,
+  IN UINT8                          Slot,
+  IN UINT8                          Access,
+  IN UINT8                          Index,
+  IN UINT8                          Value,
+  IN UINT8                          CmdSet
+  );
+
+/**
+  Prepare the command queuing engine of a slot after its device has been
+  identified.
+
+  Command queuing is used when PcdSdMmcCqeRegisterOffset locates the engine,
+  the host controller is version 4.00 or later and the device is an eMMC
+  device reporting command queuing support in its EXT_CSD register.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot           The slot number.
+
+  @retval EFI_SUCCESS       Command queuing can be used in the slot.
+  @retval EFI_UNSUPPORTED   Command queuing is not supported in the slot.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+SdMmcCqeInit (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  );
+
+/**
+  Release the resources of the command queuing engine of a slot.
+
+  The engine must not be running.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot           The slot number.
+
+**/
+VOID
+SdMmcCqeFree (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  );
+
+/**
+  Take the device of a slot out of command queue mode, so that it accepts
+  the commands sent through EFI_SD_MMC_PASS_THRU_PROTOCOL.
+
+  The tasks in flight are completed first. Nothing is done if the device is
+  not in command queue mode.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot           The slot number.
+
+  @retval EFI_SUCCESS       The device is out of command queue mode.
+  @retval Others            The device couldn't be switched.
+
+**/
+EFI_STATUS
+SdMmcCqeLeave (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  );
+
+/**
+  Complete the tasks the command queuing engine of a slot has finished, and
+  check for errors and timeouts.
+
+  It should be called at TPL_NOTIFY.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot           The slot number.
+
+**/
+VOID
+SdMmcCqeCheckTasks (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot
+  );
+
+/**
+  Stop the command queuing engine of a slot and fail all the tasks in flight.
+
+  The device is left in command queue mode, it is taken out of it with the
+  failed tasks discarded by SdMmcCqeLeave(). It should be called at TPL_NOTIFY.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+  @param[in] Slot           The slot number.
+  @param[in] Status         The result to report for the tasks in flight.
+
+**/
+VOID
+SdMmcCqeAbortTasks (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private,
+  IN UINT8                   Slot,
+  IN EFI_STATUS              Status
+  );
+
+/**
+  Get the command queue parameters of the device in a slot.
+
+  @param[in]  This              A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]  Slot              The slot number of the device.
+  @param[out] QueueDepth        The number of transfers that can be in flight at once.
+  @param[out] MaxBlockCount     The largest BlockCount of a single request.
+
+  @retval EFI_SUCCESS           The parameters are returned.
+  @retval EFI_INVALID_PARAMETER Slot, QueueDepth or MaxBlockCount is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing.
+
+**/
+EFI_STATUS
+EFIAPI
+SdMmcCommandQueueGetInfo (
+  IN  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *This,
+  IN  UINT8                                Slot,
+  OUT UINT32                               *QueueDepth,
+  OUT UINT32                               *MaxBlockCount
+  );
+
+/**
+  Queue a data transfer with the device in a slot.
+
+  @param[in]      This          A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]      Slot          The slot number of the device.
+  @param[in, out] Request       The transfer to queue.
+  @param[in]      Event         If NULL, wait for the transfer to complete,
+                                otherwise the event to signal on completion.
+
+  @retval EFI_SUCCESS           The transfer is queued, or done if Event is NULL.
+  @retval EFI_INVALID_PARAMETER Slot or Request is invalid.
+  @retval EFI_UNSUPPORTED       Command queuing can't be used in the slot.
+  @retval EFI_NO_MEDIA          There is no device in the slot.
+  @retval EFI_DEVICE_ERROR      The transfer failed.
+  @retval EFI_TIMEOUT           The transfer didn't complete in time.
+
+**/
+EFI_STATUS
+EFIAPI
+SdMmcCommandQueueSubmit (
+  IN     EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *This,
+  IN     UINT8                                Slot,
+  IN OUT EDKII_SD_MMC_COMMAND_QUEUE_REQUEST   *Request,
+  IN     EFI_EVENT                            Event OPTIONAL
+  );
+
+/**
+  Get the statistics of the queued transfers of a slot.
+
+  @param[in]  This              A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]  Slot              The slot number of the device.
+  @param[in]  Reset             Clear the statistics after returning them.
+  @param[out] Statistics        The statistics of the slot.
+
+  @retval EFI_SUCCESS           The statistics are returned.
+  @retval EFI_INVALID_PARAMETER Slot or Statistics is invalid.
+  @retval EFI_UNSUPPORTED       Command queuing is not supported in the slot.
+
+**/
+EFI_STATUS
+EFIAPI
+SdMmcCommandQueueGetStatistics (
+  IN  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL    *This,
+  IN  UINT8                                  Slot,
+  IN  BOOLEAN                                Reset,
+  OUT EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS  *Statistics
+  );
@@ -210,6 +210,66 @@ typedef struct {
 #define SD_MMC_HC_64_ADDR_EN           BIT13
 #define SD_MMC_HC_26_DATA_LEN_ADMA_EN  BIT10
 
+//
+// eMMC Command Queuing Engine (CQE) registers, relative to the offset given
+// by PcdSdMmcCqeRegisterOffset. Refer to eMMC Electrical Standard Spec 5.1
+// Appendix B for details.
+//
+#define SD_MMC_CQE_VER       0x00
+#define SD_MMC_CQE_CAP       0x04
+#define SD_MMC_CQE_CFG       0x08
+#define SD_MMC_CQE_CTL       0x0C
+#define SD_MMC_CQE_IS        0x10
+#define SD_MMC_CQE_ISTE      0x14
+#define SD_MMC_CQE_ISGE      0x18
+#define SD_MMC_CQE_IC        0x1C
+#define SD_MMC_CQE_TDLBA     0x20
+#define SD_MMC_CQE_TDBR      0x28
+#define SD_MMC_CQE_TCN       0x2C
+#define SD_MMC_CQE_DQS       0x30
+#define SD_MMC_CQE_DPT       0x34
+#define SD_MMC_CQE_TCLR      0x38
+#define SD_MMC_CQE_SSC1      0x40
+#define SD_MMC_CQE_SSC2      0x44
+#define SD_MMC_CQE_CRDCT     0x48
+#define SD_MMC_CQE_RMEM      0x50
+#define SD_MMC_CQE_TERRI     0x54
+#define SD_MMC_CQE_CRI       0x58
+#define SD_MMC_CQE_CRA       0x5C
+
+//
+// Bits of the CQE Configuration, Control and Interrupt Status registers
+//
+#define SD_MMC_CQE_CFG_ENABLE          BIT0
+#define SD_MMC_CQE_CFG_TASK_DESC_128   BIT8
+#define SD_MMC_CQE_CTL_HALT            BIT0
+#define SD_MMC_CQE_CTL_CLEAR_ALL       BIT8
+#define SD_MMC_CQE_IS_HALT_COMPLETE    BIT0
+#define SD_MMC_CQE_IS_TASK_COMPLETE    BIT1
+#define SD_MMC_CQE_IS_RESPONSE_ERROR   BIT2
+#define SD_MMC_CQE_IS_TASK_CLEARED     BIT3
+#define SD_MMC_CQE_TERRI_RESP_VALID    BIT15
+#define SD_MMC_CQE_TERRI_DATA_VALID    BIT31
+
+//
+// Task descriptor of the CQE. The 128-bit form used with 64-bit addressing
+// leaves the upper 64 bits reserved.
+//
+#define SD_MMC_CQE_TASK_VALID     BIT0
+#define SD_MMC_CQE_TASK_END       BIT1
+#define SD_MMC_CQE_TASK_INT       BIT2
+#define SD_MMC_CQE_TASK_ACT_TASK  (BIT5 | BIT3)
+#define SD_MMC_CQE_TASK_DATA_DIR  BIT12
+#define SD_MMC_CQE_TASK_BLOCK_COUNT(x)  LShiftU64 ((x), 16)
+#define SD_MMC_CQE_TASK_ADDRESS(x)      LShiftU64 ((x), 32)
+
+//
+// The transfer and link descriptors of the CQE use the ADMA2 descriptor
+// format. Act field values of SD_MMC_HC_ADMA_*_DESC_LINE:
+//
+#define SD_MMC_ADMA_ACT_TRAN  2
+#define SD_MMC_ADMA_ACT_LINK  3
+
 /**
   Dump the content of SD/MMC host controller's Capability Register.
 
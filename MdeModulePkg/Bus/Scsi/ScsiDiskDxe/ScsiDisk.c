@@ -339,6 +339,7 @@ ScsiDiskDriverBindingStart (
   ScsiDiskDevice->Handle                            = Controller;
   ScsiDiskDevice->FuaMode                           = TRUE;
   InitializeListHead (&ScsiDiskDevice->AsyncTaskQueue);
+  InitializeListHead (&ScsiDiskDevice->AsyncRequestPool);
 
   ScsiIo->GetDeviceType (ScsiIo, &(ScsiDiskDevice->DeviceType));
   switch (ScsiDiskDevice->DeviceType) {
@@ -2757,6 +2758,16 @@ ScsiDiskInquiryDevice (
             ScsiDiskDevice->BlkIo.Media->OptimalTransferLengthGranularity =
               (BlockLimits->OptimalTransferLengthGranularity2 << 8) |
               BlockLimits->OptimalTransferLengthGranularity1;
+            ScsiDiskDevice->MaxTransferBlocks =
+              (BlockLimits->MaximumTransferLength4 << 24) |
+              (BlockLimits->MaximumTransferLength3 << 16) |
+              (BlockLimits->MaximumTransferLength2 << 8)  |
+              BlockLimits->MaximumTransferLength1;
+            ScsiDiskDevice->OptimalTransferBlocks =
+              (BlockLimits->OptimalTransferLength4 << 24) |
+              (BlockLimits->OptimalTransferLength3 << 16) |
+              (BlockLimits->OptimalTransferLength2 << 8)  |
+              BlockLimits->OptimalTransferLength1;
 
             ScsiDiskDevice->UnmapInfo.MaxLbaCnt =
               (BlockLimits->MaximumUnmapLbaCount4 << 24) |
@@ -3523,6 +3534,52 @@ ParseInquiryData (
   ScsiDiskDevice->BlkIoMedia.RemovableMedia = (BOOLEAN)(!ScsiDiskDevice->FixedDevice);
 }
 
+/**
+  Get the largest number of blocks to transfer with one Read/Write command.
+
+  The limit of the command descriptor block is lowered to the maximum transfer
+  length reported in the Block Limits VPD page. A nonblocking request is split
+  further at the optimal transfer length, which keeps more of its commands in
+  flight at once. The result is rounded down to the optimal transfer length
+  granularity, so that the chunks of a request stay aligned to it.
+
+  @param  ScsiDiskDevice     The pointer of ScsiDiskDevice.
+  @param  Async              The blocks are transferred for a nonblocking request.
+
+  @return The number of blocks.
+
+**/
+UINT32
+ScsiDiskGetMaxTransferBlocks (
+  IN  SCSI_DISK_DEV  *ScsiDiskDevice,
+  IN  BOOLEAN        Async
+  )
+{
+  UINT32  MaxBlock;
+  UINT32  Granularity;
+
+  if (!ScsiDiskDevice->Cdb16Byte) {
+    MaxBlock = 0xFFFF;
+  } else {
+    MaxBlock = 0xFFFFFFFF;
+  }
+
+  if (ScsiDiskDevice->MaxTransferBlocks != 0) {
+    MaxBlock = MIN (MaxBlock, ScsiDiskDevice->MaxTransferBlocks);
+  }
+
+  if (Async && (ScsiDiskDevice->OptimalTransferBlocks != 0)) {
+    MaxBlock = MIN (MaxBlock, ScsiDiskDevice->OptimalTransferBlocks);
+  }
+
+  Granularity = ScsiDiskDevice->BlkIo.Media->OptimalTransferLengthGranularity;
+  if ((Granularity > 1) && (MaxBlock >= Granularity)) {
+    MaxBlock -= MaxBlock % Granularity;
+  }
+
+  return MaxBlock;
+}
+
 /**
   Read sector from SCSI Disk.
 
@@ -3564,11 +3621,7 @@ ScsiDiskReadSectors (
   //
   // limit the data bytes that can be transferred by one Read(10) or Read(16) Command
   //
-  if (!ScsiDiskDevice->Cdb16Byte) {
-    MaxBlock = 0xFFFF;
-  } else {
-    MaxBlock = 0xFFFFFFFF;
-  }
+  MaxBlock = ScsiDiskGetMaxTransferBlocks (ScsiDiskDevice, FALSE);
 
   PtrBuffer = Buffer;
 
@@ -3729,11 +3782,7 @@ ScsiDiskWriteSectors (
   //
   // limit the data bytes that can be transferred by one Read(10) or Read(16) Command
   //
-  if (!ScsiDiskDevice->Cdb16Byte) {
-    MaxBlock = 0xFFFF;
-  } else {
-    MaxBlock = 0xFFFFFFFF;
-  }
+  MaxBlock = ScsiDiskGetMaxTransferBlocks (ScsiDiskDevice, FALSE);
 
   PtrBuffer = Buffer;
 
@@ -3913,11 +3962,7 @@ ScsiDiskAsyncReadSectors (
   // Limit the data bytes that can be transferred by one Read(10) or Read(16)
   // Command
   //
-  if (!ScsiDiskDevice->Cdb16Byte) {
-    MaxBlock = 0xFFFF;
-  } else {
-    MaxBlock = 0xFFFFFFFF;
-  }
+  MaxBlock = ScsiDiskGetMaxTransferBlocks (ScsiDiskDevice, TRUE);
 
   PtrBuffer = Buffer;
 
@@ -4131,11 +4176,7 @@ ScsiDiskAsyncWriteSectors (
   // Limit the data bytes that can be transferred by one Read(10) or Read(16)
   // Command
   //
-  if (!ScsiDiskDevice->Cdb16Byte) {
-    MaxBlock = 0xFFFF;
-  } else {
-    MaxBlock = 0xFFFFFFFF;
-  }
+  MaxBlock = ScsiDiskGetMaxTransferBlocks (ScsiDiskDevice, TRUE);
 
   PtrBuffer = Buffer;
 
@@ -5153,8 +5194,95 @@ Exit:
     gBS->SignalEvent (Token->Event);
   }
 
-  FreePool (Request->SenseData);
-  FreePool (Request);
+  ScsiDiskFreeAsyncRequest (Request->ScsiDiskDevice, Request);
+}
+
+/**
+  Get a SCSI Read/Write request for an asynchronous command, reusing one from
+  the request pool of the device if there is any.
+
+  @param  ScsiDiskDevice     The pointer of ScsiDiskDevice.
+
+  @return The zeroed request with its sense data buffer, or NULL if it could
+          not be allocated.
+
+**/
+SCSI_ASYNC_RW_REQUEST *
+ScsiDiskAllocateAsyncRequest (
+  IN  SCSI_DISK_DEV  *ScsiDiskDevice
+  )
+{
+  SCSI_ASYNC_RW_REQUEST  *Request;
+  EFI_SCSI_SENSE_DATA    *SenseData;
+  EFI_TPL                OldTpl;
+
+  Request = NULL;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (!IsListEmpty (&ScsiDiskDevice->AsyncRequestPool)) {
+    Request = BASE_CR (
+                GetFirstNode (&ScsiDiskDevice->AsyncRequestPool),
+                SCSI_ASYNC_RW_REQUEST,
+                Link
+                );
+    RemoveEntryList (&Request->Link);
+    ScsiDiskDevice->AsyncRequestPoolCount--;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Request != NULL) {
+    SenseData = Request->SenseData;
+  } else {
+    Request = AllocatePool (sizeof (SCSI_ASYNC_RW_REQUEST));
+    if (Request == NULL) {
+      return NULL;
+    }
+
+    SenseData = AllocatePool (SCSI_ASYNC_RW_SENSE_DATA_LENGTH);
+    if (SenseData == NULL) {
+      FreePool (Request);
+      return NULL;
+    }
+  }
+
+  ZeroMem (Request, sizeof (SCSI_ASYNC_RW_REQUEST));
+  ZeroMem (SenseData, SCSI_ASYNC_RW_SENSE_DATA_LENGTH);
+  Request->SenseData       = SenseData;
+  Request->SenseDataLength = (UINT8)SCSI_ASYNC_RW_SENSE_DATA_LENGTH;
+
+  return Request;
+}
+
+/**
+  Return a SCSI Read/Write request which is no longer in any queue to the
+  request pool of the device, or free it if the pool is full.
+
+  @param  ScsiDiskDevice     The pointer of ScsiDiskDevice.
+  @param  Request            The request to release.
+
+**/
+VOID
+ScsiDiskFreeAsyncRequest (
+  IN  SCSI_DISK_DEV          *ScsiDiskDevice,
+  IN  SCSI_ASYNC_RW_REQUEST  *Request
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (ScsiDiskDevice->AsyncRequestPoolCount < SCSI_DISK_ASYNC_REQUEST_POOL_SIZE) {
+    InsertHeadList (&ScsiDiskDevice->AsyncRequestPool, &Request->Link);
+    ScsiDiskDevice->AsyncRequestPoolCount++;
+    Request = NULL;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Request != NULL) {
+    FreePool (Request->SenseData);
+    FreePool (Request);
+  }
 }
 
 /**
@@ -5197,7 +5325,7 @@ ScsiDiskAsyncRead10 (
 
   AsyncIoEvent = NULL;
 
-  Request = AllocateZeroPool (sizeof (SCSI_ASYNC_RW_REQUEST));
+  Request = ScsiDiskAllocateAsyncRequest (ScsiDiskDevice);
   if (Request == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -5206,13 +5334,6 @@ ScsiDiskAsyncRead10 (
   InsertTailList (&BlkIo2Req->ScsiRWQueue, &Request->Link);
   gBS->RestoreTPL (OldTpl);
 
-  Request->SenseDataLength = (UINT8)(6 * sizeof (EFI_SCSI_SENSE_DATA));
-  Request->SenseData       = AllocateZeroPool (Request->SenseDataLength);
-  if (Request->SenseData == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto ErrorExit;
-  }
-
   Request->ScsiDiskDevice = ScsiDiskDevice;
   Request->Timeout        = Timeout;
   Request->TimesRetry     = TimesRetry;
@@ -5260,17 +5381,11 @@ ErrorExit:
     gBS->CloseEvent (AsyncIoEvent);
   }
 
-  if (Request != NULL) {
-    if (Request->SenseData != NULL) {
-      FreePool (Request->SenseData);
-    }
-
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    RemoveEntryList (&Request->Link);
-    gBS->RestoreTPL (OldTpl);
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  RemoveEntryList (&Request->Link);
+  gBS->RestoreTPL (OldTpl);
 
-    FreePool (Request);
-  }
+  ScsiDiskFreeAsyncRequest (ScsiDiskDevice, Request);
 
   return Status;
 }
@@ -5315,7 +5430,7 @@ ScsiDiskAsyncWrite10 (
 
   AsyncIoEvent = NULL;
 
-  Request = AllocateZeroPool (sizeof (SCSI_ASYNC_RW_REQUEST));
+  Request = ScsiDiskAllocateAsyncRequest (ScsiDiskDevice);
   if (Request == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -5324,13 +5439,6 @@ ScsiDiskAsyncWrite10 (
   InsertTailList (&BlkIo2Req->ScsiRWQueue, &Request->Link);
   gBS->RestoreTPL (OldTpl);
 
-  Request->SenseDataLength = (UINT8)(6 * sizeof (EFI_SCSI_SENSE_DATA));
-  Request->SenseData       = AllocateZeroPool (Request->SenseDataLength);
-  if (Request->SenseData == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto ErrorExit;
-  }
-
   Request->ScsiDiskDevice = ScsiDiskDevice;
   Request->Timeout        = Timeout;
   Request->TimesRetry     = TimesRetry;
@@ -5378,17 +5486,11 @@ ErrorExit:
     gBS->CloseEvent (AsyncIoEvent);
   }
 
-  if (Request != NULL) {
-    if (Request->SenseData != NULL) {
-      FreePool (Request->SenseData);
-    }
-
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    RemoveEntryList (&Request->Link);
-    gBS->RestoreTPL (OldTpl);
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  RemoveEntryList (&Request->Link);
+  gBS->RestoreTPL (OldTpl);
 
-    FreePool (Request);
-  }
+  ScsiDiskFreeAsyncRequest (ScsiDiskDevice, Request);
 
   return Status;
 }
@@ -5433,7 +5535,7 @@ ScsiDiskAsyncRead16 (
 
   AsyncIoEvent = NULL;
 
-  Request = AllocateZeroPool (sizeof (SCSI_ASYNC_RW_REQUEST));
+  Request = ScsiDiskAllocateAsyncRequest (ScsiDiskDevice);
   if (Request == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -5442,13 +5544,6 @@ ScsiDiskAsyncRead16 (
   InsertTailList (&BlkIo2Req->ScsiRWQueue, &Request->Link);
   gBS->RestoreTPL (OldTpl);
 
-  Request->SenseDataLength = (UINT8)(6 * sizeof (EFI_SCSI_SENSE_DATA));
-  Request->SenseData       = AllocateZeroPool (Request->SenseDataLength);
-  if (Request->SenseData == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto ErrorExit;
-  }
-
   Request->ScsiDiskDevice = ScsiDiskDevice;
   Request->Timeout        = Timeout;
   Request->TimesRetry     = TimesRetry;
@@ -5496,17 +5591,11 @@ ErrorExit:
     gBS->CloseEvent (AsyncIoEvent);
   }
 
-  if (Request != NULL) {
-    if (Request->SenseData != NULL) {
-      FreePool (Request->SenseData);
-    }
-
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    RemoveEntryList (&Request->Link);
-    gBS->RestoreTPL (OldTpl);
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  RemoveEntryList (&Request->Link);
+  gBS->RestoreTPL (OldTpl);
 
-    FreePool (Request);
-  }
+  ScsiDiskFreeAsyncRequest (ScsiDiskDevice, Request);
 
   return Status;
 }
@@ -5551,7 +5640,7 @@ ScsiDiskAsyncWrite16 (
 
   AsyncIoEvent = NULL;
 
-  Request = AllocateZeroPool (sizeof (SCSI_ASYNC_RW_REQUEST));
+  Request = ScsiDiskAllocateAsyncRequest (ScsiDiskDevice);
   if (Request == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -5560,13 +5649,6 @@ ScsiDiskAsyncWrite16 (
   InsertTailList (&BlkIo2Req->ScsiRWQueue, &Request->Link);
   gBS->RestoreTPL (OldTpl);
 
-  Request->SenseDataLength = (UINT8)(6 * sizeof (EFI_SCSI_SENSE_DATA));
-  Request->SenseData       = AllocateZeroPool (Request->SenseDataLength);
-  if (Request->SenseData == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto ErrorExit;
-  }
-
   Request->ScsiDiskDevice = ScsiDiskDevice;
   Request->Timeout        = Timeout;
   Request->TimesRetry     = TimesRetry;
@@ -5614,17 +5696,11 @@ ErrorExit:
     gBS->CloseEvent (AsyncIoEvent);
   }
 
-  if (Request != NULL) {
-    if (Request->SenseData != NULL) {
-      FreePool (Request->SenseData);
-    }
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  RemoveEntryList (&Request->Link);
+  gBS->RestoreTPL (OldTpl);
 
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    RemoveEntryList (&Request->Link);
-    gBS->RestoreTPL (OldTpl);
-
-    FreePool (Request);
-  }
+  ScsiDiskFreeAsyncRequest (ScsiDiskDevice, Request);
 
   return Status;
 }
@@ -5992,6 +6068,8 @@ ReleaseScsiDiskDeviceResources (
   IN  SCSI_DISK_DEV  *ScsiDiskDevice
   )
 {
+  SCSI_ASYNC_RW_REQUEST  *Request;
+
   if (ScsiDiskDevice == NULL) {
     return;
   }
@@ -6001,6 +6079,19 @@ ReleaseScsiDiskDeviceResources (
     ScsiDiskDevice->SenseData = NULL;
   }
 
+  while (!IsListEmpty (&ScsiDiskDevice->AsyncRequestPool)) {
+    Request = BASE_CR (
+                GetFirstNode (&ScsiDiskDevice->AsyncRequestPool),
+                SCSI_ASYNC_RW_REQUEST,
+                Link
+                );
+    RemoveEntryList (&Request->Link);
+    FreePool (Request->SenseData);
+    FreePool (Request);
+  }
+
+  ScsiDiskDevice->AsyncRequestPoolCount = 0;
+
   if (ScsiDiskDevice->ControllerNameTable != NULL) {
     FreeUnicodeStringTable (ScsiDiskDevice->ControllerNameTable);
     ScsiDiskDevice->ControllerNameTable = NULL;
@@ -83,6 +83,13 @@ typedef struct {
   SCSI_UNMAP_PARAM_INFO                    UnmapInfo;
   BOOLEAN                                  BlockLimitsVpdSupported;
 
+  //
+  // Maximum and optimal transfer lengths in blocks from the Block Limits VPD
+  // page, 0 if not reported
+  //
+  UINT32                                   MaxTransferBlocks;
+  UINT32                                   OptimalTransferBlocks;
+
   //
   // The flag indicates if 16-byte command can be used
   //
@@ -93,12 +100,21 @@ typedef struct {
   //
   LIST_ENTRY                               AsyncTaskQueue;
 
+  //
+  // Completed SCSI Read/Write requests kept for reuse by later asynchronous
+  // commands, at most SCSI_DISK_ASYNC_REQUEST_POOL_SIZE of them
+  //
+  LIST_ENTRY                               AsyncRequestPool;
+  UINTN                                    AsyncRequestPoolCount;
+
   //
   // The flag indicates FUA support
   //
   BOOLEAN                                  FuaMode;
 } SCSI_DISK_DEV;
 
+#define SCSI_DISK_ASYNC_REQUEST_POOL_SIZE  32
+
 #define SCSI_DISK_DEV_FROM_BLKIO(a)     CR (a, SCSI_DISK_DEV, BlkIo, SCSI_DISK_DEV_SIGNATURE)
 #define SCSI_DISK_DEV_FROM_BLKIO2(a)    CR (a, SCSI_DISK_DEV, BlkIo2, SCSI_DISK_DEV_SIGNATURE)
 #define SCSI_DISK_DEV_FROM_ERASEBLK(a)  CR (a, SCSI_DISK_DEV, EraseBlock, SCSI_DISK_DEV_SIGNATURE)
@@ -153,6 +169,8 @@ typedef struct {
   LIST_ENTRY             Link;
 } SCSI_ASYNC_RW_REQUEST;
 
+#define SCSI_ASYNC_RW_SENSE_DATA_LENGTH  (6 * sizeof (EFI_SCSI_SENSE_DATA))
+
 //
 // Private data structure for an EraseBlock request
 //
@@ -1382,6 +1400,35 @@ ScsiDiskAsyncWrite16 (
   IN     EFI_BLOCK_IO2_TOKEN  *Token
   );
 
+/**
+  Get a SCSI Read/Write request for an asynchronous command, reusing one from
+  the request pool of the device if there is any.
+
+  @param  ScsiDiskDevice     The pointer of ScsiDiskDevice.
+
+  @return The zeroed request with its sense data buffer, or NULL if it could
+          not be allocated.
+
+**/
+SCSI_ASYNC_RW_REQUEST *
+ScsiDiskAllocateAsyncRequest (
+  IN  SCSI_DISK_DEV  *ScsiDiskDevice
+  );
+
+/**
+  Return a SCSI Read/Write request which is no longer in any queue to the
+  request pool of the device, or free it if the pool is full.
+
+  @param  ScsiDiskDevice     The pointer of ScsiDiskDevice.
+  @param  Request            The request to release.
+
+**/
+VOID
+ScsiDiskFreeAsyncRequest (
+  IN  SCSI_DISK_DEV          *ScsiDiskDevice,
+  IN  SCSI_ASYNC_RW_REQUEST  *Request
+  );
+
 /**
   Get information from media read capacity command.
 
@@ -1508,6 +1555,21 @@ ScsiDiskHaveSenseKey (
   IN  UINTN                SenseCounts
   );
 
+/**
+  Get the largest number of blocks to transfer with one Read/Write command.
+
+  @param  ScsiDiskDevice     The pointer of ScsiDiskDevice.
+  @param  Async              The blocks are transferred for a nonblocking request.
+
+  @return The number of blocks.
+
+**/
+UINT32
+ScsiDiskGetMaxTransferBlocks (
+  IN  SCSI_DISK_DEV  *ScsiDiskDevice,
+  IN  BOOLEAN        Async
+  );
+
 /**
   Release resource about disk device.
 
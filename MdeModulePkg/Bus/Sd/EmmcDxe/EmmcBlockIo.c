@@ -25,6 +25,7 @@ AsyncIoCallback (
 {
   EMMC_REQUEST  *Request;
   EFI_STATUS    Status;
+  EFI_STATUS    TransactionStatus;
 
   Status = gBS->CloseEvent (Event);
   if (EFI_ERROR (Status)) {
@@ -33,18 +34,28 @@ AsyncIoCallback (
 
   Request = (EMMC_REQUEST *)Context;
 
-  DEBUG_CODE_BEGIN ();
-  DEBUG ((
-    DEBUG_INFO,
-    "Emmc Async Request: CmdIndex[%d] Arg[%08x] %r\n",
-    Request->SdMmcCmdBlk.CommandIndex,
-    Request->SdMmcCmdBlk.CommandArgument,
-    Request->Packet.TransactionStatus
-    ));
-  DEBUG_CODE_END ();
+  if (Request->IsQueued) {
+    TransactionStatus = Request->QueueRequest.TransactionStatus;
+    DEBUG ((
+      DEBUG_INFO,
+      "Emmc Async Queued Request: Addr[%08x] BlkNo[%x] %r\n",
+      Request->QueueRequest.Address,
+      Request->QueueRequest.BlockCount,
+      TransactionStatus
+      ));
+  } else {
+    TransactionStatus = Request->Packet.TransactionStatus;
+    DEBUG ((
+      DEBUG_INFO,
+      "Emmc Async Request: CmdIndex[%d] Arg[%08x] %r\n",
+      Request->SdMmcCmdBlk.CommandIndex,
+      Request->SdMmcCmdBlk.CommandArgument,
+      TransactionStatus
+      ));
+  }
 
-  if (EFI_ERROR (Request->Packet.TransactionStatus)) {
-    Request->Token->TransactionStatus = Request->Packet.TransactionStatus;
+  if (EFI_ERROR (TransactionStatus)) {
+    Request->Token->TransactionStatus = TransactionStatus;
   }
 
   RemoveEntryList (&Request->Link);
@@ -776,6 +787,215 @@ Error:
   return Status;
 }
 
+/**
+  Fill in an EMMC_REQUEST for a transfer through the command queue.
+
+  @param[in]  Partition         A pointer to the EMMC_PARTITION instance.
+  @param[in]  Request           The request to fill in.
+  @param[in]  Lba               The starting logical block address to be read/written.
+  @param[in]  Buffer            A pointer to the destination/source buffer for the data.
+  @param[in]  BufferSize        Size of Buffer, must be a multiple of device block size.
+  @param[in]  IsRead            Indicates it is a read or write operation.
+
+**/
+STATIC
+VOID
+EmmcInitQueueRequest (
+  IN  EMMC_PARTITION  *Partition,
+  IN  EMMC_REQUEST    *Request,
+  IN  EFI_LBA         Lba,
+  IN  VOID            *Buffer,
+  IN  UINTN           BufferSize,
+  IN  BOOLEAN         IsRead
+  )
+{
+  Request->Signature               = EMMC_REQUEST_SIGNATURE;
+  Request->IsQueued                = TRUE;
+  Request->QueueRequest.BlockCount = (UINT32)(BufferSize / Partition->BlockMedia.BlockSize);
+  Request->QueueRequest.Buffer     = Buffer;
+  Request->QueueRequest.IsRead     = IsRead;
+  //
+  // Same timeout as EmmcRwMultiBlocks(), taking 2MB/s as the lowest speed.
+  //
+  Request->QueueRequest.Timeout = (BufferSize / (2 * 1024 * 1024) + 1) * 1000 * 1000;
+
+  if (Partition->Device->SectorAddressing) {
+    Request->QueueRequest.Address = (UINT32)Lba;
+  } else {
+    Request->QueueRequest.Address = (UINT32)MultU64x32 (Lba, Partition->BlockMedia.BlockSize);
+  }
+}
+
+/**
+  Read/write blocks of the user data area through the command queue of the
+  host controller, which keeps several transfers in flight on the device.
+
+  A nonblocking request is queued as a single transfer, it is left to
+  EmmcRwMultiBlocks() if it is larger than a queued transfer can be. A
+  blocking request is split into transfers of at most QueueMaxBlocks blocks,
+  and up to QueueDepth of them are queued at once.
+
+  @param[in]      Partition     A pointer to the EMMC_PARTITION instance.
+  @param[in, out] Lba           The starting logical block address to be read/written.
+                                On return, the block following the data transferred.
+  @param[in, out] Buffer        A pointer to the destination/source buffer for the data.
+                                On return, the data following the data transferred.
+  @param[in, out] BufferSize    Size of Buffer, must be a multiple of device block size.
+                                On return, the size of the data left to transfer.
+  @param[in]      IsRead        Indicates it is a read or write operation.
+  @param[in]      Token         A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS           The data was transferred, or queued for a nonblocking
+                                request.
+  @retval EFI_UNSUPPORTED       The data left must be transferred without the command
+                                queue.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be executed due to a lack of resources.
+  @retval Others                The request could not be executed successfully.
+
+**/
+EFI_STATUS
+EmmcQueueReadWrite (
+  IN     EMMC_PARTITION       *Partition,
+  IN OUT EFI_LBA              *Lba,
+  IN OUT VOID                 **Buffer,
+  IN OUT UINTN                *BufferSize,
+  IN     BOOLEAN              IsRead,
+  IN     EFI_BLOCK_IO2_TOKEN  *Token
+  )
+{
+  EFI_STATUS                           Status;
+  EMMC_DEVICE                          *Device;
+  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *CommandQueue;
+  EMMC_REQUEST                         *Requests;
+  EMMC_REQUEST                         *Request;
+  UINTN                                BlockSize;
+  UINTN                                Size;
+  UINTN                                Count;
+  UINTN                                Index;
+  EFI_TPL                              OldTpl;
+
+  Device       = Partition->Device;
+  CommandQueue = Device->Private->CommandQueue;
+  BlockSize    = Partition->BlockMedia.BlockSize;
+
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    if ((*BufferSize / BlockSize) > Device->QueueMaxBlocks) {
+      return EFI_UNSUPPORTED;
+    }
+
+    Request = AllocateZeroPool (sizeof (EMMC_REQUEST));
+    if (Request == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    EmmcInitQueueRequest (Partition, Request, *Lba, *Buffer, *BufferSize, IsRead);
+    Request->IsEnd = TRUE;
+    Request->Token = Token;
+
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    AsyncIoCallback,
+                    Request,
+                    &Request->Event
+                    );
+    if (EFI_ERROR (Status)) {
+      FreePool (Request);
+      return Status;
+    }
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    InsertTailList (&Partition->Queue, &Request->Link);
+    gBS->RestoreTPL (OldTpl);
+
+    Status = CommandQueue->Submit (CommandQueue, Device->Slot, &Request->QueueRequest, Request->Event);
+    if (EFI_ERROR (Status)) {
+      OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+      RemoveEntryList (&Request->Link);
+      gBS->RestoreTPL (OldTpl);
+      gBS->CloseEvent (Request->Event);
+      FreePool (Request);
+      if (Status == EFI_UNSUPPORTED) {
+        Device->QueueMaxBlocks = 0;
+      }
+
+      return Status;
+    }
+
+    *Lba       += *BufferSize / BlockSize;
+    *Buffer     = (UINT8 *)*Buffer + *BufferSize;
+    *BufferSize = 0;
+    return EFI_SUCCESS;
+  }
+
+  Requests = AllocateZeroPool (Device->QueueDepth * sizeof (EMMC_REQUEST));
+  if (Requests == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_SUCCESS;
+  while ((*BufferSize > 0) && !EFI_ERROR (Status)) {
+    //
+    // Queue as many transfers as the device takes. Their completion events
+    // are only polled.
+    //
+    for (Count = 0; (Count < Device->QueueDepth) && (*BufferSize > 0); Count++) {
+      Request = &Requests[Count];
+      ZeroMem (Request, sizeof (EMMC_REQUEST));
+      Status = gBS->CreateEvent (0, 0, NULL, NULL, &Request->Event);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Size = MIN (*BufferSize, Device->QueueMaxBlocks * BlockSize);
+      EmmcInitQueueRequest (Partition, Request, *Lba, *Buffer, Size, IsRead);
+      Status = CommandQueue->Submit (CommandQueue, Device->Slot, &Request->QueueRequest, Request->Event);
+      if (EFI_ERROR (Status)) {
+        gBS->CloseEvent (Request->Event);
+        break;
+      }
+
+      *Lba        += Size / BlockSize;
+      *Buffer      = (UINT8 *)*Buffer + Size;
+      *BufferSize -= Size;
+    }
+
+    if (Status == EFI_UNSUPPORTED) {
+      Device->QueueMaxBlocks = 0;
+    }
+
+    //
+    // Wait for the queued transfers, they may complete in any order.
+    //
+    for (Index = 0; Index < Count; Index++) {
+      Request = &Requests[Index];
+      while (gBS->CheckEvent (Request->Event) == EFI_NOT_READY) {
+      }
+
+      gBS->CloseEvent (Request->Event);
+      if (EFI_ERROR (Request->QueueRequest.TransactionStatus) &&
+          (!EFI_ERROR (Status) || (Status == EFI_UNSUPPORTED)))
+      {
+        Status = Request->QueueRequest.TransactionStatus;
+      }
+    }
+  }
+
+  FreePool (Requests);
+
+  DEBUG ((
+    DEBUG_BLKIO,
+    "EmmcQueue%a(): Part %d Lba 0x%lx Left 0x%x with %r\n",
+    IsRead ? "Read " : "Write",
+    Partition->PartitionType,
+    *Lba,
+    *BufferSize,
+    Status
+    ));
+
+  return Status;
+}
+
 /**
   This function transfers data from/to EMMC device.
 
@@ -884,6 +1104,19 @@ EmmcReadWrite (
     Device->ExtCsd.PartitionConfig = PartitionConfig;
   }
 
+  //
+  // Queue the transfers of the user data area when the host controller can.
+  // Whatever the command queue leaves is transferred one command at a time.
+  //
+  if ((Device->QueueMaxBlocks != 0) && (Partition->PartitionType == EmmcPartitionUserData)) {
+    Status = EmmcQueueReadWrite (Partition, &Lba, &Buffer, &BufferSize, IsRead, Token);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+
+    BlockNum = BufferSize / BlockSize;
+  }
+
   //
   // Start to execute data transfer. The max block number in single cmd is 65535 blocks.
   //
@@ -1092,9 +1325,17 @@ EmmcResetEx (
        Link = NextLink)
   {
     NextLink = GetNextNode (&Partition->Queue, Link);
-    RemoveEntryList (Link);
+    Request  = EMMC_REQUEST_FROM_LINK (Link);
 
-    Request = EMMC_REQUEST_FROM_LINK (Link);
+    //
+    // The host controller owns a queued transfer until it completes or times
+    // out, the request is freed by AsyncIoCallback() then.
+    //
+    if (Request->IsQueued) {
+      continue;
+    }
+
+    RemoveEntryList (Link);
 
     gBS->CloseEvent (Request->Event);
     Request->Token->TransactionStatus = EFI_ABORTED;
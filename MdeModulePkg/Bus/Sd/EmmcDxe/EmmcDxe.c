@@ -632,6 +632,21 @@ DiscoverEmmcDevice (
       goto Error;
     }
 
+    Device->QueueDepth     = 0;
+    Device->QueueMaxBlocks = 0;
+    if (Private->CommandQueue != NULL) {
+      Status = Private->CommandQueue->GetInfo (
+                                        Private->CommandQueue,
+                                        Slot,
+                                        &Device->QueueDepth,
+                                        &Device->QueueMaxBlocks
+                                        );
+      if (EFI_ERROR (Status)) {
+        Device->QueueDepth     = 0;
+        Device->QueueMaxBlocks = 0;
+      }
+    }
+
     Status = gBS->InstallProtocolInterface (
                     &Device->Handle,
                     &gEfiDevicePathProtocolGuid,
@@ -896,6 +911,21 @@ EmmcDxeDriverBindingStart (
                     EFI_OPEN_PROTOCOL_GET_PROTOCOL
                     );
     ASSERT_EFI_ERROR (Status);
+    //
+    // The command queue is optional, transfers go through PassThru without it.
+    //
+    Status = gBS->OpenProtocol (
+                    Controller,
+                    &gEdkiiSdMmcCommandQueueProtocolGuid,
+                    (VOID **)&Private->CommandQueue,
+                    This->DriverBindingHandle,
+                    Controller,
+                    EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                    );
+    if (EFI_ERROR (Status)) {
+      Private->CommandQueue = NULL;
+    }
+
     Private->PassThru            = PassThru;
     Private->Controller          = Controller;
     Private->ParentDevicePath    = ParentDevicePath;
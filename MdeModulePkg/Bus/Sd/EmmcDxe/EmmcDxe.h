@@ -15,6 +15,7 @@
 #include <IndustryStandard/Emmc.h>
 
 #include <Protocol/SdMmcPassThru.h>
+#include <Protocol/SdMmcCommandQueue.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/BlockIo2.h>
 #include <Protocol/StorageSecurityCommand.h>
@@ -80,6 +81,11 @@ typedef struct {
   EFI_SD_MMC_COMMAND_BLOCK               SdMmcCmdBlk;
   EFI_SD_MMC_STATUS_BLOCK                SdMmcStatusBlk;
   EFI_SD_MMC_PASS_THRU_COMMAND_PACKET    Packet;
+  //
+  // Used instead of Packet when the transfer goes through the command queue.
+  //
+  EDKII_SD_MMC_COMMAND_QUEUE_REQUEST     QueueRequest;
+  BOOLEAN                                IsQueued;
 
   BOOLEAN                                IsEnd;
 
@@ -123,6 +129,12 @@ struct _EMMC_DEVICE {
   EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
   UINT8                       Slot;
   BOOLEAN                     SectorAddressing;
+  //
+  // Parameters of the command queue of the slot, QueueMaxBlocks is 0 if
+  // transfers can't be queued.
+  //
+  UINT32                      QueueDepth;
+  UINT32                      QueueMaxBlocks;
 
   EMMC_PARTITION              Partition[EMMC_MAX_PARTITIONS];
   EMMC_CSD                    Csd;
@@ -144,12 +156,13 @@ struct _EMMC_DEVICE {
 // EMMC DXE driver private data structure
 //
 struct _EMMC_DRIVER_PRIVATE_DATA {
-  EFI_SD_MMC_PASS_THRU_PROTOCOL    *PassThru;
-  EFI_HANDLE                       Controller;
-  EFI_DEVICE_PATH_PROTOCOL         *ParentDevicePath;
-  EFI_HANDLE                       DriverBindingHandle;
+  EFI_SD_MMC_PASS_THRU_PROTOCOL          *PassThru;
+  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL    *CommandQueue;
+  EFI_HANDLE                             Controller;
+  EFI_DEVICE_PATH_PROTOCOL               *ParentDevicePath;
+  EFI_HANDLE                             DriverBindingHandle;
 
-  EMMC_DEVICE                      Device[EMMC_MAX_DEVICES];
+  EMMC_DEVICE                            Device[EMMC_MAX_DEVICES];
 };
 
 /**
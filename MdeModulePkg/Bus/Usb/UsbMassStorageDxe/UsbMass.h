@@ -26,9 +26,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 typedef struct _USB_MASS_TRANSPORT  USB_MASS_TRANSPORT;
 typedef struct _USB_MASS_DEVICE     USB_MASS_DEVICE;
+typedef struct _USB_MASS_COMMAND    USB_MASS_COMMAND;
 
 #include "UsbMassBot.h"
 #include "UsbMassCbi.h"
+#include "UsbMassUas.h"
 #include "UsbMassBoot.h"
 #include "UsbMassDiskInfo.h"
 #include "UsbMassImpl.h"
@@ -46,6 +48,23 @@ typedef struct _USB_MASS_DEVICE     USB_MASS_DEVICE;
 #define USB_MASS_CMD_FAIL        1
 #define USB_MASS_CMD_PERSISTENT  2
 
+//
+// Maximum number of commands handed to USB_MASS_TRANSPORT.ExecCommandList at once
+//
+#define USB_MASS_MAX_QUEUED_COMMANDS  8
+
+///
+/// One command of a list that is queued to the device at once.
+///
+struct _USB_MASS_COMMAND {
+  VOID                      *Cmd;       ///< The command to transfer to device
+  UINT8                     CmdLen;     ///< The length of the command
+  EFI_USB_DATA_DIRECTION    DataDir;    ///< The direction of data transfer
+  VOID                      *Data;      ///< The buffer to hold the data
+  UINT32                    DataLen;    ///< The length of the buffer
+  UINT32                    CmdStatus;  ///< The result of the command execution
+};
+
 /**
   Initializes USB transport protocol.
 
@@ -98,6 +117,35 @@ EFI_STATUS
   OUT UINT32                  *CmdStatus
   );
 
+/**
+  Execute several USB mass storage commands through the transport protocol,
+  with all of them outstanding on the device at the same time.
+
+  The commands must all transfer data in the same direction. The device may
+  complete them in any order; each command reports its own result in
+  CmdStatus, so some may succeed while others fail.
+
+  @param  Context               The USB Transport Protocol.
+  @param  Commands              The commands to execute.
+  @param  Count                 The number of entries in Commands.
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait for each transfer
+
+  @retval EFI_SUCCESS           All commands completed, check CmdStatus of each.
+  @retval Other                 The transport failed. Commands that did not
+                                complete have CmdStatus USB_MASS_CMD_FAIL.
+
+**/
+typedef
+EFI_STATUS
+(*USB_MASS_EXEC_COMMAND_LIST) (
+  IN     VOID              *Context,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             Count,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  );
+
 /**
   Reset the USB mass storage device by Transport protocol.
 
@@ -154,15 +202,17 @@ EFI_STATUS
 /// two transport protocols. One is the CBI, and the other is BOT.
 /// CBI is being obseleted. The design is made modular by this
 /// structure so that the CBI protocol can be easily removed when
-/// it is no longer necessary.
+/// it is no longer necessary. USB Attached SCSI (UAS) is a third
+/// transport that allows several commands to be outstanding.
 ///
 struct _USB_MASS_TRANSPORT {
-  UINT8                      Protocol;
-  USB_MASS_INIT_TRANSPORT    Init;        ///< Initialize the mass storage transport protocol
-  USB_MASS_EXEC_COMMAND      ExecCommand; ///< Transport command to the device then get result
-  USB_MASS_RESET             Reset;       ///< Reset the device
-  USB_MASS_GET_MAX_LUN       GetMaxLun;   ///< Get max lun, only for bot
-  USB_MASS_CLEAN_UP          CleanUp;     ///< Clean up the resources.
+  UINT8                         Protocol;
+  USB_MASS_INIT_TRANSPORT       Init;            ///< Initialize the mass storage transport protocol
+  USB_MASS_EXEC_COMMAND         ExecCommand;     ///< Transport command to the device then get result
+  USB_MASS_RESET                Reset;           ///< Reset the device
+  USB_MASS_GET_MAX_LUN          GetMaxLun;       ///< Get max lun, only for bot
+  USB_MASS_CLEAN_UP             CleanUp;         ///< Clean up the resources.
+  USB_MASS_EXEC_COMMAND_LIST    ExecCommandList; ///< Queue several commands at once, optional
 };
 
 struct _USB_MASS_DEVICE {
@@ -793,6 +793,132 @@ UsbBootDetectMedia (
   return Status;
 }
 
+/**
+  Read or write some blocks with several commands queued on the device at
+  once, if the transport supports it.
+
+  The blocks are split into USB_BOOT_MAX_CARRY_SIZE pieces as usual, and up
+  to USB_MASS_MAX_QUEUED_COMMANDS pieces are handed to the transport together.
+  On return Lba, TotalBlock and Buffer are advanced past the leading pieces
+  that succeeded. The rest, including a piece that failed, is left to the
+  caller to transfer one command at a time with the usual retry and sense
+  handling.
+
+  @param  UsbMass                The USB mass storage device to access
+  @param  Write                  TRUE for write operation.
+  @param  Cdb16                  TRUE to use the SCSI 16 byte commands.
+  @param  Lba                    On input, the start block number. On output,
+                                 the first block not transferred.
+  @param  TotalBlock             On input, total block number to read or write.
+                                 On output, the block number left.
+  @param  Buffer                 On input, the buffer to read to or write from.
+                                 On output, the buffer for the blocks left.
+
+**/
+VOID
+UsbBootReadWriteQueued (
+  IN     USB_MASS_DEVICE  *UsbMass,
+  IN     BOOLEAN          Write,
+  IN     BOOLEAN          Cdb16,
+  IN OUT UINT64           *Lba,
+  IN OUT UINTN            *TotalBlock,
+  IN OUT UINT8            **Buffer
+  )
+{
+  USB_MASS_COMMAND            Commands[USB_MASS_MAX_QUEUED_COMMANDS];
+  UINT8                       Cmd[USB_MASS_MAX_QUEUED_COMMANDS][16];
+  USB_BOOT_READ_WRITE_10_CMD  *Cmd10;
+  UINT32                      CountMax;
+  UINT32                      BlockSize;
+  UINT32                      Count;
+  UINTN                       Remaining;
+  UINT64                      NextLba;
+  UINT8                       *Data;
+  UINTN                       Number;
+  UINTN                       Index;
+
+  if (UsbMass->Transport->ExecCommandList == NULL) {
+    return;
+  }
+
+  BlockSize = UsbMass->BlockIoMedia.BlockSize;
+  CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
+  if (!Cdb16) {
+    CountMax = MIN (MAX_UINT16, CountMax);
+  }
+
+  //
+  // Queuing only pays off when there is more than one piece.
+  //
+  if (*TotalBlock <= CountMax) {
+    return;
+  }
+
+  Remaining = *TotalBlock;
+  NextLba   = *Lba;
+  Data      = *Buffer;
+
+  for (Number = 0; (Number < USB_MASS_MAX_QUEUED_COMMANDS) && (Remaining > 0); Number++) {
+    Count = (UINT32)MIN (Remaining, CountMax);
+
+    ZeroMem (Cmd[Number], sizeof (Cmd[Number]));
+    if (Cdb16) {
+      Cmd[Number][0] = Write ? EFI_SCSI_OP_WRITE16 : EFI_SCSI_OP_READ16;
+      Cmd[Number][1] = (UINT8)((USB_BOOT_LUN (UsbMass->Lun) & 0xE0));
+      WriteUnaligned64 ((UINT64 *)&Cmd[Number][2], SwapBytes64 (NextLba));
+      WriteUnaligned32 ((UINT32 *)&Cmd[Number][10], SwapBytes32 (Count));
+      Commands[Number].CmdLen = (UINT8)sizeof (Cmd[Number]);
+    } else {
+      Cmd10         = (USB_BOOT_READ_WRITE_10_CMD *)Cmd[Number];
+      Cmd10->OpCode = Write ? USB_BOOT_WRITE10_OPCODE : USB_BOOT_READ10_OPCODE;
+      Cmd10->Lun    = (UINT8)(USB_BOOT_LUN (UsbMass->Lun));
+      WriteUnaligned32 ((UINT32 *)Cmd10->Lba, SwapBytes32 ((UINT32)NextLba));
+      WriteUnaligned16 ((UINT16 *)Cmd10->TransferLen, SwapBytes16 ((UINT16)Count));
+      Commands[Number].CmdLen = (UINT8)sizeof (USB_BOOT_READ_WRITE_10_CMD);
+    }
+
+    Commands[Number].Cmd     = Cmd[Number];
+    Commands[Number].DataDir = Write ? EfiUsbDataOut : EfiUsbDataIn;
+    Commands[Number].Data    = Data;
+    Commands[Number].DataLen = Count * BlockSize;
+
+    NextLba   += Count;
+    Data      += Commands[Number].DataLen;
+    Remaining -= Count;
+  }
+
+  //
+  // USB command's upper limit timeout is 5s. [USB2.0-9.2.6.1]
+  //
+  UsbMass->Transport->ExecCommandList (
+                        UsbMass->Context,
+                        Commands,
+                        Number,
+                        UsbMass->Lun,
+                        USB_BOOT_GENERAL_CMD_TIMEOUT
+                        );
+
+  for (Index = 0; Index < Number; Index++) {
+    if (Commands[Index].CmdStatus != USB_MASS_CMD_SUCCESS) {
+      break;
+    }
+
+    Count        = Commands[Index].DataLen / BlockSize;
+    *Lba        += Count;
+    *Buffer     += Commands[Index].DataLen;
+    *TotalBlock -= Count;
+  }
+
+  DEBUG ((
+    DEBUG_BLKIO,
+    "UsbBoot%sQueued: %d of %d commands done, LBA (0x%lx)\n",
+    Write ? L"Write" : L"Read",
+    Index,
+    Number,
+    *Lba
+    ));
+}
+
 /**
   Read or write some blocks from the device.
 
@@ -822,12 +948,24 @@ UsbBootReadWriteBlocks (
   UINT32                      BlockSize;
   UINT32                      ByteSize;
   UINT32                      Timeout;
+  UINT64                      QueuedLba;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
   CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
+    //
+    // Let the transport queue several pieces at once if it can. A piece
+    // it could not complete is retried below, one command at a time.
+    //
+    QueuedLba = Lba;
+    UsbBootReadWriteQueued (UsbMass, Write, FALSE, &QueuedLba, &TotalBlock, &Buffer);
+    Lba = (UINT32)QueuedLba;
+    if (TotalBlock == 0) {
+      break;
+    }
+
     //
     // Split the total blocks into smaller pieces to ease the pressure
     // on the device. We must split the total block because the READ10
@@ -914,6 +1052,15 @@ UsbBootReadWriteBlocks16 (
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
+    //
+    // Let the transport queue several pieces at once if it can. A piece
+    // it could not complete is retried below, one command at a time.
+    //
+    UsbBootReadWriteQueued (UsbMass, Write, TRUE, &Lba, &TotalBlock, &Buffer);
+    if (TotalBlock == 0) {
+      break;
+    }
+
     //
     // Split the total blocks into smaller pieces.
     //
@@ -274,6 +274,38 @@ UsbBootReadBlocks (
   OUT UINT8            *Buffer
   );
 
+/**
+  Read or write some blocks with several commands queued on the device at
+  once, if the transport supports it.
+
+  The blocks are split into USB_BOOT_MAX_CARRY_SIZE pieces as usual, and up
+  to USB_MASS_MAX_QUEUED_COMMANDS pieces are handed to the transport together.
+  On return Lba, TotalBlock and Buffer are advanced past the leading pieces
+  that succeeded. The rest, including a piece that failed, is left to the
+  caller to transfer one command at a time with the usual retry and sense
+  handling.
+
+  @param  UsbMass                The USB mass storage device to access
+  @param  Write                  TRUE for write operation.
+  @param  Cdb16                  TRUE to use the SCSI 16 byte commands.
+  @param  Lba                    On input, the start block number. On output,
+                                 the first block not transferred.
+  @param  TotalBlock             On input, total block number to read or write.
+                                 On output, the block number left.
+  @param  Buffer                 On input, the buffer to read to or write from.
+                                 On output, the buffer for the blocks left.
+
+**/
+VOID
+UsbBootReadWriteQueued (
+  IN     USB_MASS_DEVICE  *UsbMass,
+  IN     BOOLEAN          Write,
+  IN     BOOLEAN          Cdb16,
+  IN OUT UINT64           *Lba,
+  IN OUT UINTN            *TotalBlock,
+  IN OUT UINT8            **Buffer
+  );
+
 /**
   Read or write some blocks from the device.
 
@@ -9,11 +9,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "UsbMass.h"
 
-#define USB_MASS_TRANSPORT_COUNT  3
+#define USB_MASS_TRANSPORT_COUNT  4
 //
-// Array of USB transport interfaces.
+// Array of USB transport interfaces. UAS comes first so that it is preferred
+// over Bulk-Only for high-speed devices that implement both. SuperSpeed UAS
+// needs bulk streams, which are not supported, so those devices use Bulk-Only.
 //
 USB_MASS_TRANSPORT  *mUsbMassTransport[USB_MASS_TRANSPORT_COUNT] = {
+  &mUsbUasTransport,
   &mUsbCbi0Transport,
   &mUsbCbi1Transport,
   &mUsbBotTransport,
@@ -441,13 +444,21 @@ UsbMassInitTransport (
   // matching transport protocol.
   // If not found, return EFI_UNSUPPORTED.
   // If found, execute USB_MASS_TRANSPORT.Init() to initialize the transport context.
+  // UAS is usually offered by an alternate setting, so it is tried whatever
+  // the protocol of the active setting is, and falls back when unusable.
   //
   for (Index = 0; Index < USB_MASS_TRANSPORT_COUNT; Index++) {
     *Transport = mUsbMassTransport[Index];
 
-    if (Interface.InterfaceProtocol == (*Transport)->Protocol) {
+    if ((Interface.InterfaceProtocol == (*Transport)->Protocol) ||
+        ((*Transport)->Protocol == USB_MASS_STORE_UAS))
+    {
       Status = (*Transport)->Init (UsbIo, Context);
-      break;
+      if (!EFI_ERROR (Status) || (Interface.InterfaceProtocol == (*Transport)->Protocol)) {
+        break;
+      }
+
+      Status = EFI_UNSUPPORTED;
     }
   }
 
@@ -767,6 +778,8 @@ USBMassDriverBindingSupported (
   // matching transport method.
   // If not found, return EFI_UNSUPPORTED.
   // If found, execute USB_MASS_TRANSPORT.Init() to initialize the transport context.
+  // Init() does no bus I/O when it is not given a context, so only the active
+  // setting is checked here. Start() looks for a UAS alternate setting.
   //
   for (Index = 0; Index < USB_MASS_TRANSPORT_COUNT; Index++) {
     Transport = mUsbMassTransport[Index];
@@ -0,0 +1,795 @@
+/** @file
+  Implementation of the USB Attached SCSI (UAS) transport protocol,
+  according to USB Mass Storage Class - USB Attached SCSI Protocol,
+  Revision 1.0.
+
+  UAS uses four bulk pipes: commands are sent as Command IUs on the command
+  pipe, the device tells the host which command's data it is ready to move
+  with READ READY / WRITE READY IUs on the status pipe, the data goes over
+  the data-in or data-out pipe, and each command ends with a Sense IU on the
+  status pipe. Every IU carries a tag, so several commands can be queued on
+  the device at once.
+
+  Only the USB 2.0 form of UAS, without bulk streams, is implemented: the
+  USB I/O Protocol cannot address a stream. SuperSpeed UAS devices require
+  streams, so they are left to the Bulk-Only transport.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbMass.h"
+
+//
+// Definition of USB UAS Transport Protocol
+//
+USB_MASS_TRANSPORT  mUsbUasTransport = {
+  USB_MASS_STORE_UAS,
+  UsbUasInit,
+  UsbUasExecCommand,
+  UsbUasResetDevice,
+  UsbUasGetMaxLun,
+  UsbUasCleanUp,
+  UsbUasExecCommandList
+};
+
+/**
+  Read the active configuration descriptor of the device, together with
+  all of its interface, endpoint and class specific descriptors.
+
+  The USB bus driver always selects the first configuration of the device,
+  so the descriptor at index 0 is read and checked against the active one.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Buffer                Return the descriptors, to be freed by caller.
+  @param  Length                Return the total length of the descriptors.
+
+  @retval EFI_SUCCESS           The descriptors are read.
+  @retval EFI_UNSUPPORTED       The first configuration is not the active one.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the buffer.
+  @retval Others                Failed to read the descriptors.
+
+**/
+EFI_STATUS
+UsbUasGetConfigDescriptor (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo,
+  OUT UINT8                **Buffer,
+  OUT UINTN                *Length
+  )
+{
+  EFI_USB_CONFIG_DESCRIPTOR  ActiveDesc;
+  EFI_USB_DEVICE_REQUEST     Request;
+  EFI_STATUS                 Status;
+  UINT32                     Result;
+
+  Status = UsbIo->UsbGetConfigDescriptor (UsbIo, &ActiveDesc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (ActiveDesc.TotalLength < sizeof (EFI_USB_CONFIG_DESCRIPTOR)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *Buffer = AllocatePool (ActiveDesc.TotalLength);
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request.RequestType = 0x80;
+  Request.Request     = USB_REQ_GET_DESCRIPTOR;
+  Request.Value       = (UINT16)(USB_DESC_TYPE_CONFIG << 8);
+  Request.Index       = 0;
+  Request.Length      = ActiveDesc.TotalLength;
+
+  Status = UsbIo->UsbControlTransfer (
+                    UsbIo,
+                    &Request,
+                    EfiUsbDataIn,
+                    USB_UAS_SEND_IU_TIMEOUT / USB_MASS_1_MILLISECOND,
+                    *Buffer,
+                    ActiveDesc.TotalLength,
+                    &Result
+                    );
+  if (!EFI_ERROR (Status) &&
+      (((EFI_USB_CONFIG_DESCRIPTOR *)*Buffer)->ConfigurationValue != ActiveDesc.ConfigurationValue))
+  {
+    Status = EFI_UNSUPPORTED;
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (*Buffer);
+    return Status;
+  }
+
+  *Length = ActiveDesc.TotalLength;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the UAS alternate setting of the interface and the endpoints of its
+  command, status, data-in and data-out pipes.
+
+  The endpoints are identified by the Pipe Usage descriptor that follows each
+  endpoint descriptor of the setting.
+
+  @param  UsbUas                The USB UAS device. Interface.InterfaceNumber
+                                must be set; on success the whole interface
+                                descriptor and the endpoints are filled in.
+
+  @retval EFI_SUCCESS           A usable UAS setting is found.
+  @retval EFI_UNSUPPORTED       The interface has no usable UAS setting.
+  @retval Others                Failed to read the descriptors.
+
+**/
+EFI_STATUS
+UsbUasFindSetting (
+  IN OUT USB_UAS_PROTOCOL  *UsbUas
+  )
+{
+  EFI_USB_INTERFACE_DESCRIPTOR  *Interface;
+  EFI_USB_ENDPOINT_DESCRIPTOR   *EndPoint;
+  EFI_STATUS                    Status;
+  UINT8                         *Buffer;
+  UINTN                         Length;
+  UINTN                         Offset;
+  UINT8                         DescLength;
+  UINT8                         DescType;
+  UINT8                         EndpointAddress;
+  BOOLEAN                       InSetting;
+  BOOLEAN                       SuperSpeed;
+
+  Status = UsbUasGetConfigDescriptor (UsbUas->UsbIo, &Buffer, &Length);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  InSetting       = FALSE;
+  SuperSpeed      = FALSE;
+  EndpointAddress = 0;
+
+  for (Offset = 0; Offset + 2 <= Length; Offset += DescLength) {
+    DescLength = Buffer[Offset];
+    DescType   = Buffer[Offset + 1];
+    if ((DescLength < 2) || (Offset + DescLength > Length)) {
+      break;
+    }
+
+    if (DescType == USB_DESC_TYPE_INTERFACE) {
+      if (InSetting && (UsbUas->CommandEndpoint != 0) && (UsbUas->StatusEndpoint != 0) &&
+          (UsbUas->DataInEndpoint != 0) && (UsbUas->DataOutEndpoint != 0))
+      {
+        break;
+      }
+
+      Interface = (EFI_USB_INTERFACE_DESCRIPTOR *)&Buffer[Offset];
+      InSetting = (BOOLEAN)((DescLength >= sizeof (EFI_USB_INTERFACE_DESCRIPTOR)) &&
+                            (Interface->InterfaceNumber == UsbUas->Interface.InterfaceNumber) &&
+                            (Interface->InterfaceClass == USB_MASS_STORE_CLASS) &&
+                            (Interface->InterfaceProtocol == USB_MASS_STORE_UAS));
+      if (InSetting) {
+        CopyMem (&UsbUas->Interface, Interface, sizeof (EFI_USB_INTERFACE_DESCRIPTOR));
+        UsbUas->CommandEndpoint = 0;
+        UsbUas->StatusEndpoint  = 0;
+        UsbUas->DataInEndpoint  = 0;
+        UsbUas->DataOutEndpoint = 0;
+        EndpointAddress         = 0;
+      }
+
+      continue;
+    }
+
+    if (!InSetting) {
+      continue;
+    }
+
+    if (DescType == USB_DESC_TYPE_ENDPOINT) {
+      EndPoint        = (EFI_USB_ENDPOINT_DESCRIPTOR *)&Buffer[Offset];
+      EndpointAddress = 0;
+      if ((DescLength >= sizeof (EFI_USB_ENDPOINT_DESCRIPTOR)) && USB_IS_BULK_ENDPOINT (EndPoint->Attributes)) {
+        EndpointAddress = EndPoint->EndpointAddress;
+      }
+    } else if (DescType == USB_UAS_DESC_TYPE_SS_ENDPOINT_COMPANION) {
+      SuperSpeed = TRUE;
+    } else if ((DescType == USB_UAS_DESC_TYPE_PIPE_USAGE) && (DescLength >= 3) && (EndpointAddress != 0)) {
+      switch (Buffer[Offset + 2]) {
+        case USB_UAS_PIPE_ID_COMMAND:
+          if (USB_IS_OUT_ENDPOINT (EndpointAddress)) {
+            UsbUas->CommandEndpoint = EndpointAddress;
+          }
+
+          break;
+
+        case USB_UAS_PIPE_ID_STATUS:
+          if (USB_IS_IN_ENDPOINT (EndpointAddress)) {
+            UsbUas->StatusEndpoint = EndpointAddress;
+          }
+
+          break;
+
+        case USB_UAS_PIPE_ID_DATA_IN:
+          if (USB_IS_IN_ENDPOINT (EndpointAddress)) {
+            UsbUas->DataInEndpoint = EndpointAddress;
+          }
+
+          break;
+
+        case USB_UAS_PIPE_ID_DATA_OUT:
+          if (USB_IS_OUT_ENDPOINT (EndpointAddress)) {
+            UsbUas->DataOutEndpoint = EndpointAddress;
+          }
+
+          break;
+
+        default:
+          break;
+      }
+    }
+  }
+
+  FreePool (Buffer);
+
+  if (!InSetting || (UsbUas->CommandEndpoint == 0) || (UsbUas->StatusEndpoint == 0) ||
+      (UsbUas->DataInEndpoint == 0) || (UsbUas->DataOutEndpoint == 0))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (SuperSpeed) {
+    //
+    // At SuperSpeed every UAS command is bound to a bulk stream, which
+    // the USB I/O Protocol cannot address. Let Bulk-Only drive the device.
+    //
+    DEBUG ((DEBUG_INFO, "UsbUasFindSetting: SuperSpeed UAS needs bulk streams, not used\n"));
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Initializes USB UAS protocol.
+
+  This function looks for an alternate setting of the interface that
+  implements UAS, selects it, and locates the command, status, data-in
+  and data-out pipes. It will save its context which is a USB_UAS_PROTOCOL
+  structure in the Context if Context isn't NULL.
+
+  If Context is NULL, as from the Supported() function of the driver
+  binding, no request is sent to the device. The function then only checks
+  that the active setting of the interface, as cached by the USB bus driver,
+  is a UAS setting.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Context               The buffer to save the context to
+
+  @retval EFI_SUCCESS           The device is successfully initialized.
+  @retval EFI_UNSUPPORTED       The transport protocol doesn't support the device.
+  @retval Other                 The USB UAS initialization fails.
+
+**/
+EFI_STATUS
+UsbUasInit (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo,
+  OUT VOID                 **Context OPTIONAL
+  )
+{
+  USB_UAS_PROTOCOL              *UsbUas;
+  EFI_USB_INTERFACE_DESCRIPTOR  Active;
+  EFI_USB_DEVICE_REQUEST        Request;
+  EFI_STATUS                    Status;
+  UINT32                        Result;
+  UINT32                        Timeout;
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Active);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Active.InterfaceClass != USB_MASS_STORE_CLASS) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Context == NULL) {
+    return (Active.InterfaceProtocol == USB_MASS_STORE_UAS) ? EFI_SUCCESS : EFI_UNSUPPORTED;
+  }
+
+  UsbUas = AllocateZeroPool (sizeof (USB_UAS_PROTOCOL));
+  if (UsbUas == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  UsbUas->UsbIo = UsbIo;
+
+  //
+  // A UAS device normally reports Bulk-Only in its default setting and UAS
+  // in an alternate one, so look through all settings of this interface.
+  //
+  UsbUas->Interface.InterfaceNumber = Active.InterfaceNumber;
+
+  Status = UsbUasFindSetting (UsbUas);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  if (Active.AlternateSetting != UsbUas->Interface.AlternateSetting) {
+    //
+    // Select the UAS setting. The USB bus driver follows the SET_INTERFACE
+    // request and updates the endpoints of this USB I/O instance.
+    //
+    Request.RequestType = 0x01;
+    Request.Request     = USB_REQ_SET_INTERFACE;
+    Request.Value       = UsbUas->Interface.AlternateSetting;
+    Request.Index       = UsbUas->Interface.InterfaceNumber;
+    Request.Length      = 0;
+    Timeout             = USB_UAS_RESET_DEVICE_TIMEOUT / USB_MASS_1_MILLISECOND;
+
+    Status = UsbIo->UsbControlTransfer (
+                      UsbIo,
+                      &Request,
+                      EfiUsbNoData,
+                      Timeout,
+                      NULL,
+                      0,
+                      &Result
+                      );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasInit: Select setting %d (%r)\n", UsbUas->Interface.AlternateSetting, Status));
+      goto ON_ERROR;
+    }
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "UsbUasInit: Interface %d setting %d, Cmd %x Sts %x In %x Out %x\n",
+    UsbUas->Interface.InterfaceNumber,
+    UsbUas->Interface.AlternateSetting,
+    UsbUas->CommandEndpoint,
+    UsbUas->StatusEndpoint,
+    UsbUas->DataInEndpoint,
+    UsbUas->DataOutEndpoint
+    ));
+
+  *Context = UsbUas;
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  FreePool (UsbUas);
+  return Status;
+}
+
+/**
+  Send a Command IU or Task Management IU to the device using the
+  command pipe.
+
+  @param  UsbUas                The USB UAS device
+  @param  Iu                    The IU to send
+  @param  IuLen                 The length of the IU
+
+  @retval EFI_SUCCESS           The IU is sent to the device.
+  @retval Others                Failed to send the IU to device
+
+**/
+EFI_STATUS
+UsbUasSendIu (
+  IN USB_UAS_PROTOCOL  *UsbUas,
+  IN VOID              *Iu,
+  IN UINTN             IuLen
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Result;
+  UINTN       DataLen;
+  UINTN       Timeout;
+
+  Result  = 0;
+  DataLen = IuLen;
+  Timeout = USB_UAS_SEND_IU_TIMEOUT / USB_MASS_1_MILLISECOND;
+
+  Status = UsbUas->UsbIo->UsbBulkTransfer (
+                            UsbUas->UsbIo,
+                            UsbUas->CommandEndpoint,
+                            Iu,
+                            &DataLen,
+                            Timeout,
+                            &Result
+                            );
+  if (EFI_ERROR (Status) && USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+    UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->CommandEndpoint);
+  }
+
+  return Status;
+}
+
+/**
+  Receive the next IU from the status pipe.
+
+  @param  UsbUas                The USB UAS device
+  @param  StatusIu              The buffer to hold the IU
+  @param  Timeout               The time to wait for the IU
+
+  @retval EFI_SUCCESS           An IU is received.
+  @retval Others                Failed to receive an IU
+
+**/
+EFI_STATUS
+UsbUasReceiveIu (
+  IN  USB_UAS_PROTOCOL   *UsbUas,
+  OUT USB_UAS_STATUS_IU  *StatusIu,
+  IN  UINT32             Timeout
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Result;
+  UINTN       DataLen;
+
+  ZeroMem (StatusIu, sizeof (USB_UAS_STATUS_IU));
+  Result  = 0;
+  DataLen = sizeof (USB_UAS_STATUS_IU);
+  Timeout = Timeout / USB_MASS_1_MILLISECOND;
+
+  Status = UsbUas->UsbIo->UsbBulkTransfer (
+                            UsbUas->UsbIo,
+                            UsbUas->StatusEndpoint,
+                            StatusIu,
+                            &DataLen,
+                            Timeout,
+                            &Result
+                            );
+  if (EFI_ERROR (Status)) {
+    if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->StatusEndpoint);
+    }
+
+    return Status;
+  }
+
+  if (DataLen < sizeof (StatusIu->Header)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Call the USB Attached SCSI protocol to queue several commands on the
+  device, then transfer their data and status in whatever order the
+  device asks for.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Commands              The commands to execute.
+  @param  Count                 The number of entries in Commands, no more
+                                than USB_MASS_MAX_QUEUED_COMMANDS.
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait for each transfer
+
+  @retval EFI_SUCCESS           All commands completed, check CmdStatus of each.
+  @retval Other                 The transport failed.
+
+**/
+EFI_STATUS
+UsbUasExecCommandList (
+  IN     VOID              *Context,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             Count,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  )
+{
+  USB_UAS_PROTOCOL    *UsbUas;
+  USB_UAS_COMMAND_IU  CommandIu;
+  USB_UAS_STATUS_IU   StatusIu;
+  USB_MASS_COMMAND    *Command;
+  EFI_STATUS          Status;
+  EFI_STATUS          SendStatus;
+  UINT32              Pending;
+  UINTN               Index;
+  UINTN               TransLen;
+  UINT32              Result;
+  UINT16              Tag;
+  UINT8               Endpoint;
+
+  ASSERT ((Count > 0) && (Count <= USB_MASS_MAX_QUEUED_COMMANDS));
+
+  UsbUas              = (USB_UAS_PROTOCOL *)Context;
+  UsbUas->SenseLength = 0;
+  SendStatus          = EFI_SUCCESS;
+  Pending             = 0;
+
+  for (Index = 0; Index < Count; Index++) {
+    Commands[Index].CmdStatus = USB_MASS_CMD_FAIL;
+  }
+
+  //
+  // Queue all the commands first. The tag of each command is its index plus
+  // one, which is how the IUs on the status pipe are matched to it.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    Command = &Commands[Index];
+    ASSERT ((Command->CmdLen > 0) && (Command->CmdLen <= USB_UAS_MAX_CMDLEN));
+
+    ZeroMem (&CommandIu, sizeof (USB_UAS_COMMAND_IU));
+    CommandIu.IuId   = USB_UAS_IU_COMMAND;
+    CommandIu.Tag    = SwapBytes16 ((UINT16)(Index + 1));
+    CommandIu.Lun[1] = Lun;
+    CopyMem (CommandIu.Cdb, Command->Cmd, Command->CmdLen);
+
+    SendStatus = UsbUasSendIu (UsbUas, &CommandIu, sizeof (USB_UAS_COMMAND_IU));
+    if (EFI_ERROR (SendStatus)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecCommandList: Send command %d (%r)\n", Index, SendStatus));
+      break;
+    }
+
+    Pending |= (UINT32)(BIT0 << Index);
+  }
+
+  //
+  // Serve the device until every queued command has returned its status.
+  //
+  Status = EFI_SUCCESS;
+  while (Pending != 0) {
+    Status = UsbUasReceiveIu (UsbUas, &StatusIu, Timeout);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecCommandList: UsbUasReceiveIu (%r)\n", Status));
+      goto ON_ERROR;
+    }
+
+    Tag = SwapBytes16 (StatusIu.Header.Tag);
+    if ((Tag == 0) || (Tag > Count) || ((Pending & (BIT0 << (Tag - 1))) == 0)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecCommandList: IU %x with unexpected tag %x\n", StatusIu.Header.IuId, Tag));
+      Status = EFI_DEVICE_ERROR;
+      goto ON_ERROR;
+    }
+
+    Command = &Commands[Tag - 1];
+
+    switch (StatusIu.Header.IuId) {
+      case USB_UAS_IU_READ_READY:
+      case USB_UAS_IU_WRITE_READY:
+        if ((StatusIu.Header.IuId == USB_UAS_IU_READ_READY) != (Command->DataDir == EfiUsbDataIn)) {
+          Status = EFI_DEVICE_ERROR;
+          goto ON_ERROR;
+        }
+
+        if (Command->DataLen == 0) {
+          break;
+        }
+
+        Endpoint = (Command->DataDir == EfiUsbDataIn) ? UsbUas->DataInEndpoint : UsbUas->DataOutEndpoint;
+        TransLen = Command->DataLen;
+        Result   = 0;
+        Status   = UsbUas->UsbIo->UsbBulkTransfer (
+                                    UsbUas->UsbIo,
+                                    Endpoint,
+                                    Command->Data,
+                                    &TransLen,
+                                    Timeout / USB_MASS_1_MILLISECOND,
+                                    &Result
+                                    );
+        if (EFI_ERROR (Status)) {
+          DEBUG ((DEBUG_ERROR, "UsbUasExecCommandList: Data transfer (%r) Result %x\n", Status, Result));
+          if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+            UsbClearEndpointStall (UsbUas->UsbIo, Endpoint);
+          }
+
+          //
+          // Don't give up on a failed data phase, the device still ends the
+          // command with a Sense IU. Only a timeout needs the reset recovery.
+          //
+          if (Status == EFI_TIMEOUT) {
+            goto ON_ERROR;
+          }
+        }
+
+        break;
+
+      case USB_UAS_IU_SENSE:
+        Pending &= ~(UINT32)(BIT0 << (Tag - 1));
+        if (StatusIu.Sense.Status == USB_UAS_STATUS_GOOD) {
+          Command->CmdStatus = USB_MASS_CMD_SUCCESS;
+          break;
+        }
+
+        DEBUG ((DEBUG_INFO, "UsbUasExecCommandList: Cmd 0x%x status %x\n", *(UINT8 *)Command->Cmd, StatusIu.Sense.Status));
+        if (UsbUas->SenseLength == 0) {
+          UsbUas->SenseLength = (UINT8)MIN (SwapBytes16 (StatusIu.Sense.SenseLength), USB_UAS_MAX_SENSE_LEN);
+          CopyMem (UsbUas->SenseData, StatusIu.Sense.SenseData, UsbUas->SenseLength);
+        }
+
+        break;
+
+      case USB_UAS_IU_RESPONSE:
+        //
+        // The device did not accept the command, e.g. an overlapped tag.
+        //
+        Pending &= ~(UINT32)(BIT0 << (Tag - 1));
+        DEBUG ((DEBUG_ERROR, "UsbUasExecCommandList: Cmd 0x%x response %x\n", *(UINT8 *)Command->Cmd, StatusIu.Response.ResponseCode));
+        break;
+
+      default:
+        DEBUG ((DEBUG_ERROR, "UsbUasExecCommandList: Unexpected IU %x\n", StatusIu.Header.IuId));
+        Status = EFI_DEVICE_ERROR;
+        goto ON_ERROR;
+    }
+  }
+
+  return SendStatus;
+
+ON_ERROR:
+  UsbUasResetDevice (UsbUas, FALSE);
+  return Status;
+}
+
+/**
+  Call the USB Attached SCSI protocol to issue one command and
+  transfer its data and status.
+
+  A REQUEST SENSE following a failed command is answered with the sense
+  data the device returned in that command's Sense IU.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval Other                 Failed to execute command
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN  VOID                    *Context,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  )
+{
+  USB_UAS_PROTOCOL  *UsbUas;
+  USB_MASS_COMMAND  Command;
+  EFI_STATUS        Status;
+
+  UsbUas = (USB_UAS_PROTOCOL *)Context;
+
+  if ((*(UINT8 *)Cmd == USB_BOOT_REQUEST_SENSE_OPCODE) && (UsbUas->SenseLength != 0)) {
+    CopyMem (Data, UsbUas->SenseData, MIN (DataLen, UsbUas->SenseLength));
+    UsbUas->SenseLength = 0;
+    *CmdStatus          = USB_MASS_CMD_SUCCESS;
+    return EFI_SUCCESS;
+  }
+
+  Command.Cmd     = Cmd;
+  Command.CmdLen  = CmdLen;
+  Command.DataDir = DataDir;
+  Command.Data    = Data;
+  Command.DataLen = DataLen;
+
+  Status     = UsbUasExecCommandList (UsbUas, &Command, 1, Lun, Timeout);
+  *CmdStatus = Command.CmdStatus;
+
+  return Status;
+}
+
+/**
+  Reset the USB mass storage device by UAS protocol.
+
+  The outstanding commands are aborted with an I_T NEXUS RESET task
+  management request, and the stall condition of all pipes is cleared.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+  @param  ExtendedVerification  ExtendedVerification is ignored in this implementation.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN  VOID     *Context,
+  IN  BOOLEAN  ExtendedVerification
+  )
+{
+  USB_UAS_PROTOCOL      *UsbUas;
+  USB_UAS_TASK_MGMT_IU  TaskIu;
+  USB_UAS_STATUS_IU     StatusIu;
+  EFI_STATUS            Status;
+  UINTN                 Index;
+
+  UsbUas              = (USB_UAS_PROTOCOL *)Context;
+  UsbUas->SenseLength = 0;
+
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->CommandEndpoint);
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->StatusEndpoint);
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->DataInEndpoint);
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->DataOutEndpoint);
+
+  ZeroMem (&TaskIu, sizeof (USB_UAS_TASK_MGMT_IU));
+  TaskIu.IuId     = USB_UAS_IU_TASK_MGMT;
+  TaskIu.Tag      = SwapBytes16 ((UINT16)USB_UAS_TASK_MGMT_TAG);
+  TaskIu.Function = USB_UAS_TASK_MGMT_IT_NEXUS_RESET;
+
+  Status = UsbUasSendIu (UsbUas, &TaskIu, sizeof (USB_UAS_TASK_MGMT_IU));
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // Status of the aborted commands may still be in the status pipe
+  // ahead of the response to the reset, skip it.
+  //
+  for (Index = 0; Index <= USB_MASS_MAX_QUEUED_COMMANDS; Index++) {
+    Status = UsbUasReceiveIu (UsbUas, &StatusIu, USB_UAS_RESET_DEVICE_TIMEOUT);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    if ((StatusIu.Header.IuId == USB_UAS_IU_RESPONSE) &&
+        (SwapBytes16 (StatusIu.Header.Tag) == USB_UAS_TASK_MGMT_TAG))
+    {
+      if ((StatusIu.Response.ResponseCode != USB_UAS_RESPONSE_COMPLETE) &&
+          (StatusIu.Response.ResponseCode != USB_UAS_RESPONSE_SUCCEEDED))
+      {
+        return EFI_DEVICE_ERROR;
+      }
+
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_DEVICE_ERROR;
+}
+
+/**
+  Get the max LUN (Logical Unit Number) of USB mass storage device.
+
+  Only logical unit 0 is exposed through UAS.
+
+  @param  Context          The context of the UAS protocol, that is, USB_UAS_PROTOCOL
+  @param  MaxLun           Return pointer to the max number of LUN.
+
+  @retval EFI_SUCCESS      Max LUN is got successfully.
+  @retval Others           Fail to execute this request.
+
+**/
+EFI_STATUS
+UsbUasGetMaxLun (
+  IN  VOID   *Context,
+  OUT UINT8  *MaxLun
+  )
+{
+  if ((Context == NULL) || (MaxLun == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *MaxLun = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Clean up the resource used by this UAS protocol.
+
+  @param  Context         The context of the UAS protocol, that is, USB_UAS_PROTOCOL.
+
+  @retval EFI_SUCCESS     The resource is cleaned up.
+
+**/
+EFI_STATUS
+UsbUasCleanUp (
+  IN  VOID  *Context
+  )
+{
+  FreePool (Context);
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,278 @@
+/** @file
+  Definition for the USB Attached SCSI (UAS) transport protocol,
+  based on "Universal Serial Bus Mass Storage Class - USB Attached
+  SCSI Protocol (UASP)" Revision 1.0.
+
+  Only the USB 2.0 (non-stream) form of the protocol is implemented,
+  because the USB I/O Protocol has no way to address a bulk stream.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#pragma once
+
+extern USB_MASS_TRANSPORT  mUsbUasTransport;
+
+//
+// Class specific Pipe Usage descriptor and the pipe identifiers it carries
+//
+#define USB_UAS_DESC_TYPE_PIPE_USAGE  0x24
+#define USB_UAS_PIPE_ID_COMMAND       0x01
+#define USB_UAS_PIPE_ID_STATUS        0x02
+#define USB_UAS_PIPE_ID_DATA_IN       0x03
+#define USB_UAS_PIPE_ID_DATA_OUT      0x04
+
+//
+// SuperSpeed Endpoint Companion descriptor. Its presence means the device is
+// operating at SuperSpeed, where UAS requires bulk streams.
+//
+#define USB_UAS_DESC_TYPE_SS_ENDPOINT_COMPANION  0x30
+
+//
+// Information Unit identifiers
+//
+#define USB_UAS_IU_COMMAND      0x01
+#define USB_UAS_IU_SENSE        0x03
+#define USB_UAS_IU_RESPONSE     0x04
+#define USB_UAS_IU_TASK_MGMT    0x05
+#define USB_UAS_IU_READ_READY   0x06
+#define USB_UAS_IU_WRITE_READY  0x07
+
+//
+// Task management functions and response codes
+//
+#define USB_UAS_TASK_MGMT_IT_NEXUS_RESET  0x10
+#define USB_UAS_RESPONSE_COMPLETE         0x00
+#define USB_UAS_RESPONSE_SUCCEEDED        0x08
+
+#define USB_UAS_MAX_CMDLEN     16   ///< Commands longer than 16 bytes are not used
+#define USB_UAS_MAX_SENSE_LEN  252  ///< Largest sense data a Sense IU carries
+#define USB_UAS_STATUS_GOOD    0x00
+
+//
+// Tag used for task management requests, command tags start from 1
+//
+#define USB_UAS_TASK_MGMT_TAG  (USB_MASS_MAX_QUEUED_COMMANDS + 1)
+
+//
+// Usb UAS transport timeout, set by experience
+//
+#define USB_UAS_SEND_IU_TIMEOUT       (3 * USB_MASS_1_SECOND)
+#define USB_UAS_RESET_DEVICE_TIMEOUT  (3 * USB_MASS_1_SECOND)
+
+#pragma pack(1)
+///
+/// Command IU, sent on the command pipe. Multi-byte fields are big endian.
+///
+typedef struct {
+  UINT8     IuId;
+  UINT8     Reserved0;
+  UINT16    Tag;
+  UINT8     TaskAttribute;      ///< Bits 0~2, 0 ~ SIMPLE
+  UINT8     Reserved1;
+  UINT8     AddCdbLength;       ///< Bits 2~7, in dwords beyond 16 bytes
+  UINT8     Reserved2;
+  UINT8     Lun[8];
+  UINT8     Cdb[USB_UAS_MAX_CMDLEN];
+} USB_UAS_COMMAND_IU;
+
+///
+/// Task Management IU, sent on the command pipe.
+///
+typedef struct {
+  UINT8     IuId;
+  UINT8     Reserved0;
+  UINT16    Tag;
+  UINT8     Function;
+  UINT8     Reserved1;
+  UINT16    TaskTag;
+  UINT8     Lun[8];
+} USB_UAS_TASK_MGMT_IU;
+
+///
+/// Sense IU, received on the status pipe when a command completes.
+///
+typedef struct {
+  UINT8     IuId;
+  UINT8     Reserved0;
+  UINT16    Tag;
+  UINT16    StatusQualifier;
+  UINT8     Status;
+  UINT8     Reserved1[7];
+  UINT16    SenseLength;
+  UINT8     SenseData[USB_UAS_MAX_SENSE_LEN];
+} USB_UAS_SENSE_IU;
+
+///
+/// Response IU, received on the status pipe for task management requests
+/// and commands the device could not accept.
+///
+typedef struct {
+  UINT8     IuId;
+  UINT8     Reserved0;
+  UINT16    Tag;
+  UINT8     AddResponseInfo[3];
+  UINT8     ResponseCode;
+} USB_UAS_RESPONSE_IU;
+
+///
+/// Any IU that can be received on the status pipe. READ READY and
+/// WRITE READY IUs only have the common header.
+///
+typedef union {
+  struct {
+    UINT8     IuId;
+    UINT8     Reserved0;
+    UINT16    Tag;
+  } Header;
+  USB_UAS_SENSE_IU       Sense;
+  USB_UAS_RESPONSE_IU    Response;
+} USB_UAS_STATUS_IU;
+#pragma pack()
+
+typedef struct {
+  //
+  // Put Interface at the first field to make it easy to distinguish BOT/CBI/UAS Protocol instance
+  //
+  EFI_USB_INTERFACE_DESCRIPTOR    Interface;
+  UINT8                           CommandEndpoint;
+  UINT8                           StatusEndpoint;
+  UINT8                           DataInEndpoint;
+  UINT8                           DataOutEndpoint;
+  EFI_USB_IO_PROTOCOL             *UsbIo;
+  //
+  // Sense data of the last failed command, returned for the following
+  // REQUEST SENSE because the device reports it only once, in the Sense IU.
+  //
+  UINT8                           SenseLength;
+  UINT8                           SenseData[USB_UAS_MAX_SENSE_LEN];
+} USB_UAS_PROTOCOL;
+
+/**
+  Initializes USB UAS protocol.
+
+  This function looks for an alternate setting of the interface that
+  implements UAS, selects it, and locates the command, status, data-in
+  and data-out pipes. It will save its context which is a USB_UAS_PROTOCOL
+  structure in the Context if Context isn't NULL.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Context               The buffer to save the context to
+
+  @retval EFI_SUCCESS           The device is successfully initialized.
+  @retval EFI_UNSUPPORTED       The transport protocol doesn't support the device.
+  @retval Other                 The USB UAS initialization fails.
+
+**/
+EFI_STATUS
+UsbUasInit (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo,
+  OUT VOID                 **Context OPTIONAL
+  );
+
+/**
+  Call the USB Attached SCSI protocol to issue one command and
+  transfer its data and status.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval Other                 Failed to execute command
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN  VOID                    *Context,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  );
+
+/**
+  Call the USB Attached SCSI protocol to queue several commands on the
+  device, then transfer their data and status in whatever order the
+  device asks for.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Commands              The commands to execute.
+  @param  Count                 The number of entries in Commands, no more
+                                than USB_MASS_MAX_QUEUED_COMMANDS.
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait for each transfer
+
+  @retval EFI_SUCCESS           All commands completed, check CmdStatus of each.
+  @retval Other                 The transport failed.
+
+**/
+EFI_STATUS
+UsbUasExecCommandList (
+  IN     VOID              *Context,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             Count,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  );
+
+/**
+  Reset the USB mass storage device by UAS protocol.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+  @param  ExtendedVerification  ExtendedVerification is ignored in this implementation.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN  VOID     *Context,
+  IN  BOOLEAN  ExtendedVerification
+  );
+
+/**
+  Get the max LUN (Logical Unit Number) of USB mass storage device.
+
+  Only logical unit 0 is exposed through UAS.
+
+  @param  Context          The context of the UAS protocol, that is, USB_UAS_PROTOCOL
+  @param  MaxLun           Return pointer to the max number of LUN.
+
+  @retval EFI_SUCCESS      Max LUN is got successfully.
+  @retval Others           Fail to execute this request.
+
+**/
+EFI_STATUS
+UsbUasGetMaxLun (
+  IN  VOID   *Context,
+  OUT UINT8  *MaxLun
+  );
+
+/**
+  Clean up the resource used by this UAS protocol.
+
+  @param  Context         The context of the UAS protocol, that is, USB_UAS_PROTOCOL.
+
+  @retval EFI_SUCCESS     The resource is cleaned up.
+
+**/
+EFI_STATUS
+UsbUasCleanUp (
+  IN  VOID  *Context
+  );
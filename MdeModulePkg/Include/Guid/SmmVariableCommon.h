@@ -76,6 +76,10 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO  14
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS
+//
+#define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_STATISTICS  15
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -146,3 +150,11 @@ typedef struct {
   UINTN      TotalVolatileStorageSize;
   BOOLEAN    AuthenticatedVariableUsage;
 } SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO;
+
+typedef struct {
+  UINT64    FlushCount;             ///< Number of flushes of pending updates to the runtime caches.
+  UINT64    TotalBytesSynchronized; ///< Bytes copied to the runtime caches by all flushes.
+  UINT64    LastBytesSynchronized;  ///< Bytes copied to the runtime caches by the last flush.
+  UINT64    DeltaUpdateCount;       ///< Variable updates synchronized by the ranges they changed.
+  UINT64    FullUpdateCount;        ///< Variable updates that reclaimed the store and synchronized all of it.
+} SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS;
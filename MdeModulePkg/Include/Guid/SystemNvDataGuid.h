@@ -83,7 +83,11 @@ typedef struct {
   UINT8      BootBlockUpdate     : 1;
   UINT8      SpareComplete       : 1;
   UINT8      DestinationComplete : 1;
-  UINT8      Reserved            : 5;
+  //
+  // Inverted index of the spare area slot that holds the backup of this
+  // write, see FTW_SPARE_SLOT_FROM_RECORD.
+  //
+  UINT8      SpareSlot           : 5;
   EFI_LBA    Lba;
   UINT64     Offset;
   UINT64     Length;
@@ -96,6 +100,17 @@ typedef struct {
   //
 } EFI_FAULT_TOLERANT_WRITE_RECORD;
 
+//
+// The spare area may be split into equally sized slots, and a write that fits
+// in one slot is backed up in that slot rather than at the start of the spare
+// area. The slot index is stored inverted, so an erased record, or a record
+// written by an implementation that does not use slots, refers to slot 0.
+//
+#define FTW_MAX_SPARE_SLOTS  32
+
+#define FTW_SPARE_SLOT_FROM_RECORD(Record)  ((UINTN) (~(UINTN) (Record)->SpareSlot & (FTW_MAX_SPARE_SLOTS - 1)))
+#define FTW_SPARE_SLOT_TO_RECORD(Slot)      ((UINT8) (~(UINTN) (Slot) & (FTW_MAX_SPARE_SLOTS - 1)))
+
 #define FTW_RECORD_SIZE(PrivateDataSize)  (sizeof (EFI_FAULT_TOLERANT_WRITE_RECORD) + (UINTN) PrivateDataSize)
 
 #define FTW_RECORD_TOTAL_SIZE(NumberOfWrites, PrivateDataSize) \
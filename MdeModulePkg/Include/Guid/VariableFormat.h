@@ -119,6 +119,13 @@ typedef struct {
 #define VARIABLE_ATTRIBUTE_NV_BS_RT_AW        (VARIABLE_ATTRIBUTE_NV_BS_RT | EFI_VARIABLE_AUTHENTICATED_WRITE_ACCESS)
 #define VARIABLE_ATTRIBUTE_NV_BS_RT_HR_AT_AW  (VARIABLE_ATTRIBUTE_NV_BS_RT_HR | VARIABLE_ATTRIBUTE_AT_AW)
 
+///
+/// Variable data flag stored in the Reserved field of the variable header.
+/// When set, the variable data is a UEFI compressed stream and DataSize is
+/// the size of that stream rather than the size of the original data.
+///
+#define VARIABLE_DATA_COMPRESSED  0x01
+
 ///
 /// Single Variable Data Header Structure.
 ///
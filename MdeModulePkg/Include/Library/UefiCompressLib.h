@@ -0,0 +1,39 @@
+/** @file
+  Provides services to compress a buffer using the UEFI Compress algorithm.
+
+  The output is a UEFI compressed stream that UefiDecompressLib decodes.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#pragma once
+
+/**
+  Compresses a source buffer using the UEFI Compress algorithm.
+
+  If Source is NULL, then ASSERT().
+  If Destination is NULL, then ASSERT().
+  If DestinationSize is NULL, then ASSERT().
+
+  @param[in]      Source           The source buffer containing the data to compress.
+  @param[in]      SourceSize       The size, in bytes, of the source buffer.
+  @param[out]     Destination      The buffer that receives the compressed stream.
+  @param[in, out] DestinationSize  On input, the size, in bytes, of Destination.
+                                   On output, the size, in bytes, of the
+                                   compressed stream, also when it did not fit.
+
+  @retval RETURN_SUCCESS           The compressed stream was placed in Destination.
+  @retval RETURN_BUFFER_TOO_SMALL  Destination is too small for the compressed
+                                   stream. DestinationSize holds the size needed.
+  @retval RETURN_OUT_OF_RESOURCES  There is not enough memory for the work buffers.
+
+**/
+RETURN_STATUS
+EFIAPI
+UefiCompress (
+  IN     CONST VOID  *Source,
+  IN     UINTN       SourceSize,
+  OUT    VOID        *Destination,
+  IN OUT UINTN       *DestinationSize
+  );
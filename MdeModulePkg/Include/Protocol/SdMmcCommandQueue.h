@@ -0,0 +1,165 @@
+/** @file
+  Protocol to transfer data with an eMMC device through the Command Queuing
+  Engine (CQE) of its SD/MMC host controller, as defined by the eMMC 5.1
+  specification, and to report the throughput the queued transfers achieve.
+
+  The protocol is produced by the SD/MMC host controller driver on the same
+  handle as EFI_SD_MMC_PASS_THRU_PROTOCOL. The driver switches the device
+  into command queue mode for queued transfers and back out of it before
+  any command sent through EFI_SD_MMC_PASS_THRU_PROTOCOL, so the consumer
+  may use both protocols freely. Queued transfers access the partition
+  currently selected in the PARTITION_CONFIG field of the EXT_CSD register.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#pragma once
+
+#define EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL_GUID \
+  { 0xec4f7b78, 0x4220, 0x4b60, { 0x99, 0xca, 0x2e, 0x01, 0x70, 0xae, 0xa4, 0xc3 } }
+
+#define EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL_REVISION  0x00010000
+
+typedef struct _EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL;
+
+///
+/// A queued read or write of 512-byte blocks.
+///
+typedef struct {
+  ///
+  /// The data address of the first block, in the unit the device expects in
+  /// the argument of READ_MULTIPLE_BLOCK and WRITE_MULTIPLE_BLOCK.
+  ///
+  UINT32        Address;
+  ///
+  /// The number of blocks to transfer, no more than the MaxBlockCount
+  /// reported by GetInfo().
+  ///
+  UINT32        BlockCount;
+  VOID          *Buffer;
+  BOOLEAN       IsRead;
+  ///
+  /// The timeout in microseconds, 0 means wait indefinitely.
+  ///
+  UINT64        Timeout;
+  ///
+  /// EFI_NOT_READY while the transfer is in flight, then its result.
+  ///
+  EFI_STATUS    TransactionStatus;
+} EDKII_SD_MMC_COMMAND_QUEUE_REQUEST;
+
+///
+/// Statistics of the queued transfers of one slot.
+///
+typedef struct {
+  UINT64    CompletedRequests;
+  UINT64    FailedRequests;
+  UINT64    TransferredBytes;
+  ///
+  /// The time in nanoseconds during which at least one transfer was in flight.
+  ///
+  UINT64    BusyTime;
+  ///
+  /// CompletedRequests and TransferredBytes divided by BusyTime.
+  ///
+  UINT64    IoPerSecond;
+  UINT64    BytesPerSecond;
+  ///
+  /// The largest number of transfers that were in flight at once.
+  ///
+  UINT32    MaxOutstanding;
+  ///
+  /// The number of times the device was switched into command queue mode.
+  ///
+  UINT32    ModeSwitches;
+} EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS;
+
+/**
+  Get the command queue parameters of the device in a slot.
+
+  @param[in]  This              A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]  Slot              The slot number of the device.
+  @param[out] QueueDepth        The number of transfers that can be in flight at once.
+  @param[out] MaxBlockCount     The largest BlockCount of a single request.
+
+  @retval EFI_SUCCESS           The parameters are returned.
+  @retval EFI_INVALID_PARAMETER Slot, QueueDepth or MaxBlockCount is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SD_MMC_COMMAND_QUEUE_GET_INFO)(
+  IN  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *This,
+  IN  UINT8                                Slot,
+  OUT UINT32                               *QueueDepth,
+  OUT UINT32                               *MaxBlockCount
+  );
+
+/**
+  Queue a data transfer with the device in a slot.
+
+  @param[in]      This          A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]      Slot          The slot number of the device.
+  @param[in, out] Request       The transfer to queue. It must stay valid until
+                                the transfer completes.
+  @param[in]      Event         If Event is NULL, the function waits for the
+                                transfer to complete. Otherwise it returns once
+                                the transfer is queued and Event is signaled
+                                when it completes.
+
+  @retval EFI_SUCCESS           The transfer is queued, or done if Event is
+                                NULL. Check Request->TransactionStatus for the
+                                result of a non-blocking transfer.
+  @retval EFI_INVALID_PARAMETER Slot or Request is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing, or it has been
+                                given up because switching modes failed. The
+                                transfer should be done without queuing.
+  @retval EFI_NO_MEDIA          There is no device in the slot.
+  @retval EFI_DEVICE_ERROR      The transfer failed.
+  @retval EFI_TIMEOUT           The transfer didn't complete in time.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SD_MMC_COMMAND_QUEUE_SUBMIT)(
+  IN     EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL  *This,
+  IN     UINT8                                Slot,
+  IN OUT EDKII_SD_MMC_COMMAND_QUEUE_REQUEST   *Request,
+  IN     EFI_EVENT                            Event OPTIONAL
+  );
+
+/**
+  Get the statistics of the queued transfers of a slot.
+
+  @param[in]  This              A pointer to the EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL instance.
+  @param[in]  Slot              The slot number of the device.
+  @param[in]  Reset             Clear the statistics after returning them.
+  @param[out] Statistics        The statistics of the slot.
+
+  @retval EFI_SUCCESS           The statistics are returned.
+  @retval EFI_INVALID_PARAMETER Slot or Statistics is invalid.
+  @retval EFI_UNSUPPORTED       The host controller or the device in the slot
+                                doesn't support command queuing.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SD_MMC_COMMAND_QUEUE_GET_STATISTICS)(
+  IN  EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL    *This,
+  IN  UINT8                                  Slot,
+  IN  BOOLEAN                                Reset,
+  OUT EDKII_SD_MMC_COMMAND_QUEUE_STATISTICS  *Statistics
+  );
+
+struct _EDKII_SD_MMC_COMMAND_QUEUE_PROTOCOL {
+  UINT64                                       Revision;
+  EDKII_SD_MMC_COMMAND_QUEUE_GET_INFO          GetInfo;
+  EDKII_SD_MMC_COMMAND_QUEUE_SUBMIT            Submit;
+  EDKII_SD_MMC_COMMAND_QUEUE_GET_STATISTICS    GetStatistics;
+};
+
+extern EFI_GUID  gEdkiiSdMmcCommandQueueProtocolGuid;
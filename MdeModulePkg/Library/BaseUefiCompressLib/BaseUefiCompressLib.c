@@ -1,23 +1,22 @@
 /** @file
-  Main file for compression routine.
+  UEFI Compress Library implementation.
 
-  Compression routine. The compression algorithm is a mixture of
-  LZ77 and Huffman coding. LZ77 transforms the source data into a
-  sequence of Original Characters and Pointers to repeated strings.
-  This sequence is further divided into Blocks and Huffman codings
-  are applied to each Block.
+  The compression algorithm is a mixture of LZ77 and Huffman coding. LZ77
+  transforms the source data into a sequence of Original Characters and
+  Pointers to repeated strings. This sequence is further divided into Blocks
+  and Huffman codings are applied to each Block. The output can be decoded
+  by UefiDecompressLib.
 
   Copyright (c) 2007 - 2018, Intel Corporation. All rights reserved.<BR>
   SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
-#include <Uefi.h>
-#include <Library/MemoryAllocationLib.h>
+
+#include <Base.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
-#include <Library/ShellLib.h>
-
-#include "Compress.h"
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiCompressLib.h>
 
 //
 // Macro Definitions
@@ -38,6 +37,13 @@ typedef INT16 NODE;
 #define HASH(LoopVar7, LoopVar5)  ((LoopVar7) + ((LoopVar5) << (WNDBIT - 9)) + WNDSIZ * 2)
 #define CRCPOLY  0xA001
 #define UPDATE_CRC(LoopVar5)  mCrc = mCrcTable[(mCrc ^ (LoopVar5)) & 0xFF] ^ (mCrc >> UINT8_BIT)
+#define FREE_NON_NULL(Pointer)  \
+  do {                          \
+    if ((Pointer) != NULL) {    \
+      FreePool ((Pointer));     \
+      (Pointer) = NULL;         \
+    }                           \
+  } while (FALSE)
 
 //
 // C: the Char&Len Set; P: the Position Set; T: the exTra Set
@@ -62,6 +68,7 @@ typedef INT16 NODE;
 
   @param[in] Data    The dword to put.
 **/
+STATIC
 VOID
 PutDword (
   IN UINT32  Data
@@ -115,12 +122,14 @@ STATIC NODE  *mPosition;
 STATIC NODE  *mParent;
 STATIC NODE  *mPrev;
 STATIC NODE  *mNext        = NULL;
-INT32        mHuffmanDepth = 0;
+
+STATIC INT32  mHuffmanDepth = 0;
 
 /**
   Make a CRC table.
 
 **/
+STATIC
 VOID
 MakeCrcTable (
   VOID
@@ -151,6 +160,7 @@ MakeCrcTable (
 
   @param[in] Data    The dword to put.
 **/
+STATIC
 VOID
 PutDword (
   IN UINT32  Data
@@ -176,10 +186,11 @@ PutDword (
 /**
   Allocate memory spaces for data structures used in compression process.
 
-  @retval EFI_SUCCESS           Memory was allocated successfully.
-  @retval EFI_OUT_OF_RESOURCES  A memory allocation failed.
+  @retval RETURN_SUCCESS           Memory was allocated successfully.
+  @retval RETURN_OUT_OF_RESOURCES  A memory allocation failed.
 **/
-EFI_STATUS
+STATIC
+RETURN_STATUS
 AllocateMemory (
   VOID
   )
@@ -197,7 +208,7 @@ AllocateMemory (
   while (mBuf == NULL) {
     mBufSiz = (mBufSiz / 10U) * 9U;
     if (mBufSiz < 4 * 1024U) {
-      return EFI_OUT_OF_RESOURCES;
+      return RETURN_OUT_OF_RESOURCES;
     }
 
     mBuf = AllocateZeroPool (mBufSiz);
@@ -205,31 +216,33 @@ AllocateMemory (
 
   mBuf[0] = 0;
 
-  return EFI_SUCCESS;
+  return RETURN_SUCCESS;
 }
 
 /**
   Called when compression is completed to free memory previously allocated.
 
 **/
+STATIC
 VOID
 FreeMemory (
   VOID
   )
 {
-  SHELL_FREE_NON_NULL (mText);
-  SHELL_FREE_NON_NULL (mLevel);
-  SHELL_FREE_NON_NULL (mChildCount);
-  SHELL_FREE_NON_NULL (mPosition);
-  SHELL_FREE_NON_NULL (mParent);
-  SHELL_FREE_NON_NULL (mPrev);
-  SHELL_FREE_NON_NULL (mNext);
-  SHELL_FREE_NON_NULL (mBuf);
+  FREE_NON_NULL (mText);
+  FREE_NON_NULL (mLevel);
+  FREE_NON_NULL (mChildCount);
+  FREE_NON_NULL (mPosition);
+  FREE_NON_NULL (mParent);
+  FREE_NON_NULL (mPrev);
+  FREE_NON_NULL (mNext);
+  FREE_NON_NULL (mBuf);
 }
 
 /**
   Initialize String Info Log data structures.
 **/
+STATIC
 VOID
 InitSlide (
   VOID
@@ -261,6 +274,7 @@ InitSlide (
   @retval NIL(Zero)   No child could be found.
 
 **/
+STATIC
 NODE
 Child (
   IN NODE   LoopVar6,
@@ -285,6 +299,7 @@ Child (
   @param[in] LoopVar5       The edge character.
   @param[in] LoopVar4       The child node.
 **/
+STATIC
 VOID
 MakeChild (
   IN NODE   LoopVar6,
@@ -311,6 +326,7 @@ MakeChild (
 
   @param[in] Old     The node to split.
 **/
+STATIC
 VOID
 Split (
   IN NODE  Old
@@ -340,6 +356,7 @@ Split (
   Insert string info for current position into the String Info Log.
 
 **/
+STATIC
 VOID
 InsertNode (
   VOID
@@ -468,6 +485,7 @@ InsertNode (
   ensures a clean deletion).
 
 **/
+STATIC
 VOID
 DeleteNode (
   VOID
@@ -562,6 +580,7 @@ DeleteNode (
 
   @return The number of bytes actually read.
 **/
+STATIC
 INT32
 FreadCrc (
   OUT UINT8  *LoopVar7,
@@ -594,6 +613,7 @@ FreadCrc (
   @retval TRUE      The operation was successful.
   @retval FALSE     The operation failed due to insufficient memory.
 **/
+STATIC
 BOOLEAN
 GetNextMatch (
   VOID
@@ -629,6 +649,7 @@ GetNextMatch (
 
   @param[in] LoopVar1    The index of the item to move.
 **/
+STATIC
 VOID
 DownHeap (
   IN INT32  i
@@ -665,6 +686,7 @@ DownHeap (
 
   @param[in] LoopVar1      The top node.
 **/
+STATIC
 VOID
 CountLen (
   IN INT32  LoopVar1
@@ -685,6 +707,7 @@ CountLen (
 
   @param[in] Root   The root of the tree.
 **/
+STATIC
 VOID
 MakeLen (
   IN INT32  Root
@@ -740,6 +763,7 @@ MakeLen (
   @param[in] Len    The code length array.
   @param[out] Code  The stores codes for each symbol.
 **/
+STATIC
 VOID
 MakeCode (
   IN  INT32   LoopVar8,
@@ -770,6 +794,7 @@ MakeCode (
 
   @return The root of the Huffman tree.
 **/
+STATIC
 INT32
 MakeTree (
   IN  INT32   NParm,
@@ -853,6 +878,7 @@ MakeTree (
   @param[in] LoopVar8   The rightmost LoopVar8 bits of the data is used.
   @param[in] x   The data.
 **/
+STATIC
 VOID
 PutBits (
   IN INT32   LoopVar8,
@@ -891,6 +917,7 @@ PutBits (
 
   @param[in] LoopVar5     The number to encode.
 **/
+STATIC
 VOID
 EncodeC (
   IN INT32  LoopVar5
@@ -904,6 +931,7 @@ EncodeC (
 
   @param[in] LoopVar7     The number to encode.
 **/
+STATIC
 VOID
 EncodeP (
   IN UINT32  LoopVar7
@@ -930,6 +958,7 @@ EncodeP (
   Count the frequencies for the Extra Set.
 
 **/
+STATIC
 VOID
 CountTFreq (
   VOID
@@ -987,6 +1016,7 @@ CountTFreq (
   @param[in] Special        The special symbol that needs to be take care of.
 
 **/
+STATIC
 VOID
 WritePTLen (
   IN INT32  LoopVar8,
@@ -1025,6 +1055,7 @@ WritePTLen (
 /**
   Outputs the code length array for Char&Length Set.
 **/
+STATIC
 VOID
 WriteCLen (
   VOID
@@ -1080,6 +1111,7 @@ WriteCLen (
   Huffman code the block and output it.
 
 **/
+STATIC
 VOID
 SendBlock (
   VOID
@@ -1155,6 +1187,7 @@ SendBlock (
   Start the huffman encoding.
 
 **/
+STATIC
 VOID
 HufEncodeStart (
   VOID
@@ -1176,6 +1209,7 @@ HufEncodeStart (
                    a Pointer.
   @param[in] LoopVar7     The 'Position' field of a Pointer.
 **/
+STATIC
 VOID
 CompressOutput (
   IN UINT32  LoopVar5,
@@ -1215,6 +1249,7 @@ CompressOutput (
   End the huffman encoding.
 
 **/
+STATIC
 VOID
 HufEncodeEnd (
   VOID
@@ -1231,20 +1266,21 @@ HufEncodeEnd (
 /**
   The main controlling routine for compression process.
 
-  @retval EFI_SUCCESS           The compression is successful.
-  @retval EFI_OUT_0F_RESOURCES  Not enough memory for compression process.
+  @retval RETURN_SUCCESS           The compression is successful.
+  @retval RETURN_OUT_OF_RESOURCES  Not enough memory for compression process.
 **/
-EFI_STATUS
+STATIC
+RETURN_STATUS
 Encode (
   VOID
   )
 {
-  EFI_STATUS  Status;
-  INT32       LastMatchLen;
-  NODE        LastMatchPos;
+  RETURN_STATUS  Status;
+  INT32          LastMatchLen;
+  NODE           LastMatchPos;
 
   Status = AllocateMemory ();
-  if (EFI_ERROR (Status)) {
+  if (RETURN_ERROR (Status)) {
     FreeMemory ();
     return Status;
   }
@@ -1266,7 +1302,7 @@ Encode (
     LastMatchLen = mMatchLen;
     LastMatchPos = mMatchPos;
     if (!GetNextMatch ()) {
-      Status = EFI_OUT_OF_RESOURCES;
+      Status = RETURN_OUT_OF_RESOURCES;
     }
 
     if (mMatchLen > mRemainder) {
@@ -1291,7 +1327,7 @@ Encode (
       LastMatchLen--;
       while (LastMatchLen > 0) {
         if (!GetNextMatch ()) {
-          Status = EFI_OUT_OF_RESOURCES;
+          Status = RETURN_OUT_OF_RESOURCES;
         }
 
         LastMatchLen--;
@@ -1309,26 +1345,39 @@ Encode (
 }
 
 /**
-  The compression routine.
+  Compresses a source buffer using the UEFI Compress algorithm.
+
+  If Source is NULL, then ASSERT().
+  If Destination is NULL, then ASSERT().
+  If DestinationSize is NULL, then ASSERT().
 
-  @param[in]       SrcBuffer     The buffer containing the source data.
-  @param[in]       SrcSize       Number of bytes in SrcBuffer.
-  @param[in]       DstBuffer     The buffer to put the compressed image in.
-  @param[in, out]  DstSize       On input the size (in bytes) of DstBuffer, on
-                                 return the number of bytes placed in DstBuffer.
+  @param[in]      Source           The source buffer containing the data to compress.
+  @param[in]      SourceSize       The size, in bytes, of the source buffer.
+  @param[out]     Destination      The buffer that receives the compressed stream.
+  @param[in, out] DestinationSize  On input, the size, in bytes, of Destination.
+                                   On output, the size, in bytes, of the
+                                   compressed stream, also when it did not fit.
+
+  @retval RETURN_SUCCESS           The compressed stream was placed in Destination.
+  @retval RETURN_BUFFER_TOO_SMALL  Destination is too small for the compressed
+                                   stream. DestinationSize holds the size needed.
+  @retval RETURN_OUT_OF_RESOURCES  There is not enough memory for the work buffers.
 
-  @retval EFI_SUCCESS           The compression was successful.
-  @retval EFI_BUFFER_TOO_SMALL  The buffer was too small.  DstSize is required.
 **/
-EFI_STATUS
-Compress (
-  IN      VOID    *SrcBuffer,
-  IN      UINT64  SrcSize,
-  IN      VOID    *DstBuffer,
-  IN OUT  UINT64  *DstSize
+RETURN_STATUS
+EFIAPI
+UefiCompress (
+  IN     CONST VOID  *Source,
+  IN     UINTN       SourceSize,
+  OUT    VOID        *Destination,
+  IN OUT UINTN       *DestinationSize
   )
 {
-  EFI_STATUS  Status;
+  RETURN_STATUS  Status;
+
+  ASSERT (Source != NULL);
+  ASSERT (Destination != NULL);
+  ASSERT (DestinationSize != NULL);
 
   //
   // Initializations
@@ -1343,10 +1392,10 @@ Compress (
   mPrev       = NULL;
   mNext       = NULL;
 
-  mSrc           = SrcBuffer;
-  mSrcUpperLimit = mSrc + SrcSize;
-  mDst           = DstBuffer;
-  mDstUpperLimit = mDst +*DstSize;
+  mSrc           = (UINT8 *)Source;
+  mSrcUpperLimit = mSrc + SourceSize;
+  mDst           = Destination;
+  mDstUpperLimit = mDst + *DestinationSize;
 
   PutDword (0L);
   PutDword (0L);
@@ -1360,8 +1409,8 @@ Compress (
   // Compress it
   //
   Status = Encode ();
-  if (EFI_ERROR (Status)) {
-    return EFI_OUT_OF_RESOURCES;
+  if (RETURN_ERROR (Status)) {
+    return RETURN_OUT_OF_RESOURCES;
   }
 
   //
@@ -1374,18 +1423,18 @@ Compress (
   //
   // Fill in compressed size and original size
   //
-  mDst = DstBuffer;
+  mDst = Destination;
   PutDword (mCompSize + 1);
   PutDword (mOrigSize);
 
   //
   // Return
   //
-  if (mCompSize + 1 + 8 > *DstSize) {
-    *DstSize = mCompSize + 1 + 8;
-    return EFI_BUFFER_TOO_SMALL;
+  if (mCompSize + 1 + 8 > *DestinationSize) {
+    *DestinationSize = mCompSize + 1 + 8;
+    return RETURN_BUFFER_TOO_SMALL;
   } else {
-    *DstSize = mCompSize + 1 + 8;
-    return EFI_SUCCESS;
+    *DestinationSize = mCompSize + 1 + 8;
+    return RETURN_SUCCESS;
   }
 }
@@ -0,0 +1,123 @@
+/** @file
+  Round-trip unit tests for BaseUefiCompressLib.
+
+  Each test compresses a buffer with UefiCompress() and checks that
+  UefiDecompress() restores the original bytes.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseMemoryLib.h>
+  #include <Library/UefiCompressLib.h>
+  #include <Library/UefiDecompressLib.h>
+}
+
+using namespace testing;
+
+typedef enum {
+  PatternZero,
+  PatternText,
+  PatternRandom
+} COMPRESS_TEST_PATTERN;
+
+typedef struct {
+  UINTN                    Size;
+  COMPRESS_TEST_PATTERN    Pattern;
+} COMPRESS_TEST_PARAM;
+
+class UefiCompressRoundTrip : public TestWithParam<COMPRESS_TEST_PARAM> {
+protected:
+  std::vector<UINT8> Input;
+
+  void
+  SetUp (
+    ) override
+  {
+    CONST COMPRESS_TEST_PARAM  &Param = GetParam ();
+    CONST CHAR8                *Text  = "The quick brown fox jumps over the lazy dog. ";
+    UINT32                     Seed;
+
+    Input.resize (Param.Size);
+    Seed = 0x12345678;
+    for (UINTN Index = 0; Index < Param.Size; Index++) {
+      switch (Param.Pattern) {
+        case PatternZero:
+          Input[Index] = 0;
+          break;
+        case PatternText:
+          Input[Index] = (UINT8)Text[Index % 45];
+          break;
+        default:
+          Seed         = Seed * 1103515245 + 12345;
+          Input[Index] = (UINT8)(Seed >> 16);
+          break;
+      }
+    }
+  }
+};
+
+// Compress the input, decompress the result and compare with the original.
+// The first UefiCompress() call uses a one byte destination so the
+// RETURN_BUFFER_TOO_SMALL path that reports the required size is covered too.
+TEST_P (UefiCompressRoundTrip, CompressThenDecompress) {
+  RETURN_STATUS       Status;
+  UINT8               Probe;
+  UINTN               CompressedSize;
+  UINT32              DestinationSize;
+  UINT32              ScratchSize;
+  std::vector<UINT8>  Compressed;
+  std::vector<UINT8>  Output;
+  std::vector<UINT8>  Scratch;
+
+  CompressedSize = sizeof (Probe);
+  Status         = UefiCompress (Input.data (), Input.size (), &Probe, &CompressedSize);
+  ASSERT_EQ (Status, RETURN_BUFFER_TOO_SMALL);
+  ASSERT_GT (CompressedSize, sizeof (Probe));
+
+  Compressed.resize (CompressedSize);
+  Status = UefiCompress (Input.data (), Input.size (), Compressed.data (), &CompressedSize);
+  ASSERT_EQ (Status, RETURN_SUCCESS);
+  ASSERT_LE (CompressedSize, Compressed.size ());
+
+  Status = UefiDecompressGetInfo (Compressed.data (), (UINT32)CompressedSize, &DestinationSize, &ScratchSize);
+  ASSERT_EQ (Status, RETURN_SUCCESS);
+  ASSERT_EQ (DestinationSize, Input.size ());
+
+  //
+  // Keep both buffers non-empty so data () never returns NULL.
+  //
+  Output.resize (DestinationSize + 1);
+  Scratch.resize (ScratchSize);
+  Status = UefiDecompress (Compressed.data (), Output.data (), Scratch.data ());
+  ASSERT_EQ (Status, RETURN_SUCCESS);
+  EXPECT_EQ (CompareMem (Output.data (), Input.data (), Input.size ()), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P (
+  Sizes,
+  UefiCompressRoundTrip,
+  Values (
+    COMPRESS_TEST_PARAM { 1, PatternText },
+    COMPRESS_TEST_PARAM { 17, PatternRandom },
+    COMPRESS_TEST_PARAM { 4096, PatternZero },
+    COMPRESS_TEST_PARAM { 4096, PatternText },
+    COMPRESS_TEST_PARAM { 4096, PatternRandom },
+    COMPRESS_TEST_PARAM { 65537, PatternText },
+    COMPRESS_TEST_PARAM { 65537, PatternRandom },
+    COMPRESS_TEST_PARAM { 1024 * 1024, PatternText }
+    )
+  );
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
@@ -186,6 +186,8 @@ DiskIoDriverBindingStart (
     goto ErrorExit;
   }
 
+  DiskIoCacheInit (Instance, ControllerHandle);
+
   //
   // Install protocol interfaces for the Disk IO device.
   //
@@ -210,6 +212,7 @@ DiskIoDriverBindingStart (
 ErrorExit:
   if (EFI_ERROR (Status)) {
     if ((Instance != NULL) && (Instance->SharedWorkingBuffer != NULL)) {
+      DiskIoCacheFree (Instance);
       FreeAlignedPages (
         Instance->SharedWorkingBuffer,
         EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
@@ -325,6 +328,7 @@ DiskIoDriverBindingStop (
       EfiReleaseLock (&Instance->TaskQueueLock);
     } while (!AllTaskDone);
 
+    DiskIoCacheFree (Instance);
     FreeAlignedPages (
       Instance->SharedWorkingBuffer,
       EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
@@ -432,6 +436,19 @@ DiskIo2OnReadWriteComplete (
     CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->Length);
   }
 
+  if (Subtask->Write) {
+    //
+    // The cached copy of the blocks was dropped when the write was submitted,
+    // drop it again in case they were read back before the write completed.
+    //
+    DiskIoCacheWrite (
+      Instance,
+      MultU64x32 (Subtask->Lba, Instance->BlockIo->Media->BlockSize),
+      MAX (Subtask->Length, Instance->BlockIo->Media->BlockSize),
+      NULL
+      );
+  }
+
   DiskIoDestroySubtask (Instance, Subtask);
 
   if (EFI_ERROR (TransactionStatus) || IsListEmpty (&Task->Subtasks)) {
@@ -865,10 +882,17 @@ DiskIo2ReadWriteDisk (
     //
     while (!DiskIo2RemoveCompletedTask (Instance)) {
     }
+  } else {
+    DiskIo2RemoveCompletedTask (Instance);
+  }
 
+  if (!Write && DiskIoCacheRead (Instance, MediaId, Offset, Token, BufferSize, Buffer, &Status)) {
+    return Status;
+  }
+
+  if (Blocking) {
     SubtasksPtr = &Subtasks;
   } else {
-    DiskIo2RemoveCompletedTask (Instance);
     Task = AllocatePool (sizeof (DISK_IO2_TASK));
     if (Task == NULL) {
       return EFI_OUT_OF_RESOURCES;
@@ -1016,6 +1040,14 @@ DiskIo2ReadWriteDisk (
   gBS->RestoreTPL (SubtaskLockTpl);
   gBS->RestoreTPL (SubtaskPerformTpl);
 
+  if (Write) {
+    //
+    // The cache is write-through. The outcome of a failed or non-blocking
+    // write is not known, so the cached copy of the range is dropped instead.
+    //
+    DiskIoCacheWrite (Instance, Offset, BufferSize, (Blocking && !EFI_ERROR (Status)) ? Buffer : NULL);
+  }
+
   return Status;
 }
 
@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 #include <Protocol/DiskIo.h>
+#include <Protocol/DevicePath.h>
 #include <Library/DebugLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/UefiLib.h>
@@ -22,6 +23,72 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/PcdLib.h>
+#include <Library/DevicePathLib.h>
+
+//
+// Size of a cache line, rounded up to a whole number of blocks.
+//
+#define DISK_IO_CACHE_LINE_SIZE  SIZE_4KB
+
+//
+// Number of back-to-back reads after which reads are considered sequential
+// and the cache starts to read ahead.
+//
+#define DISK_IO_CACHE_SEQUENTIAL_READS  2
+
+#define DISK_IO_CACHE_INVALID_LINE  MAX_UINT64
+
+typedef struct {
+  UINT64     Line;                          /// < line number, DISK_IO_CACHE_INVALID_LINE if unused
+  UINT64     LastUse;
+  BOOLEAN    ReadAhead;                     /// < read ahead and not used yet
+  UINT8      *Data;
+} DISK_IO_CACHE_LINE;
+
+typedef struct {
+  UINT64    ReadHits;
+  UINT64    ReadMisses;
+  UINT64    Bypassed;
+  UINT64    ReadAheadLines;
+  UINT64    ReadAheadHits;
+  UINT64    Invalidations;
+} DISK_IO_CACHE_STATS;
+
+typedef struct {
+  UINTN                  LineCount;         /// < 0 if the cache is disabled
+  UINT32                 LineBlocks;
+  UINT32                 LineSize;
+  DISK_IO_CACHE_LINE     *Lines;
+  UINT8                  *LineData;
+  UINTN                  FillLines;         /// < size of FillBuffer in lines
+  UINT8                  *FillBuffer;
+
+  UINT32                 MediaId;
+  UINT64                 WriteCount;        /// < value of the write counter the lines are valid for
+  UINT64                 UseCount;
+
+  UINT64                 NextOffset;
+  UINTN                  SequentialReads;
+  UINTN                  ReadAheadWindow;
+
+  DISK_IO_CACHE_STATS    Stats;
+} DISK_IO_CACHE;
+
+//
+// Number of writes issued through the Disk I/O instances of a disk and of its
+// partitions. The instances share it, a cache is only valid while it has seen
+// all of them.
+//
+#define DISK_IO_WRITE_COUNTER_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'W')
+typedef struct {
+  UINT32      Signature;
+  LIST_ENTRY  Link;
+  UINTN       RefCount;
+  UINT64      WriteCount;
+  UINTN       DevicePathSize;               /// < size of DevicePath, without end node
+  UINT8       *DevicePath;                  /// < device path of the disk, NULL if unknown
+} DISK_IO_WRITE_COUNTER;
 
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
@@ -36,6 +103,9 @@ typedef struct {
 
   EFI_LOCK                  TaskQueueLock;
   LIST_ENTRY                TaskQueue;
+
+  DISK_IO_CACHE             Cache;
+  DISK_IO_WRITE_COUNTER     *WriteCounter;  /// < NULL if it could not be allocated
 } DISK_IO_PRIVATE_DATA;
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO(a)   CR (a, DISK_IO_PRIVATE_DATA, DiskIo,  DISK_IO_PRIVATE_DATA_SIGNATURE)
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a)  CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
@@ -334,6 +404,90 @@ DiskIo2FlushDiskEx (
   IN OUT EFI_DISK_IO2_TOKEN  *Token
   );
 
+//
+// Disk I/O cache
+//
+
+/**
+  Attach a Disk I/O instance to the write counter of its disk and allocate its
+  read cache, if enabled by PcdDiskIoCacheLineCount. The instance works
+  without a cache if it cannot be allocated.
+
+  @param  Instance          Pointer to the DISK_IO_PRIVATE_DATA.
+  @param  ControllerHandle  Handle the Disk I/O instance is installed on.
+
+**/
+VOID
+DiskIoCacheInit (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN EFI_HANDLE            ControllerHandle
+  );
+
+/**
+  Dump the statistics of the read cache of a Disk I/O instance, free it and
+  detach the instance from the write counter of its disk.
+
+  @param  Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+
+**/
+VOID
+DiskIoCacheFree (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  );
+
+/**
+  Serve a read request from the cache.
+
+  Blocking reads that miss are read from the device through the cache, with
+  read-ahead if the reads are sequential. Non-blocking reads are only served
+  if all of the data is cached.
+
+  @param Instance      Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId       ID of the medium to read.
+  @param Offset        The starting byte offset on the device to read from.
+  @param Token         A pointer to the token associated with the transaction.
+                       If this field is NULL, synchronous/blocking IO is performed.
+  @param BufferSize    The size in bytes of Buffer.
+  @param Buffer        A pointer to the destination buffer for the data.
+  @param Status        The status of the read, if it was handled.
+
+  @retval TRUE         The read was handled, its status is returned in Status.
+  @retval FALSE        The read has to be issued to the device.
+
+**/
+BOOLEAN
+DiskIoCacheRead (
+  IN  DISK_IO_PRIVATE_DATA  *Instance,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  EFI_DISK_IO2_TOKEN    *Token,
+  IN  UINTN                 BufferSize,
+  OUT UINT8                 *Buffer,
+  OUT EFI_STATUS            *Status
+  );
+
+/**
+  Account a write to the device in the cache.
+
+  The written data is copied into the cached lines it overlaps. If Buffer is
+  NULL, the outcome of the write is unknown and the lines are dropped instead.
+  The caches of the other Disk I/O instances of the same disk are invalidated,
+  as they may cache the same blocks through a different partition.
+
+  @param Instance      Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset        The starting byte offset on the device written to.
+  @param BufferSize    The size in bytes of the write.
+  @param Buffer        The written data, or NULL.
+
+**/
+VOID
+DiskIoCacheWrite (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINT64                Offset,
+  IN UINTN                 BufferSize,
+  IN UINT8                 *Buffer  OPTIONAL
+  );
+
 //
 // EFI Component Name Functions
 //
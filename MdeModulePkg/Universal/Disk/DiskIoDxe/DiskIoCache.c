@@ -0,0 +1,768 @@
+/** @file
+  Read cache of the DiskIo driver.
+
+  Each Disk I/O instance may keep a small cache of fixed size lines in front
+  of its Block I/O device. File systems issue many small reads of their
+  metadata, which are served from memory once the lines are cached. When the
+  reads are sequential, more lines than requested are read from the device at
+  once, doubling the read-ahead window on every miss up to
+  PcdDiskIoCacheReadAheadLines.
+
+  Writes always go through to the device and update the cached lines they
+  overlap. The same blocks may be cached by the Disk I/O instances of a disk
+  and of its partitions, so these instances share a write counter, and every
+  write invalidates the caches of the other instances of the same disk. The
+  cache is dropped when the media changes.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DiskIo.h"
+
+//
+// Write counters of the disks with a Disk I/O instance.
+//
+LIST_ENTRY  mDiskIoWriteCounters = INITIALIZE_LIST_HEAD_VARIABLE (mDiskIoWriteCounters);
+
+/**
+  Return the size of the device path of the disk a Disk I/O instance is
+  installed on, which is the device path of the instance without the nodes
+  appended by the partition drivers.
+
+  @param DevicePath  The device path of the Disk I/O instance.
+
+  @return The size of the disk device path, without end node.
+
+**/
+STATIC
+UINTN
+DiskIoGetDiskDevicePathSize (
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL  *Node;
+  UINTN                     Size;
+
+  Size = 0;
+  for (Node = DevicePath; !IsDevicePathEnd (Node); Node = NextDevicePathNode (Node)) {
+    if ((DevicePathType (Node) != MEDIA_DEVICE_PATH) ||
+        ((DevicePathSubType (Node) != MEDIA_HARDDRIVE_DP) &&
+         (DevicePathSubType (Node) != MEDIA_CDROM_DP) &&
+         (DevicePathSubType (Node) != MEDIA_VENDOR_DP)))
+    {
+      Size = (UINTN)NextDevicePathNode (Node) - (UINTN)DevicePath;
+    }
+  }
+
+  return Size;
+}
+
+/**
+  Attach a Disk I/O instance to the write counter of its disk, allocating the
+  counter if it is the first instance of the disk.
+
+  @param Instance          Pointer to the DISK_IO_PRIVATE_DATA.
+  @param ControllerHandle  Handle the Disk I/O instance is installed on.
+
+**/
+STATIC
+VOID
+DiskIoAttachWriteCounter (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN EFI_HANDLE            ControllerHandle
+  )
+{
+  EFI_STATUS                Status;
+  EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
+  DISK_IO_WRITE_COUNTER     *NewCounter;
+  DISK_IO_WRITE_COUNTER     *Counter;
+  LIST_ENTRY                *Link;
+  UINTN                     Size;
+  EFI_TPL                   OldTpl;
+
+  Status = gBS->HandleProtocol (ControllerHandle, &gEfiDevicePathProtocolGuid, (VOID **)&DevicePath);
+  if (EFI_ERROR (Status)) {
+    DevicePath = NULL;
+    Size       = 0;
+  } else {
+    Size = DiskIoGetDiskDevicePathSize (DevicePath);
+  }
+
+  //
+  // Allocate the counter up front, it is freed below if the disk already has
+  // one. The device path is copied even when empty, so that the instances
+  // without a device path never share a counter.
+  //
+  NewCounter = AllocateZeroPool (sizeof (DISK_IO_WRITE_COUNTER));
+  if ((NewCounter != NULL) && (DevicePath != NULL)) {
+    NewCounter->DevicePath = AllocateCopyPool (MAX (Size, 1), DevicePath);
+    if (NewCounter->DevicePath == NULL) {
+      FreePool (NewCounter);
+      NewCounter = NULL;
+    }
+  }
+
+  Counter = NULL;
+  OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+  if (DevicePath != NULL) {
+    for (Link = GetFirstNode (&mDiskIoWriteCounters);
+         !IsNull (&mDiskIoWriteCounters, Link);
+         Link = GetNextNode (&mDiskIoWriteCounters, Link))
+    {
+      Counter = CR (Link, DISK_IO_WRITE_COUNTER, Link, DISK_IO_WRITE_COUNTER_SIGNATURE);
+      if ((Counter->DevicePath != NULL) && (Counter->DevicePathSize == Size) &&
+          (CompareMem (Counter->DevicePath, DevicePath, Size) == 0))
+      {
+        Counter->RefCount++;
+        break;
+      }
+
+      Counter = NULL;
+    }
+  }
+
+  if ((Counter == NULL) && (NewCounter != NULL)) {
+    NewCounter->Signature      = DISK_IO_WRITE_COUNTER_SIGNATURE;
+    NewCounter->RefCount       = 1;
+    NewCounter->DevicePathSize = Size;
+    InsertTailList (&mDiskIoWriteCounters, &NewCounter->Link);
+    Counter    = NewCounter;
+    NewCounter = NULL;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (NewCounter != NULL) {
+    if (NewCounter->DevicePath != NULL) {
+      FreePool (NewCounter->DevicePath);
+    }
+
+    FreePool (NewCounter);
+  }
+
+  Instance->WriteCounter = Counter;
+}
+
+/**
+  Detach a Disk I/O instance from the write counter of its disk, freeing the
+  counter with the last instance of the disk.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+
+**/
+STATIC
+VOID
+DiskIoDetachWriteCounter (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  )
+{
+  DISK_IO_WRITE_COUNTER  *Counter;
+  EFI_TPL                OldTpl;
+
+  Counter = Instance->WriteCounter;
+  if (Counter == NULL) {
+    return;
+  }
+
+  Instance->WriteCounter = NULL;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Counter->RefCount--;
+  if (Counter->RefCount != 0) {
+    gBS->RestoreTPL (OldTpl);
+    return;
+  }
+
+  RemoveEntryList (&Counter->Link);
+  gBS->RestoreTPL (OldTpl);
+
+  if (Counter->DevicePath != NULL) {
+    FreePool (Counter->DevicePath);
+  }
+
+  FreePool (Counter);
+}
+
+/**
+  Return the number of writes issued through the Disk I/O instances of the
+  disk of an instance. Must be called at TPL_NOTIFY.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+
+  @return The write count.
+
+**/
+STATIC
+UINT64
+DiskIoGetWriteCount (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  )
+{
+  //
+  // The cache is disabled on the instances without a write counter.
+  //
+  ASSERT (Instance->WriteCounter != NULL);
+  return Instance->WriteCounter->WriteCount;
+}
+
+/**
+  Drop all the lines of the cache.
+
+  @param Cache       Pointer to the DISK_IO_CACHE.
+
+**/
+STATIC
+VOID
+DiskIoCacheInvalidateAll (
+  IN DISK_IO_CACHE  *Cache
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Cache->LineCount; Index++) {
+    if (Cache->Lines[Index].Line != DISK_IO_CACHE_INVALID_LINE) {
+      Cache->Lines[Index].Line = DISK_IO_CACHE_INVALID_LINE;
+      Cache->Stats.Invalidations++;
+    }
+  }
+
+  Cache->SequentialReads = 0;
+  Cache->ReadAheadWindow = 0;
+}
+
+/**
+  Drop the cache if the media was changed or if a write was issued through
+  another Disk I/O instance of the same disk. Must be called at TPL_NOTIFY.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+
+**/
+STATIC
+VOID
+DiskIoCacheValidate (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  EFI_BLOCK_IO_MEDIA  *Media;
+
+  Cache = &Instance->Cache;
+  Media = Instance->BlockIo->Media;
+
+  if ((Cache->MediaId != Media->MediaId) || (Cache->WriteCount != DiskIoGetWriteCount (Instance))) {
+    DiskIoCacheInvalidateAll (Cache);
+    Cache->MediaId    = Media->MediaId;
+    Cache->WriteCount = DiskIoGetWriteCount (Instance);
+  }
+}
+
+/**
+  Find a line in the cache.
+
+  @param Cache       Pointer to the DISK_IO_CACHE.
+  @param Line        The line number.
+
+  @return The cached line, or NULL if it is not cached.
+
+**/
+STATIC
+DISK_IO_CACHE_LINE *
+DiskIoCacheLookup (
+  IN DISK_IO_CACHE  *Cache,
+  IN UINT64         Line
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Cache->LineCount; Index++) {
+    if (Cache->Lines[Index].Line == Line) {
+      return &Cache->Lines[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Store a line in the cache, replacing the least recently used line if the
+  line is not cached yet.
+
+  @param Cache       Pointer to the DISK_IO_CACHE.
+  @param Line        The line number.
+  @param Data        The data of the line.
+  @param ReadAhead   TRUE if the line was read ahead of the reads.
+
+**/
+STATIC
+VOID
+DiskIoCacheInsert (
+  IN DISK_IO_CACHE  *Cache,
+  IN UINT64         Line,
+  IN UINT8          *Data,
+  IN BOOLEAN        ReadAhead
+  )
+{
+  DISK_IO_CACHE_LINE  *Entry;
+  UINTN               Index;
+
+  Entry = DiskIoCacheLookup (Cache, Line);
+  if (Entry == NULL) {
+    Entry = &Cache->Lines[0];
+    for (Index = 1; Index < Cache->LineCount; Index++) {
+      if (Cache->Lines[Index].LastUse < Entry->LastUse) {
+        Entry = &Cache->Lines[Index];
+      }
+    }
+  }
+
+  CopyMem (Entry->Data, Data, Cache->LineSize);
+  Entry->Line      = Line;
+  Entry->LastUse   = ++Cache->UseCount;
+  Entry->ReadAhead = ReadAhead;
+}
+
+/**
+  Copy a byte range out of the cache if all of its lines are cached.
+
+  @param Cache       Pointer to the DISK_IO_CACHE.
+  @param Offset      The starting byte offset on the device.
+  @param BufferSize  The size in bytes of the range.
+  @param Buffer      A pointer to the destination buffer for the data.
+
+  @retval TRUE       The range was copied.
+  @retval FALSE      Some of the lines are not cached.
+
+**/
+STATIC
+BOOLEAN
+DiskIoCacheCopyOut (
+  IN  DISK_IO_CACHE  *Cache,
+  IN  UINT64         Offset,
+  IN  UINTN          BufferSize,
+  OUT UINT8          *Buffer
+  )
+{
+  DISK_IO_CACHE_LINE  *Entry;
+  UINT64              Line;
+  UINT64              FirstLine;
+  UINT64              LastLine;
+  UINT32              LineOffset;
+  UINTN               Length;
+
+  FirstLine = DivU64x32Remainder (Offset, Cache->LineSize, &LineOffset);
+  LastLine  = DivU64x32 (Offset + BufferSize - 1, Cache->LineSize);
+
+  for (Line = FirstLine; Line <= LastLine; Line++) {
+    if (DiskIoCacheLookup (Cache, Line) == NULL) {
+      return FALSE;
+    }
+  }
+
+  for (Line = FirstLine; Line <= LastLine; Line++) {
+    Entry  = DiskIoCacheLookup (Cache, Line);
+    Length = MIN (BufferSize, Cache->LineSize - LineOffset);
+    CopyMem (Buffer, Entry->Data + LineOffset, Length);
+
+    if (Entry->ReadAhead) {
+      Entry->ReadAhead = FALSE;
+      Cache->Stats.ReadAheadHits++;
+    }
+
+    Entry->LastUse = ++Cache->UseCount;
+    Buffer        += Length;
+    BufferSize    -= Length;
+    LineOffset     = 0;
+  }
+
+  return TRUE;
+}
+
+/**
+  Free the lines of the read cache of a Disk I/O instance.
+
+  @param Cache       Pointer to the DISK_IO_CACHE.
+
+**/
+STATIC
+VOID
+DiskIoCacheFreeLines (
+  IN DISK_IO_CACHE  *Cache
+  )
+{
+  if (Cache->FillBuffer != NULL) {
+    FreeAlignedPages (Cache->FillBuffer, EFI_SIZE_TO_PAGES (Cache->FillLines * Cache->LineSize));
+  }
+
+  if (Cache->LineData != NULL) {
+    FreePool (Cache->LineData);
+  }
+
+  if (Cache->Lines != NULL) {
+    FreePool (Cache->Lines);
+  }
+
+  ZeroMem (Cache, sizeof (DISK_IO_CACHE));
+}
+
+/**
+  Attach a Disk I/O instance to the write counter of its disk and allocate its
+  read cache, if enabled by PcdDiskIoCacheLineCount. The instance works
+  without a cache if it cannot be allocated.
+
+  @param  Instance          Pointer to the DISK_IO_PRIVATE_DATA.
+  @param  ControllerHandle  Handle the Disk I/O instance is installed on.
+
+**/
+VOID
+DiskIoCacheInit (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN EFI_HANDLE            ControllerHandle
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  EFI_BLOCK_IO_MEDIA  *Media;
+  UINTN               LineCount;
+  UINTN               Index;
+
+  Cache = &Instance->Cache;
+  Media = Instance->BlockIo->Media;
+  ZeroMem (Cache, sizeof (DISK_IO_CACHE));
+
+  DiskIoAttachWriteCounter (Instance, ControllerHandle);
+
+  LineCount = PcdGet32 (PcdDiskIoCacheLineCount);
+  if ((LineCount == 0) || (Media->BlockSize == 0)) {
+    return;
+  }
+
+  if (Instance->WriteCounter == NULL) {
+    DEBUG ((DEBUG_WARN, "DiskIo: No enough memory for the write counter, running without cache\n"));
+    return;
+  }
+
+  Cache->LineBlocks = MAX (1, DISK_IO_CACHE_LINE_SIZE / Media->BlockSize);
+  Cache->LineSize   = Cache->LineBlocks * Media->BlockSize;
+  Cache->FillLines  = MIN (MAX (PcdGet32 (PcdDiskIoCacheReadAheadLines), 2), LineCount);
+
+  Cache->Lines      = AllocateZeroPool (LineCount * sizeof (DISK_IO_CACHE_LINE));
+  Cache->LineData   = AllocatePool (LineCount * Cache->LineSize);
+  Cache->FillBuffer = AllocateAlignedPages (
+                        EFI_SIZE_TO_PAGES (Cache->FillLines * Cache->LineSize),
+                        Media->IoAlign
+                        );
+  if ((Cache->Lines == NULL) || (Cache->LineData == NULL) || (Cache->FillBuffer == NULL)) {
+    DEBUG ((DEBUG_WARN, "DiskIo: No enough memory for the cache, running without it\n"));
+    DiskIoCacheFreeLines (Cache);
+    return;
+  }
+
+  for (Index = 0; Index < LineCount; Index++) {
+    Cache->Lines[Index].Line = DISK_IO_CACHE_INVALID_LINE;
+    Cache->Lines[Index].Data = Cache->LineData + Index * Cache->LineSize;
+  }
+
+  Cache->LineCount  = LineCount;
+  Cache->MediaId    = Media->MediaId;
+  Cache->WriteCount = DiskIoGetWriteCount (Instance);
+  Cache->NextOffset = MAX_UINT64;
+}
+
+/**
+  Dump the statistics of the read cache of a Disk I/O instance, free it and
+  detach the instance from the write counter of its disk.
+
+  @param  Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+
+**/
+VOID
+DiskIoCacheFree (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  )
+{
+  DISK_IO_CACHE  *Cache;
+  UINT64         Reads;
+
+  Cache = &Instance->Cache;
+
+  Reads = Cache->Stats.ReadHits + Cache->Stats.ReadMisses;
+  if (Reads != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "DiskIo: Cache %ld hits, %ld misses (%ld%% hit rate), %ld bypassed, %ld of %ld read-ahead lines used, %ld invalidated\n",
+      Cache->Stats.ReadHits,
+      Cache->Stats.ReadMisses,
+      DivU64x64Remainder (MultU64x32 (Cache->Stats.ReadHits, 100), Reads, NULL),
+      Cache->Stats.Bypassed,
+      Cache->Stats.ReadAheadHits,
+      Cache->Stats.ReadAheadLines,
+      Cache->Stats.Invalidations
+      ));
+  }
+
+  DiskIoCacheFreeLines (Cache);
+  DiskIoDetachWriteCounter (Instance);
+}
+
+/**
+  Serve a read request from the cache.
+
+  Blocking reads that miss are read from the device through the cache, with
+  read-ahead if the reads are sequential. Non-blocking reads are only served
+  if all of the data is cached.
+
+  @param Instance      Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId       ID of the medium to read.
+  @param Offset        The starting byte offset on the device to read from.
+  @param Token         A pointer to the token associated with the transaction.
+                       If this field is NULL, synchronous/blocking IO is performed.
+  @param BufferSize    The size in bytes of Buffer.
+  @param Buffer        A pointer to the destination buffer for the data.
+  @param Status        The status of the read, if it was handled.
+
+  @retval TRUE         The read was handled, its status is returned in Status.
+  @retval FALSE        The read has to be issued to the device.
+
+**/
+BOOLEAN
+DiskIoCacheRead (
+  IN  DISK_IO_PRIVATE_DATA  *Instance,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  EFI_DISK_IO2_TOKEN    *Token,
+  IN  UINTN                 BufferSize,
+  OUT UINT8                 *Buffer,
+  OUT EFI_STATUS            *Status
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  EFI_BLOCK_IO_MEDIA  *Media;
+  BOOLEAN             Blocking;
+  UINT64              MediaSize;
+  UINT64              MediaLines;
+  UINT64              FirstLine;
+  UINT64              LastLine;
+  UINTN               RequestLines;
+  UINTN               Lines;
+  UINTN               Index;
+  UINT64              Lba;
+  UINTN               FillSize;
+  UINT64              WriteCount;
+  EFI_TPL             FillTpl;
+  EFI_TPL             OldTpl;
+
+  Cache    = &Instance->Cache;
+  Media    = Instance->BlockIo->Media;
+  Blocking = (BOOLEAN)((Token == NULL) || (Token->Event == NULL));
+
+  if ((Cache->LineCount == 0) || (BufferSize == 0) ||
+      !Media->MediaPresent || (MediaId != Media->MediaId))
+  {
+    return FALSE;
+  }
+
+  //
+  // Blocking reads fill the cache at TPL_CALLBACK, like the other blocking
+  // requests, which serializes the use of the fill buffer.
+  //
+  if (EfiGetCurrentTpl () > (Blocking ? TPL_CALLBACK : TPL_NOTIFY)) {
+    return FALSE;
+  }
+
+  MediaSize = MultU64x32 (Media->LastBlock + 1, Media->BlockSize);
+  if ((Offset >= MediaSize) || (BufferSize > MediaSize - Offset)) {
+    return FALSE;
+  }
+
+  FirstLine    = DivU64x32 (Offset, Cache->LineSize);
+  LastLine     = DivU64x32 (Offset + BufferSize - 1, Cache->LineSize);
+  RequestLines = (UINTN)(LastLine - FirstLine + 1);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  DiskIoCacheValidate (Instance);
+
+  if (RequestLines > Cache->FillLines) {
+    //
+    // Large reads go to the device directly rather than evicting the cache.
+    //
+    Cache->Stats.Bypassed++;
+    Cache->SequentialReads = 0;
+    Cache->ReadAheadWindow = 0;
+    gBS->RestoreTPL (OldTpl);
+    return FALSE;
+  }
+
+  if (Offset == Cache->NextOffset) {
+    Cache->SequentialReads++;
+  } else {
+    Cache->SequentialReads = 0;
+    Cache->ReadAheadWindow = 0;
+  }
+
+  Cache->NextOffset = Offset + BufferSize;
+
+  if (DiskIoCacheCopyOut (Cache, Offset, BufferSize, Buffer)) {
+    Cache->Stats.ReadHits++;
+    gBS->RestoreTPL (OldTpl);
+
+    if (!Blocking) {
+      Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Token->Event);
+    }
+
+    *Status = EFI_SUCCESS;
+    return TRUE;
+  }
+
+  Cache->Stats.ReadMisses++;
+  if (!Blocking) {
+    gBS->RestoreTPL (OldTpl);
+    return FALSE;
+  }
+
+  //
+  // Read the missing lines, and more of them if the reads are sequential.
+  //
+  Lines = RequestLines;
+  if (Cache->SequentialReads >= DISK_IO_CACHE_SEQUENTIAL_READS) {
+    Cache->ReadAheadWindow = MIN (MAX (Cache->ReadAheadWindow * 2, 2), Cache->FillLines);
+    Lines                  = MAX (Lines, Cache->ReadAheadWindow);
+  }
+
+  MediaLines = DivU64x32 (Media->LastBlock + Cache->LineBlocks, Cache->LineBlocks);
+  Lines      = (UINTN)MIN (Lines, MediaLines - FirstLine);
+  WriteCount = DiskIoGetWriteCount (Instance);
+  gBS->RestoreTPL (OldTpl);
+
+  Lba      = MultU64x32 (FirstLine, Cache->LineBlocks);
+  FillSize = (UINTN)MultU64x32 (
+                      MIN (MultU64x32 (Lines, Cache->LineBlocks), Media->LastBlock + 1 - Lba),
+                      Media->BlockSize
+                      );
+
+  FillTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  *Status = Instance->BlockIo->ReadBlocks (
+                                 Instance->BlockIo,
+                                 MediaId,
+                                 Lba,
+                                 FillSize,
+                                 Cache->FillBuffer
+                                 );
+  if (!EFI_ERROR (*Status)) {
+    CopyMem (Buffer, Cache->FillBuffer + (Offset - MultU64x32 (FirstLine, Cache->LineSize)), BufferSize);
+
+    //
+    // Only keep the data if nothing was written meanwhile.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    if ((WriteCount == DiskIoGetWriteCount (Instance)) && (Cache->MediaId == Media->MediaId)) {
+      for (Index = 0; Index < Lines; Index++) {
+        DiskIoCacheInsert (
+          Cache,
+          FirstLine + Index,
+          Cache->FillBuffer + Index * Cache->LineSize,
+          (BOOLEAN)(Index >= RequestLines)
+          );
+      }
+
+      Cache->Stats.ReadAheadLines += Lines - RequestLines;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  gBS->RestoreTPL (FillTpl);
+  return TRUE;
+}
+
+/**
+  Account a write to the device in the cache.
+
+  The written data is copied into the cached lines it overlaps. If Buffer is
+  NULL, the outcome of the write is unknown and the lines are dropped instead.
+  The caches of the other Disk I/O instances of the same disk are invalidated,
+  as they may cache the same blocks through a different partition.
+
+  @param Instance      Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset        The starting byte offset on the device written to.
+  @param BufferSize    The size in bytes of the write.
+  @param Buffer        The written data, or NULL.
+
+**/
+VOID
+DiskIoCacheWrite (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINT64                Offset,
+  IN UINTN                 BufferSize,
+  IN UINT8                 *Buffer  OPTIONAL
+  )
+{
+  DISK_IO_CACHE          *Cache;
+  DISK_IO_CACHE_LINE     *Entry;
+  DISK_IO_WRITE_COUNTER  *Counter;
+  LIST_ENTRY             *Link;
+  BOOLEAN                Valid;
+  UINT64              LineStart;
+  UINT64              Start;
+  UINT64              End;
+  UINTN               Index;
+  EFI_TPL             OldTpl;
+
+  if (BufferSize == 0) {
+    return;
+  }
+
+  Cache  = &Instance->Cache;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (Instance->WriteCounter == NULL) {
+    //
+    // The disk of the instance is not known, assume that the write may
+    // overlap the blocks cached for any disk.
+    //
+    for (Link = GetFirstNode (&mDiskIoWriteCounters);
+         !IsNull (&mDiskIoWriteCounters, Link);
+         Link = GetNextNode (&mDiskIoWriteCounters, Link))
+    {
+      Counter = CR (Link, DISK_IO_WRITE_COUNTER, Link, DISK_IO_WRITE_COUNTER_SIGNATURE);
+      Counter->WriteCount++;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+    return;
+  }
+
+  Valid = (BOOLEAN)(Cache->WriteCount == Instance->WriteCounter->WriteCount);
+  Instance->WriteCounter->WriteCount++;
+
+  if (Cache->LineCount != 0) {
+    if (!Valid) {
+      DiskIoCacheInvalidateAll (Cache);
+    } else {
+      for (Index = 0; Index < Cache->LineCount; Index++) {
+        Entry = &Cache->Lines[Index];
+        if (Entry->Line == DISK_IO_CACHE_INVALID_LINE) {
+          continue;
+        }
+
+        LineStart = MultU64x32 (Entry->Line, Cache->LineSize);
+        Start     = MAX (Offset, LineStart);
+        End       = MIN (Offset + BufferSize, LineStart + Cache->LineSize);
+        if (Start >= End) {
+          continue;
+        }
+
+        if (Buffer != NULL) {
+          CopyMem (Entry->Data + (Start - LineStart), Buffer + (Start - Offset), (UINTN)(End - Start));
+        } else {
+          Entry->Line = DISK_IO_CACHE_INVALID_LINE;
+          Cache->Stats.Invalidations++;
+        }
+      }
+    }
+
+    Cache->WriteCount = Instance->WriteCounter->WriteCount;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
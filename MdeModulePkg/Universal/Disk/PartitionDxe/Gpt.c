@@ -32,6 +32,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
   @param[in]  DiskIo      Disk Io protocol.
   @param[in]  Lba         The starting Lba of the Partition Table
   @param[out] PartHeader  Stores the partition table that is read
+  @param[out] PartEntry   Optional. Returns the partition entry array that
+                          was read and verified, to be freed by the caller.
 
   @retval TRUE      The partition table is valid
   @retval FALSE     The partition table is not valid
@@ -42,7 +44,88 @@ PartitionValidGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
   IN  EFI_LBA                     Lba,
-  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader
+  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  OUT EFI_PARTITION_ENTRY         **PartEntry OPTIONAL
+  );
+
+/**
+  Check the GPT partition table header that was read from Lba.
+
+  Caution: This function may receive untrusted input.
+  The GPT partition table header is external input, so this routine
+  will do basic validation for GPT partition table header before return.
+
+  @param[in]      BlockSize  Size of the block holding the header.
+  @param[in]      Lba        The Lba the header was read from.
+  @param[in, out] PartHdr    The header block.
+
+  @retval TRUE      The partition table header is valid
+  @retval FALSE     The partition table header is not valid
+
+**/
+BOOLEAN
+PartitionCheckGptHeader (
+  IN     UINT32                      BlockSize,
+  IN     EFI_LBA                     Lba,
+  IN OUT EFI_PARTITION_TABLE_HEADER  *PartHdr
+  );
+
+/**
+  Validate the primary and backup GPT tables from header blocks that were
+  already read, reading both partition entry arrays concurrently.
+
+  Only the common case of two intact tables with the backup header in the
+  last block is handled here. Anything else is left to the serial path,
+  which also restores a damaged table.
+
+  @param[in]  BlockIo        Parent BlockIo interface.
+  @param[in]  DiskIo         Disk Io protocol.
+  @param[in]  DiskIo2        Disk Io2 protocol.
+  @param[in]  PrimaryBlock   Block read from PRIMARY_PART_HEADER_LBA.
+  @param[in]  BackupBlock    Block read from the last block of the media.
+  @param[out] PrimaryHeader  Stores the primary partition table header.
+  @param[out] BackupHeader   Stores the backup partition table header.
+  @param[out] PartEntry      Returns the primary partition entry array,
+                             to be freed by the caller.
+
+  @retval TRUE      Both partition tables are valid
+  @retval FALSE     A partition table is not valid or could not be read
+
+**/
+BOOLEAN
+PartitionValidGptTablesOverlapped (
+  IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
+  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  EFI_DISK_IO2_PROTOCOL       *DiskIo2,
+  IN  EFI_PARTITION_TABLE_HEADER  *PrimaryBlock,
+  IN  EFI_PARTITION_TABLE_HEADER  *BackupBlock,
+  OUT EFI_PARTITION_TABLE_HEADER  *PrimaryHeader,
+  OUT EFI_PARTITION_TABLE_HEADER  *BackupHeader,
+  OUT EFI_PARTITION_ENTRY         **PartEntry
+  );
+
+/**
+  Read several regions of the disk.
+
+  With DiskIo2 all requests are submitted before waiting on any of them,
+  so the device can service them together. Without it, or if a request
+  cannot be submitted, the regions are read one after the other.
+
+  @param[in]      DiskIo    Disk Io protocol.
+  @param[in]      DiskIo2   Disk Io2 protocol, may be NULL.
+  @param[in]      MediaId   Id of the media.
+  @param[in, out] Requests  The read requests. The result of each read is
+                            returned in its Token.TransactionStatus.
+  @param[in]      Count     Number of requests.
+
+**/
+VOID
+PartitionReadGptRequests (
+  IN     EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN     EFI_DISK_IO2_PROTOCOL  *DiskIo2,
+  IN     UINT32                 MediaId,
+  IN OUT GPT_READ_REQUEST       *Requests,
+  IN     UINTN                  Count
   );
 
 /**
@@ -52,6 +135,8 @@ PartitionValidGptTable (
   @param[in]  BlockIo     Parent BlockIo interface
   @param[in]  DiskIo      Disk Io Protocol.
   @param[in]  PartHeader  Partition table header structure
+  @param[out] PartEntry   Optional. Returns the partition entry array if
+                          the CRC is valid, to be freed by the caller.
 
   @retval TRUE      the CRC is valid
   @retval FALSE     the CRC is invalid
@@ -61,7 +146,25 @@ BOOLEAN
 PartitionCheckGptEntryArrayCRC (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
-  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
+  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  OUT EFI_PARTITION_ENTRY         **PartEntry OPTIONAL
+  );
+
+/**
+  Check if the CRC field in the Partition table header is valid
+  for a Partition entry array already in memory.
+
+  @param[in]  PartHeader  Partition table header structure
+  @param[in]  PartEntry   The partition entry array
+
+  @retval TRUE      the CRC is valid
+  @retval FALSE     the CRC is invalid
+
+**/
+BOOLEAN
+PartitionCheckGptEntryArrayBufferCrc (
+  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  IN  EFI_PARTITION_ENTRY         *PartEntry
   );
 
 /**
@@ -199,6 +302,10 @@ PartitionInstallGptChildHandles (
   MASTER_BOOT_RECORD           *ProtectiveMbr;
   EFI_PARTITION_TABLE_HEADER   *PrimaryHeader;
   EFI_PARTITION_TABLE_HEADER   *BackupHeader;
+  EFI_PARTITION_TABLE_HEADER   *PrimaryBlock;
+  EFI_PARTITION_TABLE_HEADER   *BackupBlock;
+  GPT_READ_REQUEST             Requests[3];
+  UINTN                        RequestCount;
   EFI_PARTITION_ENTRY          *PartEntry;
   EFI_PARTITION_ENTRY          *Entry;
   EFI_PARTITION_ENTRY_STATUS   *PEntryStatus;
@@ -211,6 +318,8 @@ PartitionInstallGptChildHandles (
   ProtectiveMbr = NULL;
   PrimaryHeader = NULL;
   BackupHeader  = NULL;
+  PrimaryBlock  = NULL;
+  BackupBlock   = NULL;
   PartEntry     = NULL;
   PEntryStatus  = NULL;
 
@@ -238,16 +347,34 @@ PartitionInstallGptChildHandles (
     return EFI_NOT_FOUND;
   }
 
+  PERF_START (Handle, "GptProbe", NULL, 0);
+
   //
-  // Read the Protective MBR from LBA #0
+  // Read the Protective MBR from LBA #0. With DiskIo2 the primary and
+  // backup header blocks are fetched in the same batch, so the device
+  // services the three reads together instead of one after the other.
   //
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     0,
-                     BlockSize,
-                     ProtectiveMbr
-                     );
+  Requests[0].Offset     = 0;
+  Requests[0].BufferSize = BlockSize;
+  Requests[0].Buffer     = ProtectiveMbr;
+  RequestCount           = 1;
+
+  if (DiskIo2 != NULL) {
+    PrimaryBlock = AllocatePool (BlockSize);
+    BackupBlock  = AllocatePool (BlockSize);
+    if ((PrimaryBlock != NULL) && (BackupBlock != NULL)) {
+      Requests[1].Offset     = MultU64x32 (PRIMARY_PART_HEADER_LBA, BlockSize);
+      Requests[1].BufferSize = BlockSize;
+      Requests[1].Buffer     = PrimaryBlock;
+      Requests[2].Offset     = MultU64x32 (LastBlock, BlockSize);
+      Requests[2].BufferSize = BlockSize;
+      Requests[2].Buffer     = BackupBlock;
+      RequestCount           = 3;
+    }
+  }
+
+  PartitionReadGptRequests (DiskIo, DiskIo2, MediaId, Requests, RequestCount);
+  Status = Requests[0].Token.TransactionStatus;
   if (EFI_ERROR (Status)) {
     GptValidStatus = Status;
     goto Done;
@@ -285,10 +412,16 @@ PartitionInstallGptChildHandles (
   //
   // Check primary and backup partition tables
   //
-  if (!PartitionValidGptTable (BlockIo, DiskIo, PRIMARY_PART_HEADER_LBA, PrimaryHeader)) {
+  if ((RequestCount > 1) &&
+      !EFI_ERROR (Requests[1].Token.TransactionStatus) &&
+      !EFI_ERROR (Requests[2].Token.TransactionStatus) &&
+      PartitionValidGptTablesOverlapped (BlockIo, DiskIo, DiskIo2, PrimaryBlock, BackupBlock, PrimaryHeader, BackupHeader, &PartEntry))
+  {
+    DEBUG ((DEBUG_INFO, " Valid primary and backup partition table read overlapped\n"));
+  } else if (!PartitionValidGptTable (BlockIo, DiskIo, PRIMARY_PART_HEADER_LBA, PrimaryHeader, &PartEntry)) {
     DEBUG ((DEBUG_INFO, " Not Valid primary partition table\n"));
 
-    if (!PartitionValidGptTable (BlockIo, DiskIo, LastBlock, BackupHeader)) {
+    if (!PartitionValidGptTable (BlockIo, DiskIo, LastBlock, BackupHeader, NULL)) {
       DEBUG ((DEBUG_INFO, " Not Valid backup partition table\n"));
       goto Done;
     } else {
@@ -298,18 +431,18 @@ PartitionInstallGptChildHandles (
         DEBUG ((DEBUG_INFO, " Restore primary partition table error\n"));
       }
 
-      if (PartitionValidGptTable (BlockIo, DiskIo, BackupHeader->AlternateLBA, PrimaryHeader)) {
+      if (PartitionValidGptTable (BlockIo, DiskIo, BackupHeader->AlternateLBA, PrimaryHeader, &PartEntry)) {
         DEBUG ((DEBUG_INFO, " Restore backup partition table success\n"));
       }
     }
-  } else if (!PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader)) {
+  } else if (!PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader, NULL)) {
     DEBUG ((DEBUG_INFO, " Valid primary and !Valid backup partition table\n"));
     DEBUG ((DEBUG_INFO, " Restore backup partition table by the primary\n"));
     if (!PartitionRestoreGptTable (BlockIo, DiskIo, PrimaryHeader)) {
       DEBUG ((DEBUG_INFO, " Restore backup partition table error\n"));
     }
 
-    if (PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader)) {
+    if (PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader, NULL)) {
       DEBUG ((DEBUG_INFO, " Restore backup partition table success\n"));
     }
   }
@@ -317,25 +450,28 @@ PartitionInstallGptChildHandles (
   DEBUG ((DEBUG_INFO, " Valid primary and Valid backup partition table\n"));
 
   //
-  // Read the EFI Partition Entries
+  // Read the EFI Partition Entries, unless the validation above already
+  // returned the verified primary array
   //
-  PartEntry = AllocatePool (PrimaryHeader->NumberOfPartitionEntries * PrimaryHeader->SizeOfPartitionEntry);
   if (PartEntry == NULL) {
-    DEBUG ((DEBUG_ERROR, "Allocate pool error\n"));
-    goto Done;
-  }
+    PartEntry = AllocatePool (PrimaryHeader->NumberOfPartitionEntries * PrimaryHeader->SizeOfPartitionEntry);
+    if (PartEntry == NULL) {
+      DEBUG ((DEBUG_ERROR, "Allocate pool error\n"));
+      goto Done;
+    }
 
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     MultU64x32 (PrimaryHeader->PartitionEntryLBA, BlockSize),
-                     PrimaryHeader->NumberOfPartitionEntries * (PrimaryHeader->SizeOfPartitionEntry),
-                     PartEntry
-                     );
-  if (EFI_ERROR (Status)) {
-    GptValidStatus = Status;
-    DEBUG ((DEBUG_ERROR, " Partition Entry ReadDisk error\n"));
-    goto Done;
+    Status = DiskIo->ReadDisk (
+                       DiskIo,
+                       MediaId,
+                       MultU64x32 (PrimaryHeader->PartitionEntryLBA, BlockSize),
+                       PrimaryHeader->NumberOfPartitionEntries * (PrimaryHeader->SizeOfPartitionEntry),
+                       PartEntry
+                       );
+    if (EFI_ERROR (Status)) {
+      GptValidStatus = Status;
+      DEBUG ((DEBUG_ERROR, " Partition Entry ReadDisk error\n"));
+      goto Done;
+    }
   }
 
   DEBUG ((DEBUG_INFO, " Partition entries read block success\n"));
@@ -436,6 +572,14 @@ Done:
     FreePool (BackupHeader);
   }
 
+  if (PrimaryBlock != NULL) {
+    FreePool (PrimaryBlock);
+  }
+
+  if (BackupBlock != NULL) {
+    FreePool (BackupBlock);
+  }
+
   if (PartEntry != NULL) {
     FreePool (PartEntry);
   }
@@ -444,6 +588,8 @@ Done:
     FreePool (PEntryStatus);
   }
 
+  PERF_END (Handle, "GptProbe", NULL, 0);
+
   return GptValidStatus;
 }
 
@@ -458,6 +604,8 @@ Done:
   @param[in]  DiskIo      Disk Io protocol.
   @param[in]  Lba         The starting Lba of the Partition Table
   @param[out] PartHeader  Stores the partition table that is read
+  @param[out] PartEntry   Optional. Returns the partition entry array that
+                          was read and verified, to be freed by the caller.
 
   @retval TRUE      The partition table is valid
   @retval FALSE     The partition table is not valid
@@ -468,7 +616,8 @@ PartitionValidGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
   IN  EFI_LBA                     Lba,
-  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader
+  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  OUT EFI_PARTITION_ENTRY         **PartEntry OPTIONAL
   )
 {
   EFI_STATUS                  Status;
@@ -500,6 +649,44 @@ PartitionValidGptTable (
     return FALSE;
   }
 
+  if (!PartitionCheckGptHeader (BlockSize, Lba, PartHdr)) {
+    FreePool (PartHdr);
+    return FALSE;
+  }
+
+  CopyMem (PartHeader, PartHdr, sizeof (EFI_PARTITION_TABLE_HEADER));
+  if (!PartitionCheckGptEntryArrayCRC (BlockIo, DiskIo, PartHeader, PartEntry)) {
+    FreePool (PartHdr);
+    return FALSE;
+  }
+
+  DEBUG ((DEBUG_INFO, " Valid efi partition table header\n"));
+  FreePool (PartHdr);
+  return TRUE;
+}
+
+/**
+  Check the GPT partition table header that was read from Lba.
+
+  Caution: This function may receive untrusted input.
+  The GPT partition table header is external input, so this routine
+  will do basic validation for GPT partition table header before return.
+
+  @param[in]      BlockSize  Size of the block holding the header.
+  @param[in]      Lba        The Lba the header was read from.
+  @param[in, out] PartHdr    The header block.
+
+  @retval TRUE      The partition table header is valid
+  @retval FALSE     The partition table header is not valid
+
+**/
+BOOLEAN
+PartitionCheckGptHeader (
+  IN     UINT32                      BlockSize,
+  IN     EFI_LBA                     Lba,
+  IN OUT EFI_PARTITION_TABLE_HEADER  *PartHdr
+  )
+{
   if ((PartHdr->Header.Signature != EFI_PTAB_HEADER_ID) ||
       !PartitionCheckCrc (BlockSize, &PartHdr->Header) ||
       (PartHdr->MyLBA != Lba) ||
@@ -507,7 +694,6 @@ PartitionValidGptTable (
       )
   {
     DEBUG ((DEBUG_INFO, "Invalid efi partition table header\n"));
-    FreePool (PartHdr);
     return FALSE;
   }
 
@@ -515,19 +701,173 @@ PartitionValidGptTable (
   // Ensure the NumberOfPartitionEntries * SizeOfPartitionEntry doesn't overflow.
   //
   if (PartHdr->NumberOfPartitionEntries > DivU64x32 (MAX_UINTN, PartHdr->SizeOfPartitionEntry)) {
-    FreePool (PartHdr);
     return FALSE;
   }
 
-  CopyMem (PartHeader, PartHdr, sizeof (EFI_PARTITION_TABLE_HEADER));
-  if (!PartitionCheckGptEntryArrayCRC (BlockIo, DiskIo, PartHeader)) {
-    FreePool (PartHdr);
+  return TRUE;
+}
+
+/**
+  Validate the primary and backup GPT tables from header blocks that were
+  already read, reading both partition entry arrays concurrently.
+
+  Only the common case of two intact tables with the backup header in the
+  last block is handled here. Anything else is left to the serial path,
+  which also restores a damaged table.
+
+  @param[in]  BlockIo        Parent BlockIo interface.
+  @param[in]  DiskIo         Disk Io protocol.
+  @param[in]  DiskIo2        Disk Io2 protocol.
+  @param[in]  PrimaryBlock   Block read from PRIMARY_PART_HEADER_LBA.
+  @param[in]  BackupBlock    Block read from the last block of the media.
+  @param[out] PrimaryHeader  Stores the primary partition table header.
+  @param[out] BackupHeader   Stores the backup partition table header.
+  @param[out] PartEntry      Returns the primary partition entry array,
+                             to be freed by the caller.
+
+  @retval TRUE      Both partition tables are valid
+  @retval FALSE     A partition table is not valid or could not be read
+
+**/
+BOOLEAN
+PartitionValidGptTablesOverlapped (
+  IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
+  IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
+  IN  EFI_DISK_IO2_PROTOCOL       *DiskIo2,
+  IN  EFI_PARTITION_TABLE_HEADER  *PrimaryBlock,
+  IN  EFI_PARTITION_TABLE_HEADER  *BackupBlock,
+  OUT EFI_PARTITION_TABLE_HEADER  *PrimaryHeader,
+  OUT EFI_PARTITION_TABLE_HEADER  *BackupHeader,
+  OUT EFI_PARTITION_ENTRY         **PartEntry
+  )
+{
+  UINT32            BlockSize;
+  EFI_LBA           LastBlock;
+  GPT_READ_REQUEST  Requests[2];
+  BOOLEAN           Valid;
+
+  BlockSize = BlockIo->Media->BlockSize;
+  LastBlock = BlockIo->Media->LastBlock;
+
+  if (!PartitionCheckGptHeader (BlockSize, PRIMARY_PART_HEADER_LBA, PrimaryBlock) ||
+      (PrimaryBlock->AlternateLBA != LastBlock) ||
+      !PartitionCheckGptHeader (BlockSize, LastBlock, BackupBlock)
+      )
+  {
     return FALSE;
   }
 
-  DEBUG ((DEBUG_INFO, " Valid efi partition table header\n"));
-  FreePool (PartHdr);
-  return TRUE;
+  Requests[0].Offset     = MultU64x32 (PrimaryBlock->PartitionEntryLBA, BlockSize);
+  Requests[0].BufferSize = PrimaryBlock->NumberOfPartitionEntries * PrimaryBlock->SizeOfPartitionEntry;
+  Requests[0].Buffer     = AllocatePool (Requests[0].BufferSize);
+  Requests[1].Offset     = MultU64x32 (BackupBlock->PartitionEntryLBA, BlockSize);
+  Requests[1].BufferSize = BackupBlock->NumberOfPartitionEntries * BackupBlock->SizeOfPartitionEntry;
+  Requests[1].Buffer     = AllocatePool (Requests[1].BufferSize);
+
+  Valid = FALSE;
+  if ((Requests[0].Buffer != NULL) && (Requests[1].Buffer != NULL)) {
+    PartitionReadGptRequests (DiskIo, DiskIo2, BlockIo->Media->MediaId, Requests, ARRAY_SIZE (Requests));
+    Valid = (BOOLEAN)(!EFI_ERROR (Requests[0].Token.TransactionStatus) &&
+                      !EFI_ERROR (Requests[1].Token.TransactionStatus) &&
+                      PartitionCheckGptEntryArrayBufferCrc (PrimaryBlock, Requests[0].Buffer) &&
+                      PartitionCheckGptEntryArrayBufferCrc (BackupBlock, Requests[1].Buffer));
+  }
+
+  if (Valid) {
+    CopyMem (PrimaryHeader, PrimaryBlock, sizeof (EFI_PARTITION_TABLE_HEADER));
+    CopyMem (BackupHeader, BackupBlock, sizeof (EFI_PARTITION_TABLE_HEADER));
+    *PartEntry         = Requests[0].Buffer;
+    Requests[0].Buffer = NULL;
+  }
+
+  if (Requests[0].Buffer != NULL) {
+    FreePool (Requests[0].Buffer);
+  }
+
+  if (Requests[1].Buffer != NULL) {
+    FreePool (Requests[1].Buffer);
+  }
+
+  return Valid;
+}
+
+/**
+  Read several regions of the disk.
+
+  With DiskIo2 all requests are submitted before waiting on any of them,
+  so the device can service them together. Without it, or if a request
+  cannot be submitted, the regions are read one after the other.
+
+  @param[in]      DiskIo    Disk Io protocol.
+  @param[in]      DiskIo2   Disk Io2 protocol, may be NULL.
+  @param[in]      MediaId   Id of the media.
+  @param[in, out] Requests  The read requests. The result of each read is
+                            returned in its Token.TransactionStatus.
+  @param[in]      Count     Number of requests.
+
+**/
+VOID
+PartitionReadGptRequests (
+  IN     EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN     EFI_DISK_IO2_PROTOCOL  *DiskIo2,
+  IN     UINT32                 MediaId,
+  IN OUT GPT_READ_REQUEST       *Requests,
+  IN     UINTN                  Count
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Requests[Index].Token.Event             = NULL;
+    Requests[Index].Token.TransactionStatus = EFI_SUCCESS;
+
+    if (DiskIo2 != NULL) {
+      Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Requests[Index].Token.Event);
+      if (!EFI_ERROR (Status)) {
+        Status = DiskIo2->ReadDiskEx (
+                            DiskIo2,
+                            MediaId,
+                            Requests[Index].Offset,
+                            &Requests[Index].Token,
+                            Requests[Index].BufferSize,
+                            Requests[Index].Buffer
+                            );
+        if (!EFI_ERROR (Status)) {
+          continue;
+        }
+
+        gBS->CloseEvent (Requests[Index].Token.Event);
+      }
+
+      Requests[Index].Token.Event = NULL;
+    }
+
+    Requests[Index].Token.TransactionStatus = DiskIo->ReadDisk (
+                                                        DiskIo,
+                                                        MediaId,
+                                                        Requests[Index].Offset,
+                                                        Requests[Index].BufferSize,
+                                                        Requests[Index].Buffer
+                                                        );
+  }
+
+  //
+  // The lower layers signal completion at TPL_NOTIFY, above the TPL_CALLBACK
+  // the driver binding Start() runs at, so polling here makes progress.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    if (Requests[Index].Token.Event == NULL) {
+      continue;
+    }
+
+    while (gBS->CheckEvent (Requests[Index].Token.Event) == EFI_NOT_READY) {
+      CpuPause ();
+    }
+
+    gBS->CloseEvent (Requests[Index].Token.Event);
+    Requests[Index].Token.Event = NULL;
+  }
 }
 
 /**
@@ -537,6 +877,8 @@ PartitionValidGptTable (
   @param[in]  BlockIo     Parent BlockIo interface
   @param[in]  DiskIo      Disk Io Protocol.
   @param[in]  PartHeader  Partition table header structure
+  @param[out] PartEntry   Optional. Returns the partition entry array if
+                          the CRC is valid, to be freed by the caller.
 
   @retval TRUE      the CRC is valid
   @retval FALSE     the CRC is invalid
@@ -546,13 +888,12 @@ BOOLEAN
 PartitionCheckGptEntryArrayCRC (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
-  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
+  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  OUT EFI_PARTITION_ENTRY         **PartEntry OPTIONAL
   )
 {
   EFI_STATUS  Status;
   UINT8       *Ptr;
-  UINT32      Crc;
-  UINTN       Size;
 
   //
   // Read the EFI Partition Entries
@@ -575,17 +916,49 @@ PartitionCheckGptEntryArrayCRC (
     return FALSE;
   }
 
+  if (!PartitionCheckGptEntryArrayBufferCrc (PartHeader, (EFI_PARTITION_ENTRY *)Ptr)) {
+    FreePool (Ptr);
+    return FALSE;
+  }
+
+  if (PartEntry != NULL) {
+    *PartEntry = (EFI_PARTITION_ENTRY *)Ptr;
+  } else {
+    FreePool (Ptr);
+  }
+
+  return TRUE;
+}
+
+/**
+  Check if the CRC field in the Partition table header is valid
+  for a Partition entry array already in memory.
+
+  @param[in]  PartHeader  Partition table header structure
+  @param[in]  PartEntry   The partition entry array
+
+  @retval TRUE      the CRC is valid
+  @retval FALSE     the CRC is invalid
+
+**/
+BOOLEAN
+PartitionCheckGptEntryArrayBufferCrc (
+  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  IN  EFI_PARTITION_ENTRY         *PartEntry
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Crc;
+  UINTN       Size;
+
   Size = PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry;
 
-  Status = gBS->CalculateCrc32 (Ptr, Size, &Crc);
+  Status = gBS->CalculateCrc32 (PartEntry, Size, &Crc);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "CheckPEntryArrayCRC: Crc calculation failed\n"));
-    FreePool (Ptr);
     return FALSE;
   }
 
-  FreePool (Ptr);
-
   return (BOOLEAN)(PartHeader->PartitionEntryArrayCRC32 == Crc);
 }
 
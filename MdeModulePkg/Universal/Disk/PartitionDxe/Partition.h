@@ -30,6 +30,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/DevicePathLib.h>
+#include <Library/PerformanceLib.h>
 
 #include <IndustryStandard/Mbr.h>
 #include <IndustryStandard/ElTorito.h>
@@ -102,6 +103,17 @@ typedef struct {
   BOOLEAN    OsSpecific;
 } EFI_PARTITION_ENTRY_STATUS;
 
+//
+// GPT read request. Several requests are submitted together through DiskIo2
+// so the device can service them concurrently.
+//
+typedef struct {
+  UINT64                Offset;
+  UINTN                 BufferSize;
+  VOID                  *Buffer;
+  EFI_DISK_IO2_TOKEN    Token;
+} GPT_READ_REQUEST;
+
 //
 // Function Prototypes
 //
@@ -72,8 +72,11 @@ UdfOpenVolume (
   if (PrivFsData->OpenFiles == 0) {
     //
     // There is no more open files. Read volume information again since it was
-    // cleaned up on the last UdfClose() call.
+    // cleaned up on the last UdfClose() call, and drop the directories cached
+    // from the previous volume information.
     //
+    PurgeDirectoryCache (&PrivFsData->Volume);
+
     Status = ReadUdfVolumeInformation (
                PrivFsData->BlockIo,
                PrivFsData->DiskIo,
@@ -251,17 +254,23 @@ UdfOpen (
 
   StrCpyS (NewPrivFileData->FileName, UDF_FILENAME_LENGTH, FileName);
 
-  Status = GetFileSize (
+  //
+  // Map the extents of the file once, for the reads not to walk its
+  // Allocation Descriptors again. This replaces the map copied from the
+  // parent above.
+  //
+  Status = GetFileExtentMap (
              PrivFsData->BlockIo,
              PrivFsData->DiskIo,
              &PrivFsData->Volume,
              &NewPrivFileData->File,
+             &NewPrivFileData->ExtentMap,
              &NewPrivFileData->FileSize
              );
   if (EFI_ERROR (Status)) {
     DEBUG ((
       DEBUG_ERROR,
-      "%a: GetFileSize() fails with status - %r.\n",
+      "%a: GetFileExtentMap() fails with status - %r.\n",
       __func__,
       Status
       ));
@@ -382,6 +391,7 @@ UdfRead (
                DiskIo,
                Volume,
                Parent,
+               &PrivFileData->ExtentMap,
                PrivFileData->FileSize,
                &PrivFileData->FilePosition,
                Buffer,
@@ -570,6 +580,10 @@ UdfClose (
     if (PrivFileData->ReadDirInfo.DirectoryData != NULL) {
       FreePool (PrivFileData->ReadDirInfo.DirectoryData);
     }
+
+    if (PrivFileData->ExtentMap.Extents != NULL) {
+      FreePool (PrivFileData->ExtentMap.Extents);
+    }
   }
 
   FreePool ((VOID *)PrivFileData);
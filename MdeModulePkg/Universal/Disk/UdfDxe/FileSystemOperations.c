@@ -1053,6 +1053,69 @@ GrowUpBufferToNextAd (
   return EFI_SUCCESS;
 }
 
+/**
+  Append an extent of recorded file data to an extent map, merging it into the
+  last extent of the map if both are physically contiguous.
+
+  @param[in, out] ExtentMap       Extent map of the file.
+  @param[in]      FileOffset      Offset of the extent in the file.
+  @param[in]      DiskOffset      Offset of the extent on the disk.
+  @param[in]      Length          Length of the extent.
+
+  @retval EFI_SUCCESS             The extent was added to the map.
+  @retval EFI_OUT_OF_RESOURCES    The map could not be grown.
+
+**/
+EFI_STATUS
+AddExtentToMap (
+  IN OUT  UDF_EXTENT_MAP  *ExtentMap,
+  IN      UINT64          FileOffset,
+  IN      UINT64          DiskOffset,
+  IN      UINT32          Length
+  )
+{
+  UDF_EXTENT  *Extent;
+  UDF_EXTENT  *Extents;
+  UINTN       MaxCount;
+
+  if (Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (ExtentMap->Count > 0) {
+    Extent = &ExtentMap->Extents[ExtentMap->Count - 1];
+    if (Extent->DiskOffset + Extent->Length == DiskOffset) {
+      Extent->Length += Length;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (ExtentMap->Count == ExtentMap->MaxCount) {
+    MaxCount = (ExtentMap->MaxCount == 0) ?
+               UDF_EXTENT_MAP_INITIAL_COUNT :
+               ExtentMap->MaxCount * 2;
+    Extents = ReallocatePool (
+                ExtentMap->MaxCount * sizeof (UDF_EXTENT),
+                MaxCount * sizeof (UDF_EXTENT),
+                ExtentMap->Extents
+                );
+    if (Extents == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    ExtentMap->Extents  = Extents;
+    ExtentMap->MaxCount = MaxCount;
+  }
+
+  Extent             = &ExtentMap->Extents[ExtentMap->Count];
+  Extent->FileOffset = FileOffset;
+  Extent->DiskOffset = DiskOffset;
+  Extent->Length     = Length;
+  ExtentMap->Count++;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Read data or size of either a File Entry or an Extended File Entry.
 
@@ -1116,9 +1179,10 @@ ReadFile (
   switch (ReadFileInfo->Flags) {
     case ReadFileGetFileSize:
     case ReadFileAllocateAndRead:
+    case ReadFileGetExtentMap:
       //
-      // Initialise ReadFileInfo structure for either getting file size, or
-      // reading file's recorded data.
+      // Initialise ReadFileInfo structure for either getting file size or
+      // extents, or reading file's recorded data.
       //
       ReadFileInfo->ReadLength = 0;
       ReadFileInfo->FileData   = NULL;
@@ -1157,7 +1221,12 @@ ReadFile (
         return Status;
       }
 
-      if (ReadFileInfo->Flags == ReadFileGetFileSize) {
+      if ((ReadFileInfo->Flags == ReadFileGetFileSize) ||
+          (ReadFileInfo->Flags == ReadFileGetExtentMap))
+      {
+        //
+        // Inline data has no extents; the extent map is left empty.
+        //
         ReadFileInfo->ReadLength = Length;
       } else if (ReadFileInfo->Flags == ReadFileAllocateAndRead) {
         //
@@ -1301,6 +1370,19 @@ ReadFile (
               goto Error_Read_Disk_Blk;
             }
 
+            ReadFileInfo->ReadLength += ExtentLength;
+            break;
+          case ReadFileGetExtentMap:
+            Status = AddExtentToMap (
+                       ReadFileInfo->ExtentMap,
+                       ReadFileInfo->ReadLength,
+                       MultU64x32 (Lsn, LogicalBlockSize),
+                       ExtentLength
+                       );
+            if (EFI_ERROR (Status)) {
+              goto Error_Alloc_Buffer_To_Next_Ad;
+            }
+
             ReadFileInfo->ReadLength += ExtentLength;
             break;
           case ReadFileSeekAndRead:
@@ -1403,7 +1485,7 @@ Done:
 
 Error_Read_Disk_Blk:
 Error_Alloc_Buffer_To_Next_Ad:
-  if (ReadFileInfo->Flags != ReadFileSeekAndRead) {
+  if (ReadFileInfo->Flags == ReadFileAllocateAndRead) {
     FreePool (ReadFileInfo->FileData);
   }
 
@@ -1415,6 +1497,167 @@ Error_Get_Aed:
   return Status;
 }
 
+/**
+  Drop a directory from the directory cache of a volume.
+
+  @param[in, out] Volume          Volume information pointer.
+  @param[in]      Entry           Directory cache entry.
+
+**/
+VOID
+RemoveDirectoryCacheEntry (
+  IN OUT  UDF_VOLUME_INFO            *Volume,
+  IN      UDF_DIRECTORY_CACHE_ENTRY  *Entry
+  )
+{
+  RemoveEntryList (&Entry->Link);
+  Volume->DirectoryCacheEntries--;
+  Volume->DirectoryCacheSize -= Entry->DirectoryLength;
+
+  if (Entry->DirectoryData != NULL) {
+    FreePool (Entry->DirectoryData);
+  }
+
+  FreePool (Entry);
+}
+
+/**
+  Get the recorded data (the File Identifier Descriptors) of a directory,
+  either from the directory cache of the volume, or from the disk, in which
+  case the data is added to the cache.
+
+  The returned data belongs to the cache. It remains valid until the next call
+  to GetDirectoryData() or PurgeDirectoryCache() for the volume.
+
+  @param[in]  BlockIo             BlockIo interface.
+  @param[in]  DiskIo              DiskIo interface.
+  @param[in]  Volume              Volume information pointer.
+  @param[in]  ParentIcb           ICB of the directory.
+  @param[in]  FileEntryData       FE/EFE of the directory.
+  @param[out] DirectoryData       Recorded data of the directory.
+  @param[out] DirectoryLength     Length of DirectoryData.
+
+  @retval EFI_SUCCESS             The directory data was returned.
+  @retval EFI_OUT_OF_RESOURCES    The directory data was not read due to lack
+                                  of resources.
+  @retval other                   The directory data was not read.
+
+**/
+EFI_STATUS
+GetDirectoryData (
+  IN   EFI_BLOCK_IO_PROTOCOL           *BlockIo,
+  IN   EFI_DISK_IO_PROTOCOL            *DiskIo,
+  IN   UDF_VOLUME_INFO                 *Volume,
+  IN   UDF_LONG_ALLOCATION_DESCRIPTOR  *ParentIcb,
+  IN   VOID                            *FileEntryData,
+  OUT  VOID                            **DirectoryData,
+  OUT  UINT64                          *DirectoryLength
+  )
+{
+  EFI_STATUS                 Status;
+  UINT64                     IcbLsn;
+  LIST_ENTRY                 *Link;
+  UDF_DIRECTORY_CACHE_ENTRY  *Entry;
+  UDF_READ_FILE_INFO         ReadFileInfo;
+
+  Status = GetLongAdLsn (Volume, ParentIcb, &IcbLsn);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Link = GetFirstNode (&Volume->DirectoryCache);
+       !IsNull (&Volume->DirectoryCache, Link);
+       Link = GetNextNode (&Volume->DirectoryCache, Link))
+  {
+    Entry = UDF_DIRECTORY_CACHE_ENTRY_FROM_LINK (Link);
+    if (Entry->IcbLsn == IcbLsn) {
+      //
+      // Move the directory to the head of the cache, as the most recently
+      // used one.
+      //
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&Volume->DirectoryCache, &Entry->Link);
+
+      *DirectoryData   = Entry->DirectoryData;
+      *DirectoryLength = Entry->DirectoryLength;
+      return EFI_SUCCESS;
+    }
+  }
+
+  ReadFileInfo.Flags = ReadFileAllocateAndRead;
+
+  Status = ReadFile (
+             BlockIo,
+             DiskIo,
+             Volume,
+             ParentIcb,
+             FileEntryData,
+             &ReadFileInfo
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Entry = AllocatePool (sizeof (UDF_DIRECTORY_CACHE_ENTRY));
+  if (Entry == NULL) {
+    if (ReadFileInfo.FileData != NULL) {
+      FreePool (ReadFileInfo.FileData);
+    }
+
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Entry->Signature       = UDF_DIRECTORY_CACHE_ENTRY_SIGNATURE;
+  Entry->IcbLsn          = IcbLsn;
+  Entry->DirectoryData   = ReadFileInfo.FileData;
+  Entry->DirectoryLength = ReadFileInfo.ReadLength;
+
+  InsertHeadList (&Volume->DirectoryCache, &Entry->Link);
+  Volume->DirectoryCacheEntries++;
+  Volume->DirectoryCacheSize += Entry->DirectoryLength;
+
+  //
+  // Drop the least recently used directories while the cache is over its
+  // limits, but keep the directory just read.
+  //
+  while ((Volume->DirectoryCacheEntries > 1) &&
+         ((Volume->DirectoryCacheEntries > UDF_DIRECTORY_CACHE_MAX_ENTRIES) ||
+          (Volume->DirectoryCacheSize > UDF_DIRECTORY_CACHE_MAX_SIZE)))
+  {
+    RemoveDirectoryCacheEntry (
+      Volume,
+      UDF_DIRECTORY_CACHE_ENTRY_FROM_LINK (
+        GetPreviousNode (&Volume->DirectoryCache, &Volume->DirectoryCache)
+        )
+      );
+  }
+
+  *DirectoryData   = Entry->DirectoryData;
+  *DirectoryLength = Entry->DirectoryLength;
+  return EFI_SUCCESS;
+}
+
+/**
+  Drop all the directories cached for a volume.
+
+  @param[in, out] Volume          Volume information pointer.
+
+**/
+VOID
+PurgeDirectoryCache (
+  IN OUT  UDF_VOLUME_INFO  *Volume
+  )
+{
+  while (!IsListEmpty (&Volume->DirectoryCache)) {
+    RemoveDirectoryCacheEntry (
+      Volume,
+      UDF_DIRECTORY_CACHE_ENTRY_FROM_LINK (
+        GetFirstNode (&Volume->DirectoryCache)
+        )
+      );
+  }
+}
+
 /**
   Find a file by its filename from a given Parent file.
 
@@ -1444,7 +1687,9 @@ InternalFindFile (
 {
   EFI_STATUS                      Status;
   UDF_FILE_IDENTIFIER_DESCRIPTOR  *FileIdentifierDesc;
-  UDF_READ_DIRECTORY_INFO         ReadDirInfo;
+  VOID                            *DirectoryData;
+  UINT64                          DirectoryLength;
+  UINT64                          FidOffset;
   BOOLEAN                         Found;
   CHAR16                          FoundFileName[UDF_FILENAME_LENGTH];
   VOID                            *CompareFileEntry;
@@ -1487,40 +1732,38 @@ InternalFindFile (
   }
 
   //
-  // Start directory listing.
+  // Get the directory's recorded data. It is usually found in the directory
+  // cache, as the directories of a path are looked up again and again when
+  // opening files.
   //
-  ZeroMem ((VOID *)&ReadDirInfo, sizeof (UDF_READ_DIRECTORY_INFO));
-  Found = FALSE;
+  Status = GetDirectoryData (
+             BlockIo,
+             DiskIo,
+             Volume,
+             (Parent->FileIdentifierDesc != NULL) ?
+             &Parent->FileIdentifierDesc->Icb :
+             Icb,
+             Parent->FileEntry,
+             &DirectoryData,
+             &DirectoryLength
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-  for ( ; ;) {
-    Status = ReadDirectoryEntry (
-               BlockIo,
-               DiskIo,
-               Volume,
-               (Parent->FileIdentifierDesc != NULL) ?
-               &Parent->FileIdentifierDesc->Icb :
-               Icb,
-               Parent->FileEntry,
-               &ReadDirInfo,
-               &FileIdentifierDesc
-               );
-    if (EFI_ERROR (Status)) {
-      if (Status == EFI_DEVICE_ERROR) {
-        Status = EFI_NOT_FOUND;
-      }
+  //
+  // Walk the FIDs in place, and only duplicate the one found.
+  //
+  Found     = FALSE;
+  FidOffset = 0;
 
-      break;
-    }
+  while (FidOffset < DirectoryLength) {
+    FileIdentifierDesc = GET_FID_FROM_ADS (DirectoryData, FidOffset);
+    FidOffset         += GetFidDescriptorLength (FileIdentifierDesc);
 
-    //
-    // After calling function ReadDirectoryEntry(), if 'FileIdentifierDesc' is
-    // NULL, then the 'Status' must be EFI_OUT_OF_RESOURCES. Hence, if the code
-    // reaches here, 'FileIdentifierDesc' must be not NULL.
-    //
-    // The ASSERT here is for addressing a false positive NULL pointer
-    // dereference issue raised from static analysis.
-    //
-    ASSERT (FileIdentifierDesc != NULL);
+    if (FileIdentifierDesc->FileCharacteristics & DELETED_FILE) {
+      continue;
+    }
 
     if (FileIdentifierDesc->FileCharacteristics & PARENT_FILE) {
       //
@@ -1535,7 +1778,7 @@ InternalFindFile (
     } else {
       Status = GetFileNameFromFid (FileIdentifierDesc, ARRAY_SIZE (FoundFileName), FoundFileName);
       if (EFI_ERROR (Status)) {
-        break;
+        return Status;
       }
 
       if (StrCmp (FileName, FoundFileName) == 0) {
@@ -1546,18 +1789,14 @@ InternalFindFile (
         break;
       }
     }
-
-    FreePool ((VOID *)FileIdentifierDesc);
-  }
-
-  if (ReadDirInfo.DirectoryData != NULL) {
-    //
-    // Free all allocated resources for the directory listing.
-    //
-    FreePool (ReadDirInfo.DirectoryData);
   }
 
   if (Found) {
+    DuplicateFid (FileIdentifierDesc, &FileIdentifierDesc);
+    if (FileIdentifierDesc == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
     Status = EFI_SUCCESS;
 
     File->FileIdentifierDesc = FileIdentifierDesc;
@@ -1596,6 +1835,8 @@ InternalFindFile (
         Status = EFI_NOT_FOUND;
       }
     }
+  } else {
+    Status = EFI_NOT_FOUND;
   }
 
   return Status;
@@ -1980,33 +2221,41 @@ ReadDirectoryEntry (
   )
 {
   EFI_STATUS                      Status;
-  UDF_READ_FILE_INFO              ReadFileInfo;
+  VOID                            *DirectoryData;
+  UINT64                          DirectoryLength;
   UDF_FILE_IDENTIFIER_DESCRIPTOR  *FileIdentifierDesc;
 
   if (ReadDirInfo->DirectoryData == NULL) {
     //
-    // The directory's recorded data has not been read yet. So let's cache it
-    // into memory and the next calls won't need to read it again.
+    // The directory's recorded data has not been read yet. So let's copy it
+    // from the directory cache and the next calls won't need to look it up
+    // again. The listing keeps its own copy, as the cache may drop the
+    // directory before the listing is over.
     //
-    ReadFileInfo.Flags = ReadFileAllocateAndRead;
-
-    Status = ReadFile (
+    Status = GetDirectoryData (
                BlockIo,
                DiskIo,
                Volume,
                ParentIcb,
                FileEntryData,
-               &ReadFileInfo
+               &DirectoryData,
+               &DirectoryLength
                );
     if (EFI_ERROR (Status)) {
       return Status;
     }
 
+    if (DirectoryLength > 0) {
+      ReadDirInfo->DirectoryData = AllocateCopyPool ((UINTN)DirectoryLength, DirectoryData);
+      if (ReadDirInfo->DirectoryData == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+
     //
     // Fill in ReadDirInfo structure with the read directory's data information.
     //
-    ReadDirInfo->DirectoryData   = ReadFileInfo.FileData;
-    ReadDirInfo->DirectoryLength = ReadFileInfo.ReadLength;
+    ReadDirInfo->DirectoryLength = DirectoryLength;
   }
 
   do {
@@ -2456,6 +2705,71 @@ GetFileSize (
   return EFI_SUCCESS;
 }
 
+/**
+  Build the extent map of a file on an UDF volume, and get its size.
+
+  The map is built once when the file is opened, so that reading the file does
+  not need to walk its Allocation Descriptors, nor read its Allocation Extent
+  Descriptors again. The map of a file recorded inline is left empty.
+
+  @param[in]   BlockIo    BlockIo interface.
+  @param[in]   DiskIo     DiskIo interface.
+  @param[in]   Volume     UDF volume information structure.
+  @param[in]   File       File information structure.
+  @param[out]  ExtentMap  Extent map of the file. The caller frees
+                          ExtentMap->Extents with FreePool() if it is not
+                          NULL.
+  @param[out]  Size       Size of the file.
+
+  @retval EFI_SUCCESS          Extent map built and file size set in Size.
+  @retval EFI_UNSUPPORTED      Extended Allocation Descriptors not supported.
+  @retval EFI_NO_MEDIA         The device has no media.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_OUT_OF_RESOURCES The extent map was not built due to lack of
+                               resources.
+
+**/
+EFI_STATUS
+GetFileExtentMap (
+  IN   EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN   EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN   UDF_VOLUME_INFO        *Volume,
+  IN   UDF_FILE_INFO          *File,
+  OUT  UDF_EXTENT_MAP         *ExtentMap,
+  OUT  UINT64                 *Size
+  )
+{
+  EFI_STATUS          Status;
+  UDF_READ_FILE_INFO  ReadFileInfo;
+
+  ZeroMem ((VOID *)ExtentMap, sizeof (UDF_EXTENT_MAP));
+
+  ReadFileInfo.Flags     = ReadFileGetExtentMap;
+  ReadFileInfo.ExtentMap = ExtentMap;
+
+  Status = ReadFile (
+             BlockIo,
+             DiskIo,
+             Volume,
+             &File->FileIdentifierDesc->Icb,
+             File->FileEntry,
+             &ReadFileInfo
+             );
+  if (EFI_ERROR (Status)) {
+    if (ExtentMap->Extents != NULL) {
+      FreePool (ExtentMap->Extents);
+    }
+
+    ZeroMem ((VOID *)ExtentMap, sizeof (UDF_EXTENT_MAP));
+    return Status;
+  }
+
+  *Size = ReadFileInfo.ReadLength;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Set information about a file on an UDF volume.
 
@@ -2848,13 +3162,165 @@ Out_Free:
   return Status;
 }
 
+/**
+  Find the extent of an extent map that holds a given file position.
+
+  @param[in]  ExtentMap     Extent map of the file. It must not be empty.
+  @param[in]  FilePosition  File position, below the size of the file.
+
+  @return The index of the extent holding FilePosition.
+
+**/
+UINTN
+FindExtentInMap (
+  IN  UDF_EXTENT_MAP  *ExtentMap,
+  IN  UINT64          FilePosition
+  )
+{
+  UDF_EXTENT  *Extents;
+  UINTN       Index;
+  UINTN       Low;
+  UINTN       High;
+  UINTN       Middle;
+
+  Extents = ExtentMap->Extents;
+
+  //
+  // Sequential reads continue in the extent the last read ended in, or in the
+  // next one.
+  //
+  for (Index = ExtentMap->LastIndex;
+       Index < MIN (ExtentMap->LastIndex + 2, ExtentMap->Count);
+       Index++)
+  {
+    if ((FilePosition >= Extents[Index].FileOffset) &&
+        (FilePosition - Extents[Index].FileOffset < Extents[Index].Length))
+    {
+      return Index;
+    }
+  }
+
+  //
+  // Otherwise, look for the last extent starting at or before FilePosition.
+  //
+  Low  = 0;
+  High = ExtentMap->Count;
+  while (High - Low > 1) {
+    Middle = Low + (High - Low) / 2;
+    if (Extents[Middle].FileOffset <= FilePosition) {
+      Low = Middle;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return Low;
+}
+
+/**
+  Seek a file and read its data into memory, using the extent map of the file.
+
+  @param[in]      BlockIo       BlockIo interface.
+  @param[in]      DiskIo        DiskIo interface.
+  @param[in, out] ExtentMap     Extent map of the file. It must not be empty.
+  @param[in]      FileSize      Size of the file.
+  @param[in, out] FilePosition  File position.
+  @param[in, out] Buffer        File data.
+  @param[in, out] BufferSize    Read size.
+
+  @retval EFI_SUCCESS          File seeked and read.
+  @retval EFI_NO_MEDIA         The device has no media.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The extent map does not cover the file.
+
+**/
+EFI_STATUS
+ReadFileDataFromExtentMap (
+  IN      EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN      EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN OUT  UDF_EXTENT_MAP         *ExtentMap,
+  IN      UINT64                 FileSize,
+  IN OUT  UINT64                 *FilePosition,
+  IN OUT  VOID                   *Buffer,
+  IN OUT  UINT64                 *BufferSize
+  )
+{
+  EFI_STATUS  Status;
+  UDF_EXTENT  *Extent;
+  UINTN       Index;
+  UINT64      Position;
+  UINT64      Offset;
+  UINT64      DataOffset;
+  UINT64      DataLength;
+  UINT64      BytesLeft;
+
+  if (*FilePosition >= FileSize) {
+    *BufferSize = 0;
+    return EFI_SUCCESS;
+  }
+
+  if (*BufferSize > FileSize - *FilePosition) {
+    //
+    // About to read beyond the EOF -- truncate it.
+    //
+    *BufferSize = FileSize - *FilePosition;
+  }
+
+  Position   = *FilePosition;
+  DataOffset = 0;
+  BytesLeft  = *BufferSize;
+  Index      = FindExtentInMap (ExtentMap, Position);
+
+  while (BytesLeft > 0) {
+    if (Index >= ExtentMap->Count) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Extent = &ExtentMap->Extents[Index];
+    Offset = Position - Extent->FileOffset;
+
+    //
+    // Make sure we don't read more data than really wanted.
+    //
+    DataLength = MIN (Extent->Length - Offset, BytesLeft);
+
+    Status = DiskIo->ReadDisk (
+                       DiskIo,
+                       BlockIo->Media->MediaId,
+                       Extent->DiskOffset + Offset,
+                       (UINTN)DataLength,
+                       (VOID *)((UINT8 *)Buffer + DataOffset)
+                       );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Position   += DataLength;
+    DataOffset += DataLength;
+    BytesLeft  -= DataLength;
+
+    if (Offset + DataLength == Extent->Length) {
+      Index++;
+    }
+  }
+
+  ExtentMap->LastIndex = MIN (Index, ExtentMap->Count - 1);
+  *FilePosition        = Position;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Seek a file and read its data into memory on an UDF volume.
 
+  The extent map of the file is used when it is not empty. Otherwise, the
+  Allocation Descriptors of the file are walked.
+
   @param[in]      BlockIo       BlockIo interface.
   @param[in]      DiskIo        DiskIo interface.
   @param[in]      Volume        UDF volume information structure.
   @param[in]      File          File information structure.
+  @param[in, out] ExtentMap     Extent map of the file, or NULL.
   @param[in]      FileSize      Size of the file.
   @param[in, out] FilePosition  File position.
   @param[in, out] Buffer        File data.
@@ -2875,6 +3341,7 @@ ReadFileData (
   IN      EFI_DISK_IO_PROTOCOL   *DiskIo,
   IN      UDF_VOLUME_INFO        *Volume,
   IN      UDF_FILE_INFO          *File,
+  IN OUT  UDF_EXTENT_MAP         *ExtentMap OPTIONAL,
   IN      UINT64                 FileSize,
   IN OUT  UINT64                 *FilePosition,
   IN OUT  VOID                   *Buffer,
@@ -2884,6 +3351,18 @@ ReadFileData (
   EFI_STATUS          Status;
   UDF_READ_FILE_INFO  ReadFileInfo;
 
+  if ((ExtentMap != NULL) && (ExtentMap->Count > 0)) {
+    return ReadFileDataFromExtentMap (
+             BlockIo,
+             DiskIo,
+             ExtentMap,
+             FileSize,
+             FilePosition,
+             Buffer,
+             BufferSize
+             );
+  }
+
   ReadFileInfo.Flags        = ReadFileSeekAndRead;
   ReadFileInfo.FilePosition = *FilePosition;
   ReadFileInfo.FileData     = Buffer;
@@ -175,6 +175,7 @@ UdfDriverBindingStart (
   PrivFsData->BlockIo   = BlockIo;
   PrivFsData->DiskIo    = DiskIo;
   PrivFsData->Handle    = ControllerHandle;
+  InitializeListHead (&PrivFsData->Volume.DirectoryCache);
 
   //
   // Set up SimpleFs protocol
@@ -273,6 +274,7 @@ UdfDriverBindingStop (
                     NULL
                     );
 
+    PurgeDirectoryCache (&PrivFsData->Volume);
     FreePool ((VOID *)PrivFsData);
   }
 
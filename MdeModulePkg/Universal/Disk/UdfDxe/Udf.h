@@ -133,8 +133,33 @@ typedef enum {
   ReadFileGetFileSize,
   ReadFileAllocateAndRead,
   ReadFileSeekAndRead,
+  ReadFileGetExtentMap,
 } UDF_READ_FILE_FLAGS;
 
+//
+// A run of recorded file data, FileOffset being the offset of its first byte
+// in the file, and DiskOffset the offset of its first byte on the disk.
+//
+typedef struct {
+  UINT64    FileOffset;
+  UINT64    DiskOffset;
+  UINT64    Length;
+} UDF_EXTENT;
+
+//
+// The recorded extents of a file, in file order. Physically contiguous
+// Allocation Descriptors are merged into a single extent. LastIndex is the
+// extent that the last read ended in, where a sequential read starts looking.
+//
+typedef struct {
+  UDF_EXTENT    *Extents;
+  UINTN         Count;
+  UINTN         MaxCount;
+  UINTN         LastIndex;
+} UDF_EXTENT_MAP;
+
+#define UDF_EXTENT_MAP_INITIAL_COUNT  16
+
 typedef struct {
   VOID                   *FileData;
   UDF_READ_FILE_FLAGS    Flags;
@@ -142,6 +167,7 @@ typedef struct {
   UINT64                 FilePosition;
   UINT64                 FileSize;
   UINT64                 ReadLength;
+  UDF_EXTENT_MAP         *ExtentMap;
 } UDF_READ_FILE_INFO;
 
 #pragma pack(1)
@@ -308,6 +334,35 @@ typedef struct {
 
 #pragma pack()
 
+//
+// Recorded data of a directory, cached across opens and keyed by the logical
+// sector number of the directory's ICB.
+//
+#define UDF_DIRECTORY_CACHE_ENTRY_SIGNATURE  SIGNATURE_32 ('U', 'd', 'f', 'd')
+
+#define UDF_DIRECTORY_CACHE_ENTRY_FROM_LINK(a) \
+  CR ( \
+      a, \
+      UDF_DIRECTORY_CACHE_ENTRY, \
+      Link, \
+      UDF_DIRECTORY_CACHE_ENTRY_SIGNATURE \
+      )
+
+typedef struct {
+  UINTN         Signature;
+  LIST_ENTRY    Link;
+  UINT64        IcbLsn;
+  VOID          *DirectoryData;
+  UINT64        DirectoryLength;
+} UDF_DIRECTORY_CACHE_ENTRY;
+
+//
+// Limits of the directory cache of a volume. The most recently used directory
+// is always kept, whatever its size.
+//
+#define UDF_DIRECTORY_CACHE_MAX_ENTRIES  64
+#define UDF_DIRECTORY_CACHE_MAX_SIZE     SIZE_2MB
+
 //
 // UDF filesystem driver's private data
 //
@@ -317,6 +372,9 @@ typedef struct {
   UDF_PARTITION_DESCRIPTOR         PartitionDesc;
   UDF_FILE_SET_DESCRIPTOR          FileSetDesc;
   UINTN                            FileEntrySize;
+  LIST_ENTRY                       DirectoryCache;
+  UINTN                            DirectoryCacheEntries;
+  UINT64                           DirectoryCacheSize;
 } UDF_VOLUME_INFO;
 
 typedef struct {
@@ -352,6 +410,7 @@ typedef struct {
   CHAR16                             FileName[UDF_FILENAME_LENGTH];
   UINT64                             FileSize;
   UINT64                             FilePosition;
+  UDF_EXTENT_MAP                     ExtentMap;
 } PRIVATE_UDF_FILE_DATA;
 
 #define PRIVATE_UDF_SIMPLE_FS_DATA_SIGNATURE  SIGNATURE_32 ('U', 'd', 'f', 's')
@@ -867,6 +926,52 @@ GetFileSize (
   OUT  UINT64                 *Size
   );
 
+/**
+  Build the extent map of a file on an UDF volume, and get its size.
+
+  The map is built once when the file is opened, so that reading the file does
+  not need to walk its Allocation Descriptors, nor read its Allocation Extent
+  Descriptors again. The map of a file recorded inline is left empty.
+
+  @param[in]   BlockIo    BlockIo interface.
+  @param[in]   DiskIo     DiskIo interface.
+  @param[in]   Volume     UDF volume information structure.
+  @param[in]   File       File information structure.
+  @param[out]  ExtentMap  Extent map of the file. The caller frees
+                          ExtentMap->Extents with FreePool() if it is not
+                          NULL.
+  @param[out]  Size       Size of the file.
+
+  @retval EFI_SUCCESS          Extent map built and file size set in Size.
+  @retval EFI_UNSUPPORTED      Extended Allocation Descriptors not supported.
+  @retval EFI_NO_MEDIA         The device has no media.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_OUT_OF_RESOURCES The extent map was not built due to lack of
+                               resources.
+
+**/
+EFI_STATUS
+GetFileExtentMap (
+  IN   EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN   EFI_DISK_IO_PROTOCOL   *DiskIo,
+  IN   UDF_VOLUME_INFO        *Volume,
+  IN   UDF_FILE_INFO          *File,
+  OUT  UDF_EXTENT_MAP         *ExtentMap,
+  OUT  UINT64                 *Size
+  );
+
+/**
+  Drop all the directories cached for a volume.
+
+  @param[in, out] Volume          Volume information pointer.
+
+**/
+VOID
+PurgeDirectoryCache (
+  IN OUT  UDF_VOLUME_INFO  *Volume
+  );
+
 /**
   Set information about a file on an UDF volume.
 
@@ -956,10 +1061,14 @@ GetVolumeSize (
 /**
   Seek a file and read its data into memory on an UDF volume.
 
+  The extent map of the file is used when it is not empty. Otherwise, the
+  Allocation Descriptors of the file are walked.
+
   @param[in]      BlockIo       BlockIo interface.
   @param[in]      DiskIo        DiskIo interface.
   @param[in]      Volume        UDF volume information structure.
   @param[in]      File          File information structure.
+  @param[in, out] ExtentMap     Extent map of the file, or NULL.
   @param[in]      FileSize      Size of the file.
   @param[in, out] FilePosition  File position.
   @param[in, out] Buffer        File data.
@@ -980,6 +1089,7 @@ ReadFileData (
   IN      EFI_DISK_IO_PROTOCOL   *DiskIo,
   IN      UDF_VOLUME_INFO        *Volume,
   IN      UDF_FILE_INFO          *File,
+  IN OUT  UDF_EXTENT_MAP         *ExtentMap OPTIONAL,
   IN      UINT64                 FileSize,
   IN OUT  UINT64                 *FilePosition,
   IN OUT  VOID                   *Buffer,
@@ -237,7 +237,14 @@ FtwWriteRecord (
     // Update blocks other than working block or boot block
     //
     NumberOfWriteBlocks = FTW_BLOCKS ((UINTN)(Record->Offset + Record->Length), BlockSize);
-    Status              = FlushSpareBlockToTargetBlock (FtwDevice, Fvb, Record->Lba, BlockSize, NumberOfWriteBlocks);
+    Status              = FlushSpareBlockToTargetBlock (
+                            FtwDevice,
+                            Fvb,
+                            Record->Lba,
+                            BlockSize,
+                            NumberOfWriteBlocks,
+                            FTW_SPARE_SLOT_FROM_RECORD (Record)
+                            );
   }
 
   if (EFI_ERROR (Status)) {
@@ -338,6 +345,9 @@ FtwWrite (
   UINTN                               NumberOfBlocks;
   UINTN                               NumberOfWriteBlocks;
   UINTN                               WriteLength;
+  UINTN                               SpareSlot;
+  UINTN                               NumberOfSpareBlocks;
+  EFI_LBA                             SpareLba;
 
   FtwDevice = FTW_CONTEXT_FROM_THIS (This);
 
@@ -437,9 +447,28 @@ FtwWrite (
     ASSERT ((BlockSize == FtwDevice->SpareBlockSize) && (NumberOfWriteBlocks == FtwDevice->NumberOfSpareBlock));
   }
 
+  //
+  // Back up a write that fits in one spare slot in the next slot, round robin.
+  // Working block and boot block updates always use the whole spare area.
+  //
+  SpareSlot           = 0;
+  NumberOfSpareBlocks = FtwDevice->NumberOfSpareBlock;
+  if ((FtwDevice->NumberOfSpareSlot > 1) &&
+      (Record->BootBlockUpdate != FTW_VALID_STATE) &&
+      !IsWorkingBlock (FtwDevice, Fvb, Lba) &&
+      (WriteLength <= FtwDevice->NumberOfSpareSlotBlock * FtwDevice->SpareBlockSize))
+  {
+    SpareSlot                = FtwDevice->NextSpareSlot;
+    FtwDevice->NextSpareSlot = (SpareSlot + 1) % FtwDevice->NumberOfSpareSlot;
+    NumberOfSpareBlocks      = FtwDevice->NumberOfSpareSlotBlock;
+  }
+
+  SpareLba = FtwDevice->FtwSpareLba + SpareSlot * FtwDevice->NumberOfSpareSlotBlock;
+
   //
   // Write the record to the work space.
   //
+  Record->SpareSlot      = FTW_SPARE_SLOT_TO_RECORD (SpareSlot);
   Record->Lba            = Lba;
   Record->Offset         = Offset;
   Record->Length         = Length;
@@ -500,37 +529,25 @@ FtwWrite (
   // Try to keep the content of spare block
   // Save spare block into a spare backup memory buffer (Sparebuffer)
   //
-  SpareBufferSize = FtwDevice->SpareAreaLength;
+  SpareBufferSize = NumberOfSpareBlocks * FtwDevice->SpareBlockSize;
   SpareBuffer     = AllocatePool (SpareBufferSize);
   if (SpareBuffer == NULL) {
     FreePool (MyBuffer);
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Ptr = SpareBuffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
-    MyLength = FtwDevice->SpareBlockSize;
-    Status   = FtwDevice->FtwBackupFvb->Read (
-                                          FtwDevice->FtwBackupFvb,
-                                          FtwDevice->FtwSpareLba + Index,
-                                          0,
-                                          &MyLength,
-                                          Ptr
-                                          );
-    if (EFI_ERROR (Status)) {
-      FreePool (MyBuffer);
-      FreePool (SpareBuffer);
-      return EFI_ABORTED;
-    }
-
-    Ptr += MyLength;
+  Status = FtwReadSpareSlot (FtwDevice, SpareSlot, NumberOfSpareBlocks, SpareBuffer);
+  if (EFI_ERROR (Status)) {
+    FreePool (MyBuffer);
+    FreePool (SpareBuffer);
+    return EFI_ABORTED;
   }
 
   //
   // Write the memory buffer to spare block
   // Do not assume Spare Block and Target Block have same block size
   //
-  Status = FtwEraseSpareBlock (FtwDevice);
+  Status = FtwPrepareSpareBlock (FtwDevice, SpareSlot, NumberOfSpareBlocks, SpareBuffer);
   if (EFI_ERROR (Status)) {
     FreePool (MyBuffer);
     FreePool (SpareBuffer);
@@ -547,7 +564,7 @@ FtwWrite (
 
     Status = FtwDevice->FtwBackupFvb->Write (
                                         FtwDevice->FtwBackupFvb,
-                                        FtwDevice->FtwSpareLba + Index,
+                                        SpareLba + Index,
                                         0,
                                         &MyLength,
                                         Ptr
@@ -598,30 +615,12 @@ FtwWrite (
   //
   // Restore spare backup buffer into spare block , if no failure happened during FtwWrite.
   //
-  Status = FtwEraseSpareBlock (FtwDevice);
+  Status = FtwRestoreSpareBlock (FtwDevice, SpareSlot, NumberOfSpareBlocks, SpareBuffer);
   if (EFI_ERROR (Status)) {
     FreePool (SpareBuffer);
     return EFI_ABORTED;
   }
 
-  Ptr = SpareBuffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
-    MyLength = FtwDevice->SpareBlockSize;
-    Status   = FtwDevice->FtwBackupFvb->Write (
-                                          FtwDevice->FtwBackupFvb,
-                                          FtwDevice->FtwSpareLba + Index,
-                                          0,
-                                          &MyLength,
-                                          Ptr
-                                          );
-    if (EFI_ERROR (Status)) {
-      FreePool (SpareBuffer);
-      return EFI_ABORTED;
-    }
-
-    Ptr += MyLength;
-  }
-
   //
   // All success.
   //
@@ -77,6 +77,11 @@ typedef struct {
   EFI_LBA                                    FtwWorkSpaceLbaInSpare;  // Start LBA of working space in spare block.
   UINTN                                      FtwWorkSpaceBaseInSpare; // Offset into the FtwWorkSpaceLbaInSpare block.
   UINT8                                      *FtwWorkSpace;           // Point to Work Space in memory buffer
+  UINTN                                      NumberOfSpareSlot;       // Number of slots the spare area is split into.
+  UINTN                                      NumberOfSpareSlotBlock;  // Number of spare blocks in each slot.
+  UINTN                                      NextSpareSlot;           // Slot that backs up the next write fitting in one slot.
+  UINT32                                     SpareSlotEraseCount[FTW_MAX_SPARE_SLOTS]; // Erase cycles issued per spare slot.
+  UINT64                                     SpareEraseSkipCount;     // Number of spare erases avoided on blank spare.
   //
   // Following a buffer of FtwWorkSpace[FTW_WORK_SPACE_SIZE],
   // Allocated with EFI_FTW_DEVICE.
@@ -294,6 +299,92 @@ FtwEraseSpareBlock (
   IN EFI_FTW_DEVICE  *FtwDevice
   );
 
+/**
+  Erase blocks of the spare area, starting at a spare slot, and account the
+  erase cycle to the slots it covers.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks to erase.
+
+  @retval EFI_SUCCESS     The spare blocks were erased.
+  @retval Others          Returned from EraseBlocks () of the spare FVB.
+
+**/
+EFI_STATUS
+FtwEraseSpareSlot (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINTN           SpareSlot,
+  IN UINTN           NumberOfBlocks
+  );
+
+/**
+  Prepare a range of the spare area to receive new content.
+
+  The range is erased, unless PcdFtwSkipBlankSpareErase is set and the range
+  already reads back as erased.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks in the range.
+  @param SpareBuffer      The current content of the range, as read into
+                          memory.
+
+  @retval EFI_SUCCESS     The range is erased.
+  @retval Others          Erasing the range failed.
+
+**/
+EFI_STATUS
+FtwPrepareSpareBlock (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINTN           SpareSlot,
+  IN UINTN           NumberOfBlocks,
+  IN UINT8           *SpareBuffer
+  );
+
+/**
+  Restore the saved content of a range of the spare area.
+
+  The range is erased, then the saved content is written back unless it was
+  blank, in which case the erase alone restores it.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks in the range.
+  @param SpareBuffer      The saved content of the range.
+
+  @retval EFI_SUCCESS     The range content was restored.
+  @retval EFI_ABORTED     Erasing or writing the range failed.
+
+**/
+EFI_STATUS
+FtwRestoreSpareBlock (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINTN           SpareSlot,
+  IN UINTN           NumberOfBlocks,
+  IN UINT8           *SpareBuffer
+  );
+
+/**
+  Read a range of the spare area, starting at a spare slot, into memory.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks to read.
+  @param Buffer           The buffer receiving NumberOfBlocks spare blocks.
+
+  @retval EFI_SUCCESS     The range was read.
+  @retval Others          Returned from Read () of the spare FVB.
+
+**/
+EFI_STATUS
+FtwReadSpareSlot (
+  IN  EFI_FTW_DEVICE  *FtwDevice,
+  IN  UINTN           SpareSlot,
+  IN  UINTN           NumberOfBlocks,
+  OUT UINT8           *Buffer
+  );
+
 /**
   Retrieve the proper FVB protocol interface by HANDLE.
 
@@ -357,6 +448,7 @@ IsBootBlock (
   @param Lba             Lba of the target block
   @param BlockSize       The size of the block
   @param NumberOfBlocks  The number of consecutive blocks starting with Lba
+  @param SpareSlot       The spare slot holding the content
 
   @retval  EFI_SUCCESS               Spare block content is copied to target block
   @retval  EFI_INVALID_PARAMETER     Input parameter error
@@ -370,7 +462,8 @@ FlushSpareBlockToTargetBlock (
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *FvBlock,
   EFI_LBA                             Lba,
   UINTN                               BlockSize,
-  UINTN                               NumberOfBlocks
+  UINTN                               NumberOfBlocks,
+  UINTN                               SpareSlot
   );
 
 /**
@@ -92,14 +92,193 @@ FtwEraseSpareBlock (
   IN EFI_FTW_DEVICE  *FtwDevice
   )
 {
+  return FtwEraseSpareSlot (FtwDevice, 0, FtwDevice->NumberOfSpareBlock);
+}
+
+/**
+  Erase blocks of the spare area, starting at a spare slot, and account the
+  erase cycle to the slots it covers.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks to erase.
+
+  @retval EFI_SUCCESS     The spare blocks were erased.
+  @retval Others          Returned from EraseBlocks () of the spare FVB.
+
+**/
+EFI_STATUS
+FtwEraseSpareSlot (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINTN           SpareSlot,
+  IN UINTN           NumberOfBlocks
+  )
+{
+  UINTN  Slot;
+  UINTN  LastSlot;
+
+  LastSlot = (SpareSlot * FtwDevice->NumberOfSpareSlotBlock + NumberOfBlocks - 1) / FtwDevice->NumberOfSpareSlotBlock;
+  for (Slot = SpareSlot; Slot <= LastSlot && Slot < FtwDevice->NumberOfSpareSlot; Slot++) {
+    FtwDevice->SpareSlotEraseCount[Slot]++;
+  }
+
   return FtwDevice->FtwBackupFvb->EraseBlocks (
                                     FtwDevice->FtwBackupFvb,
-                                    FtwDevice->FtwSpareLba,
-                                    FtwDevice->NumberOfSpareBlock,
+                                    FtwDevice->FtwSpareLba + SpareSlot * FtwDevice->NumberOfSpareSlotBlock,
+                                    NumberOfBlocks,
                                     EFI_LBA_LIST_TERMINATOR
                                     );
 }
 
+/**
+  Read a range of the spare area, starting at a spare slot, into memory.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks to read.
+  @param Buffer           The buffer receiving NumberOfBlocks spare blocks.
+
+  @retval EFI_SUCCESS     The range was read.
+  @retval Others          Returned from Read () of the spare FVB.
+
+**/
+EFI_STATUS
+FtwReadSpareSlot (
+  IN  EFI_FTW_DEVICE  *FtwDevice,
+  IN  UINTN           SpareSlot,
+  IN  UINTN           NumberOfBlocks,
+  OUT UINT8           *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  EFI_LBA     Lba;
+  UINTN       Length;
+  UINTN       Index;
+
+  Lba = FtwDevice->FtwSpareLba + SpareSlot * FtwDevice->NumberOfSpareSlotBlock;
+  for (Index = 0; Index < NumberOfBlocks; Index += 1) {
+    Length = FtwDevice->SpareBlockSize;
+    Status = FtwDevice->FtwBackupFvb->Read (
+                                        FtwDevice->FtwBackupFvb,
+                                        Lba + Index,
+                                        0,
+                                        &Length,
+                                        Buffer
+                                        );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Buffer += Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Prepare a range of the spare area to receive new content.
+
+  The range is erased, unless PcdFtwSkipBlankSpareErase is set and the range
+  already reads back as erased.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks in the range.
+  @param SpareBuffer      The current content of the range, as read into
+                          memory.
+
+  @retval EFI_SUCCESS     The range is erased.
+  @retval Others          Erasing the range failed.
+
+**/
+EFI_STATUS
+FtwPrepareSpareBlock (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINTN           SpareSlot,
+  IN UINTN           NumberOfBlocks,
+  IN UINT8           *SpareBuffer
+  )
+{
+  //
+  // A NOR erase that is interrupted by a power loss may read back as all 0xFF
+  // while the cells are not reliably erased, so only platforms whose flash
+  // cannot do that may skip the erase.
+  //
+  if (FeaturePcdGet (PcdFtwSkipBlankSpareErase) &&
+      IsErasedFlashBuffer (SpareBuffer, NumberOfBlocks * FtwDevice->SpareBlockSize))
+  {
+    FtwDevice->SpareEraseSkipCount++;
+    return EFI_SUCCESS;
+  }
+
+  return FtwEraseSpareSlot (FtwDevice, SpareSlot, NumberOfBlocks);
+}
+
+/**
+  Restore the saved content of a range of the spare area.
+
+  The range is erased, then the saved content is written back unless it was
+  blank, in which case the erase alone restores it.
+
+  @param FtwDevice        The private data of FTW driver
+  @param SpareSlot        The spare slot the range starts at.
+  @param NumberOfBlocks   The number of spare blocks in the range.
+  @param SpareBuffer      The saved content of the range.
+
+  @retval EFI_SUCCESS     The range content was restored.
+  @retval EFI_ABORTED     Erasing or writing the range failed.
+
+**/
+EFI_STATUS
+FtwRestoreSpareBlock (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINTN           SpareSlot,
+  IN UINTN           NumberOfBlocks,
+  IN UINT8           *SpareBuffer
+  )
+{
+  EFI_STATUS  Status;
+  EFI_LBA     Lba;
+  UINTN       Length;
+  UINTN       Index;
+  UINT8       *Ptr;
+
+  Status = FtwEraseSpareSlot (FtwDevice, SpareSlot, NumberOfBlocks);
+  if (EFI_ERROR (Status)) {
+    return EFI_ABORTED;
+  }
+
+  if (!IsErasedFlashBuffer (SpareBuffer, NumberOfBlocks * FtwDevice->SpareBlockSize)) {
+    Lba = FtwDevice->FtwSpareLba + SpareSlot * FtwDevice->NumberOfSpareSlotBlock;
+    Ptr = SpareBuffer;
+    for (Index = 0; Index < NumberOfBlocks; Index += 1) {
+      Length = FtwDevice->SpareBlockSize;
+      Status = FtwDevice->FtwBackupFvb->Write (
+                                          FtwDevice->FtwBackupFvb,
+                                          Lba + Index,
+                                          0,
+                                          &Length,
+                                          Ptr
+                                          );
+      if (EFI_ERROR (Status)) {
+        return EFI_ABORTED;
+      }
+
+      Ptr += Length;
+    }
+  }
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "Ftw: spare slot %d erase count - %d, erases skipped - %ld\n",
+    SpareSlot,
+    FtwDevice->SpareSlotEraseCount[SpareSlot],
+    FtwDevice->SpareEraseSkipCount
+    ));
+
+  return EFI_SUCCESS;
+}
+
 /**
 
   Is it in working block?
@@ -467,6 +646,7 @@ FlushSpareBlockToBootBlock (
   @param Lba             Lba of the target block
   @param BlockSize       The size of the block
   @param NumberOfBlocks  The number of consecutive blocks starting with Lba
+  @param SpareSlot       The spare slot holding the content
 
   @retval  EFI_SUCCESS               Spare block content is copied to target block
   @retval  EFI_INVALID_PARAMETER     Input parameter error
@@ -480,7 +660,8 @@ FlushSpareBlockToTargetBlock (
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *FvBlock,
   EFI_LBA                             Lba,
   UINTN                               BlockSize,
-  UINTN                               NumberOfBlocks
+  UINTN                               NumberOfBlocks,
+  UINTN                               SpareSlot
   )
 {
   EFI_STATUS  Status;
@@ -489,39 +670,42 @@ FlushSpareBlockToTargetBlock (
   UINTN       Count;
   UINT8       *Ptr;
   UINTN       Index;
+  UINTN       NumberOfSpareBlocks;
 
   if ((FtwDevice == NULL) || (FvBlock == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The record may name a slot that does not exist if the number of slots
+  // changed while the write was pending. Its backup cannot be located then.
+  //
+  if (SpareSlot >= FtwDevice->NumberOfSpareSlot) {
+    DEBUG ((DEBUG_ERROR, "Ftw: Spare slot %d of pending write does not exist\n", SpareSlot));
+    return EFI_ABORTED;
+  }
+
   //
   // Allocate a memory buffer
   //
-  Length = FtwDevice->SpareAreaLength;
+  NumberOfSpareBlocks = FtwDevice->NumberOfSpareBlock - SpareSlot * FtwDevice->NumberOfSpareSlotBlock;
+  Length              = NumberOfSpareBlocks * FtwDevice->SpareBlockSize;
+  if (NumberOfBlocks * BlockSize > Length) {
+    return EFI_ABORTED;
+  }
+
   Buffer = AllocatePool (Length);
   if (Buffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
   //
-  // Read all content of spare block to memory buffer
+  // Read content of spare block from the slot on to memory buffer
   //
-  Ptr = Buffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
-    Count  = FtwDevice->SpareBlockSize;
-    Status = FtwDevice->FtwBackupFvb->Read (
-                                        FtwDevice->FtwBackupFvb,
-                                        FtwDevice->FtwSpareLba + Index,
-                                        0,
-                                        &Count,
-                                        Ptr
-                                        );
-    if (EFI_ERROR (Status)) {
-      FreePool (Buffer);
-      return Status;
-    }
-
-    Ptr += Count;
+  Status = FtwReadSpareSlot (FtwDevice, SpareSlot, NumberOfSpareBlocks, Buffer);
+  if (EFI_ERROR (Status)) {
+    FreePool (Buffer);
+    return Status;
   }
 
   //
@@ -1243,6 +1427,7 @@ InitFtwProtocol (
   UINTN                               Offset;
   EFI_HANDLE                          FvbHandle;
   EFI_LBA                             WorkSpaceLbaOffset;
+  UINTN                               SpareSlotCount;
 
   //
   // Find the right SMM Fvb protocol instance for FTW.
@@ -1252,6 +1437,23 @@ InitFtwProtocol (
     return EFI_NOT_FOUND;
   }
 
+  //
+  // Split the spare area into slots for the writes that fit in one slot.
+  //
+  FtwDevice->NumberOfSpareSlot      = 1;
+  FtwDevice->NumberOfSpareSlotBlock = FtwDevice->NumberOfSpareBlock;
+  SpareSlotCount                    = PcdGet8 (PcdFtwSpareSlotCount);
+  if (SpareSlotCount > 1) {
+    if ((SpareSlotCount <= FTW_MAX_SPARE_SLOTS) && ((FtwDevice->NumberOfSpareBlock % SpareSlotCount) == 0)) {
+      FtwDevice->NumberOfSpareSlot      = SpareSlotCount;
+      FtwDevice->NumberOfSpareSlotBlock = FtwDevice->NumberOfSpareBlock / SpareSlotCount;
+    } else {
+      DEBUG ((DEBUG_ERROR, "Ftw: 0x%x spare blocks cannot be split into %d slots\n", FtwDevice->NumberOfSpareBlock, SpareSlotCount));
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "Ftw: NumberOfSpareSlot - 0x%x, NumberOfSpareSlotBlock - 0x%x\n", FtwDevice->NumberOfSpareSlot, FtwDevice->NumberOfSpareSlotBlock));
+
   //
   // Calculate the start LBA of working block.
   //
@@ -1429,6 +1631,13 @@ InitFtwProtocol (
     }
   }
 
+  //
+  // Start the round robin over the spare slots at the fill level of the work
+  // space, so that the slots also wear evenly when each boot writes little.
+  //
+  FtwDevice->NextSpareSlot = ((UINTN)((UINT8 *)FtwDevice->FtwLastWriteRecord - FtwDevice->FtwWorkSpace) /
+                              sizeof (EFI_FAULT_TOLERANT_WRITE_RECORD)) % FtwDevice->NumberOfSpareSlot;
+
   //
   // Hook the protocol API
   //
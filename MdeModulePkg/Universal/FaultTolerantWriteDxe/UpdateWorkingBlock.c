@@ -513,7 +513,7 @@ FtwReclaimWorkSpace (
   //
   // Write the memory buffer to spare block
   //
-  Status = FtwEraseSpareBlock (FtwDevice);
+  Status = FtwPrepareSpareBlock (FtwDevice, 0, FtwDevice->NumberOfSpareBlock, SpareBuffer);
   if (EFI_ERROR (Status)) {
     FreePool (TempBuffer);
     FreePool (SpareBuffer);
@@ -597,30 +597,12 @@ FtwReclaimWorkSpace (
   //
   // Restore spare backup buffer into spare block , if no failure happened during FtwWrite.
   //
-  Status = FtwEraseSpareBlock (FtwDevice);
+  Status = FtwRestoreSpareBlock (FtwDevice, 0, FtwDevice->NumberOfSpareBlock, SpareBuffer);
   if (EFI_ERROR (Status)) {
     FreePool (SpareBuffer);
     return EFI_ABORTED;
   }
 
-  Ptr = SpareBuffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
-    Length = FtwDevice->SpareBlockSize;
-    Status = FtwDevice->FtwBackupFvb->Write (
-                                        FtwDevice->FtwBackupFvb,
-                                        FtwDevice->FtwSpareLba + Index,
-                                        0,
-                                        &Length,
-                                        Ptr
-                                        );
-    if (EFI_ERROR (Status)) {
-      FreePool (SpareBuffer);
-      return EFI_ABORTED;
-    }
-
-    Ptr += Length;
-  }
-
   FreePool (SpareBuffer);
 
   DEBUG ((DEBUG_INFO, "Ftw: reclaim work space successfully\n"));
@@ -216,6 +216,8 @@ PeimFaultTolerantWriteInitialize (
   EFI_PHYSICAL_ADDRESS                     WorkSpaceInSpareArea;
   UINT64                                   Size;
   FAULT_TOLERANT_WRITE_LAST_WRITE_DATA     FtwLastWrite;
+  UINTN                                    SpareSlot;
+  UINTN                                    SpareSlotOffset;
 
   FtwWorkingBlockHeader = NULL;
   FtwLastWriteHeader    = NULL;
@@ -270,10 +272,22 @@ PeimFaultTolerantWriteInitialize (
         // It means the target buffer has been backed up in spare block, then target block has been erased,
         // but the target buffer has not been writen in target block from spare block, we need to build
         // FAULT_TOLERANT_WRITE_LAST_WRITE_DATA GUID hob to hold the FTW last write data.
+        // The backup is in the spare slot named by the record, see PcdFtwSpareSlotCount.
         //
+        SpareSlot       = FTW_SPARE_SLOT_FROM_RECORD (FtwLastWriteRecord);
+        SpareSlotOffset = 0;
+        if (SpareSlot != 0) {
+          if (SpareSlot >= PcdGet8 (PcdFtwSpareSlotCount)) {
+            DEBUG ((DEBUG_ERROR, "FtwPei: Spare slot %d of last write does not exist\n", SpareSlot));
+            goto End;
+          }
+
+          SpareSlotOffset = SpareSlot * (SpareAreaLength / PcdGet8 (PcdFtwSpareSlotCount));
+        }
+
         FtwLastWrite.TargetAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)((INT64)SpareAreaAddress + FtwLastWriteRecord->RelativeOffset);
-        FtwLastWrite.SpareAddress  = SpareAreaAddress;
-        FtwLastWrite.Length        = SpareAreaLength;
+        FtwLastWrite.SpareAddress  = SpareAreaAddress + SpareSlotOffset;
+        FtwLastWrite.Length        = SpareAreaLength - SpareSlotOffset;
         DEBUG ((
           DEBUG_INFO,
           "FtwPei last write data: TargetAddress - 0x%x SpareAddress - 0x%x Length - 0x%x\n",
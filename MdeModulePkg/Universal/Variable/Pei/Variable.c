@@ -1020,6 +1020,88 @@ FindVariable (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Get the data of a variable that is stored in compressed form.
+
+  @param  StoreInfo       Pointer to variable store info structure.
+  @param  Variable        Pointer to the variable in the variable store.
+  @param  VariableHeader  Pointer to the variable header.
+  @param  DataSize        On entry, points to the size in bytes of the Data buffer.
+                          On return, points to the size of the decompressed data.
+  @param  Data            Points to the buffer which will hold the returned variable value.
+
+  @retval EFI_SUCCESS           The variable data was decompressed successfully.
+  @retval EFI_BUFFER_TOO_SMALL  The DataSize is too small for the resulting data.
+  @retval EFI_INVALID_PARAMETER Data is NULL while DataSize is large enough.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to decompress the data.
+  @retval EFI_DEVICE_ERROR      The compressed variable data is corrupted.
+
+**/
+STATIC
+EFI_STATUS
+GetCompressedVariableData (
+  IN     VARIABLE_STORE_INFO  *StoreInfo,
+  IN     VARIABLE_HEADER      *Variable,
+  IN     VARIABLE_HEADER      *VariableHeader,
+  IN OUT UINTN                *DataSize,
+  OUT    VOID                 *Data OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       CompressedSize;
+  UINT8       *Compressed;
+  VOID        *Scratch;
+  UINT32      DestinationSize;
+  UINT32      ScratchSize;
+
+  //
+  // The variable may span the FTW spare area, so read it into one buffer.
+  //
+  CompressedSize = DataSizeOfVariable (VariableHeader, StoreInfo->AuthFlag);
+  Compressed     = AllocatePool (CompressedSize);
+  if (Compressed == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  GetVariableNameOrData (StoreInfo, GetVariableDataPtr (Variable, VariableHeader, StoreInfo->AuthFlag), CompressedSize, Compressed);
+
+  Status = UefiDecompressGetInfo (Compressed, (UINT32)CompressedSize, &DestinationSize, &ScratchSize);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_DEVICE_ERROR;
+    goto Done;
+  }
+
+  if (*DataSize < DestinationSize) {
+    *DataSize = DestinationSize;
+    Status    = EFI_BUFFER_TOO_SMALL;
+    goto Done;
+  }
+
+  if (Data == NULL) {
+    Status = EFI_INVALID_PARAMETER;
+    goto Done;
+  }
+
+  Scratch = AllocatePool (ScratchSize);
+  if (Scratch == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Status = UefiDecompress (Compressed, Data, Scratch);
+  FreePool (Scratch);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_DEVICE_ERROR;
+    goto Done;
+  }
+
+  *DataSize = DestinationSize;
+
+Done:
+  FreePool (Compressed);
+  return Status;
+}
+
 /**
   This service retrieves a variable's value using its name and GUID.
 
@@ -1088,6 +1170,15 @@ PeiGetVariable (
     return EFI_DEVICE_ERROR;
   }
 
+  if ((VariableHeader->Reserved & VARIABLE_DATA_COMPRESSED) != 0) {
+    Status = GetCompressedVariableData (&StoreInfo, Variable.CurrPtr, VariableHeader, DataSize, Data);
+    if (((Status == EFI_SUCCESS) || (Status == EFI_BUFFER_TOO_SMALL)) && (Attributes != NULL)) {
+      *Attributes = VariableHeader->Attributes;
+    }
+
+    return Status;
+  }
+
   //
   // Get data size
   //
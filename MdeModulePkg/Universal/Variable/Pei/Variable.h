@@ -23,6 +23,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/VariableFlashInfoLib.h>
 #include <Library/MmUnblockMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/UefiDecompressLib.h>
 
 #include <Guid/VariableFormat.h>
 #include <Guid/VariableIndexTable.h>
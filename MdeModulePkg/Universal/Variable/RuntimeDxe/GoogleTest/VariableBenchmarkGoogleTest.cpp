@@ -0,0 +1,422 @@
+/** @file
+  Host-based performance benchmark of the variable driver.
+
+  The driver core runs on top of the in-memory flash provided by
+  VariableBenchmarkPlatform.c. Every configuration reports the average
+  latency of GetVariable (), SetVariable (), GetNextVariableName () and of the
+  SetVariable () calls that had to reclaim the store, together with the write
+  amplification seen by the flash.
+
+  The benchmark only reports numbers, so it is disabled in the host unit test
+  build. Run it with --gtest_also_run_disabled_tests.
+
+  The same platform also checks that the runtime variable cache stays in sync
+  with the stores across reclaims.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+extern "C" {
+  #include "../Variable.h"
+  #include "../VariableParsing.h"
+  #include "VariableBenchmarkPlatform.h"
+}
+
+using namespace testing;
+
+#define BENCHMARK_NAME_LENGTH     12
+#define BENCHMARK_MIN_ROUNDS      4
+#define BENCHMARK_NV_ATTRIBUTES   (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)
+
+STATIC EFI_GUID  mBenchmarkVendorGuid = {
+  0x4b8a4a4e, 0x5f0c, 0x4e39, { 0x9b, 0x1e, 0x6d, 0x2c, 0x59, 0x7a, 0x13, 0xd8 }
+};
+
+//
+// (FV size, variable count, variable data size)
+//
+typedef std::tuple<UINTN, UINTN, UINTN> BenchmarkParams;
+
+class VariableBenchmark : public TestWithParam<BenchmarkParams> {
+protected:
+  typedef std::chrono::steady_clock Clock;
+
+  UINTN FvSize;
+  UINTN Count;
+  UINTN DataSize;
+  UINTN Rounds;
+  std::vector<CHAR16> Names;
+  std::vector<UINT8> Data;
+
+  void
+  SetUp (
+    ) override
+  {
+    UINTN  EntrySize;
+
+    std::tie (FvSize, Count, DataSize) = GetParam ();
+
+    //
+    // Keep the live data within half of the store so that every update round
+    // can be absorbed by reclaim.
+    //
+    EntrySize = sizeof (AUTHENTICATED_VARIABLE_HEADER) + BENCHMARK_NAME_LENGTH * sizeof (CHAR16) + DataSize + HEADER_ALIGNMENT;
+    if (Count * EntrySize > FvSize / 2) {
+      GTEST_SKIP () << "Variable set does not fit in the store";
+    }
+
+    //
+    // Write at least twice the store size so that reclaim is exercised.
+    //
+    Rounds = MAX (BENCHMARK_MIN_ROUNDS, (2 * FvSize + Count * EntrySize - 1) / (Count * EntrySize));
+
+    ASSERT_EQ (VariableBenchmarkStart (FvSize), EFI_SUCCESS);
+
+    Names.resize (Count * BENCHMARK_NAME_LENGTH);
+    for (UINTN Index = 0; Index < Count; Index++) {
+      CHAR16  *Name;
+      UINTN   Digit;
+
+      Name = &Names[Index * BENCHMARK_NAME_LENGTH];
+      CopyMem (Name, L"Bench", 5 * sizeof (CHAR16));
+      for (Digit = 0; Digit < 6; Digit++) {
+        Name[5 + Digit] = (CHAR16)(L"0123456789ABCDEF"[(Index >> ((5 - Digit) * 4)) & 0xf]);
+      }
+
+      Name[BENCHMARK_NAME_LENGTH - 1] = L'\0';
+    }
+
+    Data.resize (DataSize);
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    VariableBenchmarkStop ();
+  }
+
+  CHAR16 *
+  Name (
+    UINTN  Index
+    )
+  {
+    return &Names[Index * BENCHMARK_NAME_LENGTH];
+  }
+
+  void
+  FillData (
+    UINTN  Index,
+    UINTN  Round
+    )
+  {
+    for (UINTN Offset = 0; Offset < DataSize; Offset++) {
+      Data[Offset] = (UINT8)(Index * 31 + Round * 7 + Offset);
+    }
+  }
+
+  static double
+  AverageNs (
+    Clock::duration  Total,
+    UINTN            Operations
+    )
+  {
+    if (Operations == 0) {
+      return 0.0;
+    }
+
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Total).count () / (double)Operations;
+  }
+
+  void
+  Report (
+    const char  *Metric,
+    double      Value
+    )
+  {
+    std::printf ("  %-24s %12.1f\n", Metric, Value);
+    RecordProperty (Metric, std::to_string (Value));
+  }
+};
+
+TEST_P (VariableBenchmark, DISABLED_Latency) {
+  VARIABLE_BENCHMARK_FLASH_STATS  Stats;
+  Clock::time_point               Start;
+  Clock::duration                 SetTime;
+  Clock::duration                 UpdateTime;
+  Clock::duration                 ReclaimTime;
+  Clock::duration                 GetTime;
+  Clock::duration                 GetNextTime;
+  UINTN                           Updates;
+  UINTN                           Reclaims;
+  UINTN                           Walked;
+  UINT64                          FtwWrites;
+  UINT64                          PayloadBytes;
+  UINT64                          FlashBytes;
+  EFI_STATUS                      Status;
+  UINT32                          Attributes;
+  UINTN                           Size;
+  UINTN                           NameSize;
+  CHAR16                          NameBuffer[BENCHMARK_NAME_LENGTH * 2];
+  EFI_GUID                        Guid;
+  std::vector<UINT8>              Buffer (DataSize);
+
+  PayloadBytes = 0;
+
+  //
+  // Create the variables.
+  //
+  SetTime = Clock::duration::zero ();
+  for (UINTN Index = 0; Index < Count; Index++) {
+    FillData (Index, 0);
+    Start    = Clock::now ();
+    Status   = VariableServiceSetVariable (Name (Index), &mBenchmarkVendorGuid, BENCHMARK_NV_ATTRIBUTES, DataSize, Data.data ());
+    SetTime += Clock::now () - Start;
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    PayloadBytes += BENCHMARK_NAME_LENGTH * sizeof (CHAR16) + DataSize;
+  }
+
+  //
+  // Read every variable back.
+  //
+  GetTime = Clock::duration::zero ();
+  for (UINTN Index = 0; Index < Count; Index++) {
+    Size     = DataSize;
+    Start    = Clock::now ();
+    Status   = VariableServiceGetVariable (Name (Index), &mBenchmarkVendorGuid, &Attributes, &Size, Buffer.data ());
+    GetTime += Clock::now () - Start;
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    ASSERT_EQ (Size, DataSize);
+  }
+
+  //
+  // Walk the whole variable list.
+  //
+  Walked        = 0;
+  NameBuffer[0] = L'\0';
+  GetNextTime   = Clock::duration::zero ();
+  for ( ; ;) {
+    NameSize     = sizeof (NameBuffer);
+    Start        = Clock::now ();
+    Status       = VariableServiceGetNextVariableName (&NameSize, NameBuffer, &Guid);
+    GetNextTime += Clock::now () - Start;
+    if (Status == EFI_NOT_FOUND) {
+      break;
+    }
+
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    Walked++;
+  }
+
+  EXPECT_GE (Walked, Count);
+
+  //
+  // Rewrite every variable several times so that the store fills up and has
+  // to be reclaimed.
+  //
+  Updates     = 0;
+  Reclaims    = 0;
+  UpdateTime  = Clock::duration::zero ();
+  ReclaimTime = Clock::duration::zero ();
+  for (UINTN Round = 1; Round <= Rounds; Round++) {
+    for (UINTN Index = 0; Index < Count; Index++) {
+      Clock::duration  Elapsed;
+
+      FillData (Index, Round);
+      VariableBenchmarkGetFlashStats (&Stats);
+      FtwWrites = Stats.FtwWrites;
+
+      Start   = Clock::now ();
+      Status  = VariableServiceSetVariable (Name (Index), &mBenchmarkVendorGuid, BENCHMARK_NV_ATTRIBUTES, DataSize, Data.data ());
+      Elapsed = Clock::now () - Start;
+      ASSERT_EQ (Status, EFI_SUCCESS);
+      PayloadBytes += BENCHMARK_NAME_LENGTH * sizeof (CHAR16) + DataSize;
+
+      VariableBenchmarkGetFlashStats (&Stats);
+      if (Stats.FtwWrites != FtwWrites) {
+        ReclaimTime += Elapsed;
+        Reclaims++;
+      } else {
+        UpdateTime += Elapsed;
+        Updates++;
+      }
+    }
+  }
+
+  //
+  // The data written last must survive the reclaims.
+  //
+  for (UINTN Index = 0; Index < Count; Index++) {
+    FillData (Index, Rounds);
+    Size   = DataSize;
+    Status = VariableServiceGetVariable (Name (Index), &mBenchmarkVendorGuid, &Attributes, &Size, Buffer.data ());
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    ASSERT_EQ (CompareMem (Buffer.data (), Data.data (), DataSize), 0);
+  }
+
+  VariableBenchmarkGetFlashStats (&Stats);
+  FlashBytes = Stats.FvbBytesWritten + Stats.FtwBytesWritten;
+
+  std::printf (
+    "Variable benchmark: FV 0x%llx, %llu variables, 0x%llx bytes of data\n",
+    (unsigned long long)FvSize,
+    (unsigned long long)Count,
+    (unsigned long long)DataSize
+    );
+  Report ("SetNewNs", AverageNs (SetTime, Count));
+  Report ("SetUpdateNs", AverageNs (UpdateTime, Updates));
+  Report ("SetReclaimNs", AverageNs (ReclaimTime, Reclaims));
+  Report ("GetNs", AverageNs (GetTime, Count));
+  Report ("GetNextNs", AverageNs (GetNextTime, Walked + 1));
+  Report ("Reclaims", (double)Reclaims);
+  Report ("BlocksErased", (double)(Stats.FvbBlocksErased + Stats.FtwBlocksErased));
+  Report ("WriteAmplification", (double)FlashBytes / (double)PayloadBytes);
+}
+
+INSTANTIATE_TEST_SUITE_P (
+  StoreSizes,
+  VariableBenchmark,
+  Combine (
+    Values ((UINTN)SIZE_64KB, (UINTN)SIZE_256KB, (UINTN)SIZE_1MB),
+    Values ((UINTN)32, (UINTN)128, (UINTN)512),
+    Values ((UINTN)16, (UINTN)256, (UINTN)2048)
+    )
+  );
+
+#define RUNTIME_CACHE_FV_SIZE        SIZE_64KB
+#define RUNTIME_CACHE_FILL_DATA_SIZE  0x400
+#define RUNTIME_CACHE_GARBAGE_SIZE    0x80
+#define RUNTIME_CACHE_MIN_REMAINING   0x200
+
+class VariableRuntimeCacheSync : public Test {
+protected:
+  void
+  SetUp (
+    ) override
+  {
+    ASSERT_EQ (VariableBenchmarkStart (RUNTIME_CACHE_FV_SIZE), EFI_SUCCESS);
+    ASSERT_EQ (VariableBenchmarkEnableRuntimeCache (), EFI_SUCCESS);
+  }
+
+  void
+  TearDown (
+    ) override
+  {
+    VariableBenchmarkStop ();
+  }
+
+  static UINTN
+  RemainingSpace (
+    )
+  {
+    return mVariableModuleGlobal->CommonVariableSpace - mVariableModuleGlobal->CommonVariableTotalSize;
+  }
+
+  static UINTN
+  VariableSize (
+    CONST CHAR16  *Name,
+    UINTN         DataSize
+    )
+  {
+    return HEADER_ALIGN (GetVariableHeaderSize (mVariableModuleGlobal->VariableGlobal.AuthFormat) + StrSize (Name) + DataSize);
+  }
+
+  //
+  // Leave one deleted variable as the only reclaimable space, fill the rest
+  // of the store and write one variable that needs a reclaim to fit but is
+  // larger than the space the reclaim frees, so the store grows.
+  //
+  void
+  ReclaimGrowingStore (
+    BOOLEAN  ReadLocked
+    )
+  {
+    VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+    VARIABLE_BENCHMARK_FLASH_STATS  Stats;
+    std::vector<UINT8>              Data (RUNTIME_CACHE_FILL_DATA_SIZE);
+    std::vector<UINT8>              Buffer;
+    CHAR16                          Name[BENCHMARK_NAME_LENGTH];
+    UINTN                           Index;
+    UINTN                           DataSize;
+    UINTN                           Size;
+    UINTN                           PreviousOffset;
+    UINT64                          FullUpdates;
+    UINT32                          Attributes;
+
+    CacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+
+    ASSERT_EQ (VariableServiceSetVariable ((CHAR16 *)L"Garbage", &mBenchmarkVendorGuid, BENCHMARK_NV_ATTRIBUTES, RUNTIME_CACHE_GARBAGE_SIZE, Data.data ()), EFI_SUCCESS);
+    ASSERT_EQ (VariableServiceSetVariable ((CHAR16 *)L"Garbage", &mBenchmarkVendorGuid, BENCHMARK_NV_ATTRIBUTES, 0, NULL), EFI_SUCCESS);
+
+    CopyMem (Name, L"Fill0000", 9 * sizeof (CHAR16));
+    for (Index = 0; RemainingSpace () >= VariableSize (Name, Data.size ()) + RUNTIME_CACHE_MIN_REMAINING; Index++) {
+      for (UINTN Digit = 0; Digit < 4; Digit++) {
+        Name[4 + Digit] = (CHAR16)(L"0123456789ABCDEF"[(Index >> ((3 - Digit) * 4)) & 0xf]);
+      }
+
+      Data.assign (Data.size (), (UINT8)Index);
+      ASSERT_EQ (VariableServiceSetVariable (Name, &mBenchmarkVendorGuid, BENCHMARK_NV_ATTRIBUTES, Data.size (), Data.data ()), EFI_SUCCESS);
+    }
+
+    EXPECT_TRUE (VariableBenchmarkRuntimeCacheInSync ());
+    EXPECT_EQ (CacheContext->FullUpdateCount, (UINT64)0);
+    EXPECT_EQ (CacheContext->DeltaUpdateCount, (UINT64)Index + 2);
+
+    //
+    // Size the new variable to the free space plus half of the deleted one:
+    // it only fits after a reclaim, and it is larger than what the reclaim
+    // frees.
+    //
+    DataSize = RemainingSpace () + VariableSize ((CHAR16 *)L"Garbage", RUNTIME_CACHE_GARBAGE_SIZE) / 2;
+    DataSize = (DataSize - GetVariableHeaderSize (mVariableModuleGlobal->VariableGlobal.AuthFormat) - StrSize ((CHAR16 *)L"Big")) & ~(UINTN)(HEADER_ALIGNMENT - 1);
+    ASSERT_GT (VariableSize ((CHAR16 *)L"Big", DataSize), RemainingSpace ());
+    ASSERT_GT (VariableSize ((CHAR16 *)L"Big", DataSize), VariableSize ((CHAR16 *)L"Garbage", RUNTIME_CACHE_GARBAGE_SIZE));
+    Data.assign (DataSize, 0x5a);
+
+    VariableBenchmarkResetFlashStats ();
+    PreviousOffset = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+    FullUpdates    = CacheContext->FullUpdateCount;
+
+    VariableBenchmarkLockRuntimeCache (ReadLocked);
+    ASSERT_EQ (VariableServiceSetVariable ((CHAR16 *)L"Big", &mBenchmarkVendorGuid, BENCHMARK_NV_ATTRIBUTES, DataSize, Data.data ()), EFI_SUCCESS);
+    if (ReadLocked) {
+      EXPECT_FALSE (VariableBenchmarkRuntimeCacheInSync ());
+      VariableBenchmarkLockRuntimeCache (FALSE);
+    }
+
+    VariableBenchmarkGetFlashStats (&Stats);
+    EXPECT_EQ (Stats.FtwWrites, (UINT64)1);
+    EXPECT_GT (mVariableModuleGlobal->NonVolatileLastVariableOffset, PreviousOffset);
+    EXPECT_EQ (CacheContext->FullUpdateCount, FullUpdates + 1);
+    EXPECT_TRUE (VariableBenchmarkRuntimeCacheInSync ());
+
+    Size = DataSize;
+    Buffer.resize (Size);
+    ASSERT_EQ (VariableServiceGetVariable ((CHAR16 *)L"Big", &mBenchmarkVendorGuid, &Attributes, &Size, Buffer.data ()), EFI_SUCCESS);
+    EXPECT_EQ (Buffer, Data);
+  }
+};
+
+TEST_F (VariableRuntimeCacheSync, ReclaimGrowingStore) {
+  ReclaimGrowingStore (FALSE);
+}
+
+TEST_F (VariableRuntimeCacheSync, ReclaimGrowingStoreUnderReadLock) {
+  ReclaimGrowingStore (TRUE);
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
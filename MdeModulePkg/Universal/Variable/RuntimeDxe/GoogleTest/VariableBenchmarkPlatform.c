@@ -0,0 +1,1147 @@
+/** @file
+  In-memory flash platform used to run the variable driver on the host for
+  performance benchmarking.
+
+  The variable FV lives in a host buffer and is exposed through an FVB
+  instance modeled on OvmfPkg/EmuVariableFvbRuntimeDxe. Reclaim goes through
+  a minimal FTW instance that models the spare block copy of the real driver,
+  so both the FVB and FTW traffic can be reported as write amplification.
+
+  This file also provides the privilege layer normally supplied by
+  VariableDxe.c, plus the few library services that the driver core needs and
+  that have no host instance.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../Variable.h"
+#include "../VariableParsing.h"
+#include "../VariableRuntimeCache.h"
+#include "VariableBenchmarkPlatform.h"
+
+#define BENCHMARK_FV_HEADER_LENGTH  (sizeof (EFI_FIRMWARE_VOLUME_HEADER) + sizeof (EFI_FV_BLOCK_MAP_ENTRY))
+
+STATIC UINT8                           *mBenchmarkFv;
+STATIC UINTN                           mBenchmarkFvSize;
+STATIC VARIABLE_BENCHMARK_FLASH_STATS  mBenchmarkStats;
+STATIC BOOLEAN                         mBenchmarkReadLock;
+STATIC BOOLEAN                         mBenchmarkPendingUpdate;
+STATIC BOOLEAN                         mBenchmarkHobFlushComplete;
+
+/**
+  Retrieves the Firmware Volume Block attributes.
+
+  @param[in]  This        Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[out] Attributes  Receives the attributes of the volume.
+
+  @retval EFI_SUCCESS     The attributes were returned.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbGetAttributes (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT      EFI_FVB_ATTRIBUTES_2                *Attributes
+  )
+{
+  *Attributes = (EFI_FVB_ATTRIBUTES_2)(EFI_FVB2_READ_ENABLED_CAP |
+                                       EFI_FVB2_READ_STATUS |
+                                       EFI_FVB2_WRITE_ENABLED_CAP |
+                                       EFI_FVB2_WRITE_STATUS |
+                                       EFI_FVB2_ERASE_POLARITY);
+  return EFI_SUCCESS;
+}
+
+/**
+  Sets the Firmware Volume Block attributes. Not supported.
+
+  @param[in]      This        Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[in, out] Attributes  The requested attributes.
+
+  @retval EFI_ACCESS_DENIED   The attributes cannot be changed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbSetAttributes (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN OUT   EFI_FVB_ATTRIBUTES_2                *Attributes
+  )
+{
+  return EFI_ACCESS_DENIED;
+}
+
+/**
+  Retrieves the base address of the firmware volume.
+
+  @param[in]  This      Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[out] Address   Receives the base address of the volume.
+
+  @retval EFI_SUCCESS   The base address was returned.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbGetPhysicalAddress (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT      EFI_PHYSICAL_ADDRESS                *Address
+  )
+{
+  *Address = (EFI_PHYSICAL_ADDRESS)(UINTN)mBenchmarkFv;
+  return EFI_SUCCESS;
+}
+
+/**
+  Retrieves the size of the requested block and the number of consecutive
+  blocks of that size starting at it.
+
+  @param[in]  This            Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[in]  Lba             The block to query.
+  @param[out] BlockSize       Receives the size of the block.
+  @param[out] NumberOfBlocks  Receives the number of blocks from Lba on.
+
+  @retval EFI_SUCCESS             The block size was returned.
+  @retval EFI_INVALID_PARAMETER   Lba is out of range.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbGetBlockSize (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN       EFI_LBA                             Lba,
+  OUT      UINTN                               *BlockSize,
+  OUT      UINTN                               *NumberOfBlocks
+  )
+{
+  UINTN  TotalBlocks;
+
+  TotalBlocks = mBenchmarkFvSize / VARIABLE_BENCHMARK_BLOCK_SIZE;
+  if (Lba >= TotalBlocks) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *BlockSize      = VARIABLE_BENCHMARK_BLOCK_SIZE;
+  *NumberOfBlocks = TotalBlocks - (UINTN)Lba;
+  return EFI_SUCCESS;
+}
+
+/**
+  Reads data from a block of the firmware volume.
+
+  @param[in]      This      Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[in]      Lba       The block to read from.
+  @param[in]      Offset    Offset into the block at which to begin reading.
+  @param[in, out] NumBytes  On input, the number of bytes to read. On output,
+                            the number of bytes read.
+  @param[out]     Buffer    Receives the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval EFI_BAD_BUFFER_SIZE   The read crossed a block boundary and was truncated.
+  @retval EFI_INVALID_PARAMETER Lba or Offset is out of range.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbRead (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN       EFI_LBA                             Lba,
+  IN       UINTN                               Offset,
+  IN OUT   UINTN                               *NumBytes,
+  OUT      UINT8                               *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((Lba >= mBenchmarkFvSize / VARIABLE_BENCHMARK_BLOCK_SIZE) || (Offset >= VARIABLE_BENCHMARK_BLOCK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = EFI_SUCCESS;
+  if (*NumBytes > VARIABLE_BENCHMARK_BLOCK_SIZE - Offset) {
+    *NumBytes = VARIABLE_BENCHMARK_BLOCK_SIZE - Offset;
+    Status    = EFI_BAD_BUFFER_SIZE;
+  }
+
+  CopyMem (Buffer, mBenchmarkFv + (UINTN)Lba * VARIABLE_BENCHMARK_BLOCK_SIZE + Offset, *NumBytes);
+  return Status;
+}
+
+/**
+  Writes data to a block of the firmware volume.
+
+  @param[in]      This      Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[in]      Lba       The block to write to.
+  @param[in]      Offset    Offset into the block at which to begin writing.
+  @param[in, out] NumBytes  On input, the number of bytes to write. On output,
+                            the number of bytes written.
+  @param[in]      Buffer    The data to write.
+
+  @retval EFI_SUCCESS           The data was written.
+  @retval EFI_BAD_BUFFER_SIZE   The write crossed a block boundary and was truncated.
+  @retval EFI_INVALID_PARAMETER Lba or Offset is out of range.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbWrite (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN       EFI_LBA                             Lba,
+  IN       UINTN                               Offset,
+  IN OUT   UINTN                               *NumBytes,
+  IN       UINT8                               *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((Lba >= mBenchmarkFvSize / VARIABLE_BENCHMARK_BLOCK_SIZE) || (Offset >= VARIABLE_BENCHMARK_BLOCK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = EFI_SUCCESS;
+  if (*NumBytes > VARIABLE_BENCHMARK_BLOCK_SIZE - Offset) {
+    *NumBytes = VARIABLE_BENCHMARK_BLOCK_SIZE - Offset;
+    Status    = EFI_BAD_BUFFER_SIZE;
+  }
+
+  CopyMem (mBenchmarkFv + (UINTN)Lba * VARIABLE_BENCHMARK_BLOCK_SIZE + Offset, Buffer, *NumBytes);
+  mBenchmarkStats.FvbBytesWritten += *NumBytes;
+  return Status;
+}
+
+/**
+  Erases one or more ranges of blocks of the firmware volume.
+
+  @param[in] This   Indicates the EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL instance.
+  @param[in] ...    Pairs of (EFI_LBA, UINTN) ranges, terminated by
+                    EFI_LBA_LIST_TERMINATOR.
+
+  @retval EFI_SUCCESS           The blocks were erased.
+  @retval EFI_INVALID_PARAMETER One of the ranges is out of range.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFvbEraseBlocks (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  ...
+  )
+{
+  VA_LIST  Args;
+  EFI_LBA  StartingLba;
+  UINTN    NumOfLba;
+  UINTN    TotalBlocks;
+
+  TotalBlocks = mBenchmarkFvSize / VARIABLE_BENCHMARK_BLOCK_SIZE;
+
+  VA_START (Args, This);
+  for ( ; ;) {
+    StartingLba = VA_ARG (Args, EFI_LBA);
+    if (StartingLba == EFI_LBA_LIST_TERMINATOR) {
+      break;
+    }
+
+    NumOfLba = VA_ARG (Args, UINTN);
+    if ((StartingLba > TotalBlocks) || (NumOfLba > TotalBlocks - StartingLba)) {
+      VA_END (Args);
+      return EFI_INVALID_PARAMETER;
+    }
+
+    SetMem (mBenchmarkFv + (UINTN)StartingLba * VARIABLE_BENCHMARK_BLOCK_SIZE, NumOfLba * VARIABLE_BENCHMARK_BLOCK_SIZE, 0xff);
+    mBenchmarkStats.FvbBlocksErased += NumOfLba;
+  }
+
+  VA_END (Args);
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  mBenchmarkFvb = {
+  BenchmarkFvbGetAttributes,
+  BenchmarkFvbSetAttributes,
+  BenchmarkFvbGetPhysicalAddress,
+  BenchmarkFvbGetBlockSize,
+  BenchmarkFvbRead,
+  BenchmarkFvbWrite,
+  BenchmarkFvbEraseBlocks,
+  NULL
+};
+
+/**
+  Get the size of the largest block that can be updated in a fault-tolerant
+  manner.
+
+  @param[in]  This        Indicates the EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+  @param[out] BlockSize   Receives the maximum block size.
+
+  @retval EFI_SUCCESS     The maximum block size was returned.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFtwGetMaxBlockSize (
+  IN  EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  OUT UINTN                              *BlockSize
+  )
+{
+  *BlockSize = mBenchmarkFvSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocates space for a write record. Not needed by the variable driver.
+
+  @param[in] This               Indicates the EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+  @param[in] CallerId           The GUID identifying the write.
+  @param[in] PrivateDataSize    The size of the caller's private data.
+  @param[in] NumberOfWrites     The number of fault tolerant block writes.
+
+  @retval EFI_UNSUPPORTED       Write records are not emulated.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFtwAllocate (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  IN EFI_GUID                           *CallerId,
+  IN UINTN                              PrivateDataSize,
+  IN UINTN                              NumberOfWrites
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Writes a range of the firmware volume in a fault-tolerant manner.
+
+  The real driver copies the affected blocks into the spare block, then
+  erases and rewrites the target blocks. Only the target is kept here, but
+  the spare traffic is accounted for so that the reported write amplification
+  matches the one of a real flash part.
+
+  @param[in] This           Indicates the EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+  @param[in] Lba            The first block to update.
+  @param[in] Offset         Offset into the block at which to begin writing.
+  @param[in] Length         The number of bytes to write.
+  @param[in] PrivateData    Caller private data. Ignored.
+  @param[in] FvBlockHandle  The handle of the FVB instance to update.
+  @param[in] Buffer         The data to write.
+
+  @retval EFI_SUCCESS           The data was written.
+  @retval EFI_INVALID_PARAMETER The range is outside of the firmware volume.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFtwWrite (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  IN EFI_LBA                            Lba,
+  IN UINTN                              Offset,
+  IN UINTN                              Length,
+  IN VOID                               *PrivateData,
+  IN EFI_HANDLE                         FvBlockHandle,
+  IN VOID                               *Buffer
+  )
+{
+  UINTN  Start;
+  UINTN  NumberOfBlocks;
+
+  Start = (UINTN)Lba * VARIABLE_BENCHMARK_BLOCK_SIZE + Offset;
+  if ((Start > mBenchmarkFvSize) || (Length > mBenchmarkFvSize - Start)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NumberOfBlocks = (Offset + Length + VARIABLE_BENCHMARK_BLOCK_SIZE - 1) / VARIABLE_BENCHMARK_BLOCK_SIZE;
+
+  //
+  // Spare block: erase and program the whole updated range of blocks.
+  // Target: erase the blocks, then program them back with the merged data.
+  //
+  CopyMem (mBenchmarkFv + Start, Buffer, Length);
+
+  mBenchmarkStats.FtwWrites++;
+  mBenchmarkStats.FtwBlocksErased += 2 * NumberOfBlocks;
+  mBenchmarkStats.FtwBytesWritten += 2 * NumberOfBlocks * VARIABLE_BENCHMARK_BLOCK_SIZE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Restarts a previously interrupted write. Not needed by the variable driver.
+
+  @param[in] This           Indicates the EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+  @param[in] FvBlockHandle  The handle of the FVB instance.
+
+  @retval EFI_UNSUPPORTED   Interrupted writes are not emulated.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFtwRestart (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  IN EFI_HANDLE                         FvBlockHandle
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Aborts all pending writes. Not needed by the variable driver.
+
+  @param[in] This   Indicates the EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+
+  @retval EFI_UNSUPPORTED   Write records are not emulated.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFtwAbort (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Gets the last incomplete write. Not needed by the variable driver.
+
+  @param[in]      This              Indicates the EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+  @param[out]     CallerId          The GUID identifying the last write.
+  @param[out]     Lba               The logical block of the last write.
+  @param[out]     Offset            The offset within the block of the last write.
+  @param[out]     Length            The number of bytes of the last write.
+  @param[in, out] PrivateDataSize   The size of the private data buffer.
+  @param[out]     PrivateData       The private data of the last write.
+  @param[out]     Complete          Whether the last write completed.
+
+  @retval EFI_NOT_FOUND   There is no incomplete write.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+BenchmarkFtwGetLastWrite (
+  IN     EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  OUT    EFI_GUID                           *CallerId,
+  OUT    EFI_LBA                            *Lba,
+  OUT    UINTN                              *Offset,
+  OUT    UINTN                              *Length,
+  IN OUT UINTN                              *PrivateDataSize,
+  OUT    VOID                               *PrivateData,
+  OUT    BOOLEAN                            *Complete
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+STATIC EFI_FAULT_TOLERANT_WRITE_PROTOCOL  mBenchmarkFtw = {
+  BenchmarkFtwGetMaxBlockSize,
+  BenchmarkFtwAllocate,
+  BenchmarkFtwWrite,
+  BenchmarkFtwRestart,
+  BenchmarkFtwAbort,
+  BenchmarkFtwGetLastWrite
+};
+
+//
+// Privilege layer services normally provided by VariableDxe.c.
+//
+
+/**
+  Return TRUE if ExitBootServices () has been called.
+
+  @retval FALSE   The benchmark always runs at boot time.
+
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+  Initializes a basic mutual exclusion lock.
+
+  @param  Lock       A pointer to the lock data structure to initialize.
+  @param  Priority   EFI TPL is associated with the lock.
+
+  @return The lock.
+
+**/
+EFI_LOCK *
+InitializeLock (
+  IN OUT EFI_LOCK  *Lock,
+  IN     EFI_TPL   Priority
+  )
+{
+  Lock->Tpl      = Priority;
+  Lock->OwnerTpl = TPL_APPLICATION;
+  Lock->Lock     = EfiLockReleased;
+  return Lock;
+}
+
+/**
+  Acquires lock only at boot time. The benchmark is single threaded.
+
+  @param  Lock         A pointer to the lock to acquire.
+
+**/
+VOID
+AcquireLockOnlyAtBootTime (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Releases lock only at boot time. The benchmark is single threaded.
+
+  @param  Lock         A pointer to the lock to release.
+
+**/
+VOID
+ReleaseLockOnlyAtBootTime (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Retrieve the Fault Tolerent Write protocol interface.
+
+  @param[out] FtwProtocol       The interface of Ftw protocol
+
+  @retval EFI_SUCCESS           The FTW protocol instance was returned in FtwProtocol.
+  @retval EFI_NOT_FOUND         The variable FV is not set up yet.
+
+**/
+EFI_STATUS
+GetFtwProtocol (
+  OUT VOID  **FtwProtocol
+  )
+{
+  //
+  // Like the DXE driver, only report FTW once the flash is usable so that the
+  // store is first loaded from flash rather than from an FTW backup.
+  //
+  if ((mVariableModuleGlobal == NULL) || (mVariableModuleGlobal->FvbInstance == NULL)) {
+    return EFI_NOT_FOUND;
+  }
+
+  *FtwProtocol = &mBenchmarkFtw;
+  return EFI_SUCCESS;
+}
+
+/**
+  Retrieve the FVB protocol interface by HANDLE.
+
+  @param[in]  FvBlockHandle     The handle of FVB protocol.
+  @param[out] FvBlock           The interface of FVB protocol
+
+  @retval EFI_SUCCESS           The interface was returned.
+  @retval EFI_UNSUPPORTED       The handle is not the benchmark FVB handle.
+
+**/
+EFI_STATUS
+GetFvbByHandle (
+  IN  EFI_HANDLE                          FvBlockHandle,
+  OUT EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  **FvBlock
+  )
+{
+  if (FvBlockHandle != (EFI_HANDLE)&mBenchmarkFvb) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *FvBlock = &mBenchmarkFvb;
+  return EFI_SUCCESS;
+}
+
+/**
+  Function returns an array of handles that support the FVB protocol
+  in a buffer allocated from pool.
+
+  @param[out]  NumberHandles    The number of handles returned in Buffer.
+  @param[out]  Buffer           The array of handles that support FVB protocol.
+
+  @retval EFI_SUCCESS           The handle of the benchmark FVB was returned.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough pool memory for the array.
+
+**/
+EFI_STATUS
+GetFvbCountAndBuffer (
+  OUT UINTN       *NumberHandles,
+  OUT EFI_HANDLE  **Buffer
+  )
+{
+  *Buffer = AllocatePool (sizeof (EFI_HANDLE));
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*Buffer)[0]   = (EFI_HANDLE)&mBenchmarkFvb;
+  *NumberHandles = 1;
+  return EFI_SUCCESS;
+}
+
+/**
+  Measure and log an EFI variable. Nothing is measured on the host.
+
+  @param[in]  VariableName  Name of the variable.
+  @param[in]  VendorGuid    Guid of the variable.
+
+**/
+VOID
+EFIAPI
+SecureBootHook (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid
+  )
+{
+}
+
+/**
+  Initialization for MOR Control Lock. Not emulated.
+
+  @retval EFI_SUCCESS     MorLock initialization success.
+
+**/
+EFI_STATUS
+MorLockInit (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  MOR/MorLock checker handler for the SetVariable(). Not emulated.
+
+  @param[in]  VariableName  The name of the variable.
+  @param[in]  VendorGuid    The vendor GUID of the variable.
+  @param[in]  Attributes    The attributes of the variable.
+  @param[in]  DataSize      The size of the variable data.
+  @param[in]  Data          The variable data.
+
+  @retval EFI_SUCCESS       The variable is not a MOR variable.
+
+**/
+EFI_STATUS
+SetVariableCheckHandlerMor (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid,
+  IN UINT32    Attributes,
+  IN UINTN     DataSize,
+  IN VOID      *Data
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Speculation barrier. Not needed on the host.
+
+**/
+VOID
+VariableSpeculationBarrier (
+  VOID
+  )
+{
+}
+
+//
+// Library services without a HOST_APPLICATION instance.
+//
+
+/**
+  Get the base address and size of the variable FV.
+
+  @param[out] BaseAddress   The base address of the variable FV.
+  @param[out] Length        The size in bytes of the variable FV.
+
+  @retval EFI_SUCCESS       The variable FV information was returned.
+  @retval EFI_NOT_FOUND     The variable FV is not set up.
+
+**/
+EFI_STATUS
+EFIAPI
+GetVariableFlashNvStorageInfo (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  if (mBenchmarkFv == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *BaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)mBenchmarkFv;
+  *Length      = mBenchmarkFvSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the first instance of a HOB with the given GUID. There are no HOBs.
+
+  @param  Guid      The GUID to match.
+
+  @return NULL.
+
+**/
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return NULL;
+}
+
+/**
+  Returns the next instance of a HOB with the given GUID. There are no HOBs.
+
+  @param  Guid      The GUID to match.
+  @param  HobStart  The HOB to start the search from.
+
+  @return NULL.
+
+**/
+VOID *
+EFIAPI
+GetNextGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *HobStart
+  )
+{
+  return NULL;
+}
+
+/**
+  Initialize the authenticated variable services. Not emulated.
+
+  @param[in]  AuthVarLibContextIn   Context passed in by the variable driver.
+  @param[out] AuthVarLibContextOut  Context passed out to the variable driver.
+
+  @retval EFI_UNSUPPORTED   The variable driver runs without auth support.
+
+**/
+EFI_STATUS
+EFIAPI
+AuthVariableLibInitialize (
+  IN  AUTH_VAR_LIB_CONTEXT_IN   *AuthVarLibContextIn,
+  OUT AUTH_VAR_LIB_CONTEXT_OUT  *AuthVarLibContextOut
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Process an authenticated variable. Not emulated.
+
+  @param[in] VariableName   Name of the variable.
+  @param[in] VendorGuid     Variable vendor GUID.
+  @param[in] Data           Data pointer.
+  @param[in] DataSize       Size of Data.
+  @param[in] Attributes     Attribute value of the variable.
+
+  @retval EFI_UNSUPPORTED   Authenticated variables are not supported.
+
+**/
+EFI_STATUS
+EFIAPI
+AuthVariableLibProcessVariable (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid,
+  IN VOID      *Data,
+  IN UINTN     DataSize,
+  IN UINT32    Attributes
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Register a SetVariable check handler. Not emulated.
+
+  @param[in] Handler    The check handler.
+
+  @retval EFI_SUCCESS   The handler was accepted.
+
+**/
+EFI_STATUS
+EFIAPI
+VarCheckLibRegisterSetVariableCheckHandler (
+  IN VAR_CHECK_SET_VARIABLE_CHECK_HANDLER  Handler
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Set a variable property. Not emulated.
+
+  @param[in] Name               The name of the variable.
+  @param[in] Guid               The vendor GUID of the variable.
+  @param[in] VariableProperty   The property of the variable.
+
+  @retval EFI_SUCCESS           The property was accepted.
+
+**/
+EFI_STATUS
+EFIAPI
+VarCheckLibVariablePropertySet (
+  IN CHAR16                       *Name,
+  IN EFI_GUID                     *Guid,
+  IN VAR_CHECK_VARIABLE_PROPERTY  *VariableProperty
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Get a variable property. No property is ever set.
+
+  @param[in]  Name              The name of the variable.
+  @param[in]  Guid              The vendor GUID of the variable.
+  @param[out] VariableProperty  The property of the variable.
+
+  @retval EFI_NOT_FOUND         The variable has no property.
+
+**/
+EFI_STATUS
+EFIAPI
+VarCheckLibVariablePropertyGet (
+  IN  CHAR16                       *Name,
+  IN  EFI_GUID                     *Guid,
+  OUT VAR_CHECK_VARIABLE_PROPERTY  *VariableProperty
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  SetVariable check. Every request is allowed.
+
+  @param[in] VariableName       The name of the variable.
+  @param[in] VendorGuid         The vendor GUID of the variable.
+  @param[in] Attributes         The attributes of the variable.
+  @param[in] DataSize           The size of the variable data.
+  @param[in] Data               The variable data.
+  @param[in] RequestSource      The source of the request.
+
+  @retval EFI_SUCCESS           The request is allowed.
+
+**/
+EFI_STATUS
+EFIAPI
+VarCheckLibSetVariableCheck (
+  IN CHAR16                    *VariableName,
+  IN EFI_GUID                  *VendorGuid,
+  IN UINT32                    Attributes,
+  IN UINTN                     DataSize,
+  IN VOID                      *Data,
+  IN VAR_CHECK_REQUEST_SOURCE  RequestSource
+  )
+{
+  return EFI_SUCCESS;
+}
+
+//
+// Benchmark control.
+//
+
+/**
+  Format the FV and variable store headers of the in-memory variable FV.
+
+  Modeled on InitializeFvAndVariableStoreHeaders () of
+  OvmfPkg/EmuVariableFvbRuntimeDxe.
+
+**/
+STATIC
+VOID
+BenchmarkFormatFv (
+  VOID
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  VARIABLE_STORE_HEADER       *VariableStore;
+
+  SetMem (mBenchmarkFv, mBenchmarkFvSize, 0xff);
+
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)mBenchmarkFv;
+  ZeroMem (FvHeader, BENCHMARK_FV_HEADER_LENGTH);
+  CopyGuid (&FvHeader->FileSystemGuid, &gEfiSystemNvDataFvGuid);
+  FvHeader->FvLength              = mBenchmarkFvSize;
+  FvHeader->Signature             = EFI_FVH_SIGNATURE;
+  FvHeader->Attributes            = EFI_FVB2_READ_ENABLED_CAP | EFI_FVB2_READ_STATUS |
+                                    EFI_FVB2_WRITE_ENABLED_CAP | EFI_FVB2_WRITE_STATUS |
+                                    EFI_FVB2_ERASE_POLARITY;
+  FvHeader->HeaderLength          = (UINT16)BENCHMARK_FV_HEADER_LENGTH;
+  FvHeader->Revision              = EFI_FVH_REVISION;
+  FvHeader->BlockMap[0].NumBlocks = (UINT32)(mBenchmarkFvSize / VARIABLE_BENCHMARK_BLOCK_SIZE);
+  FvHeader->BlockMap[0].Length    = VARIABLE_BENCHMARK_BLOCK_SIZE;
+  FvHeader->Checksum              = CalculateCheckSum16 ((UINT16 *)FvHeader, FvHeader->HeaderLength);
+
+  VariableStore = (VARIABLE_STORE_HEADER *)(mBenchmarkFv + BENCHMARK_FV_HEADER_LENGTH);
+  CopyGuid (&VariableStore->Signature, &gEfiAuthenticatedVariableGuid);
+  VariableStore->Size      = (UINT32)(mBenchmarkFvSize - BENCHMARK_FV_HEADER_LENGTH);
+  VariableStore->Format    = VARIABLE_STORE_FORMATTED;
+  VariableStore->State     = VARIABLE_STORE_HEALTHY;
+  VariableStore->Reserved  = 0;
+  VariableStore->Reserved1 = 0;
+}
+
+/**
+  Format an in-memory variable FV and start the variable driver on it.
+
+  @param[in] FvSize   Size in bytes of the emulated variable FV. It must be a
+                      multiple of VARIABLE_BENCHMARK_BLOCK_SIZE.
+
+  @retval EFI_SUCCESS             The variable services are ready for writes.
+  @retval EFI_INVALID_PARAMETER   FvSize is not a valid FV size.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory for the FV.
+  @retval Others                  The variable driver failed to initialize.
+
+**/
+EFI_STATUS
+VariableBenchmarkStart (
+  IN UINTN  FvSize
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
+
+  if ((FvSize == 0) || ((FvSize % VARIABLE_BENCHMARK_BLOCK_SIZE) != 0) || (FvSize > MAX_UINT32)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  mBenchmarkFv = AllocatePool (FvSize);
+  if (mBenchmarkFv == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mBenchmarkFvSize = FvSize;
+  BenchmarkFormatFv ();
+
+  Status = VariableCommonInitialize ();
+  if (EFI_ERROR (Status)) {
+    //
+    // VariableCommonInitialize () has released its own allocations.
+    //
+    mVariableModuleGlobal = NULL;
+    mNvFvHeaderCache      = NULL;
+    VariableBenchmarkStop ();
+    return Status;
+  }
+
+  //
+  // Follow FtwNotificationEvent () of VariableDxe.c: write directly to the
+  // flash once FTW and the FVB instance are available.
+  //
+  mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase = (EFI_PHYSICAL_ADDRESS)(UINTN)(mBenchmarkFv + mNvFvHeaderCache->HeaderLength);
+
+  Status = GetFvbInfoByAddress ((EFI_PHYSICAL_ADDRESS)(UINTN)mBenchmarkFv, NULL, &Fvb);
+  if (!EFI_ERROR (Status)) {
+    mVariableModuleGlobal->FvbInstance = Fvb;
+    Status                             = VariableWriteServiceInitialize ();
+  }
+
+  if (EFI_ERROR (Status)) {
+    VariableBenchmarkStop ();
+    return Status;
+  }
+
+  VariableBenchmarkResetFlashStats ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Stop the variable driver and free the in-memory variable FV.
+
+**/
+VOID
+VariableBenchmarkStop (
+  VOID
+  )
+{
+  if (mVariableModuleGlobal != NULL) {
+    VariableBenchmarkDisableRuntimeCache ();
+    FreePool ((VOID *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase);
+    FreePool (mVariableModuleGlobal);
+    mVariableModuleGlobal = NULL;
+  }
+
+  if (mNvFvHeaderCache != NULL) {
+    FreePool (mNvFvHeaderCache);
+    mNvFvHeaderCache = NULL;
+    mNvVariableCache = NULL;
+  }
+
+  if (mVariableDecompressScratch != NULL) {
+    FreePool (mVariableDecompressScratch);
+    mVariableDecompressScratch = NULL;
+  }
+
+  if (mBenchmarkFv != NULL) {
+    FreePool (mBenchmarkFv);
+    mBenchmarkFv     = NULL;
+    mBenchmarkFvSize = 0;
+  }
+}
+
+/**
+  Get the flash operations performed since the last reset.
+
+  @param[out] Stats   Receives the flash operation counters.
+
+**/
+VOID
+VariableBenchmarkGetFlashStats (
+  OUT VARIABLE_BENCHMARK_FLASH_STATS  *Stats
+  )
+{
+  CopyMem (Stats, &mBenchmarkStats, sizeof (*Stats));
+}
+
+/**
+  Reset the flash operation counters.
+
+**/
+VOID
+VariableBenchmarkResetFlashStats (
+  VOID
+  )
+{
+  ZeroMem (&mBenchmarkStats, sizeof (mBenchmarkStats));
+}
+
+/**
+  Attach runtime caches to the non-volatile and volatile variable stores, the
+  way SMM_VARIABLE_FUNCTION_INIT_RUNTIME_VARIABLE_CACHE_CONTEXT does for the
+  SMM variable driver. The caches start as copies of the stores.
+
+  @retval EFI_SUCCESS             The runtime caches are attached.
+  @retval EFI_NOT_STARTED         The variable driver is not running.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory for the caches.
+
+**/
+EFI_STATUS
+VariableBenchmarkEnableRuntimeCache (
+  VOID
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  VARIABLE_STORE_HEADER           *VolatileStore;
+
+  if (mVariableModuleGlobal == NULL) {
+    return EFI_NOT_STARTED;
+  }
+
+  CacheContext  = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  VolatileStore = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+
+  CacheContext->VariableRuntimeNvCache.Store       = AllocateCopyPool (mNvVariableCache->Size, mNvVariableCache);
+  CacheContext->VariableRuntimeVolatileCache.Store = AllocateCopyPool (VolatileStore->Size, VolatileStore);
+  if ((CacheContext->VariableRuntimeNvCache.Store == NULL) || (CacheContext->VariableRuntimeVolatileCache.Store == NULL)) {
+    VariableBenchmarkDisableRuntimeCache ();
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mBenchmarkReadLock         = FALSE;
+  mBenchmarkPendingUpdate    = FALSE;
+  mBenchmarkHobFlushComplete = FALSE;
+
+  CacheContext->ReadLock         = &mBenchmarkReadLock;
+  CacheContext->PendingUpdate    = &mBenchmarkPendingUpdate;
+  CacheContext->HobFlushComplete = &mBenchmarkHobFlushComplete;
+  return EFI_SUCCESS;
+}
+
+/**
+  Detach and free the runtime caches.
+
+**/
+VOID
+VariableBenchmarkDisableRuntimeCache (
+  VOID
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+
+  if (mVariableModuleGlobal == NULL) {
+    return;
+  }
+
+  CacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  if (CacheContext->VariableRuntimeNvCache.Store != NULL) {
+    FreePool (CacheContext->VariableRuntimeNvCache.Store);
+  }
+
+  if (CacheContext->VariableRuntimeVolatileCache.Store != NULL) {
+    FreePool (CacheContext->VariableRuntimeVolatileCache.Store);
+  }
+
+  ZeroMem (CacheContext, sizeof (*CacheContext));
+}
+
+/**
+  Take or release the runtime cache read lock. While it is taken, updates are
+  only journaled; releasing it flushes them, as a runtime cache reader does
+  with SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE.
+
+  @param[in] Locked   TRUE to take the read lock, FALSE to release it.
+
+**/
+VOID
+VariableBenchmarkLockRuntimeCache (
+  IN BOOLEAN  Locked
+  )
+{
+  mBenchmarkReadLock = Locked;
+  if (!Locked) {
+    FlushPendingRuntimeVariableCacheUpdates ();
+  }
+}
+
+/**
+  Check that the runtime caches hold the same bytes as the stores they mirror.
+
+  @retval TRUE    Both runtime caches match their stores.
+  @retval FALSE   A runtime cache is stale or not attached.
+
+**/
+BOOLEAN
+VariableBenchmarkRuntimeCacheInSync (
+  VOID
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  VARIABLE_STORE_HEADER           *VolatileStore;
+
+  if (mVariableModuleGlobal == NULL) {
+    return FALSE;
+  }
+
+  CacheContext  = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  VolatileStore = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  if ((CacheContext->VariableRuntimeNvCache.Store == NULL) || (CacheContext->VariableRuntimeVolatileCache.Store == NULL)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((CompareMem (CacheContext->VariableRuntimeNvCache.Store, mNvVariableCache, mNvVariableCache->Size) == 0) &&
+                   (CompareMem (CacheContext->VariableRuntimeVolatileCache.Store, VolatileStore, VolatileStore->Size) == 0));
+}
@@ -0,0 +1,137 @@
+/** @file
+  In-memory flash platform used to run the variable driver on the host for
+  performance benchmarking.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#pragma once
+
+#include <Uefi.h>
+
+///
+/// Flash block size of the emulated variable FV.
+///
+#define VARIABLE_BENCHMARK_BLOCK_SIZE  SIZE_4KB
+
+///
+/// Flash operations performed on the emulated variable FV.
+///
+typedef struct {
+  ///
+  /// Bytes programmed through FVB Write ().
+  ///
+  UINT64    FvbBytesWritten;
+  ///
+  /// Blocks erased through FVB EraseBlocks ().
+  ///
+  UINT64    FvbBlocksErased;
+  ///
+  /// Number of FTW Write () calls. Each one is a variable store reclaim.
+  ///
+  UINT64    FtwWrites;
+  ///
+  /// Bytes programmed by FTW Write (), including the spare block copy.
+  ///
+  UINT64    FtwBytesWritten;
+  ///
+  /// Blocks erased by FTW Write (), including the spare block erase.
+  ///
+  UINT64    FtwBlocksErased;
+} VARIABLE_BENCHMARK_FLASH_STATS;
+
+/**
+  Format an in-memory variable FV and start the variable driver on it.
+
+  @param[in] FvSize   Size in bytes of the emulated variable FV. It must be a
+                      multiple of VARIABLE_BENCHMARK_BLOCK_SIZE.
+
+  @retval EFI_SUCCESS             The variable services are ready for writes.
+  @retval EFI_INVALID_PARAMETER   FvSize is not a valid FV size.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory for the FV.
+  @retval Others                  The variable driver failed to initialize.
+
+**/
+EFI_STATUS
+VariableBenchmarkStart (
+  IN UINTN  FvSize
+  );
+
+/**
+  Stop the variable driver and free the in-memory variable FV.
+
+**/
+VOID
+VariableBenchmarkStop (
+  VOID
+  );
+
+/**
+  Get the flash operations performed since the last reset.
+
+  @param[out] Stats   Receives the flash operation counters.
+
+**/
+VOID
+VariableBenchmarkGetFlashStats (
+  OUT VARIABLE_BENCHMARK_FLASH_STATS  *Stats
+  );
+
+/**
+  Reset the flash operation counters.
+
+**/
+VOID
+VariableBenchmarkResetFlashStats (
+  VOID
+  );
+
+/**
+  Attach runtime caches to the non-volatile and volatile variable stores, the
+  way SMM_VARIABLE_FUNCTION_INIT_RUNTIME_VARIABLE_CACHE_CONTEXT does for the
+  SMM variable driver. The caches start as copies of the stores.
+
+  @retval EFI_SUCCESS             The runtime caches are attached.
+  @retval EFI_NOT_STARTED         The variable driver is not running.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory for the caches.
+
+**/
+EFI_STATUS
+VariableBenchmarkEnableRuntimeCache (
+  VOID
+  );
+
+/**
+  Detach and free the runtime caches.
+
+**/
+VOID
+VariableBenchmarkDisableRuntimeCache (
+  VOID
+  );
+
+/**
+  Take or release the runtime cache read lock. While it is taken, updates are
+  only journaled; releasing it flushes them, as a runtime cache reader does
+  with SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE.
+
+  @param[in] Locked   TRUE to take the read lock, FALSE to release it.
+
+**/
+VOID
+VariableBenchmarkLockRuntimeCache (
+  IN BOOLEAN  Locked
+  );
+
+/**
+  Check that the runtime caches hold the same bytes as the stores they mirror.
+
+  @retval TRUE    Both runtime caches match their stores.
+  @retval FALSE   A runtime cache is stale or not attached.
+
+**/
+BOOLEAN
+VariableBenchmarkRuntimeCacheInSync (
+  VOID
+  );
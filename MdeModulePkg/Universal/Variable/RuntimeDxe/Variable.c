@@ -437,6 +437,58 @@ IsUserVariable (
   return FALSE;
 }
 
+/**
+  Check if the data of a variable being written should be stored compressed.
+
+  Only non-volatile variables that are not authenticated and not hardware
+  error records are compressed, and only during boot time. Architecturally
+  defined variables and the variable error flag are always stored as is so
+  that their consumers can read them directly from the variable store.
+
+  @param[in] VendorGuid   Variable vendor GUID.
+  @param[in] Attributes   Attributes of the variable.
+  @param[in] DataSize     Size of the variable data.
+
+  @retval TRUE          The variable data should be compressed.
+  @retval FALSE         The variable data should be stored as is.
+
+**/
+STATIC
+BOOLEAN
+IsVariableCompressible (
+  IN EFI_GUID  *VendorGuid,
+  IN UINT32    Attributes,
+  IN UINTN     DataSize
+  )
+{
+  UINT32  Threshold;
+
+  Threshold = PcdGet32 (PcdVariableCompressionThreshold);
+  if ((Threshold == 0) || (DataSize < Threshold) || AtRuntime ()) {
+    return FALSE;
+  }
+
+  //
+  // Without the decompression scratch buffer the data could not be read
+  // back, so store it as is.
+  //
+  if (mVariableDecompressScratch == NULL) {
+    return FALSE;
+  }
+
+  if (((Attributes & EFI_VARIABLE_NON_VOLATILE) == 0) ||
+      ((Attributes & (VARIABLE_ATTRIBUTE_AT_AW | EFI_VARIABLE_HARDWARE_ERROR_RECORD)) != 0))
+  {
+    return FALSE;
+  }
+
+  if (CompareGuid (VendorGuid, &gEfiGlobalVariableGuid) || CompareGuid (VendorGuid, &gEdkiiVarErrorFlagGuid)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 /**
   Calculate common user variable total size.
 
@@ -1712,6 +1764,15 @@ UpdateVariable (
   BOOLEAN                             IsCommonUserVariable;
   AUTHENTICATED_VARIABLE_HEADER       *AuthVariable;
   BOOLEAN                             AuthFormat;
+  VARIABLE_HEADER                     *UpdatedVariables[4];
+  UINTN                               PreviousLastVariableOffset;
+  UINTN                               LastVariableOffset;
+  VARIABLE_STORE_HEADER               *CacheStore;
+  BOOLEAN                             StoreReclaimed;
+  UINT8                               *ExistingData;
+  UINTN                               ExistingDataSize;
+  UINT8                               *CompressedData;
+  UINTN                               CompressedDataSize;
 
   if ((mVariableModuleGlobal->FvbInstance == NULL) && !mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     //
@@ -1765,6 +1826,19 @@ UpdateVariable (
     }
   }
 
+  //
+  // Remember which parts of the variable stores this update may change, so only
+  // those are synchronized to the runtime cache afterwards.
+  //
+  StoreReclaimed      = FALSE;
+  UpdatedVariables[0] = CacheVariable->CurrPtr;
+  UpdatedVariables[1] = CacheVariable->InDeletedTransitionPtr;
+  if (((CacheVariable->CurrPtr != NULL) && !CacheVariable->Volatile) || ((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0)) {
+    PreviousLastVariableOffset = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  } else {
+    PreviousLastVariableOffset = mVariableModuleGlobal->VolatileLastVariableOffset;
+  }
+
   if ((CacheVariable->CurrPtr == NULL) || CacheVariable->Volatile) {
     Variable = CacheVariable;
   } else {
@@ -1887,12 +1961,29 @@ UpdateVariable (
       goto Done;
     }
 
+    //
+    // A compressed variable is decompressed into the data area of NextVariable,
+    // which is where EFI_VARIABLE_APPEND_WRITE merges the existing data anyway.
+    //
+    DataOffset = GetVariableDataOffset (CacheVariable->CurrPtr, AuthFormat);
+    if (IsVariableDataCompressed (CacheVariable->CurrPtr)) {
+      ExistingData     = (UINT8 *)((UINTN)NextVariable + DataOffset);
+      ExistingDataSize = ScratchSize - DataOffset;
+      Status           = GetVariableData (CacheVariable->CurrPtr, AuthFormat, &ExistingDataSize, ExistingData);
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+    } else {
+      ExistingData     = GetVariableDataPtr (CacheVariable->CurrPtr, AuthFormat);
+      ExistingDataSize = DataSizeOfVariable (CacheVariable->CurrPtr, AuthFormat);
+    }
+
     //
     // If the variable is marked valid, and the same data has been passed in,
     // then return to the caller immediately.
     //
-    if ((DataSizeOfVariable (CacheVariable->CurrPtr, AuthFormat) == DataSize) &&
-        (CompareMem (Data, GetVariableDataPtr (CacheVariable->CurrPtr, AuthFormat), DataSize) == 0) &&
+    if ((ExistingDataSize == DataSize) &&
+        (CompareMem (Data, ExistingData, DataSize) == 0) &&
         ((Attributes & EFI_VARIABLE_APPEND_WRITE) == 0) &&
         (TimeStamp == NULL))
     {
@@ -1913,13 +2004,8 @@ UpdateVariable (
         // NOTE: From 0 to DataOffset of NextVariable is reserved for Variable Header and Name.
         // From DataOffset of NextVariable is to save the existing variable data.
         //
-        DataOffset     = GetVariableDataOffset (CacheVariable->CurrPtr, AuthFormat);
         BufferForMerge = (UINT8 *)((UINTN)NextVariable + DataOffset);
-        CopyMem (
-          BufferForMerge,
-          (UINT8 *)((UINTN)CacheVariable->CurrPtr + DataOffset),
-          DataSizeOfVariable (CacheVariable->CurrPtr, AuthFormat)
-          );
+        CopyMem (BufferForMerge, ExistingData, ExistingDataSize);
 
         //
         // Set Max Auth/Non-Volatile/Volatile Variable Data Size as default MaxDataSize.
@@ -1940,7 +2026,7 @@ UpdateVariable (
           MaxDataSize = PcdGet32 (PcdMaxHardwareErrorVariableSize) - DataOffset;
         }
 
-        if (DataSizeOfVariable (CacheVariable->CurrPtr, AuthFormat) + DataSize > MaxDataSize) {
+        if (ExistingDataSize + DataSize > MaxDataSize) {
           //
           // Existing data size + new data size exceed maximum variable size limitation.
           //
@@ -1950,12 +2036,12 @@ UpdateVariable (
 
         CopyMem (
           (UINT8 *)(
-                    (UINTN)BufferForMerge + DataSizeOfVariable (CacheVariable->CurrPtr, AuthFormat)
+                    (UINTN)BufferForMerge + ExistingDataSize
                     ),
           Data,
           DataSize
           );
-        MergedBufSize = DataSizeOfVariable (CacheVariable->CurrPtr, AuthFormat) +
+        MergedBufSize = ExistingDataSize +
                         DataSize;
 
         //
@@ -2081,6 +2167,35 @@ UpdateVariable (
       Data,
       DataSize
       );
+    //
+    // Drop any decompressed copy of the old data beyond the new data.
+    //
+    SetMem ((UINT8 *)((UINTN)NextVariable + VarDataOffset + DataSize), ScratchSize - VarDataOffset - DataSize, 0xff);
+  }
+
+  //
+  // Store the data in compressed form if that makes the variable smaller.
+  //
+  if (IsVariableCompressible (VendorGuid, Attributes, DataSize)) {
+    CompressedDataSize = DataSize;
+    CompressedData     = AllocatePool (CompressedDataSize);
+    if (CompressedData != NULL) {
+      Status = UefiCompress (
+                 (UINT8 *)((UINTN)NextVariable + VarDataOffset),
+                 DataSize,
+                 CompressedData,
+                 &CompressedDataSize
+                 );
+      if (!EFI_ERROR (Status) && (CompressedDataSize < DataSize)) {
+        DEBUG ((DEBUG_VERBOSE, "Variable driver: compressed %s data 0x%x -> 0x%x bytes\n", VariableName, DataSize, CompressedDataSize));
+        SetMem ((UINT8 *)((UINTN)NextVariable + VarDataOffset), DataSize, 0xff);
+        CopyMem ((UINT8 *)((UINTN)NextVariable + VarDataOffset), CompressedData, CompressedDataSize);
+        DataSize                = CompressedDataSize;
+        NextVariable->Reserved |= VARIABLE_DATA_COMPRESSED;
+      }
+
+      FreePool (CompressedData);
+    }
   }
 
   CopyMem (
@@ -2136,14 +2251,15 @@ UpdateVariable (
       //
       // Perform garbage collection & reclaim operation, and integrate the new variable at the same time.
       //
-      Status = Reclaim (
-                 mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
-                 &mVariableModuleGlobal->NonVolatileLastVariableOffset,
-                 FALSE,
-                 Variable,
-                 NextVariable,
-                 HEADER_ALIGN (VarSize)
-                 );
+      StoreReclaimed = TRUE;
+      Status         = Reclaim (
+                         mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
+                         &mVariableModuleGlobal->NonVolatileLastVariableOffset,
+                         FALSE,
+                         Variable,
+                         NextVariable,
+                         HEADER_ALIGN (VarSize)
+                         );
       if (!EFI_ERROR (Status)) {
         //
         // The new variable has been integrated successfully during reclaiming.
@@ -2255,14 +2371,15 @@ UpdateVariable (
       //
       // Perform garbage collection & reclaim operation, and integrate the new variable at the same time.
       //
-      Status = Reclaim (
-                 mVariableModuleGlobal->VariableGlobal.VolatileVariableBase,
-                 &mVariableModuleGlobal->VolatileLastVariableOffset,
-                 TRUE,
-                 Variable,
-                 NextVariable,
-                 HEADER_ALIGN (VarSize)
-                 );
+      StoreReclaimed = TRUE;
+      Status         = Reclaim (
+                         mVariableModuleGlobal->VariableGlobal.VolatileVariableBase,
+                         &mVariableModuleGlobal->VolatileLastVariableOffset,
+                         TRUE,
+                         Variable,
+                         NextVariable,
+                         HEADER_ALIGN (VarSize)
+                         );
       if (!EFI_ERROR (Status)) {
         //
         // The new variable has been integrated successfully during reclaiming.
@@ -2354,16 +2471,26 @@ Done:
   if (!EFI_ERROR (Status)) {
     if (((Variable->CurrPtr != NULL) && !Variable->Volatile) || ((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0)) {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache);
+      CacheStore            = mNvVariableCache;
+      LastVariableOffset    = mVariableModuleGlobal->NonVolatileLastVariableOffset;
     } else {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache);
+      CacheStore            = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+      LastVariableOffset    = mVariableModuleGlobal->VolatileLastVariableOffset;
     }
 
     if (VolatileCacheInstance->Store != NULL) {
-      Status =  SynchronizeRuntimeVariableCache (
-                  VolatileCacheInstance,
-                  0,
-                  VolatileCacheInstance->Store->Size
-                  );
+      UpdatedVariables[2] = CacheVariable->CurrPtr;
+      UpdatedVariables[3] = CacheVariable->InDeletedTransitionPtr;
+      Status              =  SynchronizeRuntimeVariableCacheUpdate (
+                               VolatileCacheInstance,
+                               CacheStore,
+                               UpdatedVariables,
+                               ARRAY_SIZE (UpdatedVariables),
+                               PreviousLastVariableOffset,
+                               LastVariableOffset,
+                               StoreReclaimed
+                               );
       ASSERT_EFI_ERROR (Status);
     }
   } else if (Status == EFI_OUT_OF_RESOURCES) {
@@ -2434,30 +2561,29 @@ VariableServiceGetVariable (
   }
 
   //
-  // Get data size
+  // Get data, decompressing it if it is stored in compressed form.
   //
-  VarDataSize = DataSizeOfVariable (Variable.CurrPtr, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  VarDataSize = (Data == NULL) ? 0 : *DataSize;
+  Status      = GetVariableData (Variable.CurrPtr, mVariableModuleGlobal->VariableGlobal.AuthFormat, &VarDataSize, Data);
   ASSERT (VarDataSize != 0);
 
-  if (*DataSize >= VarDataSize) {
-    if (Data == NULL) {
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    if (*DataSize >= VarDataSize) {
       Status = EFI_INVALID_PARAMETER;
       goto Done;
     }
 
-    CopyMem (Data, GetVariableDataPtr (Variable.CurrPtr, mVariableModuleGlobal->VariableGlobal.AuthFormat), VarDataSize);
-
     *DataSize = VarDataSize;
-    UpdateVariableInfo (VariableName, VendorGuid, Variable.Volatile, TRUE, FALSE, FALSE, FALSE, &gVariableInfo);
-
-    Status = EFI_SUCCESS;
     goto Done;
-  } else {
-    *DataSize = VarDataSize;
-    Status    = EFI_BUFFER_TOO_SMALL;
+  } else if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Variable driver: failed to decompress variable data - %r\n", Status));
+    Status = EFI_DEVICE_ERROR;
     goto Done;
   }
 
+  *DataSize = VarDataSize;
+  UpdateVariableInfo (VariableName, VendorGuid, Variable.Volatile, TRUE, FALSE, FALSE, FALSE, &gVariableInfo);
+
 Done:
   if ((Status == EFI_SUCCESS) || (Status == EFI_BUFFER_TOO_SMALL)) {
     if ((Attributes != NULL) && (Variable.CurrPtr != NULL)) {
@@ -2954,9 +3080,14 @@ VariableServiceQueryVariableInfoInternal (
   UINT64                  HwErrVariableTotalSize;
   EFI_STATUS              Status;
   VARIABLE_POINTER_TRACK  VariablePtrTrack;
+  UINT64                  CompressedStoredSize;
+  UINT64                  CompressedLogicalSize;
+  UINTN                   LogicalDataSize;
 
   CommonVariableTotalSize = 0;
   HwErrVariableTotalSize  = 0;
+  CompressedStoredSize    = 0;
+  CompressedLogicalSize   = 0;
 
   if ((Attributes & EFI_VARIABLE_NON_VOLATILE) == 0) {
     //
@@ -3067,12 +3198,35 @@ VariableServiceQueryVariableInfoInternal (
       }
     }
 
+    //
+    // Track how much data compressed variables hold against what they occupy.
+    //
+    if ((Variable->State == VAR_ADDED) && IsVariableDataCompressed (Variable)) {
+      LogicalDataSize = 0;
+      GetVariableData (Variable, mVariableModuleGlobal->VariableGlobal.AuthFormat, &LogicalDataSize, NULL);
+      CompressedStoredSize  += DataSizeOfVariable (Variable, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+      CompressedLogicalSize += LogicalDataSize;
+    }
+
     //
     // Go to the next one.
     //
     Variable = NextVariable;
   }
 
+  //
+  // QueryVariableInfo() reports physical storage. The logical size of the
+  // compressed variables, as seen by GetVariable(), is only reported here.
+  //
+  if (CompressedStoredSize != 0) {
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "Variable driver: compressed variables hold 0x%lx bytes of data in 0x%lx bytes of storage\n",
+      CompressedLogicalSize,
+      CompressedStoredSize
+      ));
+  }
+
   if ((Attributes  & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
     *RemainingVariableStorageSize = *MaximumVariableStorageSize - HwErrVariableTotalSize;
   } else {
@@ -3567,6 +3721,7 @@ ConvertNormalVarStorageToAuthVarStorage (
       //
       AuthStartPtr->StartId    = StartPtr->StartId;
       AuthStartPtr->State      = StartPtr->State;
+      AuthStartPtr->Reserved   = StartPtr->Reserved;
       AuthStartPtr->Attributes = StartPtr->Attributes;
       AuthStartPtr->NameSize   = StartPtr->NameSize;
       AuthStartPtr->DataSize   = StartPtr->DataSize;
@@ -3721,6 +3876,15 @@ VariableCommonInitialize (
 
   InitializeLock (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock, TPL_NOTIFY);
 
+  //
+  // Allocate the scratch buffer used to read compressed variables.
+  // Variables are stored uncompressed if it cannot be allocated.
+  //
+  Status = InitializeVariableDecompressScratch ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Variable driver: no decompression scratch buffer, compression disabled - %r\n", Status));
+  }
+
   //
   // Init non-volatile variable store.
   //
@@ -32,6 +32,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/VarCheckLib.h>
 #include <Library/VariableFlashInfoLib.h>
 #include <Library/SafeIntLib.h>
+#include <Library/UefiDecompressLib.h>
+#include <Library/UefiCompressLib.h>
 #include <Guid/GlobalVariable.h>
 #include <Guid/EventGroup.h>
 #include <Guid/VariableFormat.h>
@@ -60,10 +62,21 @@ typedef enum {
   VariableStoreTypeMax
 } VARIABLE_STORE_TYPE;
 
+///
+/// The maximum number of disjoint pending update ranges journaled per runtime cache.
+/// Further updates are merged into the nearest journaled range.
+///
+#define VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES  8
+
+typedef struct {
+  UINT32    Offset;
+  UINT32    Length;
+} VARIABLE_RUNTIME_CACHE_UPDATE;
+
 typedef struct {
-  UINT32                   PendingUpdateOffset;
-  UINT32                   PendingUpdateLength;
-  VARIABLE_STORE_HEADER    *Store;
+  UINT32                           PendingUpdateCount;
+  VARIABLE_RUNTIME_CACHE_UPDATE    PendingUpdates[VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES];
+  VARIABLE_STORE_HEADER            *Store;
 } VARIABLE_RUNTIME_CACHE;
 
 typedef struct {
@@ -73,6 +86,11 @@ typedef struct {
   VARIABLE_RUNTIME_CACHE    VariableRuntimeHobCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeNvCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeVolatileCache;
+  UINT64                    FlushCount;             ///< Number of flushes of pending updates.
+  UINT64                    TotalBytesSynchronized; ///< Bytes copied to the runtime caches by all flushes.
+  UINT64                    LastBytesSynchronized;  ///< Bytes copied to the runtime caches by the last flush.
+  UINT64                    DeltaUpdateCount;       ///< Variable updates synchronized by the ranges they changed.
+  UINT64                    FullUpdateCount;        ///< Variable updates that reclaimed the store and synchronized all of it.
 } VARIABLE_RUNTIME_CACHE_CONTEXT;
 
 typedef struct {
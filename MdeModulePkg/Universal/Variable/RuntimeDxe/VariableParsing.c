@@ -9,6 +9,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "VariableParsing.h"
 
+///
+/// Scratch buffer used to decompress variable data. It is allocated from
+/// runtime memory so that compressed variables can be read at OS runtime.
+///
+VOID    *mVariableDecompressScratch     = NULL;
+UINT32  mVariableDecompressScratchSize = 0;
+
 /**
 
   This code checks if variable header is valid or not.
@@ -341,6 +348,136 @@ GetVariableDataOffset (
   return Value;
 }
 
+/**
+  This code checks if the data of a variable is stored in compressed form.
+
+  @param[in] Variable     Pointer to the Variable Header.
+
+  @retval TRUE            The variable data is a UEFI compressed stream.
+  @retval FALSE           The variable data is stored as is.
+
+**/
+BOOLEAN
+IsVariableDataCompressed (
+  IN  VARIABLE_HEADER  *Variable
+  )
+{
+  //
+  // The Reserved field is at the same offset in both header formats.
+  //
+  return (BOOLEAN)((Variable->Reserved & VARIABLE_DATA_COMPRESSED) != 0);
+}
+
+/**
+  Allocate the scratch buffer used to decompress variable data.
+
+  @retval EFI_SUCCESS           The scratch buffer is allocated.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the buffer.
+
+**/
+EFI_STATUS
+InitializeVariableDecompressScratch (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      DestinationSize;
+  UINT8       Header[8];
+
+  if (mVariableDecompressScratch != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The scratch size required by the UEFI decompressor does not depend on the
+  // stream, so query it with a minimal header.
+  //
+  ZeroMem (Header, sizeof (Header));
+  Status = UefiDecompressGetInfo (Header, sizeof (Header), &DestinationSize, &mVariableDecompressScratchSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mVariableDecompressScratch = AllocateRuntimePool (mVariableDecompressScratchSize);
+  if (mVariableDecompressScratch == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  This code gets the data of a variable, decompressing it if it is stored in
+  compressed form.
+
+  @param[in]      Variable    Pointer to the Variable Header.
+  @param[in]      AuthFormat  TRUE indicates authenticated variables are used.
+                              FALSE indicates authenticated variables are not used.
+  @param[in, out] DataSize    On input, the size in bytes of Data. On output,
+                              the size of the variable data.
+  @param[out]     Data        Buffer to receive the variable data. It may be
+                              NULL when *DataSize is too small.
+
+  @retval EFI_SUCCESS           The variable data is returned in Data.
+  @retval EFI_BUFFER_TOO_SMALL  DataSize is too small for the variable data.
+                                DataSize has been updated with the size needed.
+  @retval EFI_NOT_READY         The decompression scratch buffer is not allocated.
+  @retval EFI_VOLUME_CORRUPTED  The compressed variable data is corrupted.
+
+**/
+EFI_STATUS
+GetVariableData (
+  IN      VARIABLE_HEADER  *Variable,
+  IN      BOOLEAN          AuthFormat,
+  IN OUT  UINTN            *DataSize,
+  OUT     VOID             *Data OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       StoredSize;
+  UINT32      DestinationSize;
+  UINT32      ScratchSize;
+
+  StoredSize = DataSizeOfVariable (Variable, AuthFormat);
+  if (!IsVariableDataCompressed (Variable)) {
+    if (*DataSize < StoredSize) {
+      *DataSize = StoredSize;
+      return EFI_BUFFER_TOO_SMALL;
+    }
+
+    CopyMem (Data, GetVariableDataPtr (Variable, AuthFormat), StoredSize);
+    *DataSize = StoredSize;
+    return EFI_SUCCESS;
+  }
+
+  Status = UefiDecompressGetInfo (
+             GetVariableDataPtr (Variable, AuthFormat),
+             (UINT32)StoredSize,
+             &DestinationSize,
+             &ScratchSize
+             );
+  if (EFI_ERROR (Status)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (*DataSize < DestinationSize) {
+    *DataSize = DestinationSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  if ((mVariableDecompressScratch == NULL) || (ScratchSize > mVariableDecompressScratchSize)) {
+    return EFI_NOT_READY;
+  }
+
+  Status = UefiDecompress (GetVariableDataPtr (Variable, AuthFormat), Data, mVariableDecompressScratch);
+  if (EFI_ERROR (Status)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  *DataSize = DestinationSize;
+  return EFI_SUCCESS;
+}
+
 /**
 
   This code gets the pointer to the next variable header.
@@ -12,6 +12,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/ImageAuthentication.h>
 #include "Variable.h"
 
+extern VOID    *mVariableDecompressScratch;
+extern UINT32  mVariableDecompressScratchSize;
+
 /**
 
   This code checks if variable header is valid or not.
@@ -191,6 +194,59 @@ GetVariableDataOffset (
   IN  BOOLEAN          AuthFormat
   );
 
+/**
+  This code checks if the data of a variable is stored in compressed form.
+
+  @param[in] Variable     Pointer to the Variable Header.
+
+  @retval TRUE            The variable data is a UEFI compressed stream.
+  @retval FALSE           The variable data is stored as is.
+
+**/
+BOOLEAN
+IsVariableDataCompressed (
+  IN  VARIABLE_HEADER  *Variable
+  );
+
+/**
+  Allocate the scratch buffer used to decompress variable data.
+
+  @retval EFI_SUCCESS           The scratch buffer is allocated.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the buffer.
+
+**/
+EFI_STATUS
+InitializeVariableDecompressScratch (
+  VOID
+  );
+
+/**
+  This code gets the data of a variable, decompressing it if it is stored in
+  compressed form.
+
+  @param[in]      Variable    Pointer to the Variable Header.
+  @param[in]      AuthFormat  TRUE indicates authenticated variables are used.
+                              FALSE indicates authenticated variables are not used.
+  @param[in, out] DataSize    On input, the size in bytes of Data. On output,
+                              the size of the variable data.
+  @param[out]     Data        Buffer to receive the variable data. It may be
+                              NULL when *DataSize is too small.
+
+  @retval EFI_SUCCESS           The variable data is returned in Data.
+  @retval EFI_BUFFER_TOO_SMALL  DataSize is too small for the variable data.
+                                DataSize has been updated with the size needed.
+  @retval EFI_NOT_READY         The decompression scratch buffer is not allocated.
+  @retval EFI_VOLUME_CORRUPTED  The compressed variable data is corrupted.
+
+**/
+EFI_STATUS
+GetVariableData (
+  IN      VARIABLE_HEADER  *Variable,
+  IN      BOOLEAN          AuthFormat,
+  IN OUT  UINTN            *DataSize,
+  OUT     VOID             *Data OPTIONAL
+  );
+
 /**
 
   This code gets the pointer to the next variable header.
@@ -18,6 +18,42 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 extern VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 extern VARIABLE_STORE_HEADER   *mNvVariableCache;
 
+/**
+  Copies the journaled pending updates of one runtime variable cache from the variable store it mirrors.
+
+  @param[in, out] VariableRuntimeCache  Variable runtime cache structure for the runtime cache being flushed.
+  @param[in]      Source                Base address of the variable store mirrored by the runtime cache.
+
+  @return The number of bytes copied to the runtime cache.
+
+**/
+STATIC
+UINTN
+FlushRuntimeVariableCache (
+  IN OUT VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN     UINT8                   *Source
+  )
+{
+  VARIABLE_RUNTIME_CACHE_UPDATE  *Update;
+  UINTN                          Index;
+  UINTN                          BytesCopied;
+
+  BytesCopied = 0;
+  for (Index = 0; Index < VariableRuntimeCache->PendingUpdateCount; Index++) {
+    Update = &VariableRuntimeCache->PendingUpdates[Index];
+    CopyMem (
+      (VOID *)(((UINT8 *)(UINTN)VariableRuntimeCache->Store) + Update->Offset),
+      (VOID *)(Source + Update->Offset),
+      Update->Length
+      );
+    BytesCopied += Update->Length;
+  }
+
+  VariableRuntimeCache->PendingUpdateCount = 0;
+
+  return BytesCopied;
+}
+
 /**
   Copies any pending updates to runtime variable caches.
 
@@ -31,6 +67,7 @@ FlushPendingRuntimeVariableCacheUpdates (
   )
 {
   VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext;
+  UINTN                           BytesCopied;
 
   VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
 
@@ -42,57 +79,124 @@ FlushPendingRuntimeVariableCacheUpdates (
   }
 
   if (*(VariableRuntimeCacheContext->PendingUpdate)) {
+    BytesCopied = 0;
     if ((VariableRuntimeCacheContext->VariableRuntimeHobCache.Store != NULL) &&
         (mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0))
     {
-      CopyMem (
-        (VOID *)(
-                 ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeHobCache.Store) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        (VOID *)(
-                 ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength
-        );
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
+      BytesCopied += FlushRuntimeVariableCache (
+                       &VariableRuntimeCacheContext->VariableRuntimeHobCache,
+                       (UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase
+                       );
     }
 
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeNvCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mNvVariableCache) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength
-      );
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
+    BytesCopied += FlushRuntimeVariableCache (
+                     &VariableRuntimeCacheContext->VariableRuntimeNvCache,
+                     (UINT8 *)(UINTN)mNvVariableCache
+                     );
+    BytesCopied += FlushRuntimeVariableCache (
+                     &VariableRuntimeCacheContext->VariableRuntimeVolatileCache,
+                     (UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase
+                     );
+    *(VariableRuntimeCacheContext->PendingUpdate) = FALSE;
 
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength
-      );
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-    *(VariableRuntimeCacheContext->PendingUpdate)                                 = FALSE;
+    VariableRuntimeCacheContext->FlushCount++;
+    VariableRuntimeCacheContext->LastBytesSynchronized   = BytesCopied;
+    VariableRuntimeCacheContext->TotalBytesSynchronized += BytesCopied;
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "Variable runtime cache flush #%ld: 0x%lx bytes copied, 0x%lx bytes in total\n",
+      VariableRuntimeCacheContext->FlushCount,
+      VariableRuntimeCacheContext->LastBytesSynchronized,
+      VariableRuntimeCacheContext->TotalBytesSynchronized
+      ));
   }
 
   return EFI_SUCCESS;
 }
 
+/**
+  Adds an update range to the pending update journal of a runtime variable cache.
+
+  Ranges overlapping or adjacent to the new one are coalesced with it. If the journal is full, the journaled
+  range closest to the new one is merged with it, so the journal always covers every pending update.
+
+  @param[in, out] VariableRuntimeCache  Variable runtime cache structure for the runtime cache being updated.
+  @param[in]      Offset                Offset in bytes to apply the update.
+  @param[in]      Length                Length of data in bytes of the update.
+
+**/
+STATIC
+VOID
+AddRuntimeVariableCacheUpdate (
+  IN OUT VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN     UINTN                   Offset,
+  IN     UINTN                   Length
+  )
+{
+  VARIABLE_RUNTIME_CACHE_UPDATE  *Update;
+  UINTN                          Index;
+  UINTN                          Start;
+  UINTN                          End;
+  UINTN                          UpdateEnd;
+  UINTN                          Gap;
+  UINTN                          NearestGap;
+  UINTN                          NearestIndex;
+
+  if (Length == 0) {
+    return;
+  }
+
+  Start = Offset;
+  End   = Offset + Length;
+
+  Index = 0;
+  while (Index < VariableRuntimeCache->PendingUpdateCount) {
+    Update    = &VariableRuntimeCache->PendingUpdates[Index];
+    UpdateEnd = (UINTN)Update->Offset + Update->Length;
+    if ((Update->Offset > End) || (UpdateEnd < Start)) {
+      Index++;
+      if ((Index < VariableRuntimeCache->PendingUpdateCount) ||
+          (VariableRuntimeCache->PendingUpdateCount < VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES))
+      {
+        continue;
+      }
+
+      //
+      // The journal is full and no range touches the new one. Merge the closest range into it.
+      //
+      NearestGap   = MAX_UINTN;
+      NearestIndex = 0;
+      for (Index = 0; Index < VariableRuntimeCache->PendingUpdateCount; Index++) {
+        Update    = &VariableRuntimeCache->PendingUpdates[Index];
+        UpdateEnd = (UINTN)Update->Offset + Update->Length;
+        Gap       = (UpdateEnd < Start) ? (Start - UpdateEnd) : (Update->Offset - End);
+        if (Gap < NearestGap) {
+          NearestGap   = Gap;
+          NearestIndex = Index;
+        }
+      }
+
+      Index     = NearestIndex;
+      Update    = &VariableRuntimeCache->PendingUpdates[Index];
+      UpdateEnd = (UINTN)Update->Offset + Update->Length;
+    }
+
+    //
+    // Coalesce the journaled range with the new one and rescan, as the grown range may now touch others.
+    //
+    Start = MIN (Start, (UINTN)Update->Offset);
+    End   = MAX (End, UpdateEnd);
+    VariableRuntimeCache->PendingUpdateCount--;
+    *Update = VariableRuntimeCache->PendingUpdates[VariableRuntimeCache->PendingUpdateCount];
+    Index   = 0;
+  }
+
+  Update         = &VariableRuntimeCache->PendingUpdates[VariableRuntimeCache->PendingUpdateCount];
+  Update->Offset = (UINT32)Start;
+  Update->Length = (UINT32)(End - Start);
+  VariableRuntimeCache->PendingUpdateCount++;
+}
+
 /**
   Synchronizes the runtime variable caches with all pending updates outside runtime.
 
@@ -131,23 +235,12 @@ SynchronizeRuntimeVariableCache (
     return EFI_UNSUPPORTED;
   }
 
-  if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) &&
-      (VariableRuntimeCache->PendingUpdateLength > 0))
-  {
-    VariableRuntimeCache->PendingUpdateLength =
-      (UINT32)(
-               MAX (
-                 (UINTN)(VariableRuntimeCache->PendingUpdateOffset + VariableRuntimeCache->PendingUpdateLength),
-                 Offset + Length
-                 ) - MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset)
-               );
-    VariableRuntimeCache->PendingUpdateOffset =
-      (UINT32)MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset);
-  } else {
-    VariableRuntimeCache->PendingUpdateLength = (UINT32)Length;
-    VariableRuntimeCache->PendingUpdateOffset = (UINT32)Offset;
+  if (!*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate)) {
+    VariableRuntimeCache->PendingUpdateCount = 0;
   }
 
+  AddRuntimeVariableCacheUpdate (VariableRuntimeCache, Offset, Length);
+
   *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) = TRUE;
 
   if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReadLock) == FALSE) {
@@ -156,3 +249,71 @@ SynchronizeRuntimeVariableCache (
 
   return EFI_SUCCESS;
 }
+
+/**
+  Synchronizes the runtime variable cache with the changes one variable update made to the store it mirrors.
+
+  Instead of the whole store, only the State fields of the variables whose state may have changed and the range
+  the new variable was appended to are synchronized. If the update reclaimed the store, every variable may have
+  moved and the whole store is synchronized, whether the store grew or shrank.
+
+  @param[in] VariableRuntimeCache       Variable runtime cache structure for the runtime cache being synchronized.
+  @param[in] VariableStore              The variable store mirrored by the runtime cache.
+  @param[in] UpdatedVariables           Variables whose State field may have changed. NULL entries and
+                                        variables outside VariableStore are ignored.
+  @param[in] UpdatedVariableCount       Number of entries in UpdatedVariables.
+  @param[in] PreviousLastVariableOffset Offset of the end of the variables in the store before the update.
+  @param[in] LastVariableOffset         Offset of the end of the variables in the store after the update.
+  @param[in] StoreReclaimed             TRUE if the update reclaimed the store.
+
+  @retval EFI_SUCCESS             The update was added as a pending update successfully. If the variable runtime
+                                  cache ReadLock was available, the runtime cache was updated successfully.
+  @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCacheUpdate (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER   *VariableStore,
+  IN  VARIABLE_HEADER         **UpdatedVariables,
+  IN  UINTN                   UpdatedVariableCount,
+  IN  UINTN                   PreviousLastVariableOffset,
+  IN  UINTN                   LastVariableOffset,
+  IN  BOOLEAN                 StoreReclaimed
+  )
+{
+  EFI_STATUS                      Status;
+  UINTN                           Index;
+  UINTN                           Offset;
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext;
+
+  VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+
+  if (StoreReclaimed || (LastVariableOffset < PreviousLastVariableOffset)) {
+    VariableRuntimeCacheContext->FullUpdateCount++;
+    return SynchronizeRuntimeVariableCache (VariableRuntimeCache, 0, VariableStore->Size);
+  }
+
+  VariableRuntimeCacheContext->DeltaUpdateCount++;
+
+  for (Index = 0; Index < UpdatedVariableCount; Index++) {
+    if ((UpdatedVariables[Index] == NULL) ||
+        ((UINTN)UpdatedVariables[Index] < (UINTN)VariableStore) ||
+        ((UINTN)UpdatedVariables[Index] >= (UINTN)VariableStore + VariableStore->Size))
+    {
+      continue;
+    }
+
+    Offset = (UINTN)UpdatedVariables[Index] - (UINTN)VariableStore + OFFSET_OF (VARIABLE_HEADER, State);
+    Status = SynchronizeRuntimeVariableCache (VariableRuntimeCache, Offset, sizeof (UpdatedVariables[Index]->State));
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return SynchronizeRuntimeVariableCache (
+           VariableRuntimeCache,
+           PreviousLastVariableOffset,
+           LastVariableOffset - PreviousLastVariableOffset
+           );
+}
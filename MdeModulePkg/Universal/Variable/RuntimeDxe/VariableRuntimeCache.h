@@ -46,3 +46,35 @@ SynchronizeRuntimeVariableCache (
   IN  UINTN                   Offset,
   IN  UINTN                   Length
   );
+
+/**
+  Synchronizes the runtime variable cache with the changes one variable update made to the store it mirrors.
+
+  Instead of the whole store, only the State fields of the variables whose state may have changed and the range
+  the new variable was appended to are synchronized. If the update reclaimed the store, every variable may have
+  moved and the whole store is synchronized, whether the store grew or shrank.
+
+  @param[in] VariableRuntimeCache       Variable runtime cache structure for the runtime cache being synchronized.
+  @param[in] VariableStore              The variable store mirrored by the runtime cache.
+  @param[in] UpdatedVariables           Variables whose State field may have changed. NULL entries and
+                                        variables outside VariableStore are ignored.
+  @param[in] UpdatedVariableCount       Number of entries in UpdatedVariables.
+  @param[in] PreviousLastVariableOffset Offset of the end of the variables in the store before the update.
+  @param[in] LastVariableOffset         Offset of the end of the variables in the store after the update.
+  @param[in] StoreReclaimed             TRUE if the update reclaimed the store.
+
+  @retval EFI_SUCCESS             The update was added as a pending update successfully. If the variable runtime
+                                  cache ReadLock was available, the runtime cache was updated successfully.
+  @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCacheUpdate (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER   *VariableStore,
+  IN  VARIABLE_HEADER         **UpdatedVariables,
+  IN  UINTN                   UpdatedVariableCount,
+  IN  UINTN                   PreviousLastVariableOffset,
+  IN  UINTN                   LastVariableOffset,
+  IN  BOOLEAN                 StoreReclaimed
+  );
@@ -467,6 +467,7 @@ SmmVariableHandler (
   SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE                *GetPayloadSize;
   SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT  *RuntimeVariableCacheContext;
   SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO          *GetRuntimeCacheInfo;
+  SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS    *GetRuntimeCacheStatistics;
   SMM_VARIABLE_COMMUNICATE_LOCK_VARIABLE                   *VariableToLock;
   SMM_VARIABLE_COMMUNICATE_VAR_CHECK_VARIABLE_PROPERTY     *CommVariableProperty;
   VARIABLE_INFO_ENTRY                                      *VariableInfo;
@@ -933,24 +934,27 @@ SmmVariableHandler (
       VariableCacheContext->HobFlushComplete                   = RuntimeVariableCacheContext->HobFlushComplete;
 
       // Set up the intial pending request since the RT cache needs to be in sync with SMM cache
-      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
+      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateCount = 0;
       if ((mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0) &&
           (VariableCacheContext->VariableRuntimeHobCache.Store != NULL))
       {
-        VariableCache                                                     = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
-        VariableCacheContext->VariableRuntimeHobCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+        VariableCache                                                           = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdates[0].Offset = 0;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdates[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdateCount       = 1;
         CopyGuid (&(VariableCacheContext->VariableRuntimeHobCache.Store->Signature), &(VariableCache->Signature));
       }
 
-      VariableCache                                                          = (VARIABLE_STORE_HEADER  *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
-      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCache                                                                = (VARIABLE_STORE_HEADER  *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdates[0].Offset = 0;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdates[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateCount       = 1;
       CopyGuid (&(VariableCacheContext->VariableRuntimeVolatileCache.Store->Signature), &(VariableCache->Signature));
 
-      VariableCache                                                    = (VARIABLE_STORE_HEADER  *)(UINTN)mNvVariableCache;
-      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCache                                                          = (VARIABLE_STORE_HEADER  *)(UINTN)mNvVariableCache;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdates[0].Offset = 0;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdates[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateCount       = 1;
       CopyGuid (&(VariableCacheContext->VariableRuntimeNvCache.Store->Signature), &(VariableCache->Signature));
 
       *(VariableCacheContext->PendingUpdate)    = TRUE;
@@ -983,6 +987,28 @@ SmmVariableHandler (
       GetRuntimeCacheInfo->TotalNvStorageSize         = (UINTN)VariableCache->Size;
       GetRuntimeCacheInfo->AuthenticatedVariableUsage = mVariableModuleGlobal->VariableGlobal.AuthFormat;
 
+      Status = EFI_SUCCESS;
+      break;
+    case SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_STATISTICS:
+      if (!FeaturePcdGet (PcdVariableCollectStatistics)) {
+        Status = EFI_UNSUPPORTED;
+        break;
+      }
+
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS)) {
+        DEBUG ((DEBUG_ERROR, "GetRuntimeCacheStatistics: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+
+      GetRuntimeCacheStatistics = (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_STATISTICS *)SmmVariableFunctionHeader->Data;
+      VariableCacheContext      = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+
+      GetRuntimeCacheStatistics->FlushCount             = VariableCacheContext->FlushCount;
+      GetRuntimeCacheStatistics->TotalBytesSynchronized = VariableCacheContext->TotalBytesSynchronized;
+      GetRuntimeCacheStatistics->LastBytesSynchronized  = VariableCacheContext->LastBytesSynchronized;
+      GetRuntimeCacheStatistics->DeltaUpdateCount       = VariableCacheContext->DeltaUpdateCount;
+      GetRuntimeCacheStatistics->FullUpdateCount        = VariableCacheContext->FullUpdateCount;
+
       Status = EFI_SUCCESS;
       break;
 
@@ -629,29 +629,28 @@ FindVariableInRuntimeCache (
 
     if (!EFI_ERROR (Status)) {
       //
-      // Get data size
+      // Get data, decompressing it if it is stored in compressed form.
       //
-      TempDataSize = DataSizeOfVariable (RtPtrTrack.CurrPtr, mVariableAuthFormat);
+      TempDataSize = (Data == NULL) ? 0 : *DataSize;
+      Status       = GetVariableData (RtPtrTrack.CurrPtr, mVariableAuthFormat, &TempDataSize, Data);
       ASSERT (TempDataSize != 0);
 
-      if (*DataSize >= TempDataSize) {
-        if (Data == NULL) {
+      if (Status == EFI_BUFFER_TOO_SMALL) {
+        if (*DataSize >= TempDataSize) {
           Status = EFI_INVALID_PARAMETER;
           goto Done;
         }
 
-        CopyMem (Data, GetVariableDataPtr (RtPtrTrack.CurrPtr, mVariableAuthFormat), TempDataSize);
         *DataSize = TempDataSize;
-
-        UpdateVariableInfo (VariableName, VendorGuid, RtPtrTrack.Volatile, TRUE, FALSE, FALSE, TRUE, &mVariableInfo);
-
-        Status = EFI_SUCCESS;
         goto Done;
-      } else {
-        *DataSize = TempDataSize;
-        Status    = EFI_BUFFER_TOO_SMALL;
+      } else if (EFI_ERROR (Status)) {
+        Status = EFI_DEVICE_ERROR;
         goto Done;
       }
+
+      *DataSize = TempDataSize;
+
+      UpdateVariableInfo (VariableName, VendorGuid, RtPtrTrack.Volatile, TRUE, FALSE, FALSE, TRUE, &mVariableInfo);
     }
   }
 
@@ -1378,6 +1377,7 @@ VariableAddressChangeEvent (
   )
 {
   EfiConvertPointer (0x0, (VOID **)&mVariableBuffer);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableDecompressScratch);
   if (mMmCommunication3 != NULL) {
     EfiConvertPointer (0x0, (VOID **)&mMmCommunication3);
   } else {
@@ -1830,10 +1830,21 @@ SmmVariableReady (
   mVariableBufferPhysical = mVariableBuffer;
 
   GuidHob = GetFirstGuidHob (&gEdkiiVariableRuntimeCacheInfoHobGuid);
+  if (GuidHob != NULL) {
+    //
+    // Compressed variables cannot be read from the runtime cache without the
+    // decompression scratch buffer, so leave all reads to MM in that case.
+    //
+    Status = InitializeVariableDecompressScratch ();
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Variable driver: no decompression scratch buffer for runtime cache - %r\n", Status));
+      GuidHob = NULL;
+    }
+  }
+
   if (GuidHob != NULL) {
     mIsRuntimeCacheEnabled = TRUE;
     DEBUG ((DEBUG_INFO, "Variable driver runtime cache is enabled.\n"));
-
     Status = InitVariableCache (GuidHob);
     if (!EFI_ERROR (Status)) {
       Status = SendRuntimeVariableCacheContextToSmm ();
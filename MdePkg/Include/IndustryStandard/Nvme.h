@@ -765,6 +765,7 @@ typedef struct {
 // Feature Identifier
 // (ref. spec. v2.1 Figure 32).
 //
+#define NUMBER_OF_QUEUES_FID             0x07  // Number of Queues
 #define POWER_LOSS_SIGNALING_CONFIG_FID  0x1B  // Power Loss Signaling Config
 
 //
@@ -885,8 +886,8 @@ typedef struct {
   //
   UINT8           Opc;       // Opcode
   UINT8           Fuse  : 2; // Fused Operation
-  UINT8           Rsvd1 : 5;
-  UINT8           Psdt  : 1; // PRP or SGL for Data Transfer
+  UINT8           Rsvd1 : 4;
+  UINT8           Psdt  : 2; // PRP or SGL for Data Transfer
   UINT16          Cid;       // Command Identifier
 
   //
@@ -912,6 +913,40 @@ typedef struct {
   NVME_PAYLOAD    Payload;
 } NVME_SQ;
 
+//
+// PRP or SGL for Data Transfer (PSDT) values of the Submission Queue entry
+//
+#define NVME_PSDT_PRP              0x0   // PRPs are used for the data transfer
+#define NVME_PSDT_SGL_MPTR_BUFFER  0x1   // SGLs are used, MPTR is a contiguous buffer
+#define NVME_PSDT_SGL_MPTR_SGL     0x2   // SGLs are used, MPTR is an SGL segment
+
+//
+// SGL Support (SGLS) bits 1:0 of the Identify Controller data
+//
+#define NVME_SGLS_SUPPORT_MASK     0x3
+#define NVME_SGLS_NOT_SUPPORTED    0x0   // SGLs are not supported
+#define NVME_SGLS_SUPPORTED        0x1   // SGLs are supported, no alignment requirement
+#define NVME_SGLS_SUPPORTED_DWORD  0x2   // SGLs are supported, Dword alignment required
+
+//
+// SGL descriptor types
+//
+#define NVME_SGL_TYPE_DATA_BLOCK  0x0
+#define NVME_SGL_TYPE_BIT_BUCKET  0x1
+#define NVME_SGL_TYPE_SEGMENT     0x2
+#define NVME_SGL_TYPE_LAST_SEG    0x3
+
+//
+// SGL Descriptor
+//
+typedef struct {
+  UINT64    Address;
+  UINT32    Length;
+  UINT8     Rsvd[3];
+  UINT8     SubType : 4;     // SGL Descriptor Sub Type
+  UINT8     Type    : 4;     // SGL Descriptor Type
+} NVME_SGL_DESCRIPTOR;
+
 //
 // Completion Queue
 //
@@ -35,6 +35,7 @@
 #define USB_MASS_STORE_CBI0  0x00    ///< CBI protocol with command completion interrupt
 #define USB_MASS_STORE_CBI1  0x01    ///< CBI protocol without command completion interrupt
 #define USB_MASS_STORE_BOT   0x50    ///< Bulk-Only Transport
+#define USB_MASS_STORE_UAS   0x62    ///< USB Attached SCSI
 
 //
 // Standard device request and request type
@@ -552,6 +552,35 @@ InternalAsciiHexCharToUintn (
   IN      CHAR8  Char
   );
 
+//
+// Buffers shorter than this are checksummed by CalculateCrc32 () with tables
+// only. The first CPU feature check traps to the hypervisor in virtual
+// machines, and modules running from flash repeat it on every call, where it
+// costs as much as checksumming a few KB with the tables.
+//
+#define CRC32_ACCELERATED_MIN_LENGTH  SIZE_4KB
+
+/**
+  Update a CRC32 (ITU-T V.42) over the leading part of a buffer using CPU
+  instructions, if the processor has them.
+
+  @param[in]  Crc     The running CRC32, without the final inversion.
+  @param[in]  Buffer  The buffer to checksum.
+  @param[in]  Length  The number of bytes in Buffer.
+  @param[out] Done    The number of leading bytes of Buffer that were
+                      checksummed. Zero if the CPU cannot accelerate CRC32.
+
+  @return The running CRC32 updated with the first Done bytes of Buffer.
+
+**/
+UINT32
+InternalCrc32Accelerated (
+  IN  UINT32       Crc,
+  IN  CONST UINT8  *Buffer,
+  IN  UINTN        Length,
+  OUT UINTN        *Done
+  );
+
 //
 // Ia32 and x64 specific functions
 //
@@ -862,6 +891,25 @@ InternalX86WriteFsBase (
   UINT64  FsBase
   );
 
+/**
+  Update a CRC32 (ITU-T V.42) using the PCLMULQDQ instruction.
+
+  @param[in]  Crc     The running CRC32, without the final inversion.
+  @param[in]  Buffer  The buffer to checksum.
+  @param[in]  Length  The number of bytes in Buffer. Must be at least 64 and
+                      a multiple of 16.
+
+  @return The running CRC32 updated with Buffer.
+
+**/
+UINT32
+EFIAPI
+InternalCrc32Pclmul (
+  IN UINT32       Crc,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  );
+
 /**
   Read FS base register.
 
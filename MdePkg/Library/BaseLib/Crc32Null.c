@@ -0,0 +1,34 @@
+/** @file
+  Null stub of the CRC32 acceleration, for processors whose CRC32
+  instructions BaseLib does not use.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "BaseLibInternals.h"
+
+/**
+  Update a CRC32 (ITU-T V.42) over the leading part of a buffer using CPU
+  instructions, if the processor has them.
+
+  @param[in]  Crc     The running CRC32, without the final inversion.
+  @param[in]  Buffer  The buffer to checksum.
+  @param[in]  Length  The number of bytes in Buffer.
+  @param[out] Done    The number of leading bytes of Buffer that were
+                      checksummed. Always zero.
+
+  @return Crc, unchanged.
+
+**/
+UINT32
+InternalCrc32Accelerated (
+  IN  UINT32       Crc,
+  IN  CONST UINT8  *Buffer,
+  IN  UINTN        Length,
+  OUT UINTN        *Done
+  )
+{
+  *Done = 0;
+  return Crc;
+}
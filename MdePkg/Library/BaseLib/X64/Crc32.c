@@ -0,0 +1,71 @@
+/** @file
+  CRC32 acceleration with the PCLMULQDQ instruction.
+
+  The routine only touches XMM0-XMM5, which are volatile in the X64 calling
+  convention, and expects SSE to be enabled like compiler generated X64 code
+  does. It may therefore run in every X64 phase: SEC once in long mode, PEI,
+  DXE, SMM, Standalone MM and runtime. It is only reached when the platform
+  sets PcdCrc32CpuAcceleration to TRUE, as the CPUID feature check traps in
+  SEV-ES, SEV-SNP and TDX guests.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "BaseLibInternals.h"
+#include <Register/Intel/Cpuid.h>
+
+#define CRC32_PCLMUL_UNKNOWN      0
+#define CRC32_PCLMUL_SUPPORTED    1
+#define CRC32_PCLMUL_UNSUPPORTED  2
+
+//
+// Result of the CPUID feature check. Modules that run from flash cannot
+// update it, and check again on every call.
+//
+STATIC UINT8  mCrc32Pclmul = CRC32_PCLMUL_UNKNOWN;
+
+/**
+  Update a CRC32 (ITU-T V.42) over the leading part of a buffer using CPU
+  instructions, if the processor has them.
+
+  @param[in]  Crc     The running CRC32, without the final inversion.
+  @param[in]  Buffer  The buffer to checksum.
+  @param[in]  Length  The number of bytes in Buffer.
+  @param[out] Done    The number of leading bytes of Buffer that were
+                      checksummed. Zero if the CPU cannot accelerate CRC32.
+
+  @return The running CRC32 updated with the first Done bytes of Buffer.
+
+**/
+UINT32
+InternalCrc32Accelerated (
+  IN  UINT32       Crc,
+  IN  CONST UINT8  *Buffer,
+  IN  UINTN        Length,
+  OUT UINTN        *Done
+  )
+{
+  CPUID_VERSION_INFO_ECX  Ecx;
+
+  *Done = 0;
+
+  //
+  // The PCLMULQDQ routine folds whole 16 byte blocks, at least four of them
+  //
+  if (Length < 64) {
+    return Crc;
+  }
+
+  if (mCrc32Pclmul == CRC32_PCLMUL_UNKNOWN) {
+    AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &Ecx.Uint32, NULL);
+    mCrc32Pclmul = (Ecx.Bits.PCLMULQDQ != 0) ? CRC32_PCLMUL_SUPPORTED : CRC32_PCLMUL_UNSUPPORTED;
+  }
+
+  if (mCrc32Pclmul != CRC32_PCLMUL_SUPPORTED) {
+    return Crc;
+  }
+
+  *Done = Length & ~(UINTN)0xF;
+  return InternalCrc32Pclmul (Crc, Buffer, *Done);
+}
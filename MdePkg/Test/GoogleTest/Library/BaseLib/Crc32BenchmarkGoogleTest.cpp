@@ -0,0 +1,222 @@
+/** @file
+  Host-based throughput benchmark of CalculateCrc32 ().
+
+  For every buffer size the benchmark reports the throughput of the byte at a
+  time table loop CalculateCrc32 () used to run and of CalculateCrc32 ()
+  itself, and checks that both agree. CalculateCrc32 () uses its slicing-by-8
+  tables below 4 KB, and the CPU CRC32 instructions from 4 KB on when the host
+  has them. It caches the CPU feature check, so one run cannot measure the
+  tables on large buffers of a host with the instructions.
+
+  The test is disabled, as it checksums several GB. Run it by hand with
+  --gtest_also_run_disabled_tests.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+  #include <Base.h>
+  #include <Library/BaseLib.h>
+  #include <Library/UnitTestHostBaseLib.h>
+}
+
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+  #if defined (_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
+using namespace testing;
+
+//
+// Bytes checksummed per measurement, whatever the buffer size
+//
+#define BENCHMARK_BYTES  SIZE_256MB
+
+STATIC UINT32  mByteTable[256];
+
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+
+/**
+  AsmCpuid () hook that executes the real CPUID instruction, so that
+  CalculateCrc32 () finds PCLMULQDQ when the host has it.
+**/
+STATIC
+UINT32
+EFIAPI
+BenchmarkAsmCpuid (
+  IN      UINT32  Index,
+  OUT     UINT32  *Eax   OPTIONAL,
+  OUT     UINT32  *Ebx   OPTIONAL,
+  OUT     UINT32  *Ecx   OPTIONAL,
+  OUT     UINT32  *Edx   OPTIONAL
+  )
+{
+  UINT32  Regs[4];
+
+ #if defined (_MSC_VER)
+  __cpuid ((int *)Regs, (int)Index);
+ #else
+  __cpuid (Index, Regs[0], Regs[1], Regs[2], Regs[3]);
+ #endif
+
+  if (Eax != NULL) {
+    *Eax = Regs[0];
+  }
+
+  if (Ebx != NULL) {
+    *Ebx = Regs[1];
+  }
+
+  if (Ecx != NULL) {
+    *Ecx = Regs[2];
+  }
+
+  if (Edx != NULL) {
+    *Edx = Regs[3];
+  }
+
+  return Index;
+}
+
+#endif
+
+/**
+  The byte at a time CRC32 loop, as a baseline.
+**/
+STATIC
+UINT32
+ByteTableCrc32 (
+  CONST UINT8  *Buffer,
+  UINTN        Length
+  )
+{
+  UINT32  Crc;
+
+  Crc = 0xFFFFFFFF;
+  while (Length-- != 0) {
+    Crc = (Crc >> 8) ^ mByteTable[(UINT8)Crc ^ *Buffer++];
+  }
+
+  return Crc ^ 0xFFFFFFFF;
+}
+
+class Crc32Benchmark : public TestWithParam<UINTN> {
+protected:
+  typedef std::chrono::steady_clock Clock;
+
+  std::vector<UINT8> Buffer;
+
+  static void
+  SetUpTestSuite (
+    )
+  {
+    UINT32  Crc;
+    UINTN   Index;
+    UINTN   Bit;
+
+    for (Index = 0; Index < 256; Index++) {
+      Crc = (UINT32)Index;
+      for (Bit = 0; Bit < 8; Bit++) {
+        Crc = (Crc >> 1) ^ (0xEDB88320 & (0 - (Crc & 1)));
+      }
+
+      mByteTable[Index] = Crc;
+    }
+
+ #if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+    gUnitTestHostBaseLib.X86->AsmCpuid = BenchmarkAsmCpuid;
+ #endif
+  }
+
+  void
+  SetUp (
+    ) override
+  {
+    UINTN  Index;
+
+    Buffer.resize (GetParam ());
+    for (Index = 0; Index < Buffer.size (); Index++) {
+      Buffer[Index] = (UINT8)(Index * 131 + (Index >> 8));
+    }
+  }
+
+  //
+  // Throughput of Crc32 over the buffer in MB/s; the CRC of the last round is
+  // returned in Crc.
+  //
+  template <typename Function>
+  double
+  Measure (
+    Function  Crc32,
+    UINT32    &Crc
+    )
+  {
+    UINTN              Rounds;
+    UINTN              Round;
+    Clock::time_point  Start;
+    double             Seconds;
+
+    Rounds = MAX (1, BENCHMARK_BYTES / Buffer.size ());
+    Start  = Clock::now ();
+    for (Round = 0; Round < Rounds; Round++) {
+      Crc = Crc32 (Buffer.data (), Buffer.size ());
+    }
+
+    Seconds = std::chrono::duration<double>(Clock::now () - Start).count ();
+    return (double)(Rounds * Buffer.size ()) / Seconds / 1e6;
+  }
+};
+
+TEST_P (Crc32Benchmark, DISABLED_Throughput) {
+  UINT32  ByteCrc;
+  UINT32  Crc;
+  double  ByteRate;
+  double  Rate;
+
+  ByteRate = Measure (ByteTableCrc32, ByteCrc);
+  Rate     = Measure ([](UINT8 *Data, UINTN Size) { return CalculateCrc32 (Data, Size); }, Crc);
+
+  EXPECT_EQ (Crc, ByteCrc);
+
+  std::printf (
+    "CRC32 benchmark: 0x%llx bytes\n"
+    "  %-24s %12.1f\n"
+    "  %-24s %12.1f\n",
+    (unsigned long long)Buffer.size (),
+    "ByteTableMBps",
+    ByteRate,
+    "CalculateCrc32MBps",
+    Rate
+    );
+}
+
+INSTANTIATE_TEST_SUITE_P (
+  BufferSizes,
+  Crc32Benchmark,
+  Values (
+    (UINTN)64,
+    (UINTN)512,
+    (UINTN)SIZE_1KB,
+    (UINTN)SIZE_4KB,
+    (UINTN)SIZE_16KB,
+    (UINTN)SIZE_64KB,
+    (UINTN)SIZE_1MB
+    )
+  );
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
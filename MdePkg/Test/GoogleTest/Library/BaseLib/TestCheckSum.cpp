@@ -6,15 +6,162 @@
 **/
 
 #include <Library/GoogleTestLib.h>
+#include <vector>
+
 extern "C" {
   #include <Base.h>
   #include <Library/BaseLib.h>
+  #include <Library/UnitTestHostBaseLib.h>
 }
 
-// Precomputed crc32c and crc16-ansi for "hello" (without the null byte)
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+  #if defined (_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
+// Precomputed crc32, crc32c and crc16-ansi for "hello" (without the null byte)
+constexpr STATIC UINT32  mHelloCrc32  = 0x3610A686;
 constexpr STATIC UINT32  mHelloCrc32c = 0x9A71BB4C;
 constexpr STATIC UINT16  mHelloCrc16  = 0x34F6;
 
+// Bit at a time crc32, to check the table driven implementation against
+STATIC
+UINT32
+ReferenceCrc32 (
+  CONST UINT8  *Buffer,
+  UINTN        Length
+  )
+{
+  UINT32  Crc;
+  UINTN   Bit;
+
+  Crc = 0xFFFFFFFF;
+  while (Length-- != 0) {
+    Crc ^= *Buffer++;
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (Crc >> 1) ^ (0xEDB88320 & (0 - (Crc & 1)));
+    }
+  }
+
+  return Crc ^ 0xFFFFFFFF;
+}
+
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+
+// AsmCpuid () hook that executes the real CPUID instruction, so that
+// CalculateCrc32 () finds PCLMULQDQ when the host has it
+STATIC
+UINT32
+EFIAPI
+HostAsmCpuid (
+  IN      UINT32  Index,
+  OUT     UINT32  *Eax   OPTIONAL,
+  OUT     UINT32  *Ebx   OPTIONAL,
+  OUT     UINT32  *Ecx   OPTIONAL,
+  OUT     UINT32  *Edx   OPTIONAL
+  )
+{
+  UINT32  Regs[4];
+
+ #if defined (_MSC_VER)
+  __cpuid ((int *)Regs, (int)Index);
+ #else
+  __cpuid (Index, Regs[0], Regs[1], Regs[2], Regs[3]);
+ #endif
+
+  if (Eax != NULL) {
+    *Eax = Regs[0];
+  }
+
+  if (Ebx != NULL) {
+    *Ebx = Regs[1];
+  }
+
+  if (Ecx != NULL) {
+    *Ecx = Regs[2];
+  }
+
+  if (Edx != NULL) {
+    *Edx = Regs[3];
+  }
+
+  return Index;
+}
+
+#endif
+
+TEST (Crc32, BasicCheck) {
+  // Note: The magic numbers below are precomputed checksums
+  // Check for basic operation on even and odd numbers of bytes
+  EXPECT_EQ (CalculateCrc32 ((VOID *)"hello", 5), mHelloCrc32);
+  EXPECT_EQ (CalculateCrc32 ((VOID *)"123456789", 9), 0xCBF43926);
+  EXPECT_EQ (CalculateCrc32 ((VOID *)"h", 1), 0x916B06E7);
+
+  // Check if a checksum with no bytes correctly yields 0
+  EXPECT_EQ (CalculateCrc32 ((VOID *)"", 0), 0U);
+}
+
+TEST (Crc32, LongBufferCheck) {
+  // Cover the eight bytes at a time loop and its byte sized tail at every
+  // alignment. All lengths stay below 4 KB, so only the tables are used.
+  UINT8  Buffer[SIZE_4KB + 8];
+  UINTN  Index;
+  UINTN  Offset;
+  UINTN  Length;
+
+  for (Index = 0; Index < sizeof (Buffer); Index++) {
+    Buffer[Index] = (UINT8)(Index * 131 + (Index >> 8));
+  }
+
+  for (Offset = 0; Offset < 8; Offset++) {
+    for (Length = 0; Length <= SIZE_4KB; Length += (Length < 80) ? 1 : 61) {
+      EXPECT_EQ (CalculateCrc32 (&Buffer[Offset], Length), ReferenceCrc32 (&Buffer[Offset], Length));
+    }
+  }
+}
+
+TEST (Crc32, CpuCrc32Check) {
+  // Buffers of 4 KB and more are checksummed with CPU CRC32 instructions when
+  // the processor has them. Let CalculateCrc32 () see the host CPU and check
+  // every 16 byte tail length at every alignment, plus a few larger buffers.
+  // Hosts without the instructions exercise the tables instead. The feature
+  // check is cached, so no earlier test may checksum 4 KB or more.
+  STATIC CONST UINTN  LargeLengths[] = { SIZE_4KB * 3 + 5, SIZE_64KB + 13, SIZE_256KB + 1 };
+  std::vector<UINT8>  Buffer (SIZE_256KB + 32);
+  UINTN               Index;
+  UINTN               Offset;
+  UINTN               Length;
+
+  for (Index = 0; Index < Buffer.size (); Index++) {
+    Buffer[Index] = (UINT8)(Index * 131 + (Index >> 8));
+  }
+
+ #if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+  UNIT_TEST_HOST_BASE_LIB_ASM_CPUID  SavedAsmCpuid;
+
+  SavedAsmCpuid                      = gUnitTestHostBaseLib.X86->AsmCpuid;
+  gUnitTestHostBaseLib.X86->AsmCpuid = HostAsmCpuid;
+ #endif
+
+  for (Offset = 0; Offset < 16; Offset++) {
+    for (Length = SIZE_4KB; Length < SIZE_4KB + 80; Length++) {
+      EXPECT_EQ (CalculateCrc32 (&Buffer[Offset], Length), ReferenceCrc32 (&Buffer[Offset], Length));
+    }
+
+    for (Index = 0; Index < ARRAY_SIZE (LargeLengths); Index++) {
+      Length = LargeLengths[Index];
+      EXPECT_EQ (CalculateCrc32 (&Buffer[Offset], Length), ReferenceCrc32 (&Buffer[Offset], Length));
+    }
+  }
+
+ #if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+  gUnitTestHostBaseLib.X86->AsmCpuid = SavedAsmCpuid;
+ #endif
+}
+
 TEST (Crc32c, BasicCheck) {
   // Note: The magic numbers below are precomputed checksums
   // Check for basic operation on even and odd numbers of bytes
@@ -0,0 +1,451 @@
+/** @file
+  Measure the sequential read throughput of block devices, through
+  EFI_BLOCK_IO_PROTOCOL (synchronous, one request at a time) and through
+  EFI_BLOCK_IO2_PROTOCOL (asynchronous, several requests in flight).
+
+  Meant to be run from the UEFI shell in a QEMU guest, for example against a
+  virtio-blk disk or an emulated NVMe controller ("-device nvme"):
+
+    BlockIoBenchmark [-s TotalMiB] [-c ChunkKiB] [-q QueueDepth]
+
+  Without -c, the benchmark is repeated for a range of chunk sizes, up to
+  several MiB, in order to show how the throughput scales with the size of
+  the transfers.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>                  // StrDecimalToUintn()
+#include <Library/BaseMemoryLib.h>            // ZeroMem()
+#include <Library/MemoryAllocationLib.h>      // AllocatePages()
+#include <Library/ShellCEntryLib.h>           // ShellAppMain()
+#include <Library/TimerLib.h>                 // GetPerformanceCounter()
+#include <Library/UefiBootServicesTableLib.h> // gBS
+#include <Library/UefiLib.h>                  // Print()
+#include <Protocol/BlockIo.h>                 // EFI_BLOCK_IO_PROTOCOL
+#include <Protocol/BlockIo2.h>                // EFI_BLOCK_IO2_PROTOCOL
+
+#define DEFAULT_TOTAL_MIB     256
+#define DEFAULT_QUEUE_DEPTH   32
+#define MAX_QUEUE_DEPTH       256
+#define MAX_IN_FLIGHT_BYTES   SIZE_64MB
+
+STATIC CONST UINTN  mDefaultChunkSizes[] = {
+  SIZE_64KB, SIZE_256KB, SIZE_1MB, SIZE_4MB
+};
+
+typedef struct {
+  UINTN    TotalSize;
+  UINTN    ChunkSize;
+  UINTN    QueueDepth;
+} BENCHMARK_PARAMS;
+
+typedef struct {
+  EFI_BLOCK_IO2_TOKEN    Token;
+  VOID                   *Buffer;
+  BOOLEAN                InFlight;
+} BENCHMARK_REQUEST;
+
+/**
+  Return the time elapsed since a performance counter value, in nanoseconds.
+
+  @param[in] Start  The performance counter value at the start of the
+                    measurement.
+
+  @return  The elapsed time in nanoseconds.
+**/
+STATIC
+UINT64
+ElapsedNs (
+  IN UINT64  Start
+  )
+{
+  UINT64  End;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  End = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    //
+    // The counter counts down.
+    //
+    return GetTimeInNanoSecond (Start - End);
+  }
+
+  return GetTimeInNanoSecond (End - Start);
+}
+
+/**
+  Print a throughput figure in MiB/s.
+
+  @param[in] Label      The name of the access method measured.
+  @param[in] Bytes      The number of bytes transferred.
+  @param[in] ElapsedNs  The time the transfer took, in nanoseconds.
+**/
+STATIC
+VOID
+PrintThroughput (
+  IN CONST CHAR16  *Label,
+  IN UINT64        Bytes,
+  IN UINT64        ElapsedNs
+  )
+{
+  UINT64  KibPerSec;
+
+  if (ElapsedNs == 0) {
+    ElapsedNs = 1;
+  }
+
+  KibPerSec = DivU64x64Remainder (MultU64x32 (Bytes, 1000000000 / SIZE_1KB), ElapsedNs, NULL);
+  Print (
+    L"  %-6s %6Lu.%02Lu MiB/s (%Lu bytes in %Lu us)\n",
+    Label,
+    DivU64x32 (KibPerSec, SIZE_1KB),
+    DivU64x32 (MultU64x32 (KibPerSec % SIZE_1KB, 100), SIZE_1KB),
+    Bytes,
+    DivU64x32 (ElapsedNs, 1000)
+    );
+}
+
+/**
+  Read the first TotalSize bytes of a device with EFI_BLOCK_IO_PROTOCOL, one
+  chunk at a time.
+
+  @param[in] BlockIo    The device to read.
+  @param[in] Params     The benchmark parameters.
+  @param[in] Buffer     A buffer of at least Params->ChunkSize bytes.
+  @param[out] Bytes     The number of bytes read.
+  @param[out] Elapsed   The time the reads took, in nanoseconds.
+
+  @retval EFI_SUCCESS   All reads completed.
+  @return               Error codes from ReadBlocks().
+**/
+STATIC
+EFI_STATUS
+BenchmarkSync (
+  IN  EFI_BLOCK_IO_PROTOCOL   *BlockIo,
+  IN  CONST BENCHMARK_PARAMS  *Params,
+  IN  VOID                    *Buffer,
+  OUT UINT64                  *Bytes,
+  OUT UINT64                  *Elapsed
+  )
+{
+  EFI_STATUS  Status;
+  EFI_LBA     Lba;
+  UINTN       BlocksPerChunk;
+  UINT64      Offset;
+  UINT64      Start;
+
+  BlocksPerChunk = Params->ChunkSize / BlockIo->Media->BlockSize;
+  Lba            = 0;
+  Status         = EFI_SUCCESS;
+
+  Start = GetPerformanceCounter ();
+  for (Offset = 0; Offset < Params->TotalSize; Offset += Params->ChunkSize) {
+    Status = BlockIo->ReadBlocks (
+                        BlockIo,
+                        BlockIo->Media->MediaId,
+                        Lba,
+                        Params->ChunkSize,
+                        Buffer
+                        );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Lba += BlocksPerChunk;
+  }
+
+  *Elapsed = ElapsedNs (Start);
+  *Bytes   = Offset;
+  return Status;
+}
+
+/**
+  Read the first TotalSize bytes of a device with EFI_BLOCK_IO2_PROTOCOL,
+  keeping up to QueueDepth chunk reads in flight.
+
+  @param[in] BlockIo2   The device to read.
+  @param[in] Params     The benchmark parameters.
+  @param[in] Requests   Params->QueueDepth requests, each with a buffer of at
+                        least Params->ChunkSize bytes and an event.
+  @param[out] Bytes     The number of bytes read.
+  @param[out] Elapsed   The time the reads took, in nanoseconds.
+
+  @retval EFI_SUCCESS   All reads completed.
+  @return               Error codes from ReadBlocksEx(), or from the
+                        completion of a read.
+**/
+STATIC
+EFI_STATUS
+BenchmarkAsync (
+  IN  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2,
+  IN  CONST BENCHMARK_PARAMS  *Params,
+  IN  BENCHMARK_REQUEST       *Requests,
+  OUT UINT64                  *Bytes,
+  OUT UINT64                  *Elapsed
+  )
+{
+  EFI_STATUS  Status;
+  EFI_LBA     Lba;
+  UINTN       BlocksPerChunk;
+  UINT64      Submitted;
+  UINT64      Completed;
+  UINTN       InFlight;
+  UINTN       Index;
+  UINT64      Start;
+
+  BlocksPerChunk = Params->ChunkSize / BlockIo2->Media->BlockSize;
+  Lba            = 0;
+  Submitted      = 0;
+  Completed      = 0;
+  InFlight       = 0;
+  Status         = EFI_SUCCESS;
+
+  Start = GetPerformanceCounter ();
+  for ( ; ;) {
+    for (Index = 0; Index < Params->QueueDepth; Index++) {
+      if (Requests[Index].InFlight) {
+        if (gBS->CheckEvent (Requests[Index].Token.Event) != EFI_SUCCESS) {
+          continue;
+        }
+
+        Requests[Index].InFlight = FALSE;
+        InFlight--;
+        if (EFI_ERROR (Requests[Index].Token.TransactionStatus)) {
+          Status = Requests[Index].Token.TransactionStatus;
+        } else {
+          Completed += Params->ChunkSize;
+        }
+      }
+
+      if (EFI_ERROR (Status) || (Submitted >= Params->TotalSize)) {
+        continue;
+      }
+
+      Requests[Index].Token.TransactionStatus = EFI_NOT_READY;
+      Status                                  = BlockIo2->ReadBlocksEx (
+                                                            BlockIo2,
+                                                            BlockIo2->Media->MediaId,
+                                                            Lba,
+                                                            &Requests[Index].Token,
+                                                            Params->ChunkSize,
+                                                            Requests[Index].Buffer
+                                                            );
+      if (EFI_ERROR (Status)) {
+        continue;
+      }
+
+      Requests[Index].InFlight = TRUE;
+      InFlight++;
+      Submitted += Params->ChunkSize;
+      Lba       += BlocksPerChunk;
+    }
+
+    if ((InFlight == 0) && (EFI_ERROR (Status) || (Submitted >= Params->TotalSize))) {
+      break;
+    }
+  }
+
+  *Elapsed = ElapsedNs (Start);
+  *Bytes   = Completed;
+  return Status;
+}
+
+/**
+  Run the benchmark on one device.
+
+  @param[in] Handle   The handle carrying both EFI_BLOCK_IO_PROTOCOL and
+                      EFI_BLOCK_IO2_PROTOCOL.
+  @param[in] Params   The benchmark parameters.
+**/
+STATIC
+VOID
+BenchmarkDevice (
+  IN EFI_HANDLE              Handle,
+  IN CONST BENCHMARK_PARAMS  *Params
+  )
+{
+  EFI_STATUS              Status;
+  EFI_BLOCK_IO_PROTOCOL   *BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  BENCHMARK_PARAMS        DeviceParams;
+  BENCHMARK_REQUEST       *Requests;
+  UINT64                  DeviceSize;
+  UINT64                  Bytes;
+  UINT64                  Elapsed;
+  UINTN                   Index;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIoProtocolGuid, (VOID **)&BlockIo);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIo2ProtocolGuid, (VOID **)&BlockIo2);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  if (!BlockIo->Media->MediaPresent || BlockIo->Media->LogicalPartition ||
+      (Params->ChunkSize % BlockIo->Media->BlockSize != 0))
+  {
+    return;
+  }
+
+  CopyMem (&DeviceParams, Params, sizeof DeviceParams);
+  DeviceSize = MultU64x32 (BlockIo->Media->LastBlock + 1, BlockIo->Media->BlockSize);
+  if (DeviceParams.TotalSize > DeviceSize) {
+    DeviceParams.TotalSize = (UINTN)DeviceSize;
+  }
+
+  DeviceParams.TotalSize -= DeviceParams.TotalSize % DeviceParams.ChunkSize;
+
+  //
+  // Bound the memory taken up by the buffers of the requests in flight.
+  //
+  DeviceParams.QueueDepth = MIN (
+                              DeviceParams.QueueDepth,
+                              MAX (MAX_IN_FLIGHT_BYTES / DeviceParams.ChunkSize, 1)
+                              );
+
+  if (DeviceParams.TotalSize == 0) {
+    return;
+  }
+
+  Print (
+    L"Handle %p: BlockSize %u, %Lu bytes, chunk %Lu bytes, queue depth %Lu\n",
+    Handle,
+    BlockIo->Media->BlockSize,
+    (UINT64)DeviceParams.TotalSize,
+    (UINT64)DeviceParams.ChunkSize,
+    (UINT64)DeviceParams.QueueDepth
+    );
+
+  Requests = AllocateZeroPool (DeviceParams.QueueDepth * sizeof *Requests);
+  if (Requests == NULL) {
+    Print (L"  out of memory\n");
+    return;
+  }
+
+  for (Index = 0; Index < DeviceParams.QueueDepth; Index++) {
+    Requests[Index].Buffer = AllocatePages (EFI_SIZE_TO_PAGES (DeviceParams.ChunkSize));
+    if (Requests[Index].Buffer == NULL) {
+      Print (L"  out of memory\n");
+      goto FreeRequests;
+    }
+
+    Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Requests[Index].Token.Event);
+    if (EFI_ERROR (Status)) {
+      Print (L"  CreateEvent: %r\n", Status);
+      goto FreeRequests;
+    }
+  }
+
+  Status = BenchmarkSync (BlockIo, &DeviceParams, Requests[0].Buffer, &Bytes, &Elapsed);
+  if (EFI_ERROR (Status)) {
+    Print (L"  sync read failed: %r\n", Status);
+  } else {
+    PrintThroughput (L"sync", Bytes, Elapsed);
+  }
+
+  Status = BenchmarkAsync (BlockIo2, &DeviceParams, Requests, &Bytes, &Elapsed);
+  if (EFI_ERROR (Status)) {
+    Print (L"  async read failed: %r\n", Status);
+  } else {
+    PrintThroughput (L"async", Bytes, Elapsed);
+  }
+
+FreeRequests:
+  for (Index = 0; Index < DeviceParams.QueueDepth; Index++) {
+    if (Requests[Index].Token.Event != NULL) {
+      gBS->CloseEvent (Requests[Index].Token.Event);
+    }
+
+    if (Requests[Index].Buffer != NULL) {
+      FreePages (Requests[Index].Buffer, EFI_SIZE_TO_PAGES (DeviceParams.ChunkSize));
+    }
+  }
+
+  FreePool (Requests);
+}
+
+/**
+  Entry point of the application.
+
+  @param[in] Argc  The number of command line arguments.
+  @param[in] Argv  The command line arguments.
+
+  @retval 0  The benchmark ran.
+  @retval 1  Invalid command line, or no device to run the benchmark on.
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN   Argc,
+  IN CHAR16  **Argv
+  )
+{
+  EFI_STATUS        Status;
+  BENCHMARK_PARAMS  Params;
+  EFI_HANDLE        *Handles;
+  UINTN             NumHandles;
+  UINTN             Index;
+  UINTN             ChunkIndex;
+  UINTN             Value;
+
+  Params.TotalSize  = DEFAULT_TOTAL_MIB * SIZE_1MB;
+  Params.ChunkSize  = 0;
+  Params.QueueDepth = DEFAULT_QUEUE_DEPTH;
+
+  for (Index = 1; Index + 1 < Argc; Index += 2) {
+    Value = StrDecimalToUintn (Argv[Index + 1]);
+    if (Value == 0) {
+      break;
+    }
+
+    if (StrCmp (Argv[Index], L"-s") == 0) {
+      Params.TotalSize = Value * SIZE_1MB;
+    } else if (StrCmp (Argv[Index], L"-c") == 0) {
+      Params.ChunkSize = Value * SIZE_1KB;
+    } else if (StrCmp (Argv[Index], L"-q") == 0) {
+      Params.QueueDepth = MIN (Value, MAX_QUEUE_DEPTH);
+    } else {
+      break;
+    }
+  }
+
+  if (Index != Argc) {
+    Print (L"Usage: %s [-s TotalMiB] [-c ChunkKiB] [-q QueueDepth]\n", Argv[0]);
+    return 1;
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiBlockIo2ProtocolGuid,
+                  NULL,
+                  &NumHandles,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    Print (L"No EFI_BLOCK_IO2_PROTOCOL instance found: %r\n", Status);
+    return 1;
+  }
+
+  for (Index = 0; Index < NumHandles; Index++) {
+    if (Params.ChunkSize != 0) {
+      BenchmarkDevice (Handles[Index], &Params);
+      continue;
+    }
+
+    for (ChunkIndex = 0; ChunkIndex < ARRAY_SIZE (mDefaultChunkSizes); ChunkIndex++) {
+      Params.ChunkSize = mDefaultChunkSizes[ChunkIndex];
+      BenchmarkDevice (Handles[Index], &Params);
+    }
+
+    Params.ChunkSize = 0;
+  }
+
+  FreePool (Handles);
+  return 0;
+}
@@ -33,6 +33,9 @@ typedef struct {
   UINT8                  Sectors;
   UINT32                 BlkSize;
   VIRTIO_BLK_TOPOLOGY    Topology;
+  UINT8                  WriteBack;
+  UINT8                  Unused0;
+  UINT16                 NumQueues;
 } VIRTIO_BLK_CONFIG;
 #pragma pack()
 
@@ -52,6 +55,7 @@ typedef struct {
 #define VIRTIO_BLK_F_SCSI      BIT7
 #define VIRTIO_BLK_F_FLUSH     BIT9  // identical to "write cache enabled"
 #define VIRTIO_BLK_F_TOPOLOGY  BIT10 // information on optimal I/O alignment
+#define VIRTIO_BLK_F_MQ        BIT12 // multiple request queues
 
 //
 // We keep the status byte separate from the rest of the virtio-blk request
@@ -6,9 +6,12 @@
 
   - No attach/detach (ie. removable media).
 
-  - Although the non-blocking interfaces of EFI_BLOCK_IO2_PROTOCOL could be a
-    good match for multiple in-flight virtio-blk requests, we stick to
-    synchronous requests and EFI_BLOCK_IO_PROTOCOL for now.
+  - EFI_BLOCK_IO2_PROTOCOL keeps up to VBLK_MAX_PENDING requests in flight on
+    each request queue; up to VBLK_MAX_QUEUES request queues are used with
+    VIRTIO_BLK_F_MQ. Completions are polled from a timer; virtio interrupts
+    are not used. Indirect descriptors are used if the device offers them, so
+    that every request takes up a single ring descriptor, and the data buffer
+    of a request may be scattered over VIRTIO_BLK_F_SEG_MAX descriptors.
 
   Copyright (C) 2012, Red Hat, Inc.
   Copyright (c) 2012 - 2018, Intel Corporation. All rights reserved.<BR>
@@ -177,300 +180,840 @@ VerifyReadWriteRequest (
 
 /**
 
-  Format a read / write / flush request as three consecutive virtio
-  descriptors, push them to the host, and poll for the response.
+  Release a ReadBlocks(Ex) / WriteBlocks(Ex) / FlushBlocks(Ex) call to the
+  free list of the device, for reuse by VirtioBlkStartIo().
 
-  This is the main workhorse function. Two use cases are supported, read/write
-  and flush. The function may only be called after the request parameters have
-  been verified by
-  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
-  - VerifyReadWriteRequest() (for read/write only).
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
 
-  Parameters handled commonly:
+  @param[in,out] Dev  The virtio-blk device the call was targeted at.
 
-    @param[in] Dev             The virtio-blk device the request is targeted
-                               at.
+  @param[in] Io       The call to release.
 
-  Flush request:
+**/
+STATIC
+VOID
+VirtioBlkReleaseIo (
+  IN OUT VBLK_DEV  *Dev,
+  IN     VBLK_IO   *Io
+  )
+{
+  Io->NextFree = Dev->FreeIo;
+  Dev->FreeIo  = Io;
+}
 
-    @param[in] Lba             Must be zero.
+/**
 
-    @param[in] BufferSize      Must be zero.
+  Drop a reference to a ReadBlocks(Ex) / WriteBlocks(Ex) / FlushBlocks(Ex)
+  call, recording the outcome of one of its requests.
 
-    @param[in out] Buffer      Ignored by the function.
+  When the last reference is dropped, the token of an asynchronous call is
+  signaled, and the call is released. Synchronous calls keep a reference until
+  the submitter has fetched the status, except when they are abandoned.
 
-    @param[in] RequestIsWrite  Must be TRUE.
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
 
-  Read/Write request:
+  @param[in,out] Dev     The virtio-blk device the call is targeted at.
 
-    @param[in] Lba             Logical Block Address: number of logical blocks
-                               to skip from the beginning of the device.
+  @param[in,out] Io      The call to drop the reference to.
 
-    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
-                               is responsible to ensure this parameter is
-                               positive.
+  @param[in] Status      The outcome of the request that held the reference.
 
-    @param[in out] Buffer      The guest side area to read data from the device
-                               into, or write data to the device from.
+**/
+STATIC
+VOID
+VirtioBlkPutIo (
+  IN OUT VBLK_DEV    *Dev,
+  IN OUT VBLK_IO     *Io,
+  IN     EFI_STATUS  Status
+  )
+{
+  if (EFI_ERROR (Status) && !EFI_ERROR (Io->Status)) {
+    Io->Status = Status;
+  }
 
-    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
-                               device.
+  ASSERT (Io->Pending > 0);
+  if (--Io->Pending > 0) {
+    return;
+  }
 
-  Return values are common to both use cases, and are appropriate to be
-  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
-  WriteBlocks(), FlushBlocks()).
+  if (Io->Token != NULL) {
+    Io->Token->TransactionStatus = Io->Status;
+    gBS->SignalEvent (Io->Token->Event);
 
+    if (--Dev->AsyncPending == 0) {
+      gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
+    }
+  }
 
-  @retval EFI_SUCCESS          Transfer complete.
+  VirtioBlkReleaseIo (Dev, Io);
+}
 
-  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
-                               unable to parse host response, or host response
-                               is not VIRTIO_BLK_S_OK or failed to map Buffer
-                               for a bus master operation.
+/**
+
+  Reap the requests that the host has completed on a request queue since the
+  last call.
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev    The virtio-blk device whose request queue is polled.
+
+  @param[in,out] Queue  The request queue to poll.
+
+**/
+STATIC
+VOID
+VirtioBlkCompleteQueue (
+  IN OUT VBLK_DEV    *Dev,
+  IN OUT VBLK_QUEUE  *Queue
+  )
+{
+  UINT16                          CurUsed;
+  volatile CONST VRING_USED_ELEM  *UsedElem;
+  UINT32                          SlotIdx;
+  VBLK_REQ_SLOT                   *Slot;
+  VBLK_IO                         *Io;
+  EFI_STATUS                      Status;
+  EFI_STATUS                      UnmapStatus;
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  CurUsed = *Queue->Ring.Used.Idx;
+  MemoryFence ();
+
+  while (Queue->LastUsed != CurUsed) {
+    UsedElem = &Queue->Ring.Used.UsedElem[Queue->LastUsed++ % Queue->Ring.QueueSize];
+    SlotIdx  = Dev->IndirectDesc ? UsedElem->Id : UsedElem->Id / VBLK_DESC_PER_REQ;
+    ASSERT (SlotIdx < Queue->MaxPending);
+    Slot = &Queue->Slots[SlotIdx];
+
+    Status = (Queue->SharedReq[SlotIdx].HostStatus == VIRTIO_BLK_S_OK) ?
+             EFI_SUCCESS :
+             EFI_DEVICE_ERROR;
+
+    while (Slot->NumMappings > 0) {
+      UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (
+                                   Dev->VirtIo,
+                                   Slot->Mappings[--Slot->NumMappings]
+                                   );
+      if (EFI_ERROR (UnmapStatus) && !Slot->RequestIsWrite) {
+        //
+        // Data from the bus master may not reach the caller; fail the request.
+        //
+        Status = EFI_DEVICE_ERROR;
+      }
+    }
+
+    Io                                    = Slot->Io;
+    Slot->Io                              = NULL;
+    Queue->FreeStack[--Queue->CurPending] = (UINT16)SlotIdx;
+
+    VirtioBlkPutIo (Dev, Io, Status);
+  }
+}
+
+/**
+
+  Reap the requests that the host has completed on any request queue since
+  the last call.
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev  The virtio-blk device whose request queues are polled.
+
+**/
+STATIC
+VOID
+VirtioBlkCompleteRequests (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  UINT16  QueueIdx;
+
+  for (QueueIdx = 0; QueueIdx < Dev->NumQueues; ++QueueIdx) {
+    VirtioBlkCompleteQueue (Dev, &Dev->Queues[QueueIdx]);
+  }
+}
+
+/**
+
+  Wait a little for the host to process requests, then reap the completed
+  ones.
+
+  The wait period keeps doubling until it reaches slightly above 1 ms, like
+  in VirtioFlush().
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev              The virtio-blk device to poll.
+
+  @param[in,out] PollPeriodUsecs  The period to wait, in microseconds. Updated
+                                  for the next call.
+
+**/
+STATIC
+VOID
+VirtioBlkPollRequests (
+  IN OUT VBLK_DEV  *Dev,
+  IN OUT UINTN     *PollPeriodUsecs
+  )
+{
+  gBS->Stall (*PollPeriodUsecs);
+  if (*PollPeriodUsecs < 1024) {
+    *PollPeriodUsecs *= 2;
+  }
+
+  VirtioBlkCompleteRequests (Dev);
+}
+
+/**
+
+  Return the number of requests in flight on all request queues.
+
+  @param[in] Dev  The virtio-blk device.
+
+**/
+STATIC
+UINTN
+VirtioBlkCurPending (
+  IN CONST VBLK_DEV  *Dev
+  )
+{
+  UINT16  QueueIdx;
+  UINTN   CurPending;
+
+  CurPending = 0;
+  for (QueueIdx = 0; QueueIdx < Dev->NumQueues; ++QueueIdx) {
+    CurPending += Dev->Queues[QueueIdx].CurPending;
+  }
+
+  return CurPending;
+}
+
+/**
+
+  Wait until no request is in flight anymore.
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev  The virtio-blk device to drain.
+
+**/
+STATIC
+VOID
+VirtioBlkDrainRequests (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  UINTN  PollPeriodUsecs;
+
+  PollPeriodUsecs = 1;
+  VirtioBlkCompleteRequests (Dev);
+  while (VirtioBlkCurPending (Dev) > 0) {
+    VirtioBlkPollRequests (Dev, &PollPeriodUsecs);
+  }
+}
+
+/**
+
+  Return the least busy request queue that has a free request slot, waiting
+  for a slot to be released if necessary.
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+  @return  The selected request queue.
+
+**/
+STATIC
+VBLK_QUEUE *
+VirtioBlkSelectQueue (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  UINTN       PollPeriodUsecs;
+  UINT16      QueueIdx;
+  VBLK_QUEUE  *Queue;
+  VBLK_QUEUE  *Best;
+
+  PollPeriodUsecs = 1;
+  VirtioBlkCompleteRequests (Dev);
+  for ( ; ;) {
+    Best = NULL;
+    for (QueueIdx = 0; QueueIdx < Dev->NumQueues; ++QueueIdx) {
+      Queue = &Dev->Queues[QueueIdx];
+      if ((Queue->CurPending < Queue->MaxPending) &&
+          ((Best == NULL) || (Queue->CurPending < Best->CurPending)))
+      {
+        Best = Queue;
+      }
+    }
+
+    if (Best != NULL) {
+      return Best;
+    }
+
+    VirtioBlkPollRequests (Dev, &PollPeriodUsecs);
+  }
+}
+
+/**
+
+  Format a read / write / flush request as a chain of virtio descriptors and
+  push it to the host, without waiting for the response.
+
+  The descriptor chain consists of the request header, the data buffer (for
+  read/write only), and the host status. If VIRTIO_F_RING_INDIRECT_DESC has
+  been negotiated, the chain lives in the indirect descriptor table of the
+  request slot, the request consumes a single descriptor of the ring, and the
+  data buffer may be scattered over up to Dev->MaxSegments descriptors of at
+  most Dev->SegmentSizeMax bytes each. Every piece of the data buffer that
+  VIRTIO_DEVICE_PROTOCOL.MapSharedBuffer() maps is described in place, so no
+  bounce buffer is needed unless the IOMMU demands it.
+
+  The request may cover only the start of the data buffer, up to
+  Dev->MaxTransfer bytes, or less if the buffer could only be mapped in
+  parts. The caller submits the rest with further requests.
+
+  This function may only be called after the request parameters have been
+  verified by
+  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
+  - VerifyReadWriteRequest() (for read/write only).
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev         The virtio-blk device the request is targeted at.
+
+  @param[in,out] Io          The call the request belongs to. Io->Pending is
+                             incremented once the request is visible to the
+                             host.
+
+  @param[in] Lba             Logical Block Address: number of logical blocks
+                             to skip from the beginning of the device. Zero
+                             for flush.
+
+  @param[in] BufferSize      Size of buffer to transfer, in bytes. Zero for
+                             flush.
+
+  @param[in,out] Buffer      The guest side area to read data from the device
+                             into, or write data to the device from. Ignored
+                             for flush.
+
+  @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to device.
+                             Must be TRUE for flush.
+
+  @param[out] Submitted      On success, the number of bytes from the start of
+                             Buffer that the request covers.
+
+  @retval EFI_SUCCESS        The request has been submitted.
+
+  @retval EFI_DEVICE_ERROR   Failed to map Buffer for a bus master operation;
+                             the request has not been submitted. Or, failed to
+                             notify the host via VirtIo write; the request may
+                             still be processed by the host, and Io->Abandoned
+                             is set.
 
 **/
 STATIC
 EFI_STATUS
-EFIAPI
-SynchronousRequest (
-  IN              VBLK_DEV  *Dev,
+VirtioBlkSubmitRequest (
+  IN OUT          VBLK_DEV  *Dev,
+  IN OUT          VBLK_IO   *Io,
   IN              EFI_LBA   Lba,
   IN              UINTN     BufferSize,
   IN OUT volatile VOID      *Buffer,
-  IN              BOOLEAN   RequestIsWrite
+  IN              BOOLEAN   RequestIsWrite,
+  OUT             UINTN     *Submitted
   )
 {
-  UINT32                   BlockSize;
-  volatile VIRTIO_BLK_REQ  *Request;
-  volatile UINT8           *HostStatus;
-  VOID                     *HostStatusBuffer;
-  DESC_INDICES             Indices;
-  VOID                     *RequestMapping;
-  VOID                     *StatusMapping;
-  VOID                     *BufferMapping;
-  EFI_PHYSICAL_ADDRESS     BufferDeviceAddress;
-  EFI_PHYSICAL_ADDRESS     HostStatusDeviceAddress;
-  EFI_PHYSICAL_ADDRESS     RequestDeviceAddress;
-  EFI_STATUS               Status;
-  EFI_STATUS               UnmapStatus;
-  EFI_TPL                  CurrentTpl;
+  UINT32                BlockSize;
+  VBLK_QUEUE            *Queue;
+  UINT16                Idx;
+  VBLK_SHARED_REQ       *SharedReq;
+  VBLK_REQ_SLOT         *Slot;
+  EFI_PHYSICAL_ADDRESS  SharedReqDeviceAddress;
+  EFI_PHYSICAL_ADDRESS  BufferDeviceAddress;
+  VOID                  *BufferMapping;
+  UINTN                 Target;
+  UINTN                 Described;
+  UINTN                 MapSize;
+  UINTN                 MapRequested;
+  UINTN                 SegmentOffset;
+  UINT32                SegmentSize;
+  volatile VRING_DESC   *Desc;
+  UINT16                DescBase;
+  UINT16                NumDesc;
+  UINT16                HeadDescIdx;
+  UINT16                AvailIdx;
+  EFI_STATUS            Status;
 
   BlockSize = Dev->BlockIoMedia.BlockSize;
 
-  //
-  // Set BufferMapping and BufferDeviceAddress to suppress incorrect
-  // compiler/analyzer warnings.
-  //
-  BufferMapping       = NULL;
-  BufferDeviceAddress = 0;
-
   //
   // ensured by VirtioBlkInit()
   //
   ASSERT (BlockSize > 0);
   ASSERT (BlockSize % 512 == 0);
+  ASSERT (Dev->MaxTransfer >= BlockSize);
+  ASSERT (Dev->MaxTransfer % BlockSize == 0);
 
   //
   // ensured by contract above, plus VerifyReadWriteRequest()
   //
   ASSERT (BufferSize % BlockSize == 0);
 
-  Request = AllocateZeroPool (sizeof (*Request));
-  if (Request == NULL) {
-    return EFI_DEVICE_ERROR;
+  Queue     = VirtioBlkSelectQueue (Dev);
+  Idx       = Queue->FreeStack[Queue->CurPending];
+  SharedReq = &Queue->SharedReq[Idx];
+  Slot      = &Queue->Slots[Idx];
+
+  ASSERT (Slot->NumMappings == 0);
+
+  if (Dev->IndirectDesc) {
+    Desc     = SharedReq->Indirect;
+    DescBase = 0;
+  } else {
+    Desc     = &Queue->Ring.Desc[Idx * VBLK_DESC_PER_REQ];
+    DescBase = (UINT16)(Idx * VBLK_DESC_PER_REQ);
   }
 
   //
-  // Prepare virtio-blk request header, setting zero size for flush.
-  // IO Priority is homogeneously 0.
+  // virtio-blk header in first desc
   //
-  Request->Type = RequestIsWrite ?
-                  (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
-                  VIRTIO_BLK_T_IN;
-  Request->IoPrio = 0;
-  Request->Sector = MultU64x32 (Lba, BlockSize / 512);
+  SharedReqDeviceAddress = Queue->SharedReqBase + Idx * sizeof (VBLK_SHARED_REQ);
+
+  NumDesc             = 0;
+  Desc[NumDesc].Addr  = SharedReqDeviceAddress + OFFSET_OF (VBLK_SHARED_REQ, Request);
+  Desc[NumDesc].Len   = sizeof (VIRTIO_BLK_REQ);
+  Desc[NumDesc].Flags = VRING_DESC_F_NEXT;
+  Desc[NumDesc].Next  = (UINT16)(DescBase + NumDesc + 1);
+  NumDesc++;
 
   //
-  // Host status is bi-directional (we preset with a value and expect the
-  // device to update it). Allocate a host status buffer which can be mapped
-  // to access equally by both processor and the device.
+  // data buffer for read/write in the following descs
   //
-  Status = Dev->VirtIo->AllocateSharedPages (
-                          Dev->VirtIo,
-                          EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                          &HostStatusBuffer
-                          );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeBlkRequest;
+  // From virtio-0.9.5, 2.3.2 Descriptor Table: "no descriptor chain may be
+  // more than 2^32 bytes long in total". Dev->MaxTransfer is at most 1 GB.
+  //
+  Target    = MIN (BufferSize, Dev->MaxTransfer);
+  Described = 0;
+  while (Described < Target) {
+    //
+    // Map as much of the rest of the request as the remaining descriptors can
+    // describe, in whole blocks.
+    //
+    MapRequested = (UINTN)MIN (
+                            (UINT64)(Target - Described),
+                            MultU64x32 ((UINT64)(Dev->MaxSegments - (NumDesc - 1)), Dev->SegmentSizeMax)
+                            );
+    MapRequested -= MapRequested % BlockSize;
+    if (MapRequested == 0) {
+      break;
+    }
+
+    MapSize = MapRequested;
+    Status  = Dev->VirtIo->MapSharedBuffer (
+                             Dev->VirtIo,
+                             (RequestIsWrite ?
+                              VirtioOperationBusMasterRead :
+                              VirtioOperationBusMasterWrite),
+                             (UINT8 *)Buffer + Described,
+                             &MapSize,
+                             &BufferDeviceAddress,
+                             &BufferMapping
+                             );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if ((MapSize == 0) || (MapSize > MapRequested) || (MapSize % BlockSize != 0)) {
+      //
+      // Only whole blocks can be transferred by a request.
+      //
+      Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
+      break;
+    }
+
+    Slot->Mappings[Slot->NumMappings++] = BufferMapping;
+
+    //
+    // VRING_DESC_F_WRITE is interpreted from the host's point of view.
+    //
+    for (SegmentOffset = 0; SegmentOffset < MapSize; SegmentOffset += SegmentSize) {
+      SegmentSize         = (UINT32)MIN (MapSize - SegmentOffset, Dev->SegmentSizeMax);
+      Desc[NumDesc].Addr  = BufferDeviceAddress + SegmentOffset;
+      Desc[NumDesc].Len   = SegmentSize;
+      Desc[NumDesc].Flags = VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE);
+      Desc[NumDesc].Next  = (UINT16)(DescBase + NumDesc + 1);
+      NumDesc++;
+    }
+
+    Described += MapSize;
   }
 
-  HostStatus = HostStatusBuffer;
+  if (Described < ((BufferSize > 0) ? BlockSize : 0)) {
+    while (Slot->NumMappings > 0) {
+      Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Slot->Mappings[--Slot->NumMappings]);
+    }
 
-  //
-  // Map virtio-blk request header (must be done after request header is
-  // populated)
-  //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterRead,
-             (VOID *)Request,
-             sizeof (*Request),
-             &RequestDeviceAddress,
-             &RequestMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeHostStatusBuffer;
+    return EFI_DEVICE_ERROR;
   }
 
   //
-  // Map data buffer
+  // Prepare virtio-blk request header, setting zero size for flush.
+  // IO Priority is homogeneously 0.
   //
-  if (BufferSize > 0) {
-    Status = VirtioMapAllBytesInSharedBuffer (
-               Dev->VirtIo,
-               (RequestIsWrite ?
-                VirtioOperationBusMasterRead :
-                VirtioOperationBusMasterWrite),
-               (VOID *)Buffer,
-               BufferSize,
-               &BufferDeviceAddress,
-               &BufferMapping
-               );
-    if (EFI_ERROR (Status)) {
-      Status = EFI_DEVICE_ERROR;
-      goto UnmapRequestBuffer;
-    }
-  }
+  SharedReq->Request.Type = RequestIsWrite ?
+                            (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
+                            VIRTIO_BLK_T_IN;
+  SharedReq->Request.IoPrio = 0;
+  SharedReq->Request.Sector = MultU64x32 (Lba, BlockSize / 512);
 
   //
   // preset a host status for ourselves that we do not accept as success
   //
-  *HostStatus = VIRTIO_BLK_S_IOERR;
+  SharedReq->HostStatus = VIRTIO_BLK_S_IOERR;
 
   //
-  // Map the Status Buffer with VirtioOperationBusMasterCommonBuffer so that
-  // both processor and device can access it.
+  // host status in last desc
   //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterCommonBuffer,
-             HostStatusBuffer,
-             sizeof *HostStatus,
-             &HostStatusDeviceAddress,
-             &StatusMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto UnmapDataBuffer;
-  }
+  Desc[NumDesc].Addr  = SharedReqDeviceAddress + OFFSET_OF (VBLK_SHARED_REQ, HostStatus);
+  Desc[NumDesc].Len   = sizeof (SharedReq->HostStatus);
+  Desc[NumDesc].Flags = VRING_DESC_F_WRITE;
+  Desc[NumDesc].Next  = 0;
+  NumDesc++;
 
-  CurrentTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Dev->IndirectDesc) {
+    HeadDescIdx                         = Idx;
+    Queue->Ring.Desc[HeadDescIdx].Addr  = SharedReqDeviceAddress + OFFSET_OF (VBLK_SHARED_REQ, Indirect);
+    Queue->Ring.Desc[HeadDescIdx].Len   = (UINT32)(NumDesc * sizeof (VRING_DESC));
+    Queue->Ring.Desc[HeadDescIdx].Flags = VRING_DESC_F_INDIRECT;
+    Queue->Ring.Desc[HeadDescIdx].Next  = 0;
+  } else {
+    HeadDescIdx = DescBase;
+  }
 
-  VirtioPrepare (&Dev->Ring, &Indices);
+  Slot->Io             = Io;
+  Slot->RequestIsWrite = RequestIsWrite;
+  Queue->CurPending++;
+  Io->Pending++;
 
   //
-  // ensured by VirtioBlkInit() -- this predicate, in combination with the
-  // lock-step progress, ensures we don't have to track free descriptors.
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
   //
-  ASSERT (Dev->Ring.QueueSize >= 3);
+  // The available index is never written by the host, we can read it back
+  // without a barrier.
+  //
+  AvailIdx                                                   = *Queue->Ring.Avail.Idx;
+  Queue->Ring.Avail.Ring[AvailIdx++ % Queue->Ring.QueueSize] = HeadDescIdx;
 
   //
-  // virtio-blk header in first desc
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
   //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    RequestDeviceAddress,
-    sizeof (*Request),
-    VRING_DESC_F_NEXT,
-    &Indices
-    );
+  MemoryFence ();
+  *Queue->Ring.Avail.Idx = AvailIdx;
 
   //
-  // data buffer for read/write in second desc
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device -- gratuitous notifications are
+  // OK. Request queues are numbered from zero.
   //
-  if (BufferSize > 0) {
-    //
-    // From virtio-0.9.5, 2.3.2 Descriptor Table:
-    // "no descriptor chain may be more than 2^32 bytes long in total".
-    //
-    // The predicate is ensured by the call contract above (for flush), or
-    // VerifyReadWriteRequest() (for read/write). It also implies that
-    // converting BufferSize to UINT32 will not truncate it.
-    //
-    ASSERT (BufferSize <= SIZE_1GB);
-
+  MemoryFence ();
+  Status = Dev->VirtIo->SetQueueNotify (
+                          Dev->VirtIo,
+                          (UINT16)(Queue - Dev->Queues)
+                          );
+  if (EFI_ERROR (Status)) {
     //
-    // VRING_DESC_F_WRITE is interpreted from the host's point of view.
+    // The request is visible to the host and cannot be withdrawn. It is
+    // reaped by VirtioBlkCompleteRequests() if the host ever processes it.
     //
-    VirtioAppendDesc (
-      &Dev->Ring,
-      BufferDeviceAddress,
-      (UINT32)BufferSize,
-      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
-      &Indices
-      );
+    Io->Abandoned = TRUE;
+    return EFI_DEVICE_ERROR;
   }
 
-  //
-  // host status in last (second or third) desc
-  //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    HostStatusDeviceAddress,
-    sizeof *HostStatus,
-    VRING_DESC_F_WRITE,
-    &Indices
-    );
+  *Submitted = Described;
+  return EFI_SUCCESS;
+}
 
-  //
-  // virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
-  //
-  if ((VirtioFlush (
-         Dev->VirtIo,
-         0,
-         &Dev->Ring,
-         &Indices,
-         NULL
-         ) == EFI_SUCCESS) &&
-      (*HostStatus == VIRTIO_BLK_S_OK))
-  {
-    Status = EFI_SUCCESS;
+/**
+
+  Submit the requests that carry a read / write / flush call.
+
+  The call is split into several requests if the data buffer is larger than
+  Dev->MaxTransfer, or could only be mapped in parts. A flush request is only
+  submitted after all earlier requests have completed, because the device is
+  only required to flush the writes it has completed.
+
+  The caller is responsible for raising the TPL to TPL_NOTIFY.
+
+  @param[in,out] Dev         The virtio-blk device the call is targeted at.
+
+  @param[in] Lba             See SynchronousRequest().
+
+  @param[in] BufferSize      See SynchronousRequest().
+
+  @param[in,out] Buffer      See SynchronousRequest().
+
+  @param[in] RequestIsWrite  See SynchronousRequest().
+
+  @param[out] Io             On success, the call, with Io->Pending accounting
+                             for the submitter's reference in addition to the
+                             requests in flight.
+
+  @retval EFI_SUCCESS           All requests have been submitted.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @retval EFI_DEVICE_ERROR      A request could not be submitted. Requests
+                                submitted earlier have completed, or have been
+                                abandoned.
+
+**/
+STATIC
+EFI_STATUS
+VirtioBlkStartIo (
+  IN OUT          VBLK_DEV  *Dev,
+  IN              EFI_LBA   Lba,
+  IN              UINTN     BufferSize,
+  IN OUT volatile VOID      *Buffer,
+  IN              BOOLEAN   RequestIsWrite,
+  OUT             VBLK_IO   **Io
+  )
+{
+  VBLK_IO     *NewIo;
+  UINTN       Offset;
+  UINTN       Submitted;
+  UINTN       PollPeriodUsecs;
+  EFI_STATUS  Status;
+
+  NewIo = Dev->FreeIo;
+  if (NewIo != NULL) {
+    Dev->FreeIo = NewIo->NextFree;
+    ZeroMem (NewIo, sizeof *NewIo);
   } else {
-    Status = EFI_DEVICE_ERROR;
+    NewIo = AllocateZeroPool (sizeof *NewIo);
+    if (NewIo == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
 
-  gBS->RestoreTPL (CurrentTpl);
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, StatusMapping);
+  NewIo->Pending = 1;
+  NewIo->Status  = EFI_SUCCESS;
 
-UnmapDataBuffer:
-  if (BufferSize > 0) {
-    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
-    if (EFI_ERROR (UnmapStatus) && !RequestIsWrite && !EFI_ERROR (Status)) {
-      //
-      // Data from the bus master may not reach the caller; fail the request.
-      //
-      Status = EFI_DEVICE_ERROR;
+  if (BufferSize == 0) {
+    VirtioBlkDrainRequests (Dev);
+  }
+
+  Offset = 0;
+  do {
+    Status = VirtioBlkSubmitRequest (
+               Dev,
+               NewIo,
+               Lba + (Offset / Dev->BlockIoMedia.BlockSize),
+               BufferSize - Offset,
+               (UINT8 *)Buffer + Offset,
+               RequestIsWrite,
+               &Submitted
+               );
+    if (EFI_ERROR (Status)) {
+      if (NewIo->Abandoned) {
+        //
+        // Let VirtioBlkCompleteRequests() release NewIo.
+        //
+        VirtioBlkPutIo (Dev, NewIo, Status);
+      } else {
+        //
+        // Don't return until the host is done with the caller's buffer.
+        //
+        PollPeriodUsecs = 1;
+        while (NewIo->Pending > 1) {
+          VirtioBlkPollRequests (Dev, &PollPeriodUsecs);
+        }
+
+        VirtioBlkReleaseIo (Dev, NewIo);
+      }
+
+      return Status;
+    }
+
+    Offset += Submitted;
+  } while (Offset < BufferSize);
+
+  *Io = NewIo;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Submit a read / write / flush request, and poll for the response.
+
+  The function may only be called after the request parameters have been
+  verified by
+  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
+  - VerifyReadWriteRequest() (for read/write only).
+
+  Parameters handled commonly:
+
+    @param[in] Dev             The virtio-blk device the request is targeted
+                               at.
+
+  Flush request:
+
+    @param[in] Lba             Must be zero.
+
+    @param[in] BufferSize      Must be zero.
+
+    @param[in out] Buffer      Ignored by the function.
+
+    @param[in] RequestIsWrite  Must be TRUE.
+
+  Read/Write request:
+
+    @param[in] Lba             Logical Block Address: number of logical blocks
+                               to skip from the beginning of the device.
+
+    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
+                               is responsible to ensure this parameter is
+                               positive.
+
+    @param[in out] Buffer      The guest side area to read data from the device
+                               into, or write data to the device from.
+
+    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
+                               device.
+
+  Return values are common to both use cases, and are appropriate to be
+  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
+  WriteBlocks(), FlushBlocks()).
+
+
+  @retval EFI_SUCCESS          Transfer complete.
+
+  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
+                               unable to parse host response, or host response
+                               is not VIRTIO_BLK_S_OK or failed to map Buffer
+                               for a bus master operation.
+
+  @retval EFI_OUT_OF_RESOURCES Memory allocation failed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SynchronousRequest (
+  IN              VBLK_DEV  *Dev,
+  IN              EFI_LBA   Lba,
+  IN              UINTN     BufferSize,
+  IN OUT volatile VOID      *Buffer,
+  IN              BOOLEAN   RequestIsWrite
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     CurrentTpl;
+  VBLK_IO     *Io;
+  UINTN       PollPeriodUsecs;
+
+  CurrentTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  Status = VirtioBlkStartIo (Dev, Lba, BufferSize, Buffer, RequestIsWrite, &Io);
+  if (!EFI_ERROR (Status)) {
+    PollPeriodUsecs = 1;
+    VirtioBlkCompleteRequests (Dev);
+    while (Io->Pending > 1) {
+      VirtioBlkPollRequests (Dev, &PollPeriodUsecs);
     }
+
+    Status = Io->Status;
+    VirtioBlkReleaseIo (Dev, Io);
   }
 
-UnmapRequestBuffer:
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, RequestMapping);
+  gBS->RestoreTPL (CurrentTpl);
+  return Status;
+}
 
-FreeHostStatusBuffer:
-  Dev->VirtIo->FreeSharedPages (
-                 Dev->VirtIo,
-                 EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                 HostStatusBuffer
-                 );
+/**
 
-FreeBlkRequest:
-  FreePool ((VOID *)Request);
+  Submit a read / write / flush request on behalf of an EFI_BLOCK_IO2_PROTOCOL
+  member function, and return without waiting for the response.
 
+  The request parameters have to be verified like for SynchronousRequest().
+
+  @param[in] Dev             The virtio-blk device the request is targeted at.
+
+  @param[in] Lba             See SynchronousRequest().
+
+  @param[in] BufferSize      See SynchronousRequest().
+
+  @param[in out] Buffer      See SynchronousRequest().
+
+  @param[in] RequestIsWrite  See SynchronousRequest().
+
+  @param[in] Token           The token whose event is signaled, and whose
+                             TransactionStatus is set, when the request
+                             completes.
+
+  @retval EFI_SUCCESS           The request has been submitted.
+
+  @retval EFI_DEVICE_ERROR      The request could not be submitted; Token is
+                                not going to be signaled.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed; Token is not going
+                                to be signaled.
+
+**/
+STATIC
+EFI_STATUS
+AsynchronousRequest (
+  IN              VBLK_DEV             *Dev,
+  IN              EFI_LBA              Lba,
+  IN              UINTN                BufferSize,
+  IN OUT volatile VOID                 *Buffer,
+  IN              BOOLEAN              RequestIsWrite,
+  IN              EFI_BLOCK_IO2_TOKEN  *Token
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     CurrentTpl;
+  VBLK_IO     *Io;
+
+  CurrentTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  Status = VirtioBlkStartIo (Dev, Lba, BufferSize, Buffer, RequestIsWrite, &Io);
+  if (!EFI_ERROR (Status)) {
+    Io->Token = Token;
+    if (Dev->AsyncPending++ == 0) {
+      gBS->SetTimer (Dev->PollTimer, TimerPeriodic, VBLK_ASYNC_POLL_PERIOD);
+    }
+
+    VirtioBlkPutIo (Dev, Io, EFI_SUCCESS);
+  }
+
+  gBS->RestoreTPL (CurrentTpl);
   return Status;
 }
 
+/**
+
+  Timer notification function that reaps completed asynchronous requests.
+
+  @param[in] Event    Event whose notification function is being invoked.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkPollTimer (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  VirtioBlkCompleteRequests (Context);
+}
+
 /**
 
   ReadBlocks() operation for virtio-blk.
@@ -589,30 +1132,215 @@ VirtioBlkWriteBlocks (
   - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.4 FlushBlocks() and
     FlushBlocksEx() Implementation.
 
-  If the underlying virtio-blk device doesn't support flushing (ie.
-  write-caching), then this function should not be called by higher layers,
-  according to EFI_BLOCK_IO_MEDIA characteristics set in VirtioBlkInit().
-  Should they do nonetheless, we do nothing, successfully.
+  If the underlying virtio-blk device doesn't support flushing (ie.
+  write-caching), then this function should not be called by higher layers,
+  according to EFI_BLOCK_IO_MEDIA characteristics set in VirtioBlkInit().
+  Should they do nonetheless, we do nothing, successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  VBLK_DEV  *Dev;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
+  return Dev->BlockIoMedia.WriteCaching ?
+         SynchronousRequest (
+           Dev,
+           0,      // Lba
+           0,      // BufferSize
+           NULL,   // Buffer
+           TRUE    // RequestIsWrite
+           ) :
+         EFI_SUCCESS;
+}
+
+/**
+
+  ResetEx() operation for virtio-blk.
+
+  See UEFI Spec 2.10, 13.10 EFI Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.Reset().
+
+  The device is not reset; the function only waits for all in-flight requests
+  to complete, and their tokens to be signaled.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  )
+{
+  VBLK_DEV  *Dev;
+  EFI_TPL   CurrentTpl;
+
+  Dev        = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  CurrentTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  VirtioBlkDrainRequests (Dev);
+  gBS->RestoreTPL (CurrentTpl);
+  return EFI_SUCCESS;
+}
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.10, 13.10 EFI Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the request is serviced by
+  VirtioBlkReadBlocks(). Otherwise the request is queued on the device, up to
+  VBLK_MAX_PENDING requests are kept in flight per request queue, and
+  Token->Event is signaled from a timer that polls the request queues.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  OUT    VOID                    *Buffer
+  )
+{
+  VBLK_DEV    *Dev;
+  EFI_STATUS  Status;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    return VirtioBlkReadBlocks (&Dev->BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  if (BufferSize == 0) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             FALSE               // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return AsynchronousRequest (
+           Dev,
+           Lba,
+           BufferSize,
+           Buffer,
+           FALSE,      // RequestIsWrite
+           Token
+           );
+}
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.10, 13.10 EFI Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the request is serviced by
+  VirtioBlkWriteBlocks(). Otherwise the request is queued on the device, like
+  in VirtioBlkReadBlocksEx().
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  )
+{
+  VBLK_DEV    *Dev;
+  EFI_STATUS  Status;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    return VirtioBlkWriteBlocks (&Dev->BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  if (BufferSize == 0) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             TRUE                // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return AsynchronousRequest (
+           Dev,
+           Lba,
+           BufferSize,
+           Buffer,
+           TRUE,       // RequestIsWrite
+           Token
+           );
+}
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.10, 13.10 EFI Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+
+  The flush request is submitted once all earlier requests have completed. If
+  the device doesn't support flushing, the request succeeds immediately, like
+  in VirtioBlkFlushBlocks().
 
 **/
 EFI_STATUS
 EFIAPI
-VirtioBlkFlushBlocks (
-  IN EFI_BLOCK_IO_PROTOCOL  *This
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token
   )
 {
   VBLK_DEV  *Dev;
 
-  Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
-  return Dev->BlockIoMedia.WriteCaching ?
-         SynchronousRequest (
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    return VirtioBlkFlushBlocks (&Dev->BlockIo);
+  }
+
+  if (!Dev->BlockIoMedia.WriteCaching) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  return AsynchronousRequest (
            Dev,
            0,      // Lba
            0,      // BufferSize
            NULL,   // Buffer
-           TRUE    // RequestIsWrite
-           ) :
-         EFI_SUCCESS;
+           TRUE,   // RequestIsWrite
+           Token
+           );
 }
 
 /**
@@ -698,6 +1426,238 @@ VirtioBlkDriverBindingSupported (
   return Status;
 }
 
+/**
+
+  Set up a request queue of a virtio-blk device, together with its request
+  slots.
+
+  The function allocates and maps the virtio ring, reports it to the device,
+  allocates the area shared with the device for request headers, host
+  statuses and indirect descriptor tables, maps it with
+  VirtioOperationBusMasterCommonBuffer, and sets up the stack of free request
+  slots.
+
+  This function may only be called by VirtioBlkInit().
+
+  @param[in,out] Dev       The virtio-blk device. Dev->IndirectDesc must be
+                           valid.
+
+  @param[in] QueueIdx      The index of the request queue to set up.
+
+  @retval EFI_SUCCESS           The request queue is ready for use.
+
+  @retval EFI_UNSUPPORTED       The queue size reported by the device is too
+                                small.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes from the VirtIo protocol,
+                                VirtioRingInit(), VirtioRingMap() or
+                                VirtioMapAllBytesInSharedBuffer().
+
+**/
+STATIC
+EFI_STATUS
+VirtioBlkInitQueue (
+  IN OUT VBLK_DEV  *Dev,
+  IN     UINT16    QueueIdx
+  )
+{
+  EFI_STATUS  Status;
+  VBLK_QUEUE  *Queue;
+  UINT16      QueueSize;
+  UINT64      RingBaseShift;
+  VOID        *SharedReqBuffer;
+  UINTN       SharedReqSize;
+  UINT16      Idx;
+
+  Queue = &Dev->Queues[QueueIdx];
+
+  //
+  // step 4b -- allocate selected queue
+  //
+  Status = Dev->VirtIo->SetQueueSel (Dev->VirtIo, QueueIdx);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Dev->VirtIo->GetQueueNumMax (Dev->VirtIo, &QueueSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (QueueSize < VBLK_DESC_PER_REQ) {
+    // a request uses at most three descriptors
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = VirtioRingInit (Dev->VirtIo, QueueSize, &Queue->Ring);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // If anything fails from here on, we must release the ring resources
+  //
+  Status = VirtioRingMap (
+             Dev->VirtIo,
+             &Queue->Ring,
+             &RingBaseShift,
+             &Queue->RingMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto ReleaseQueue;
+  }
+
+  //
+  // Set up the request slots. If anything fails from here on, we must
+  // release them.
+  //
+  Queue->MaxPending = (UINT16)MIN (
+                                (Dev->IndirectDesc ?
+                                 QueueSize :
+                                 QueueSize / VBLK_DESC_PER_REQ),
+                                VBLK_MAX_PENDING
+                                );
+  Queue->CurPending = 0;
+
+  Queue->FreeStack = AllocatePool (Queue->MaxPending * sizeof *Queue->FreeStack);
+  if (Queue->FreeStack == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto UnmapQueue;
+  }
+
+  Queue->Slots = AllocateZeroPool (Queue->MaxPending * sizeof *Queue->Slots);
+  if (Queue->Slots == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeFreeStack;
+  }
+
+  SharedReqSize = Queue->MaxPending * sizeof *Queue->SharedReq;
+  Status        = Dev->VirtIo->AllocateSharedPages (
+                                 Dev->VirtIo,
+                                 EFI_SIZE_TO_PAGES (SharedReqSize),
+                                 &SharedReqBuffer
+                                 );
+  if (EFI_ERROR (Status)) {
+    goto FreeSlots;
+  }
+
+  ZeroMem (SharedReqBuffer, SharedReqSize);
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             SharedReqBuffer,
+             SharedReqSize,
+             &Queue->SharedReqBase,
+             &Queue->SharedReqMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeSharedReqBuffer;
+  }
+
+  Queue->SharedReq = SharedReqBuffer;
+
+  for (Idx = 0; Idx < Queue->MaxPending; ++Idx) {
+    Queue->FreeStack[Idx] = Idx;
+  }
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  Queue->LastUsed = *Queue->Ring.Used.Idx;
+  ASSERT (Queue->LastUsed == 0);
+
+  //
+  // We're going to poll the answers, the host should not send interrupts.
+  //
+  *Queue->Ring.Avail.Flags = (UINT16)VRING_AVAIL_F_NO_INTERRUPT;
+
+  //
+  // Additional steps for MMIO: align the queue appropriately, and set the
+  // size.
+  //
+  Status = Dev->VirtIo->SetQueueNum (Dev->VirtIo, QueueSize);
+  if (EFI_ERROR (Status)) {
+    goto UnmapSharedReqBuffer;
+  }
+
+  Status = Dev->VirtIo->SetQueueAlign (Dev->VirtIo, EFI_PAGE_SIZE);
+  if (EFI_ERROR (Status)) {
+    goto UnmapSharedReqBuffer;
+  }
+
+  //
+  // step 4c -- Report GPFN (guest-physical frame number) of queue.
+  //
+  Status = Dev->VirtIo->SetQueueAddress (
+                          Dev->VirtIo,
+                          &Queue->Ring,
+                          RingBaseShift
+                          );
+  if (EFI_ERROR (Status)) {
+    goto UnmapSharedReqBuffer;
+  }
+
+  return EFI_SUCCESS;
+
+UnmapSharedReqBuffer:
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Queue->SharedReqMap);
+
+FreeSharedReqBuffer:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (SharedReqSize),
+                 SharedReqBuffer
+                 );
+
+FreeSlots:
+  FreePool (Queue->Slots);
+
+FreeFreeStack:
+  FreePool (Queue->FreeStack);
+
+UnmapQueue:
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Queue->RingMap);
+
+ReleaseQueue:
+  VirtioRingUninit (Dev->VirtIo, &Queue->Ring);
+
+  return Status;
+}
+
+/**
+
+  Release a request queue set up by VirtioBlkInitQueue().
+
+  The device must have been reset, or all requests must have completed.
+
+  @param[in,out] Dev    The virtio-blk device.
+
+  @param[in,out] Queue  The request queue to release.
+
+**/
+STATIC
+VOID
+VirtioBlkUninitQueue (
+  IN OUT VBLK_DEV    *Dev,
+  IN OUT VBLK_QUEUE  *Queue
+  )
+{
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Queue->SharedReqMap);
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (Queue->MaxPending * sizeof *Queue->SharedReq),
+                 Queue->SharedReq
+                 );
+  FreePool (Queue->Slots);
+  FreePool (Queue->FreeStack);
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Queue->RingMap);
+  VirtioRingUninit (Dev->VirtIo, &Queue->Ring);
+}
+
 /**
 
   Set up all BlockIo and virtio-blk aspects of this driver for the specified
@@ -712,9 +1672,8 @@ VirtioBlkDriverBindingSupported (
   @retval EFI_UNSUPPORTED  The driver is unable to work with the virtio ring or
                            virtio-blk attributes the host provides.
 
-  @return                  Error codes from VirtioRingInit() or
-                           VIRTIO_CFG_READ() / VIRTIO_CFG_WRITE or
-                           VirtioRingMap().
+  @return                  Error codes from VirtioBlkInitQueue() or
+                           VIRTIO_CFG_READ() / VIRTIO_CFG_WRITE.
 
 **/
 STATIC
@@ -733,12 +1692,18 @@ VirtioBlkInit (
   UINT8   PhysicalBlockExp;
   UINT8   AlignmentOffset;
   UINT32  OptIoSize;
-  UINT16  QueueSize;
-  UINT64  RingBaseShift;
+  UINT32  SizeMax;
+  UINT32  SegMax;
+  UINT16  NumQueues;
+  UINT16  QueueIdx;
+  UINT64  MaxTransfer;
 
   PhysicalBlockExp = 0;
   AlignmentOffset  = 0;
   OptIoSize        = 0;
+  SizeMax          = 0;
+  SegMax           = 0;
+  NumQueues        = 1;
 
   //
   // Execute virtio-0.9.5, 2.2.1 Device Initialization Sequence.
@@ -833,82 +1798,82 @@ VirtioBlkInit (
     }
   }
 
-  Features &= VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_TOPOLOGY | VIRTIO_BLK_F_RO |
-              VIRTIO_BLK_F_FLUSH | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
-
-  //
-  // In virtio-1.0, feature negotiation is expected to complete before queue
-  // discovery, and the device can also reject the selected set of features.
-  //
-  if (Dev->VirtIo->Revision >= VIRTIO_SPEC_REVISION (1, 0, 0)) {
-    Status = Virtio10WriteFeatures (Dev->VirtIo, Features, &NextDevStat);
+  if (Features & VIRTIO_BLK_F_SIZE_MAX) {
+    Status = VIRTIO_CFG_READ (Dev, SizeMax, &SizeMax);
     if (EFI_ERROR (Status)) {
       goto Failed;
     }
   }
 
-  //
-  // step 4b -- allocate virtqueue
-  //
-  Status = Dev->VirtIo->SetQueueSel (Dev->VirtIo, 0);
-  if (EFI_ERROR (Status)) {
-    goto Failed;
+  if (Features & VIRTIO_BLK_F_SEG_MAX) {
+    Status = VIRTIO_CFG_READ (Dev, SegMax, &SegMax);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
   }
 
-  Status = Dev->VirtIo->GetQueueNumMax (Dev->VirtIo, &QueueSize);
-  if (EFI_ERROR (Status)) {
-    goto Failed;
-  }
+  if (Features & VIRTIO_BLK_F_MQ) {
+    Status = VIRTIO_CFG_READ (Dev, NumQueues, &NumQueues);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
 
-  if (QueueSize < 3) {
-    // SynchronousRequest() uses at most three descriptors
-    Status = EFI_UNSUPPORTED;
-    goto Failed;
+    NumQueues = MAX (NumQueues, 1);
   }
 
-  Status = VirtioRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
-  if (EFI_ERROR (Status)) {
-    goto Failed;
-  }
+  Features &= VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_TOPOLOGY | VIRTIO_BLK_F_RO |
+              VIRTIO_BLK_F_FLUSH | VIRTIO_BLK_F_SIZE_MAX |
+              VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_MQ |
+              VIRTIO_F_RING_INDIRECT_DESC | VIRTIO_F_VERSION_1 |
+              VIRTIO_F_IOMMU_PLATFORM;
+
+  Dev->IndirectDesc = (BOOLEAN)((Features & VIRTIO_F_RING_INDIRECT_DESC) != 0);
 
   //
-  // If anything fails from here on, we must release the ring resources
+  // Without indirect descriptors, or without VIRTIO_BLK_F_SEG_MAX, the data
+  // buffer of a request takes up a single descriptor. No descriptor may be
+  // longer than SizeMax bytes, if the device specifies a limit.
   //
-  Status = VirtioRingMap (
-             Dev->VirtIo,
-             &Dev->Ring,
-             &RingBaseShift,
-             &Dev->RingMap
-             );
-  if (EFI_ERROR (Status)) {
-    goto ReleaseQueue;
+  Dev->MaxSegments    = (UINT8)((Dev->IndirectDesc && (SegMax > 1)) ?
+                                MIN (SegMax, VBLK_MAX_SEGMENTS) :
+                                1);
+  Dev->SegmentSizeMax = (SizeMax > 0) ? MIN (SizeMax, SIZE_1GB) : SIZE_1GB;
+  MaxTransfer         = MIN (
+                          MultU64x32 (Dev->MaxSegments, Dev->SegmentSizeMax),
+                          SIZE_1GB
+                          );
+  MaxTransfer -= ModU64x32 (MaxTransfer, BlockSize);
+  if (MaxTransfer == 0) {
+    //
+    // We can't transfer even a single block in a request.
+    //
+    Status = EFI_UNSUPPORTED;
+    goto Failed;
   }
 
+  Dev->MaxTransfer  = (UINT32)MaxTransfer;
+  Dev->NumQueues    = MIN (NumQueues, VBLK_MAX_QUEUES);
+  Dev->AsyncPending = 0;
+
   //
-  // Additional steps for MMIO: align the queue appropriately, and set the
-  // size. If anything fails from here on, we must unmap the ring resources.
+  // In virtio-1.0, feature negotiation is expected to complete before queue
+  // discovery, and the device can also reject the selected set of features.
   //
-  Status = Dev->VirtIo->SetQueueNum (Dev->VirtIo, QueueSize);
-  if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
-  }
-
-  Status = Dev->VirtIo->SetQueueAlign (Dev->VirtIo, EFI_PAGE_SIZE);
-  if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+  if (Dev->VirtIo->Revision >= VIRTIO_SPEC_REVISION (1, 0, 0)) {
+    Status = Virtio10WriteFeatures (Dev->VirtIo, Features, &NextDevStat);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
   }
 
   //
-  // step 4c -- Report GPFN (guest-physical frame number) of queue.
+  // step 4b, 4c -- allocate the request queues
   //
-  Status = Dev->VirtIo->SetQueueAddress (
-                          Dev->VirtIo,
-                          &Dev->Ring,
-                          RingBaseShift
-                          );
-  if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+  for (QueueIdx = 0; QueueIdx < Dev->NumQueues; ++QueueIdx) {
+    Status = VirtioBlkInitQueue (Dev, QueueIdx);
+    if (EFI_ERROR (Status)) {
+      goto UninitQueues;
+    }
   }
 
   //
@@ -918,7 +1883,7 @@ VirtioBlkInit (
     Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
     Status    = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
-      goto UnmapQueue;
+      goto UninitQueues;
     }
   }
 
@@ -928,7 +1893,7 @@ VirtioBlkInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status       = Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto UninitQueues;
   }
 
   //
@@ -941,6 +1906,11 @@ VirtioBlkInit (
   Dev->BlockIo.ReadBlocks            = &VirtioBlkReadBlocks;
   Dev->BlockIo.WriteBlocks           = &VirtioBlkWriteBlocks;
   Dev->BlockIo.FlushBlocks           = &VirtioBlkFlushBlocks;
+  Dev->BlockIo2.Media                = &Dev->BlockIoMedia;
+  Dev->BlockIo2.Reset                = &VirtioBlkResetEx;
+  Dev->BlockIo2.ReadBlocksEx         = &VirtioBlkReadBlocksEx;
+  Dev->BlockIo2.WriteBlocksEx        = &VirtioBlkWriteBlocksEx;
+  Dev->BlockIo2.FlushBlocksEx        = &VirtioBlkFlushBlocksEx;
   Dev->BlockIoMedia.MediaId          = 0;
   Dev->BlockIoMedia.RemovableMedia   = FALSE;
   Dev->BlockIoMedia.MediaPresent     = TRUE;
@@ -961,6 +1931,23 @@ VirtioBlkInit (
     Dev->BlockIoMedia.BlockSize,
     Dev->BlockIoMedia.LastBlock + 1
     ));
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: NumQueues=%u QueueSize=%u MaxPending=%u IndirectDesc=%d\n",
+    __func__,
+    Dev->NumQueues,
+    Dev->Queues[0].Ring.QueueSize,
+    Dev->Queues[0].MaxPending,
+    Dev->IndirectDesc
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: MaxSegments=%u SegmentSizeMax=0x%x MaxTransfer=0x%x\n",
+    __func__,
+    Dev->MaxSegments,
+    Dev->SegmentSizeMax,
+    Dev->MaxTransfer
+    ));
 
   if (Features & VIRTIO_BLK_F_TOPOLOGY) {
     Dev->BlockIo.Revision = EFI_BLOCK_IO_PROTOCOL_REVISION3;
@@ -986,11 +1973,10 @@ VirtioBlkInit (
 
   return EFI_SUCCESS;
 
-UnmapQueue:
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
-
-ReleaseQueue:
-  VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
+UninitQueues:
+  while (QueueIdx > 0) {
+    VirtioBlkUninitQueue (Dev, &Dev->Queues[--QueueIdx]);
+  }
 
 Failed:
   //
@@ -1018,6 +2004,9 @@ VirtioBlkUninit (
   IN OUT VBLK_DEV  *Dev
   )
 {
+  UINT16   QueueIdx;
+  VBLK_IO  *Io;
+
   //
   // Reset the virtual device -- see virtio-0.9.5, 2.2.2.1 Device Status. When
   // VIRTIO_CFG_WRITE() returns, the host will have learned to stay away from
@@ -1025,10 +2014,18 @@ VirtioBlkUninit (
   //
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
-  VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
+  for (QueueIdx = 0; QueueIdx < Dev->NumQueues; ++QueueIdx) {
+    VirtioBlkUninitQueue (Dev, &Dev->Queues[QueueIdx]);
+  }
+
+  while (Dev->FreeIo != NULL) {
+    Io          = Dev->FreeIo;
+    Dev->FreeIo = Io->NextFree;
+    FreePool (Io);
+  }
 
   SetMem (&Dev->BlockIo, sizeof Dev->BlockIo, 0x00);
+  SetMem (&Dev->BlockIo2, sizeof Dev->BlockIo2, 0x00);
   SetMem (&Dev->BlockIoMedia, sizeof Dev->BlockIoMedia, 0x00);
 }
 
@@ -1049,7 +2046,11 @@ VirtioBlkExitBoot (
   IN  VOID       *Context
   )
 {
-  VBLK_DEV  *Dev;
+  VBLK_DEV       *Dev;
+  VBLK_QUEUE     *Queue;
+  VBLK_REQ_SLOT  *Slot;
+  UINT16         QueueIdx;
+  UINT16         SlotIdx;
 
   DEBUG ((DEBUG_VERBOSE, "%a: Context=0x%p\n", __func__, Context));
   //
@@ -1061,6 +2062,31 @@ VirtioBlkExitBoot (
   //
   Dev = Context;
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
+
+  //
+  // The host no longer accesses the callers' buffers. Fail the asynchronous
+  // calls that were still in flight, so that no token is left unsignaled.
+  // Memory must not be freed here, so the calls are not released.
+  //
+  if (Dev->AsyncPending == 0) {
+    return;
+  }
+
+  gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
+  for (QueueIdx = 0; QueueIdx < Dev->NumQueues; ++QueueIdx) {
+    Queue = &Dev->Queues[QueueIdx];
+    for (SlotIdx = 0; SlotIdx < Queue->MaxPending; ++SlotIdx) {
+      Slot = &Queue->Slots[SlotIdx];
+      if ((Slot->Io == NULL) || (Slot->Io->Token == NULL)) {
+        continue;
+      }
+
+      Slot->Io->Token->TransactionStatus = EFI_DEVICE_ERROR;
+      gBS->SignalEvent (Slot->Io->Token->Event);
+      Slot->Io->Token = NULL;
+      --Dev->AsyncPending;
+    }
+  }
 }
 
 /**
@@ -1138,22 +2164,39 @@ VirtioBlkDriverBindingStart (
     goto UninitDev;
   }
 
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  &VirtioBlkPollTimer,
+                  Dev,
+                  &Dev->PollTimer
+                  );
+  if (EFI_ERROR (Status)) {
+    goto CloseExitBoot;
+  }
+
   //
-  // Setup complete, attempt to export the driver instance's BlockIo interface.
+  // Setup complete, attempt to export the driver instance's BlockIo and
+  // BlockIo2 interfaces.
   //
   Dev->Signature = VBLK_SIG;
-  Status         = gBS->InstallProtocolInterface (
+  Status         = gBS->InstallMultipleProtocolInterfaces (
                           &DeviceHandle,
                           &gEfiBlockIoProtocolGuid,
-                          EFI_NATIVE_INTERFACE,
-                          &Dev->BlockIo
+                          &Dev->BlockIo,
+                          &gEfiBlockIo2ProtocolGuid,
+                          &Dev->BlockIo2,
+                          NULL
                           );
   if (EFI_ERROR (Status)) {
-    goto CloseExitBoot;
+    goto ClosePollTimer;
   }
 
   return EFI_SUCCESS;
 
+ClosePollTimer:
+  gBS->CloseEvent (Dev->PollTimer);
+
 CloseExitBoot:
   gBS->CloseEvent (Dev->ExitBoot);
 
@@ -1208,6 +2251,7 @@ VirtioBlkDriverBindingStop (
   EFI_STATUS             Status;
   EFI_BLOCK_IO_PROTOCOL  *BlockIo;
   VBLK_DEV               *Dev;
+  EFI_TPL                OldTpl;
 
   Status = gBS->OpenProtocol (
                   DeviceHandle,                  // candidate device
@@ -1226,15 +2270,27 @@ VirtioBlkDriverBindingStop (
   //
   // Handle Stop() requests for in-use driver instances gracefully.
   //
-  Status = gBS->UninstallProtocolInterface (
+  Status = gBS->UninstallMultipleProtocolInterfaces (
                   DeviceHandle,
                   &gEfiBlockIoProtocolGuid,
-                  &Dev->BlockIo
+                  &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &Dev->BlockIo2,
+                  NULL
                   );
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  //
+  // Let the asynchronous requests still in flight complete, and signal their
+  // tokens.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  VirtioBlkDrainRequests (Dev);
+  gBS->RestoreTPL (OldTpl);
+
+  gBS->CloseEvent (Dev->PollTimer);
   gBS->CloseEvent (Dev->ExitBoot);
 
   VirtioBlkUninit (Dev);
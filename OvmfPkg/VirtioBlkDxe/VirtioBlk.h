@@ -12,13 +12,100 @@
 #pragma once
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 
 #include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
 
 #define VBLK_SIG  SIGNATURE_32 ('V', 'B', 'L', 'K')
 
+//
+// Without indirect descriptors, every request is a chain of at most three
+// ring descriptors: the virtio-blk request header, the data buffer (absent for
+// flush), and the host status.
+//
+#define VBLK_DESC_PER_REQ  3
+
+//
+// With indirect descriptors, the data buffer of a request may be scattered
+// over this many descriptors, subject to VIRTIO_BLK_F_SEG_MAX.
+//
+#define VBLK_MAX_SEGMENTS  30
+
+//
+// Upper bound on the number of requests kept in flight on each request queue.
+//
+#define VBLK_MAX_PENDING  64
+
+//
+// Upper bound on the number of request queues used with VIRTIO_BLK_F_MQ.
+//
+#define VBLK_MAX_QUEUES  4
+
+//
+// Period of polling the request queues for completed asynchronous requests.
+// Interrupts are not used by the driver.
+//
+#define VBLK_ASYNC_POLL_PERIOD  EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// The part of a request that is shared with the device. One such structure
+// exists per request slot, in a single buffer per queue mapped with
+// VirtioOperationBusMasterCommonBuffer. The size of the structure is a
+// multiple of 16 bytes, so that each indirect descriptor table is suitably
+// aligned.
+//
+#pragma pack (1)
+typedef struct {
+  VRING_DESC        Indirect[VBLK_MAX_SEGMENTS + 2]; // if VIRTIO_F_RING_INDIRECT_DESC
+  VIRTIO_BLK_REQ    Request;
+  UINT8             HostStatus;
+  UINT8             Reserved[15];
+} VBLK_SHARED_REQ;
+#pragma pack ()
+
+//
+// A single ReadBlocks(Ex) / WriteBlocks(Ex) / FlushBlocks(Ex) call. Transfers
+// larger than VBLK_DEV.MaxTransfer are carried by several virtio-blk requests.
+// Released calls are kept on VBLK_DEV.FreeIo for reuse.
+//
+typedef struct _VBLK_IO {
+  EFI_BLOCK_IO2_TOKEN    *Token;    // NULL for synchronous calls
+  UINTN                  Pending;   // requests in flight, plus one for the
+                                    // submitter while it holds on to the call
+  EFI_STATUS             Status;    // first failure among the requests
+  BOOLEAN                Abandoned; // the host could not be notified
+  struct _VBLK_IO        *NextFree; // link on VBLK_DEV.FreeIo
+} VBLK_IO;
+
+//
+// Private bookkeeping of a request slot.
+//
+typedef struct {
+  VBLK_IO    *Io;
+  BOOLEAN    RequestIsWrite;
+  UINT8      NumMappings;
+  VOID       *Mappings[VBLK_MAX_SEGMENTS];
+} VBLK_REQ_SLOT;
+
+//
+// A request queue, and the request slots that go with it.
+//
+typedef struct {
+  VRING                   Ring;
+  VOID                    *RingMap;
+  UINT16                  MaxPending;
+  UINT16                  CurPending;
+  UINT16                  LastUsed;
+  UINT16                  *FreeStack;
+  VBLK_REQ_SLOT           *Slots;
+  VBLK_SHARED_REQ         *SharedReq;
+  EFI_PHYSICAL_ADDRESS    SharedReqBase;
+  VOID                    *SharedReqMap;
+} VBLK_QUEUE;
+
 typedef struct {
   //
   // Parts of this structure are initialized / torn down in various functions
@@ -30,15 +117,26 @@ typedef struct {
   UINT32                    Signature;         // DriverBindingStart  0
   VIRTIO_DEVICE_PROTOCOL    *VirtIo;           // DriverBindingStart  0
   EFI_EVENT                 ExitBoot;          // DriverBindingStart  0
-  VRING                     Ring;              // VirtioRingInit      2
   EFI_BLOCK_IO_PROTOCOL     BlockIo;           // VirtioBlkInit       1
+  EFI_BLOCK_IO2_PROTOCOL    BlockIo2;          // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA        BlockIoMedia;      // VirtioBlkInit       1
-  VOID                      *RingMap;          // VirtioRingMap       2
+  BOOLEAN                   IndirectDesc;      // VirtioBlkInit       1
+  UINT8                     MaxSegments;       // VirtioBlkInit       1
+  UINT32                    SegmentSizeMax;    // VirtioBlkInit       1
+  UINT32                    MaxTransfer;       // VirtioBlkInit       1
+  UINT16                    NumQueues;         // VirtioBlkInit       1
+  UINT16                    AsyncPending;      // VirtioBlkInit       1
+  VBLK_QUEUE                Queues[VBLK_MAX_QUEUES]; // VirtioBlkInitQueue 2
+  EFI_EVENT                 PollTimer;         // DriverBindingStart  0
+  VBLK_IO                   *FreeIo;           // DriverBindingStart  0
 } VBLK_DEV;
 
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
 /**
 
   Device probe function for this driver.
@@ -243,6 +341,48 @@ VirtioBlkFlushBlocks (
   IN EFI_BLOCK_IO_PROTOCOL  *This
   );
 
+//
+// UEFI Spec 2.10, 13.10 EFI Block I/O 2 Protocol
+//
+// If Token is NULL, or Token->Event is NULL, the request is executed
+// synchronously, like with the corresponding EFI_BLOCK_IO_PROTOCOL member.
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  OUT    VOID                    *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token
+  );
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
@@ -115,6 +115,13 @@ VirtioFsBindingStart (
   }
 
   InitializeListHead (&VirtioFs->OpenFiles);
+  InitializeListHead (&VirtioFs->Nodes);
+  InitializeListHead (&VirtioFs->Dentries);
+  VirtioFs->NumDentries  = 0;
+  VirtioFs->LookupHits   = 0;
+  VirtioFs->LookupMisses = 0;
+  VirtioFs->AttrHits     = 0;
+  VirtioFs->AttrMisses   = 0;
   VirtioFs->SimpleFs.Revision   = EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_REVISION;
   VirtioFs->SimpleFs.OpenVolume = VirtioFsOpenVolume;
 
@@ -195,6 +202,7 @@ VirtioFsBindingStop (
   Status = gBS->CloseEvent (VirtioFs->ExitBoot);
   ASSERT_EFI_ERROR (Status);
 
+  VirtioFsPurgeLookupCache (VirtioFs);
   VirtioFsUninit (VirtioFs);
 
   Status = gBS->CloseProtocol (
@@ -24,8 +24,9 @@
                            "VirtioFs->RequestId" will have been incremented.
 
   @param[in] NodeId        The inode number that the client learned by way of
-                           lookup, and that the server should now un-reference
-                           exactly once.
+                           lookup, and that the server should now un-reference.
+
+  @param[in] NumberOfLookups  The number of lookups to un-reference NodeId by.
 
   @retval EFI_SUCCESS  The FUSE_FORGET request has been submitted.
 
@@ -35,7 +36,8 @@
 EFI_STATUS
 VirtioFsFuseForget (
   IN OUT VIRTIO_FS  *VirtioFs,
-  IN     UINT64     NodeId
+  IN     UINT64     NodeId,
+  IN     UINT64     NumberOfLookups
   )
 {
   VIRTIO_FS_FUSE_REQUEST         CommonReq;
@@ -80,7 +82,7 @@ VirtioFsFuseForget (
   //
   // Populate the FUSE_FORGET-specific fields.
   //
-  ForgetReq.NumberOfLookups = 1;
+  ForgetReq.NumberOfLookups = NumberOfLookups;
 
   //
   // Submit the request. There's not going to be a response.
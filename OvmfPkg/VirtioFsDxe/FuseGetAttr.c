@@ -23,10 +23,13 @@
   @param[in] NodeId        The inode number for which the attributes should be
                            retrieved.
 
+  @param[out] GetAttrResp  The VIRTIO_FS_FUSE_GETATTR_RESPONSE object carrying
+                           the duration for which FuseAttr may be cached.
+
   @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
                            describing the properties of the inode.
 
-  @retval EFI_SUCCESS  FuseAttr has been filled in.
+  @retval EFI_SUCCESS  GetAttrResp and FuseAttr have been filled in.
 
   @return              The "errno" value mapped to an EFI_STATUS code, if the
                        Virtio Filesystem device explicitly reported an error.
@@ -39,6 +42,7 @@ EFI_STATUS
 VirtioFsFuseGetAttr (
   IN OUT VIRTIO_FS                        *VirtioFs,
   IN     UINT64                           NodeId,
+  OUT VIRTIO_FS_FUSE_GETATTR_RESPONSE     *GetAttrResp,
   OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
   )
 {
@@ -47,7 +51,6 @@ VirtioFsFuseGetAttr (
   VIRTIO_FS_IO_VECTOR              ReqIoVec[2];
   VIRTIO_FS_SCATTER_GATHER_LIST    ReqSgList;
   VIRTIO_FS_FUSE_RESPONSE          CommonResp;
-  VIRTIO_FS_FUSE_GETATTR_RESPONSE  GetAttrResp;
   VIRTIO_FS_IO_VECTOR              RespIoVec[3];
   VIRTIO_FS_SCATTER_GATHER_LIST    RespSgList;
   EFI_STATUS                       Status;
@@ -64,8 +67,8 @@ VirtioFsFuseGetAttr (
 
   RespIoVec[0].Buffer = &CommonResp;
   RespIoVec[0].Size   = sizeof CommonResp;
-  RespIoVec[1].Buffer = &GetAttrResp;
-  RespIoVec[1].Size   = sizeof GetAttrResp;
+  RespIoVec[1].Buffer = GetAttrResp;
+  RespIoVec[1].Size   = sizeof *GetAttrResp;
   RespIoVec[2].Buffer = FuseAttr;
   RespIoVec[2].Size   = sizeof *FuseAttr;
   RespSgList.IoVec    = RespIoVec;
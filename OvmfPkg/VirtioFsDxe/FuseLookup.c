@@ -30,7 +30,10 @@
   @param[in] Name          The single-component filename to resolve in the
                            directory identified by DirNodeId.
 
-  @param[out] NodeId       The inode number which Name has been resolved to.
+  @param[out] NodeResp     The VIRTIO_FS_FUSE_NODE_RESPONSE object carrying
+                           the inode number which Name has been resolved to,
+                           and the durations for which the resolution and the
+                           attributes may be cached.
 
   @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
                            describing the properties of the resolved inode.
@@ -55,7 +58,7 @@ VirtioFsFuseLookup (
   IN OUT VIRTIO_FS                        *VirtioFs,
   IN     UINT64                           DirNodeId,
   IN     CHAR8                            *Name,
-  OUT UINT64                              *NodeId,
+  OUT VIRTIO_FS_FUSE_NODE_RESPONSE        *NodeResp,
   OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
   )
 {
@@ -63,7 +66,6 @@ VirtioFsFuseLookup (
   VIRTIO_FS_IO_VECTOR            ReqIoVec[2];
   VIRTIO_FS_SCATTER_GATHER_LIST  ReqSgList;
   VIRTIO_FS_FUSE_RESPONSE        CommonResp;
-  VIRTIO_FS_FUSE_NODE_RESPONSE   NodeResp;
   VIRTIO_FS_IO_VECTOR            RespIoVec[3];
   VIRTIO_FS_SCATTER_GATHER_LIST  RespSgList;
   EFI_STATUS                     Status;
@@ -80,8 +82,8 @@ VirtioFsFuseLookup (
 
   RespIoVec[0].Buffer = &CommonResp;
   RespIoVec[0].Size   = sizeof CommonResp;
-  RespIoVec[1].Buffer = &NodeResp;
-  RespIoVec[1].Size   = sizeof NodeResp;
+  RespIoVec[1].Buffer = NodeResp;
+  RespIoVec[1].Size   = sizeof *NodeResp;
   RespIoVec[2].Buffer = FuseAttr;
   RespIoVec[2].Size   = sizeof *FuseAttr;
   RespSgList.IoVec    = RespIoVec;
@@ -144,10 +146,6 @@ VirtioFsFuseLookup (
     goto Fail;
   }
 
-  //
-  // Output the NodeId to which Name has been resolved to.
-  //
-  *NodeId = NodeResp.NodeId;
   return EFI_SUCCESS;
 
 Fail:
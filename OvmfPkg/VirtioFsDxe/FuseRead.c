@@ -1,11 +1,13 @@
 /** @file
-  FUSE_READ / FUSE_READDIRPLUS wrapper for the Virtio Filesystem device.
+  FUSE_READ / FUSE_READDIRPLUS wrappers for the Virtio Filesystem device.
 
   Copyright (C) 2020, Red Hat, Inc.
 
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
+#include <Library/MemoryAllocationLib.h> // AllocatePool()
+
 #include "VirtioFsDxe.h"
 
 /**
@@ -203,3 +205,236 @@ VirtioFsFuseReadFileOrDir (
   *Size = (UINT32)TailBufferFill;
   return EFI_SUCCESS;
 }
+
+//
+// The buffers of a single FUSE_READ request, when several requests are
+// submitted at once.
+//
+typedef struct {
+  VIRTIO_FS_FUSE_REQUEST         CommonReq;
+  VIRTIO_FS_FUSE_READ_REQUEST    ReadReq;
+  VIRTIO_FS_IO_VECTOR            ReqIoVec[2];
+  VIRTIO_FS_SCATTER_GATHER_LIST  ReqSgList;
+  VIRTIO_FS_FUSE_RESPONSE        CommonResp;
+  VIRTIO_FS_IO_VECTOR            RespIoVec[2];
+  VIRTIO_FS_SCATTER_GATHER_LIST  RespSgList;
+} VIRTIO_FS_FUSE_READ_SLOT;
+
+/**
+  Read a range of a regular file, by splitting it into chunks and sending
+  several FUSE_READ requests to the Virtio Filesystem device at once.
+
+  Up to VirtioFsMaxInFlight() chunks are outstanding at the same time, so that
+  the Virtio Filesystem device can service them in parallel. The range is
+  split evenly among them, so that a device that services the requests one by
+  one doesn't pay for more requests than necessary; chunks are never smaller
+  than "VirtioFs->MaxWrite" though.
+
+  The function may only be called after VirtioFsFuseInitSession() returns
+  successfully and before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the FUSE_READ
+                           requests to. On output, the FUSE request counter
+                           "VirtioFs->RequestId" will have been incremented
+                           once per request.
+
+  @param[in] NodeId        The inode number of the regular file to read from.
+
+  @param[in] FuseHandle    The open handle to the regular file to read from.
+
+  @param[in] Offset        The absolute file position at which to start
+                           reading.
+
+  @param[in,out] Size      On input, the number of bytes to read. On successful
+                           return, the number of bytes actually read, which may
+                           be smaller than the value on input. Reading stops
+                           after the first chunk that comes back short, so
+                           that the bytes reported are contiguous. EOF can be
+                           detected by passing in a nonzero Size, and finding a
+                           zero Size on output.
+
+  @param[out] Data         Buffer to read the bytes from the regular file into.
+                           The caller is responsible for providing room for (at
+                           least) as many bytes in Data as Size is on input.
+
+  @retval EFI_SUCCESS           Read successful. The caller is responsible for
+                                checking Size to learn the actual byte count
+                                transferred.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       The "errno" value mapped to an EFI_STATUS code,
+                                if the Virtio Filesystem device explicitly
+                                reported an error for the first chunk.
+
+  @return                       Error codes propagated from
+                                VirtioFsSgListsValidate(),
+                                VirtioFsFuseNewRequest(),
+                                VirtioFsSgListsSubmitMultiple(),
+                                VirtioFsFuseCheckResponse().
+**/
+EFI_STATUS
+VirtioFsFuseReadFileMultiple (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId,
+  IN     UINT64     FuseHandle,
+  IN     UINT64     Offset,
+  IN OUT UINTN      *Size,
+  OUT VOID          *Data
+  )
+{
+  UINTN                     MaxSlots;
+  UINTN                     ChunkSize;
+  VIRTIO_FS_FUSE_READ_SLOT  *Slots;
+  VIRTIO_FS_EXCHANGE        *Exchange;
+  UINTN                     Transferred;
+  UINTN                     Left;
+  BOOLEAN                   Short;
+  EFI_STATUS                Status;
+
+  MaxSlots = VirtioFsMaxInFlight (VirtioFs, 4);
+  Slots    = AllocatePool (MaxSlots * sizeof *Slots);
+  if (Slots == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Exchange = AllocatePool (MaxSlots * sizeof *Exchange);
+  if (Exchange == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeSlots;
+  }
+
+  ChunkSize = (*Size + MaxSlots - 1) / MaxSlots;
+  ChunkSize = MIN (MAX (ChunkSize, (UINTN)VirtioFs->MaxWrite), SIZE_1GB);
+
+  Status      = EFI_SUCCESS;
+  Transferred = 0;
+  Left        = *Size;
+  Short       = FALSE;
+  while (Left > 0 && !Short) {
+    UINTN                     NumSlots;
+    UINTN                     SlotIdx;
+    UINTN                     Queued;
+    VIRTIO_FS_FUSE_READ_SLOT  *Slot;
+
+    //
+    // Set up one request per chunk, for as many chunks as we may submit at
+    // once.
+    //
+    Queued = 0;
+    for (NumSlots = 0; NumSlots < MaxSlots && Queued < Left; NumSlots++) {
+      Slot = &Slots[NumSlots];
+
+      Slot->ReqIoVec[0].Buffer = &Slot->CommonReq;
+      Slot->ReqIoVec[0].Size   = sizeof Slot->CommonReq;
+      Slot->ReqIoVec[1].Buffer = &Slot->ReadReq;
+      Slot->ReqIoVec[1].Size   = sizeof Slot->ReadReq;
+      Slot->ReqSgList.IoVec    = Slot->ReqIoVec;
+      Slot->ReqSgList.NumVec   = ARRAY_SIZE (Slot->ReqIoVec);
+
+      Slot->RespIoVec[0].Buffer = &Slot->CommonResp;
+      Slot->RespIoVec[0].Size   = sizeof Slot->CommonResp;
+      Slot->RespIoVec[1].Buffer = (UINT8 *)Data + Transferred + Queued;
+      Slot->RespIoVec[1].Size   = MIN (ChunkSize, Left - Queued);
+      Slot->RespSgList.IoVec    = Slot->RespIoVec;
+      Slot->RespSgList.NumVec   = ARRAY_SIZE (Slot->RespIoVec);
+
+      Status = VirtioFsSgListsValidate (
+                 VirtioFs,
+                 &Slot->ReqSgList,
+                 &Slot->RespSgList
+                 );
+      if (EFI_ERROR (Status)) {
+        goto FreeExchange;
+      }
+
+      Status = VirtioFsFuseNewRequest (
+                 VirtioFs,
+                 &Slot->CommonReq,
+                 Slot->ReqSgList.TotalSize,
+                 VirtioFsFuseOpRead,
+                 NodeId
+                 );
+      if (EFI_ERROR (Status)) {
+        goto FreeExchange;
+      }
+
+      Slot->ReadReq.FileHandle = FuseHandle;
+      Slot->ReadReq.Offset     = Offset + Transferred + Queued;
+      Slot->ReadReq.Size       = (UINT32)Slot->RespIoVec[1].Size;
+      Slot->ReadReq.ReadFlags  = 0;
+      Slot->ReadReq.LockOwner  = 0;
+      Slot->ReadReq.Flags      = 0;
+      Slot->ReadReq.Padding    = 0;
+
+      Exchange[NumSlots].RequestSgList  = &Slot->ReqSgList;
+      Exchange[NumSlots].ResponseSgList = &Slot->RespSgList;
+
+      Queued += Slot->RespIoVec[1].Size;
+    }
+
+    Status = VirtioFsSgListsSubmitMultiple (VirtioFs, Exchange, NumSlots);
+    if (EFI_ERROR (Status)) {
+      goto FreeExchange;
+    }
+
+    //
+    // Collect the results in file order. A short chunk means EOF (or an
+    // error); anything read by the chunks after it is not reported.
+    //
+    for (SlotIdx = 0; SlotIdx < NumSlots && !Short; SlotIdx++) {
+      UINTN  TailBufferFill;
+
+      Slot   = &Slots[SlotIdx];
+      Status = VirtioFsFuseCheckResponse (
+                 &Slot->RespSgList,
+                 Slot->CommonReq.Unique,
+                 &TailBufferFill
+                 );
+      if (EFI_ERROR (Status)) {
+        if (Status == EFI_DEVICE_ERROR) {
+          DEBUG ((
+            DEBUG_ERROR,
+            "%a: Label=\"%s\" NodeId=%Lu FuseHandle=%Lu "
+            "Offset=0x%Lx Size=0x%x Errno=%d\n",
+            __func__,
+            VirtioFs->Label,
+            NodeId,
+            FuseHandle,
+            Slot->ReadReq.Offset,
+            Slot->ReadReq.Size,
+            Slot->CommonResp.Error
+            ));
+          Status = VirtioFsErrnoToEfiStatus (Slot->CommonResp.Error);
+        }
+
+        if (Transferred > 0) {
+          Status = EFI_SUCCESS;
+        }
+
+        Short = TRUE;
+        break;
+      }
+
+      Transferred += TailBufferFill;
+      Left        -= TailBufferFill;
+      if (TailBufferFill < Slot->RespIoVec[1].Size) {
+        Short = TRUE;
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      goto FreeExchange;
+    }
+  }
+
+  *Size = Transferred;
+
+FreeExchange:
+  FreePool (Exchange);
+
+FreeSlots:
+  FreePool (Slots);
+
+  return Status;
+}
@@ -1,11 +1,13 @@
 /** @file
-  FUSE_WRITE wrapper for the Virtio Filesystem device.
+  FUSE_WRITE wrappers for the Virtio Filesystem device.
 
   Copyright (C) 2020, Red Hat, Inc.
 
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
+#include <Library/MemoryAllocationLib.h> // AllocatePool()
+
 #include "VirtioFsDxe.h"
 
 /**
@@ -168,3 +170,230 @@ VirtioFsFuseWrite (
   *Size = WriteResp.Size;
   return EFI_SUCCESS;
 }
+
+//
+// The buffers of a single FUSE_WRITE request, when several requests are
+// submitted at once.
+//
+typedef struct {
+  VIRTIO_FS_FUSE_REQUEST         CommonReq;
+  VIRTIO_FS_FUSE_WRITE_REQUEST   WriteReq;
+  VIRTIO_FS_IO_VECTOR            ReqIoVec[3];
+  VIRTIO_FS_SCATTER_GATHER_LIST  ReqSgList;
+  VIRTIO_FS_FUSE_RESPONSE        CommonResp;
+  VIRTIO_FS_FUSE_WRITE_RESPONSE  WriteResp;
+  VIRTIO_FS_IO_VECTOR            RespIoVec[2];
+  VIRTIO_FS_SCATTER_GATHER_LIST  RespSgList;
+} VIRTIO_FS_FUSE_WRITE_SLOT;
+
+/**
+  Write a range of a regular file, by splitting it into chunks of at most
+  "VirtioFs->MaxWrite" bytes, and sending several FUSE_WRITE requests to the
+  Virtio Filesystem device at once.
+
+  The function may only be called after VirtioFsFuseInitSession() returns
+  successfully and before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the FUSE_WRITE
+                           requests to. On output, the FUSE request counter
+                           "VirtioFs->RequestId" will have been incremented
+                           once per request.
+
+  @param[in] NodeId        The inode number of the regular file to write to.
+
+  @param[in] FuseHandle    The open handle to the regular file to write to.
+
+  @param[in] Offset        The absolute file position at which to start
+                           writing.
+
+  @param[in,out] Size      On input, the number of bytes to write. On
+                           successful return, the number of bytes actually
+                           written, which may be smaller than the value on
+                           input. Only the bytes up to and including the first
+                           short chunk are reported; chunks after it may have
+                           been written as well, and the caller may simply
+                           write them again.
+
+  @param[in] Data          The buffer to write to the regular file.
+
+  @retval EFI_SUCCESS           Write successful. The caller is responsible for
+                                checking Size to learn the actual byte count
+                                transferred.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       The "errno" value mapped to an EFI_STATUS code,
+                                if the Virtio Filesystem device explicitly
+                                reported an error for the first chunk.
+
+  @return                       Error codes propagated from
+                                VirtioFsSgListsValidate(),
+                                VirtioFsFuseNewRequest(),
+                                VirtioFsSgListsSubmitMultiple(),
+                                VirtioFsFuseCheckResponse().
+**/
+EFI_STATUS
+VirtioFsFuseWriteMultiple (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId,
+  IN     UINT64     FuseHandle,
+  IN     UINT64     Offset,
+  IN OUT UINTN      *Size,
+  IN     VOID       *Data
+  )
+{
+  UINTN                      MaxSlots;
+  VIRTIO_FS_FUSE_WRITE_SLOT  *Slots;
+  VIRTIO_FS_EXCHANGE         *Exchange;
+  UINTN                      Transferred;
+  UINTN                      Left;
+  BOOLEAN                    Short;
+  EFI_STATUS                 Status;
+
+  MaxSlots = VirtioFsMaxInFlight (VirtioFs, 5);
+  Slots    = AllocatePool (MaxSlots * sizeof *Slots);
+  if (Slots == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Exchange = AllocatePool (MaxSlots * sizeof *Exchange);
+  if (Exchange == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeSlots;
+  }
+
+  Status      = EFI_SUCCESS;
+  Transferred = 0;
+  Left        = *Size;
+  Short       = FALSE;
+  while (Left > 0 && !Short) {
+    UINTN                      NumSlots;
+    UINTN                      SlotIdx;
+    UINTN                      Queued;
+    VIRTIO_FS_FUSE_WRITE_SLOT  *Slot;
+
+    //
+    // Set up one request per chunk, for as many chunks as we may submit at
+    // once.
+    //
+    Queued = 0;
+    for (NumSlots = 0; NumSlots < MaxSlots && Queued < Left; NumSlots++) {
+      Slot = &Slots[NumSlots];
+
+      Slot->ReqIoVec[0].Buffer = &Slot->CommonReq;
+      Slot->ReqIoVec[0].Size   = sizeof Slot->CommonReq;
+      Slot->ReqIoVec[1].Buffer = &Slot->WriteReq;
+      Slot->ReqIoVec[1].Size   = sizeof Slot->WriteReq;
+      Slot->ReqIoVec[2].Buffer = (UINT8 *)Data + Transferred + Queued;
+      Slot->ReqIoVec[2].Size   = MIN ((UINTN)VirtioFs->MaxWrite, Left - Queued);
+      Slot->ReqSgList.IoVec    = Slot->ReqIoVec;
+      Slot->ReqSgList.NumVec   = ARRAY_SIZE (Slot->ReqIoVec);
+
+      Slot->RespIoVec[0].Buffer = &Slot->CommonResp;
+      Slot->RespIoVec[0].Size   = sizeof Slot->CommonResp;
+      Slot->RespIoVec[1].Buffer = &Slot->WriteResp;
+      Slot->RespIoVec[1].Size   = sizeof Slot->WriteResp;
+      Slot->RespSgList.IoVec    = Slot->RespIoVec;
+      Slot->RespSgList.NumVec   = ARRAY_SIZE (Slot->RespIoVec);
+
+      Status = VirtioFsSgListsValidate (
+                 VirtioFs,
+                 &Slot->ReqSgList,
+                 &Slot->RespSgList
+                 );
+      if (EFI_ERROR (Status)) {
+        goto FreeExchange;
+      }
+
+      Status = VirtioFsFuseNewRequest (
+                 VirtioFs,
+                 &Slot->CommonReq,
+                 Slot->ReqSgList.TotalSize,
+                 VirtioFsFuseOpWrite,
+                 NodeId
+                 );
+      if (EFI_ERROR (Status)) {
+        goto FreeExchange;
+      }
+
+      Slot->WriteReq.FileHandle = FuseHandle;
+      Slot->WriteReq.Offset     = Offset + Transferred + Queued;
+      Slot->WriteReq.Size       = (UINT32)Slot->ReqIoVec[2].Size;
+      Slot->WriteReq.WriteFlags = 0;
+      Slot->WriteReq.LockOwner  = 0;
+      Slot->WriteReq.Flags      = 0;
+      Slot->WriteReq.Padding    = 0;
+
+      Exchange[NumSlots].RequestSgList  = &Slot->ReqSgList;
+      Exchange[NumSlots].ResponseSgList = &Slot->RespSgList;
+
+      Queued += Slot->ReqIoVec[2].Size;
+    }
+
+    Status = VirtioFsSgListsSubmitMultiple (VirtioFs, Exchange, NumSlots);
+    if (EFI_ERROR (Status)) {
+      goto FreeExchange;
+    }
+
+    //
+    // Collect the results in file order, up to the first short chunk.
+    //
+    for (SlotIdx = 0; SlotIdx < NumSlots && !Short; SlotIdx++) {
+      Slot   = &Slots[SlotIdx];
+      Status = VirtioFsFuseCheckResponse (
+                 &Slot->RespSgList,
+                 Slot->CommonReq.Unique,
+                 NULL
+                 );
+      if (EFI_ERROR (Status)) {
+        if (Status == EFI_DEVICE_ERROR) {
+          DEBUG ((
+            DEBUG_ERROR,
+            "%a: Label=\"%s\" NodeId=%Lu FuseHandle=%Lu "
+            "Offset=0x%Lx Size=0x%x Errno=%d\n",
+            __func__,
+            VirtioFs->Label,
+            NodeId,
+            FuseHandle,
+            Slot->WriteReq.Offset,
+            Slot->WriteReq.Size,
+            Slot->CommonResp.Error
+            ));
+          Status = VirtioFsErrnoToEfiStatus (Slot->CommonResp.Error);
+        }
+
+        if (Transferred > 0) {
+          Status = EFI_SUCCESS;
+        }
+
+        Short = TRUE;
+        break;
+      }
+
+      if (Slot->WriteResp.Size > Slot->WriteReq.Size) {
+        Status = EFI_DEVICE_ERROR;
+        goto FreeExchange;
+      }
+
+      Transferred += Slot->WriteResp.Size;
+      Left        -= Slot->WriteResp.Size;
+      if (Slot->WriteResp.Size < Slot->WriteReq.Size) {
+        Short = TRUE;
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      goto FreeExchange;
+    }
+  }
+
+  *Size = Transferred;
+
+FreeExchange:
+  FreePool (Exchange);
+
+FreeSlots:
+  FreePool (Slots);
+
+  return Status;
+}
@@ -10,6 +10,7 @@
 #include <Library/BaseMemoryLib.h>       // CopyMem()
 #include <Library/MemoryAllocationLib.h> // AllocatePool()
 #include <Library/TimeBaseLib.h>         // EpochToEfiTime()
+#include <Library/UefiBootServicesTableLib.h> // gBS
 #include <Library/VirtioLib.h>           // Virtio10WriteFeatures()
 
 #include "VirtioFsDxe.h"
@@ -531,8 +532,7 @@ VirtioFsSgListsValidate (
                             more response bytes than ResponseSgList->TotalSize.
 
   @return                   Error codes propagated from
-                            VirtioMapAllBytesInSharedBuffer(), VirtioFlush(),
-                            or VirtioFs->Virtio->UnmapSharedBuffer().
+                            VirtioFsSgListsSubmitMultiple().
 **/
 EFI_STATUS
 VirtioFsSgListsSubmit (
@@ -540,158 +540,320 @@ VirtioFsSgListsSubmit (
   IN OUT VIRTIO_FS_SCATTER_GATHER_LIST  *RequestSgList,
   IN OUT VIRTIO_FS_SCATTER_GATHER_LIST  *ResponseSgList OPTIONAL
   )
+{
+  VIRTIO_FS_EXCHANGE  Exchange;
+
+  Exchange.RequestSgList  = RequestSgList;
+  Exchange.ResponseSgList = ResponseSgList;
+  return VirtioFsSgListsSubmitMultiple (VirtioFs, &Exchange, 1);
+}
+
+/**
+  Submit several validated request-response exchanges to the Virtio Filesystem
+  device at once, and wait until the device completes all of them.
+
+  The descriptor chains of all exchanges are placed on the request queue
+  before the device is notified, so that the device may process the requests
+  concurrently, and complete them in any order.
+
+  On input, the request and response lists of each exchange must have been
+  validated together, using the VirtioFsSgListsValidate() function.
+
+  On output, the VIRTIO_FS_IO_VECTOR fields are updated exactly like by
+  VirtioFsSgListsSubmit(), for every exchange.
+
+  The function may only be called after VirtioFsInit() returns successfully and
+  before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device that the exchanges
+                           should be submitted to.
+
+  @param[in,out] Exchange  Array of NumExchanges exchanges. The caller is
+                           responsible for populating the RequestSgList and
+                           ResponseSgList fields of each element.
+
+  @param[in] NumExchanges  The number of elements in Exchange.
+
+  @retval EFI_SUCCESS       All exchanges complete. The caller should
+                            investigate the response buffers like after
+                            VirtioFsSgListsSubmit().
+
+  @retval EFI_UNSUPPORTED   The exchanges need more descriptors in total than
+                            VirtioFs->QueueSize.
+
+  @retval EFI_DEVICE_ERROR  The Virtio Filesystem device reported populating
+                            more response bytes than the TotalSize field of an
+                            exchange's ResponseSgList, or completed a
+                            descriptor chain that we didn't submit.
+
+  @return                   Error codes propagated from
+                            VirtioMapAllBytesInSharedBuffer(),
+                            VirtioFs->Virtio->SetQueueNotify(), or
+                            VirtioFs->Virtio->UnmapSharedBuffer().
+**/
+EFI_STATUS
+VirtioFsSgListsSubmitMultiple (
+  IN OUT VIRTIO_FS           *VirtioFs,
+  IN OUT VIRTIO_FS_EXCHANGE  *Exchange,
+  IN     UINTN               NumExchanges
+  )
 {
   VIRTIO_FS_SCATTER_GATHER_LIST  *SgListParam[2];
   VIRTIO_MAP_OPERATION           SgListVirtioMapOp[ARRAY_SIZE (SgListParam)];
   UINT16                         SgListDescriptorFlag[ARRAY_SIZE (SgListParam)];
+  UINTN                          ExchangeIdx;
   UINTN                          ListId;
   VIRTIO_FS_SCATTER_GATHER_LIST  *SgList;
   UINTN                          IoVecIdx;
   VIRTIO_FS_IO_VECTOR            *IoVec;
   EFI_STATUS                     Status;
+  UINTN                          DescriptorsNeeded;
   DESC_INDICES                   Indices;
+  VRING                          *Ring;
+  UINT16                         NextAvailIdx;
+  UINT16                         LastUsedIdx;
+  UINTN                          Pending;
+  UINTN                          PollPeriodUsecs;
   UINT32                         TotalBytesWrittenByDevice;
   UINT32                         BytesPermittedForWrite;
 
-  SgListParam[0]          = RequestSgList;
   SgListVirtioMapOp[0]    = VirtioOperationBusMasterRead;
   SgListDescriptorFlag[0] = 0;
 
-  SgListParam[1]          = ResponseSgList;
   SgListVirtioMapOp[1]    = VirtioOperationBusMasterWrite;
   SgListDescriptorFlag[1] = VRING_DESC_F_WRITE;
 
   //
-  // Map all IO Vectors.
+  // VirtioFsSgListsValidate() made sure that each exchange fits on the queue
+  // in isolation; check that all of them fit at the same time.
   //
-  for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
-      continue;
+  DescriptorsNeeded = 0;
+  for (ExchangeIdx = 0; ExchangeIdx < NumExchanges; ExchangeIdx++) {
+    DescriptorsNeeded += Exchange[ExchangeIdx].RequestSgList->NumVec;
+    if (Exchange[ExchangeIdx].ResponseSgList != NULL) {
+      DescriptorsNeeded += Exchange[ExchangeIdx].ResponseSgList->NumVec;
     }
+  }
 
-    for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
-      IoVec = &SgList->IoVec[IoVecIdx];
-      //
-      // Map this IO Vector.
-      //
-      Status = VirtioMapAllBytesInSharedBuffer (
-                 VirtioFs->Virtio,
-                 SgListVirtioMapOp[ListId],
-                 IoVec->Buffer,
-                 IoVec->Size,
-                 &IoVec->MappedAddress,
-                 &IoVec->Mapping
-                 );
-      if (EFI_ERROR (Status)) {
-        goto Unmap;
+  if ((NumExchanges == 0) || (DescriptorsNeeded > VirtioFs->QueueSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Map all IO Vectors.
+  //
+  Status = EFI_SUCCESS;
+  for (ExchangeIdx = 0; ExchangeIdx < NumExchanges; ExchangeIdx++) {
+    SgListParam[0] = Exchange[ExchangeIdx].RequestSgList;
+    SgListParam[1] = Exchange[ExchangeIdx].ResponseSgList;
+
+    for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
+      SgList = SgListParam[ListId];
+      if (SgList == NULL) {
+        continue;
       }
 
-      IoVec->Mapped = TRUE;
+      for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
+        IoVec = &SgList->IoVec[IoVecIdx];
+        //
+        // Map this IO Vector.
+        //
+        Status = VirtioMapAllBytesInSharedBuffer (
+                   VirtioFs->Virtio,
+                   SgListVirtioMapOp[ListId],
+                   IoVec->Buffer,
+                   IoVec->Size,
+                   &IoVec->MappedAddress,
+                   &IoVec->Mapping
+                   );
+        if (EFI_ERROR (Status)) {
+          goto Unmap;
+        }
+
+        IoVec->Mapped = TRUE;
+      }
     }
   }
 
   //
-  // Compose the descriptor chain.
+  // Compose the descriptor chains back to back. All chains submitted earlier
+  // have been completed, so the descriptor table can be filled from entry #0.
   //
-  VirtioPrepare (&VirtioFs->Ring, &Indices);
-  for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
-      continue;
-    }
+  Ring = &VirtioFs->Ring;
+  VirtioPrepare (Ring, &Indices);
+  for (ExchangeIdx = 0; ExchangeIdx < NumExchanges; ExchangeIdx++) {
+    SgListParam[0] = Exchange[ExchangeIdx].RequestSgList;
+    SgListParam[1] = Exchange[ExchangeIdx].ResponseSgList;
 
-    for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
-      UINT16  NextFlag;
+    Exchange[ExchangeIdx].HeadDescIdx  = Indices.NextDescIdx % Ring->QueueSize;
+    Exchange[ExchangeIdx].Completed    = FALSE;
+    Exchange[ExchangeIdx].BytesWritten = 0;
 
-      IoVec = &SgList->IoVec[IoVecIdx];
-      //
-      // Set VRING_DESC_F_NEXT on all except the very last descriptor.
-      //
-      NextFlag = VRING_DESC_F_NEXT;
-      if ((ListId == ARRAY_SIZE (SgListParam) - 1) &&
-          (IoVecIdx == SgList->NumVec - 1))
-      {
-        NextFlag = 0;
+    for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
+      SgList = SgListParam[ListId];
+      if (SgList == NULL) {
+        continue;
       }
 
-      VirtioAppendDesc (
-        &VirtioFs->Ring,
-        IoVec->MappedAddress,
-        (UINT32)IoVec->Size,
-        SgListDescriptorFlag[ListId] | NextFlag,
-        &Indices
-        );
+      for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
+        UINT16  NextFlag;
+
+        IoVec = &SgList->IoVec[IoVecIdx];
+        //
+        // Set VRING_DESC_F_NEXT on all except the very last descriptor of
+        // the chain.
+        //
+        NextFlag = VRING_DESC_F_NEXT;
+        if (((ListId == ARRAY_SIZE (SgListParam) - 1) ||
+             (SgListParam[ARRAY_SIZE (SgListParam) - 1] == NULL)) &&
+            (IoVecIdx == SgList->NumVec - 1))
+        {
+          NextFlag = 0;
+        }
+
+        VirtioAppendDesc (
+          Ring,
+          IoVec->MappedAddress,
+          (UINT32)IoVec->Size,
+          SgListDescriptorFlag[ListId] | NextFlag,
+          &Indices
+          );
+      }
     }
   }
 
   //
-  // Submit the descriptor chain.
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring -- one entry per head
+  // descriptor.
   //
-  Status = VirtioFlush (
-             VirtioFs->Virtio,
-             VIRTIO_FS_REQUEST_QUEUE,
-             &VirtioFs->Ring,
-             &Indices,
-             &TotalBytesWrittenByDevice
-             );
-  if (EFI_ERROR (Status)) {
-    goto Unmap;
+  NextAvailIdx = *Ring->Avail.Idx;
+  LastUsedIdx  = NextAvailIdx;
+  for (ExchangeIdx = 0; ExchangeIdx < NumExchanges; ExchangeIdx++) {
+    Ring->Avail.Ring[NextAvailIdx++ % Ring->QueueSize] =
+      Exchange[ExchangeIdx].HeadDescIdx;
   }
 
   //
-  // Sanity-check: the Virtio Filesystem device should not have written more
-  // bytes than what we offered buffers for.
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field, and 2.4.1.4 Notifying the
+  // Device -- a single notification covers all chains.
   //
-  if (ResponseSgList == NULL) {
-    BytesPermittedForWrite = 0;
-  } else {
-    BytesPermittedForWrite = ResponseSgList->TotalSize;
-  }
+  MemoryFence ();
+  *Ring->Avail.Idx = NextAvailIdx;
 
-  if (TotalBytesWrittenByDevice > BytesPermittedForWrite) {
-    Status = EFI_DEVICE_ERROR;
+  MemoryFence ();
+  Status = VirtioFs->Virtio->SetQueueNotify (
+                               VirtioFs->Virtio,
+                               VIRTIO_FS_REQUEST_QUEUE
+                               );
+  if (EFI_ERROR (Status)) {
     goto Unmap;
   }
 
   //
-  // Update the transfer sizes in the IO Vectors.
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device. The device
+  // may complete the chains in any order; match each used element to its
+  // exchange by head descriptor index. Keep slowing down the polling until we
+  // reach a poll period of slightly above 1 ms, but start over after each
+  // completion, as the rest of the chains are likely to follow shortly.
   //
-  for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
+  Pending         = NumExchanges;
+  PollPeriodUsecs = 1;
+  MemoryFence ();
+  while (Pending > 0) {
+    volatile CONST VRING_USED_ELEM  *UsedElem;
+
+    if (*Ring->Used.Idx == LastUsedIdx) {
+      gBS->Stall (PollPeriodUsecs);
+      if (PollPeriodUsecs < 1024) {
+        PollPeriodUsecs *= 2;
+      }
+
+      MemoryFence ();
       continue;
     }
 
-    for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
-      IoVec = &SgList->IoVec[IoVecIdx];
-      if (SgListVirtioMapOp[ListId] == VirtioOperationBusMasterRead) {
-        //
-        // We report that the Virtio Filesystem device has read all buffers in
-        // the request.
-        //
-        IoVec->Transferred = IoVec->Size;
-      } else {
-        //
-        // Regarding the response, calculate how much of the current IO Vector
-        // has been populated by the Virtio Filesystem device. In
-        // "TotalBytesWrittenByDevice", VirtioFlush() reported the total count
-        // across all device-writeable descriptors, in the order they were
-        // chained on the ring.
-        //
-        IoVec->Transferred = MIN (
-                               (UINTN)TotalBytesWrittenByDevice,
-                               IoVec->Size
-                               );
-        TotalBytesWrittenByDevice -= (UINT32)IoVec->Transferred;
+    UsedElem = &Ring->Used.UsedElem[LastUsedIdx++ % Ring->QueueSize];
+    for (ExchangeIdx = 0; ExchangeIdx < NumExchanges; ExchangeIdx++) {
+      if (!Exchange[ExchangeIdx].Completed &&
+          (Exchange[ExchangeIdx].HeadDescIdx == UsedElem->Id))
+      {
+        break;
       }
     }
+
+    if (ExchangeIdx == NumExchanges) {
+      ASSERT (FALSE);
+      Status = EFI_DEVICE_ERROR;
+      goto Unmap;
+    }
+
+    Exchange[ExchangeIdx].Completed    = TRUE;
+    Exchange[ExchangeIdx].BytesWritten = UsedElem->Len;
+    Pending--;
+    PollPeriodUsecs = 1;
   }
 
-  //
-  // By now, "TotalBytesWrittenByDevice" has been exhausted.
-  //
-  ASSERT (TotalBytesWrittenByDevice == 0);
+  MemoryFence ();
+
+  for (ExchangeIdx = 0; ExchangeIdx < NumExchanges; ExchangeIdx++) {
+    SgListParam[0] = Exchange[ExchangeIdx].RequestSgList;
+    SgListParam[1] = Exchange[ExchangeIdx].ResponseSgList;
+
+    //
+    // Sanity-check: the Virtio Filesystem device should not have written more
+    // bytes than what we offered buffers for.
+    //
+    TotalBytesWrittenByDevice = Exchange[ExchangeIdx].BytesWritten;
+    if (SgListParam[1] == NULL) {
+      BytesPermittedForWrite = 0;
+    } else {
+      BytesPermittedForWrite = SgListParam[1]->TotalSize;
+    }
+
+    if (TotalBytesWrittenByDevice > BytesPermittedForWrite) {
+      Status = EFI_DEVICE_ERROR;
+      goto Unmap;
+    }
+
+    //
+    // Update the transfer sizes in the IO Vectors.
+    //
+    for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
+      SgList = SgListParam[ListId];
+      if (SgList == NULL) {
+        continue;
+      }
+
+      for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
+        IoVec = &SgList->IoVec[IoVecIdx];
+        if (SgListVirtioMapOp[ListId] == VirtioOperationBusMasterRead) {
+          //
+          // We report that the Virtio Filesystem device has read all buffers
+          // in the request.
+          //
+          IoVec->Transferred = IoVec->Size;
+        } else {
+          //
+          // Regarding the response, calculate how much of the current IO
+          // Vector has been populated by the Virtio Filesystem device. The
+          // used element reported the total count across all
+          // device-writeable descriptors, in the order they were chained on
+          // the ring.
+          //
+          IoVec->Transferred = MIN (
+                                 (UINTN)TotalBytesWrittenByDevice,
+                                 IoVec->Size
+                                 );
+          TotalBytesWrittenByDevice -= (UINT32)IoVec->Transferred;
+        }
+      }
+    }
+
+    //
+    // By now, "TotalBytesWrittenByDevice" has been exhausted.
+    //
+    ASSERT (TotalBytesWrittenByDevice == 0);
+  }
 
   //
   // We've succeeded; fall through.
@@ -702,49 +864,54 @@ Unmap:
   // unmapping occurs in reverse order of mapping, in an attempt to avoid
   // memory fragmentation.
   //
-  ListId = ARRAY_SIZE (SgListParam);
-  while (ListId > 0) {
-    --ListId;
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
-      continue;
-    }
-
-    IoVecIdx = SgList->NumVec;
-    while (IoVecIdx > 0) {
-      EFI_STATUS  UnmapStatus;
-
-      --IoVecIdx;
-      IoVec = &SgList->IoVec[IoVecIdx];
-      //
-      // Unmap this IO Vector, if it has been mapped.
-      //
-      if (!IoVec->Mapped) {
+  ExchangeIdx = NumExchanges;
+  while (ExchangeIdx > 0) {
+    --ExchangeIdx;
+    SgListParam[0] = Exchange[ExchangeIdx].RequestSgList;
+    SgListParam[1] = Exchange[ExchangeIdx].ResponseSgList;
+
+    ListId = ARRAY_SIZE (SgListParam);
+    while (ListId > 0) {
+      --ListId;
+      SgList = SgListParam[ListId];
+      if (SgList == NULL) {
         continue;
       }
 
-      UnmapStatus = VirtioFs->Virtio->UnmapSharedBuffer (
-                                        VirtioFs->Virtio,
-                                        IoVec->Mapping
-                                        );
-      //
-      // Re-set the following fields to the values they initially got from
-      // VirtioFsSgListsValidate() -- the above unmapping attempt is considered
-      // final, even if it fails.
-      //
-      IoVec->Mapped        = FALSE;
-      IoVec->MappedAddress = 0;
-      IoVec->Mapping       = NULL;
+      IoVecIdx = SgList->NumVec;
+      while (IoVecIdx > 0) {
+        EFI_STATUS  UnmapStatus;
 
-      //
-      // If we are on the success path, but the unmapping failed, we need to
-      // transparently flip to the failure path -- the caller must learn they
-      // should not consult the response buffers.
-      //
-      // The branch below can be taken at most once.
-      //
-      if (!EFI_ERROR (Status) && EFI_ERROR (UnmapStatus)) {
-        Status = UnmapStatus;
+        --IoVecIdx;
+        IoVec = &SgList->IoVec[IoVecIdx];
+        //
+        // Unmap this IO Vector, if it has been mapped.
+        //
+        if (!IoVec->Mapped) {
+          continue;
+        }
+
+        UnmapStatus = VirtioFs->Virtio->UnmapSharedBuffer (
+                                          VirtioFs->Virtio,
+                                          IoVec->Mapping
+                                          );
+        //
+        // Re-set the following fields to the values they initially got from
+        // VirtioFsSgListsValidate() -- the above unmapping attempt is
+        // considered final, even if it fails.
+        //
+        IoVec->Mapped        = FALSE;
+        IoVec->MappedAddress = 0;
+        IoVec->Mapping       = NULL;
+
+        //
+        // If we are on the success path, but the unmapping failed, we need to
+        // transparently flip to the failure path -- the caller must learn
+        // they should not consult the response buffers.
+        //
+        if (!EFI_ERROR (Status) && EFI_ERROR (UnmapStatus)) {
+          Status = UnmapStatus;
+        }
       }
     }
   }
@@ -752,6 +919,59 @@ Unmap:
   return Status;
 }
 
+/**
+  Calculate how many requests, each consisting of DescriptorsPerRequest
+  buffers, VirtioFsSgListsSubmitMultiple() can accept at once.
+
+  @param[in] VirtioFs               The Virtio Filesystem device.
+
+  @param[in] DescriptorsPerRequest  The number of buffers (request and
+                                    response together) that a single exchange
+                                    uses.
+
+  @return  The number of exchanges that fit on the request queue, capped at
+           VIRTIO_FS_MAX_IN_FLIGHT. At least 1 is returned, so that
+           VirtioFsSgListsValidate() reports the error if even a single
+           exchange does not fit.
+**/
+UINTN
+VirtioFsMaxInFlight (
+  IN VIRTIO_FS  *VirtioFs,
+  IN UINTN      DescriptorsPerRequest
+  )
+{
+  UINTN  MaxInFlight;
+
+  MaxInFlight = VirtioFs->QueueSize / DescriptorsPerRequest;
+  return MAX (1, MIN (MaxInFlight, VIRTIO_FS_MAX_IN_FLIGHT));
+}
+
+/**
+  Drop the read-ahead buffer contents of every open VIRTIO_FS_FILE that refers
+  to NodeId, after the file has been modified through this driver.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device whose open files
+                           should be checked.
+
+  @param[in] NodeId        The inode number of the modified file.
+**/
+VOID
+VirtioFsInvalidateReadAhead (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  )
+{
+  LIST_ENTRY      *Entry;
+  VIRTIO_FS_FILE  *VirtioFsFile;
+
+  BASE_LIST_FOR_EACH (Entry, &VirtioFs->OpenFiles) {
+    VirtioFsFile = VIRTIO_FS_FILE_FROM_OPEN_FILES_ENTRY (Entry);
+    if (VirtioFsFile->NodeId == NodeId) {
+      VirtioFsFile->ReadAheadSize = 0;
+    }
+  }
+}
+
 /**
   Set up the fields of a new VIRTIO_FS_FUSE_REQUEST object.
 
@@ -1666,8 +1886,9 @@ FreeRhsPath8:
   successfully and before VirtioFsUninit() is called.
 
   @param[in,out] VirtioFs    The Virtio Filesystem device to send FUSE_LOOKUP
-                             and FUSE_FORGET requests to. On output, the FUSE
-                             request counter "VirtioFs->RequestId" will have
+                             and FUSE_FORGET requests to, unless the lookup
+                             cache can answer them. On output, the FUSE
+                             request counter "VirtioFs->RequestId" may have
                              been incremented several times.
 
   @param[in,out] Path        The canonical pathname (as defined in the
@@ -1678,10 +1899,10 @@ FreeRhsPath8:
 
   @param[out] DirNodeId      The NodeId of the most specific parent directory
                              identified by Path. The caller is responsible for
-                             sending a FUSE_FORGET request to the Virtio
-                             Filesystem device for DirNodeId -- unless
-                             DirNodeId equals VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID
-                             --, when DirNodeId's use ends.
+                             releasing DirNodeId with VirtioFsForget() --
+                             unless DirNodeId equals
+                             VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID --, when
+                             DirNodeId's use ends.
 
   @param[out] LastComponent  A pointer into Path, pointing at the start of the
                              last pathname component.
@@ -1694,7 +1915,7 @@ FreeRhsPath8:
                                  is not a directory.
 
   @return                        Error codes propagated from
-                                 VirtioFsFuseLookup() and
+                                 VirtioFsLookup() and
                                  VirtioFsFuseAttrToEfiFileInfo().
 **/
 EFI_STATUS
@@ -1735,7 +1956,7 @@ VirtioFsLookupMostSpecificParentDir (
     // up.
     //
     *NextSlash = '\0';
-    Status     = VirtioFsFuseLookup (
+    Status     = VirtioFsLookup (
                    VirtioFs,
                    ParentDirNodeId,
                    Slash + 1,
@@ -1748,7 +1969,7 @@ VirtioFsLookupMostSpecificParentDir (
     // We're done with the directory inode that was the basis for the lookup.
     //
     if (ParentDirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-      VirtioFsFuseForget (VirtioFs, ParentDirNodeId);
+      VirtioFsForget (VirtioFs, ParentDirNodeId);
     }
 
     //
@@ -1789,7 +2010,7 @@ VirtioFsLookupMostSpecificParentDir (
   return EFI_SUCCESS;
 
 ForgetNextDirNodeId:
-  VirtioFsFuseForget (VirtioFs, NextDirNodeId);
+  VirtioFsForget (VirtioFs, NextDirNodeId);
   return Status;
 }
 
@@ -0,0 +1,658 @@
+/** @file
+  Lookup and attribute cache for the Virtio Filesystem device.
+
+  Resolving a pathname costs one FUSE_LOOKUP round trip per pathname component,
+  and EFI_FILE_PROTOCOL.GetInfo() costs a FUSE_GETATTR round trip. The Virtio
+  Filesystem device reports, with every such response, for how long the result
+  may be cached ("entry_valid" and "attr_valid"). This file caches the
+  (parent directory, filename) to inode translations and the inode attributes
+  for that long.
+
+  Every FUSE_LOOKUP (and every other request that returns an inode, such as
+  FUSE_CREATE, FUSE_MKDIR and FUSE_READDIRPLUS) increments a lookup count on
+  the device side, which FUSE_FORGET has to decrement eventually. For this
+  reason, inodes are tracked in VIRTIO_FS_NODE objects that accumulate the
+  lookup count, and count the claims on the inode -- by cached translations,
+  open files, and pathname walks in progress. The accumulated lookup count is
+  returned to the device in a single FUSE_FORGET request when the last claim
+  is dropped.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>             // AsciiStrCmp()
+#include <Library/BaseMemoryLib.h>       // CopyMem()
+#include <Library/MemoryAllocationLib.h> // AllocatePool()
+#include <Library/TimerLib.h>            // GetPerformanceCounter()
+
+#include "VirtioFsDxe.h"
+
+/**
+  Return the current time in nanoseconds, on the TimerLib time scale.
+**/
+STATIC
+UINT64
+GetTimeNs (
+  VOID
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Calculate the expiry time of a cached item from a FUSE validity duration.
+
+  @param[in] Now      The current time, from GetTimeNs().
+
+  @param[in] Seconds  The seconds part of the validity duration.
+
+  @param[in] Nsec     The nanoseconds part of the validity duration.
+
+  @return  The time from which on the item may no longer be used, saturated
+           at MAX_UINT64.
+**/
+STATIC
+UINT64
+GetExpiry (
+  IN UINT64  Now,
+  IN UINT64  Seconds,
+  IN UINT32  Nsec
+  )
+{
+  UINT64  Duration;
+
+  if (Seconds >= DivU64x32 (MAX_UINT64 - Nsec, 1000000000)) {
+    return MAX_UINT64;
+  }
+
+  Duration = MultU64x32 (Seconds, 1000000000) + Nsec;
+  if (Duration >= MAX_UINT64 - Now) {
+    return MAX_UINT64;
+  }
+
+  return Now + Duration;
+}
+
+/**
+  Find the VIRTIO_FS_NODE object for NodeId.
+
+  @return  The VIRTIO_FS_NODE object, or NULL if NodeId is not tracked.
+**/
+STATIC
+VIRTIO_FS_NODE *
+FindNode (
+  IN VIRTIO_FS  *VirtioFs,
+  IN UINT64     NodeId
+  )
+{
+  LIST_ENTRY      *Entry;
+  VIRTIO_FS_NODE  *Node;
+
+  BASE_LIST_FOR_EACH (Entry, &VirtioFs->Nodes) {
+    Node = VIRTIO_FS_NODE_FROM_NODES_ENTRY (Entry);
+    if (Node->NodeId == NodeId) {
+      return Node;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Take a claim on NodeId, accounting for Lookups new device-side lookups.
+
+  @return  The VIRTIO_FS_NODE object for NodeId, or NULL if memory allocation
+           failed. In the latter case the caller's reference remains untracked,
+           and VirtioFsForget() will send FUSE_FORGET for it directly.
+**/
+STATIC
+VIRTIO_FS_NODE *
+AcquireNode (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId,
+  IN     UINT64     Lookups
+  )
+{
+  VIRTIO_FS_NODE  *Node;
+
+  Node = FindNode (VirtioFs, NodeId);
+  if (Node == NULL) {
+    Node = AllocatePool (sizeof *Node);
+    if (Node == NULL) {
+      return NULL;
+    }
+
+    Node->Signature = VIRTIO_FS_NODE_SIG;
+    Node->NodeId    = NodeId;
+    Node->Lookups   = 0;
+    Node->Claims    = 0;
+    Node->AttrValid = FALSE;
+    InsertHeadList (&VirtioFs->Nodes, &Node->NodesEntry);
+  }
+
+  Node->Lookups += Lookups;
+  Node->Claims++;
+  return Node;
+}
+
+STATIC
+VOID
+ReleaseNode (
+  IN OUT VIRTIO_FS       *VirtioFs,
+  IN OUT VIRTIO_FS_NODE  *Node
+  );
+
+/**
+  Remove a VIRTIO_FS_DENTRY object from the cache, dropping its claim on the
+  inode it translates to.
+**/
+STATIC
+VOID
+RemoveDentry (
+  IN OUT VIRTIO_FS         *VirtioFs,
+  IN OUT VIRTIO_FS_DENTRY  *Dentry
+  )
+{
+  VIRTIO_FS_NODE  *Node;
+
+  RemoveEntryList (&Dentry->DentriesEntry);
+  VirtioFs->NumDentries--;
+
+  Node = Dentry->Node;
+  FreePool (Dentry->Name);
+  FreePool (Dentry);
+  ReleaseNode (VirtioFs, Node);
+}
+
+/**
+  Drop a claim on an inode. When the last claim is dropped, return all lookups
+  of the inode to the device with FUSE_FORGET, and drop the cached
+  translations of the names in the inode (which the device may no longer
+  consider a directory it knows).
+**/
+STATIC
+VOID
+ReleaseNode (
+  IN OUT VIRTIO_FS       *VirtioFs,
+  IN OUT VIRTIO_FS_NODE  *Node
+  )
+{
+  LIST_ENTRY        *Entry;
+  VIRTIO_FS_DENTRY  *Dentry;
+
+  ASSERT (Node->Claims > 0);
+  Node->Claims--;
+  if (Node->Claims > 0) {
+    return;
+  }
+
+  //
+  // Removing a dentry may recursively remove others, so restart the scan
+  // after each removal.
+  //
+  Entry = GetFirstNode (&VirtioFs->Dentries);
+  while (!IsNull (&VirtioFs->Dentries, Entry)) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_DENTRIES_ENTRY (Entry);
+    if (Dentry->ParentNodeId == Node->NodeId) {
+      RemoveDentry (VirtioFs, Dentry);
+      Entry = GetFirstNode (&VirtioFs->Dentries);
+      continue;
+    }
+
+    Entry = GetNextNode (&VirtioFs->Dentries, Entry);
+  }
+
+  if (Node->Lookups > 0) {
+    VirtioFsFuseForget (VirtioFs, Node->NodeId, Node->Lookups);
+  }
+
+  RemoveEntryList (&Node->NodesEntry);
+  FreePool (Node);
+}
+
+/**
+  Find the cached translation of Name in the directory DirNodeId.
+
+  @return  The VIRTIO_FS_DENTRY object, or NULL if there is none. The returned
+           object may have expired.
+**/
+STATIC
+VIRTIO_FS_DENTRY *
+FindDentry (
+  IN VIRTIO_FS    *VirtioFs,
+  IN UINT64       DirNodeId,
+  IN CONST CHAR8  *Name
+  )
+{
+  LIST_ENTRY        *Entry;
+  VIRTIO_FS_DENTRY  *Dentry;
+
+  BASE_LIST_FOR_EACH (Entry, &VirtioFs->Dentries) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_DENTRIES_ENTRY (Entry);
+    if ((Dentry->ParentNodeId == DirNodeId) &&
+        (AsciiStrCmp (Dentry->Name, Name) == 0))
+    {
+      return Dentry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Cache the translation of Name (of NameLen characters, not necessarily
+  NUL-terminated) in the directory DirNodeId to Node, replacing any earlier
+  translation of the same name. If the cache grows beyond
+  VIRTIO_FS_LOOKUP_CACHE_SIZE, the least recently used translations are
+  dropped.
+
+  The caller is responsible for holding a claim on Node. Failure to allocate
+  memory is not reported; the translation is not cached then.
+**/
+STATIC
+VOID
+InsertDentry (
+  IN OUT VIRTIO_FS       *VirtioFs,
+  IN     UINT64          DirNodeId,
+  IN     CONST CHAR8     *Name,
+  IN     UINTN           NameLen,
+  IN OUT VIRTIO_FS_NODE  *Node,
+  IN     UINT64          EntryExpiry
+  )
+{
+  VIRTIO_FS_DENTRY  *Dentry;
+  CHAR8             *NameCopy;
+
+  NameCopy = AllocatePool (NameLen + 1);
+  if (NameCopy == NULL) {
+    return;
+  }
+
+  CopyMem (NameCopy, Name, NameLen);
+  NameCopy[NameLen] = '\0';
+
+  Dentry = FindDentry (VirtioFs, DirNodeId, NameCopy);
+  if (Dentry != NULL) {
+    RemoveDentry (VirtioFs, Dentry);
+  }
+
+  Dentry = AllocatePool (sizeof *Dentry);
+  if (Dentry == NULL) {
+    FreePool (NameCopy);
+    return;
+  }
+
+  Dentry->Signature    = VIRTIO_FS_DENTRY_SIG;
+  Dentry->ParentNodeId = DirNodeId;
+  Dentry->Name         = NameCopy;
+  Dentry->Node         = Node;
+  Dentry->EntryExpiry  = EntryExpiry;
+  Node->Claims++;
+  InsertHeadList (&VirtioFs->Dentries, &Dentry->DentriesEntry);
+  VirtioFs->NumDentries++;
+
+  while (VirtioFs->NumDentries > VIRTIO_FS_LOOKUP_CACHE_SIZE) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_DENTRIES_ENTRY (
+               GetPreviousNode (&VirtioFs->Dentries, &VirtioFs->Dentries)
+               );
+    RemoveDentry (VirtioFs, Dentry);
+  }
+}
+
+/**
+  Resolve a filename to an inode, using the lookup cache if possible, and
+  sending a FUSE_LOOKUP request to the Virtio Filesystem device otherwise.
+
+  The interface is identical to that of VirtioFsFuseLookup(), except that the
+  inode number is output directly, and that the caller is responsible for
+  releasing the inode number with VirtioFsForget() (and not with
+  VirtioFsFuseForget()).
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] DirNodeId     The inode number of the directory in which Name
+                           should be resolved to an inode.
+
+  @param[in] Name          The single-component filename to resolve in the
+                           directory identified by DirNodeId.
+
+  @param[out] NodeId       The inode number which Name has been resolved to.
+
+  @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
+                           describing the properties of the resolved inode.
+
+  @retval EFI_SUCCESS    Filename to inode resolution successful.
+
+  @retval EFI_NOT_FOUND  The Virtio Filesystem device explicitly reported
+                         ENOENT -- "No such file or directory".
+
+  @return                Error codes propagated from VirtioFsFuseLookup() and
+                         VirtioFsGetAttr().
+**/
+EFI_STATUS
+VirtioFsLookup (
+  IN OUT VIRTIO_FS                        *VirtioFs,
+  IN     UINT64                           DirNodeId,
+  IN     CHAR8                            *Name,
+  OUT UINT64                              *NodeId,
+  OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
+  )
+{
+  UINT64                        Now;
+  VIRTIO_FS_DENTRY              *Dentry;
+  VIRTIO_FS_NODE                *Node;
+  EFI_STATUS                    Status;
+  VIRTIO_FS_FUSE_NODE_RESPONSE  NodeResp;
+
+  Now    = GetTimeNs ();
+  Dentry = FindDentry (VirtioFs, DirNodeId, Name);
+  if ((Dentry != NULL) && (Now < Dentry->EntryExpiry)) {
+    VirtioFs->LookupHits++;
+
+    //
+    // Mark the translation most recently used, and claim the inode for the
+    // caller.
+    //
+    RemoveEntryList (&Dentry->DentriesEntry);
+    InsertHeadList (&VirtioFs->Dentries, &Dentry->DentriesEntry);
+    Node = Dentry->Node;
+    Node->Claims++;
+
+    //
+    // The attributes may have a shorter lifetime than the translation.
+    //
+    Status = VirtioFsGetAttr (VirtioFs, Node->NodeId, FuseAttr);
+    if (EFI_ERROR (Status)) {
+      ReleaseNode (VirtioFs, Node);
+      return Status;
+    }
+
+    *NodeId = Node->NodeId;
+    return EFI_SUCCESS;
+  }
+
+  VirtioFs->LookupMisses++;
+  Status = VirtioFsFuseLookup (VirtioFs, DirNodeId, Name, &NodeResp, FuseAttr);
+  if (EFI_ERROR (Status)) {
+    if ((Status == EFI_NOT_FOUND) && (Dentry != NULL)) {
+      RemoveDentry (VirtioFs, Dentry);
+    }
+
+    return Status;
+  }
+
+  *NodeId = NodeResp.NodeId;
+  Node    = AcquireNode (VirtioFs, NodeResp.NodeId, 1);
+  if (Node == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  CopyMem (&Node->Attr, FuseAttr, sizeof *FuseAttr);
+  Node->AttrValid  = TRUE;
+  Node->AttrExpiry = GetExpiry (Now, NodeResp.AttrValid, NodeResp.AttrValidNsec);
+
+  if ((NodeResp.EntryValid > 0) || (NodeResp.EntryValidNsec > 0)) {
+    InsertDentry (
+      VirtioFs,
+      DirNodeId,
+      Name,
+      AsciiStrLen (Name),
+      Node,
+      GetExpiry (Now, NodeResp.EntryValid, NodeResp.EntryValidNsec)
+      );
+  } else {
+    Dentry = FindDentry (VirtioFs, DirNodeId, Name);
+    if (Dentry != NULL) {
+      RemoveDentry (VirtioFs, Dentry);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Fetch the attributes of an inode, using the attribute cache if possible, and
+  sending a FUSE_GETATTR request to the Virtio Filesystem device otherwise.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode number for which the attributes should be
+                           retrieved.
+
+  @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
+                           describing the properties of the inode.
+
+  @retval EFI_SUCCESS  FuseAttr has been filled in.
+
+  @return              Error codes propagated from VirtioFsFuseGetAttr().
+**/
+EFI_STATUS
+VirtioFsGetAttr (
+  IN OUT VIRTIO_FS                        *VirtioFs,
+  IN     UINT64                           NodeId,
+  OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
+  )
+{
+  UINT64                           Now;
+  VIRTIO_FS_NODE                   *Node;
+  EFI_STATUS                       Status;
+  VIRTIO_FS_FUSE_GETATTR_RESPONSE  GetAttrResp;
+
+  Now  = GetTimeNs ();
+  Node = FindNode (VirtioFs, NodeId);
+  if ((Node != NULL) && Node->AttrValid && (Now < Node->AttrExpiry)) {
+    VirtioFs->AttrHits++;
+    CopyMem (FuseAttr, &Node->Attr, sizeof *FuseAttr);
+    return EFI_SUCCESS;
+  }
+
+  VirtioFs->AttrMisses++;
+  Status = VirtioFsFuseGetAttr (VirtioFs, NodeId, &GetAttrResp, FuseAttr);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Node != NULL) {
+    CopyMem (&Node->Attr, FuseAttr, sizeof *FuseAttr);
+    Node->AttrValid  = TRUE;
+    Node->AttrExpiry = GetExpiry (
+                         Now,
+                         GetAttrResp.AttrValid,
+                         GetAttrResp.AttrValidNsec
+                         );
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Account for an inode number that the Virtio Filesystem device returned in
+  response to a request other than FUSE_LOOKUP, such as FUSE_CREATE or
+  FUSE_MKDIR. The caller is responsible for releasing the inode number with
+  VirtioFsForget().
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode number returned by the device.
+**/
+VOID
+VirtioFsTrackNode (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  )
+{
+  AcquireNode (VirtioFs, NodeId, 1);
+}
+
+/**
+  Release an inode number that the caller obtained from VirtioFsLookup(), or
+  registered with VirtioFsTrackNode(). The Virtio Filesystem device is sent
+  FUSE_FORGET when the inode is no longer used by any caller, nor by the
+  lookup cache.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode number to release.
+**/
+VOID
+VirtioFsForget (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  )
+{
+  VIRTIO_FS_NODE  *Node;
+
+  Node = FindNode (VirtioFs, NodeId);
+  if (Node == NULL) {
+    VirtioFsFuseForget (VirtioFs, NodeId, 1);
+    return;
+  }
+
+  ReleaseNode (VirtioFs, Node);
+}
+
+/**
+  Take over the inode reference carried by a FUSE_READDIRPLUS directory entry,
+  caching the translation and the attributes that come with it.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] DirNodeId     The inode number of the directory that has been
+                           read.
+
+  @param[in] Dirent        The directory entry. The caller is responsible for
+                           ensuring that Dirent->Namelen describes valid
+                           storage.
+**/
+VOID
+VirtioFsCacheDirent (
+  IN OUT VIRTIO_FS                           *VirtioFs,
+  IN     UINT64                              DirNodeId,
+  IN     VIRTIO_FS_FUSE_DIRENTPLUS_RESPONSE  *Dirent
+  )
+{
+  UINT64                        Now;
+  VIRTIO_FS_FUSE_NODE_RESPONSE  *NodeResp;
+  VIRTIO_FS_NODE                *Node;
+
+  //
+  // The "." and ".." entries carry no inode reference.
+  //
+  NodeResp = &Dirent->NodeResp;
+  if (NodeResp->NodeId == 0) {
+    return;
+  }
+
+  Now  = GetTimeNs ();
+  Node = AcquireNode (VirtioFs, NodeResp->NodeId, 1);
+  if (Node == NULL) {
+    VirtioFsFuseForget (VirtioFs, NodeResp->NodeId, 1);
+    return;
+  }
+
+  CopyMem (&Node->Attr, &Dirent->AttrResp, sizeof Node->Attr);
+  Node->AttrValid  = TRUE;
+  Node->AttrExpiry = GetExpiry (Now, NodeResp->AttrValid, NodeResp->AttrValidNsec);
+
+  if ((NodeResp->EntryValid > 0) || (NodeResp->EntryValidNsec > 0)) {
+    InsertDentry (
+      VirtioFs,
+      DirNodeId,
+      (CONST CHAR8 *)(Dirent + 1),
+      Dirent->Namelen,
+      Node,
+      GetExpiry (Now, NodeResp->EntryValid, NodeResp->EntryValidNsec)
+      );
+  }
+
+  //
+  // Drop our own claim; the cached translation (if any) keeps the inode.
+  //
+  ReleaseNode (VirtioFs, Node);
+}
+
+/**
+  Drop the cached translation of Name in the directory DirNodeId, after the
+  name has been removed or renamed through this driver.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] DirNodeId     The inode number of the directory.
+
+  @param[in] Name          The single-component filename.
+**/
+VOID
+VirtioFsInvalidateLookup (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     DirNodeId,
+  IN     CHAR8      *Name
+  )
+{
+  VIRTIO_FS_DENTRY  *Dentry;
+
+  Dentry = FindDentry (VirtioFs, DirNodeId, Name);
+  if (Dentry != NULL) {
+    RemoveDentry (VirtioFs, Dentry);
+  }
+}
+
+/**
+  Drop the cached attributes of an inode, after the inode has been modified
+  through this driver.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode number.
+**/
+VOID
+VirtioFsInvalidateAttr (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  )
+{
+  VIRTIO_FS_NODE  *Node;
+
+  Node = FindNode (VirtioFs, NodeId);
+  if (Node != NULL) {
+    Node->AttrValid = FALSE;
+  }
+}
+
+/**
+  Drop all cached translations, returning the inode references they hold to
+  the Virtio Filesystem device. The function is called when no files are open
+  any longer, before the device is reset.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+**/
+VOID
+VirtioFsPurgeLookupCache (
+  IN OUT VIRTIO_FS  *VirtioFs
+  )
+{
+  VIRTIO_FS_DENTRY  *Dentry;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: Label=\"%s\" LookupHits=%Lu LookupMisses=%Lu AttrHits=%Lu "
+    "AttrMisses=%Lu\n",
+    __func__,
+    VirtioFs->Label,
+    VirtioFs->LookupHits,
+    VirtioFs->LookupMisses,
+    VirtioFs->AttrHits,
+    VirtioFs->AttrMisses
+    ));
+
+  while (!IsListEmpty (&VirtioFs->Dentries)) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_DENTRIES_ENTRY (
+               GetFirstNode (&VirtioFs->Dentries)
+               );
+    RemoveDentry (VirtioFs, Dentry);
+  }
+
+  //
+  // With no files open, no claims should remain.
+  //
+  ASSERT (IsListEmpty (&VirtioFs->Nodes));
+}
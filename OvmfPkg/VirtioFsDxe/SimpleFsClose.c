@@ -62,7 +62,7 @@ VirtioFsSimpleFileClose (
   // now we should ask the server to forget it *once*.
   //
   if (VirtioFsFile->NodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, VirtioFsFile->NodeId);
+    VirtioFsForget (VirtioFs, VirtioFsFile->NodeId);
   }
 
   //
@@ -75,6 +75,10 @@ VirtioFsSimpleFileClose (
     FreePool (VirtioFsFile->FileInfoArray);
   }
 
+  if (VirtioFsFile->ReadAheadBuffer != NULL) {
+    FreePool (VirtioFsFile->ReadAheadBuffer);
+  }
+
   FreePool (VirtioFsFile);
   return EFI_SUCCESS;
 }
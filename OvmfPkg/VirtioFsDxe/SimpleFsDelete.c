@@ -78,8 +78,10 @@ VirtioFsSimpleFileDelete (
                  LastComponent,
                  VirtioFsFile->IsDirectory
                  );
+      VirtioFsInvalidateLookup (VirtioFs, ParentNodeId, LastComponent);
+      VirtioFsInvalidateAttr (VirtioFs, VirtioFsFile->NodeId);
       if (ParentNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-        VirtioFsFuseForget (VirtioFs, ParentNodeId);
+        VirtioFsForget (VirtioFs, ParentNodeId);
       }
     }
 
@@ -98,7 +100,7 @@ VirtioFsSimpleFileDelete (
   // also ask the server to forget it *once*.
   //
   if (VirtioFsFile->NodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, VirtioFsFile->NodeId);
+    VirtioFsForget (VirtioFs, VirtioFsFile->NodeId);
   }
 
   //
@@ -111,6 +113,10 @@ VirtioFsSimpleFileDelete (
     FreePool (VirtioFsFile->FileInfoArray);
   }
 
+  if (VirtioFsFile->ReadAheadBuffer != NULL) {
+    FreePool (VirtioFsFile->ReadAheadBuffer);
+  }
+
   FreePool (VirtioFsFile);
   return Status;
 }
@@ -57,7 +57,7 @@ OpenRootDirectory (
     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  FuseAttr;
     EFI_FILE_INFO                       FileInfo;
 
-    Status = VirtioFsFuseGetAttr (
+    Status = VirtioFsGetAttr (
                VirtioFs,
                VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID,
                &FuseAttr
@@ -153,7 +153,7 @@ OpenExistentFileOrDirectory (
   BOOLEAN                             IsDirectory;
   UINT64                              NewFuseHandle;
 
-  Status = VirtioFsFuseLookup (
+  Status = VirtioFsLookup (
              VirtioFs,
              DirNodeId,
              Name,
@@ -202,7 +202,7 @@ OpenExistentFileOrDirectory (
   return EFI_SUCCESS;
 
 ForgetResolvedNodeId:
-  VirtioFsFuseForget (VirtioFs, ResolvedNodeId);
+  VirtioFsForget (VirtioFs, ResolvedNodeId);
   return (Status == EFI_NOT_FOUND) ? EFI_DEVICE_ERROR : Status;
 }
 
@@ -248,6 +248,8 @@ CreateDirectory (
     return Status;
   }
 
+  VirtioFsTrackNode (VirtioFs, NewChildDirNodeId);
+
   Status = VirtioFsFuseOpenDir (VirtioFs, NewChildDirNodeId, &NewFuseHandle);
   if (EFI_ERROR (Status)) {
     goto RemoveNewChildDir;
@@ -259,7 +261,7 @@ CreateDirectory (
 
 RemoveNewChildDir:
   VirtioFsFuseRemoveFileOrDir (VirtioFs, DirNodeId, Name, TRUE /* IsDir */);
-  VirtioFsFuseForget (VirtioFs, NewChildDirNodeId);
+  VirtioFsForget (VirtioFs, NewChildDirNodeId);
   return Status;
 }
 
@@ -296,13 +298,21 @@ CreateRegularFile (
   OUT UINT64        *FuseHandle
   )
 {
-  return VirtioFsFuseOpenOrCreate (
-           VirtioFs,
-           DirNodeId,
-           Name,
-           NodeId,
-           FuseHandle
-           );
+  EFI_STATUS  Status;
+
+  Status = VirtioFsFuseOpenOrCreate (
+             VirtioFs,
+             DirNodeId,
+             Name,
+             NodeId,
+             FuseHandle
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  VirtioFsTrackNode (VirtioFs, *NodeId);
+  return EFI_SUCCESS;
 }
 
 EFI_STATUS
@@ -524,7 +534,7 @@ VirtioFsSimpleFileOpen (
   // Regardless of the branch taken, we're done with DirNodeId.
   //
   if (DirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, DirNodeId);
+    VirtioFsForget (VirtioFs, DirNodeId);
   }
 
   if (EFI_ERROR (Status)) {
@@ -557,6 +567,14 @@ VirtioFsSimpleFileOpen (
   NewVirtioFsFile->SingleFileInfoSize     = 0;
   NewVirtioFsFile->NumFileInfo            = 0;
   NewVirtioFsFile->NextFileInfo           = 0;
+  NewVirtioFsFile->MaxNamelen             = 0;
+  NewVirtioFsFile->ReadAheadBuffer        = NULL;
+  NewVirtioFsFile->ReadAheadOffset        = 0;
+  NewVirtioFsFile->ReadAheadSize          = 0;
+  NewVirtioFsFile->ReadAheadFileSize      = 0;
+  NewVirtioFsFile->ReadAheadMtime         = 0;
+  NewVirtioFsFile->ReadAheadMtimeNsec     = 0;
+  NewVirtioFsFile->ReadEndPosition        = 0;
 
   //
   // One more file is now open for the filesystem.
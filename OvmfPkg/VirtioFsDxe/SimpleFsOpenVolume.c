@@ -82,6 +82,14 @@ VirtioFsOpenVolume (
   VirtioFsFile->SingleFileInfoSize     = 0;
   VirtioFsFile->NumFileInfo            = 0;
   VirtioFsFile->NextFileInfo           = 0;
+  VirtioFsFile->MaxNamelen             = 0;
+  VirtioFsFile->ReadAheadBuffer        = NULL;
+  VirtioFsFile->ReadAheadOffset        = 0;
+  VirtioFsFile->ReadAheadSize          = 0;
+  VirtioFsFile->ReadAheadFileSize      = 0;
+  VirtioFsFile->ReadAheadMtime         = 0;
+  VirtioFsFile->ReadAheadMtimeNsec     = 0;
+  VirtioFsFile->ReadEndPosition        = 0;
 
   //
   // One more file open for the filesystem.
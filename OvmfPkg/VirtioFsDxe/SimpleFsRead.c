@@ -72,6 +72,7 @@ RefillFileInfoCache (
   VIRTIO_FS                       *VirtioFs;
   EFI_STATUS                      Status;
   VIRTIO_FS_FUSE_STATFS_RESPONSE  FilesysAttr;
+  UINT32                          MaxNamelen;
   UINT32                          DirentBufSize;
   UINT8                           *DirentBuf;
   UINTN                           SingleFileInfoSize;
@@ -85,17 +86,21 @@ RefillFileInfoCache (
   // VIRTIO_FS_FILE_MAX_FILE_INFO directory entries, based on the maximum
   // filename length supported by the filesystem. Note that the multiplication
   // is safe from overflow due to the VIRTIO_FS_FUSE_DIRENTPLUS_RESPONSE_SIZE()
-  // check.
+  // check. The maximum filename length is fetched only for the first refill;
+  // it does not change while the directory is open.
   //
   VirtioFs = VirtioFsFile->OwnerFs;
-  Status   = VirtioFsFuseStatFs (VirtioFs, VirtioFsFile->NodeId, &FilesysAttr);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  if (VirtioFsFile->MaxNamelen == 0) {
+    Status = VirtioFsFuseStatFs (VirtioFs, VirtioFsFile->NodeId, &FilesysAttr);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    VirtioFsFile->MaxNamelen = FilesysAttr.Namelen;
   }
 
-  DirentBufSize = (UINT32)VIRTIO_FS_FUSE_DIRENTPLUS_RESPONSE_SIZE (
-                            FilesysAttr.Namelen
-                            );
+  MaxNamelen    = VirtioFsFile->MaxNamelen;
+  DirentBufSize = (UINT32)VIRTIO_FS_FUSE_DIRENTPLUS_RESPONSE_SIZE (MaxNamelen);
   if (DirentBufSize == 0) {
     return EFI_UNSUPPORTED;
   }
@@ -115,14 +120,20 @@ RefillFileInfoCache (
   // calculation takes the L'\0' character that we'll need to append into
   // account.
   //
+  // The cache has been fully consumed when we get here, so the array of a
+  // previous refill, which has the same element size, is reused.
+  //
   SingleFileInfoSize = (OFFSET_OF (EFI_FILE_INFO, FileName) +
-                        ((UINTN)FilesysAttr.Namelen + 1) * sizeof (CHAR16));
-  FileInfoArray = AllocatePool (
-                    VIRTIO_FS_FILE_MAX_FILE_INFO * SingleFileInfoSize
-                    );
+                        ((UINTN)MaxNamelen + 1) * sizeof (CHAR16));
+  FileInfoArray = VirtioFsFile->FileInfoArray;
   if (FileInfoArray == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto FreeDirentBuf;
+    FileInfoArray = AllocatePool (
+                      VIRTIO_FS_FILE_MAX_FILE_INFO * SingleFileInfoSize
+                      );
+    if (FileInfoArray == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto FreeDirentBuf;
+    }
   }
 
   //
@@ -198,7 +209,7 @@ RefillFileInfoCache (
         goto FreeFileInfoArray;
       }
 
-      if (Dirent->Namelen > FilesysAttr.Namelen) {
+      if (Dirent->Namelen > MaxNamelen) {
         //
         // This is possible without tripping the truncation check above, due to
         // how entries are padded. The condition means that Dirent->Namelen is
@@ -239,14 +250,14 @@ RefillFileInfoCache (
       }
 
       //
-      // Make the Virtio Filesystem device forget the NodeId in this directory
-      // entry, as we'll need it no more. (The "." and ".." entries need no
-      // FUSE_FORGET requests, when returned by FUSE_READDIRPLUS -- and so the
-      // Virtio Filesystem device reports their NodeId fields as zero.)
+      // Hand the NodeId in this directory entry over to the lookup cache; a
+      // subsequent Open() of the entry may not need a FUSE_LOOKUP then. The
+      // cache sends FUSE_FORGET for the NodeId when it drops the entry. (The
+      // "." and ".." entries need no FUSE_FORGET requests, when returned by
+      // FUSE_READDIRPLUS -- and so the Virtio Filesystem device reports their
+      // NodeId fields as zero.)
       //
-      if (Dirent->NodeResp.NodeId != 0) {
-        VirtioFsFuseForget (VirtioFs, Dirent->NodeResp.NodeId);
-      }
+      VirtioFsCacheDirent (VirtioFs, VirtioFsFile->NodeId, Dirent);
 
       //
       // Advance to the next entry in DirentBuf.
@@ -275,10 +286,6 @@ RefillFileInfoCache (
   //
   // Commit the results. (Note that the result may be an empty cache.)
   //
-  if (VirtioFsFile->FileInfoArray != NULL) {
-    FreePool (VirtioFsFile->FileInfoArray);
-  }
-
   VirtioFsFile->FileInfoArray      = FileInfoArray;
   VirtioFsFile->SingleFileInfoSize = SingleFileInfoSize;
   VirtioFsFile->NumFileInfo        = NumFileInfo;
@@ -289,7 +296,15 @@ RefillFileInfoCache (
   return EFI_SUCCESS;
 
 FreeFileInfoArray:
-  FreePool (FileInfoArray);
+  if (FileInfoArray == VirtioFsFile->FileInfoArray) {
+    //
+    // Keep the reused array, but mark its contents invalid.
+    //
+    VirtioFsFile->NumFileInfo  = 0;
+    VirtioFsFile->NextFileInfo = 0;
+  } else {
+    FreePool (FileInfoArray);
+  }
 
 FreeDirentBuf:
   FreePool (DirentBuf);
@@ -362,6 +377,54 @@ ReadFileInfoCache (
   return EFI_SUCCESS;
 }
 
+/**
+  Fill the read-ahead buffer of a regular file, starting at Position.
+**/
+STATIC
+EFI_STATUS
+RefillReadAhead (
+  IN OUT VIRTIO_FS_FILE                      *VirtioFsFile,
+  IN     UINT64                              Position,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       ReadSize;
+
+  if (VirtioFsFile->ReadAheadBuffer == NULL) {
+    VirtioFsFile->ReadAheadBuffer = AllocatePool (VIRTIO_FS_READ_AHEAD_SIZE);
+    if (VirtioFsFile->ReadAheadBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  //
+  // Drop the old contents first, so that an error doesn't leave a partially
+  // overwritten buffer behind.
+  //
+  VirtioFsFile->ReadAheadSize = 0;
+
+  ReadSize = VIRTIO_FS_READ_AHEAD_SIZE;
+  Status   = VirtioFsFuseReadFileMultiple (
+               VirtioFsFile->OwnerFs,
+               VirtioFsFile->NodeId,
+               VirtioFsFile->FuseHandle,
+               Position,
+               &ReadSize,
+               VirtioFsFile->ReadAheadBuffer
+               );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  VirtioFsFile->ReadAheadOffset    = Position;
+  VirtioFsFile->ReadAheadSize      = ReadSize;
+  VirtioFsFile->ReadAheadFileSize  = FuseAttr->Size;
+  VirtioFsFile->ReadAheadMtime     = FuseAttr->Mtime;
+  VirtioFsFile->ReadAheadMtimeNsec = FuseAttr->MtimeNsec;
+  return EFI_SUCCESS;
+}
+
 /**
   Read from a regular file.
 **/
@@ -376,6 +439,7 @@ ReadRegularFile (
   VIRTIO_FS                           *VirtioFs;
   EFI_STATUS                          Status;
   VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  FuseAttr;
+  UINT64                              Position;
   UINTN                               Transferred;
   UINTN                               Left;
 
@@ -383,40 +447,84 @@ ReadRegularFile (
   //
   // The UEFI spec forbids reads that start beyond the end of the file.
   //
-  Status = VirtioFsFuseGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
+  Status = VirtioFsGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
   if (EFI_ERROR (Status) || (VirtioFsFile->FilePosition > FuseAttr.Size)) {
     return EFI_DEVICE_ERROR;
   }
 
+  //
+  // Forget the read-ahead buffer contents if the file has changed since the
+  // buffer was filled.
+  //
+  if ((VirtioFsFile->ReadAheadFileSize != FuseAttr.Size) ||
+      (VirtioFsFile->ReadAheadMtime != FuseAttr.Mtime) ||
+      (VirtioFsFile->ReadAheadMtimeNsec != FuseAttr.MtimeNsec))
+  {
+    VirtioFsFile->ReadAheadSize = 0;
+  }
+
   Status      = EFI_SUCCESS;
+  Position    = VirtioFsFile->FilePosition;
   Transferred = 0;
   Left        = *BufferSize;
   while (Left > 0) {
-    UINT32  ReadSize;
+    UINTN  ReadSize;
 
     //
-    // FUSE_READ cannot express a >=4GB buffer size.
+    // Serve what we can from the read-ahead buffer.
     //
-    ReadSize = (UINT32)MIN ((UINTN)MAX_UINT32, Left);
-    Status   = VirtioFsFuseReadFileOrDir (
-                 VirtioFs,
-                 VirtioFsFile->NodeId,
-                 VirtioFsFile->FuseHandle,
-                 FALSE,                                  // IsDir
-                 VirtioFsFile->FilePosition + Transferred,
-                 &ReadSize,
-                 (UINT8 *)Buffer + Transferred
-                 );
-    if (EFI_ERROR (Status) || (ReadSize == 0)) {
-      break;
+    if ((Position >= VirtioFsFile->ReadAheadOffset) &&
+        (Position - VirtioFsFile->ReadAheadOffset <
+         VirtioFsFile->ReadAheadSize))
+    {
+      UINTN  BufferOffset;
+
+      BufferOffset = (UINTN)(Position - VirtioFsFile->ReadAheadOffset);
+      ReadSize     = MIN (Left, VirtioFsFile->ReadAheadSize - BufferOffset);
+      CopyMem (
+        (UINT8 *)Buffer + Transferred,
+        VirtioFsFile->ReadAheadBuffer + BufferOffset,
+        ReadSize
+        );
+    } else if ((Left < VIRTIO_FS_READ_AHEAD_SIZE) &&
+               (VirtioFsFile->FilePosition == VirtioFsFile->ReadEndPosition))
+    {
+      //
+      // A small read continuing the previous one; fetch more than requested,
+      // expecting the next read to pick up where this one ends.
+      //
+      Status = RefillReadAhead (VirtioFsFile, Position, &FuseAttr);
+      if (EFI_ERROR (Status) || (VirtioFsFile->ReadAheadSize == 0)) {
+        break;
+      }
+
+      continue;
+    } else {
+      //
+      // Large or random access reads go directly to the caller's buffer.
+      //
+      ReadSize = Left;
+      Status   = VirtioFsFuseReadFileMultiple (
+                   VirtioFs,
+                   VirtioFsFile->NodeId,
+                   VirtioFsFile->FuseHandle,
+                   Position,
+                   &ReadSize,
+                   (UINT8 *)Buffer + Transferred
+                   );
+      if (EFI_ERROR (Status) || (ReadSize == 0)) {
+        break;
+      }
     }
 
+    Position    += ReadSize;
     Transferred += ReadSize;
     Left        -= ReadSize;
   }
 
-  *BufferSize                 = Transferred;
-  VirtioFsFile->FilePosition += Transferred;
+  *BufferSize                   = Transferred;
+  VirtioFsFile->FilePosition   += Transferred;
+  VirtioFsFile->ReadEndPosition = VirtioFsFile->FilePosition;
   //
   // If we managed to read some data, return success. If zero bytes were
   // transferred due to zero-sized buffer on input or due to EOF on first read,
@@ -307,6 +307,9 @@ Rename (
     goto ForgetNewParentDirNodeId;
   }
 
+  VirtioFsInvalidateLookup (VirtioFs, OldParentDirNodeId, OldLastComponent);
+  VirtioFsInvalidateLookup (VirtioFs, NewParentDirNodeId, NewLastComponent);
+
   //
   // Swap in the new canonical pathname.
   //
@@ -320,12 +323,12 @@ Rename (
   //
 ForgetNewParentDirNodeId:
   if (NewParentDirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, NewParentDirNodeId);
+    VirtioFsForget (VirtioFs, NewParentDirNodeId);
   }
 
 ForgetOldParentDirNodeId:
   if (OldParentDirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, OldParentDirNodeId);
+    VirtioFsForget (VirtioFs, OldParentDirNodeId);
   }
 
 FreeDestination:
@@ -383,7 +386,7 @@ UpdateAttributes (
   // Fetch the current attributes first, so we can build the difference between
   // them and NewFileInfo.
   //
-  Status = VirtioFsFuseGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
+  Status = VirtioFsGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -457,6 +460,7 @@ UpdateAttributes (
              UpdateMtime    ? &Mtime    : NULL,
              UpdateMode     ? &Mode     : NULL
              );
+  VirtioFsInvalidateAttr (VirtioFs, VirtioFsFile->NodeId);
   return Status;
 }
 
@@ -60,7 +60,7 @@ VirtioFsSimpleFileSetPosition (
   // Caller is requesting a seek to EOF.
   //
   VirtioFs = VirtioFsFile->OwnerFs;
-  Status   = VirtioFsFuseGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
+  Status   = VirtioFsGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -37,13 +37,14 @@ VirtioFsSimpleFileWrite (
   Transferred = 0;
   Left        = *BufferSize;
   while (Left > 0) {
-    UINT32  WriteSize;
+    UINTN  WriteSize;
 
     //
-    // Honor the write buffer size limit.
+    // VirtioFsFuseWriteMultiple() honors the write buffer size limit, and
+    // keeps several chunks in flight.
     //
-    WriteSize = (UINT32)MIN ((UINTN)VirtioFs->MaxWrite, Left);
-    Status    = VirtioFsFuseWrite (
+    WriteSize = Left;
+    Status    = VirtioFsFuseWriteMultiple (
                   VirtioFs,
                   VirtioFsFile->NodeId,
                   VirtioFsFile->FuseHandle,
@@ -68,6 +69,12 @@ VirtioFsSimpleFileWrite (
 
   *BufferSize                 = Transferred;
   VirtioFsFile->FilePosition += Transferred;
+  //
+  // Chunks beyond a failed or short one may have reached the file too.
+  //
+  VirtioFsInvalidateReadAhead (VirtioFs, VirtioFsFile->NodeId);
+  VirtioFsInvalidateAttr (VirtioFs, VirtioFsFile->NodeId);
+
   //
   // According to the UEFI spec,
   //
@@ -22,6 +22,12 @@
 #define VIRTIO_FS_FILE_SIG \
   SIGNATURE_64 ('V', 'I', 'O', 'F', 'S', 'F', 'I', 'L')
 
+#define VIRTIO_FS_NODE_SIG \
+  SIGNATURE_64 ('V', 'I', 'O', 'F', 'S', 'N', 'O', 'D')
+
+#define VIRTIO_FS_DENTRY_SIG \
+  SIGNATURE_64 ('V', 'I', 'O', 'F', 'S', 'D', 'E', 'N')
+
 //
 // The following limit applies to two kinds of pathnames.
 //
@@ -51,6 +57,25 @@
 //
 #define VIRTIO_FS_FILE_MAX_FILE_INFO  256
 
+//
+// Maximum number of FUSE_READ / FUSE_WRITE requests that we place on the
+// request queue at once, when a large transfer is split into chunks. The queue
+// size may impose a lower limit.
+//
+#define VIRTIO_FS_MAX_IN_FLIGHT  16
+
+//
+// Size of the read-ahead buffer that is allocated for a regular file when it
+// is read sequentially in small pieces.
+//
+#define VIRTIO_FS_READ_AHEAD_SIZE  SIZE_256KB
+
+//
+// Maximum number of (parent directory, filename) to inode translations kept in
+// the lookup cache.
+//
+#define VIRTIO_FS_LOOKUP_CACHE_SIZE  256
+
 //
 // Filesystem label encoded in UCS-2, transformed from the UTF-8 representation
 // in "VIRTIO_FS_CONFIG.Tag", and NUL-terminated. Only the printable ASCII code
@@ -81,6 +106,16 @@ typedef struct {
   EFI_EVENT                          ExitBoot;  // DriverBindingStart  0
   LIST_ENTRY                         OpenFiles; // DriverBindingStart  0
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL    SimpleFs;  // DriverBindingStart  0
+  //
+  // Lookup and attribute cache; see LookupCache.c.
+  //
+  LIST_ENTRY                         Nodes;        // DriverBindingStart  0
+  LIST_ENTRY                         Dentries;     // DriverBindingStart  0
+  UINTN                              NumDentries;  // DriverBindingStart  0
+  UINT64                             LookupHits;   // DriverBindingStart  0
+  UINT64                             LookupMisses; // DriverBindingStart  0
+  UINT64                             AttrHits;     // DriverBindingStart  0
+  UINT64                             AttrMisses;   // DriverBindingStart  0
 } VIRTIO_FS;
 
 #define VIRTIO_FS_FROM_SIMPLE_FS(SimpleFsReference) \
@@ -132,6 +167,28 @@ typedef struct {
   UINT32                 TotalSize;
 } VIRTIO_FS_SCATTER_GATHER_LIST;
 
+//
+// Structure for describing one request-response exchange, when several
+// exchanges are submitted to the Virtio Filesystem device at once.
+//
+typedef struct {
+  //
+  // The following fields originate from the submitter. Both lists must have
+  // been validated with VirtioFsSgListsValidate().
+  //
+  VIRTIO_FS_SCATTER_GATHER_LIST    *RequestSgList;
+  VIRTIO_FS_SCATTER_GATHER_LIST    *ResponseSgList;
+  //
+  // The following fields are internal to VirtioFsSgListsSubmitMultiple().
+  // HeadDescIdx identifies the descriptor chain of the exchange on the ring;
+  // BytesWritten is the number of bytes the device reported populating in the
+  // response buffers.
+  //
+  UINT16                           HeadDescIdx;
+  BOOLEAN                          Completed;
+  UINT32                           BytesWritten;
+} VIRTIO_FS_EXCHANGE;
+
 //
 // Private context structure that exposes EFI_FILE_PROTOCOL on top of an open
 // FUSE file reference.
@@ -173,6 +230,27 @@ typedef struct {
   UINTN    SingleFileInfoSize;
   UINTN    NumFileInfo;
   UINTN    NextFileInfo;
+  //
+  // The maximum filename length in the directory, as reported by FUSE_STATFS
+  // when the EFI_FILE_INFO cache is first filled. Zero until then.
+  //
+  UINT32    MaxNamelen;
+  //
+  // Read-ahead buffer for a regular file. When the file is read sequentially
+  // (that is, a read starts at ReadEndPosition, where the previous read
+  // ended), small reads are served from ReadAheadBuffer, which holds
+  // ReadAheadSize bytes from file position ReadAheadOffset. The buffer is
+  // allocated when first needed. The file size and the modification time
+  // from when the buffer was filled are recorded, so that changes made to the
+  // file by other means are noticed.
+  //
+  UINT8     *ReadAheadBuffer;
+  UINT64    ReadAheadOffset;
+  UINTN     ReadAheadSize;
+  UINT64    ReadAheadFileSize;
+  UINT64    ReadAheadMtime;
+  UINT32    ReadAheadMtimeNsec;
+  UINT64    ReadEndPosition;
 } VIRTIO_FS_FILE;
 
 #define VIRTIO_FS_FILE_FROM_SIMPLE_FILE(SimpleFileReference) \
@@ -182,6 +260,53 @@ typedef struct {
   CR (OpenFilesEntryReference, VIRTIO_FS_FILE, OpenFilesEntry, \
     VIRTIO_FS_FILE_SIG);
 
+//
+// An inode that the Virtio Filesystem device has reported to us by way of
+// FUSE_LOOKUP (or a similar request), and that we have not yet told the device
+// to forget.
+//
+typedef struct {
+  UINT64                                Signature;
+  LIST_ENTRY                            NodesEntry;
+  UINT64                                NodeId;
+  //
+  // The number of lookups the device has counted for NodeId, to be passed
+  // back in FUSE_FORGET when Claims drops to zero. Claims counts the
+  // VIRTIO_FS_DENTRY objects and the other holders (open files, pathname
+  // walks) using NodeId.
+  //
+  UINT64                                Lookups;
+  UINTN                                 Claims;
+  //
+  // Attributes of the inode, valid until AttrExpiry (in nanoseconds, on the
+  // TimerLib time scale) if AttrValid is TRUE.
+  //
+  BOOLEAN                               AttrValid;
+  UINT64                                AttrExpiry;
+  VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE    Attr;
+} VIRTIO_FS_NODE;
+
+#define VIRTIO_FS_NODE_FROM_NODES_ENTRY(NodesEntryReference) \
+  CR (NodesEntryReference, VIRTIO_FS_NODE, NodesEntry, VIRTIO_FS_NODE_SIG);
+
+//
+// A cached translation of Name in the directory ParentNodeId to Node, valid
+// until EntryExpiry. The translation holds a claim on Node. Dentries are kept
+// in most recently used order.
+//
+typedef struct {
+  UINT64            Signature;
+  LIST_ENTRY        DentriesEntry;
+  UINT64            ParentNodeId;
+  CHAR8             *Name;
+  VIRTIO_FS_NODE    *Node;
+  UINT64            EntryExpiry;
+} VIRTIO_FS_DENTRY;
+
+#define VIRTIO_FS_DENTRY_FROM_DENTRIES_ENTRY(DentriesEntryReference) \
+  CR (DentriesEntryReference, VIRTIO_FS_DENTRY, DentriesEntry, \
+    VIRTIO_FS_DENTRY_SIG);
+
 //
 // Initialization and helper routines for the Virtio Filesystem device.
 //
@@ -217,6 +342,25 @@ VirtioFsSgListsSubmit (
   IN OUT VIRTIO_FS_SCATTER_GATHER_LIST  *ResponseSgList OPTIONAL
   );
 
+EFI_STATUS
+VirtioFsSgListsSubmitMultiple (
+  IN OUT VIRTIO_FS           *VirtioFs,
+  IN OUT VIRTIO_FS_EXCHANGE  *Exchange,
+  IN     UINTN               NumExchanges
+  );
+
+UINTN
+VirtioFsMaxInFlight (
+  IN VIRTIO_FS  *VirtioFs,
+  IN UINTN      DescriptorsPerRequest
+  );
+
+VOID
+VirtioFsInvalidateReadAhead (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  );
+
 EFI_STATUS
 VirtioFsFuseNewRequest (
   IN OUT VIRTIO_FS              *VirtioFs,
@@ -307,6 +451,63 @@ VirtioFsGetFuseModeUpdate (
   OUT UINT32            *Mode
   );
 
+//
+// Lookup and attribute cache routines.
+//
+
+EFI_STATUS
+VirtioFsLookup (
+  IN OUT VIRTIO_FS                        *VirtioFs,
+  IN     UINT64                           DirNodeId,
+  IN     CHAR8                            *Name,
+  OUT UINT64                              *NodeId,
+  OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
+  );
+
+EFI_STATUS
+VirtioFsGetAttr (
+  IN OUT VIRTIO_FS                        *VirtioFs,
+  IN     UINT64                           NodeId,
+  OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
+  );
+
+VOID
+VirtioFsTrackNode (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  );
+
+VOID
+VirtioFsForget (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  );
+
+VOID
+VirtioFsCacheDirent (
+  IN OUT VIRTIO_FS                           *VirtioFs,
+  IN     UINT64                              DirNodeId,
+  IN     VIRTIO_FS_FUSE_DIRENTPLUS_RESPONSE  *Dirent
+  );
+
+VOID
+VirtioFsInvalidateLookup (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     DirNodeId,
+  IN     CHAR8      *Name
+  );
+
+VOID
+VirtioFsInvalidateAttr (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId
+  );
+
+VOID
+VirtioFsPurgeLookupCache (
+  IN OUT VIRTIO_FS  *VirtioFs
+  );
+
 //
 // Wrapper functions for FUSE commands (primitives).
 //
@@ -316,20 +517,22 @@ VirtioFsFuseLookup (
   IN OUT VIRTIO_FS                        *VirtioFs,
   IN     UINT64                           DirNodeId,
   IN     CHAR8                            *Name,
-  OUT UINT64                              *NodeId,
+  OUT VIRTIO_FS_FUSE_NODE_RESPONSE        *NodeResp,
   OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
   );
 
 EFI_STATUS
 VirtioFsFuseForget (
   IN OUT VIRTIO_FS  *VirtioFs,
-  IN     UINT64     NodeId
+  IN     UINT64     NodeId,
+  IN     UINT64     NumberOfLookups
   );
 
 EFI_STATUS
 VirtioFsFuseGetAttr (
   IN OUT VIRTIO_FS                        *VirtioFs,
   IN     UINT64                           NodeId,
+  OUT VIRTIO_FS_FUSE_GETATTR_RESPONSE     *GetAttrResp,
   OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE  *FuseAttr
   );
 
@@ -378,6 +581,16 @@ VirtioFsFuseReadFileOrDir (
   OUT VOID          *Data
   );
 
+EFI_STATUS
+VirtioFsFuseReadFileMultiple (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId,
+  IN     UINT64     FuseHandle,
+  IN     UINT64     Offset,
+  IN OUT UINTN      *Size,
+  OUT VOID          *Data
+  );
+
 EFI_STATUS
 VirtioFsFuseWrite (
   IN OUT VIRTIO_FS  *VirtioFs,
@@ -388,6 +601,16 @@ VirtioFsFuseWrite (
   IN     VOID       *Data
   );
 
+EFI_STATUS
+VirtioFsFuseWriteMultiple (
+  IN OUT VIRTIO_FS  *VirtioFs,
+  IN     UINT64     NodeId,
+  IN     UINT64     FuseHandle,
+  IN     UINT64     Offset,
+  IN OUT UINTN      *Size,
+  IN     VOID       *Data
+  );
+
 EFI_STATUS
 VirtioFsFuseStatFs (
   IN OUT VIRTIO_FS                    *VirtioFs,
@@ -71,6 +71,21 @@ HASH_TABLE  mHash[] = {
 
 EFI_STRING  mHashTypeStr;
 
+//
+// Sorted lookup indexes of the "db", "dbx" and "dbt" signature databases.
+//
+SIGNATURE_DATABASE_INDEX  mSignatureDatabaseIndex[] = {
+  { EFI_IMAGE_SECURITY_DATABASE,  NULL, 0, NULL, 0, 0 },
+  { EFI_IMAGE_SECURITY_DATABASE1, NULL, 0, NULL, 0, 0 },
+  { EFI_IMAGE_SECURITY_DATABASE2, NULL, 0, NULL, 0, 0 }
+};
+
+//
+// Bumped for every image verification. The indexes are checked against the
+// database variables at most once per generation.
+//
+UINTN  mSignatureDatabaseGeneration = 1;
+
 /**
   SecureBoot Hook for processing image verification.
 
@@ -828,142 +843,377 @@ AddImageExeInfo (
 }
 
 /**
-  Check whether the hash of an given X.509 certificate is in forbidden database (DBX).
+  Compare a signature key against one entry of the signature database index.
 
-  @param[in]  Certificate       Pointer to X.509 Certificate that is searched for.
-  @param[in]  CertSize          Size of X.509 Certificate.
-  @param[in]  SignatureList     Pointer to the Signature List in forbidden database.
-  @param[in]  SignatureListSize Size of Signature List.
-  @param[out] RevocationTime    Return the time that the certificate was revoked.
-  @param[out] IsFound           Search result. Only valid if EFI_SUCCESS returned.
+  @param[in]  CertType            Pointer to the signature type of the key.
+  @param[in]  SignatureSize       Size of the key signature data.
+  @param[in]  Signature           Pointer to the key signature data, or NULL
+                                  to compare the signature type only.
+  @param[in]  KeySize             Number of leading bytes of the signature data
+                                  to compare, at most SignatureSize.
+  @param[in]  Entry               Index entry to compare with.
 
-  @retval EFI_SUCCESS           Finished the search without any error.
-  @retval Others                Error occurred in the search of database.
+  @retval 0                       The key matches the entry.
+  @retval <0                      The key sorts before the entry.
+  @retval >0                      The key sorts after the entry.
 
 **/
+STATIC
+INTN
+CompareSignatureKey (
+  IN CONST EFI_GUID               *CertType,
+  IN UINTN                        SignatureSize,
+  IN CONST UINT8                  *Signature OPTIONAL,
+  IN UINTN                        KeySize,
+  IN CONST SIGNATURE_INDEX_ENTRY  *Entry
+  )
+{
+  INTN   Result;
+  UINTN  EntrySize;
+
+  Result = CompareMem (CertType, &Entry->CertList->SignatureType, sizeof (EFI_GUID));
+  if ((Result != 0) || (Signature == NULL)) {
+    return Result;
+  }
+
+  EntrySize = Entry->CertList->SignatureSize - (sizeof (EFI_SIGNATURE_DATA) - 1);
+  if (SignatureSize != EntrySize) {
+    return (SignatureSize < EntrySize) ? -1 : 1;
+  }
+
+  return CompareMem (Signature, Entry->Cert->SignatureData, KeySize);
+}
+
+/**
+  Sort callback ordering signature database index entries.
+
+  Entries are grouped by signature type. X.509 certificates are tried one by
+  one rather than looked up, so they keep their database order. All other
+  entries are sorted by size and data. Entries with identical content keep
+  their database order, so a lookup returns the same entry as a linear scan
+  of the database would.
+
+  @param[in]  Buffer1             Pointer to the first SIGNATURE_INDEX_ENTRY.
+  @param[in]  Buffer2             Pointer to the second SIGNATURE_INDEX_ENTRY.
+
+  @return 0                       Buffer1 is equal to Buffer2.
+  @return <0                      Buffer1 is less than Buffer2.
+  @return >0                      Buffer1 is greater than Buffer2.
+
+**/
+STATIC
+INTN
+EFIAPI
+CompareSignatureIndexEntry (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST SIGNATURE_INDEX_ENTRY  *Entry1;
+  CONST SIGNATURE_INDEX_ENTRY  *Entry2;
+  UINTN                        Size1;
+  INTN                         Result;
+
+  Entry1 = (CONST SIGNATURE_INDEX_ENTRY *)Buffer1;
+  Entry2 = (CONST SIGNATURE_INDEX_ENTRY *)Buffer2;
+
+  Result = CompareSignatureKey (&Entry1->CertList->SignatureType, 0, NULL, 0, Entry2);
+  if (Result != 0) {
+    return Result;
+  }
+
+  if (!CompareGuid (&Entry1->CertList->SignatureType, &gEfiCertX509Guid)) {
+    Size1  = Entry1->CertList->SignatureSize - (sizeof (EFI_SIGNATURE_DATA) - 1);
+    Result = CompareSignatureKey (
+               &Entry1->CertList->SignatureType,
+               Size1,
+               Entry1->Cert->SignatureData,
+               Size1,
+               Entry2
+               );
+    if (Result != 0) {
+      return Result;
+    }
+  }
+
+  if ((UINTN)Entry1->Cert == (UINTN)Entry2->Cert) {
+    return 0;
+  }
+
+  return ((UINTN)Entry1->Cert < (UINTN)Entry2->Cert) ? -1 : 1;
+}
+
+/**
+  Rebuild the sorted lookup index of a signature database.
+
+  The signature lists are walked the same way the database was scanned
+  linearly before, so malformed trailing lists are ignored in the same manner.
+
+  @param[in, out]  Index          The index to rebuild. Data and DataSize must
+                                  already describe the new database content.
+
+  @retval EFI_SUCCESS             The index was rebuilt.
+  @retval EFI_OUT_OF_RESOURCES    No memory for the index entries.
+
+**/
+STATIC
 EFI_STATUS
-IsCertHashFoundInDbx (
-  IN  UINT8               *Certificate,
-  IN  UINTN               CertSize,
-  IN  EFI_SIGNATURE_LIST  *SignatureList,
-  IN  UINTN               SignatureListSize,
-  OUT EFI_TIME            *RevocationTime,
-  OUT BOOLEAN             *IsFound
+BuildSignatureDatabaseIndex (
+  IN OUT SIGNATURE_DATABASE_INDEX  *Index
   )
 {
-  EFI_STATUS          Status;
-  EFI_SIGNATURE_LIST  *DbxList;
-  UINTN               DbxSize;
-  EFI_SIGNATURE_DATA  *CertHash;
-  UINTN               CertHashCount;
-  UINTN               Index;
-  UINT32              HashAlg;
-  VOID                *HashCtx;
-  UINT8               CertDigest[MAX_DIGEST_SIZE];
-  UINT8               *DbxCertHash;
-  UINTN               SiglistHeaderSize;
-  UINT8               *TBSCert;
-  UINTN               TBSCertSize;
-
-  Status   = EFI_ABORTED;
-  *IsFound = FALSE;
-  DbxList  = SignatureList;
-  DbxSize  = SignatureListSize;
-  HashCtx  = NULL;
-  HashAlg  = HASHALG_MAX;
+  EFI_SIGNATURE_LIST     *CertList;
+  EFI_SIGNATURE_DATA     *Cert;
+  UINTN                  DataSize;
+  UINTN                  CertCount;
+  UINTN                  EntryCount;
+  UINTN                  Pass;
+  UINTN                  CertIndex;
+  SIGNATURE_INDEX_ENTRY  SwapEntry;
 
-  if ((RevocationTime == NULL) || (DbxList == NULL)) {
-    return EFI_INVALID_PARAMETER;
+  if (Index->Entries != NULL) {
+    FreePool (Index->Entries);
+    Index->Entries = NULL;
   }
 
+  Index->EntryCount = 0;
+
   //
-  // Retrieve the TBSCertificate from the X.509 Certificate.
+  // The first pass counts the entries, the second one fills in the index.
   //
-  if (!X509GetTBSCert (Certificate, CertSize, &TBSCert, &TBSCertSize)) {
-    return Status;
-  }
+  for (Pass = 0; Pass < 2; Pass++) {
+    EntryCount = 0;
+    DataSize   = Index->DataSize;
+    CertList   = (EFI_SIGNATURE_LIST *)Index->Data;
+    while ((DataSize >= sizeof (EFI_SIGNATURE_LIST)) &&
+           (DataSize >= CertList->SignatureListSize) &&
+           (CertList->SignatureListSize >= sizeof (EFI_SIGNATURE_LIST)))
+    {
+      if ((CertList->SignatureSize >= sizeof (EFI_SIGNATURE_DATA)) &&
+          (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) >= CertList->SignatureHeaderSize))
+      {
+        CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
+        Cert      = (EFI_SIGNATURE_DATA *)((UINT8 *)CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
+        for (CertIndex = 0; CertIndex < CertCount; CertIndex++) {
+          if (Pass == 1) {
+            Index->Entries[EntryCount].CertList = CertList;
+            Index->Entries[EntryCount].Cert     = Cert;
+          }
 
-  while ((DbxSize > 0) && (SignatureListSize >= DbxList->SignatureListSize)) {
-    //
-    // Determine Hash Algorithm of Certificate in the forbidden database.
-    //
-    if (CompareGuid (&DbxList->SignatureType, &gEfiCertX509Sha256Guid)) {
-      HashAlg = HASHALG_SHA256;
-    } else if (CompareGuid (&DbxList->SignatureType, &gEfiCertX509Sha384Guid)) {
-      HashAlg = HASHALG_SHA384;
-    } else if (CompareGuid (&DbxList->SignatureType, &gEfiCertX509Sha512Guid)) {
-      HashAlg = HASHALG_SHA512;
-    } else {
-      DbxSize -= DbxList->SignatureListSize;
-      DbxList  = (EFI_SIGNATURE_LIST *)((UINT8 *)DbxList + DbxList->SignatureListSize);
-      continue;
-    }
+          EntryCount++;
+          Cert = (EFI_SIGNATURE_DATA *)((UINT8 *)Cert + CertList->SignatureSize);
+        }
+      }
 
-    //
-    // Calculate the hash value of current TBSCertificate for comparision.
-    //
-    if (mHash[HashAlg].GetContextSize == NULL) {
-      goto Done;
+      DataSize -= CertList->SignatureListSize;
+      CertList  = (EFI_SIGNATURE_LIST *)((UINT8 *)CertList + CertList->SignatureListSize);
     }
 
-    ZeroMem (CertDigest, MAX_DIGEST_SIZE);
-    HashCtx = AllocatePool (mHash[HashAlg].GetContextSize ());
-    if (HashCtx == NULL) {
-      goto Done;
+    if (EntryCount == 0) {
+      return EFI_SUCCESS;
     }
 
-    if (!mHash[HashAlg].HashInit (HashCtx)) {
-      goto Done;
+    if (Pass == 0) {
+      Index->Entries = AllocatePool (EntryCount * sizeof (SIGNATURE_INDEX_ENTRY));
+      if (Index->Entries == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
     }
+  }
 
-    if (!mHash[HashAlg].HashUpdate (HashCtx, TBSCert, TBSCertSize)) {
-      goto Done;
-    }
+  QuickSort (
+    Index->Entries,
+    EntryCount,
+    sizeof (SIGNATURE_INDEX_ENTRY),
+    CompareSignatureIndexEntry,
+    &SwapEntry
+    );
+  Index->EntryCount = EntryCount;
 
-    if (!mHash[HashAlg].HashFinal (HashCtx, CertDigest)) {
-      goto Done;
+  return EFI_SUCCESS;
+}
+
+/**
+  Drop the snapshot and the lookup index of a signature database.
+
+  @param[in, out]  Index          The index to empty.
+
+**/
+STATIC
+VOID
+FreeSignatureDatabaseIndex (
+  IN OUT SIGNATURE_DATABASE_INDEX  *Index
+  )
+{
+  if (Index->Entries != NULL) {
+    FreePool (Index->Entries);
+    Index->Entries = NULL;
+  }
+
+  if (Index->Data != NULL) {
+    FreePool (Index->Data);
+    Index->Data = NULL;
+  }
+
+  Index->EntryCount = 0;
+  Index->DataSize   = 0;
+}
+
+/**
+  Return the lookup index of a signature database.
+
+  The index is checked against the database variable at most once per
+  image verification, that is once per mSignatureDatabaseGeneration. All
+  other lookups while verifying the same image use it without accessing
+  the variable.
+
+  @param[in]  VariableName        Name of database variable.
+  @param[out] Index               Returns the up-to-date index. Set to NULL
+                                  if the database does not exist.
+
+  @retval EFI_SUCCESS             The index is up to date or the database
+                                  does not exist.
+  @retval Others                  Error occurred reading the database.
+
+**/
+STATIC
+EFI_STATUS
+GetSignatureDatabaseIndex (
+  IN  CHAR16                    *VariableName,
+  OUT SIGNATURE_DATABASE_INDEX  **Index
+  )
+{
+  EFI_STATUS                Status;
+  SIGNATURE_DATABASE_INDEX  *Slot;
+  UINTN                     SlotIndex;
+  UINTN                     DataSize;
+  UINT8                     *Data;
+
+  *Index = NULL;
+  Slot   = NULL;
+  for (SlotIndex = 0; SlotIndex < ARRAY_SIZE (mSignatureDatabaseIndex); SlotIndex++) {
+    if (StrCmp (VariableName, mSignatureDatabaseIndex[SlotIndex].VariableName) == 0) {
+      Slot = &mSignatureDatabaseIndex[SlotIndex];
+      break;
     }
+  }
 
-    FreePool (HashCtx);
-    HashCtx = NULL;
+  ASSERT (Slot != NULL);
+  if (Slot == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Slot->Generation == mSignatureDatabaseGeneration) {
+    *Index = (Slot->Data != NULL) ? Slot : NULL;
+    return EFI_SUCCESS;
+  }
 
-    SiglistHeaderSize = sizeof (EFI_SIGNATURE_LIST) + DbxList->SignatureHeaderSize;
-    CertHash          = (EFI_SIGNATURE_DATA *)((UINT8 *)DbxList + SiglistHeaderSize);
-    CertHashCount     = (DbxList->SignatureListSize - SiglistHeaderSize) / DbxList->SignatureSize;
-    for (Index = 0; Index < CertHashCount; Index++) {
+  DataSize = 0;
+  Status   = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    if (Status == EFI_NOT_FOUND) {
       //
-      // Iterate each Signature Data Node within this CertList for verify.
+      // No database, no need to search.
       //
-      DbxCertHash = CertHash->SignatureData;
-      if (CompareMem (DbxCertHash, CertDigest, mHash[HashAlg].DigestLength) == 0) {
-        //
-        // Hash of Certificate is found in forbidden database.
-        //
-        Status   = EFI_SUCCESS;
-        *IsFound = TRUE;
+      FreeSignatureDatabaseIndex (Slot);
+      Slot->Generation = mSignatureDatabaseGeneration;
+      Status           = EFI_SUCCESS;
+    }
 
-        //
-        // Return the revocation time.
-        //
-        CopyMem (RevocationTime, (EFI_TIME *)(DbxCertHash + mHash[HashAlg].DigestLength), sizeof (EFI_TIME));
-        goto Done;
-      }
+    return Status;
+  }
 
-      CertHash = (EFI_SIGNATURE_DATA *)((UINT8 *)CertHash + DbxList->SignatureSize);
-    }
+  Data = (UINT8 *)AllocateZeroPool (DataSize);
+  if (Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-    DbxSize -= DbxList->SignatureListSize;
-    DbxList  = (EFI_SIGNATURE_LIST *)((UINT8 *)DbxList + DbxList->SignatureListSize);
+  Status = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, Data);
+  if (EFI_ERROR (Status)) {
+    FreePool (Data);
+    return Status;
   }
 
-  Status = EFI_SUCCESS;
+  //
+  // The database may have been updated since the previous image, even to
+  // content of the same size, so compare the whole snapshot. The index is
+  // only rebuilt when the content differs.
+  //
+  if ((Slot->Data != NULL) && (Slot->DataSize == DataSize) &&
+      (CompareMem (Slot->Data, Data, DataSize) == 0))
+  {
+    FreePool (Data);
+    Slot->Generation = mSignatureDatabaseGeneration;
+    *Index           = Slot;
+    return EFI_SUCCESS;
+  }
 
-Done:
-  if (HashCtx != NULL) {
-    FreePool (HashCtx);
+  FreeSignatureDatabaseIndex (Slot);
+  Slot->Data     = Data;
+  Slot->DataSize = DataSize;
+  Status         = BuildSignatureDatabaseIndex (Slot);
+  if (EFI_ERROR (Status)) {
+    FreeSignatureDatabaseIndex (Slot);
+    return Status;
   }
 
-  return Status;
+  DEBUG ((DEBUG_INFO, "DxeImageVerificationLib: indexed %lu signatures of %s\n", (UINT64)Slot->EntryCount, VariableName));
+
+  Slot->Generation = mSignatureDatabaseGeneration;
+  *Index           = Slot;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the first entry of a signature database index that matches a key.
+
+  @param[in]  Index               The signature database index to search.
+  @param[in]  CertType            Pointer to the signature type to search for.
+  @param[in]  SignatureSize       Size of the signature data of the entries.
+  @param[in]  Signature           Pointer to the signature data to search for,
+                                  or NULL to find the first entry of CertType.
+  @param[in]  KeySize             Number of leading bytes of the signature data
+                                  that have to match, at most SignatureSize.
+
+  @return The position of the first matching entry, or Index->EntryCount if
+          no entry matches.
+
+**/
+STATIC
+UINTN
+FindSignatureIndexEntry (
+  IN CONST SIGNATURE_DATABASE_INDEX  *Index,
+  IN CONST EFI_GUID                  *CertType,
+  IN UINTN                           SignatureSize,
+  IN CONST UINT8                     *Signature OPTIONAL,
+  IN UINTN                           KeySize
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  //
+  // Binary search for the first entry not sorting before the key.
+  //
+  Low  = 0;
+  High = Index->EntryCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (CompareSignatureKey (CertType, SignatureSize, Signature, KeySize, &Index->Entries[Middle]) > 0) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low == Index->EntryCount) ||
+      (CompareSignatureKey (CertType, SignatureSize, Signature, KeySize, &Index->Entries[Low]) != 0))
+  {
+    return Index->EntryCount;
+  }
+
+  return Low;
 }
 
 /**
@@ -988,81 +1238,180 @@ IsSignatureFoundInDatabase (
   OUT BOOLEAN   *IsFound
   )
 {
-  EFI_STATUS          Status;
-  EFI_SIGNATURE_LIST  *CertList;
-  EFI_SIGNATURE_DATA  *Cert;
-  UINTN               DataSize;
-  UINT8               *Data;
-  UINTN               Index;
-  UINTN               CertCount;
+  EFI_STATUS                Status;
+  SIGNATURE_DATABASE_INDEX  *Index;
+  SIGNATURE_INDEX_ENTRY     *Entry;
+  UINTN                     Position;
 
-  //
-  // Read signature database variable.
-  //
   *IsFound = FALSE;
-  Data     = NULL;
-  DataSize = 0;
-  Status   = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    if (Status == EFI_NOT_FOUND) {
-      //
-      // No database, no need to search.
-      //
-      Status = EFI_SUCCESS;
-    }
 
+  Status = GetSignatureDatabaseIndex (VariableName, &Index);
+  if (EFI_ERROR (Status) || (Index == NULL)) {
     return Status;
   }
 
-  Data = (UINT8 *)AllocateZeroPool (DataSize);
-  if (Data == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  Position = FindSignatureIndexEntry (Index, CertType, SignatureSize, Signature, SignatureSize);
+  if (Position == Index->EntryCount) {
+    return EFI_SUCCESS;
   }
 
-  Status = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, Data);
-  if (EFI_ERROR (Status)) {
-    goto Done;
+  //
+  // Find the signature in database.
+  //
+  *IsFound = TRUE;
+  Entry    = &Index->Entries[Position];
+  //
+  // Entries in UEFI_IMAGE_SECURITY_DATABASE that are used to validate image should be measured
+  //
+  if (StrCmp (VariableName, EFI_IMAGE_SECURITY_DATABASE) == 0) {
+    SecureBootHook (VariableName, &gEfiImageSecurityDatabaseGuid, Entry->CertList->SignatureSize, Entry->Cert);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Check whether the hash of an given X.509 certificate is in forbidden database (DBX).
+
+  @param[in]  Certificate       Pointer to X.509 Certificate that is searched for.
+  @param[in]  CertSize          Size of X.509 Certificate.
+  @param[in]  DbxIndex          Lookup index of the forbidden database.
+  @param[out] RevocationTime    Return the time that the certificate was revoked.
+  @param[out] IsFound           Search result. Only valid if EFI_SUCCESS returned.
+
+  @retval EFI_SUCCESS           Finished the search without any error.
+  @retval Others                Error occurred in the search of database.
+
+**/
+EFI_STATUS
+IsCertHashFoundInDbx (
+  IN  UINT8                     *Certificate,
+  IN  UINTN                     CertSize,
+  IN  SIGNATURE_DATABASE_INDEX  *DbxIndex,
+  OUT EFI_TIME                  *RevocationTime,
+  OUT BOOLEAN                   *IsFound
+  )
+{
+  STATIC CONST struct {
+    EFI_GUID    *CertType;
+    UINT32      HashAlg;
+  } CertHashTypes[] = {
+    { &gEfiCertX509Sha256Guid, HASHALG_SHA256 },
+    { &gEfiCertX509Sha384Guid, HASHALG_SHA384 },
+    { &gEfiCertX509Sha512Guid, HASHALG_SHA512 }
+  };
+
+  EFI_STATUS             Status;
+  UINTN                  TypeIndex;
+  UINT32                 HashAlg;
+  UINTN                  HashSize;
+  VOID                   *HashCtx;
+  UINT8                  CertDigest[MAX_DIGEST_SIZE];
+  UINTN                  Position;
+  SIGNATURE_INDEX_ENTRY  *Entry;
+  SIGNATURE_INDEX_ENTRY  *FoundEntry;
+  UINT8                  *TBSCert;
+  UINTN                  TBSCertSize;
+
+  Status     = EFI_ABORTED;
+  *IsFound   = FALSE;
+  HashCtx    = NULL;
+  FoundEntry = NULL;
+
+  if ((RevocationTime == NULL) || (DbxIndex == NULL)) {
+    return EFI_INVALID_PARAMETER;
   }
 
   //
-  // Enumerate all signature data in SigDB to check if signature exists for executable.
+  // Retrieve the TBSCertificate from the X.509 Certificate.
   //
-  CertList = (EFI_SIGNATURE_LIST *)Data;
-  while ((DataSize > 0) && (DataSize >= CertList->SignatureListSize)) {
-    CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
-    Cert      = (EFI_SIGNATURE_DATA *)((UINT8 *)CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
-    if ((CertList->SignatureSize == sizeof (EFI_SIGNATURE_DATA) - 1 + SignatureSize) && (CompareGuid (&CertList->SignatureType, CertType))) {
-      for (Index = 0; Index < CertCount; Index++) {
-        if (CompareMem (Cert->SignatureData, Signature, SignatureSize) == 0) {
-          //
-          // Find the signature in database.
-          //
-          *IsFound = TRUE;
-          //
-          // Entries in UEFI_IMAGE_SECURITY_DATABASE that are used to validate image should be measured
-          //
-          if (StrCmp (VariableName, EFI_IMAGE_SECURITY_DATABASE) == 0) {
-            SecureBootHook (VariableName, &gEfiImageSecurityDatabaseGuid, CertList->SignatureSize, Cert);
-          }
+  if (!X509GetTBSCert (Certificate, CertSize, &TBSCert, &TBSCertSize)) {
+    return Status;
+  }
 
-          break;
-        }
+  for (TypeIndex = 0; TypeIndex < ARRAY_SIZE (CertHashTypes); TypeIndex++) {
+    //
+    // Only hash the certificate for the algorithms the forbidden database uses.
+    //
+    if (FindSignatureIndexEntry (DbxIndex, CertHashTypes[TypeIndex].CertType, 0, NULL, 0) == DbxIndex->EntryCount) {
+      continue;
+    }
 
-        Cert = (EFI_SIGNATURE_DATA *)((UINT8 *)Cert + CertList->SignatureSize);
-      }
+    //
+    // Calculate the hash value of current TBSCertificate for comparision.
+    //
+    HashAlg = CertHashTypes[TypeIndex].HashAlg;
+    if (mHash[HashAlg].GetContextSize == NULL) {
+      goto Done;
+    }
 
-      if (*IsFound) {
-        break;
+    ZeroMem (CertDigest, MAX_DIGEST_SIZE);
+    HashCtx = AllocatePool (mHash[HashAlg].GetContextSize ());
+    if (HashCtx == NULL) {
+      goto Done;
+    }
+
+    if (!mHash[HashAlg].HashInit (HashCtx)) {
+      goto Done;
+    }
+
+    if (!mHash[HashAlg].HashUpdate (HashCtx, TBSCert, TBSCertSize)) {
+      goto Done;
+    }
+
+    if (!mHash[HashAlg].HashFinal (HashCtx, CertDigest)) {
+      goto Done;
+    }
+
+    FreePool (HashCtx);
+    HashCtx = NULL;
+
+    //
+    // The entries are the certificate hash followed by the revocation time.
+    // Of all entries for this hash, take the first one in database order, as
+    // the linear scan of the database did.
+    //
+    HashSize = mHash[HashAlg].DigestLength;
+    Position = FindSignatureIndexEntry (
+                 DbxIndex,
+                 CertHashTypes[TypeIndex].CertType,
+                 HashSize + sizeof (EFI_TIME),
+                 CertDigest,
+                 HashSize
+                 );
+    while ((Position < DbxIndex->EntryCount) &&
+           (CompareSignatureKey (
+              CertHashTypes[TypeIndex].CertType,
+              HashSize + sizeof (EFI_TIME),
+              CertDigest,
+              HashSize,
+              &DbxIndex->Entries[Position]
+              ) == 0))
+    {
+      Entry = &DbxIndex->Entries[Position];
+      if ((FoundEntry == NULL) || ((UINTN)Entry->Cert < (UINTN)FoundEntry->Cert)) {
+        FoundEntry = Entry;
       }
+
+      Position++;
     }
+  }
 
-    DataSize -= CertList->SignatureListSize;
-    CertList  = (EFI_SIGNATURE_LIST *)((UINT8 *)CertList + CertList->SignatureListSize);
+  if (FoundEntry != NULL) {
+    //
+    // Hash of Certificate is found in forbidden database. Return the
+    // revocation time.
+    //
+    *IsFound = TRUE;
+    HashSize = FoundEntry->CertList->SignatureSize - (sizeof (EFI_SIGNATURE_DATA) - 1) - sizeof (EFI_TIME);
+    CopyMem (RevocationTime, FoundEntry->Cert->SignatureData + HashSize, sizeof (EFI_TIME));
   }
 
+  Status = EFI_SUCCESS;
+
 Done:
-  if (Data != NULL) {
-    FreePool (Data);
+  if (HashCtx != NULL) {
+    FreePool (HashCtx);
   }
 
   return Status;
@@ -1143,25 +1492,19 @@ PassTimestampCheck (
   IN EFI_TIME  *RevocationTime
   )
 {
-  EFI_STATUS          Status;
-  BOOLEAN             VerifyStatus;
-  EFI_SIGNATURE_LIST  *CertList;
-  EFI_SIGNATURE_DATA  *Cert;
-  UINT8               *DbtData;
-  UINTN               DbtDataSize;
-  UINT8               *RootCert;
-  UINTN               RootCertSize;
-  UINTN               Index;
-  UINTN               CertCount;
-  EFI_TIME            SigningTime;
+  EFI_STATUS                Status;
+  BOOLEAN                   VerifyStatus;
+  SIGNATURE_DATABASE_INDEX  *DbtIndex;
+  SIGNATURE_INDEX_ENTRY     *Entry;
+  UINTN                     Position;
+  UINT8                     *RootCert;
+  UINTN                     RootCertSize;
+  EFI_TIME                  SigningTime;
 
   //
   // Variable Initialization
   //
   VerifyStatus = FALSE;
-  DbtData      = NULL;
-  CertList     = NULL;
-  Cert         = NULL;
   RootCert     = NULL;
   RootCertSize = 0;
 
@@ -1176,57 +1519,38 @@ PassTimestampCheck (
   // RevocationTime is non-zero, the certificate should be considered to be revoked from that time and onwards.
   // Using the dbt to get the trusted TSA certificates.
   //
-  DbtDataSize = 0;
-  Status      = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE2, &gEfiImageSecurityDatabaseGuid, NULL, &DbtDataSize, NULL);
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    goto Done;
-  }
-
-  DbtData = (UINT8 *)AllocateZeroPool (DbtDataSize);
-  if (DbtData == NULL) {
-    goto Done;
-  }
-
-  Status = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE2, &gEfiImageSecurityDatabaseGuid, NULL, &DbtDataSize, (VOID *)DbtData);
-  if (EFI_ERROR (Status)) {
-    goto Done;
+  Status = GetSignatureDatabaseIndex (EFI_IMAGE_SECURITY_DATABASE2, &DbtIndex);
+  if (EFI_ERROR (Status) || (DbtIndex == NULL)) {
+    return VerifyStatus;
   }
 
-  CertList = (EFI_SIGNATURE_LIST *)DbtData;
-  while ((DbtDataSize > 0) && (DbtDataSize >= CertList->SignatureListSize)) {
-    if (CompareGuid (&CertList->SignatureType, &gEfiCertX509Guid)) {
-      Cert      = (EFI_SIGNATURE_DATA *)((UINT8 *)CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
-      CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
-      for (Index = 0; Index < CertCount; Index++) {
-        //
-        // Iterate each Signature Data Node within this CertList for verify.
-        //
-        RootCert     = Cert->SignatureData;
-        RootCertSize = CertList->SignatureSize - sizeof (EFI_GUID);
-        //
-        // Get the signing time if the timestamp signature is valid.
-        //
-        if (ImageTimestampVerify (AuthData, AuthDataSize, RootCert, RootCertSize, &SigningTime)) {
-          //
-          // The signer signature is valid only when the signing time is earlier than revocation time.
-          //
-          if (IsValidSignatureByTimestamp (&SigningTime, RevocationTime)) {
-            VerifyStatus = TRUE;
-            goto Done;
-          }
-        }
+  //
+  // The X.509 certificates of the index are in database order.
+  //
+  Position = FindSignatureIndexEntry (DbtIndex, &gEfiCertX509Guid, 0, NULL, 0);
+  for ( ; Position < DbtIndex->EntryCount; Position++) {
+    Entry = &DbtIndex->Entries[Position];
+    if (!CompareGuid (&Entry->CertList->SignatureType, &gEfiCertX509Guid)) {
+      break;
+    }
 
-        Cert = (EFI_SIGNATURE_DATA *)((UINT8 *)Cert + CertList->SignatureSize);
+    //
+    // Iterate each Signature Data Node within this CertList for verify.
+    //
+    RootCert     = Entry->Cert->SignatureData;
+    RootCertSize = Entry->CertList->SignatureSize - sizeof (EFI_GUID);
+    //
+    // Get the signing time if the timestamp signature is valid.
+    //
+    if (ImageTimestampVerify (AuthData, AuthDataSize, RootCert, RootCertSize, &SigningTime)) {
+      //
+      // The signer signature is valid only when the signing time is earlier than revocation time.
+      //
+      if (IsValidSignatureByTimestamp (&SigningTime, RevocationTime)) {
+        VerifyStatus = TRUE;
+        break;
       }
     }
-
-    DbtDataSize -= CertList->SignatureListSize;
-    CertList     = (EFI_SIGNATURE_LIST *)((UINT8 *)CertList + CertList->SignatureListSize);
-  }
-
-Done:
-  if (DbtData != NULL) {
-    FreePool (DbtData);
   }
 
   return VerifyStatus;
@@ -1249,35 +1573,29 @@ IsForbiddenByDbx (
   IN UINTN  AuthDataSize
   )
 {
-  EFI_STATUS          Status;
-  BOOLEAN             IsForbidden;
-  BOOLEAN             IsFound;
-  UINT8               *Data;
-  UINTN               DataSize;
-  EFI_SIGNATURE_LIST  *CertList;
-  UINTN               CertListSize;
-  EFI_SIGNATURE_DATA  *CertData;
-  UINT8               *RootCert;
-  UINTN               RootCertSize;
-  UINTN               CertCount;
-  UINTN               Index;
-  UINT8               *CertBuffer;
-  UINTN               BufferLength;
-  UINT8               *TrustedCert;
-  UINTN               TrustedCertLength;
-  UINT8               CertNumber;
-  UINT8               *CertPtr;
-  UINT8               *Cert;
-  UINTN               CertSize;
-  EFI_TIME            RevocationTime;
+  EFI_STATUS                Status;
+  BOOLEAN                   IsForbidden;
+  BOOLEAN                   IsFound;
+  SIGNATURE_DATABASE_INDEX  *DbxIndex;
+  SIGNATURE_INDEX_ENTRY     *Entry;
+  UINTN                     Position;
+  UINT8                     *RootCert;
+  UINTN                     RootCertSize;
+  UINTN                     Index;
+  UINT8                     *CertBuffer;
+  UINTN                     BufferLength;
+  UINT8                     *TrustedCert;
+  UINTN                     TrustedCertLength;
+  UINT8                     CertNumber;
+  UINT8                     *CertPtr;
+  UINT8                     *Cert;
+  UINTN                     CertSize;
+  EFI_TIME                  RevocationTime;
 
   //
   // Variable Initialization
   //
   IsForbidden       = TRUE;
-  Data              = NULL;
-  CertList          = NULL;
-  CertData          = NULL;
   RootCert          = NULL;
   RootCertSize      = 0;
   Cert              = NULL;
@@ -1289,70 +1607,48 @@ IsForbiddenByDbx (
   //
   // The image will not be forbidden if dbx can't be got.
   //
-  DataSize = 0;
-  Status   = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE1, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
-  ASSERT (EFI_ERROR (Status));
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    if (Status == EFI_NOT_FOUND) {
-      //
-      // Evidently not in dbx if the database doesn't exist.
-      //
-      IsForbidden = FALSE;
-    }
-
-    return IsForbidden;
-  }
-
-  Data = (UINT8 *)AllocateZeroPool (DataSize);
-  if (Data == NULL) {
+  Status = GetSignatureDatabaseIndex (EFI_IMAGE_SECURITY_DATABASE1, &DbxIndex);
+  if (EFI_ERROR (Status)) {
     return IsForbidden;
   }
 
-  Status = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE1, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, (VOID *)Data);
-  if (EFI_ERROR (Status)) {
-    goto Done;
+  if (DbxIndex == NULL) {
+    //
+    // Evidently not in dbx if the database doesn't exist.
+    //
+    return FALSE;
   }
 
   //
   // Verify image signature with RAW X509 certificates in DBX database.
-  // If passed, the image will be forbidden.
+  // If passed, the image will be forbidden. The X.509 certificates of the
+  // index are in database order.
   //
-  CertList     = (EFI_SIGNATURE_LIST *)Data;
-  CertListSize = DataSize;
-  while ((CertListSize > 0) && (CertListSize >= CertList->SignatureListSize)) {
-    if (CompareGuid (&CertList->SignatureType, &gEfiCertX509Guid)) {
-      CertData  = (EFI_SIGNATURE_DATA *)((UINT8 *)CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
-      CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
+  Position = FindSignatureIndexEntry (DbxIndex, &gEfiCertX509Guid, 0, NULL, 0);
+  for ( ; Position < DbxIndex->EntryCount; Position++) {
+    Entry = &DbxIndex->Entries[Position];
+    if (!CompareGuid (&Entry->CertList->SignatureType, &gEfiCertX509Guid)) {
+      break;
+    }
 
-      for (Index = 0; Index < CertCount; Index++) {
-        //
-        // Iterate each Signature Data Node within this CertList for verify.
-        //
-        RootCert     = CertData->SignatureData;
-        RootCertSize = CertList->SignatureSize - sizeof (EFI_GUID);
+    RootCert     = Entry->Cert->SignatureData;
+    RootCertSize = Entry->CertList->SignatureSize - sizeof (EFI_GUID);
 
-        //
-        // Call AuthenticodeVerify library to Verify Authenticode struct.
-        //
-        IsForbidden = AuthenticodeVerify (
-                        AuthData,
-                        AuthDataSize,
-                        RootCert,
-                        RootCertSize,
-                        mImageDigest,
-                        mImageDigestSize
-                        );
-        if (IsForbidden) {
-          DEBUG ((DEBUG_INFO, "DxeImageVerificationLib: Image is signed but signature is forbidden by DBX.\n"));
-          goto Done;
-        }
-
-        CertData = (EFI_SIGNATURE_DATA *)((UINT8 *)CertData + CertList->SignatureSize);
-      }
+    //
+    // Call AuthenticodeVerify library to Verify Authenticode struct.
+    //
+    IsForbidden = AuthenticodeVerify (
+                    AuthData,
+                    AuthDataSize,
+                    RootCert,
+                    RootCertSize,
+                    mImageDigest,
+                    mImageDigestSize
+                    );
+    if (IsForbidden) {
+      DEBUG ((DEBUG_INFO, "DxeImageVerificationLib: Image is signed but signature is forbidden by DBX.\n"));
+      goto Done;
     }
-
-    CertListSize -= CertList->SignatureListSize;
-    CertList      = (EFI_SIGNATURE_LIST *)((UINT8 *)CertList + CertList->SignatureListSize);
   }
 
   //
@@ -1390,7 +1686,7 @@ IsForbiddenByDbx (
     //
     CertPtr = CertPtr + sizeof (UINT32) + CertSize;
 
-    Status = IsCertHashFoundInDbx (Cert, CertSize, (EFI_SIGNATURE_LIST *)Data, DataSize, &RevocationTime, &IsFound);
+    Status = IsCertHashFoundInDbx (Cert, CertSize, DbxIndex, &RevocationTime, &IsFound);
     if (EFI_ERROR (Status)) {
       //
       // Error in searching dbx. Consider it as 'found'. RevocationTime might
@@ -1419,10 +1715,6 @@ IsForbiddenByDbx (
   IsForbidden = FALSE;
 
 Done:
-  if (Data != NULL) {
-    FreePool (Data);
-  }
-
   Pkcs7FreeSigners (CertBuffer);
   Pkcs7FreeSigners (TrustedCert);
 
@@ -1445,26 +1737,19 @@ IsAllowedByDb (
   IN UINTN  AuthDataSize
   )
 {
-  EFI_STATUS          Status;
-  BOOLEAN             VerifyStatus;
-  BOOLEAN             IsFound;
-  EFI_SIGNATURE_LIST  *CertList;
-  EFI_SIGNATURE_DATA  *CertData;
-  UINTN               DataSize;
-  UINT8               *Data;
-  UINT8               *RootCert;
-  UINTN               RootCertSize;
-  UINTN               Index;
-  UINTN               CertCount;
-  UINTN               DbxDataSize;
-  UINT8               *DbxData;
-  EFI_TIME            RevocationTime;
-
-  Data         = NULL;
-  CertList     = NULL;
-  CertData     = NULL;
+  EFI_STATUS                Status;
+  BOOLEAN                   VerifyStatus;
+  BOOLEAN                   IsFound;
+  SIGNATURE_DATABASE_INDEX  *DbIndex;
+  SIGNATURE_DATABASE_INDEX  *DbxIndex;
+  SIGNATURE_INDEX_ENTRY     *Entry;
+  UINTN                     Position;
+  UINT8                     *RootCert;
+  UINTN                     RootCertSize;
+  EFI_TIME                  RevocationTime;
+
+  Entry        = NULL;
   RootCert     = NULL;
-  DbxData      = NULL;
   RootCertSize = 0;
   VerifyStatus = FALSE;
 
@@ -1472,136 +1757,84 @@ IsAllowedByDb (
   // Fetch 'db' content. If 'db' doesn't exist or encounters problem to get the
   // data, return not-allowed-by-db (FALSE).
   //
-  DataSize = 0;
-  Status   = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
-  ASSERT (EFI_ERROR (Status));
-  if (Status != EFI_BUFFER_TOO_SMALL) {
+  Status = GetSignatureDatabaseIndex (EFI_IMAGE_SECURITY_DATABASE, &DbIndex);
+  if (EFI_ERROR (Status) || (DbIndex == NULL)) {
     return VerifyStatus;
   }
 
-  Data = (UINT8 *)AllocateZeroPool (DataSize);
-  if (Data == NULL) {
-    return VerifyStatus;
-  }
-
-  Status = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, (VOID *)Data);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
-
   //
   // Fetch 'dbx' content. If 'dbx' doesn't exist, continue to check 'db'.
   // If any other errors occurred, no need to check 'db' but just return
   // not-allowed-by-db (FALSE) to avoid bypass.
   //
-  DbxDataSize = 0;
-  Status      = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE1, &gEfiImageSecurityDatabaseGuid, NULL, &DbxDataSize, NULL);
-  ASSERT (EFI_ERROR (Status));
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    if (Status != EFI_NOT_FOUND) {
-      goto Done;
-    }
-
-    //
-    // 'dbx' does not exist. Continue to check 'db'.
-    //
-  } else {
-    //
-    // 'dbx' exists. Get its content.
-    //
-    DbxData = (UINT8 *)AllocateZeroPool (DbxDataSize);
-    if (DbxData == NULL) {
-      goto Done;
-    }
-
-    Status = gRT->GetVariable (EFI_IMAGE_SECURITY_DATABASE1, &gEfiImageSecurityDatabaseGuid, NULL, &DbxDataSize, (VOID *)DbxData);
-    if (EFI_ERROR (Status)) {
-      goto Done;
-    }
+  Status = GetSignatureDatabaseIndex (EFI_IMAGE_SECURITY_DATABASE1, &DbxIndex);
+  if (EFI_ERROR (Status)) {
+    return VerifyStatus;
   }
 
   //
-  // Find X509 certificate in Signature List to verify the signature in pkcs7 signed data.
+  // Find X509 certificate in Signature List to verify the signature in pkcs7
+  // signed data. The X.509 certificates of the index are in database order.
   //
-  CertList = (EFI_SIGNATURE_LIST *)Data;
-  while ((DataSize > 0) && (DataSize >= CertList->SignatureListSize)) {
-    if (CompareGuid (&CertList->SignatureType, &gEfiCertX509Guid)) {
-      CertData  = (EFI_SIGNATURE_DATA *)((UINT8 *)CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
-      CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
+  Position = FindSignatureIndexEntry (DbIndex, &gEfiCertX509Guid, 0, NULL, 0);
+  for ( ; Position < DbIndex->EntryCount; Position++) {
+    Entry = &DbIndex->Entries[Position];
+    if (!CompareGuid (&Entry->CertList->SignatureType, &gEfiCertX509Guid)) {
+      break;
+    }
 
-      for (Index = 0; Index < CertCount; Index++) {
-        //
-        // Iterate each Signature Data Node within this CertList for verify.
-        //
-        RootCert     = CertData->SignatureData;
-        RootCertSize = CertList->SignatureSize - sizeof (EFI_GUID);
+    RootCert     = Entry->Cert->SignatureData;
+    RootCertSize = Entry->CertList->SignatureSize - sizeof (EFI_GUID);
 
+    //
+    // Call AuthenticodeVerify library to Verify Authenticode struct.
+    //
+    VerifyStatus = AuthenticodeVerify (
+                     AuthData,
+                     AuthDataSize,
+                     RootCert,
+                     RootCertSize,
+                     mImageDigest,
+                     mImageDigestSize
+                     );
+    if (VerifyStatus) {
+      //
+      // The image is signed and its signature is found in 'db'.
+      //
+      if (DbxIndex != NULL) {
         //
-        // Call AuthenticodeVerify library to Verify Authenticode struct.
+        // Here We still need to check if this RootCert's Hash is revoked
         //
-        VerifyStatus = AuthenticodeVerify (
-                         AuthData,
-                         AuthDataSize,
-                         RootCert,
-                         RootCertSize,
-                         mImageDigest,
-                         mImageDigestSize
-                         );
-        if (VerifyStatus) {
+        Status = IsCertHashFoundInDbx (RootCert, RootCertSize, DbxIndex, &RevocationTime, &IsFound);
+        if (EFI_ERROR (Status)) {
           //
-          // The image is signed and its signature is found in 'db'.
+          // Error in searching dbx. Consider it as 'found'. RevocationTime might
+          // not be valid in such situation.
           //
-          if (DbxData != NULL) {
-            //
-            // Here We still need to check if this RootCert's Hash is revoked
-            //
-            Status = IsCertHashFoundInDbx (RootCert, RootCertSize, (EFI_SIGNATURE_LIST *)DbxData, DbxDataSize, &RevocationTime, &IsFound);
-            if (EFI_ERROR (Status)) {
-              //
-              // Error in searching dbx. Consider it as 'found'. RevocationTime might
-              // not be valid in such situation.
-              //
-              VerifyStatus = FALSE;
-            } else if (IsFound) {
-              //
-              // Check the timestamp signature and signing time to determine if the RootCert can be trusted.
-              //
-              VerifyStatus = PassTimestampCheck (AuthData, AuthDataSize, &RevocationTime);
-              if (!VerifyStatus) {
-                DEBUG ((DEBUG_INFO, "DxeImageVerificationLib: Image is signed and signature is accepted by DB, but its root cert failed the timestamp check.\n"));
-              }
-            }
-          }
-
+          VerifyStatus = FALSE;
+        } else if (IsFound) {
           //
-          // There's no 'dbx' to check revocation time against (must-be pass),
-          // or, there's revocation time found in 'dbx' and checked againt 'dbt'
-          // (maybe pass or fail, depending on timestamp compare result). Either
-          // way the verification job has been completed at this point.
+          // Check the timestamp signature and signing time to determine if the RootCert can be trusted.
           //
-          goto Done;
+          VerifyStatus = PassTimestampCheck (AuthData, AuthDataSize, &RevocationTime);
+          if (!VerifyStatus) {
+            DEBUG ((DEBUG_INFO, "DxeImageVerificationLib: Image is signed and signature is accepted by DB, but its root cert failed the timestamp check.\n"));
+          }
         }
-
-        CertData = (EFI_SIGNATURE_DATA *)((UINT8 *)CertData + CertList->SignatureSize);
       }
-    }
 
-    DataSize -= CertList->SignatureListSize;
-    CertList  = (EFI_SIGNATURE_LIST *)((UINT8 *)CertList + CertList->SignatureListSize);
+      //
+      // There's no 'dbx' to check revocation time against (must-be pass),
+      // or, there's revocation time found in 'dbx' and checked againt 'dbt'
+      // (maybe pass or fail, depending on timestamp compare result). Either
+      // way the verification job has been completed at this point.
+      //
+      break;
+    }
   }
 
-Done:
-
   if (VerifyStatus) {
-    SecureBootHook (EFI_IMAGE_SECURITY_DATABASE, &gEfiImageSecurityDatabaseGuid, CertList->SignatureSize, CertData);
-  }
-
-  if (Data != NULL) {
-    FreePool (Data);
-  }
-
-  if (DbxData != NULL) {
-    FreePool (DbxData);
+    SecureBootHook (EFI_IMAGE_SECURITY_DATABASE, &gEfiImageSecurityDatabaseGuid, Entry->CertList->SignatureSize, Entry->Cert);
   }
 
   return VerifyStatus;
@@ -1786,6 +2019,12 @@ DxeImageVerificationHandler (
   mImageBase = (UINT8 *)FileBuffer;
   mImageSize = FileSize;
 
+  //
+  // Check the signature database indexes against the variables once for
+  // this image rather than on every lookup.
+  //
+  mSignatureDatabaseGeneration++;
+
   ZeroMem (&ImageContext, sizeof (ImageContext));
   ImageContext.Handle    = (VOID *)FileBuffer;
   ImageContext.ImageRead = (PE_COFF_LOADER_READ_FILE)DxeImageVerificationLibImageRead;
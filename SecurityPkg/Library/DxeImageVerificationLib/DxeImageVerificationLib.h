@@ -193,3 +193,45 @@ typedef struct {
   //
   HASH_FINAL               HashFinal;
 } HASH_TABLE;
+
+//
+// One signature entry of a security database, as referenced from the
+// sorted lookup index.
+//
+typedef struct {
+  //
+  // Signature list containing the entry
+  //
+  EFI_SIGNATURE_LIST    *CertList;
+  //
+  // Signature entry inside CertList
+  //
+  EFI_SIGNATURE_DATA    *Cert;
+} SIGNATURE_INDEX_ENTRY;
+
+//
+// Sorted lookup index built over the content of a security database
+// variable. The index is rebuilt whenever the variable content changes, which
+// is checked once per image verification.
+//
+typedef struct {
+  //
+  // Name of the indexed database variable
+  //
+  CHAR16                   *VariableName;
+  //
+  // Snapshot of the variable content the index refers to
+  //
+  UINT8                    *Data;
+  UINTN                    DataSize;
+  //
+  // Signature entries sorted by signature type, size and data
+  //
+  SIGNATURE_INDEX_ENTRY    *Entries;
+  UINTN                    EntryCount;
+  //
+  // Value of mSignatureDatabaseGeneration when the index was last checked
+  // against the variable
+  //
+  UINTN                    Generation;
+} SIGNATURE_DATABASE_INDEX;
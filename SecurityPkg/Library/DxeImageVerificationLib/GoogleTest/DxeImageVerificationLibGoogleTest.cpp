@@ -15,6 +15,9 @@ extern "C" {
   #include <Uefi.h>
   #include <Library/BaseLib.h>
   #include <Library/DebugLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include <Library/BaseCryptLib.h>
+  #include <Guid/ImageAuthentication.h>
 
   #include "DxeImageVerificationLibGoogleTest.h"
 }
@@ -126,6 +129,211 @@ TEST_F (CheckImageTypeResult, ImageTypeVerifyImageFromFixedMedia) {
   TestFunc (EFI_ACCESS_DENIED);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+#define DBX_HASH_COUNT  500
+
+class SignatureDatabaseLookup : public ::testing::Test {
+protected:
+  MockUefiRuntimeServicesTableLib RtServicesMock;
+
+  EFI_STATUS Status;
+  BOOLEAN IsFound;
+  std::vector<UINT8> Dbx;
+  UINTN GetVariableCalls;
+
+  //
+  // Build a distinct SHA256 "image digest" from a seed.
+  //
+  static void
+  MakeDigest (
+    UINTN  Seed,
+    UINT8  *Digest
+    )
+  {
+    UINTN  Index;
+
+    for (Index = 0; Index < SHA256_DIGEST_SIZE; Index++) {
+      Digest[Index] = (UINT8)((Seed * 0x9E3779B1U) >> ((Index % 4) * 8)) ^ (UINT8)Index;
+    }
+
+    Digest[0] = (UINT8)Seed;
+    Digest[1] = (UINT8)(Seed >> 8);
+  }
+
+  //
+  // Append one EFI_SIGNATURE_LIST holding Count SHA256 hashes, starting at
+  // seed First.
+  //
+  void
+  AppendSha256List (
+    UINTN  First,
+    UINTN  Count
+    )
+  {
+    EFI_SIGNATURE_LIST  List;
+    UINTN               SignatureSize;
+    UINTN               Offset;
+    UINTN               Index;
+
+    SignatureSize            = sizeof (EFI_SIGNATURE_DATA) - 1 + SHA256_DIGEST_SIZE;
+    List.SignatureType       = gEfiCertSha256Guid;
+    List.SignatureHeaderSize = 0;
+    List.SignatureSize       = (UINT32)SignatureSize;
+    List.SignatureListSize   = (UINT32)(sizeof (EFI_SIGNATURE_LIST) + Count * SignatureSize);
+
+    Offset = Dbx.size ();
+    Dbx.resize (Offset + List.SignatureListSize, 0);
+    CopyMem (&Dbx[Offset], &List, sizeof (List));
+    Offset += sizeof (List);
+    for (Index = 0; Index < Count; Index++) {
+      MakeDigest (First + Index, &Dbx[Offset + sizeof (EFI_GUID)]);
+      Offset += SignatureSize;
+    }
+  }
+
+  virtual void
+  SetUp (
+    )
+  {
+    Dbx.clear ();
+    GetVariableCalls = 0;
+
+    //
+    // Each test stands for a new image verification, so the cached indexes
+    // have to be checked against the variables again.
+    //
+    mSignatureDatabaseGeneration++;
+
+    //
+    // Spread the hashes over several lists, in reverse seed order, so the
+    // index has to sort across list boundaries.
+    //
+    AppendSha256List (DBX_HASH_COUNT / 2, DBX_HASH_COUNT / 2);
+    AppendSha256List (0, DBX_HASH_COUNT / 2);
+
+    EXPECT_CALL (RtServicesMock, gRT_GetVariable)
+      .WillRepeatedly (
+         [this](CHAR16 *VariableName, EFI_GUID *VendorGuid, UINT32 *Attributes, UINTN *DataSize, VOID *Data) {
+        if (StrCmp (VariableName, (CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1) != 0) {
+          return EFI_NOT_FOUND;
+        }
+
+        GetVariableCalls++;
+        if (*DataSize < Dbx.size ()) {
+          *DataSize = Dbx.size ();
+          return EFI_BUFFER_TOO_SMALL;
+        }
+
+        *DataSize = Dbx.size ();
+        CopyMem (Data, Dbx.data (), Dbx.size ());
+        return EFI_SUCCESS;
+      }
+         );
+  }
+};
+
+TEST_F (SignatureDatabaseLookup, AllRevokedHashesFound) {
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+  UINTN  Seed;
+
+  //
+  // Look up the digests of DBX_HASH_COUNT images against the full dbx.
+  //
+  for (Seed = 0; Seed < DBX_HASH_COUNT; Seed++) {
+    MakeDigest (Seed, Digest);
+    Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    EXPECT_TRUE (IsFound);
+  }
+}
+
+TEST_F (SignatureDatabaseLookup, UnknownHashNotFound) {
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+
+  MakeDigest (DBX_HASH_COUNT, Digest);
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_FALSE (IsFound);
+
+  //
+  // Same digest, different hash type.
+  //
+  MakeDigest (0, Digest);
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha384Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_FALSE (IsFound);
+}
+
+TEST_F (SignatureDatabaseLookup, IndexFollowsDatabaseUpdate) {
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+
+  MakeDigest (DBX_HASH_COUNT, Digest);
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_FALSE (IsFound);
+
+  //
+  // Append the digest to dbx, the next lookup must see it.
+  //
+  AppendSha256List (DBX_HASH_COUNT, 1);
+  mSignatureDatabaseGeneration++;
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_TRUE (IsFound);
+}
+
+TEST_F (SignatureDatabaseLookup, DatabaseReadOncePerImage) {
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+  UINTN  Seed;
+
+  //
+  // All lookups for one image share the index: one size probe plus one read.
+  //
+  for (Seed = 0; Seed < DBX_HASH_COUNT; Seed++) {
+    MakeDigest (Seed, Digest);
+    Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+    ASSERT_EQ (Status, EFI_SUCCESS);
+  }
+
+  EXPECT_LE (GetVariableCalls, (UINTN)2);
+}
+
+TEST_F (SignatureDatabaseLookup, SameSizeReplacementDetected) {
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+
+  MakeDigest (0, Digest);
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_TRUE (IsFound);
+
+  //
+  // Replace the dbx content with a database of the same size that revokes
+  // other hashes; the next image must not see the old entries.
+  //
+  Dbx.clear ();
+  AppendSha256List (DBX_HASH_COUNT, DBX_HASH_COUNT / 2);
+  AppendSha256List (DBX_HASH_COUNT * 2, DBX_HASH_COUNT / 2);
+  mSignatureDatabaseGeneration++;
+
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_FALSE (IsFound);
+
+  MakeDigest (DBX_HASH_COUNT * 2, Digest);
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE1, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_TRUE (IsFound);
+}
+
+TEST_F (SignatureDatabaseLookup, MissingDatabase) {
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+
+  MakeDigest (0, Digest);
+  Status = IsSignatureFoundInDatabase ((CHAR16 *)EFI_IMAGE_SECURITY_DATABASE, Digest, &gEfiCertSha256Guid, sizeof (Digest), &IsFound);
+  ASSERT_EQ (Status, EFI_SUCCESS);
+  EXPECT_FALSE (IsFound);
+}
+
 int
 main (
   int   argc,
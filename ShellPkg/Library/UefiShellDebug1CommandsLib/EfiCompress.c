@@ -8,7 +8,7 @@
 **/
 
 #include "UefiShellDebug1CommandsLib.h"
-#include "Compress.h"
+#include <Library/UefiCompressLib.h>
 
 /**
   Function for 'compress' command.
@@ -29,8 +29,7 @@ ShellCommandRunEfiCompress (
   SHELL_STATUS       ShellStatus;
   SHELL_FILE_HANDLE  InShellFileHandle;
   SHELL_FILE_HANDLE  OutShellFileHandle;
-  UINT64             OutSize;
-  UINTN              OutSize2;
+  UINTN              OutSize;
   VOID               *OutBuffer;
   UINT64             InSize;
   UINTN              InSize2;
@@ -128,13 +127,24 @@ ShellCommandRunEfiCompress (
             Status  = gEfiShellProtocol->ReadFile (InShellFileHandle, &InSize2, InBuffer);
             InSize  = InSize2;
             ASSERT_EFI_ERROR (Status);
-            Status = Compress (InBuffer, InSize, OutBuffer, &OutSize);
-            if (Status == EFI_BUFFER_TOO_SMALL) {
-              OutBuffer = AllocateZeroPool ((UINTN)OutSize);
-              if (OutBuffer == NULL) {
-                Status = EFI_OUT_OF_RESOURCES;
-              } else {
-                Status = Compress (InBuffer, InSize, OutBuffer, &OutSize);
+            //
+            // UefiCompress() requires a destination buffer, so start with one
+            // the size of the input and grow it if the data does not compress.
+            //
+            OutSize   = InSize2;
+            OutBuffer = AllocateZeroPool (OutSize);
+            if (OutBuffer == NULL) {
+              Status = EFI_OUT_OF_RESOURCES;
+            } else {
+              Status = UefiCompress (InBuffer, InSize2, OutBuffer, &OutSize);
+              if (Status == EFI_BUFFER_TOO_SMALL) {
+                FreePool (OutBuffer);
+                OutBuffer = AllocateZeroPool (OutSize);
+                if (OutBuffer == NULL) {
+                  Status = EFI_OUT_OF_RESOURCES;
+                } else {
+                  Status = UefiCompress (InBuffer, InSize2, OutBuffer, &OutSize);
+                }
               }
             }
           }
@@ -143,8 +153,7 @@ ShellCommandRunEfiCompress (
             ShellPrintHiiDefaultEx (STRING_TOKEN (STR_EFI_COMPRESS_FAIL), gShellDebug1HiiHandle, Status);
             ShellStatus = ((Status == EFI_OUT_OF_RESOURCES) ? SHELL_OUT_OF_RESOURCES : SHELL_DEVICE_ERROR);
           } else {
-            OutSize2 = (UINTN)OutSize;
-            Status   = gEfiShellProtocol->WriteFile (OutShellFileHandle, &OutSize2, OutBuffer);
+            Status = gEfiShellProtocol->WriteFile (OutShellFileHandle, &OutSize, OutBuffer);
             if (EFI_ERROR (Status)) {
               ShellPrintHiiDefaultEx (STRING_TOKEN (STR_FILE_WRITE_FAIL), gShellDebug1HiiHandle, L"eficompress", OutFileName);
               ShellStatus = SHELL_DEVICE_ERROR;